@@ -0,0 +1,232 @@
+#include <vector>
+#include <string>
+#include <pcl/point_types.h>
+#include <pcl/common/time.h>
+#include <pcl/common/common.h>
+#include <pcl/console/parse.h>
+#include <pcl/console/print.h>
+#include <pcl/sample_consensus/distance_kernels.h>
+#include <pcl/sample_consensus/sac_model_plane.h>
+#include <pcl/sample_consensus/sac_model_sphere.h>
+#include <pcl/sample_consensus/sac_model_line.h>
+#include <pcl/sample_consensus/sac_model_normal_plane.h>
+#include <pcl/sample_consensus/sac_model_cylinder.h>
+
+using namespace std;
+
+typedef pcl::PointCloud<pcl::PointXYZ> Cloud;
+typedef pcl::PointCloud<pcl::Normal> Normals;
+
+// The point by point distance loops used by the models before the distance kernels, as a reference
+int
+countPlaneReference (const Cloud &cloud, const vector<int> &indices, const Eigen::VectorXf &c, double threshold)
+{
+  int nr_p = 0;
+  for (size_t i = 0; i < indices.size (); ++i)
+  {
+    Eigen::Vector4f pt (cloud.points[indices[i]].x, cloud.points[indices[i]].y, cloud.points[indices[i]].z, 1);
+    if (fabs (c.dot (pt)) < threshold)
+      nr_p++;
+  }
+  return (nr_p);
+}
+
+int
+countSphereReference (const Cloud &cloud, const vector<int> &indices, const Eigen::VectorXf &c, double threshold)
+{
+  int nr_p = 0;
+  for (size_t i = 0; i < indices.size (); ++i)
+  {
+    const pcl::PointXYZ &p = cloud.points[indices[i]];
+    if (fabs (sqrtf ((p.x - c[0]) * (p.x - c[0]) + (p.y - c[1]) * (p.y - c[1]) + (p.z - c[2]) * (p.z - c[2])) - c[3]) < threshold)
+      nr_p++;
+  }
+  return (nr_p);
+}
+
+int
+countLineReference (const Cloud &cloud, const vector<int> &indices, const Eigen::VectorXf &c, double threshold)
+{
+  Eigen::Vector4f line_pt  (c[0], c[1], c[2], 0);
+  Eigen::Vector4f line_dir (c[3], c[4], c[5], 0);
+  line_dir.normalize ();
+  int nr_p = 0;
+  for (size_t i = 0; i < indices.size (); ++i)
+    if ((line_pt - cloud.points[indices[i]].getVector4fMap ()).cross3 (line_dir).squaredNorm () < threshold * threshold)
+      nr_p++;
+  return (nr_p);
+}
+
+int
+countNormalPlaneReference (const Cloud &cloud, const Normals &normals, const vector<int> &indices,
+                           const Eigen::VectorXf &c, double w, double threshold)
+{
+  Eigen::Vector4f coeff = c;
+  coeff[3] = 0;
+  int nr_p = 0;
+  for (size_t i = 0; i < indices.size (); ++i)
+  {
+    Eigen::Vector4f p (cloud.points[indices[i]].x, cloud.points[indices[i]].y, cloud.points[indices[i]].z, 0);
+    Eigen::Vector4f n (normals.points[indices[i]].normal[0], normals.points[indices[i]].normal[1], normals.points[indices[i]].normal[2], 0);
+    double d_euclid = fabs (coeff.dot (p) + c[3]);
+    double d_normal = fabs (pcl::getAngle3D (n, coeff));
+    d_normal = (std::min) (d_normal, M_PI - d_normal);
+    if (fabs (w * d_normal + (1 - w) * d_euclid) < threshold)
+      nr_p++;
+  }
+  return (nr_p);
+}
+
+int
+countCylinderReference (const Cloud &cloud, const Normals &normals, const vector<int> &indices,
+                        const Eigen::VectorXf &c, double w, double threshold)
+{
+  Eigen::Vector4f line_pt  (c[0], c[1], c[2], 0);
+  Eigen::Vector4f line_dir (c[3], c[4], c[5], 0);
+  float ptdotdir = line_pt.dot (line_dir);
+  float dirdotdir = 1.0f / line_dir.dot (line_dir);
+  int nr_p = 0;
+  for (size_t i = 0; i < indices.size (); ++i)
+  {
+    Eigen::Vector4f pt (cloud.points[indices[i]].x, cloud.points[indices[i]].y, cloud.points[indices[i]].z, 0);
+    Eigen::Vector4f n (normals.points[indices[i]].normal[0], normals.points[indices[i]].normal[1], normals.points[indices[i]].normal[2], 0);
+    double d_euclid = fabs (sqrt (pcl::sqrPointToLineDistance (pt, line_pt, line_dir)) - c[6]);
+    float k = (pt.dot (line_dir) - ptdotdir) * dirdotdir;
+    Eigen::Vector4f dir = pt - (line_pt + k * line_dir);
+    dir.normalize ();
+    double d_normal = fabs (pcl::getAngle3D (n, dir));
+    d_normal = (std::min) (d_normal, M_PI - d_normal);
+    if (fabs (w * d_normal + (1 - w) * d_euclid) < threshold)
+      nr_p++;
+  }
+  return (nr_p);
+}
+
+// Prints the time and throughput of one model, for nr_iterations calls
+void
+printTiming (const char *name, int nr_points, int nr_iterations, double time, int nr_inliers)
+{
+  pcl::console::print_info ("  %-14s %8.2f ms/call %8.1f Mpts/s  (%d inliers)\n", name, time * 1000.0 / nr_iterations,
+                            static_cast<double> (nr_points) * nr_iterations / time * 1e-6, nr_inliers);
+}
+
+int
+main (int argc, char ** argv)
+{
+  if (pcl::console::find_switch (argc, argv, "-h"))
+  {
+    pcl::console::print_info ("Syntax is: %s [-points <n>] [-iterations <k>]\n", argv[0]);
+    pcl::console::print_info ("  Counts the inliers of the plane, sphere, line, normal plane and cylinder models\n"
+                              "  with the point by point reference loops and with the distance kernels, for each\n"
+                              "  instruction set available. Without -points, uses clouds of 300k, 1M and 3M points.\n");
+    return (1);
+  }
+
+  vector<int> sizes;
+  int nr_points = 0;
+  if (pcl::console::parse (argc, argv, "-points", nr_points) >= 0 && nr_points > 0)
+    sizes.push_back (nr_points);
+  else
+  {
+    sizes.push_back (300000);
+    sizes.push_back (1000000);
+    sizes.push_back (3000000);
+  }
+  int nr_iterations = 20;
+  pcl::console::parse (argc, argv, "-iterations", nr_iterations);
+
+  const double threshold = 0.05, weight = 0.1;
+  Eigen::VectorXf plane (4), sphere (4), line (6), cylinder (7);
+  plane << 0.0f, 0.0f, 1.0f, -0.5f;
+  sphere << 0.5f, 0.5f, 0.5f, 0.3f;
+  line << 0.5f, 0.5f, 0.0f, 0.0f, 0.0f, 1.0f;
+  cylinder << 0.5f, 0.5f, 0.0f, 0.0f, 0.0f, 1.0f, 0.3f;
+
+  const char *level_names[] = { "none", "SSE2", "AVX" };
+  const pcl::sample_consensus::SimdLevel default_level = pcl::sample_consensus::getSimdLevel ();
+  pcl::console::print_info ("Best instruction set available: %s\n", level_names[default_level]);
+
+  for (size_t s = 0; s < sizes.size (); ++s)
+  {
+    Cloud::Ptr cloud (new Cloud);
+    Normals::Ptr normals (new Normals);
+    cloud->resize (sizes[s]);
+    normals->resize (sizes[s]);
+    vector<int> indices (sizes[s]);
+    for (int i = 0; i < sizes[s]; ++i)
+    {
+      (*cloud)[i].x = static_cast<float> (rand ()) / RAND_MAX;
+      (*cloud)[i].y = static_cast<float> (rand ()) / RAND_MAX;
+      (*cloud)[i].z = static_cast<float> (rand ()) / RAND_MAX;
+      (*normals)[i].normal_x = static_cast<float> (rand ()) / RAND_MAX - 0.5f;
+      (*normals)[i].normal_y = static_cast<float> (rand ()) / RAND_MAX - 0.5f;
+      (*normals)[i].normal_z = static_cast<float> (rand ()) / RAND_MAX - 0.5f;
+      indices[i] = i;
+    }
+
+    pcl::SampleConsensusModelPlane<pcl::PointXYZ> plane_model (cloud, indices);
+    pcl::SampleConsensusModelSphere<pcl::PointXYZ> sphere_model (cloud, indices);
+    pcl::SampleConsensusModelLine<pcl::PointXYZ> line_model (cloud, indices);
+    pcl::SampleConsensusModelNormalPlane<pcl::PointXYZ, pcl::Normal> normal_plane_model (cloud, indices);
+    normal_plane_model.setInputNormals (normals);
+    normal_plane_model.setNormalDistanceWeight (weight);
+    pcl::SampleConsensusModelCylinder<pcl::PointXYZ, pcl::Normal> cylinder_model (cloud, indices);
+    cylinder_model.setInputNormals (normals);
+    cylinder_model.setNormalDistanceWeight (weight);
+
+    pcl::console::print_info ("%d points, reference loops:\n", sizes[s]);
+    double start;
+    int nr_inliers = 0;
+    start = pcl::getTime ();
+    for (int it = 0; it < nr_iterations; ++it)
+      nr_inliers = countPlaneReference (*cloud, indices, plane, threshold);
+    printTiming ("plane", sizes[s], nr_iterations, pcl::getTime () - start, nr_inliers);
+    start = pcl::getTime ();
+    for (int it = 0; it < nr_iterations; ++it)
+      nr_inliers = countSphereReference (*cloud, indices, sphere, threshold);
+    printTiming ("sphere", sizes[s], nr_iterations, pcl::getTime () - start, nr_inliers);
+    start = pcl::getTime ();
+    for (int it = 0; it < nr_iterations; ++it)
+      nr_inliers = countLineReference (*cloud, indices, line, threshold);
+    printTiming ("line", sizes[s], nr_iterations, pcl::getTime () - start, nr_inliers);
+    start = pcl::getTime ();
+    for (int it = 0; it < nr_iterations; ++it)
+      nr_inliers = countNormalPlaneReference (*cloud, *normals, indices, plane, weight, threshold);
+    printTiming ("normal plane", sizes[s], nr_iterations, pcl::getTime () - start, nr_inliers);
+    start = pcl::getTime ();
+    for (int it = 0; it < nr_iterations; ++it)
+      nr_inliers = countCylinderReference (*cloud, *normals, indices, cylinder, weight, threshold);
+    printTiming ("cylinder", sizes[s], nr_iterations, pcl::getTime () - start, nr_inliers);
+
+    for (int level = pcl::sample_consensus::SIMD_NONE; level <= pcl::sample_consensus::SIMD_AVX; ++level)
+    {
+      if (pcl::sample_consensus::setSimdLevel (static_cast<pcl::sample_consensus::SimdLevel> (level)) != level)
+        continue;
+      pcl::console::print_info ("%d points, distance kernels (%s):\n", sizes[s], level_names[level]);
+
+      start = pcl::getTime ();
+      for (int it = 0; it < nr_iterations; ++it)
+        nr_inliers = plane_model.countWithinDistance (plane, threshold);
+      printTiming ("plane", sizes[s], nr_iterations, pcl::getTime () - start, nr_inliers);
+      start = pcl::getTime ();
+      for (int it = 0; it < nr_iterations; ++it)
+        nr_inliers = sphere_model.countWithinDistance (sphere, threshold);
+      printTiming ("sphere", sizes[s], nr_iterations, pcl::getTime () - start, nr_inliers);
+      start = pcl::getTime ();
+      for (int it = 0; it < nr_iterations; ++it)
+        nr_inliers = line_model.countWithinDistance (line, threshold);
+      printTiming ("line", sizes[s], nr_iterations, pcl::getTime () - start, nr_inliers);
+      start = pcl::getTime ();
+      for (int it = 0; it < nr_iterations; ++it)
+        nr_inliers = normal_plane_model.countWithinDistance (plane, threshold);
+      printTiming ("normal plane", sizes[s], nr_iterations, pcl::getTime () - start, nr_inliers);
+      start = pcl::getTime ();
+      for (int it = 0; it < nr_iterations; ++it)
+        nr_inliers = cylinder_model.countWithinDistance (cylinder, threshold);
+      printTiming ("cylinder", sizes[s], nr_iterations, pcl::getTime () - start, nr_inliers);
+    }
+    pcl::sample_consensus::setSimdLevel (default_level);
+  }
+
+  return (0);
+}
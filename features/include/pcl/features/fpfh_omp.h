@@ -40,12 +40,17 @@
 
 #include <pcl/features/feature.h>
 #include <pcl/features/fpfh.h>
+#include <pcl/features/pair_feature_cache.h>
 
 namespace pcl
 {
   /** \brief FPFHEstimationOMP estimates the Fast Point Feature Histogram (FPFH) descriptor for a given point cloud
     * dataset containing points and normals, in parallel, using the OpenMP standard.
     *
+    * The neighborhood of each point is searched once, and shared by the SPFH and FPFH stages. The pair features are
+    * shared between the SPFH signatures of the two points of a pair through a PairFeatureCache. After a call to
+    * compute (), computeChanged () updates the descriptors affected by a change of some points of the cloud.
+    *
     * \note If you use this code in any academic work, please cite:
     *
     *   - R.B. Rusu, N. Blodow, M. Beetz.
@@ -79,7 +84,12 @@ namespace pcl
       using Feature<PointInT, PointOutT>::search_parameter_;
       using Feature<PointInT, PointOutT>::input_;
       using Feature<PointInT, PointOutT>::surface_;
+      using Feature<PointInT, PointOutT>::tree_;
+      using Feature<PointInT, PointOutT>::search_method_surface_;
       using FeatureFromNormals<PointInT, PointNT, PointOutT>::normals_;
+      using FeatureFromNormals<PointInT, PointNT, PointOutT>::initCompute;
+      using Feature<PointInT, PointOutT>::deinitCompute;
+      using FPFHEstimation<PointInT, PointNT, PointOutT>::d_pi_;
       using FPFHEstimation<PointInT, PointNT, PointOutT>::hist_f1_;
       using FPFHEstimation<PointInT, PointNT, PointOutT>::hist_f2_;
       using FPFHEstimation<PointInT, PointNT, PointOutT>::hist_f3_;
@@ -90,7 +100,12 @@ namespace pcl
       /** \brief Initialize the scheduler and set the number of threads to use.
         * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
         */
-      FPFHEstimationOMP (unsigned int nr_threads = 0) : nr_bins_f1_ (11), nr_bins_f2_ (11), nr_bins_f3_ (11), threads_ (nr_threads)
+      FPFHEstimationOMP (unsigned int nr_threads = 0) : nr_bins_f1_ (11), nr_bins_f2_ (11), nr_bins_f3_ (11), threads_ (nr_threads),
+        use_cache_ (false),
+        // Default 1GB memory size.
+        max_cache_size_ ((1ul*1024ul*1024ul*1024ul) / (sizeof (uint64_t) + sizeof (Eigen::Vector4f))),
+        pair_cache_ (), surface_neighborhoods_ (), query_neighborhoods_ (), spfh_hist_lookup_ (),
+        same_cloud_ (false), previous_indices_ (), previous_search_parameter_ (0)
       {
         feature_name_ = "FPFHEstimationOMP";
       }
@@ -101,6 +116,40 @@ namespace pcl
       inline void 
       setNumberOfThreads (unsigned int nr_threads = 0) { threads_ = nr_threads; }
 
+      /** \brief Set whether the pair features are shared through the internal cache (default: false). The
+        * descriptors are the same with and without the cache. FPFH computes each pair at most twice, so the
+        * cache mostly pays off for large neighborhoods, where the pair features cost more than the lookups.
+        * \param[in] use_cache set to true to use the internal cache, false otherwise
+        */
+      inline void
+      setUseInternalCache (bool use_cache) { use_cache_ = use_cache; }
+
+      /** \brief Get whether the internal cache is used or not for computing the FPFH features. */
+      inline bool
+      getUseInternalCache () const { return (use_cache_); }
+
+      /** \brief Set the maximum number of pairs of the internal cache. Defaults to 1GB worth of entries.
+        * \param[in] cache_size maximum cache size
+        */
+      inline void
+      setMaximumCacheSize (size_t cache_size) { max_cache_size_ = cache_size; }
+
+      /** \brief Get the maximum number of pairs of the internal cache. */
+      inline size_t
+      getMaximumCacheSize () const { return (max_cache_size_); }
+
+      /** \brief Update the descriptors computed by the last call to compute () or computeChanged () after some
+        * points of the input cloud moved, or got a different normal. Only the neighborhoods, SPFH and FPFH
+        * signatures affected by these points are computed again.
+        *
+        * The input cloud, normals and indices have to be the same objects (with the same sizes) as in the last call.
+        * Otherwise, and when a search surface different from the input is set, all the descriptors are computed.
+        * \param[in] changed_indices the indices in the input cloud of the points that changed
+        * \param[in,out] output the descriptors given by the last call, updated
+        */
+      void
+      computeChanged (const std::vector<int> &changed_indices, PointCloudOut &output);
+
     private:
       /** \brief Estimate the Fast Point Feature Histograms (FPFH) descriptors at a set of points given by
         * <setInputCloud (), setIndices ()> using the surface in setSearchSurface () and the spatial locator in
@@ -110,6 +159,38 @@ namespace pcl
       void 
       computeFeature (PointCloudOut &output);
 
+      /** \brief Assign a SPFH row to the neighbors of a set of query points that do not have one yet, and search
+        * their neighborhoods if needed.
+        * \param[in] queries the indices of the query points, without duplicates
+        * \param[in,out] spfh_points the points whose SPFH signature has to be computed, new points are appended
+        */
+      void
+      addSPFHPoints (const std::vector<int> &queries, std::vector<int> &spfh_points);
+
+      /** \brief Compute the SPFH signatures of a set of points in parallel.
+        * \param[in] spfh_points the indices of the points in the search surface, without duplicates
+        */
+      void
+      computeSPFHSignatures (const std::vector<int> &spfh_points);
+
+      /** \brief Compute the FPFH signatures of a set of query points in parallel, from their SPFH signatures.
+        * \param[in] positions the positions of the query points in the indices
+        * \param[out] output the output point cloud
+        */
+      void
+      computeFPFHSignatures (const std::vector<int> &positions, PointCloudOut &output);
+
+      /** \brief Get the neighborhoods of the query points (the ones of the search surface if it is the input). */
+      inline const FeatureNeighborhoods<PointInT>&
+      getQueryNeighborhoods () const
+      {
+        return (same_cloud_ ? surface_neighborhoods_ : query_neighborhoods_);
+      }
+
+      /** \brief Get the query points without duplicates. */
+      void
+      getUniqueQueries (std::vector<int> &queries) const;
+
     public:
       /** \brief The number of subdivisions for each angular feature interval. */
       int nr_bins_f1_, nr_bins_f2_, nr_bins_f3_;
@@ -117,6 +198,33 @@ namespace pcl
       /** \brief The number of threads the scheduler should use. */
       unsigned int threads_;
 
+      /** \brief Set to true to use the internal cache for removing redundant computations. */
+      bool use_cache_;
+
+      /** \brief Maximum number of pairs of the internal cache. */
+      size_t max_cache_size_;
+
+      /** \brief The pair features shared between the SPFH signatures. */
+      PairFeatureCache pair_cache_;
+
+      /** \brief The neighborhoods of the points of the search surface. */
+      FeatureNeighborhoods<PointInT> surface_neighborhoods_;
+
+      /** \brief The neighborhoods of the query points, when the search surface is not the input cloud. */
+      FeatureNeighborhoods<PointInT> query_neighborhoods_;
+
+      /** \brief The row of the SPFH signature of each point of the search surface, -1 if it has none. */
+      std::vector<int> spfh_hist_lookup_;
+
+      /** \brief Whether the search surface is the input cloud. */
+      bool same_cloud_;
+
+      /** \brief The indices used by the last call, to check that the descriptors can be updated. */
+      std::vector<int> previous_indices_;
+
+      /** \brief The search parameter used by the last call, to check that the descriptors can be updated. */
+      double previous_search_parameter_;
+
       /** \brief Make the computeFeature (&Eigen::MatrixXf); inaccessible from outside the class
         * \param[out] output the output point cloud 
         */
@@ -46,82 +46,246 @@
 template <typename PointInT, typename PointNT, typename PointOutT> void
 pcl::FPFHEstimationOMP<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut &output)
 {
-  std::vector<int> spfh_indices_vec;
-  std::vector<int> spfh_hist_lookup (surface_->points.size ());
-
-  // Build a list of (unique) indices for which we will need to compute SPFH signatures
-  // (We need an SPFH signature for every point that is a neighbor of any point in input_[indices_])
-  if (surface_ != input_ ||
-      indices_->size () != surface_->points.size ())
-  { 
-    std::vector<int> nn_indices (k_); // \note These resizes are irrelevant for a radiusSearch ().
-    std::vector<float> nn_dists (k_); 
-
-    std::set<int> spfh_indices_set;
-    for (size_t idx = 0; idx < indices_->size (); ++idx)
-    {
-      int p_idx = (*indices_)[idx];
-      if (this->searchForNeighbors (p_idx, search_parameter_, nn_indices, nn_dists) == 0)
-        continue;
-      
-      spfh_indices_set.insert (nn_indices.begin (), nn_indices.end ());
-    }
-    spfh_indices_vec.resize (spfh_indices_set.size ());
-    std::copy (spfh_indices_set.begin (), spfh_indices_set.end (), spfh_indices_vec.begin ());
-  }
+  // When the search surface is the input cloud, the neighborhoods of the query points are also the ones used for
+  // their SPFH signatures, so each neighborhood is searched once
+  same_cloud_ = (surface_ == input_);
+  surface_neighborhoods_.reset (surface_->points.size ());
+  query_neighborhoods_.reset (same_cloud_ ? 0 : input_->points.size ());
+  spfh_hist_lookup_.assign (surface_->points.size (), -1);
+  hist_f1_.setZero (0, nr_bins_f1_);
+  hist_f2_.setZero (0, nr_bins_f2_);
+  hist_f3_.setZero (0, nr_bins_f3_);
+
+  std::vector<int> queries;
+  getUniqueQueries (queries);
+  if (same_cloud_)
+    surface_neighborhoods_.search (search_method_surface_, *input_, queries, search_parameter_, threads_);
   else
+    query_neighborhoods_.search (search_method_surface_, *input_, queries, search_parameter_, threads_);
+
+  // We need an SPFH signature for every point that is a neighbor of any point in input_[indices_]
+  std::vector<int> spfh_points;
+  addSPFHPoints (queries, spfh_points);
+
+  // Each pair of neighbors appears in the SPFH signatures of both of its points
+  size_t nr_pairs = 0;
+  for (size_t i = 0; i < spfh_points.size (); ++i)
+    nr_pairs += surface_neighborhoods_.getIndices (spfh_points[i]).size ();
+  pair_cache_.resize (use_cache_ ? (std::min) (nr_pairs, max_cache_size_) : 0);
+
+  computeSPFHSignatures (spfh_points);
+
+  std::vector<int> positions (indices_->size ());
+  for (size_t idx = 0; idx < positions.size (); ++idx)
+    positions[idx] = static_cast<int> (idx);
+  computeFPFHSignatures (positions, output);
+
+  previous_indices_ = *indices_;
+  previous_search_parameter_ = search_parameter_;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT> void
+pcl::FPFHEstimationOMP<PointInT, PointNT, PointOutT>::computeChanged (const std::vector<int> &changed_indices,
+                                                                      PointCloudOut &output)
+{
+  if (!initCompute ())
+  {
+    output.width = output.height = 0;
+    output.points.clear ();
+    return;
+  }
+  // The points changed in place, so the spatial locator has to be built again
+  tree_->setInputCloud (surface_);
+
+  const int nr_points = static_cast<int> (surface_->points.size ());
+  if (!same_cloud_ || surface_ != input_ || static_cast<int> (surface_neighborhoods_.size ()) != nr_points ||
+      output.points.size () != indices_->size () || previous_indices_ != *indices_ ||
+      previous_search_parameter_ != search_parameter_)
   {
-    // Special case: When a feature must be computed at every point, there is no need for a neighborhood search
-    spfh_indices_vec.resize (indices_->size ());
-    for (int idx = 0; idx < static_cast<int> (indices_->size ()); ++idx)
-      spfh_indices_vec[idx] = idx;
+    deinitCompute ();
+    this->compute (output);
+    return;
   }
 
-  // Initialize the arrays that will store the SPFH signatures
-  size_t data_size = spfh_indices_vec.size ();
-  hist_f1_.setZero (data_size, nr_bins_f1_);
-  hist_f2_.setZero (data_size, nr_bins_f2_);
-  hist_f3_.setZero (data_size, nr_bins_f3_);
+  std::vector<char> changed (nr_points, 0);
+  for (size_t i = 0; i < changed_indices.size (); ++i)
+    if (changed_indices[i] >= 0 && changed_indices[i] < nr_points)
+      changed[changed_indices[i]] = 1;
+  pair_cache_.erase (changed);
+
+  // The neighborhoods to search again are the ones of the changed points, the ones that contained a changed point,
+  // and the ones that may contain a changed point now, within the search radius (or the largest k-th neighbor
+  // distance) of its new position
+  std::vector<char> dirty (changed);
+  surface_neighborhoods_.findContaining (changed, dirty, threads_);
+  const double radius = (k_ == 0 ? search_parameter_ : sqrt (surface_neighborhoods_.getMaxSqrDistance ())) * 1.0001;
+  std::vector<int> nn_indices;
+  std::vector<float> nn_dists;
+  for (size_t i = 0; i < changed_indices.size (); ++i)
+  {
+    const int p_idx = changed_indices[i];
+    if (p_idx < 0 || p_idx >= nr_points || !isFinite (surface_->points[p_idx]))
+      continue;
+    tree_->radiusSearch (*surface_, p_idx, radius, nn_indices, nn_dists);
+    for (size_t j = 0; j < nn_indices.size (); ++j)
+      dirty[nn_indices[j]] = 1;
+  }
+
+  std::vector<int> searched_points, spfh_points;
+  for (int p_idx = 0; p_idx < nr_points; ++p_idx)
+  {
+    if (!dirty[p_idx] || !surface_neighborhoods_.isSearched (p_idx))
+      continue;
+    searched_points.push_back (p_idx);
+    if (spfh_hist_lookup_[p_idx] >= 0)
+      spfh_points.push_back (p_idx);
+  }
+  surface_neighborhoods_.search (search_method_surface_, *surface_, searched_points, search_parameter_, threads_);
+
+  // The query points with a new neighborhood may have neighbors without a SPFH signature
+  std::vector<int> queries, dirty_queries;
+  getUniqueQueries (queries);
+  for (size_t i = 0; i < queries.size (); ++i)
+    if (dirty[queries[i]])
+      dirty_queries.push_back (queries[i]);
+  addSPFHPoints (dirty_queries, spfh_points);
+  computeSPFHSignatures (spfh_points);
+
+  // The FPFH signatures to compute again are the ones with a new neighborhood or a neighbor with a new SPFH
+  std::vector<char> spfh_changed (nr_points, 0);
+  for (size_t i = 0; i < spfh_points.size (); ++i)
+    spfh_changed[spfh_points[i]] = 1;
+  std::vector<int> positions;
+  for (int idx = 0; idx < static_cast<int> (indices_->size ()); ++idx)
+  {
+    const int q_idx = (*indices_)[idx];
+    bool update = dirty[q_idx] != 0;
+    const std::vector<int> &neighbors = surface_neighborhoods_.getIndices (q_idx);
+    for (size_t j = 0; j < neighbors.size () && !update; ++j)
+      update = spfh_changed[neighbors[j]] != 0;
+    if (update)
+      positions.push_back (idx);
+  }
+  computeFPFHSignatures (positions, output);
+
+  output.is_dense = true;
+  for (size_t idx = 0; idx < output.points.size () && output.is_dense; ++idx)
+    output.is_dense = pcl_isfinite (output.points[idx].histogram[0]);
+
+  deinitCompute ();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT> void
+pcl::FPFHEstimationOMP<PointInT, PointNT, PointOutT>::getUniqueQueries (std::vector<int> &queries) const
+{
+  std::vector<char> is_query (input_->points.size (), 0);
+  queries.clear ();
+  for (size_t idx = 0; idx < indices_->size (); ++idx)
+  {
+    const int q_idx = (*indices_)[idx];
+    if (is_query[q_idx])
+      continue;
+    is_query[q_idx] = 1;
+    queries.push_back (q_idx);
+  }
+}
 
-  std::vector<int> nn_indices (k_); // \note These resizes are irrelevant for a radiusSearch ().
-  std::vector<float> nn_dists (k_); 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT> void
+pcl::FPFHEstimationOMP<PointInT, PointNT, PointOutT>::addSPFHPoints (const std::vector<int> &queries,
+                                                                     std::vector<int> &spfh_points)
+{
+  const FeatureNeighborhoods<PointInT> &query_neighborhoods = getQueryNeighborhoods ();
+  int nr_rows = static_cast<int> (hist_f1_.rows ());
+  std::vector<int> new_points, unsearched_points;
+  for (size_t i = 0; i < queries.size (); ++i)
+  {
+    const std::vector<int> &neighbors = query_neighborhoods.getIndices (queries[i]);
+    for (size_t j = 0; j < neighbors.size (); ++j)
+    {
+      const int p_idx = neighbors[j];
+      if (spfh_hist_lookup_[p_idx] >= 0)
+        continue;
+      spfh_hist_lookup_[p_idx] = nr_rows++;
+      new_points.push_back (p_idx);
+      if (!surface_neighborhoods_.isSearched (p_idx))
+        unsearched_points.push_back (p_idx);
+    }
+  }
+  surface_neighborhoods_.search (search_method_surface_, *surface_, unsearched_points, search_parameter_, threads_);
 
-  // Compute SPFH signatures for every point that needs them
+  hist_f1_.conservativeResize (nr_rows, nr_bins_f1_);
+  hist_f2_.conservativeResize (nr_rows, nr_bins_f2_);
+  hist_f3_.conservativeResize (nr_rows, nr_bins_f3_);
+  spfh_points.insert (spfh_points.end (), new_points.begin (), new_points.end ());
+}
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT> void
+pcl::FPFHEstimationOMP<PointInT, PointNT, PointOutT>::computeSPFHSignatures (const std::vector<int> &spfh_points)
+{
 #ifdef _OPENMP
-#pragma omp parallel for shared (spfh_hist_lookup) private (nn_indices, nn_dists) num_threads(threads_)
+#pragma omp parallel for schedule (dynamic, 64) num_threads(threads_)
 #endif
-  for (int i = 0; i < static_cast<int> (spfh_indices_vec.size ()); ++i)
+  for (int i = 0; i < static_cast<int> (spfh_points.size ()); ++i)
   {
-    // Get the next point index
-    int p_idx = spfh_indices_vec[i];
+    const int p_idx = spfh_points[i];
+    const int row = spfh_hist_lookup_[p_idx];
+    hist_f1_.row (row).setZero ();
+    hist_f2_.row (row).setZero ();
+    hist_f3_.row (row).setZero ();
 
-    // Find the neighborhood around p_idx
-    if (this->searchForNeighbors (*surface_, p_idx, search_parameter_, nn_indices, nn_dists) == 0)
+    const std::vector<int> &indices = surface_neighborhoods_.getIndices (p_idx);
+    if (indices.empty ())
       continue;
 
-    // Estimate the SPFH signature around p_idx
-    this->computePointSPFHSignature (*surface_, *normals_, p_idx, i, nn_indices, hist_f1_, hist_f2_, hist_f3_);
+    // Same as computePointSPFHSignature, with the pair features taken from the cache (a pair whose features
+    // cannot be computed is counted with null features there as well)
+    float hist_incr = 100.0f / static_cast<float>(indices.size () - 1);
+    Eigen::Vector4f pfh_tuple;
+    for (size_t idx = 0; idx < indices.size (); ++idx)
+    {
+      if (p_idx == indices[idx])
+        continue;
 
-    // Populate a lookup table for converting a point index to its corresponding row in the spfh_hist_* matrices
-    spfh_hist_lookup[p_idx] = i;
+      pair_cache_.computePairFeatures (*surface_, *normals_, p_idx, indices[idx], pfh_tuple);
+
+      int h_index = static_cast<int> (floor (nr_bins_f1_ * ((pfh_tuple[0] + M_PI) * d_pi_)));
+      if (h_index < 0)            h_index = 0;
+      if (h_index >= nr_bins_f1_) h_index = nr_bins_f1_ - 1;
+      hist_f1_ (row, h_index) += hist_incr;
+
+      h_index = static_cast<int> (floor (nr_bins_f2_ * ((pfh_tuple[1] + 1.0) * 0.5)));
+      if (h_index < 0)            h_index = 0;
+      if (h_index >= nr_bins_f2_) h_index = nr_bins_f2_ - 1;
+      hist_f2_ (row, h_index) += hist_incr;
+
+      h_index = static_cast<int> (floor (nr_bins_f3_ * ((pfh_tuple[2] + 1.0) * 0.5)));
+      if (h_index < 0)            h_index = 0;
+      if (h_index >= nr_bins_f3_) h_index = nr_bins_f3_ - 1;
+      hist_f3_ (row, h_index) += hist_incr;
+    }
   }
+}
 
-  // Intialize the array that will store the FPFH signature
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT> void
+pcl::FPFHEstimationOMP<PointInT, PointNT, PointOutT>::computeFPFHSignatures (const std::vector<int> &positions,
+                                                                             PointCloudOut &output)
+{
+  const FeatureNeighborhoods<PointInT> &query_neighborhoods = getQueryNeighborhoods ();
   int nr_bins = nr_bins_f1_ + nr_bins_f2_ + nr_bins_f3_;
 
-  nn_indices.clear();
-  nn_dists.clear();
-
-  // Iterate over the entire index vector
 #ifdef _OPENMP
-#pragma omp parallel for shared (output) private (nn_indices, nn_dists) num_threads(threads_)
+#pragma omp parallel for schedule (dynamic, 64) shared (output) num_threads(threads_)
 #endif
-  for (int idx = 0; idx < static_cast<int> (indices_->size ()); ++idx)
+  for (int i = 0; i < static_cast<int> (positions.size ()); ++i)
   {
-    // Find the indices of point idx's neighbors...
-    if (!isFinite ((*input_)[(*indices_)[idx]]) ||
-        this->searchForNeighbors ((*indices_)[idx], search_parameter_, nn_indices, nn_dists) == 0)
+    const int idx = positions[i];
+    const std::vector<int> &nn_indices = query_neighborhoods.getIndices ((*indices_)[idx]);
+    if (nn_indices.empty ())
     {
       for (int d = 0; d < nr_bins; ++d)
         output.points[idx].histogram[d] = std::numeric_limits<float>::quiet_NaN ();
@@ -130,21 +294,19 @@ pcl::FPFHEstimationOMP<PointInT, PointNT, PointOutT>::computeFeature (PointCloud
       continue;
     }
 
-
-    // ... and remap the nn_indices values so that they represent row indices in the spfh_hist_* matrices 
-    // instead of indices into surface_->points
-    for (size_t i = 0; i < nn_indices.size (); ++i)
-      nn_indices[i] = spfh_hist_lookup[nn_indices[i]];
+    // Remap the neighbors to their rows in the hist_f* matrices
+    std::vector<int> nn_rows (nn_indices.size ());
+    for (size_t j = 0; j < nn_indices.size (); ++j)
+      nn_rows[j] = spfh_hist_lookup_[nn_indices[j]];
 
     // Compute the FPFH signature (i.e. compute a weighted combination of local SPFH signatures) ...
     Eigen::VectorXf fpfh_histogram = Eigen::VectorXf::Zero (nr_bins);
-    weightPointSPFHSignature (hist_f1_, hist_f2_, hist_f3_, nn_indices, nn_dists, fpfh_histogram);
+    weightPointSPFHSignature (hist_f1_, hist_f2_, hist_f3_, nn_rows, query_neighborhoods.getSqrDistances ((*indices_)[idx]), fpfh_histogram);
 
     // ...and copy it into the output cloud
     for (int d = 0; d < nr_bins; ++d)
       output.points[idx].histogram[d] = fpfh_histogram[d];
   }
-
 }
 
 #define PCL_INSTANTIATE_FPFHEstimationOMP(T,NT,OutT) template class PCL_EXPORTS pcl::FPFHEstimationOMP<T,NT,OutT>;
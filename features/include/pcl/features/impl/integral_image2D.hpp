@@ -40,6 +40,84 @@
 #define PCL_INTEGRAL_IMAGE2D_IMPL_H_
 
 #include <cstddef>
+#include <algorithm>
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#endif
+
+namespace pcl
+{
+  namespace detail
+  {
+    /** \brief Add the values [begin, end[ of a row of an integral image to the ones of the next row. */
+    template <typename T> inline void
+    addIntegralImageRow (const T *previous_row, T *current_row, int begin, int end)
+    {
+      for (int i = begin; i < end; ++i)
+        current_row[i] += previous_row[i];
+    }
+
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+    inline void
+    addIntegralImageRow (const double *previous_row, double *current_row, int begin, int end)
+    {
+      int i = begin;
+      for (; i + 2 <= end; i += 2)
+        _mm_storeu_pd (current_row + i, _mm_add_pd (_mm_loadu_pd (current_row + i), _mm_loadu_pd (previous_row + i)));
+      for (; i < end; ++i)
+        current_row[i] += previous_row[i];
+    }
+
+    inline void
+    addIntegralImageRow (const float *previous_row, float *current_row, int begin, int end)
+    {
+      int i = begin;
+      for (; i + 4 <= end; i += 4)
+        _mm_storeu_ps (current_row + i, _mm_add_ps (_mm_loadu_ps (current_row + i), _mm_loadu_ps (previous_row + i)));
+      for (; i < end; ++i)
+        current_row[i] += previous_row[i];
+    }
+
+    inline void
+    addIntegralImageRow (const unsigned *previous_row, unsigned *current_row, int begin, int end)
+    {
+      int i = begin;
+      for (; i + 4 <= end; i += 4)
+      {
+        const __m128i previous = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (previous_row + i));
+        const __m128i current = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (current_row + i));
+        _mm_storeu_si128 (reinterpret_cast<__m128i*> (current_row + i), _mm_add_epi32 (current, previous));
+      }
+      for (; i < end; ++i)
+        current_row[i] += previous_row[i];
+    }
+#endif
+
+    /** \brief Turn a table of row sums into an integral image, by adding each row to the next one. The rows are
+      * split in stripes of columns, processed in parallel.
+      * \param[in,out] table the table, nr_rows rows of row_size values
+      * \param[in] row_size the number of values of a row
+      * \param[in] nr_rows the number of rows
+      * \param[in] nr_threads the number of threads to use (0 for automatic)
+      */
+    template <typename T> void
+    accumulateIntegralImageRows (T *table, int row_size, int nr_rows, unsigned nr_threads)
+    {
+      const int stripe_size = 512;
+      const int nr_stripes = (row_size + stripe_size - 1) / stripe_size;
+#ifdef _OPENMP
+#pragma omp parallel for schedule (static) num_threads (nr_threads)
+#endif
+      for (int stripe = 0; stripe < nr_stripes; ++stripe)
+      {
+        const int begin = stripe * stripe_size;
+        const int end = (std::min) (begin + stripe_size, row_size);
+        for (int row = 1; row < nr_rows; ++row)
+          addIntegralImageRow (table + static_cast<size_t> (row - 1) * row_size, table + static_cast<size_t> (row) * row_size, begin, end);
+      }
+    }
+  }
+}
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename DataType, unsigned Dimension> void
@@ -52,15 +130,17 @@ pcl::IntegralImage2D<DataType, Dimension>::setSecondOrderComputation (bool compu
 template <typename DataType, unsigned Dimension> void
 pcl::IntegralImage2D<DataType, Dimension>::setInput (const DataType * data, unsigned width,unsigned height, unsigned element_stride, unsigned row_stride)
 {
-  if ((width + 1) * (height + 1) > first_order_integral_image_.size () )
+  // The images only grow, so that a stream of frames of the same size reuses them
+  width_  = width;
+  height_ = height;
+  const size_t size = (width_ + 1) * (height_ + 1);
+  if (first_order_integral_image_.size () < size)
   {
-    width_  = width;
-    height_ = height;
-    first_order_integral_image_.resize ( (width_ + 1) * (height_ + 1) );
-    finite_values_integral_image_.resize ( (width_ + 1) * (height_ + 1) );
-    if (compute_second_order_integral_images_)
-      second_order_integral_image_.resize ( (width_ + 1) * (height_ + 1) );
+    first_order_integral_image_.resize (size);
+    finite_values_integral_image_.resize (size);
   }
+  if (compute_second_order_integral_images_ && second_order_integral_image_.size () < size)
+    second_order_integral_image_.resize (size);
   computeIntegralImages (data, row_stride, element_stride);
 }
 
@@ -153,68 +233,62 @@ template <typename DataType, unsigned Dimension> void
 pcl::IntegralImage2D<DataType, Dimension>::computeIntegralImages (
     const DataType *data, unsigned row_stride, unsigned element_stride)
 {
-  ElementType* previous_row = &first_order_integral_image_[0];
-  ElementType* current_row  = previous_row + (width_ + 1);
-  memset (previous_row, 0, sizeof (ElementType) * (width_ + 1));
-
-  unsigned* count_previous_row = &finite_values_integral_image_[0];
-  unsigned* count_current_row  = count_previous_row + (width_ + 1);
-  memset (count_previous_row, 0, sizeof (unsigned) * (width_ + 1));
-
-  if (!compute_second_order_integral_images_)
+  typedef typename IntegralImageTypeTraits<DataType>::IntegralType IntegralType;
+  const int stride = static_cast<int> (width_) + 1;
+  const int height = static_cast<int> (height_);
+  ElementType* first_order = &first_order_integral_image_[0];
+  unsigned* count = &finite_values_integral_image_[0];
+  SecondOrderType* second_order = compute_second_order_integral_images_ ? &second_order_integral_image_[0] : NULL;
+
+  memset (first_order, 0, sizeof (ElementType) * stride);
+  memset (count, 0, sizeof (unsigned) * stride);
+  if (second_order)
+    memset (second_order, 0, sizeof (SecondOrderType) * stride);
+
+  // Sum each row, independently of the others...
+#ifdef _OPENMP
+#pragma omp parallel for schedule (static) num_threads (threads_)
+#endif
+  for (int rowIdx = 0; rowIdx < height; ++rowIdx)
   {
-    for (unsigned rowIdx = 0; rowIdx < height_; ++rowIdx, data += row_stride,
-                                                previous_row = current_row, current_row += (width_ + 1),
-                                                count_previous_row = count_current_row, count_current_row += (width_ + 1))
-    {
-      current_row [0].setZero ();
-      count_current_row [0] = 0;
-      for (unsigned colIdx = 0, valIdx = 0; colIdx < width_; ++colIdx, valIdx += element_stride)
-      {
-        current_row [colIdx + 1] = previous_row [colIdx + 1] + current_row [colIdx] - previous_row [colIdx];
-        count_current_row [colIdx + 1] = count_previous_row [colIdx + 1] + count_current_row [colIdx] - count_previous_row [colIdx];
-        const InputType* element = reinterpret_cast <const InputType*> (&data [valIdx]);
-        if (pcl_isfinite (element->sum ()))
-        {
-          current_row [colIdx + 1] += element->template cast<typename IntegralImageTypeTraits<DataType>::IntegralType>();
-          ++(count_current_row [colIdx + 1]);
-        }
-      }
-    }
-  }
-  else
-  {
-    SecondOrderType* so_previous_row = &second_order_integral_image_[0];
-    SecondOrderType* so_current_row  = so_previous_row + (width_ + 1);
-    memset (so_previous_row, 0, sizeof (SecondOrderType) * (width_ + 1));
-
-    SecondOrderType so_element;
-    for (unsigned rowIdx = 0; rowIdx < height_; ++rowIdx, data += row_stride,
-                                                previous_row = current_row, current_row += (width_ + 1),
-                                                count_previous_row = count_current_row, count_current_row += (width_ + 1),
-                                                so_previous_row = so_current_row, so_current_row += (width_ + 1))
-    {
-      current_row [0].setZero ();
+    const DataType *row_data = data + static_cast<size_t> (rowIdx) * row_stride;
+    ElementType* current_row = first_order + static_cast<size_t> (rowIdx + 1) * stride;
+    unsigned* count_current_row = count + static_cast<size_t> (rowIdx + 1) * stride;
+    SecondOrderType* so_current_row = second_order ? second_order + static_cast<size_t> (rowIdx + 1) * stride : NULL;
+
+    ElementType sum = ElementType::Zero ();
+    SecondOrderType so_sum = SecondOrderType::Zero ();
+    unsigned finite_count = 0;
+    current_row [0].setZero ();
+    count_current_row [0] = 0;
+    if (so_current_row)
       so_current_row [0].setZero ();
-      count_current_row [0] = 0;
-      for (unsigned colIdx = 0, valIdx = 0; colIdx < width_; ++colIdx, valIdx += element_stride)
+    for (unsigned colIdx = 0, valIdx = 0; colIdx < width_; ++colIdx, valIdx += element_stride)
+    {
+      const InputType* element = reinterpret_cast <const InputType*> (&row_data [valIdx]);
+      if (pcl_isfinite (element->sum ()))
       {
-        current_row [colIdx + 1] = previous_row [colIdx + 1] + current_row [colIdx] - previous_row [colIdx];
-        so_current_row [colIdx + 1] = so_previous_row [colIdx + 1] + so_current_row [colIdx] - so_previous_row [colIdx];
-        count_current_row [colIdx + 1] = count_previous_row [colIdx + 1] + count_current_row [colIdx] - count_previous_row [colIdx];
-
-        const InputType* element = reinterpret_cast <const InputType*> (&data [valIdx]);
-        if (pcl_isfinite (element->sum ()))
+        sum += element->template cast<IntegralType>();
+        ++finite_count;
+        if (so_current_row)
         {
-          current_row [colIdx + 1] += element->template cast<typename IntegralImageTypeTraits<DataType>::IntegralType>();
-          ++(count_current_row [colIdx + 1]);
           for (unsigned myIdx = 0, elIdx = 0; myIdx < Dimension; ++myIdx)
             for (unsigned mxIdx = myIdx; mxIdx < Dimension; ++mxIdx, ++elIdx)
-              so_current_row [colIdx + 1][elIdx] += (*element)[myIdx] * (*element)[mxIdx];
+              so_sum [elIdx] += (*element)[myIdx] * (*element)[mxIdx];
         }
       }
+      current_row [colIdx + 1] = sum;
+      count_current_row [colIdx + 1] = finite_count;
+      if (so_current_row)
+        so_current_row [colIdx + 1] = so_sum;
     }
   }
+
+  // ...then accumulate the row sums along the columns
+  detail::accumulateIntegralImageRows (reinterpret_cast<IntegralType*> (first_order), Dimension * stride, height + 1, threads_);
+  detail::accumulateIntegralImageRows (count, stride, height + 1, threads_);
+  if (second_order)
+    detail::accumulateIntegralImageRows (reinterpret_cast<IntegralType*> (second_order), second_order_size * stride, height + 1, threads_);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -222,15 +296,17 @@ pcl::IntegralImage2D<DataType, Dimension>::computeIntegralImages (
 template <typename DataType> void
 pcl::IntegralImage2D<DataType, 1>::setInput (const DataType * data, unsigned width,unsigned height, unsigned element_stride, unsigned row_stride)
 {
-  if ((width + 1) * (height + 1) > first_order_integral_image_.size () )
+  // The images only grow, so that a stream of frames of the same size reuses them
+  width_  = width;
+  height_ = height;
+  const size_t size = (width_ + 1) * (height_ + 1);
+  if (first_order_integral_image_.size () < size)
   {
-    width_  = width;
-    height_ = height;
-    first_order_integral_image_.resize ( (width_ + 1) * (height_ + 1) );
-    finite_values_integral_image_.resize ( (width_ + 1) * (height_ + 1) );
-    if (compute_second_order_integral_images_)
-      second_order_integral_image_.resize ( (width_ + 1) * (height_ + 1) );
+    first_order_integral_image_.resize (size);
+    finite_values_integral_image_.resize (size);
   }
+  if (compute_second_order_integral_images_ && second_order_integral_image_.size () < size)
+    second_order_integral_image_.resize (size);
   computeIntegralImages (data, row_stride, element_stride);
 }
 
@@ -323,62 +399,55 @@ template <typename DataType> void
 pcl::IntegralImage2D<DataType, 1>::computeIntegralImages (
     const DataType *data, unsigned row_stride, unsigned element_stride)
 {
-  ElementType* previous_row = &first_order_integral_image_[0];
-  ElementType* current_row  = previous_row + (width_ + 1);
-  memset (previous_row, 0, sizeof (ElementType) * (width_ + 1));
-
-  unsigned* count_previous_row = &finite_values_integral_image_[0];
-  unsigned* count_current_row  = count_previous_row + (width_ + 1);
-  memset (count_previous_row, 0, sizeof (unsigned) * (width_ + 1));
-
-  if (!compute_second_order_integral_images_)
-  {
-    for (unsigned rowIdx = 0; rowIdx < height_; ++rowIdx, data += row_stride,
-                                                previous_row = current_row, current_row += (width_ + 1),
-                                                count_previous_row = count_current_row, count_current_row += (width_ + 1))
-    {
-      current_row [0] = 0.0;
-      count_current_row [0] = 0;
-      for (unsigned colIdx = 0, valIdx = 0; colIdx < width_; ++colIdx, valIdx += element_stride)
-      {
-        current_row [colIdx + 1] = previous_row [colIdx + 1] + current_row [colIdx] - previous_row [colIdx];
-        count_current_row [colIdx + 1] = count_previous_row [colIdx + 1] + count_current_row [colIdx] - count_previous_row [colIdx];
-        if (pcl_isfinite (data [valIdx]))
-        {
-          current_row [colIdx + 1] += data [valIdx];
-          ++(count_current_row [colIdx + 1]);
-        }
-      }
-    }
-  }
-  else
+  const int stride = static_cast<int> (width_) + 1;
+  const int height = static_cast<int> (height_);
+  ElementType* first_order = &first_order_integral_image_[0];
+  unsigned* count = &finite_values_integral_image_[0];
+  SecondOrderType* second_order = compute_second_order_integral_images_ ? &second_order_integral_image_[0] : NULL;
+
+  memset (first_order, 0, sizeof (ElementType) * stride);
+  memset (count, 0, sizeof (unsigned) * stride);
+  if (second_order)
+    memset (second_order, 0, sizeof (SecondOrderType) * stride);
+
+  // Sum each row, independently of the others...
+#ifdef _OPENMP
+#pragma omp parallel for schedule (static) num_threads (threads_)
+#endif
+  for (int rowIdx = 0; rowIdx < height; ++rowIdx)
   {
-    SecondOrderType* so_previous_row = &second_order_integral_image_[0];
-    SecondOrderType* so_current_row  = so_previous_row + (width_ + 1);
-    memset (so_previous_row, 0, sizeof (SecondOrderType) * (width_ + 1));
-
-    for (unsigned rowIdx = 0; rowIdx < height_; ++rowIdx, data += row_stride,
-                                                previous_row = current_row, current_row += (width_ + 1),
-                                                count_previous_row = count_current_row, count_current_row += (width_ + 1),
-                                                so_previous_row = so_current_row, so_current_row += (width_ + 1))
+    const DataType *row_data = data + static_cast<size_t> (rowIdx) * row_stride;
+    ElementType* current_row = first_order + static_cast<size_t> (rowIdx + 1) * stride;
+    unsigned* count_current_row = count + static_cast<size_t> (rowIdx + 1) * stride;
+    SecondOrderType* so_current_row = second_order ? second_order + static_cast<size_t> (rowIdx + 1) * stride : NULL;
+
+    ElementType sum = 0;
+    SecondOrderType so_sum = 0;
+    unsigned finite_count = 0;
+    current_row [0] = 0;
+    count_current_row [0] = 0;
+    if (so_current_row)
+      so_current_row [0] = 0;
+    for (unsigned colIdx = 0, valIdx = 0; colIdx < width_; ++colIdx, valIdx += element_stride)
     {
-      current_row [0] = 0.0;
-      so_current_row [0] = 0.0;
-      count_current_row [0] = 0;
-      for (unsigned colIdx = 0, valIdx = 0; colIdx < width_; ++colIdx, valIdx += element_stride)
+      if (pcl_isfinite (row_data [valIdx]))
       {
-        current_row [colIdx + 1] = previous_row [colIdx + 1] + current_row [colIdx] - previous_row [colIdx];
-        so_current_row [colIdx + 1] = so_previous_row [colIdx + 1] + so_current_row [colIdx] - so_previous_row [colIdx];
-        count_current_row [colIdx + 1] = count_previous_row [colIdx + 1] + count_current_row [colIdx] - count_previous_row [colIdx];
-        if (pcl_isfinite (data[valIdx]))
-        {
-          current_row [colIdx + 1] += data[valIdx];
-          so_current_row [colIdx + 1] += data[valIdx] * data[valIdx];
-          ++(count_current_row [colIdx + 1]);
-        }
+        sum += row_data [valIdx];
+        so_sum += row_data [valIdx] * row_data [valIdx];
+        ++finite_count;
       }
+      current_row [colIdx + 1] = sum;
+      count_current_row [colIdx + 1] = finite_count;
+      if (so_current_row)
+        so_current_row [colIdx + 1] = so_sum;
     }
   }
+
+  // ...then accumulate the row sums along the columns
+  detail::accumulateIntegralImageRows (first_order, stride, height + 1, threads_);
+  detail::accumulateIntegralImageRows (count, stride, height + 1, threads_);
+  if (second_order)
+    detail::accumulateIntegralImageRows (second_order, stride, height + 1, threads_);
 }
 #endif    // PCL_INTEGRAL_IMAGE2D_IMPL_H_
 
@@ -39,15 +39,12 @@
 #include <pcl/features/boost.h>
 #include <pcl/features/integral_image_normal.h>
 #include <pcl/features/normal_3d.h>
+#include <pcl/common/time.h>
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointInT, typename PointOutT>
 pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::~IntegralImageNormalEstimation ()
 {
-  if (diff_x_ != NULL) delete diff_x_;
-  if (diff_y_ != NULL) delete diff_y_;
-  if (depth_data_ != NULL) delete depth_data_;
-  if (distance_map_ != NULL) delete distance_map_;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -66,16 +63,8 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::initData ()
     PCL_THROW_EXCEPTION (InitFailedException,
                          "[pcl::IntegralImageNormalEstimation::initData] unknown normal estimation method.");
 
-  // compute derivatives
-  if (diff_x_ != NULL) delete diff_x_;
-  if (diff_y_ != NULL) delete diff_y_;
-  if (depth_data_ != NULL) delete depth_data_;
-  if (distance_map_ != NULL) delete distance_map_;
-  diff_x_ = NULL;
-  diff_y_ = NULL;
-  depth_data_ = NULL;
-  distance_map_ = NULL;
-
+  // the buffers are kept, and only reallocated if the size of the input changes
+  pcl::StopWatch timer;
   if (normal_estimation_method_ == COVARIANCE_MATRIX)
     initCovarianceMatrixMethod ();
   else if (normal_estimation_method_ == AVERAGE_3D_GRADIENT)
@@ -84,6 +73,7 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::initData ()
     initAverageDepthChangeMethod ();
   else if (normal_estimation_method_ == SIMPLE_3D_GRADIENT)
     initSimple3DGradientMethod ();
+  integral_images_time_ = timer.getTime ();
 }
 
 
@@ -139,33 +129,41 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::initCovarianceMatrixMet
 template <typename PointInT, typename PointOutT> void
 pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::initAverage3DGradientMethod ()
 {
-  size_t data_size = (input_->points.size () << 2);
-  diff_x_ = new float[data_size];
-  diff_y_ = new float[data_size];
-
-  memset (diff_x_, 0, sizeof(float) * data_size);
-  memset (diff_y_, 0, sizeof(float) * data_size);
+  const int width = static_cast<int> (input_->width);
+  const int height = static_cast<int> (input_->height);
+  const size_t row_size = static_cast<size_t> (width) << 2;
+
+  // the buffers keep their size between frames of the same resolution. The fourth component of each element is
+  // never written, the points without gradient (first and last rows and columns) are cleared below.
+  diff_x_.resize (input_->points.size () << 2);
+  diff_y_.resize (input_->points.size () << 2);
+  std::fill (diff_x_.begin (), diff_x_.begin () + row_size, 0.0f);
+  std::fill (diff_y_.begin (), diff_y_.begin () + row_size, 0.0f);
+  std::fill (diff_x_.end () - row_size, diff_x_.end (), 0.0f);
+  std::fill (diff_y_.end () - row_size, diff_y_.end (), 0.0f);
 
   // x u x
   // l x r
   // x d x
-  const PointInT* point_up = &(input_->points [1]);
-  const PointInT* point_dn = point_up + (input_->width << 1);//&(input_->points [1 + (input_->width << 1)]);
-  const PointInT* point_lf = &(input_->points [input_->width]);
-  const PointInT* point_rg = point_lf + 2; //&(input_->points [input_->width + 2]);
-  float* diff_x_ptr = diff_x_ + ((input_->width + 1) << 2);
-  float* diff_y_ptr = diff_y_ + ((input_->width + 1) << 2);
-  unsigned diff_skip = 8; // skip last element in row and the first in the next row
-
-  for (size_t ri = 1; ri < input_->height - 1; ++ri
-                                             , point_up += input_->width
-                                             , point_dn += input_->width
-                                             , point_lf += input_->width
-                                             , point_rg += input_->width
-                                             , diff_x_ptr += diff_skip
-                                             , diff_y_ptr += diff_skip)
+#ifdef _OPENMP
+#pragma omp parallel for num_threads (threads_) schedule (static)
+#endif
+  for (int ri = 1; ri < height - 1; ++ri)
   {
-    for (size_t ci = 0; ci < input_->width - 2; ++ci, diff_x_ptr += 4, diff_y_ptr += 4)
+    const PointInT* point_up = &(input_->points [(ri - 1) * width + 1]);
+    const PointInT* point_dn = &(input_->points [(ri + 1) * width + 1]);
+    const PointInT* point_lf = &(input_->points [ri * width]);
+    const PointInT* point_rg = point_lf + 2;
+    float* diff_x_ptr = &diff_x_[ri * row_size];
+    float* diff_y_ptr = &diff_y_[ri * row_size];
+
+    // first element of the row
+    std::fill (diff_x_ptr, diff_x_ptr + 4, 0.0f);
+    std::fill (diff_y_ptr, diff_y_ptr + 4, 0.0f);
+    diff_x_ptr += 4;
+    diff_y_ptr += 4;
+
+    for (int ci = 0; ci < width - 2; ++ci, diff_x_ptr += 4, diff_y_ptr += 4)
     {
       diff_x_ptr[0] = point_rg[ci].x - point_lf[ci].x;
       diff_x_ptr[1] = point_rg[ci].y - point_lf[ci].y;
@@ -175,11 +173,15 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::initAverage3DGradientMe
       diff_y_ptr[1] = point_dn[ci].y - point_up[ci].y;
       diff_y_ptr[2] = point_dn[ci].z - point_up[ci].z;
     }
+
+    // last element of the row
+    std::fill (diff_x_ptr, diff_x_ptr + 4, 0.0f);
+    std::fill (diff_y_ptr, diff_y_ptr + 4, 0.0f);
   }
 
   // Compute integral images
-  integral_image_DX_.setInput (diff_x_, input_->width, input_->height, 4, input_->width << 2);
-  integral_image_DY_.setInput (diff_y_, input_->width, input_->height, 4, input_->width << 2);
+  integral_image_DX_.setInput (&diff_x_[0], input_->width, input_->height, 4, input_->width << 2);
+  integral_image_DY_.setInput (&diff_y_[0], input_->width, input_->height, 4, input_->width << 2);
   init_covariance_matrix_ = init_depth_change_ = init_simple_3d_gradient_ = false;
   init_average_3d_gradient_ = true;
 }
@@ -206,14 +208,28 @@ template <typename PointInT, typename PointOutT> void
 pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormal (
     const int pos_x, const int pos_y, const unsigned point_index, PointOutT &normal)
 {
+  if (!isMethodInitialized ())
+    initData ();
+
+  computePointNormal (pos_x, pos_y, point_index, rect_width_, rect_height_, normal);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointOutT> void
+pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormal (
+    const int pos_x, const int pos_y, const unsigned point_index,
+    const int rect_width, const int rect_height, PointOutT &normal) const
+{
+  const int rect_width_2 = rect_width / 2;
+  const int rect_width_4 = rect_width / 4;
+  const int rect_height_2 = rect_height / 2;
+  const int rect_height_4 = rect_height / 4;
+
   float bad_point = std::numeric_limits<float>::quiet_NaN ();
 
   if (normal_estimation_method_ == COVARIANCE_MATRIX)
   {
-    if (!init_covariance_matrix_)
-      initCovarianceMatrixMethod ();
-
-    unsigned count = integral_image_XYZ_.getFiniteElementsCount (pos_x - (rect_width_2_), pos_y - (rect_height_2_), rect_width_, rect_height_);
+    unsigned count = integral_image_XYZ_.getFiniteElementsCount (pos_x - (rect_width_2), pos_y - (rect_height_2), rect_width, rect_height);
 
     // no valid points within the rectangular reagion?
     if (count == 0)
@@ -225,8 +241,8 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormal (
     EIGEN_ALIGN16 Eigen::Matrix3f covariance_matrix;
     Eigen::Vector3f center;
     typename IntegralImage2D<float, 3>::SecondOrderType so_elements;
-    center = integral_image_XYZ_.getFirstOrderSum(pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_).template cast<float> ();
-    so_elements = integral_image_XYZ_.getSecondOrderSum(pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_);
+    center = integral_image_XYZ_.getFirstOrderSum(pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height).template cast<float> ();
+    so_elements = integral_image_XYZ_.getSecondOrderSum(pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height);
 
     covariance_matrix.coeffRef (0) = static_cast<float> (so_elements [0]);
     covariance_matrix.coeffRef (1) = covariance_matrix.coeffRef (3) = static_cast<float> (so_elements [1]);
@@ -252,18 +268,15 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormal (
   }
   else if (normal_estimation_method_ == AVERAGE_3D_GRADIENT)
   {
-    if (!init_average_3d_gradient_)
-      initAverage3DGradientMethod ();
-
-    unsigned count_x = integral_image_DX_.getFiniteElementsCount (pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_);
-    unsigned count_y = integral_image_DY_.getFiniteElementsCount (pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_);
+    unsigned count_x = integral_image_DX_.getFiniteElementsCount (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height);
+    unsigned count_y = integral_image_DY_.getFiniteElementsCount (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height);
     if (count_x == 0 || count_y == 0)
     {
       normal.normal_x = normal.normal_y = normal.normal_z = normal.curvature = bad_point;
       return;
     }
-    Eigen::Vector3d gradient_x = integral_image_DX_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_);
-    Eigen::Vector3d gradient_y = integral_image_DY_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_);
+    Eigen::Vector3d gradient_x = integral_image_DX_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height);
+    Eigen::Vector3d gradient_y = integral_image_DY_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height);
 
     Eigen::Vector3d normal_vector = gradient_y.cross (gradient_x);
     double normal_length = normal_vector.squaredNorm ();
@@ -291,25 +304,22 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormal (
   }
   else if (normal_estimation_method_ == AVERAGE_DEPTH_CHANGE)
   {
-    if (!init_depth_change_)
-      initAverageDepthChangeMethod ();
-
-//    unsigned count = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_);
+//    unsigned count = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height);
 //    if (count == 0)
 //    {
 //      normal.normal_x = normal.normal_y = normal.normal_z = normal.curvature = bad_point;
 //      return;
 //    }
-//    const float mean_L_z = integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2_ - 1, pos_y - rect_height_2_    , rect_width_ - 1, rect_height_ - 1) / ((rect_width_-1)*(rect_height_-1));
-//    const float mean_R_z = integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2_ + 1, pos_y - rect_height_2_    , rect_width_ - 1, rect_height_ - 1) / ((rect_width_-1)*(rect_height_-1));
-//    const float mean_U_z = integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2_    , pos_y - rect_height_2_ - 1, rect_width_ - 1, rect_height_ - 1) / ((rect_width_-1)*(rect_height_-1));
-//    const float mean_D_z = integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2_    , pos_y - rect_height_2_ + 1, rect_width_ - 1, rect_height_ - 1) / ((rect_width_-1)*(rect_height_-1));
+//    const float mean_L_z = integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2 - 1, pos_y - rect_height_2    , rect_width - 1, rect_height - 1) / ((rect_width-1)*(rect_height-1));
+//    const float mean_R_z = integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2 + 1, pos_y - rect_height_2    , rect_width - 1, rect_height - 1) / ((rect_width-1)*(rect_height-1));
+//    const float mean_U_z = integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2    , pos_y - rect_height_2 - 1, rect_width - 1, rect_height - 1) / ((rect_width-1)*(rect_height-1));
+//    const float mean_D_z = integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2    , pos_y - rect_height_2 + 1, rect_width - 1, rect_height - 1) / ((rect_width-1)*(rect_height-1));
 
     // width and height are at least 3 x 3
-    unsigned count_L_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_2_, pos_y - rect_height_4_, rect_width_2_, rect_height_2_);
-    unsigned count_R_z = integral_image_depth_.getFiniteElementsCount (pos_x + 1            , pos_y - rect_height_4_, rect_width_2_, rect_height_2_);
-    unsigned count_U_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_4_, pos_y - rect_height_2_, rect_width_2_, rect_height_2_);
-    unsigned count_D_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_4_, pos_y + 1             , rect_width_2_, rect_height_2_);
+    unsigned count_L_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_2, pos_y - rect_height_4, rect_width_2, rect_height_2);
+    unsigned count_R_z = integral_image_depth_.getFiniteElementsCount (pos_x + 1            , pos_y - rect_height_4, rect_width_2, rect_height_2);
+    unsigned count_U_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_4, pos_y - rect_height_2, rect_width_2, rect_height_2);
+    unsigned count_D_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_4, pos_y + 1             , rect_width_2, rect_height_2);
 
     if (count_L_z == 0 || count_R_z == 0 || count_U_z == 0 || count_D_z == 0)
     {
@@ -317,15 +327,15 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormal (
       return;
     }
 
-    float mean_L_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_4_, rect_width_2_, rect_height_2_) / count_L_z);
-    float mean_R_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x + 1            , pos_y - rect_height_4_, rect_width_2_, rect_height_2_) / count_R_z);
-    float mean_U_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_4_, pos_y - rect_height_2_, rect_width_2_, rect_height_2_) / count_U_z);
-    float mean_D_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_4_, pos_y + 1             , rect_width_2_, rect_height_2_) / count_D_z);
+    float mean_L_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_4, rect_width_2, rect_height_2) / count_L_z);
+    float mean_R_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x + 1            , pos_y - rect_height_4, rect_width_2, rect_height_2) / count_R_z);
+    float mean_U_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_4, pos_y - rect_height_2, rect_width_2, rect_height_2) / count_U_z);
+    float mean_D_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_4, pos_y + 1             , rect_width_2, rect_height_2) / count_D_z);
 
-    PointInT pointL = input_->points[point_index - rect_width_4_ - 1];
-    PointInT pointR = input_->points[point_index + rect_width_4_ + 1];
-    PointInT pointU = input_->points[point_index - rect_height_4_ * input_->width - 1];
-    PointInT pointD = input_->points[point_index + rect_height_4_ * input_->width + 1];
+    PointInT pointL = input_->points[point_index - rect_width_4 - 1];
+    PointInT pointR = input_->points[point_index + rect_width_4 + 1];
+    PointInT pointU = input_->points[point_index - rect_height_4 * input_->width - 1];
+    PointInT pointD = input_->points[point_index + rect_height_4 * input_->width + 1];
 
     const float mean_x_z = mean_R_z - mean_L_z;
     const float mean_y_z = mean_D_z - mean_U_z;
@@ -361,15 +371,12 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormal (
   }
   else if (normal_estimation_method_ == SIMPLE_3D_GRADIENT)
   {
-    if (!init_simple_3d_gradient_)
-      initSimple3DGradientMethod ();
-
     // this method does not work if lots of NaNs are in the neighborhood of the point
-    Eigen::Vector3d gradient_x = integral_image_XYZ_.getFirstOrderSum (pos_x + rect_width_2_, pos_y - rect_height_2_, 1, rect_height_) -
-                                 integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_2_, 1, rect_height_);
+    Eigen::Vector3d gradient_x = integral_image_XYZ_.getFirstOrderSum (pos_x + rect_width_2, pos_y - rect_height_2, 1, rect_height) -
+                                 integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_2, 1, rect_height);
 
-    Eigen::Vector3d gradient_y = integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2_, pos_y + rect_height_2_, rect_width_, 1) -
-                                 integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, 1);
+    Eigen::Vector3d gradient_y = integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2, pos_y + rect_height_2, rect_width, 1) -
+                                 integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, 1);
     Eigen::Vector3d normal_vector = gradient_y.cross (gradient_x);
     double normal_length = normal_vector.squaredNorm ();
     if (normal_length == 0.0f)
@@ -503,6 +510,23 @@ template <typename PointInT, typename PointOutT> void
 pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalMirror (
     const int pos_x, const int pos_y, const unsigned point_index, PointOutT &normal)
 {
+  if (!isMethodInitialized ())
+    initData ();
+
+  computePointNormalMirror (pos_x, pos_y, point_index, rect_width_, rect_height_, normal);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointOutT> void
+pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalMirror (
+    const int pos_x, const int pos_y, const unsigned point_index,
+    const int rect_width, const int rect_height, PointOutT &normal) const
+{
+  const int rect_width_2 = rect_width / 2;
+  const int rect_width_4 = rect_width / 4;
+  const int rect_height_2 = rect_height / 2;
+  const int rect_height_4 = rect_height / 4;
+
   float bad_point = std::numeric_limits<float>::quiet_NaN ();
 
   const int width = input_->width;
@@ -510,13 +534,10 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalMirro
 
   if (normal_estimation_method_ == COVARIANCE_MATRIX) // ==============================================================
   {
-    if (!init_covariance_matrix_)
-      initCovarianceMatrixMethod ();
-
-    const int start_x = pos_x - rect_width_2_;
-    const int start_y = pos_y - rect_height_2_;
-    const int end_x = start_x + rect_width_;
-    const int end_y = start_y + rect_height_;
+    const int start_x = pos_x - rect_width_2;
+    const int start_y = pos_y - rect_height_2;
+    const int end_x = start_x + rect_width;
+    const int end_y = start_y + rect_height;
 
     unsigned count = 0;
     sumArea<unsigned>(start_x, start_y, end_x, end_y, width, height, boost::bind(&IntegralImage2D<float, 3>::getFiniteElementsCountSE, &integral_image_XYZ_, _1, _2, _3, _4), count);
@@ -578,13 +599,10 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalMirro
   }
   else if (normal_estimation_method_ == AVERAGE_3D_GRADIENT) // =======================================================
   {
-    if (!init_average_3d_gradient_)
-      initAverage3DGradientMethod ();
-
-    const int start_x = pos_x - rect_width_2_;
-    const int start_y = pos_y - rect_height_2_;
-    const int end_x = start_x + rect_width_;
-    const int end_y = start_y + rect_height_;
+    const int start_x = pos_x - rect_width_2;
+    const int start_y = pos_y - rect_height_2;
+    const int end_x = start_x + rect_width;
+    const int end_y = start_y + rect_height;
 
     unsigned count_x = 0;
     unsigned count_y = 0;
@@ -598,8 +616,8 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalMirro
       normal.normal_x = normal.normal_y = normal.normal_z = normal.curvature = bad_point;
       return;
     }
-    //Eigen::Vector3d gradient_x = integral_image_DX_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_);
-    //Eigen::Vector3d gradient_y = integral_image_DY_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, rect_height_);
+    //Eigen::Vector3d gradient_x = integral_image_DX_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height);
+    //Eigen::Vector3d gradient_y = integral_image_DY_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, rect_height);
 
     Eigen::Vector3d gradient_x (0, 0, 0);
     Eigen::Vector3d gradient_y (0, 0, 0);
@@ -634,22 +652,19 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalMirro
   }
   else if (normal_estimation_method_ == AVERAGE_DEPTH_CHANGE) // ======================================================
   {
-    if (!init_depth_change_)
-      initAverageDepthChangeMethod ();
-
-    //const size_t point_index_L = point_index - rect_width_4_ - 1;
-    //const size_t point_index_R = point_index + rect_width_4_ + 1;
-    //const size_t point_index_U = point_index - rect_height_4_ * width - 1;
-    //const size_t point_index_D = point_index + rect_height_4_ * width + 1;
+    //const size_t point_index_L = point_index - rect_width_4 - 1;
+    //const size_t point_index_R = point_index + rect_width_4 + 1;
+    //const size_t point_index_U = point_index - rect_height_4 * width - 1;
+    //const size_t point_index_D = point_index + rect_height_4 * width + 1;
 
-    int point_index_L_x = pos_x - rect_width_4_ - 1;
+    int point_index_L_x = pos_x - rect_width_4 - 1;
     int point_index_L_y = pos_y;
-    int point_index_R_x = pos_x + rect_width_4_ + 1;
+    int point_index_R_x = pos_x + rect_width_4 + 1;
     int point_index_R_y = pos_y;
     int point_index_U_x = pos_x - 1;
-    int point_index_U_y = pos_y - rect_height_4_;
+    int point_index_U_y = pos_y - rect_height_4;
     int point_index_D_x = pos_x + 1;
-    int point_index_D_y = pos_y + rect_height_4_;
+    int point_index_D_y = pos_y + rect_height_4;
 
     if (point_index_L_x < 0)
       point_index_L_x = -point_index_L_x;
@@ -665,10 +680,10 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalMirro
     if (point_index_D_y >= height)
       point_index_D_y = height-(point_index_D_y-(height-1));
 
-    //const size_t min_x = pos_x - rect_width_4_ - 1;
-    //const size_t max_x = pos_x + rect_width_4_ + 1;
-    //const size_t min_y = pos_y - rect_height_4_ - 1;
-    //const size_t max_y = pos_y + rect_height_4_ + 1;
+    //const size_t min_x = pos_x - rect_width_4 - 1;
+    //const size_t max_x = pos_x + rect_width_4 + 1;
+    //const size_t min_y = pos_y - rect_height_4 - 1;
+    //const size_t max_y = pos_y + rect_height_4 + 1;
 
     //if (min_x >= width || max_x >= width || min_y >= height || max_y >= height)
     //{
@@ -677,31 +692,31 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalMirro
     //}
 
 
-    const int start_x_L = pos_x - rect_width_2_;
-    const int start_y_L = pos_y - rect_height_4_;
-    const int end_x_L = start_x_L + rect_width_2_;
-    const int end_y_L = start_y_L + rect_height_2_;
+    const int start_x_L = pos_x - rect_width_2;
+    const int start_y_L = pos_y - rect_height_4;
+    const int end_x_L = start_x_L + rect_width_2;
+    const int end_y_L = start_y_L + rect_height_2;
 
     const int start_x_R = pos_x + 1;
-    const int start_y_R = pos_y - rect_height_4_;
-    const int end_x_R = start_x_R + rect_width_2_;
-    const int end_y_R = start_y_R + rect_height_2_;
+    const int start_y_R = pos_y - rect_height_4;
+    const int end_x_R = start_x_R + rect_width_2;
+    const int end_y_R = start_y_R + rect_height_2;
 
-    const int start_x_U = pos_x - rect_width_4_;
-    const int start_y_U = pos_y - rect_height_2_;
-    const int end_x_U = start_x_U + rect_width_2_;
-    const int end_y_U = start_y_U + rect_height_2_;
+    const int start_x_U = pos_x - rect_width_4;
+    const int start_y_U = pos_y - rect_height_2;
+    const int end_x_U = start_x_U + rect_width_2;
+    const int end_y_U = start_y_U + rect_height_2;
 
-    const int start_x_D = pos_x - rect_width_4_;
+    const int start_x_D = pos_x - rect_width_4;
     const int start_y_D = pos_y + 1;
-    const int end_x_D = start_x_D + rect_width_2_;
-    const int end_y_D = start_y_D + rect_height_2_;
+    const int end_x_D = start_x_D + rect_width_2;
+    const int end_y_D = start_y_D + rect_height_2;
 
     // width and height are at least 3 x 3
-    //unsigned count_L_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_2_, pos_y - rect_height_4_, rect_width_2_, rect_height_2_);
-    //unsigned count_R_z = integral_image_depth_.getFiniteElementsCount (pos_x + 1            , pos_y - rect_height_4_, rect_width_2_, rect_height_2_);
-    //unsigned count_U_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_4_, pos_y - rect_height_2_, rect_width_2_, rect_height_2_);
-    //unsigned count_D_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_4_, pos_y + 1             , rect_width_2_, rect_height_2_);
+    //unsigned count_L_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_2, pos_y - rect_height_4, rect_width_2, rect_height_2);
+    //unsigned count_R_z = integral_image_depth_.getFiniteElementsCount (pos_x + 1            , pos_y - rect_height_4, rect_width_2, rect_height_2);
+    //unsigned count_U_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_4, pos_y - rect_height_2, rect_width_2, rect_height_2);
+    //unsigned count_D_z = integral_image_depth_.getFiniteElementsCount (pos_x - rect_width_4, pos_y + 1             , rect_width_2, rect_height_2);
 
     unsigned count_L_z = 0;
     unsigned count_R_z = 0;
@@ -719,10 +734,10 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalMirro
       return;
     }
 
-    //float mean_L_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_4_, rect_width_2_, rect_height_2_) / count_L_z);
-    //float mean_R_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x + 1            , pos_y - rect_height_4_, rect_width_2_, rect_height_2_) / count_R_z);
-    //float mean_U_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_4_, pos_y - rect_height_2_, rect_width_2_, rect_height_2_) / count_U_z);
-    //float mean_D_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_4_, pos_y + 1             , rect_width_2_, rect_height_2_) / count_D_z);
+    //float mean_L_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_4, rect_width_2, rect_height_2) / count_L_z);
+    //float mean_R_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x + 1            , pos_y - rect_height_4, rect_width_2, rect_height_2) / count_R_z);
+    //float mean_U_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_4, pos_y - rect_height_2, rect_width_2, rect_height_2) / count_U_z);
+    //float mean_D_z = static_cast<float> (integral_image_depth_.getFirstOrderSum (pos_x - rect_width_4, pos_y + 1             , rect_width_2, rect_height_2) / count_D_z);
 
     float mean_L_z = 0;
     float mean_R_z = 0;
@@ -740,10 +755,10 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalMirro
     mean_D_z /= float (count_D_z);
 
 
-    //PointInT pointL = input_->points[point_index - rect_width_4_ - 1];
-    //PointInT pointR = input_->points[point_index + rect_width_4_ + 1];
-    //PointInT pointU = input_->points[point_index - rect_height_4_ * input_->width - 1];
-    //PointInT pointD = input_->points[point_index + rect_height_4_ * input_->width + 1];
+    //PointInT pointL = input_->points[point_index - rect_width_4 - 1];
+    //PointInT pointR = input_->points[point_index + rect_width_4 + 1];
+    //PointInT pointU = input_->points[point_index - rect_height_4 * input_->width - 1];
+    //PointInT pointD = input_->points[point_index + rect_height_4 * input_->width + 1];
     PointInT pointL = input_->points[point_index_L_y*width + point_index_L_x];
     PointInT pointR = input_->points[point_index_R_y*width + point_index_R_x];
     PointInT pointU = input_->points[point_index_U_y*width + point_index_U_x];
@@ -789,28 +804,28 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computePointNormalMirro
     //  initSimple3DGradientMethod ();
 
     //// this method does not work if lots of NaNs are in the neighborhood of the point
-    ////Eigen::Vector3d gradient_x = integral_image_XYZ_.getFirstOrderSum (pos_x + rect_width_2_, pos_y - rect_height_2_, 1, rect_height_) -
-    ////                             integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_2_, 1, rect_height_);
+    ////Eigen::Vector3d gradient_x = integral_image_XYZ_.getFirstOrderSum (pos_x + rect_width_2, pos_y - rect_height_2, 1, rect_height) -
+    ////                             integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_2, 1, rect_height);
 
-    ////Eigen::Vector3d gradient_y = integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2_, pos_y + rect_height_2_, rect_width_, 1) -
-    ////                             integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2_, pos_y - rect_height_2_, rect_width_, 1);
+    ////Eigen::Vector3d gradient_y = integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2, pos_y + rect_height_2, rect_width, 1) -
+    ////                             integral_image_XYZ_.getFirstOrderSum (pos_x - rect_width_2, pos_y - rect_height_2, rect_width, 1);
 
 
-    //const int start_x = pos_x - rect_width_2_;
-    //const int start_y = pos_y - rect_height_2_;
-    //const int end_x = start_x + rect_width_;
-    //const int end_y = start_y + rect_height_;
+    //const int start_x = pos_x - rect_width_2;
+    //const int start_y = pos_y - rect_height_2;
+    //const int end_x = start_x + rect_width;
+    //const int end_y = start_y + rect_height;
 
     //Eigen::Vector3d gradient_x (0, 0, 0);
     //Eigen::Vector3d gradient_y (0, 0, 0);
 
-    //sumArea<typename IntegralImage2D<float, 3>::ElementType>(pos_x - rect_width_2_,  pos_y - rect_height_2_,  pos_x - rect_width_2_ + 1,  pos_y - rect_height_2_ + rect_height_, width, height, boost::bind(&IntegralImage2D<float, 3>::getFirstOrderSumSE, &integral_image_XYZ_, _1, _2, _3, _4), gradient_x);
+    //sumArea<typename IntegralImage2D<float, 3>::ElementType>(pos_x - rect_width_2,  pos_y - rect_height_2,  pos_x - rect_width_2 + 1,  pos_y - rect_height_2 + rect_height, width, height, boost::bind(&IntegralImage2D<float, 3>::getFirstOrderSumSE, &integral_image_XYZ_, _1, _2, _3, _4), gradient_x);
     //gradient_x *= -1;
-    //sumArea<typename IntegralImage2D<float, 3>::ElementType>(pos_x + rect_width_2_,  pos_y - rect_height_2_,  pos_x + rect_width_2_ + 1,  pos_y - rect_height_2_ + rect_height_, width, height, boost::bind(&IntegralImage2D<float, 3>::getFirstOrderSumSE, &integral_image_XYZ_, _1, _2, _3, _4), gradient_x);
+    //sumArea<typename IntegralImage2D<float, 3>::ElementType>(pos_x + rect_width_2,  pos_y - rect_height_2,  pos_x + rect_width_2 + 1,  pos_y - rect_height_2 + rect_height, width, height, boost::bind(&IntegralImage2D<float, 3>::getFirstOrderSumSE, &integral_image_XYZ_, _1, _2, _3, _4), gradient_x);
 
-    //sumArea<typename IntegralImage2D<float, 3>::ElementType>(pos_x - rect_width_2_,  pos_y - rect_height_2_,  pos_x - rect_width_2_ + rect_width_,  pos_y - rect_height_2_ + 1,  width, height, boost::bind(&IntegralImage2D<float, 3>::getFirstOrderSumSE, &integral_image_XYZ_, _1, _2, _3, _4), gradient_y);
+    //sumArea<typename IntegralImage2D<float, 3>::ElementType>(pos_x - rect_width_2,  pos_y - rect_height_2,  pos_x - rect_width_2 + rect_width,  pos_y - rect_height_2 + 1,  width, height, boost::bind(&IntegralImage2D<float, 3>::getFirstOrderSumSE, &integral_image_XYZ_, _1, _2, _3, _4), gradient_y);
     //gradient_y *= -1;
-    //sumArea<typename IntegralImage2D<float, 3>::ElementType>(pos_x - rect_width_2_,  pos_y + rect_height_2_,  pos_x - rect_width_2_ + rect_width_,  pos_y + rect_height_2_ + 1,  width, height, boost::bind(&IntegralImage2D<float, 3>::getFirstOrderSumSE, &integral_image_XYZ_, _1, _2, _3, _4), gradient_y);
+    //sumArea<typename IntegralImage2D<float, 3>::ElementType>(pos_x - rect_width_2,  pos_y + rect_height_2,  pos_x - rect_width_2 + rect_width,  pos_y + rect_height_2 + 1,  width, height, boost::bind(&IntegralImage2D<float, 3>::getFirstOrderSumSE, &integral_image_XYZ_, _1, _2, _3, _4), gradient_y);
 
 
     //Eigen::Vector3d normal_vector = gradient_y.cross (gradient_x);
@@ -852,44 +867,48 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computeFeature (PointCl
   
   float bad_point = std::numeric_limits<float>::quiet_NaN ();
 
-  // compute depth-change map
-  unsigned char * depthChangeMap = new unsigned char[input_->points.size ()];
-  memset (depthChangeMap, 255, input_->points.size ());
-
-  unsigned index = 0;
-  for (unsigned int ri = 0; ri < input_->height-1; ++ri)
-  {
-    for (unsigned int ci = 0; ci < input_->width-1; ++ci, ++index)
-    {
-      index = ri * input_->width + ci;
+  // the integral images are shared by the threads below, they have to be computed beforehand
+  if (!isMethodInitialized ())
+    initData ();
 
-      const float depth  = input_->points [index].z;
-      const float depthR = input_->points [index + 1].z;
-      const float depthD = input_->points [index + input_->width].z;
+  if (border_policy_ == BORDER_POLICY_MIRROR && normal_estimation_method_ == SIMPLE_3D_GRADIENT)
+    PCL_THROW_EXCEPTION (PCLException, "BORDER_POLICY_MIRROR not supported for normal estimation method SIMPLE_3D_GRADIENT");
 
-      //const float depthDependendDepthChange = (max_depth_change_factor_ * (fabs(depth)+1.0f))/(500.0f*0.001f);
-      const float depthDependendDepthChange = (max_depth_change_factor_ * (fabsf (depth) + 1.0f) * 2.0f);
+  pcl::StopWatch timer;
+  const int width = static_cast<int> (input_->width);
+  const int height = static_cast<int> (input_->height);
 
-      if (fabs (depth - depthR) > depthDependendDepthChange
-        || !pcl_isfinite (depth) || !pcl_isfinite (depthR))
-      {
-        depthChangeMap[index] = 0;
-        depthChangeMap[index+1] = 0;
-      }
-      if (fabs (depth - depthD) > depthDependendDepthChange
-        || !pcl_isfinite (depth) || !pcl_isfinite (depthD))
+  // compute depth-change map: a point is marked if the depth changes too much between it and its right or lower
+  // neighbor, or between its left or upper neighbor and itself
+  depth_change_map_.resize (input_->points.size ());
+  unsigned char *depthChangeMap = &depth_change_map_[0];
+#ifdef _OPENMP
+#pragma omp parallel for shared (depthChangeMap) num_threads (threads_) schedule (static)
+#endif
+  for (int ri = 0; ri < height; ++ri)
+  {
+    const PointInT *row = &(input_->points [ri * width]);
+    for (int ci = 0; ci < width; ++ci)
+    {
+      const float depth = row [ci].z;
+      bool depth_change = false;
+      if (ri < height - 1)
       {
-        depthChangeMap[index] = 0;
-        depthChangeMap[index + input_->width] = 0;
+        if (ci < width - 1)
+          depth_change = isDepthChange (depth, row [ci + 1].z) || isDepthChange (depth, row [ci + width].z);
+        if (!depth_change && ci > 0)
+          depth_change = isDepthChange (row [ci - 1].z, depth);
       }
+      if (!depth_change && ri > 0 && ci < width - 1)
+        depth_change = isDepthChange (row [ci - width].z, depth);
+
+      depthChangeMap [ri * width + ci] = depth_change ? 0 : 255;
     }
   }
 
   // compute distance map
-  //float *distanceMap = new float[input_->points.size ()];
-  if (distance_map_ != NULL) delete distance_map_;
-  distance_map_ = new float[input_->points.size ()];
-  float *distanceMap = distance_map_;
+  distance_map_.resize (input_->points.size ());
+  float *distanceMap = &distance_map_[0];
   for (size_t index = 0; index < input_->points.size (); ++index)
   {
     if (depthChangeMap[index] == 0)
@@ -898,6 +917,7 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computeFeature (PointCl
       distanceMap[index] = static_cast<float> (input_->width + input_->height);
   }
 
+  // both passes depend on the rows computed before, they are done sequentially
   // first pass
   float* previous_row = distanceMap;
   float* current_row = previous_row + input_->width;
@@ -942,12 +962,16 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computeFeature (PointCl
     current_row -= input_->width;
   }
 
+  distance_map_time_ = timer.getTime ();
+  timer.reset ();
+
+  // Set all normals that we do not touch to NaN
+  // That sets the output density to false!
+  output.is_dense = false;
+
   if (border_policy_ == BORDER_POLICY_IGNORE)
   {
-    // Set all normals that we do not touch to NaN
     // top and bottom borders
-    // That sets the output density to false!
-    output.is_dense = false;
     unsigned border = int(normal_smoothing_size_);
     PointOutT* vec1 = &output [0];
     PointOutT* vec2 = vec1 + input_->width * (input_->height - border);
@@ -975,153 +999,86 @@ pcl::IntegralImageNormalEstimation<PointInT, PointOutT>::computeFeature (PointCl
       }
     }
 
-    if (use_depth_dependent_smoothing_)
+    // the rows are processed in bands of 8, the cost of a row depends on the number of valid points
+    const int border_size = static_cast<int> (border);
+#ifdef _OPENMP
+#pragma omp parallel for shared (output, distanceMap) num_threads (threads_) schedule (dynamic, 8)
+#endif
+    for (int ri = border_size; ri < height - border_size; ++ri)
     {
-      index = border + input_->width * border;
-      unsigned skip = (border << 1);
-      for (unsigned ri = border; ri < input_->height - border; ++ri, index += skip)
+      for (int ci = border_size; ci < width - border_size; ++ci)
       {
-        for (unsigned ci = border; ci < input_->width - border; ++ci, ++index)
+        const int index = ri * width + ci;
+
+        const float depth = input_->points[index].z;
+        if (!pcl_isfinite (depth))
         {
-          index = ri * input_->width + ci;
-
-          const float depth = input_->points[index].z;
-          if (!pcl_isfinite (depth))
-          {
-            output[index].getNormalVector3fMap ().setConstant (bad_point);
-            output[index].curvature = bad_point;
-            continue;
-          }
-
-          float smoothing = (std::min)(distanceMap[index], normal_smoothing_size_ + static_cast<float>(depth)/10.0f);
-
-          if (smoothing > 2.0f)
-          {
-            setRectSize (static_cast<int> (smoothing), static_cast<int> (smoothing));
-            computePointNormal (ci, ri, index, output [index]);
-          }
-          else
-          {
-            output[index].getNormalVector3fMap ().setConstant (bad_point);
-            output[index].curvature = bad_point;
-          }
+          output[index].getNormalVector3fMap ().setConstant (bad_point);
+          output[index].curvature = bad_point;
+          continue;
         }
-      }
-    }
-    else
-    {
-      float smoothing_constant = normal_smoothing_size_;
 
-      index = border + input_->width * border;
-      unsigned skip = (border << 1);
-      for (unsigned ri = border; ri < input_->height - border; ++ri, index += skip)
-      {
-        for (unsigned ci = border; ci < input_->width - border; ++ci, ++index)
+        float smoothing;
+        if (use_depth_dependent_smoothing_)
+          smoothing = (std::min)(distanceMap[index], normal_smoothing_size_ + static_cast<float>(depth)/10.0f);
+        else
+          smoothing = (std::min)(distanceMap[index], normal_smoothing_size_);
+
+        if (smoothing > 2.0f)
+        {
+          const int rect_size = static_cast<int> (smoothing);
+          computePointNormal (ci, ri, index, rect_size, rect_size, output [index]);
+        }
+        else
         {
-          index = ri * input_->width + ci;
-
-          if (!pcl_isfinite (input_->points[index].z))
-          {
-            output [index].getNormalVector3fMap ().setConstant (bad_point);
-            output [index].curvature = bad_point;
-            continue;
-          }
-
-          float smoothing = (std::min)(distanceMap[index], smoothing_constant);
-
-          if (smoothing > 2.0f)
-          {
-            setRectSize (static_cast<int> (smoothing), static_cast<int> (smoothing));
-            computePointNormal (ci, ri, index, output [index]);
-          }
-          else
-          {
-            output [index].getNormalVector3fMap ().setConstant (bad_point);
-            output [index].curvature = bad_point;
-          }
+          output[index].getNormalVector3fMap ().setConstant (bad_point);
+          output[index].curvature = bad_point;
         }
       }
     }
   }
   else if (border_policy_ == BORDER_POLICY_MIRROR)
   {
-    output.is_dense = false;
-
-    if (use_depth_dependent_smoothing_)
+#ifdef _OPENMP
+#pragma omp parallel for shared (output, distanceMap) num_threads (threads_) schedule (dynamic, 8)
+#endif
+    for (int ri = 0; ri < height; ++ri)
     {
-      //index = 0;
-      //unsigned skip = 0;
-      //for (unsigned ri = 0; ri < input_->height; ++ri, index += skip)
-      for (unsigned ri = 0; ri < input_->height; ++ri)
+      for (int ci = 0; ci < width; ++ci)
       {
-        //for (unsigned ci = 0; ci < input_->width; ++ci, ++index)
-        for (unsigned ci = 0; ci < input_->width; ++ci)
+        const int index = ri * width + ci;
+
+        const float depth = input_->points[index].z;
+        if (!pcl_isfinite (depth))
         {
-          index = ri * input_->width + ci;
-
-          const float depth = input_->points[index].z;
-          if (!pcl_isfinite (depth))
-          {
-            output[index].getNormalVector3fMap ().setConstant (bad_point);
-            output[index].curvature = bad_point;
-            continue;
-          }
-
-          float smoothing = (std::min)(distanceMap[index], normal_smoothing_size_ + static_cast<float>(depth)/10.0f);
-
-          if (smoothing > 2.0f)
-          {
-            setRectSize (static_cast<int> (smoothing), static_cast<int> (smoothing));
-            computePointNormalMirror (ci, ri, index, output [index]);
-          }
-          else
-          {
-            output[index].getNormalVector3fMap ().setConstant (bad_point);
-            output[index].curvature = bad_point;
-          }
+          output[index].getNormalVector3fMap ().setConstant (bad_point);
+          output[index].curvature = bad_point;
+          continue;
         }
-      }
-    }
-    else
-    {
-      float smoothing_constant = normal_smoothing_size_;
 
-      //index = border + input_->width * border;
-      //unsigned skip = (border << 1);
-      //for (unsigned ri = border; ri < input_->height - border; ++ri, index += skip)
-      for (unsigned ri = 0; ri < input_->height; ++ri)
-      {
-        //for (unsigned ci = border; ci < input_->width - border; ++ci, ++index)
-        for (unsigned ci = 0; ci < input_->width; ++ci)
+        float smoothing;
+        if (use_depth_dependent_smoothing_)
+          smoothing = (std::min)(distanceMap[index], normal_smoothing_size_ + static_cast<float>(depth)/10.0f);
+        else
+          smoothing = (std::min)(distanceMap[index], normal_smoothing_size_);
+
+        if (smoothing > 2.0f)
+        {
+          const int rect_size = static_cast<int> (smoothing);
+          computePointNormalMirror (ci, ri, index, rect_size, rect_size, output [index]);
+        }
+        else
         {
-          index = ri * input_->width + ci;
-
-          if (!pcl_isfinite (input_->points[index].z))
-          {
-            output [index].getNormalVector3fMap ().setConstant (bad_point);
-            output [index].curvature = bad_point;
-            continue;
-          }
-
-          float smoothing = (std::min)(distanceMap[index], smoothing_constant);
-
-          if (smoothing > 2.0f)
-          {
-            setRectSize (static_cast<int> (smoothing), static_cast<int> (smoothing));
-            computePointNormalMirror (ci, ri, index, output [index]);
-          }
-          else
-          {
-            output [index].getNormalVector3fMap ().setConstant (bad_point);
-            output [index].curvature = bad_point;
-          }
+          output[index].getNormalVector3fMap ().setConstant (bad_point);
+          output[index].curvature = bad_point;
         }
       }
     }
   }
 
-  delete[] depthChangeMap;
-  //delete[] distanceMap;
+  normals_time_ = timer.getTime ();
+  PCL_DEBUG ("[pcl::IntegralImageNormalEstimation::computeFeature] %ux%u: integral images %g ms, distance map %g ms, normals %g ms\n",
+             input_->width, input_->height, integral_images_time_, distance_map_time_, normals_time_);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
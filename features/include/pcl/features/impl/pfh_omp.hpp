@@ -0,0 +1,238 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_FEATURES_IMPL_PFH_OMP_H_
+#define PCL_FEATURES_IMPL_PFH_OMP_H_
+
+#include <pcl/features/pfh_omp.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT> void
+pcl::PFHEstimationOMP<PointInT, PointNT, PointOutT>::computeFeature (PointCloudOut &output)
+{
+  neighborhoods_.reset (input_->points.size ());
+  std::vector<int> queries;
+  getUniqueQueries (queries);
+  neighborhoods_.search (search_method_surface_, *input_, queries, search_parameter_, threads_);
+
+  // Size the cache from the number of pairs, most of which appear in several neighborhoods
+  size_t nr_pairs = 0, nr_neighbors = 0;
+  for (size_t i = 0; i < queries.size (); ++i)
+  {
+    const size_t m = neighborhoods_.getIndices (queries[i]).size ();
+    if (m > 1)
+      nr_pairs += m * (m - 1) / 2;
+    nr_neighbors += m;
+  }
+  nr_pairs = (std::min) (nr_pairs, 4 * nr_neighbors);
+  pair_cache_.resize (use_cache_ ? (std::min) (nr_pairs, static_cast<size_t> (max_cache_size_)) : 0);
+
+  std::vector<int> positions (indices_->size ());
+  for (size_t idx = 0; idx < positions.size (); ++idx)
+    positions[idx] = static_cast<int> (idx);
+  computePFHSignatures (positions, output);
+
+  previous_indices_ = *indices_;
+  previous_search_parameter_ = search_parameter_;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT> void
+pcl::PFHEstimationOMP<PointInT, PointNT, PointOutT>::computeChanged (const std::vector<int> &changed_indices,
+                                                                     PointCloudOut &output)
+{
+  if (!initCompute ())
+  {
+    output.width = output.height = 0;
+    output.points.clear ();
+    return;
+  }
+  // The points changed in place, so the spatial locator has to be built again
+  tree_->setInputCloud (surface_);
+
+  const int nr_points = static_cast<int> (surface_->points.size ());
+  if (surface_ != input_ || static_cast<int> (neighborhoods_.size ()) != nr_points ||
+      output.points.size () != indices_->size () || previous_indices_ != *indices_ ||
+      previous_search_parameter_ != search_parameter_)
+  {
+    deinitCompute ();
+    this->compute (output);
+    return;
+  }
+
+  std::vector<char> changed (nr_points, 0);
+  for (size_t i = 0; i < changed_indices.size (); ++i)
+    if (changed_indices[i] >= 0 && changed_indices[i] < nr_points)
+      changed[changed_indices[i]] = 1;
+  pair_cache_.erase (changed);
+
+  // The descriptors to compute again are the ones of the changed points, the ones whose neighborhood contained a
+  // changed point, and the ones whose neighborhood may contain a changed point now, within the search radius (or
+  // the largest k-th neighbor distance) of its new position
+  std::vector<char> dirty (changed);
+  neighborhoods_.findContaining (changed, dirty, threads_);
+  const double radius = (k_ == 0 ? search_parameter_ : sqrt (neighborhoods_.getMaxSqrDistance ())) * 1.0001;
+  std::vector<int> nn_indices;
+  std::vector<float> nn_dists;
+  for (size_t i = 0; i < changed_indices.size (); ++i)
+  {
+    const int p_idx = changed_indices[i];
+    if (p_idx < 0 || p_idx >= nr_points || !isFinite (surface_->points[p_idx]))
+      continue;
+    tree_->radiusSearch (*surface_, p_idx, radius, nn_indices, nn_dists);
+    for (size_t j = 0; j < nn_indices.size (); ++j)
+      dirty[nn_indices[j]] = 1;
+  }
+
+  std::vector<int> queries, dirty_queries;
+  getUniqueQueries (queries);
+  for (size_t i = 0; i < queries.size (); ++i)
+    if (dirty[queries[i]])
+      dirty_queries.push_back (queries[i]);
+  neighborhoods_.search (search_method_surface_, *input_, dirty_queries, search_parameter_, threads_);
+
+  std::vector<int> positions;
+  for (int idx = 0; idx < static_cast<int> (indices_->size ()); ++idx)
+    if (dirty[(*indices_)[idx]])
+      positions.push_back (idx);
+  computePFHSignatures (positions, output);
+
+  output.is_dense = true;
+  for (size_t idx = 0; idx < output.points.size () && output.is_dense; ++idx)
+    output.is_dense = pcl_isfinite (output.points[idx].histogram[0]);
+
+  deinitCompute ();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT> void
+pcl::PFHEstimationOMP<PointInT, PointNT, PointOutT>::getUniqueQueries (std::vector<int> &queries) const
+{
+  std::vector<char> is_query (input_->points.size (), 0);
+  queries.clear ();
+  for (size_t idx = 0; idx < indices_->size (); ++idx)
+  {
+    const int q_idx = (*indices_)[idx];
+    if (is_query[q_idx])
+      continue;
+    is_query[q_idx] = 1;
+    queries.push_back (q_idx);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT> void
+pcl::PFHEstimationOMP<PointInT, PointNT, PointOutT>::computePFHSignatures (const std::vector<int> &positions,
+                                                                           PointCloudOut &output)
+{
+  const int nr_bins = nr_subdiv_ * nr_subdiv_ * nr_subdiv_;
+  bool is_dense = true;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule (dynamic, 64) shared (output) reduction (&&: is_dense) num_threads(threads_)
+#endif
+  for (int i = 0; i < static_cast<int> (positions.size ()); ++i)
+  {
+    const int idx = positions[i];
+    const std::vector<int> &nn_indices = neighborhoods_.getIndices ((*indices_)[idx]);
+    if (nn_indices.empty ())
+    {
+      for (int d = 0; d < nr_bins; ++d)
+        output.points[idx].histogram[d] = std::numeric_limits<float>::quiet_NaN ();
+
+      is_dense = false;
+      continue;
+    }
+
+    // Estimate the PFH signature at each patch
+    Eigen::VectorXf pfh_histogram (nr_bins);
+    computeCachedPFHSignature (nn_indices, pfh_histogram);
+
+    // Copy into the resultant cloud
+    for (int d = 0; d < nr_bins; ++d)
+      output.points[idx].histogram[d] = pfh_histogram[d];
+  }
+
+  if (!is_dense)
+    output.is_dense = false;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointInT, typename PointNT, typename PointOutT> void
+pcl::PFHEstimationOMP<PointInT, PointNT, PointOutT>::computeCachedPFHSignature (const std::vector<int> &indices,
+                                                                                Eigen::VectorXf &pfh_histogram)
+{
+  const int nr_split = nr_subdiv_;
+  pfh_histogram.setZero ();
+
+  // Factorization constant
+  float hist_incr = 100.0f / static_cast<float> (indices.size () * (indices.size () - 1) / 2);
+
+  Eigen::Vector4f pfh_tuple;
+  int f_index[3];
+  for (size_t i_idx = 0; i_idx < indices.size (); ++i_idx)
+  {
+    for (size_t j_idx = 0; j_idx < i_idx; ++j_idx)
+    {
+      // If the 3D points are invalid, don't bother estimating, just continue
+      if (!isFinite (surface_->points[indices[i_idx]]) || !isFinite (surface_->points[indices[j_idx]]))
+        continue;
+
+      // A pair whose features cannot be computed is counted with null features, as in computePointPFHSignature
+      pair_cache_.computePairFeatures (*surface_, *normals_, indices[i_idx], indices[j_idx], pfh_tuple);
+
+      // Normalize the f1, f2, f3 features and push them in the histogram
+      f_index[0] = static_cast<int> (floor (nr_split * ((pfh_tuple[0] + M_PI) * d_pi_)));
+      if (f_index[0] < 0)         f_index[0] = 0;
+      if (f_index[0] >= nr_split) f_index[0] = nr_split - 1;
+
+      f_index[1] = static_cast<int> (floor (nr_split * ((pfh_tuple[1] + 1.0) * 0.5)));
+      if (f_index[1] < 0)         f_index[1] = 0;
+      if (f_index[1] >= nr_split) f_index[1] = nr_split - 1;
+
+      f_index[2] = static_cast<int> (floor (nr_split * ((pfh_tuple[2] + 1.0) * 0.5)));
+      if (f_index[2] < 0)         f_index[2] = 0;
+      if (f_index[2] >= nr_split) f_index[2] = nr_split - 1;
+
+      pfh_histogram[f_index[0] + nr_split * (f_index[1] + nr_split * f_index[2])] += hist_incr;
+    }
+  }
+}
+
+#define PCL_INSTANTIATE_PFHEstimationOMP(T,NT,OutT) template class PCL_EXPORTS pcl::PFHEstimationOMP<T,NT,OutT>;
+
+#endif    // PCL_FEATURES_IMPL_PFH_OMP_H_
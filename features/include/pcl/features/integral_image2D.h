@@ -100,6 +100,10 @@ namespace pcl
   };
 
   /** \brief Determines an integral image representation for a given organized data array
+    *
+    * The images are kept between calls to setInput and only reallocated when the input grows, so a stream of
+    * frames of the same size does not allocate memory. The rows are summed in parallel, and the column sums are
+    * accumulated in parallel stripes, with SSE2 when available.
     * \author Suat Gedikli
     */
   template <class DataType, unsigned Dimension>
@@ -119,7 +123,8 @@ namespace pcl
         finite_values_integral_image_ (),
         width_ (1), 
         height_ (1), 
-        compute_second_order_integral_images_ (compute_second_order_integral_images)
+        compute_second_order_integral_images_ (compute_second_order_integral_images),
+        threads_ (0)
       {
       }
 
@@ -133,6 +138,15 @@ namespace pcl
       void 
       setSecondOrderComputation (bool compute_second_order_integral_images);
 
+      /** \brief Set the number of threads used to compute the integral images.
+        * \param[in] nr_threads the number of threads to use (0 sets the value back to automatic)
+        */
+      inline void
+      setNumberOfThreads (unsigned nr_threads = 0)
+      {
+        threads_ = nr_threads;
+      }
+
       /** \brief Set the input data to compute the integral image for
         * \param[in] data the input data
         * \param[in] width the width of the data
@@ -220,6 +234,9 @@ namespace pcl
 
       /** \brief Indicates whether second order integral images are available **/
       bool compute_second_order_integral_images_;
+
+      /** \brief The number of threads used to compute the integral images (0 for automatic) */
+      unsigned threads_;
    };
 
    /**
@@ -241,7 +258,8 @@ namespace pcl
         second_order_integral_image_ (),
         finite_values_integral_image_ (),
         width_ (1), height_ (1), 
-        compute_second_order_integral_images_ (compute_second_order_integral_images)
+        compute_second_order_integral_images_ (compute_second_order_integral_images),
+        threads_ (0)
       {
       }
 
@@ -249,6 +267,15 @@ namespace pcl
       virtual
       ~IntegralImage2D () { }
 
+      /** \brief Set the number of threads used to compute the integral images.
+        * \param[in] nr_threads the number of threads to use (0 sets the value back to automatic)
+        */
+      inline void
+      setNumberOfThreads (unsigned nr_threads = 0)
+      {
+        threads_ = nr_threads;
+      }
+
       /** \brief Set the input data to compute the integral image for
         * \param[in] data the input data
         * \param[in] width the width of the data
@@ -336,6 +363,9 @@ namespace pcl
 
       /** \brief Indicates whether second order integral images are available **/
       bool compute_second_order_integral_images_;
+
+      /** \brief The number of threads used to compute the integral images (0 for automatic) */
+      unsigned threads_;
    };
  }
 
@@ -49,6 +49,11 @@
 namespace pcl
 {
   /** \brief Surface normal estimation on organized data using integral images.
+    *
+    * The buffers (integral images, gradients, depth change and distance maps) are kept between frames and only
+    * reallocated when the resolution changes, so that a stream of organized frames can be processed without
+    * allocations. The integral images and the normals are computed in parallel; see setNumberOfThreads and
+    * getTimings.
     * \author Stefan Holzer
     */
   template <typename PointInT, typename PointOutT>
@@ -101,10 +106,10 @@ namespace pcl
         , integral_image_DY_ (false)
         , integral_image_depth_ (false)
         , integral_image_XYZ_ (true)
-        , diff_x_ (NULL)
-        , diff_y_ (NULL)
-        , depth_data_ (NULL)
-        , distance_map_ (NULL)
+        , diff_x_ ()
+        , diff_y_ ()
+        , depth_change_map_ ()
+        , distance_map_ ()
         , use_depth_dependent_smoothing_ (false)
         , max_depth_change_factor_ (20.0f*0.001f)
         , normal_smoothing_size_ (10.0f)
@@ -116,6 +121,10 @@ namespace pcl
         , vpy_ (0.0f)
         , vpz_ (0.0f)
         , use_sensor_origin_ (true)
+        , threads_ (0)
+        , integral_images_time_ (0)
+        , distance_map_time_ (0)
+        , normals_time_ (0)
       {
         feature_name_ = "IntegralImagesNormalEstimation";
         tree_.reset ();
@@ -132,6 +141,33 @@ namespace pcl
       void
       setRectSize (const int width, const int height);
 
+      /** \brief Set the number of threads used to compute the integral images and the normals.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      void
+      setNumberOfThreads (unsigned int nr_threads = 0)
+      {
+        threads_ = nr_threads;
+        integral_image_DX_.setNumberOfThreads (nr_threads);
+        integral_image_DY_.setNumberOfThreads (nr_threads);
+        integral_image_depth_.setNumberOfThreads (nr_threads);
+        integral_image_XYZ_.setNumberOfThreads (nr_threads);
+      }
+
+      /** \brief Get the time spent on the last frame, in milliseconds.
+        * \param[out] integral_images_time the time spent computing the integral images of the normal estimation
+        * method (in setInputCloud, or in compute if the method changed since)
+        * \param[out] distance_map_time the time spent computing the depth change and distance maps
+        * \param[out] normals_time the time spent computing the normals
+        */
+      inline void
+      getTimings (double &integral_images_time, double &distance_map_time, double &normals_time) const
+      {
+        integral_images_time = integral_images_time_;
+        distance_map_time = distance_map_time_;
+        normals_time = normals_time_;
+      }
+
       /** \brief Sets the policy for handling borders.
         * \param[in] border_policy the border policy.
         */
@@ -225,7 +261,7 @@ namespace pcl
           return;
         }
 
-        init_covariance_matrix_ = init_average_3d_gradient_ = init_depth_change_ = false;
+        init_covariance_matrix_ = init_average_3d_gradient_ = init_depth_change_ = init_simple_3d_gradient_ = false;
         
         if (use_sensor_origin_)
         {
@@ -243,7 +279,7 @@ namespace pcl
       inline float*
       getDistanceMap ()
       {
-        return (distance_map_);
+        return (distance_map_.empty () ? NULL : &distance_map_[0]);
       }
 
       /** \brief Set the viewpoint.
@@ -310,6 +346,54 @@ namespace pcl
       void
       initData ();
 
+      /** \brief Get whether the data structures of the normal estimation method chosen are initialized. */
+      inline bool
+      isMethodInitialized () const
+      {
+        return ((normal_estimation_method_ == COVARIANCE_MATRIX && init_covariance_matrix_) ||
+                (normal_estimation_method_ == AVERAGE_3D_GRADIENT && init_average_3d_gradient_) ||
+                (normal_estimation_method_ == AVERAGE_DEPTH_CHANGE && init_depth_change_) ||
+                (normal_estimation_method_ == SIMPLE_3D_GRADIENT && init_simple_3d_gradient_));
+      }
+
+      /** \brief Computes the normal at the specified position, for a given size of the search rectangle. The data
+        * structures of the normal estimation method have to be initialized; the method is then thread safe.
+        * \param[in] pos_x x position (pixel)
+        * \param[in] pos_y y position (pixel)
+        * \param[in] point_index the position index of the point
+        * \param[in] rect_width the width of the search rectangle
+        * \param[in] rect_height the height of the search rectangle
+        * \param[out] normal the output estimated normal
+        */
+      void
+      computePointNormal (const int pos_x, const int pos_y, const unsigned point_index,
+                          const int rect_width, const int rect_height, PointOutT &normal) const;
+
+      /** \brief Computes the normal at the specified position with mirroring for border handling, for a given size
+        * of the search rectangle. The data structures of the normal estimation method have to be initialized; the
+        * method is then thread safe.
+        * \param[in] pos_x x position (pixel)
+        * \param[in] pos_y y position (pixel)
+        * \param[in] point_index the position index of the point
+        * \param[in] rect_width the width of the search rectangle
+        * \param[in] rect_height the height of the search rectangle
+        * \param[out] normal the output estimated normal
+        */
+      void
+      computePointNormalMirror (const int pos_x, const int pos_y, const unsigned point_index,
+                                const int rect_width, const int rect_height, PointOutT &normal) const;
+
+      /** \brief Check whether the depth changes too much between two neighboring points.
+        * \param[in] depth the depth of the first point
+        * \param[in] depth_neighbor the depth of the second point
+        */
+      inline bool
+      isDepthChange (const float depth, const float depth_neighbor) const
+      {
+        const float depthDependendDepthChange = (max_depth_change_factor_ * (fabsf (depth) + 1.0f) * 2.0f);
+        return (fabs (depth - depth_neighbor) > depthDependendDepthChange || !pcl_isfinite (depth) || !pcl_isfinite (depth_neighbor));
+      }
+
     private:
       /** \brief The normal estimation method to use. Currently, 3 implementations are provided:
         *
@@ -344,15 +428,15 @@ namespace pcl
       IntegralImage2D<float, 3> integral_image_XYZ_;
 
       /** derivatives in x-direction */
-      float *diff_x_;
+      std::vector<float> diff_x_;
       /** derivatives in y-direction */
-      float *diff_y_;
+      std::vector<float> diff_y_;
 
-      /** depth data */
-      float *depth_data_;
+      /** depth change map, 0 for the points next to a depth discontinuity */
+      std::vector<unsigned char> depth_change_map_;
 
       /** distance map */
-      float *distance_map_;
+      std::vector<float> distance_map_;
 
       /** \brief Smooth data based on depth (true/false). */
       bool use_depth_dependent_smoothing_;
@@ -381,6 +465,18 @@ namespace pcl
 
       /** whether the sensor origin of the input cloud or a user given viewpoint should be used.*/
       bool use_sensor_origin_;
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
+
+      /** \brief The time spent computing the integral images of the last frame, in milliseconds. */
+      double integral_images_time_;
+
+      /** \brief The time spent computing the depth change and distance maps of the last frame, in milliseconds. */
+      double distance_map_time_;
+
+      /** \brief The time spent computing the normals of the last frame, in milliseconds. */
+      double normals_time_;
       
       /** \brief This method should get called before starting the actual computation. */
       bool
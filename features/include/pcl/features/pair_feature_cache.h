@@ -0,0 +1,261 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_FEATURES_PAIR_FEATURE_CACHE_H_
+#define PCL_FEATURES_PAIR_FEATURE_CACHE_H_
+
+#include <pcl/point_types.h>
+#include <pcl/point_cloud.h>
+#include <pcl/common/point_tests.h>
+#include <boost/function.hpp>
+#include <vector>
+
+namespace pcl
+{
+  /** \brief PairFeatureCache is a bounded hash table of point pair features (see computePairFeatures), shared by
+    * several threads without locks.
+    *
+    * The pairs are stored in a flat, open-addressed table, under the key (smaller index, larger index). The features
+    * of a pair do not depend on the order of the two points, except when both normals make the same angle with the
+    * line joining the points: such pairs are not stored, so a cached pair is always identical to a computed one.
+    *
+    * Entries are never replaced: once the probes around the slot of a pair are all used, its features are
+    * computed every time. The table is sized by the caller, from the number of pairs expected.
+    *
+    * \ingroup features
+    */
+  class PCL_EXPORTS PairFeatureCache
+  {
+    public:
+      /** \brief Empty constructor, the cache holds no entry until resized. */
+      PairFeatureCache () : keys_ (), features_ (), mask_ (0) {}
+
+      /** \brief Clear the cache and set its capacity.
+        * \param[in] max_size the maximum number of pairs, rounded down to a power of two
+        */
+      void
+      resize (size_t max_size);
+
+      /** \brief Remove all the pairs from the cache, keeping its capacity. */
+      void
+      clear ();
+
+      /** \brief Get the maximum number of pairs of the cache. */
+      inline size_t
+      getMaximumSize () const
+      {
+        return (keys_.size ());
+      }
+
+      /** \brief Remove the pairs involving some points from the cache. Not thread safe.
+        * \param[in] changed a flag for each point index, true for the points whose pairs have to be removed
+        */
+      void
+      erase (const std::vector<char> &changed);
+
+      /** \brief Compute the features of a point pair, or get them from the cache. Thread safe.
+        * \param[in] cloud the dataset containing the XYZ Cartesian coordinates of the two points
+        * \param[in] normals the dataset containing the surface normals at each point in \a cloud
+        * \param[in] p_idx the index of the first point (source)
+        * \param[in] q_idx the index of the second point (target)
+        * \param[out] features the pair features (f1, f2, f3, f4), see computePairFeatures
+        * \return false if the features could not be computed (they are set to 0 then)
+        */
+      template <typename PointInT, typename PointNT> inline bool
+      computePairFeatures (const pcl::PointCloud<PointInT> &cloud, const pcl::PointCloud<PointNT> &normals,
+                           int p_idx, int q_idx, Eigen::Vector4f &features)
+      {
+        const Eigen::Vector4f &p1 = cloud.points[p_idx].getVector4fMap (), &n1 = normals.points[p_idx].getNormalVector4fMap ();
+        const Eigen::Vector4f &p2 = cloud.points[q_idx].getVector4fMap (), &n2 = normals.points[q_idx].getNormalVector4fMap ();
+        return (computePairFeatures (p1, n1, p2, n2, p_idx, q_idx, features));
+      }
+
+    protected:
+      /** \brief Compute the features of a point pair given by its coordinates and normals, or get them from the
+        * cache. The indices of the points form the key of the pair.
+        */
+      bool
+      computePairFeatures (const Eigen::Vector4f &p1, const Eigen::Vector4f &n1,
+                           const Eigen::Vector4f &p2, const Eigen::Vector4f &n2,
+                           int p_idx, int q_idx, Eigen::Vector4f &features);
+
+      /** \brief Look up the features of a pair. */
+      bool
+      find (uint64_t key, Eigen::Vector4f &features) const;
+
+      /** \brief Store the features of a pair, unless the probed slots are all used. */
+      void
+      insert (uint64_t key, const Eigen::Vector4f &features);
+
+      /** \brief The slot of a key, before probing. */
+      inline size_t
+      getSlot (uint64_t key) const
+      {
+        return (static_cast<size_t> ((key * 0x9E3779B97F4A7C15ull) >> 32) & mask_);
+      }
+
+      /** \brief The keys of the pairs, written last when a pair is stored. */
+      std::vector<uint64_t> keys_;
+
+      /** \brief The features of the pairs, 4 floats per slot. */
+      std::vector<float> features_;
+
+      /** \brief The number of slots minus one. */
+      size_t mask_;
+  };
+
+  /** \brief FeatureNeighborhoods stores the neighborhoods of the points of a cloud, so that they are searched once
+    * (in parallel) and shared by the stages of a feature estimation. After a local change of the cloud, only the
+    * neighborhoods affected by the change have to be searched again.
+    *
+    * \ingroup features
+    */
+  template <typename PointT>
+  class FeatureNeighborhoods
+  {
+    public:
+      typedef boost::function<int (const pcl::PointCloud<PointT> &, size_t, double, std::vector<int> &, std::vector<float> &)> SearchMethod;
+
+      /** \brief Empty constructor. */
+      FeatureNeighborhoods () : indices_ (), sqr_distances_ (), searched_ () {}
+
+      /** \brief Forget all the neighborhoods.
+        * \param[in] nr_points the number of points of the cloud
+        */
+      inline void
+      reset (size_t nr_points)
+      {
+        indices_.assign (nr_points, std::vector<int> ());
+        sqr_distances_.assign (nr_points, std::vector<float> ());
+        searched_.assign (nr_points, 0);
+      }
+
+      /** \brief Get the number of points of the cloud. */
+      inline size_t
+      size () const
+      {
+        return (searched_.size ());
+      }
+
+      /** \brief Get whether the neighborhood of a point has been searched. */
+      inline bool
+      isSearched (int index) const
+      {
+        return (searched_[index] != 0);
+      }
+
+      /** \brief Get the indices of the neighbors of a point, empty if none were found. */
+      inline const std::vector<int>&
+      getIndices (int index) const
+      {
+        return (indices_[index]);
+      }
+
+      /** \brief Get the squared distances to the neighbors of a point. */
+      inline const std::vector<float>&
+      getSqrDistances (int index) const
+      {
+        return (sqr_distances_[index]);
+      }
+
+      /** \brief Search the neighborhoods of a set of points in parallel. Points with non finite coordinates get
+        * an empty neighborhood.
+        * \param[in] search_method the search function (see Feature::searchForNeighbors)
+        * \param[in] cloud the cloud of the points
+        * \param[in] points the indices of the points, without duplicates
+        * \param[in] parameter the search parameter (radius or number of neighbors)
+        * \param[in] nr_threads the number of threads to use (0 for automatic)
+        */
+      void
+      search (const SearchMethod &search_method, const pcl::PointCloud<PointT> &cloud,
+              const std::vector<int> &points, double parameter, unsigned int nr_threads)
+      {
+#pragma omp parallel for schedule (dynamic, 64) num_threads (nr_threads)
+        for (int i = 0; i < static_cast<int> (points.size ()); ++i)
+        {
+          const int p = points[i];
+          if (!isFinite (cloud.points[p]) || search_method (cloud, p, parameter, indices_[p], sqr_distances_[p]) == 0)
+          {
+            indices_[p].clear ();
+            sqr_distances_[p].clear ();
+          }
+          searched_[p] = 1;
+        }
+      }
+
+      /** \brief Flag the points whose neighborhood contains one of the given points.
+        * \param[in] points a flag for each point index, true for the points to look for
+        * \param[out] containing set to true for the points whose neighborhood contains one of \a points
+        * \param[in] nr_threads the number of threads to use (0 for automatic)
+        */
+      void
+      findContaining (const std::vector<char> &points, std::vector<char> &containing, unsigned int nr_threads) const
+      {
+#pragma omp parallel for schedule (dynamic, 256) num_threads (nr_threads)
+        for (int p = 0; p < static_cast<int> (indices_.size ()); ++p)
+          for (size_t j = 0; j < indices_[p].size (); ++j)
+            if (points[indices_[p][j]])
+            {
+              containing[p] = 1;
+              break;
+            }
+      }
+
+      /** \brief Get the largest squared distance between a point and one of its neighbors. */
+      float
+      getMaxSqrDistance () const
+      {
+        float max_sqr_distance = 0.0f;
+        for (size_t p = 0; p < sqr_distances_.size (); ++p)
+          for (size_t j = 0; j < sqr_distances_[p].size (); ++j)
+            max_sqr_distance = (std::max) (max_sqr_distance, sqr_distances_[p][j]);
+        return (max_sqr_distance);
+      }
+
+    protected:
+      /** \brief The indices of the neighbors of each point. */
+      std::vector<std::vector<int> > indices_;
+
+      /** \brief The squared distances to the neighbors of each point. */
+      std::vector<std::vector<float> > sqr_distances_;
+
+      /** \brief Whether the neighborhood of each point has been searched. */
+      std::vector<char> searched_;
+  };
+}
+
+#endif  //#ifndef PCL_FEATURES_PAIR_FEATURE_CACHE_H_
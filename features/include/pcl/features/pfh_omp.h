@@ -0,0 +1,166 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_PFH_OMP_H_
+#define PCL_PFH_OMP_H_
+
+#include <pcl/features/feature.h>
+#include <pcl/features/pfh.h>
+#include <pcl/features/pair_feature_cache.h>
+
+namespace pcl
+{
+  /** \brief PFHEstimationOMP estimates the Point Feature Histogram (PFH) descriptor for a given point cloud dataset
+    * containing points and normals, in parallel, using the OpenMP standard.
+    *
+    * The neighborhoods of the query points are searched once, in parallel, and the pair features are shared
+    * between the overlapping neighborhoods through a PairFeatureCache, so each pair is computed once per call
+    * (within the cache capacity). The descriptors are the same as the ones given by PFHEstimation. After a call
+    * to compute (), computeChanged () updates the descriptors affected by a change of some points of the cloud.
+    *
+    * \note If you use this code in any academic work, please cite:
+    *
+    *   - R.B. Rusu, N. Blodow, Z.C. Marton, M. Beetz.
+    *     Aligning Point Cloud Views using Persistent Feature Histograms.
+    *     In Proceedings of the 21st IEEE/RSJ International Conference on Intelligent Robots and Systems (IROS),
+    *     Nice, France, September 22-26 2008.
+    *
+    * \ingroup features
+    */
+  template <typename PointInT, typename PointNT, typename PointOutT = pcl::PFHSignature125>
+  class PFHEstimationOMP : public PFHEstimation<PointInT, PointNT, PointOutT>
+  {
+    public:
+      using Feature<PointInT, PointOutT>::feature_name_;
+      using Feature<PointInT, PointOutT>::getClassName;
+      using Feature<PointInT, PointOutT>::indices_;
+      using Feature<PointInT, PointOutT>::k_;
+      using Feature<PointInT, PointOutT>::search_parameter_;
+      using Feature<PointInT, PointOutT>::input_;
+      using Feature<PointInT, PointOutT>::surface_;
+      using Feature<PointInT, PointOutT>::tree_;
+      using Feature<PointInT, PointOutT>::search_method_surface_;
+      using FeatureFromNormals<PointInT, PointNT, PointOutT>::normals_;
+      using FeatureFromNormals<PointInT, PointNT, PointOutT>::initCompute;
+      using Feature<PointInT, PointOutT>::deinitCompute;
+      using PFHEstimation<PointInT, PointNT, PointOutT>::nr_subdiv_;
+      using PFHEstimation<PointInT, PointNT, PointOutT>::d_pi_;
+      using PFHEstimation<PointInT, PointNT, PointOutT>::max_cache_size_;
+      using PFHEstimation<PointInT, PointNT, PointOutT>::use_cache_;
+
+      typedef typename Feature<PointInT, PointOutT>::PointCloudOut PointCloudOut;
+
+      /** \brief Initialize the scheduler and set the number of threads to use. The internal cache is enabled.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      PFHEstimationOMP (unsigned int nr_threads = 0) : threads_ (nr_threads),
+        pair_cache_ (), neighborhoods_ (), previous_indices_ (), previous_search_parameter_ (0)
+      {
+        use_cache_ = true;
+        feature_name_ = "PFHEstimationOMP";
+      }
+
+      /** \brief Initialize the scheduler and set the number of threads to use.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      inline void 
+      setNumberOfThreads (unsigned int nr_threads = 0) { threads_ = nr_threads; }
+
+      /** \brief Update the descriptors computed by the last call to compute () or computeChanged () after some
+        * points of the input cloud moved, or got a different normal. Only the neighborhoods and descriptors
+        * affected by these points are computed again.
+        *
+        * The input cloud, normals and indices have to be the same objects (with the same sizes) as in the last call.
+        * Otherwise, and when a search surface different from the input is set, all the descriptors are computed.
+        * \param[in] changed_indices the indices in the input cloud of the points that changed
+        * \param[in,out] output the descriptors given by the last call, updated
+        */
+      void
+      computeChanged (const std::vector<int> &changed_indices, PointCloudOut &output);
+
+    private:
+      /** \brief Estimate the Point Feature Histograms (PFH) descriptors at a set of points given by
+        * <setInputCloud (), setIndices ()> using the surface in setSearchSurface () and the spatial locator in
+        * setSearchMethod ()
+        * \param[out] output the resultant point cloud model dataset that contains the PFH feature estimates
+        */
+      void 
+      computeFeature (PointCloudOut &output);
+
+      /** \brief Compute the PFH signatures of a set of query points in parallel, from their neighborhoods.
+        * \param[in] positions the positions of the query points in the indices
+        * \param[out] output the output point cloud
+        */
+      void
+      computePFHSignatures (const std::vector<int> &positions, PointCloudOut &output);
+
+      /** \brief Estimate the PFH signature of a neighborhood as computePointPFHSignature does, with the pair
+        * features taken from the cache. Thread safe.
+        * \param[in] indices the k-neighborhood point indices in the search surface
+        * \param[out] pfh_histogram the resultant PFH histogram
+        */
+      void
+      computeCachedPFHSignature (const std::vector<int> &indices, Eigen::VectorXf &pfh_histogram);
+
+      /** \brief Get the query points without duplicates. */
+      void
+      getUniqueQueries (std::vector<int> &queries) const;
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
+
+      /** \brief The pair features shared between the neighborhoods. */
+      PairFeatureCache pair_cache_;
+
+      /** \brief The neighborhoods of the query points. */
+      FeatureNeighborhoods<PointInT> neighborhoods_;
+
+      /** \brief The indices used by the last call, to check that the descriptors can be updated. */
+      std::vector<int> previous_indices_;
+
+      /** \brief The search parameter used by the last call, to check that the descriptors can be updated. */
+      double previous_search_parameter_;
+
+      /** \brief Make the computeFeature (&Eigen::MatrixXf); inaccessible from outside the class
+        * \param[out] output the output point cloud 
+        */
+      void 
+      computeFeatureEigen (pcl::PointCloud<Eigen::MatrixXf> &) {}
+  };
+}
+
+#endif  //#ifndef PCL_PFH_OMP_H_
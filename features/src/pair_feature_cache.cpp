@@ -0,0 +1,204 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <pcl/features/pair_feature_cache.h>
+#include <pcl/features/pfh.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+  /** \brief Key of the slots never used. */
+  const uint64_t EMPTY_KEY = ~0ull;
+
+  /** \brief Key of the slots being written by a thread. */
+  const uint64_t BUSY_KEY = ~0ull - 1;
+
+  /** \brief Number of slots probed before giving up on a pair. */
+  const int MAX_PROBES = 16;
+
+  /** \brief Replace *value by new_value if it is equal to old_value, atomically. */
+  inline bool
+  compareAndSwap (volatile uint64_t *value, uint64_t old_value, uint64_t new_value)
+  {
+#ifdef _MSC_VER
+    return (static_cast<uint64_t> (_InterlockedCompareExchange64 (reinterpret_cast<volatile __int64*> (value), new_value, old_value)) == old_value);
+#else
+    return (__sync_bool_compare_and_swap (value, old_value, new_value));
+#endif
+  }
+
+  /** \brief Order the memory accesses on both sides of the call. */
+  inline void
+  memoryBarrier ()
+  {
+#ifdef _MSC_VER
+    _mm_mfence ();
+#else
+    __sync_synchronize ();
+#endif
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::PairFeatureCache::resize (size_t max_size)
+{
+  if (max_size == 0)
+  {
+    keys_.clear ();
+    features_.clear ();
+    mask_ = 0;
+    return;
+  }
+  // the capacity is a bound on the memory used, so the slot count never exceeds it
+  size_t nr_slots = 1;
+  while (nr_slots <= max_size / 2)
+    nr_slots *= 2;
+  keys_.assign (nr_slots, EMPTY_KEY);
+  features_.assign (4 * nr_slots, 0.0f);
+  mask_ = nr_slots - 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::PairFeatureCache::clear ()
+{
+  std::fill (keys_.begin (), keys_.end (), EMPTY_KEY);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::PairFeatureCache::erase (const std::vector<char> &changed)
+{
+  // Open addressing does not allow removing entries in place, so the remaining pairs are inserted again
+  std::vector<uint64_t> kept_keys;
+  std::vector<float> kept_features;
+  for (size_t slot = 0; slot < keys_.size (); ++slot)
+  {
+    const uint64_t key = keys_[slot];
+    if (key == EMPTY_KEY || key == BUSY_KEY)
+      continue;
+    const size_t p_idx = static_cast<size_t> (key >> 32), q_idx = static_cast<size_t> (key & 0xFFFFFFFFull);
+    if ((p_idx < changed.size () && changed[p_idx]) || (q_idx < changed.size () && changed[q_idx]))
+      continue;
+    kept_keys.push_back (key);
+    kept_features.insert (kept_features.end (), features_.begin () + 4 * slot, features_.begin () + 4 * slot + 4);
+  }
+
+  clear ();
+  for (size_t i = 0; i < kept_keys.size (); ++i)
+    insert (kept_keys[i], Eigen::Vector4f::Map (&kept_features[4 * i]));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl::PairFeatureCache::computePairFeatures (const Eigen::Vector4f &p1, const Eigen::Vector4f &n1,
+                                            const Eigen::Vector4f &p2, const Eigen::Vector4f &n2,
+                                            int p_idx, int q_idx, Eigen::Vector4f &features)
+{
+  const uint64_t key = p_idx < q_idx ? (static_cast<uint64_t> (p_idx) << 32) | static_cast<uint32_t> (q_idx)
+                                     : (static_cast<uint64_t> (q_idx) << 32) | static_cast<uint32_t> (p_idx);
+  // The distance feature is 0 if and only if the features could not be computed
+  if (!keys_.empty () && find (key, features))
+    return (features[3] != 0.0f);
+
+  const bool valid = pcl::computePairFeatures (p1, n1, p2, n2, features[0], features[1], features[2], features[3]);
+  if (keys_.empty ())
+    return (valid);
+
+  // computePairFeatures takes as source the point whose normal is the closest to the line joining the points, so
+  // the features of the reversed pair are the same unless both normals make the same angle with that line
+  Eigen::Vector4f dp2p1 = p2 - p1;
+  dp2p1[3] = 0.0f;
+  const float f4 = dp2p1.norm ();
+  if (f4 != 0.0f)
+  {
+    Eigen::Vector4f n1_copy = n1, n2_copy = n2;
+    n1_copy[3] = n2_copy[3] = 0.0f;
+    if (acos (fabs (n1_copy.dot (dp2p1) / f4)) == acos (fabs (n2_copy.dot (dp2p1) / f4)))
+      return (valid);
+  }
+  insert (key, features);
+  return (valid);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl::PairFeatureCache::find (uint64_t key, Eigen::Vector4f &features) const
+{
+  const volatile uint64_t *keys = &keys_[0];
+  size_t slot = getSlot (key);
+  for (int probe = 0; probe < MAX_PROBES; ++probe, slot = (slot + 1) & mask_)
+  {
+    const uint64_t slot_key = keys[slot];
+    if (slot_key == key)
+    {
+      // the features were written before the key
+      memoryBarrier ();
+      features = Eigen::Vector4f::Map (&features_[4 * slot]);
+      return (true);
+    }
+    if (slot_key == EMPTY_KEY)
+      return (false);
+  }
+  return (false);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::PairFeatureCache::insert (uint64_t key, const Eigen::Vector4f &features)
+{
+  volatile uint64_t *keys = &keys_[0];
+  size_t slot = getSlot (key);
+  for (int probe = 0; probe < MAX_PROBES; ++probe, slot = (slot + 1) & mask_)
+  {
+    const uint64_t slot_key = keys[slot];
+    if (slot_key == key)
+      return;
+    if (slot_key == EMPTY_KEY && compareAndSwap (keys + slot, EMPTY_KEY, BUSY_KEY))
+    {
+      Eigen::Vector4f::Map (&features_[4 * slot]) = features;
+      // publish the key once the features are visible to the other threads
+      memoryBarrier ();
+      keys[slot] = key;
+      return;
+    }
+  }
+}
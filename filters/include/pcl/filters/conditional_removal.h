@@ -72,6 +72,20 @@ namespace pcl
         */
       int
       compare (const PointT& p, const double& val);
+
+      /** \brief Get the type of data. */
+      inline uint8_t
+      getDatatype () const
+      {
+        return (datatype_);
+      }
+
+      /** \brief Get the data offset. */
+      inline uint32_t
+      getOffset () const
+      {
+        return (offset_);
+      }
     protected:
       /** \brief The type of data. */
       uint8_t datatype_;
@@ -104,6 +118,13 @@ namespace pcl
         return (capable_);
       }
 
+      /** \brief Get the comparison operator type. */
+      inline ComparisonOps::CompareOp
+      getCompareOp () const
+      {
+        return (op_);
+      }
+
       /** \brief Evaluate function. */
       virtual bool
       evaluate (const PointT &point) const = 0;
@@ -172,6 +193,20 @@ namespace pcl
       virtual bool
       evaluate (const PointT &point) const;
 
+      /** \brief Get the constant value the field is compared to. */
+      inline double
+      getCompareValue () const
+      {
+        return (compare_val_);
+      }
+
+      /** \brief Get the point data to compare (NULL if the field was not found). */
+      inline const PointDataAtOffset<PointT>*
+      getPointData () const
+      {
+        return (point_data_);
+      }
+
     protected:
       /** \brief All types (that we care about) can be represented as a double. */
       double compare_val_;
@@ -476,6 +511,20 @@ namespace pcl
         return (capable_);
       }
 
+      /** \brief Get the comparisons of this condition. */
+      inline const std::vector<ComparisonBaseConstPtr>&
+      getComparisons () const
+      {
+        return (comparisons_);
+      }
+
+      /** \brief Get the nested conditions of this condition. */
+      inline const std::vector<Ptr>&
+      getConditions () const
+      {
+        return (conditions_);
+      }
+
       /** \brief Determine if a point meets this condition.  
         * \return whether the point meets this condition.
         */
@@ -549,6 +598,134 @@ namespace pcl
       evaluate (const PointT &point) const;
   };
 
+  //////////////////////////////////////////////////////////////////////////////////////////
+  /** \brief A condition tree flattened into an array of nodes, evaluated on blocks of points.
+    *
+    * The nodes are stored in pre-order, each one with the index past its subtree, so that the
+    * tree is walked without following shared pointers. A FieldComparison leaf gathers its field
+    * for the whole block in the field datatype and compares it to the threshold in a tight loop.
+    * ConditionAnd/ConditionOr nodes combine the results of their children and skip the remaining
+    * children as soon as the whole block is decided. Any other comparison or condition is
+    * evaluated point by point through its evaluate method, only on the points that are not
+    * decided yet.
+    *
+    * The results are the same as the ones of ConditionBase::evaluate, including for NaN fields.
+    * A CompiledCondition holds shared pointers to the comparisons it could not flatten, it does
+    * not follow later changes of the condition it was compiled from.
+    *
+    * \ingroup filters
+    */
+  template<typename PointT>
+  class CompiledCondition
+  {
+    public:
+      typedef typename pcl::ConditionBase<PointT> ConditionBase;
+      typedef typename ConditionBase::ConstPtr ConditionBaseConstPtr;
+      typedef typename pcl::ComparisonBase<PointT> ComparisonBase;
+      typedef typename ComparisonBase::ConstPtr ComparisonBaseConstPtr;
+
+      /** \brief Number of points evaluated at once. */
+      enum { BLOCK_SIZE = 256 };
+
+      /** \brief Empty constructor. */
+      CompiledCondition () : nodes_ ()
+      {
+      }
+
+      /** \brief Constructor that compiles a condition.
+        * \param[in] condition the condition to compile
+        */
+      CompiledCondition (const ConditionBaseConstPtr &condition) : nodes_ ()
+      {
+        compile (condition);
+      }
+
+      /** \brief Flatten a condition tree, replacing the previously compiled one.
+        * \param[in] condition the condition to compile
+        */
+      void
+      compile (const ConditionBaseConstPtr &condition);
+
+      /** \brief Evaluate the condition on a range of points.
+        * \param[in] cloud the point cloud
+        * \param[in] indices the indices of the points in \a cloud, or NULL to address the points directly
+        * \param[in] first the position of the first point to evaluate (in \a indices if given, in \a cloud otherwise)
+        * \param[in] nr_points the number of points to evaluate
+        * \param[out] result 1 for every point meeting the condition, 0 otherwise (must hold \a nr_points values)
+        */
+      void
+      evaluate (const PointCloud<PointT> &cloud, const int *indices, int first, int nr_points, uint8_t *result) const;
+
+    protected:
+      /** \brief The kinds of nodes of a compiled condition. */
+      enum NodeType
+      {
+        NODE_AND, NODE_OR, NODE_FIELD, NODE_COMPARISON, NODE_CONDITION
+      };
+
+      /** \brief A node of a compiled condition. */
+      struct Node
+      {
+        /** \brief The kind of node. */
+        NodeType type;
+
+        /** \brief Index of the node following the subtree of this node. */
+        int end;
+
+        /** \brief Datatype, offset, operator and constant of a NODE_FIELD comparison. */
+        uint8_t datatype;
+        uint32_t offset;
+        ComparisonOps::CompareOp op;
+        double compare_val;
+
+        /** \brief The comparison of a NODE_COMPARISON leaf. */
+        ComparisonBaseConstPtr comparison;
+
+        /** \brief The condition of a NODE_CONDITION leaf. */
+        ConditionBaseConstPtr condition;
+      };
+
+      /** \brief Append the nodes of a condition and of its subtree.
+        * \param[in] condition the condition to append
+        */
+      void
+      compileCondition (const ConditionBaseConstPtr &condition);
+
+      /** \brief Append the node of a comparison.
+        * \param[in] comparison the comparison to append
+        */
+      void
+      compileComparison (const ComparisonBaseConstPtr &comparison);
+
+      /** \brief Evaluate a node on a block of at most BLOCK_SIZE points.
+        * \param[in] node the index of the node
+        * \param[in] cloud the point cloud
+        * \param[in] indices the indices of the points in \a cloud, or NULL
+        * \param[in] first the position of the first point of the block
+        * \param[in] nr_points the number of points of the block
+        * \param[in] active the points of the block whose result is still needed, or NULL for all of them
+        * \param[out] result the result for every active point of the block, undefined for the other ones
+        */
+      void
+      evaluateNode (int node, const PointCloud<PointT> &cloud, const int *indices, int first, int nr_points,
+                    const uint8_t *active, uint8_t *result) const;
+
+      /** \brief Compare a field of a block of points to a constant, in the datatype of the field.
+        * \param[in] node the NODE_FIELD node
+        * \param[in] cloud the point cloud
+        * \param[in] indices the indices of the points in \a cloud, or NULL
+        * \param[in] first the position of the first point of the block
+        * \param[in] nr_points the number of points of the block
+        * \param[out] result the result for every point of the block
+        */
+      template <typename T> void
+      compareField (const Node &node, const PointCloud<PointT> &cloud, const int *indices, int first, int nr_points,
+                    uint8_t *result) const;
+
+      /** \brief The nodes of the condition tree, in pre-order. */
+      std::vector<Node> nodes_;
+  };
+
   //////////////////////////////////////////////////////////////////////////////////////////
   /** \brief @b ConditionalRemoval filters data that satisfies certain conditions.
     *
@@ -577,6 +754,9 @@ namespace pcl
     *  range_filt.setCondition (range_cond);
     *  range_filt.setKeepOrganized (false);
     *
+    * The condition is flattened into a CompiledCondition when filtering, and evaluated
+    * on blocks of points in parallel.
+    *
     * \author Louis LeGrand, Intel Labs Seattle
     * \ingroup filters
     */
@@ -607,7 +787,7 @@ namespace pcl
         */
       ConditionalRemoval (int extract_removed_indices = false) :
         Filter<PointT>::Filter (extract_removed_indices), capable_ (false), keep_organized_ (false), condition_ (),
-        user_filter_value_ (std::numeric_limits<float>::quiet_NaN ())
+        user_filter_value_ (std::numeric_limits<float>::quiet_NaN ()), threads_ (0)
       {
         filter_name_ = "ConditionalRemoval";
       }
@@ -619,7 +799,7 @@ namespace pcl
         */
       ConditionalRemoval (ConditionBasePtr condition, bool extract_removed_indices = false) :
         Filter<PointT>::Filter (extract_removed_indices), capable_ (false), keep_organized_ (false), condition_ (),
-        user_filter_value_ (std::numeric_limits<float>::quiet_NaN ())
+        user_filter_value_ (std::numeric_limits<float>::quiet_NaN ()), threads_ (0)
       {
         filter_name_ = "ConditionalRemoval";
         setCondition (condition);
@@ -665,6 +845,15 @@ namespace pcl
       void
       setCondition (ConditionBasePtr condition);
 
+      /** \brief Set the number of threads used to evaluate the condition.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads = 0)
+      {
+        threads_ = nr_threads;
+      }
+
     protected:
       /** \brief Filter a Point Cloud.
         * \param output the resultant point cloud message
@@ -689,6 +878,9 @@ namespace pcl
         * the correct field type. 
         */
       float user_filter_value_;
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
   };
 }
 
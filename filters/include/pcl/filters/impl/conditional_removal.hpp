@@ -657,6 +657,272 @@ pcl::ConditionOr<PointT>::evaluate (const PointT &point) const
   return (false);
 }
 
+//////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::CompiledCondition<PointT>::compile (const ConditionBaseConstPtr &condition)
+{
+  nodes_.clear ();
+  if (condition)
+    compileCondition (condition);
+}
+
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::CompiledCondition<PointT>::compileCondition (const ConditionBaseConstPtr &condition)
+{
+  const int node = static_cast<int> (nodes_.size ());
+  nodes_.push_back (Node ());
+
+  if (dynamic_cast<const ConditionAnd<PointT>*> (condition.get ()))
+    nodes_[node].type = NODE_AND;
+  else if (dynamic_cast<const ConditionOr<PointT>*> (condition.get ()))
+    nodes_[node].type = NODE_OR;
+  else
+  {
+    // unknown condition, evaluated as a whole
+    nodes_[node].type = NODE_CONDITION;
+    nodes_[node].condition = condition;
+    nodes_[node].end = node + 1;
+    return;
+  }
+
+  // same order as ConditionAnd/ConditionOr::evaluate: comparisons first, then nested conditions
+  for (size_t i = 0; i < condition->getComparisons ().size (); ++i)
+    compileComparison (condition->getComparisons ()[i]);
+  for (size_t i = 0; i < condition->getConditions ().size (); ++i)
+    compileCondition (condition->getConditions ()[i]);
+
+  nodes_[node].end = static_cast<int> (nodes_.size ());
+}
+
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::CompiledCondition<PointT>::compileComparison (const ComparisonBaseConstPtr &comparison)
+{
+  Node node;
+  node.end = static_cast<int> (nodes_.size ()) + 1;
+
+  const FieldComparison<PointT>* field_comparison = dynamic_cast<const FieldComparison<PointT>*> (comparison.get ());
+  if (field_comparison && field_comparison->isCapable () && field_comparison->getPointData ())
+  {
+    node.datatype = field_comparison->getPointData ()->getDatatype ();
+    node.offset = field_comparison->getPointData ()->getOffset ();
+    node.op = field_comparison->getCompareOp ();
+    node.compare_val = field_comparison->getCompareValue ();
+
+    switch (node.datatype)
+    {
+      case sensor_msgs::PointField::INT8 :
+      case sensor_msgs::PointField::UINT8 :
+      case sensor_msgs::PointField::INT16 :
+      case sensor_msgs::PointField::UINT16 :
+      case sensor_msgs::PointField::INT32 :
+      case sensor_msgs::PointField::UINT32 :
+      case sensor_msgs::PointField::FLOAT32 :
+      case sensor_msgs::PointField::FLOAT64 :
+      {
+        if (node.op == ComparisonOps::GT || node.op == ComparisonOps::GE || node.op == ComparisonOps::LT ||
+            node.op == ComparisonOps::LE || node.op == ComparisonOps::EQ)
+        {
+          node.type = NODE_FIELD;
+          nodes_.push_back (node);
+          return;
+        }
+        break;
+      }
+      default:
+        break;
+    }
+  }
+
+  // anything else (including the error cases of FieldComparison) is evaluated point by point
+  node.type = NODE_COMPARISON;
+  node.comparison = comparison;
+  nodes_.push_back (node);
+}
+
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::CompiledCondition<PointT>::evaluate (const PointCloud<PointT> &cloud, const int *indices, int first, int nr_points,
+                                          uint8_t *result) const
+{
+  for (int block = 0; block < nr_points; block += BLOCK_SIZE)
+  {
+    const int block_size = std::min (nr_points - block, static_cast<int> (BLOCK_SIZE));
+
+    // an empty condition lets every point through
+    if (nodes_.empty ())
+      std::fill (result + block, result + block + block_size, static_cast<uint8_t> (1));
+    else
+      evaluateNode (0, cloud, indices, first + block, block_size, NULL, result + block);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::CompiledCondition<PointT>::evaluateNode (int node, const PointCloud<PointT> &cloud, const int *indices,
+                                              int first, int nr_points, const uint8_t *active, uint8_t *result) const
+{
+  const Node &current = nodes_[node];
+
+  switch (current.type)
+  {
+    case NODE_FIELD:
+    {
+      switch (current.datatype)
+      {
+        case sensor_msgs::PointField::INT8 :
+          compareField<int8_t> (current, cloud, indices, first, nr_points, result);
+          break;
+        case sensor_msgs::PointField::UINT8 :
+          compareField<uint8_t> (current, cloud, indices, first, nr_points, result);
+          break;
+        case sensor_msgs::PointField::INT16 :
+          compareField<int16_t> (current, cloud, indices, first, nr_points, result);
+          break;
+        case sensor_msgs::PointField::UINT16 :
+          compareField<uint16_t> (current, cloud, indices, first, nr_points, result);
+          break;
+        case sensor_msgs::PointField::INT32 :
+          compareField<int32_t> (current, cloud, indices, first, nr_points, result);
+          break;
+        case sensor_msgs::PointField::UINT32 :
+          compareField<uint32_t> (current, cloud, indices, first, nr_points, result);
+          break;
+        case sensor_msgs::PointField::FLOAT32 :
+          compareField<float> (current, cloud, indices, first, nr_points, result);
+          break;
+        default :
+          compareField<double> (current, cloud, indices, first, nr_points, result);
+          break;
+      }
+      break;
+    }
+    case NODE_COMPARISON:
+    {
+      for (int i = 0; i < nr_points; ++i)
+        result[i] = (!active || active[i]) && current.comparison->evaluate (cloud.points[indices ? indices[first + i] : first + i]);
+      break;
+    }
+    case NODE_CONDITION:
+    {
+      for (int i = 0; i < nr_points; ++i)
+        result[i] = (!active || active[i]) && current.condition->evaluate (cloud.points[indices ? indices[first + i] : first + i]);
+      break;
+    }
+    case NODE_AND:
+    {
+      // the points rejected by a child are not active for the next ones
+      if (active)
+        std::copy (active, active + nr_points, result);
+      else
+        std::fill (result, result + nr_points, static_cast<uint8_t> (1));
+
+      uint8_t child_result[BLOCK_SIZE];
+      for (int child = node + 1; child < current.end; child = nodes_[child].end)
+      {
+        evaluateNode (child, cloud, indices, first, nr_points, result, child_result);
+
+        uint8_t any_true = 0;
+        for (int i = 0; i < nr_points; ++i)
+        {
+          result[i] &= child_result[i];
+          any_true |= result[i];
+        }
+        // the whole block is already rejected
+        if (!any_true)
+          break;
+      }
+      break;
+    }
+    case NODE_OR:
+    {
+      // an empty ConditionOr evaluates to true
+      if (node + 1 == current.end)
+      {
+        std::fill (result, result + nr_points, static_cast<uint8_t> (1));
+        break;
+      }
+
+      std::fill (result, result + nr_points, static_cast<uint8_t> (0));
+
+      // the points accepted by a child are not active for the next ones
+      uint8_t pending[BLOCK_SIZE];
+      if (active)
+        std::copy (active, active + nr_points, pending);
+      else
+        std::fill (pending, pending + nr_points, static_cast<uint8_t> (1));
+
+      uint8_t child_result[BLOCK_SIZE];
+      for (int child = node + 1; child < current.end; child = nodes_[child].end)
+      {
+        evaluateNode (child, cloud, indices, first, nr_points, pending, child_result);
+
+        uint8_t any_pending = 0;
+        for (int i = 0; i < nr_points; ++i)
+        {
+          const uint8_t accepted = child_result[i] & pending[i];
+          result[i] |= accepted;
+          pending[i] &= static_cast<uint8_t> (!accepted);
+          any_pending |= pending[i];
+        }
+        // the whole block is already decided
+        if (!any_pending)
+          break;
+      }
+      break;
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> template <typename T> void
+pcl::CompiledCondition<PointT>::compareField (const Node &node, const PointCloud<PointT> &cloud, const int *indices,
+                                              int first, int nr_points, uint8_t *result) const
+{
+  // gather the field of the block as a column
+  T column[BLOCK_SIZE];
+  if (indices)
+  {
+    for (int i = 0; i < nr_points; ++i)
+      memcpy (&column[i], reinterpret_cast<const uint8_t*> (&cloud.points[indices[first + i]]) + node.offset, sizeof (T));
+  }
+  else
+  {
+    for (int i = 0; i < nr_points; ++i)
+      memcpy (&column[i], reinterpret_cast<const uint8_t*> (&cloud.points[first + i]) + node.offset, sizeof (T));
+  }
+
+  // same conversion of the constant as PointDataAtOffset::compare, and the same outcome for NaN
+  // fields, which compare neither greater nor lower than the constant
+  const T val = static_cast<T> (node.compare_val);
+  switch (node.op)
+  {
+    case ComparisonOps::GT :
+      for (int i = 0; i < nr_points; ++i)
+        result[i] = column[i] > val;
+      break;
+    case ComparisonOps::GE :
+      for (int i = 0; i < nr_points; ++i)
+        result[i] = !(column[i] < val);
+      break;
+    case ComparisonOps::LT :
+      for (int i = 0; i < nr_points; ++i)
+        result[i] = column[i] < val;
+      break;
+    case ComparisonOps::LE :
+      for (int i = 0; i < nr_points; ++i)
+        result[i] = !(column[i] > val);
+      break;
+    default :
+      for (int i = 0; i < nr_points; ++i)
+        result[i] = !(column[i] < val) & !(column[i] > val);
+      break;
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
@@ -708,6 +974,30 @@ pcl::ConditionalRemoval<PointT>::applyFilter (PointCloud &output)
   int nr_p = 0;
   int nr_removed_p = 0;
 
+  // The organized output is filled by walking the indices in order
+  std::vector<int> sorted_indices;
+  if (keep_organized_)
+  {
+    sorted_indices = *Filter<PointT>::indices_;
+    std::sort (sorted_indices.begin (), sorted_indices.end ());   //TODO: is this necessary or can we assume the indices to be sorted?
+  }
+  const std::vector<int> &condition_indices = keep_organized_ ? sorted_indices : *Filter<PointT>::indices_;
+
+  // Evaluate the condition on blocks of points, in parallel
+  const CompiledCondition<PointT> condition (condition_);
+  const int nr_points = static_cast<int> (condition_indices.size ());
+  const int nr_blocks = (nr_points + CompiledCondition<PointT>::BLOCK_SIZE - 1) / CompiledCondition<PointT>::BLOCK_SIZE;
+  std::vector<uint8_t> passed (nr_points);
+
+#pragma omp parallel for schedule (dynamic, 16) num_threads (threads_)
+  for (int block = 0; block < nr_blocks; ++block)
+  {
+    const int first = block * CompiledCondition<PointT>::BLOCK_SIZE;
+    condition.evaluate (*input_, &condition_indices[0], first,
+                        std::min (nr_points - first, static_cast<int> (CompiledCondition<PointT>::BLOCK_SIZE)),
+                        &passed[first]);
+  }
+
   if (!keep_organized_)
   {
     for (size_t cp = 0; cp < Filter<PointT>::indices_->size (); ++cp)
@@ -725,12 +1015,9 @@ pcl::ConditionalRemoval<PointT>::applyFilter (PointCloud &output)
         continue;
       }
 
-      if (condition_->evaluate (input_->points[(*Filter < PointT > ::indices_)[cp]]))
+      if (passed[cp])
       {
-        pcl::for_each_type<FieldList> (
-                                       pcl::NdConcatenateFunctor<PointT, PointT> (
-                                                                                  input_->points[(*Filter < PointT > ::indices_)[cp]],
-                                                                                  output.points[nr_p]));
+        output.points[nr_p] = input_->points[(*Filter < PointT > ::indices_)[cp]];
         nr_p++;
       }
       else
@@ -748,8 +1035,7 @@ pcl::ConditionalRemoval<PointT>::applyFilter (PointCloud &output)
   }
   else
   {
-    std::vector<int> indices = *Filter<PointT>::indices_;
-    std::sort (indices.begin (), indices.end ());   //TODO: is this necessary or can we assume the indices to be sorted?
+    const std::vector<int> &indices = sorted_indices;
     bool removed_p = false;
     size_t ci = 0;
     for (size_t cp = 0; cp < input_->points.size (); ++cp)
@@ -764,9 +1050,8 @@ pcl::ConditionalRemoval<PointT>::applyFilter (PointCloud &output)
         }
 
         // copy all the fields
-        pcl::for_each_type<FieldList> (pcl::NdConcatenateFunctor<PointT, PointT> (input_->points[cp],
-                                                                                  output.points[cp]));
-        if (!condition_->evaluate (input_->points[cp]))
+        output.points[cp] = input_->points[cp];
+        if (!passed[ci - 1])
         {
           output.points[cp].getVector4fMap ().setConstant (user_filter_value_);
           removed_p = true;
@@ -801,6 +1086,7 @@ pcl::ConditionalRemoval<PointT>::applyFilter (PointCloud &output)
 #define PCL_INSTANTIATE_ConditionBase(T) template class PCL_EXPORTS pcl::ConditionBase<T>;
 #define PCL_INSTANTIATE_ConditionAnd(T) template class PCL_EXPORTS pcl::ConditionAnd<T>;
 #define PCL_INSTANTIATE_ConditionOr(T) template class PCL_EXPORTS pcl::ConditionOr<T>;
+#define PCL_INSTANTIATE_CompiledCondition(T) template class PCL_EXPORTS pcl::CompiledCondition<T>;
 #define PCL_INSTANTIATE_ConditionalRemoval(T) template class PCL_EXPORTS pcl::ConditionalRemoval<T>;
 
 #endif 
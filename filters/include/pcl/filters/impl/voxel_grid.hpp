@@ -40,6 +40,7 @@
 
 #include <pcl/common/common.h>
 #include <pcl/filters/voxel_grid.h>
+#include <limits>
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
@@ -167,6 +168,19 @@ pcl::VoxelGrid<PointT>::applyFilter (PointCloud &output)
   // Set up the division multiplier
   divb_mul_ = Eigen::Vector4i (1, div_b_[0], div_b_[0] * div_b_[1], 0);
 
+  // Voxels are addressed with 64 bit indices, the grid only needs to fit in them
+  const double nr_divisions = static_cast<double> (div_b_[0]) * static_cast<double> (div_b_[1]) * static_cast<double> (div_b_[2]);
+  if (nr_divisions >= 18446744073709551615.0)
+  {
+    PCL_WARN ("[pcl::%s::applyFilter] Leaf size is too small for the input dataset, the number of voxels overflows a 64 bit index.\n", getClassName ().c_str ());
+    output.width = output.height = 0;
+    output.points.clear ();
+    return;
+  }
+  const uint64_t divb_mul_y = static_cast<uint64_t> (div_b_[0]);
+  const uint64_t divb_mul_z = static_cast<uint64_t> (div_b_[0]) * static_cast<uint64_t> (div_b_[1]);
+  const uint64_t nr_voxels = divb_mul_z * static_cast<uint64_t> (div_b_[2]);
+
   int centroid_size = 4;
   if (downsample_all_data_)
     centroid_size = boost::mpl::size<FieldList>::value;
@@ -183,34 +197,42 @@ pcl::VoxelGrid<PointT>::applyFilter (PointCloud &output)
     centroid_size += 3;
   }
 
-  std::vector<cloud_point_index_idx> index_vector;
-  index_vector.reserve(input_->points.size());
-
   // If we don't want to process the entire cloud, but rather filter points far away from the viewpoint first...
+  int distance_idx = -1;
+  std::vector<sensor_msgs::PointField> distance_fields;
   if (!filter_field_name_.empty ())
   {
     // Get the distance field index
-    std::vector<sensor_msgs::PointField> fields;
-    int distance_idx = pcl::getFieldIndex (*input_, filter_field_name_, fields);
+    distance_idx = pcl::getFieldIndex (*input_, filter_field_name_, distance_fields);
     if (distance_idx == -1)
       PCL_WARN ("[pcl::%s::applyFilter] Invalid filter field name. Index is %d.\n", getClassName ().c_str (), distance_idx);
+  }
 
-    // First pass: go over all points and insert them into the index_vector vector
-    // with calculated idx. Points with the same idx value will contribute to the
-    // same point of resulting CloudPoint
-    for (unsigned int cp = 0; cp < static_cast<unsigned int> (input_->points.size ()); ++cp)
-    {
-      if (!input_->is_dense)
-        // Check if the point is invalid
-        if (!pcl_isfinite (input_->points[cp].x) || 
-            !pcl_isfinite (input_->points[cp].y) || 
-            !pcl_isfinite (input_->points[cp].z))
-          continue;
+  // First pass: go over all points and compute the index of their voxel. Points with the same index value will
+  // contribute to the same point of resulting CloudPoint. Rejected points get the index nr_voxels, past every
+  // valid voxel, so that the sort moves them to the end
+  const int nr_points = static_cast<int> (input_->points.size ());
+  std::vector<VoxelIndex> index_vector (nr_points);
+
+#pragma omp parallel for num_threads (threads_)
+  for (int cp = 0; cp < nr_points; ++cp)
+  {
+    index_vector[cp].idx = nr_voxels;
+    index_vector[cp].cloud_point_index = static_cast<unsigned int> (cp);
+
+    if (!input_->is_dense)
+      // Check if the point is invalid
+      if (!pcl_isfinite (input_->points[cp].x) ||
+          !pcl_isfinite (input_->points[cp].y) ||
+          !pcl_isfinite (input_->points[cp].z))
+        continue;
 
+    if (distance_idx >= 0)
+    {
       // Get the distance value
       const uint8_t* pt_data = reinterpret_cast<const uint8_t*> (&input_->points[cp]);
       float distance_value = 0;
-      memcpy (&distance_value, pt_data + fields[distance_idx].offset, sizeof (float));
+      memcpy (&distance_value, pt_data + distance_fields[distance_idx].offset, sizeof (float));
 
       if (filter_limit_negative_)
       {
@@ -224,69 +246,74 @@ pcl::VoxelGrid<PointT>::applyFilter (PointCloud &output)
         if ((distance_value > filter_limit_max_) || (distance_value < filter_limit_min_))
           continue;
       }
-      
-      int ijk0 = static_cast<int> (floor (input_->points[cp].x * inverse_leaf_size_[0]) - min_b_[0]);
-      int ijk1 = static_cast<int> (floor (input_->points[cp].y * inverse_leaf_size_[1]) - min_b_[1]);
-      int ijk2 = static_cast<int> (floor (input_->points[cp].z * inverse_leaf_size_[2]) - min_b_[2]);
-
-      // Compute the centroid leaf index
-      int idx = ijk0 * divb_mul_[0] + ijk1 * divb_mul_[1] + ijk2 * divb_mul_[2];
-      index_vector.push_back (cloud_point_index_idx (static_cast<unsigned int> (idx), cp));
     }
-  }
-  // No distance filtering, process all data
-  else
-  {
-    // First pass: go over all points and insert them into the index_vector vector
-    // with calculated idx. Points with the same idx value will contribute to the
-    // same point of resulting CloudPoint
-    for (unsigned int cp = 0; cp < static_cast<unsigned int> (input_->points.size ()); ++cp)
-    {
-      if (!input_->is_dense)
-        // Check if the point is invalid
-        if (!pcl_isfinite (input_->points[cp].x) || 
-            !pcl_isfinite (input_->points[cp].y) || 
-            !pcl_isfinite (input_->points[cp].z))
-          continue;
 
-      int ijk0 = static_cast<int> (floor (input_->points[cp].x * inverse_leaf_size_[0]) - min_b_[0]);
-      int ijk1 = static_cast<int> (floor (input_->points[cp].y * inverse_leaf_size_[1]) - min_b_[1]);
-      int ijk2 = static_cast<int> (floor (input_->points[cp].z * inverse_leaf_size_[2]) - min_b_[2]);
+    int ijk0 = static_cast<int> (floor (input_->points[cp].x * inverse_leaf_size_[0]) - min_b_[0]);
+    int ijk1 = static_cast<int> (floor (input_->points[cp].y * inverse_leaf_size_[1]) - min_b_[1]);
+    int ijk2 = static_cast<int> (floor (input_->points[cp].z * inverse_leaf_size_[2]) - min_b_[2]);
 
-      // Compute the centroid leaf index
-      int idx = ijk0 * divb_mul_[0] + ijk1 * divb_mul_[1] + ijk2 * divb_mul_[2];
-      index_vector.push_back (cloud_point_index_idx (static_cast<unsigned int> (idx), cp));
-    }
+    // Compute the centroid leaf index
+    index_vector[cp].idx = static_cast<uint64_t> (ijk0) + static_cast<uint64_t> (ijk1) * divb_mul_y + static_cast<uint64_t> (ijk2) * divb_mul_z;
   }
 
   // Second pass: sort the index_vector vector using value representing target cell as index
   // in effect all points belonging to the same output cell will be next to each other
-  std::sort (index_vector.begin (), index_vector.end (), std::less<cloud_point_index_idx> ());
+  unsigned int nr_bits = 1;
+  while (nr_bits < 64 && (nr_voxels >> nr_bits) != 0)
+    ++nr_bits;
+  sortVoxelIndices (index_vector, nr_bits);
+
+  // Drop the rejected points, sorted last
+  int nr_valid = nr_points;
+  while (nr_valid > 0 && index_vector[nr_valid - 1].idx == nr_voxels)
+    --nr_valid;
+  index_vector.resize (nr_valid);
+
+  // Third pass: find the first point of every output cell, chunk by chunk
+  const int nr_chunks = std::max (1, std::min (nr_valid / 65536, 64));
+  std::vector<int> chunk_offsets (nr_chunks + 1, 0);
+#pragma omp parallel for num_threads (threads_)
+  for (int c = 0; c < nr_chunks; ++c)
+  {
+    const int first = static_cast<int> (static_cast<long long> (nr_valid) * c / nr_chunks);
+    const int last = static_cast<int> (static_cast<long long> (nr_valid) * (c + 1) / nr_chunks);
+    for (int i = first; i < last; ++i)
+      if (i == 0 || index_vector[i].idx != index_vector[i - 1].idx)
+        ++chunk_offsets[c + 1];
+  }
+  for (int c = 0; c < nr_chunks; ++c)
+    chunk_offsets[c + 1] += chunk_offsets[c];
 
-  // Third pass: count output cells
-  // we need to skip all the same, adjacenent idx values
-  unsigned int total = 0;
-  unsigned int index = 0;
-  while (index < index_vector.size ()) 
+  const int total = chunk_offsets[nr_chunks];
+  std::vector<int> cell_begin (total + 1);
+#pragma omp parallel for num_threads (threads_)
+  for (int c = 0; c < nr_chunks; ++c)
   {
-    unsigned int i = index + 1;
-    while (i < index_vector.size () && index_vector[i].idx == index_vector[index].idx) 
-      ++i;
-    ++total;
-    index = i;
+    const int first = static_cast<int> (static_cast<long long> (nr_valid) * c / nr_chunks);
+    const int last = static_cast<int> (static_cast<long long> (nr_valid) * (c + 1) / nr_chunks);
+    int cell = chunk_offsets[c];
+    for (int i = first; i < last; ++i)
+      if (i == 0 || index_vector[i].idx != index_vector[i - 1].idx)
+        cell_begin[cell++] = i;
   }
+  cell_begin[total] = nr_valid;
 
   // Fourth pass: compute centroids, insert them into their final position
   output.points.resize (total);
   if (save_leaf_layout_)
   {
+    // The leaf layout is addressed with int indices
+    if (nr_voxels > static_cast<uint64_t> (std::numeric_limits<int>::max ()))
+      throw PCLException("VoxelGrid bin size is too low; impossible to allocate memory for layout", 
+        "voxel_grid.hpp", "applyFilter");	
+
     try
     { 
       // Resizing won't reset old elements to -1.  If leaf_layout_ has been used previously, it needs to be re-initialized to -1
-      uint32_t new_layout_size = div_b_[0]*div_b_[1]*div_b_[2];
+      size_t new_layout_size = static_cast<size_t> (nr_voxels);
       //This is the number of elements that need to be re-initialized to -1
-      uint32_t reinit_size = std::min (static_cast<unsigned int> (new_layout_size), static_cast<unsigned int> (leaf_layout_.size()));
-      for (uint32_t i = 0; i < reinit_size; i++)
+      size_t reinit_size = std::min (new_layout_size, leaf_layout_.size());
+      for (size_t i = 0; i < reinit_size; i++)
       {
         leaf_layout_[i] = -1;
       }        
@@ -303,43 +330,26 @@ pcl::VoxelGrid<PointT>::applyFilter (PointCloud &output)
         "voxel_grid.hpp", "applyFilter");	
     }
   }
-  
-  index = 0;
-  Eigen::VectorXf centroid = Eigen::VectorXf::Zero (centroid_size);
-  Eigen::VectorXf temporary = Eigen::VectorXf::Zero (centroid_size);
 
-  for (unsigned int cp = 0; cp < index_vector.size ();)
+#pragma omp parallel num_threads (threads_)
   {
-    // calculate centroid - sum values from all input points, that have the same idx value in index_vector array
-    if (!downsample_all_data_) 
-    {
-      centroid[0] = input_->points[index_vector[cp].cloud_point_index].x;
-      centroid[1] = input_->points[index_vector[cp].cloud_point_index].y;
-      centroid[2] = input_->points[index_vector[cp].cloud_point_index].z;
-    }
-    else 
-    {
-      // ---[ RGB special case
-      if (rgba_index >= 0)
-      {
-        // Fill r/g/b data, assuming that the order is BGRA
-        pcl::RGB rgb;
-        memcpy (&rgb, reinterpret_cast<const char*> (&input_->points[index_vector[cp].cloud_point_index]) + rgba_index, sizeof (RGB));
-        centroid[centroid_size-3] = rgb.r;
-        centroid[centroid_size-2] = rgb.g;
-        centroid[centroid_size-1] = rgb.b;
-      }
-      pcl::for_each_type <FieldList> (NdCopyPointEigenFunctor <PointT> (input_->points[index_vector[cp].cloud_point_index], centroid));
-    }
+    Eigen::VectorXf centroid = Eigen::VectorXf::Zero (centroid_size);
+    Eigen::VectorXf temporary = Eigen::VectorXf::Zero (centroid_size);
 
-    unsigned int i = cp + 1;
-    while (i < index_vector.size () && index_vector[i].idx == index_vector[cp].idx) 
+#pragma omp for schedule (dynamic, 1024)
+    for (int index = 0; index < total; ++index)
     {
+      const int cp = cell_begin[index];
+      const int i = cell_begin[index + 1];
+
+      // calculate centroid - sum values from all input points, that have the same idx value in index_vector array
       if (!downsample_all_data_) 
       {
-        centroid[0] += input_->points[index_vector[i].cloud_point_index].x;
-        centroid[1] += input_->points[index_vector[i].cloud_point_index].y;
-        centroid[2] += input_->points[index_vector[i].cloud_point_index].z;
+        // the xyz coordinates are summed as aligned 4 float packets
+        Eigen::Array4f xyz_sum = input_->points[index_vector[cp].cloud_point_index].getArray4fMap ();
+        for (int j = cp + 1; j < i; ++j)
+          xyz_sum += input_->points[index_vector[j].cloud_point_index].getArray4fMap ();
+        centroid.head<4> () = xyz_sum.matrix ();
       }
       else 
       {
@@ -348,47 +358,122 @@ pcl::VoxelGrid<PointT>::applyFilter (PointCloud &output)
         {
           // Fill r/g/b data, assuming that the order is BGRA
           pcl::RGB rgb;
-          memcpy (&rgb, reinterpret_cast<const char*> (&input_->points[index_vector[i].cloud_point_index]) + rgba_index, sizeof (RGB));
-          temporary[centroid_size-3] = rgb.r;
-          temporary[centroid_size-2] = rgb.g;
-          temporary[centroid_size-1] = rgb.b;
+          memcpy (&rgb, reinterpret_cast<const char*> (&input_->points[index_vector[cp].cloud_point_index]) + rgba_index, sizeof (RGB));
+          centroid[centroid_size-3] = rgb.r;
+          centroid[centroid_size-2] = rgb.g;
+          centroid[centroid_size-1] = rgb.b;
+        }
+        pcl::for_each_type <FieldList> (NdCopyPointEigenFunctor <PointT> (input_->points[index_vector[cp].cloud_point_index], centroid));
+
+        for (int j = cp + 1; j < i; ++j)
+        {
+          // ---[ RGB special case
+          if (rgba_index >= 0)
+          {
+            // Fill r/g/b data, assuming that the order is BGRA
+            pcl::RGB rgb;
+            memcpy (&rgb, reinterpret_cast<const char*> (&input_->points[index_vector[j].cloud_point_index]) + rgba_index, sizeof (RGB));
+            temporary[centroid_size-3] = rgb.r;
+            temporary[centroid_size-2] = rgb.g;
+            temporary[centroid_size-1] = rgb.b;
+          }
+          pcl::for_each_type <FieldList> (NdCopyPointEigenFunctor <PointT> (input_->points[index_vector[j].cloud_point_index], temporary));
+          centroid += temporary;
+        }
+      }
+
+      // index is centroid final position in resulting PointCloud
+      if (save_leaf_layout_)
+        leaf_layout_[static_cast<size_t> (index_vector[cp].idx)] = index;
+
+      centroid /= static_cast<float> (i - cp);
+
+      // store centroid
+      // Do we need to process all the fields?
+      if (!downsample_all_data_) 
+      {
+        output.points[index].x = centroid[0];
+        output.points[index].y = centroid[1];
+        output.points[index].z = centroid[2];
+      }
+      else 
+      {
+        pcl::for_each_type<FieldList> (pcl::NdCopyEigenPointFunctor <PointT> (centroid, output.points[index]));
+        // ---[ RGB special case
+        if (rgba_index >= 0) 
+        {
+          // pack r/g/b into rgb
+          float r = centroid[centroid_size-3], g = centroid[centroid_size-2], b = centroid[centroid_size-1];
+          int rgb = (static_cast<int> (r) << 16) | (static_cast<int> (g) << 8) | static_cast<int> (b);
+          memcpy (reinterpret_cast<char*> (&output.points[index]) + rgba_index, &rgb, sizeof (float));
         }
-        pcl::for_each_type <FieldList> (NdCopyPointEigenFunctor <PointT> (input_->points[index_vector[i].cloud_point_index], temporary));
-        centroid += temporary;
       }
-      ++i;
     }
+  }
+  output.width = static_cast<uint32_t> (output.points.size ());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::VoxelGrid<PointT>::sortVoxelIndices (std::vector<VoxelIndex> &index_vector, unsigned int nr_bits) const
+{
+  const int nr_indices = static_cast<int> (index_vector.size ());
+  const int nr_chunks = std::max (1, std::min (nr_indices / 65536, 64));
+  const unsigned int nr_passes = (nr_bits + 7) / 8;
 
-    // index is centroid final position in resulting PointCloud
-    if (save_leaf_layout_)
-      leaf_layout_[index_vector[cp].idx] = index;
+  std::vector<VoxelIndex> buffer (index_vector.size ());
+  std::vector<int> histograms (256 * nr_chunks);
 
-    centroid /= static_cast<float> (i - cp);
+  for (unsigned int pass = 0; pass < nr_passes; ++pass)
+  {
+    const unsigned int shift = 8 * pass;
 
-    // store centroid
-    // Do we need to process all the fields?
-    if (!downsample_all_data_) 
+    // count the digits of each chunk
+#pragma omp parallel for num_threads (threads_)
+    for (int c = 0; c < nr_chunks; ++c)
     {
-      output.points[index].x = centroid[0];
-      output.points[index].y = centroid[1];
-      output.points[index].z = centroid[2];
+      int* histogram = &histograms[256 * c];
+      std::fill (histogram, histogram + 256, 0);
+
+      const int first = static_cast<int> (static_cast<long long> (nr_indices) * c / nr_chunks);
+      const int last = static_cast<int> (static_cast<long long> (nr_indices) * (c + 1) / nr_chunks);
+      for (int i = first; i < last; ++i)
+        ++histogram[(index_vector[i].idx >> shift) & 0xff];
     }
-    else 
+
+    // exclusive prefix sum, digit major and chunk minor so that the scatter is stable
+    int offset = 0;
+    bool single_digit = false;
+    for (int digit = 0; digit < 256; ++digit)
     {
-      pcl::for_each_type<FieldList> (pcl::NdCopyEigenPointFunctor <PointT> (centroid, output.points[index]));
-      // ---[ RGB special case
-      if (rgba_index >= 0) 
+      const int digit_begin = offset;
+      for (int c = 0; c < nr_chunks; ++c)
       {
-        // pack r/g/b into rgb
-        float r = centroid[centroid_size-3], g = centroid[centroid_size-2], b = centroid[centroid_size-1];
-        int rgb = (static_cast<int> (r) << 16) | (static_cast<int> (g) << 8) | static_cast<int> (b);
-        memcpy (reinterpret_cast<char*> (&output.points[index]) + rgba_index, &rgb, sizeof (float));
+        const int count = histograms[256 * c + digit];
+        histograms[256 * c + digit] = offset;
+        offset += count;
       }
+      if (offset - digit_begin == nr_indices)
+        single_digit = true;
+    }
+
+    // all the indices share this digit, the pass would not move anything
+    if (single_digit)
+      continue;
+
+#pragma omp parallel for num_threads (threads_)
+    for (int c = 0; c < nr_chunks; ++c)
+    {
+      int* histogram = &histograms[256 * c];
+
+      const int first = static_cast<int> (static_cast<long long> (nr_indices) * c / nr_chunks);
+      const int last = static_cast<int> (static_cast<long long> (nr_indices) * (c + 1) / nr_chunks);
+      for (int i = first; i < last; ++i)
+        buffer[histogram[(index_vector[i].idx >> shift) & 0xff]++] = index_vector[i];
     }
-    cp = i;
-    ++index;
+
+    index_vector.swap (buffer);
   }
-  output.width = static_cast<uint32_t> (output.points.size ());
 }
 
 #define PCL_INSTANTIATE_VoxelGrid(T) template class PCL_EXPORTS pcl::VoxelGrid<T>;
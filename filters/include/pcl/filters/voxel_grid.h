@@ -153,6 +153,9 @@ namespace pcl
     * a bit slower than approximating them with the center of the voxel, but it
     * represents the underlying surface more accurately.
     *
+    * Voxels are addressed with 64 bit indices, sorted with a parallel radix sort, so that fine leaf sizes over large
+    * clouds do not overflow the grid. Saving the leaf layout still requires the grid to fit in an int index.
+    *
     * \author Radu B. Rusu, Bastian Steder
     * \ingroup filters
     */
@@ -184,7 +187,8 @@ namespace pcl
         filter_field_name_ (""), 
         filter_limit_min_ (-FLT_MAX), 
         filter_limit_max_ (FLT_MAX),
-        filter_limit_negative_ (false)
+        filter_limit_negative_ (false),
+        threads_ (0)
       {
         filter_name_ = "VoxelGrid";
       }
@@ -250,6 +254,12 @@ namespace pcl
       inline bool 
       getSaveLeafLayout () { return (save_leaf_layout_); }
 
+      /** \brief Set the number of threads used to sort the points into their voxels and to compute the centroids.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads = 0) { threads_ = nr_threads; }
+
       /** \brief Get the minimum coordinates of the bounding box (after
         * filtering is performed). 
         */
@@ -450,8 +460,26 @@ namespace pcl
       /** \brief Set to true if we want to return the data outside (\a filter_limit_min_;\a filter_limit_max_). Default: false. */
       bool filter_limit_negative_;
 
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
+
       typedef typename pcl::traits::fieldList<PointT>::type FieldList;
 
+      /** \brief A point index and the 64 bit index of its voxel in the grid. */
+      struct VoxelIndex
+      {
+        uint64_t idx;
+        unsigned int cloud_point_index;
+      };
+
+      /** \brief Sort voxel indices by voxel with a parallel LSD radix sort, 8 bits per pass. The sort is stable, so the
+        * points of a voxel keep their order in the input cloud.
+        * \param[in,out] index_vector the voxel indices to sort
+        * \param[in] nr_bits the number of significant bits of the voxel indices
+        */
+      void
+      sortVoxelIndices (std::vector<VoxelIndex> &index_vector, unsigned int nr_bits) const;
+
       /** \brief Downsample a Point Cloud using a voxelized grid approach
         * \param[out] output the resultant point cloud message
         */
@@ -50,5 +50,6 @@ PCL_INSTANTIATE(TfQuadraticXYZComparison, PCL_XYZ_POINT_TYPES)
 PCL_INSTANTIATE(ConditionBase, PCL_XYZ_POINT_TYPES)
 PCL_INSTANTIATE(ConditionAnd, PCL_XYZ_POINT_TYPES)
 PCL_INSTANTIATE(ConditionOr, PCL_XYZ_POINT_TYPES)
+PCL_INSTANTIATE(CompiledCondition, PCL_XYZ_POINT_TYPES)
 PCL_INSTANTIATE(ConditionalRemoval, PCL_XYZ_POINT_TYPES)
 
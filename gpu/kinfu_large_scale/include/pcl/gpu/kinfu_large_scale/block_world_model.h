@@ -0,0 +1,224 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2011, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_BLOCK_WORLD_MODEL_H_
+#define PCL_BLOCK_WORLD_MODEL_H_
+
+#include <pcl/gpu/kinfu_large_scale/world_model.h>
+#include <boost/unordered_map.hpp>
+
+namespace pcl
+{
+  /** \brief BlockWorldModel is a WorldModel backend that groups the points of the world into cubic blocks
+    * keyed by their voxel coordinates.
+    * Extracting or evicting a slice only visits the blocks that overlap the slice bounds, so the cost
+    * of a shift depends on the size of the TSDF volume and not on how much of the world was scanned.
+    * Points evicted by setSliceAsNans are erased from their blocks directly, cleanWorldFromNans only drops empty blocks.
+    * \note The world is expected in TSDF grid coordinates (indices), as filled by the CyclicalBuffer.
+    */
+  template <typename PointT>
+  class BlockWorldModel : public WorldModel<PointT>
+  {
+    public:
+
+      typedef boost::shared_ptr<BlockWorldModel<PointT> > Ptr;
+      typedef boost::shared_ptr<const BlockWorldModel<PointT> > ConstPtr;
+
+      typedef typename WorldModel<PointT>::PointCloud PointCloud;
+      typedef typename WorldModel<PointT>::PointCloudPtr PointCloudPtr;
+
+      typedef typename WorldModel<PointT>::PointVector PointVector;
+      typedef boost::unordered_map<uint64_t, PointVector> BlockMap;
+      typedef typename BlockMap::iterator BlockIterator;
+
+      using WorldModel<PointT>::world_;
+
+      /** \brief Constructor for the BlockWorldModel.
+        * \param[in] block_size side of a block, in voxels.
+        */
+      BlockWorldModel (const int block_size = 32) :
+        WorldModel<PointT> (),
+        blocks_ (),
+        block_size_ (block_size > 0 ? block_size : 32),
+        nb_points_ (0)
+      {
+      }
+
+      /** \brief Set the side of a block, in voxels. The world is cleared if it is not empty.
+        * \param[in] block_size side of a block, in voxels.
+        */
+      void setBlockSize (const int block_size)
+      {
+        if (block_size <= 0)
+        {
+          PCL_ERROR ("[pcl::BlockWorldModel::setBlockSize] Block size must be positive (%d given).\n", block_size);
+          return;
+        }
+        if (nb_points_ != 0)
+          reset ();
+        block_size_ = block_size;
+      }
+
+      /** \brief Returns the side of a block, in voxels. */
+      int getBlockSize () const { return (block_size_); }
+
+      /** \brief Returns the number of allocated blocks. */
+      size_t getNumberOfBlocks () const { return (blocks_.size ()); }
+
+      /** \brief Clear the world.
+        */
+      void reset ();
+
+      /** \brief Dispatch a new point cloud (slice) into the blocks of the world.
+        * \param[in] new_cloud the point cloud to add to the world
+        */
+      void addSlice (const PointCloudPtr new_cloud);
+
+      /** \brief Retreive existing data from the world model, after a shift. Only the blocks overlapping the new cube are visited.
+        * \param[in] previous_origin_x global origin of the cube on X axis, before the shift
+        * \param[in] previous_origin_y global origin of the cube on Y axis, before the shift
+        * \param[in] previous_origin_z global origin of the cube on Z axis, before the shift
+        * \param[in] offset_x shift on X, in indices
+        * \param[in] offset_y shift on Y, in indices
+        * \param[in] offset_z shift on Z, in indices
+        * \param[in] volume_x size of the cube, X axis, in indices
+        * \param[in] volume_y size of the cube, Y axis, in indices
+        * \param[in] volume_z size of the cube, Z axis, in indices
+        * \param[out] existing_slice the extracted point cloud representing the slice
+        */
+      void getExistingData (const double previous_origin_x, const double previous_origin_y, const double previous_origin_z,
+                            const double offset_x, const double offset_y, const double offset_z,
+                            const double volume_x, const double volume_y, const double volume_z, pcl::PointCloud<PointT> &existing_slice);
+
+      /** \brief Remove the points of the slice from the world. Only the blocks overlapping the slice are visited.
+        * \param[in] origin_x global origin of the cube on X axis, before the shift
+        * \param[in] origin_y global origin of the cube on Y axis, before the shift
+        * \param[in] origin_z global origin of the cube on Z axis, before the shift
+        * \param[in] offset_x shift on X, in indices
+        * \param[in] offset_y shift on Y, in indices
+        * \param[in] offset_z shift on Z, in indices
+        * \param[in] size_x size of the cube, X axis, in indices
+        * \param[in] size_y size of the cube, Y axis, in indices
+        * \param[in] size_z size of the cube, Z axis, in indices
+        */
+      void setSliceAsNans (const double origin_x, const double origin_y, const double origin_z,
+                           const double offset_x, const double offset_y, const double offset_z,
+                           const int size_x, const int size_y, const int size_z);
+
+      /** \brief Drop the blocks left empty by setSliceAsNans. The blocks never contain nan points.
+        */
+      void cleanWorldFromNans ();
+
+      /** \brief Gathers the blocks and returns the world as a point cloud.
+        * \note This copies every point of the world, it is meant for saving the world, not for the shift path.
+        */
+      PointCloudPtr getWorld ();
+
+      /** \brief Returns the number of points contained in the world.
+        */
+      size_t getWorldSize ()
+      {
+        return (nb_points_);
+      }
+
+    protected:
+
+      /** \brief Extract the points of the world lying inside an axis aligned box, visiting only the overlapping blocks.
+        * \param[in] min_x lower bound of the box on X axis (inclusive)
+        * \param[in] min_y lower bound of the box on Y axis (inclusive)
+        * \param[in] min_z lower bound of the box on Z axis (inclusive)
+        * \param[in] max_x upper bound of the box on X axis (exclusive)
+        * \param[in] max_y upper bound of the box on Y axis (exclusive)
+        * \param[in] max_z upper bound of the box on Z axis (exclusive)
+        * \param[out] box the points of the world inside the box
+        */
+      void extractBox (const double min_x, const double min_y, const double min_z,
+                       const double max_x, const double max_y, const double max_z, PointCloud &box);
+
+      /** \brief Compute the bounding values of the world on XYZ.
+        * \param[out] min the minimum coordinates of the world
+        * \param[out] max the maximum coordinates of the world
+        */
+      void getWorldBounds (PointT &min, PointT &max);
+
+      /** \brief Collect the points of the blocks, without copying them.
+        * \param[out] segments the first point and the number of points of each array
+        */
+      void getWorldSegments (std::vector<std::pair<const PointT*, size_t> > &segments);
+
+    private:
+
+      typedef typename WorldModel<PointT>::Box Box;
+      typedef typename WorldModel<PointT>::EnteringSlice EnteringSlice;
+      typedef typename WorldModel<PointT>::EvictedSlice EvictedSlice;
+
+      /** \brief Returns the block coordinate of a value expressed in voxels. */
+      inline int
+      getBlockCoordinate (const double value) const
+      {
+        return (static_cast<int> (floor (value / block_size_)));
+      }
+
+      /** \brief Packs the coordinates of a block into a single key (21 bits per axis). */
+      static inline uint64_t
+      getBlockKey (const int x, const int y, const int z)
+      {
+        const uint64_t mask = (1 << 21) - 1;
+        return (((static_cast<uint64_t> (x + (1 << 20)) & mask) << 42) |
+                ((static_cast<uint64_t> (y + (1 << 20)) & mask) << 21) |
+                 (static_cast<uint64_t> (z + (1 << 20)) & mask));
+      }
+
+      /** \brief Collect the blocks overlapping a box.
+        * \param[in] box the box, in voxels
+        * \param[out] blocks iterators to the overlapping blocks
+        */
+      void
+      findBlocks (const Box &box, std::vector<BlockIterator> &blocks);
+
+      /** \brief blocks of points, keyed by their block coordinates */
+      BlockMap blocks_;
+
+      /** \brief side of a block, in voxels */
+      int block_size_;
+
+      /** \brief number of points contained in the blocks */
+      size_t nb_points_;
+  };
+}
+
+#endif // PCL_BLOCK_WORLD_MODEL_H_
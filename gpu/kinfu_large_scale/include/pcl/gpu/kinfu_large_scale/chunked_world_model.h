@@ -0,0 +1,223 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2011, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_CHUNKED_WORLD_MODEL_H_
+#define PCL_CHUNKED_WORLD_MODEL_H_
+
+#include <pcl/gpu/kinfu_large_scale/world_model.h>
+
+namespace pcl
+{
+  /** \brief ChunkedWorldModel is an append-only WorldModel backend storing the world in fixed size chunks of points.
+    * Adding a slice fills the last chunk and allocates new ones, the points already in the world are never copied or moved.
+    * Points evicted by setSliceAsNans are set to nan in place, as in WorldModel. cleanWorldFromNans drops the chunks left
+    * without valid points and only compacts the chunks in which most points were evicted.
+    * Each chunk keeps the bounding box of its points, so that slice queries skip the chunks that do not overlap the slice.
+    * Since a chunk is filled by consecutive slices, the chunks are spatially coherent.
+    */
+  template <typename PointT>
+  class ChunkedWorldModel : public WorldModel<PointT>
+  {
+    public:
+
+      typedef boost::shared_ptr<ChunkedWorldModel<PointT> > Ptr;
+      typedef boost::shared_ptr<const ChunkedWorldModel<PointT> > ConstPtr;
+
+      typedef typename WorldModel<PointT>::PointCloud PointCloud;
+      typedef typename WorldModel<PointT>::PointCloudPtr PointCloudPtr;
+
+      typedef typename WorldModel<PointT>::PointVector PointVector;
+
+      /** \brief A chunk of the world: its points (nan once evicted) and their bounding box. */
+      struct Chunk
+      {
+        PointVector points;
+        Eigen::Array4f min;
+        Eigen::Array4f max;
+        size_t nb_valid;
+
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+      };
+      typedef boost::shared_ptr<Chunk> ChunkPtr;
+
+      using WorldModel<PointT>::world_;
+
+      /** \brief Constructor for the ChunkedWorldModel.
+        * \param[in] chunk_size number of points of a chunk.
+        */
+      ChunkedWorldModel (const size_t chunk_size = 65536) :
+        WorldModel<PointT> (),
+        chunks_ (),
+        chunk_size_ (chunk_size > 0 ? chunk_size : 65536),
+        nb_points_ (0)
+      {
+      }
+
+      /** \brief Set the number of points of a chunk. The world is cleared if it is not empty.
+        * \param[in] chunk_size number of points of a chunk.
+        */
+      void setChunkSize (const size_t chunk_size)
+      {
+        if (chunk_size == 0)
+        {
+          PCL_ERROR ("[pcl::ChunkedWorldModel::setChunkSize] Chunk size must be positive.\n");
+          return;
+        }
+        if (!chunks_.empty ())
+          reset ();
+        chunk_size_ = chunk_size;
+      }
+
+      /** \brief Returns the number of points of a chunk. */
+      size_t getChunkSize () const { return (chunk_size_); }
+
+      /** \brief Returns the number of allocated chunks. */
+      size_t getNumberOfChunks () const { return (chunks_.size ()); }
+
+      /** \brief Clear the world.
+        */
+      void reset ();
+
+      /** \brief Append a new point cloud (slice) to the world, without moving the points already in the world.
+        * \param[in] new_cloud the point cloud to add to the world
+        */
+      void addSlice (const PointCloudPtr new_cloud);
+
+      /** \brief Retreive existing data from the world model, after a shift. Only the chunks overlapping the new cube are visited.
+        * \param[in] previous_origin_x global origin of the cube on X axis, before the shift
+        * \param[in] previous_origin_y global origin of the cube on Y axis, before the shift
+        * \param[in] previous_origin_z global origin of the cube on Z axis, before the shift
+        * \param[in] offset_x shift on X, in indices
+        * \param[in] offset_y shift on Y, in indices
+        * \param[in] offset_z shift on Z, in indices
+        * \param[in] volume_x size of the cube, X axis, in indices
+        * \param[in] volume_y size of the cube, Y axis, in indices
+        * \param[in] volume_z size of the cube, Z axis, in indices
+        * \param[out] existing_slice the extracted point cloud representing the slice
+        */
+      void getExistingData (const double previous_origin_x, const double previous_origin_y, const double previous_origin_z,
+                            const double offset_x, const double offset_y, const double offset_z,
+                            const double volume_x, const double volume_y, const double volume_z, pcl::PointCloud<PointT> &existing_slice);
+
+      /** \brief Give nan values to the points of the slice. Only the chunks overlapping the slice are visited.
+        * \param[in] origin_x global origin of the cube on X axis, before the shift
+        * \param[in] origin_y global origin of the cube on Y axis, before the shift
+        * \param[in] origin_z global origin of the cube on Z axis, before the shift
+        * \param[in] offset_x shift on X, in indices
+        * \param[in] offset_y shift on Y, in indices
+        * \param[in] offset_z shift on Z, in indices
+        * \param[in] size_x size of the cube, X axis, in indices
+        * \param[in] size_y size of the cube, Y axis, in indices
+        * \param[in] size_z size of the cube, Z axis, in indices
+        */
+      void setSliceAsNans (const double origin_x, const double origin_y, const double origin_z,
+                           const double offset_x, const double offset_y, const double offset_z,
+                           const int size_x, const int size_y, const int size_z);
+
+      /** \brief Drop the chunks without valid points, compact the chunks in which less than half of the points are valid.
+        */
+      void cleanWorldFromNans ();
+
+      /** \brief Gathers the valid points of the chunks and returns the world as a point cloud.
+        * \note This copies every point of the world, it is meant for saving the world, not for the shift path.
+        */
+      PointCloudPtr getWorld ();
+
+      /** \brief Returns the number of valid points contained in the world.
+        */
+      size_t getWorldSize ()
+      {
+        return (nb_points_);
+      }
+
+    protected:
+
+      /** \brief Extract the points of the world lying inside an axis aligned box, visiting only the overlapping chunks.
+        * \param[in] min_x lower bound of the box on X axis (inclusive)
+        * \param[in] min_y lower bound of the box on Y axis (inclusive)
+        * \param[in] min_z lower bound of the box on Z axis (inclusive)
+        * \param[in] max_x upper bound of the box on X axis (exclusive)
+        * \param[in] max_y upper bound of the box on Y axis (exclusive)
+        * \param[in] max_z upper bound of the box on Z axis (exclusive)
+        * \param[out] box the points of the world inside the box
+        */
+      void extractBox (const double min_x, const double min_y, const double min_z,
+                       const double max_x, const double max_y, const double max_z, PointCloud &box);
+
+      /** \brief Compute the bounding values of the valid points of the world on XYZ.
+        * \param[out] min the minimum coordinates of the world
+        * \param[out] max the maximum coordinates of the world
+        */
+      void getWorldBounds (PointT &min, PointT &max);
+
+      /** \brief Collect the points of the chunks, with their nan points, without copying them.
+        * \param[out] segments the first point and the number of points of each array
+        */
+      void getWorldSegments (std::vector<std::pair<const PointT*, size_t> > &segments);
+
+    private:
+
+      typedef typename WorldModel<PointT>::Box Box;
+      typedef typename WorldModel<PointT>::EnteringSlice EnteringSlice;
+      typedef typename WorldModel<PointT>::EvictedSlice EvictedSlice;
+
+      /** \brief Check if the bounding box of a chunk overlaps a box. */
+      static inline bool
+      overlaps (const Chunk &chunk, const Box &box)
+      {
+        return (chunk.nb_valid != 0 &&
+                chunk.max[0] >= box.min[0] && chunk.min[0] < box.max[0] &&
+                chunk.max[1] >= box.min[1] && chunk.min[1] < box.max[1] &&
+                chunk.max[2] >= box.min[2] && chunk.min[2] < box.max[2]);
+      }
+
+      /** \brief Recompute the bounding box and the number of valid points of a chunk, dropping its nan points. */
+      static void
+      compactChunk (Chunk &chunk);
+
+      /** \brief chunks of points, in insertion order */
+      std::vector<ChunkPtr> chunks_;
+
+      /** \brief number of points of a chunk */
+      size_t chunk_size_;
+
+      /** \brief number of valid points contained in the chunks */
+      size_t nb_points_;
+  };
+}
+
+#endif // PCL_CHUNKED_WORLD_MODEL_H_
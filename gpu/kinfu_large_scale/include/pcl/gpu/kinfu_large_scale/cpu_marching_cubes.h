@@ -0,0 +1,163 @@
+ /*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2011, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_CPU_MARCHING_CUBES_H_
+#define PCL_CPU_MARCHING_CUBES_H_
+
+#include <string>
+#include <vector>
+#include <pcl/point_types.h>
+#include <pcl/point_cloud.h>
+#include <pcl/PolygonMesh.h>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/function.hpp>
+#include <Eigen/Core>
+
+namespace pcl
+{
+  /** \brief CpuMarchingCubes extracts meshes from the TSDF clouds of the world model on the CPU.
+    * It follows the cell layout of the GPU marching cubes (voxel centers, corner order and face orientation) with the
+    * tables of pcl::MarchingCubes, and shares the vertices between triangles through the voxel edge they lie on.
+    * As it does not need a TSDF volume on the device, several cubes of the world can be meshed concurrently.
+    */
+  template <typename PointT>
+  class CpuMarchingCubes
+  {
+    public:
+      typedef typename pcl::PointCloud<PointT> PointCloud;
+      typedef typename pcl::PointCloud<PointT>::Ptr PointCloudPtr;
+      typedef boost::shared_ptr<pcl::PolygonMesh> MeshPtr;
+
+      /** \brief Returns the TSDF cloud of a cube from its position in the list of cubes, e.g. WorldModel::CubeBuckets::getCube.
+        * Called from several threads at once.
+        */
+      typedef boost::function<PointCloudPtr (size_t)> CubeGetter;
+
+      /** \brief Constructor
+        * \param[in] voxels_x number of voxels of a cube on X axis
+        * \param[in] voxels_y number of voxels of a cube on Y axis
+        * \param[in] voxels_z number of voxels of a cube on Z axis
+        * \param[in] volume_size size of a cube in meters. Must match the size used when scanning.
+        */
+      CpuMarchingCubes (int voxels_x = 512, int voxels_y = 512, int voxels_z = 512, float volume_size = 3.0f);
+
+      /** \brief Run marching cubes in a TSDF cloud and returns a PolygonMesh. Input X,Y,Z coordinates must be in indices of the TSDF volume grid, output is in meters.
+        * Only the voxels in ]0 ... VOXELS_X[ ]0 ... VOXELS_Y[ ]0 ... VOXELS_Z[ are used, as in pcl::gpu::StandaloneMarchingCubes.
+        * \param[in] cloud TSDF cloud. Intensity value corresponds to the TSDF value in that coordinate.
+        * \return pointer to a PolygonMesh in meters, null if no face was generated.
+        */
+      MeshPtr
+      getMeshFromTSDFCloud (const PointCloud &cloud) const;
+
+      /** \brief Runs marching cubes on every cloud of the vector with a pool of threads. Each mesh is moved to the world frame and saved
+        * as <prefix><n>.ply as soon as it is done, n being the position of the cube in the vector (starting at 1). Cubes are released once meshed.
+        * \param[in,out] tsdf_clouds vector of TSDF clouds in world indices
+        * \param[in] tsdf_offsets position (in indices) of every cube with respect to the origin of the world model
+        * \param[in] nr_threads number of threads to use (0 uses one thread per core)
+        * \param[in] prefix prefix of the saved files
+        * \return the number of meshes saved
+        */
+      int
+      getMeshesFromTSDFVector (std::vector<PointCloudPtr> &tsdf_clouds, const std::vector<Eigen::Vector3f> &tsdf_offsets,
+                               unsigned int nr_threads = 0, const std::string &prefix = "mesh_");
+
+      /** \brief Same as getMeshesFromTSDFVector, but the cubes are built by get_cube when a thread picks them, so that only
+        * the cubes being meshed are held in memory.
+        * \param[in] get_cube returns the TSDF cloud of a cube in world indices, e.g. a bound WorldModel::CubeBuckets::getCube
+        * \param[in] tsdf_offsets position (in indices) of every cube with respect to the origin of the world model
+        * \param[in] nr_threads number of threads to use (0 uses one thread per core)
+        * \param[in] prefix prefix of the saved files
+        * \return the number of meshes saved
+        */
+      int
+      getMeshesFromTSDFCubes (const CubeGetter &get_cube, const std::vector<Eigen::Vector3f> &tsdf_offsets,
+                              unsigned int nr_threads = 0, const std::string &prefix = "mesh_");
+
+      /** \brief Returns the size of a voxel in meters. */
+      float
+      getCellSize () const { return (volume_size_ / voxels_x_); }
+
+    private:
+
+      /** \brief The progress of a getMeshesFromTSDFCubes call, shared by its workers. */
+      struct MeshingState
+      {
+        MeshingState () : mutex (), next_cube (0), nb_meshes (0) {}
+
+        /** Guards the cube counter and the statistics */
+        boost::mutex mutex;
+        /** Next cube to mesh */
+        size_t next_cube;
+        /** Number of meshes saved */
+        int nb_meshes;
+      };
+
+      /** \brief Run marching cubes on a cube of the world.
+        * \param[in] cloud TSDF cloud, in indices
+        * \param[in] origin origin of the cube in indices, subtracted from the cloud before meshing and added back (in meters) to the vertices
+        * \return pointer to a PolygonMesh in meters, null if no face was generated.
+        */
+      MeshPtr
+      computeMesh (const PointCloud &cloud, const Eigen::Vector3f &origin) const;
+
+      /** \brief Worker of getMeshesFromTSDFCubes: meshes and saves cubes until there is none left.
+        * \param[in] get_cube returns the cubes to mesh
+        * \param[in] tsdf_offsets the position of the cubes, in indices
+        * \param[in] prefix prefix of the saved files
+        * \param[in,out] state the progress of the call, shared by its workers
+        */
+      void
+      meshCubes (const CubeGetter &get_cube, const std::vector<Eigen::Vector3f> &tsdf_offsets, const std::string &prefix,
+                 MeshingState *state) const;
+
+      /** \brief Cube getter of getMeshesFromTSDFVector: moves cube i out of the vector, so that it is freed once meshed. */
+      static PointCloudPtr
+      takeCube (std::vector<PointCloudPtr> *tsdf_clouds, size_t i);
+
+      /** Number of voxels in the grid for each axis */
+      int voxels_x_;
+      int voxels_y_;
+      int voxels_z_;
+
+      /** Tsdf volume size in meters */
+      float volume_size_;
+  };
+}
+
+#endif // PCL_CPU_MARCHING_CUBES_H_
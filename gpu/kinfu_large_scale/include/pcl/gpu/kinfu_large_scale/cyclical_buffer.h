@@ -48,6 +48,7 @@
 #include <pcl/gpu/kinfu_large_scale/point_intensity.h>
 
 #include <pcl/gpu/kinfu_large_scale/world_model.h>
+#include <pcl/gpu/kinfu_large_scale/slice_writer.h>
 #include "../../../../src/internal.h"
 
 #include <pcl/io/pcd_io.h>
@@ -71,6 +72,7 @@ namespace pcl
           * \param[in] nb_voxels_per_axis number of voxels per axis of the volume represented by the TSDF buffer.
           */
         CyclicalBuffer (const double distance_threshold, const double cube_size = 3.f, const int nb_voxels_per_axis = 512)
+          : world_model_ (new pcl::WorldModel<pcl::PointXYZI>)
         {
           distance_threshold_ = distance_threshold;
           buffer_.volume_size.x = cube_size; 
@@ -92,6 +94,7 @@ namespace pcl
           * \param[in] nb_voxels_z number of voxels for Z axis of the volume represented by the TSDF buffer.
           */
         CyclicalBuffer (const double distance_threshold, const double volume_size_x, const double volume_size_y, const double volume_size_z, const int nb_voxels_x, const int nb_voxels_y, const int nb_voxels_z)
+          : world_model_ (new pcl::WorldModel<pcl::PointXYZI>)
         {
           distance_threshold_ = distance_threshold;
           buffer_.volume_size.x = volume_size_x; 
@@ -234,7 +237,34 @@ namespace pcl
         pcl::WorldModel<pcl::PointXYZI>*
         getWorldModel ()
         {
-          return (&world_model_);
+          return (world_model_.get ());
+        }
+
+        /** \brief Replace the world model, e.g. by a spatially indexed pcl::BlockWorldModel.
+          * \param[in] world_model the world model backend used to store the shifted slices
+          */
+        void
+        setWorldModel (const pcl::WorldModel<pcl::PointXYZI>::Ptr &world_model)
+        {
+          if (world_model)
+            world_model_ = world_model;
+        }
+
+        /** \brief Set a writer persisting the slices added to the world model in the background, NULL to disable it.
+          * \param[in] slice_writer the writer receiving the slices, in global grid coordinates
+          */
+        void
+        setSliceWriter (const pcl::SliceWriter<pcl::PointXYZI>::Ptr &slice_writer)
+        {
+          slice_writer_ = slice_writer;
+        }
+
+        /** \brief Return the writer persisting the slices, NULL if none was set
+          */
+        pcl::SliceWriter<pcl::PointXYZI>::Ptr
+        getSliceWriter ()
+        {
+          return (slice_writer_);
         }
                
         
@@ -250,7 +280,10 @@ namespace pcl
         double distance_threshold_;
         
         /** \brief world model object that maintains the known world */
-        pcl::WorldModel<pcl::PointXYZI> world_model_;
+        pcl::WorldModel<pcl::PointXYZI>::Ptr world_model_;
+
+        /** \brief optional writer persisting the slices added to the world */
+        pcl::SliceWriter<pcl::PointXYZI>::Ptr slice_writer_;
 
         /** \brief structure that contains all TSDF buffer's addresses */
         tsdf_buffer buffer_;
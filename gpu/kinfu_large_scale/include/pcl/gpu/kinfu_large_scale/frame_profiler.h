@@ -0,0 +1,294 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2011, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef PCL_KINFU_FRAME_PROFILER_H_
+#define PCL_KINFU_FRAME_PROFILER_H_
+
+#include <pcl/pcl_exports.h>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace pcl
+{
+  namespace gpu
+  {
+    /** \brief FrameProfiler records the wall time spent in each stage of the KinfuLS pipeline, frame by frame,
+      * together with the host and device memory in use at the end of each frame.
+      * Stage events and frame records are kept in two ring buffers of fixed capacity, so a long scan only keeps
+      * its last frames. They can be dumped as CSV (one line per frame) or as a Chrome trace (chrome://tracing).
+      *
+      * The pipeline is instrumented with the KINFU_PROFILE_* macros, which compile to nothing unless
+      * PCL_KINFU_PROFILING is defined (CMake option KINFU_LS_PROFILING). When compiled in, the profiler
+      * still records nothing until it is enabled.
+      * \note CUDA kernels are asynchronous: unless synchronization is disabled, the device is synchronized at
+      * the end of each device stage so that the time of a stage includes its kernels. Host stages, timed with
+      * KINFU_PROFILE_HOST_STAGE, are never synchronized: they may run on a worker thread, next to the kernels
+      * queued by the main thread.
+      */
+    class PCL_EXPORTS FrameProfiler
+    {
+      public:
+
+        /** \brief Stages of the pipeline. ICP_LEVEL events are nested in the ICP stage. */
+        enum Stage
+        {
+          FRAME,
+          PREPROCESS,
+          RAYCAST,
+          ICP,
+          ICP_LEVEL,
+          SHIFT,
+          INTEGRATE,
+          PLANE_FITTING,
+          MESH_EXTRACTION,
+          NB_STAGES
+        };
+
+        /** \brief A timed stage. Times are in microseconds since the profiler was enabled. */
+        struct Event
+        {
+          int stage;
+          int level;
+          int frame;
+          int thread;
+          double begin;
+          double duration;
+        };
+
+        /** \brief Summary of a frame: total time of each stage and memory in use at the end of the frame. */
+        struct FrameRecord
+        {
+          int frame;
+          double begin;
+          double duration;
+          double stage_time[NB_STAGES];
+          size_t host_memory;
+          size_t device_memory;
+        };
+
+        /** \brief Times a stage from construction to destruction. Does nothing if the profiler is disabled. */
+        class ScopedStage
+        {
+          public:
+            /** \param[in] stage the stage
+              * \param[in] level pyramid level, -1 if not relevant
+              * \param[in] device true if the stage queues device work, which is then waited for at the end of the stage
+              */
+            ScopedStage (const Stage stage, const int level = -1, const bool device = true);
+            ~ScopedStage ();
+          private:
+            ScopedStage (const ScopedStage &);
+            ScopedStage& operator= (const ScopedStage &);
+
+            Stage stage_;
+            int level_;
+            double begin_;
+            bool device_;
+            bool active_;
+        };
+
+        /** \brief Brackets a frame from construction to destruction. Does nothing if the profiler is disabled. */
+        class ScopedFrame
+        {
+          public:
+            ScopedFrame (const bool has_data, const int frame);
+            ~ScopedFrame ();
+          private:
+            ScopedFrame (const ScopedFrame &);
+            ScopedFrame& operator= (const ScopedFrame &);
+
+            bool active_;
+        };
+
+        /** \brief Returns the profiler of the process. */
+        static FrameProfiler&
+        instance ();
+
+        /** \brief Returns the name of a stage, as written in the CSV header and the trace. */
+        static const char*
+        getStageName (const int stage);
+
+        /** \brief Start or stop recording. Enabling the profiler clears what was recorded before. */
+        void
+        setEnabled (const bool enabled);
+
+        /** \brief Returns true if the profiler is recording. */
+        inline bool
+        isEnabled () const { return (enabled_); }
+
+        /** \brief Synchronize the device at the end of each device stage (default: true). */
+        void
+        setSynchronizeDevice (const bool synchronize) { synchronize_ = synchronize; }
+
+        /** \brief Set the capacity of the ring buffers. Clears what was recorded before.
+          * \param[in] max_frames number of frame records kept
+          * \param[in] max_events number of stage events kept
+          */
+        void
+        setCapacity (const size_t max_frames, const size_t max_events);
+
+        /** \brief Clear the ring buffers. */
+        void
+        clear ();
+
+        /** \brief Open a new frame. Stages ended before the next endFrame are accounted to it.
+          * \param[in] frame index of the frame
+          */
+        void
+        beginFrame (const int frame);
+
+        /** \brief Close the current frame and sample the memory in use. */
+        void
+        endFrame ();
+
+        /** \brief Record a stage of the current frame.
+          * \param[in] stage the stage
+          * \param[in] level pyramid level, -1 if not relevant
+          * \param[in] begin start time, as returned by now ()
+          * \param[in] end end time, as returned by now ()
+          */
+        void
+        addEvent (const Stage stage, const int level, const double begin, const double end);
+
+        /** \brief Returns the time elapsed since the profiler was enabled, in microseconds. */
+        double
+        now () const;
+
+        /** \brief Returns the number of frame records currently kept. */
+        size_t
+        getNumberOfFrames () const;
+
+        /** \brief Returns the number of stage events currently kept. */
+        size_t
+        getNumberOfEvents () const;
+
+        /** \brief Write one line per recorded frame: frame, begin, total time and time of each stage (ms),
+          * then host and device memory in use (MB).
+          * \param[in] filename output file
+          * \return true on success
+          */
+        bool
+        saveCSV (const std::string &filename) const;
+
+        /** \brief Write the recorded stages and memory counters in the Chrome trace event format.
+          * \param[in] filename output file
+          * \return true on success
+          */
+        bool
+        saveChromeTrace (const std::string &filename) const;
+
+        /** \brief Returns the resident memory of the process, in bytes (0 if unknown). */
+        static size_t
+        getHostMemory ();
+
+        /** \brief Returns the memory in use on the current device, in bytes (0 if unknown). */
+        static size_t
+        getDeviceMemory ();
+
+      private:
+
+        FrameProfiler ();
+        FrameProfiler (const FrameProfiler &);
+        FrameProfiler& operator= (const FrameProfiler &);
+
+        /** \brief Returns a small index for the calling thread. Must be called with mutex_ locked. */
+        int
+        getThreadIndex ();
+
+        /** \brief Copies the records of a ring buffer in chronological order. */
+        template <typename T> static void
+        unroll (const std::vector<T> &ring, const size_t head, const size_t size, std::vector<T> &out);
+
+        /** \brief true while recording */
+        bool enabled_;
+
+        /** \brief synchronize the device at the end of each device stage */
+        bool synchronize_;
+
+        /** \brief absolute time at which recording started, in microseconds */
+        double origin_;
+
+        /** \brief frame being recorded, valid while in_frame_ is set */
+        FrameRecord current_;
+        bool in_frame_;
+
+        /** \brief ring buffer of frame records */
+        std::vector<FrameRecord> frames_;
+        size_t frames_head_;
+        size_t frames_size_;
+
+        /** \brief ring buffer of stage events */
+        std::vector<Event> events_;
+        size_t events_head_;
+        size_t events_size_;
+
+        /** \brief indices of the threads that recorded events */
+        std::map<boost::thread::id, int> threads_;
+
+        /** \brief protects the buffers, stages may be timed from worker threads */
+        mutable boost::mutex mutex_;
+    };
+  }
+}
+
+#ifdef PCL_KINFU_PROFILING
+#  define KINFU_PROFILE_JOIN_(a, b) a##b
+#  define KINFU_PROFILE_JOIN(a, b) KINFU_PROFILE_JOIN_(a, b)
+   /** \brief Time the enclosing scope as the given pcl::gpu::FrameProfiler::Stage. */
+#  define KINFU_PROFILE_STAGE(stage) \
+     pcl::gpu::FrameProfiler::ScopedStage KINFU_PROFILE_JOIN(kinfu_profile_stage_, __LINE__) (pcl::gpu::FrameProfiler::stage)
+   /** \brief Time the enclosing scope as the given stage, without waiting for the device at its end. */
+#  define KINFU_PROFILE_HOST_STAGE(stage) \
+     pcl::gpu::FrameProfiler::ScopedStage KINFU_PROFILE_JOIN(kinfu_profile_stage_, __LINE__) (pcl::gpu::FrameProfiler::stage, -1, false)
+   /** \brief Time the enclosing scope as the given stage, for one pyramid level. */
+#  define KINFU_PROFILE_LEVEL(stage, level) \
+     pcl::gpu::FrameProfiler::ScopedStage KINFU_PROFILE_JOIN(kinfu_profile_stage_, __LINE__) (pcl::gpu::FrameProfiler::stage, level)
+   /** \brief Account the stages timed in the enclosing scope to a frame. */
+#  define KINFU_PROFILE_FRAME(has_data, frame) \
+     pcl::gpu::FrameProfiler::ScopedFrame KINFU_PROFILE_JOIN(kinfu_profile_frame_, __LINE__) (has_data, frame)
+#else
+#  define KINFU_PROFILE_STAGE(stage)
+#  define KINFU_PROFILE_HOST_STAGE(stage)
+#  define KINFU_PROFILE_LEVEL(stage, level)
+#  define KINFU_PROFILE_FRAME(has_data, frame)
+#endif
+
+#endif // PCL_KINFU_FRAME_PROFILER_H_
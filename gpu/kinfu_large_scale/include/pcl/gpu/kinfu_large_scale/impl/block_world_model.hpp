@@ -0,0 +1,265 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2011, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_BLOCK_WORLD_MODEL_IMPL_HPP_
+#define PCL_BLOCK_WORLD_MODEL_IMPL_HPP_
+
+#include <pcl/gpu/kinfu_large_scale/block_world_model.h>
+#include <pcl/gpu/kinfu_large_scale/impl/world_model.hpp>
+
+
+template <typename PointT>
+void
+pcl::BlockWorldModel<PointT>::reset ()
+{
+  PCL_WARN ("Clearing block world model\n");
+  blocks_.clear ();
+  nb_points_ = 0;
+  world_->points.clear ();
+}
+
+
+template <typename PointT>
+void
+pcl::BlockWorldModel<PointT>::addSlice (const PointCloudPtr new_cloud)
+{
+  PCL_DEBUG ("Adding new cloud. Current world contains %d points in %d blocks.\n", nb_points_, blocks_.size ());
+
+  PCL_DEBUG ("New slice contains %d points.\n", new_cloud->points.size ());
+
+  // consecutive points of a slice mostly fall in the same block, avoid hashing them again
+  uint64_t last_key = 0;
+  PointVector *last_block = NULL;
+
+  for (size_t i = 0; i < new_cloud->points.size (); ++i)
+  {
+    const PointT &point = new_cloud->points[i];
+    if (!pcl_isfinite (point.x) || !pcl_isfinite (point.y) || !pcl_isfinite (point.z))
+      continue;
+
+    const uint64_t key = getBlockKey (getBlockCoordinate (point.x), getBlockCoordinate (point.y), getBlockCoordinate (point.z));
+    if (last_block == NULL || key != last_key)
+    {
+      last_block = &blocks_[key];
+      last_key = key;
+    }
+    last_block->push_back (point);
+    ++nb_points_;
+  }
+
+  PCL_DEBUG ("World now contains %d points in %d blocks.\n", nb_points_, blocks_.size ());
+}
+
+
+template <typename PointT>
+void
+pcl::BlockWorldModel<PointT>::findBlocks (const Box &box, std::vector<BlockIterator> &blocks)
+{
+  blocks.clear ();
+
+  int min_block[3], max_block[3];
+  double nb_candidates = 1.0;
+  for (int d = 0; d < 3; ++d)
+  {
+    min_block[d] = getBlockCoordinate (box.min[d]);
+    max_block[d] = getBlockCoordinate (box.max[d]);
+    nb_candidates *= static_cast<double> (max_block[d] - min_block[d] + 1);
+  }
+
+  // look the candidate keys up, unless the box covers more blocks than the world actually has
+  if (nb_candidates <= static_cast<double> (blocks_.size ()))
+  {
+    for (int x = min_block[0]; x <= max_block[0]; ++x)
+      for (int y = min_block[1]; y <= max_block[1]; ++y)
+        for (int z = min_block[2]; z <= max_block[2]; ++z)
+        {
+          BlockIterator it = blocks_.find (getBlockKey (x, y, z));
+          if (it != blocks_.end ())
+            blocks.push_back (it);
+        }
+  }
+  else
+  {
+    for (BlockIterator it = blocks_.begin (); it != blocks_.end (); ++it)
+    {
+      if (it->second.empty ())
+        continue;
+      const PointT &point = it->second.front ();
+      const int x = getBlockCoordinate (point.x);
+      const int y = getBlockCoordinate (point.y);
+      const int z = getBlockCoordinate (point.z);
+      if (x >= min_block[0] && x <= max_block[0] &&
+          y >= min_block[1] && y <= max_block[1] &&
+          z >= min_block[2] && z <= max_block[2])
+        blocks.push_back (it);
+    }
+  }
+}
+
+
+template <typename PointT>
+void
+pcl::BlockWorldModel<PointT>::getExistingData (const double previous_origin_x, const double previous_origin_y, const double previous_origin_z, const double offset_x, const double offset_y, const double offset_z, const double volume_x, const double volume_y, const double volume_z, pcl::PointCloud<PointT> &existing_slice)
+{
+  EnteringSlice slice;
+  this->getEnteringSlice (previous_origin_x, previous_origin_y, previous_origin_z, offset_x, offset_y, offset_z, volume_x, volume_y, volume_z, slice);
+
+  existing_slice.points.clear ();
+
+  std::vector<BlockIterator> blocks;
+  findBlocks (slice.cube, blocks);
+
+  for (size_t b = 0; b < blocks.size (); ++b)
+    this->copyPointsIn (slice, blocks[b]->second, existing_slice);
+
+  this->finishExistingSlice (slice, existing_slice);
+}
+
+
+template <typename PointT>
+void
+pcl::BlockWorldModel<PointT>::setSliceAsNans (const double origin_x, const double origin_y, const double origin_z, const double offset_x, const double offset_y, const double offset_z, const int size_x, const int size_y, const int size_z)
+{
+  PCL_DEBUG ("IN SETSLICE AS NANS (blocks)\n");
+
+  EvictedSlice slice;
+  this->getEvictedSlice (origin_x, origin_y, origin_z, offset_x, offset_y, offset_z, size_x, size_y, size_z, slice);
+
+  std::vector<BlockIterator> blocks;
+  findBlocks (slice.bounds, blocks);
+
+  size_t nb_removed = 0;
+  for (size_t b = 0; b < blocks.size (); ++b)
+  {
+    PointVector &block = blocks[b]->second;
+    size_t kept = 0;
+    for (size_t i = 0; i < block.size (); ++i)
+    {
+      const PointT &point = block[i];
+      if (slice.contains (point))
+        continue;
+      if (kept != i)
+        block[kept] = point;
+      ++kept;
+    }
+    nb_removed += block.size () - kept;
+    block.resize (kept);
+  }
+  nb_points_ -= nb_removed;
+
+  PCL_DEBUG ("%d points removed from %d blocks\n", static_cast<int> (nb_removed), static_cast<int> (blocks.size ()));
+}
+
+
+template <typename PointT>
+void
+pcl::BlockWorldModel<PointT>::cleanWorldFromNans ()
+{
+  BlockIterator it = blocks_.begin ();
+  while (it != blocks_.end ())
+  {
+    if (it->second.empty ())
+      it = blocks_.erase (it);
+    else
+      ++it;
+  }
+}
+
+
+template <typename PointT>
+typename pcl::BlockWorldModel<PointT>::PointCloudPtr
+pcl::BlockWorldModel<PointT>::getWorld ()
+{
+  world_->points.clear ();
+  world_->points.reserve (nb_points_);
+  for (BlockIterator it = blocks_.begin (); it != blocks_.end (); ++it)
+    world_->points.insert (world_->points.end (), it->second.begin (), it->second.end ());
+
+  this->setAsUnorganized (*world_);
+  return (world_);
+}
+
+
+template <typename PointT>
+void
+pcl::BlockWorldModel<PointT>::extractBox (const double min_x, const double min_y, const double min_z,
+                                          const double max_x, const double max_y, const double max_z, PointCloud &box)
+{
+  const Box region = {{static_cast<float> (min_x), static_cast<float> (min_y), static_cast<float> (min_z)},
+                      {static_cast<float> (max_x), static_cast<float> (max_y), static_cast<float> (max_z)}};
+
+  box.points.clear ();
+
+  std::vector<BlockIterator> blocks;
+  findBlocks (region, blocks);
+
+  for (size_t b = 0; b < blocks.size (); ++b)
+    this->copyPointsIn (region, blocks[b]->second, box);
+
+  this->setAsUnorganized (box);
+}
+
+
+template <typename PointT>
+void
+pcl::BlockWorldModel<PointT>::getWorldBounds (PointT &min, PointT &max)
+{
+  Eigen::Array4f min_p, max_p;
+  min_p.setConstant (FLT_MAX);
+  max_p.setConstant (-FLT_MAX);
+
+  for (BlockIterator it = blocks_.begin (); it != blocks_.end (); ++it)
+    this->updateBounds (it->second, min_p, max_p);
+
+  min.x = min_p[0]; min.y = min_p[1]; min.z = min_p[2];
+  max.x = max_p[0]; max.y = max_p[1]; max.z = max_p[2];
+}
+
+
+template <typename PointT>
+void
+pcl::BlockWorldModel<PointT>::getWorldSegments (std::vector<std::pair<const PointT*, size_t> > &segments)
+{
+  segments.clear ();
+  for (BlockIterator it = blocks_.begin (); it != blocks_.end (); ++it)
+    if (!it->second.empty ())
+      segments.push_back (std::make_pair (&it->second[0], it->second.size ()));
+}
+
+#define PCL_INSTANTIATE_BlockWorldModel(T) template class PCL_EXPORTS pcl::BlockWorldModel<T>;
+
+#endif // PCL_BLOCK_WORLD_MODEL_IMPL_HPP_
@@ -0,0 +1,255 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2011, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_CHUNKED_WORLD_MODEL_IMPL_HPP_
+#define PCL_CHUNKED_WORLD_MODEL_IMPL_HPP_
+
+#include <pcl/gpu/kinfu_large_scale/chunked_world_model.h>
+#include <pcl/gpu/kinfu_large_scale/impl/world_model.hpp>
+
+
+template <typename PointT>
+void
+pcl::ChunkedWorldModel<PointT>::reset ()
+{
+  PCL_WARN ("Clearing chunked world model\n");
+  chunks_.clear ();
+  nb_points_ = 0;
+  world_->points.clear ();
+}
+
+
+template <typename PointT>
+void
+pcl::ChunkedWorldModel<PointT>::addSlice (const PointCloudPtr new_cloud)
+{
+  PCL_DEBUG ("Adding new cloud. Current world contains %d points in %d chunks.\n", nb_points_, chunks_.size ());
+
+  PCL_DEBUG ("New slice contains %d points.\n", new_cloud->points.size ());
+
+  Chunk *chunk = chunks_.empty () ? NULL : chunks_.back ().get ();
+
+  for (size_t i = 0; i < new_cloud->points.size (); ++i)
+  {
+    const PointT &point = new_cloud->points[i];
+    if (!pcl_isfinite (point.x) || !pcl_isfinite (point.y) || !pcl_isfinite (point.z))
+      continue;
+
+    // the capacity of a chunk is reserved once, push_back never reallocates it
+    if (chunk == NULL || chunk->points.size () == chunk_size_)
+    {
+      ChunkPtr new_chunk (new Chunk);
+      new_chunk->points.reserve (chunk_size_);
+      new_chunk->min.setConstant (FLT_MAX);
+      new_chunk->max.setConstant (-FLT_MAX);
+      new_chunk->nb_valid = 0;
+      chunks_.push_back (new_chunk);
+      chunk = new_chunk.get ();
+    }
+
+    chunk->points.push_back (point);
+    chunk->min = chunk->min.min (point.getArray4fMap ());
+    chunk->max = chunk->max.max (point.getArray4fMap ());
+    ++chunk->nb_valid;
+    ++nb_points_;
+  }
+
+  PCL_DEBUG ("World now contains %d points in %d chunks.\n", nb_points_, chunks_.size ());
+}
+
+
+template <typename PointT>
+void
+pcl::ChunkedWorldModel<PointT>::getExistingData (const double previous_origin_x, const double previous_origin_y, const double previous_origin_z, const double offset_x, const double offset_y, const double offset_z, const double volume_x, const double volume_y, const double volume_z, pcl::PointCloud<PointT> &existing_slice)
+{
+  EnteringSlice slice;
+  this->getEnteringSlice (previous_origin_x, previous_origin_y, previous_origin_z, offset_x, offset_y, offset_z, volume_x, volume_y, volume_z, slice);
+
+  existing_slice.points.clear ();
+
+  for (size_t c = 0; c < chunks_.size (); ++c)
+    if (overlaps (*chunks_[c], slice.cube))
+      this->copyPointsIn (slice, chunks_[c]->points, existing_slice);
+
+  this->finishExistingSlice (slice, existing_slice);
+}
+
+
+template <typename PointT>
+void
+pcl::ChunkedWorldModel<PointT>::setSliceAsNans (const double origin_x, const double origin_y, const double origin_z, const double offset_x, const double offset_y, const double offset_z, const int size_x, const int size_y, const int size_z)
+{
+  PCL_DEBUG ("IN SETSLICE AS NANS (chunks)\n");
+
+  EvictedSlice slice;
+  this->getEvictedSlice (origin_x, origin_y, origin_z, offset_x, offset_y, offset_z, size_x, size_y, size_z, slice);
+
+  const float nan = std::numeric_limits<float>::quiet_NaN ();
+  size_t nb_removed = 0, nb_visited = 0;
+  for (size_t c = 0; c < chunks_.size (); ++c)
+  {
+    Chunk &chunk = *chunks_[c];
+    if (!overlaps (chunk, slice.bounds))
+      continue;
+
+    ++nb_visited;
+    for (size_t i = 0; i < chunk.points.size (); ++i)
+    {
+      PointT &point = chunk.points[i];
+      if (slice.contains (point))
+      {
+        point.x = point.y = point.z = nan;
+        --chunk.nb_valid;
+        ++nb_removed;
+      }
+    }
+  }
+  nb_points_ -= nb_removed;
+
+  PCL_DEBUG ("%d points set as nans in %d chunks\n", static_cast<int> (nb_removed), static_cast<int> (nb_visited));
+}
+
+
+template <typename PointT>
+void
+pcl::ChunkedWorldModel<PointT>::compactChunk (Chunk &chunk)
+{
+  chunk.min.setConstant (FLT_MAX);
+  chunk.max.setConstant (-FLT_MAX);
+
+  size_t kept = 0;
+  for (size_t i = 0; i < chunk.points.size (); ++i)
+  {
+    const PointT &point = chunk.points[i];
+    if (!pcl_isfinite (point.x))
+      continue;
+    if (kept != i)
+      chunk.points[kept] = point;
+    chunk.min = chunk.min.min (point.getArray4fMap ());
+    chunk.max = chunk.max.max (point.getArray4fMap ());
+    ++kept;
+  }
+  chunk.points.resize (kept);
+  chunk.nb_valid = kept;
+}
+
+
+template <typename PointT>
+void
+pcl::ChunkedWorldModel<PointT>::cleanWorldFromNans ()
+{
+  size_t kept = 0;
+  for (size_t c = 0; c < chunks_.size (); ++c)
+  {
+    Chunk &chunk = *chunks_[c];
+    if (chunk.nb_valid == 0)
+      continue;
+    if (chunk.nb_valid * 2 < chunk.points.size ())
+      compactChunk (chunk);
+    chunks_[kept++] = chunks_[c];
+  }
+  chunks_.resize (kept);
+}
+
+
+template <typename PointT>
+typename pcl::ChunkedWorldModel<PointT>::PointCloudPtr
+pcl::ChunkedWorldModel<PointT>::getWorld ()
+{
+  world_->points.clear ();
+  world_->points.reserve (nb_points_);
+  for (size_t c = 0; c < chunks_.size (); ++c)
+  {
+    const PointVector &points = chunks_[c]->points;
+    for (size_t i = 0; i < points.size (); ++i)
+      if (pcl_isfinite (points[i].x))
+        world_->points.push_back (points[i]);
+  }
+
+  this->setAsUnorganized (*world_);
+  return (world_);
+}
+
+
+template <typename PointT>
+void
+pcl::ChunkedWorldModel<PointT>::extractBox (const double min_x, const double min_y, const double min_z,
+                                            const double max_x, const double max_y, const double max_z, PointCloud &box)
+{
+  const Box region = {{static_cast<float> (min_x), static_cast<float> (min_y), static_cast<float> (min_z)},
+                      {static_cast<float> (max_x), static_cast<float> (max_y), static_cast<float> (max_z)}};
+
+  box.points.clear ();
+
+  for (size_t c = 0; c < chunks_.size (); ++c)
+    if (overlaps (*chunks_[c], region))
+      this->copyPointsIn (region, chunks_[c]->points, box);
+
+  this->setAsUnorganized (box);
+}
+
+
+template <typename PointT>
+void
+pcl::ChunkedWorldModel<PointT>::getWorldBounds (PointT &min, PointT &max)
+{
+  Eigen::Array4f min_p, max_p;
+  min_p.setConstant (FLT_MAX);
+  max_p.setConstant (-FLT_MAX);
+
+  // the bounds of the chunks are not shrunk when points are evicted, look at the points themselves
+  for (size_t c = 0; c < chunks_.size (); ++c)
+    this->updateBounds (chunks_[c]->points, min_p, max_p);
+
+  min.x = min_p[0]; min.y = min_p[1]; min.z = min_p[2];
+  max.x = max_p[0]; max.y = max_p[1]; max.z = max_p[2];
+}
+
+
+template <typename PointT>
+void
+pcl::ChunkedWorldModel<PointT>::getWorldSegments (std::vector<std::pair<const PointT*, size_t> > &segments)
+{
+  segments.clear ();
+  for (size_t c = 0; c < chunks_.size (); ++c)
+    if (!chunks_[c]->points.empty ())
+      segments.push_back (std::make_pair (&chunks_[c]->points[0], chunks_[c]->points.size ()));
+}
+
+#define PCL_INSTANTIATE_ChunkedWorldModel(T) template class PCL_EXPORTS pcl::ChunkedWorldModel<T>;
+
+#endif // PCL_CHUNKED_WORLD_MODEL_IMPL_HPP_
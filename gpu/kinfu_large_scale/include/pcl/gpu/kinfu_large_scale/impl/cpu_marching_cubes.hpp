@@ -0,0 +1,279 @@
+ /*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2011, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_CPU_MARCHING_CUBES_IMPL_H_
+#define PCL_CPU_MARCHING_CUBES_IMPL_H_
+
+#include <pcl/gpu/kinfu_large_scale/cpu_marching_cubes.h>
+#include <pcl/surface/marching_cubes.h>
+#include <pcl/ros/conversions.h>
+#include <pcl/io/ply_io.h>
+#include <pcl/console/print.h>
+#include <boost/thread/thread.hpp>
+#include <algorithm>
+#include <sstream>
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PointT>
+pcl::CpuMarchingCubes<PointT>::CpuMarchingCubes (int voxels_x, int voxels_y, int voxels_z, float volume_size) :
+  voxels_x_ (voxels_x),
+  voxels_y_ (voxels_y),
+  voxels_z_ (voxels_z),
+  volume_size_ (volume_size)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PointT> typename pcl::CpuMarchingCubes<PointT>::MeshPtr
+pcl::CpuMarchingCubes<PointT>::getMeshFromTSDFCloud (const PointCloud &cloud) const
+{
+  return (computeMesh (cloud, Eigen::Vector3f::Zero ()));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PointT> typename pcl::CpuMarchingCubes<PointT>::MeshPtr
+pcl::CpuMarchingCubes<PointT>::computeMesh (const PointCloud &cloud, const Eigen::Vector3f &origin) const
+{
+  const int DIVISOR = 32767;     // SHRT_MAX, as in the GPU volume
+  const int slice = voxels_x_ * voxels_y_;
+
+  // corners of a cell, in the order of the GPU marching cubes
+  static const int corner_offsets[8][3] = {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0},
+                                           {0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1}};
+  // lower and upper corners of each edge, and the axis of the edge
+  static const int edge_corners[12][2] = {{0, 1}, {1, 2}, {3, 2}, {0, 3}, {4, 5}, {5, 6},
+                                          {7, 6}, {4, 7}, {0, 4}, {1, 5}, {2, 6}, {3, 7}};
+  static const int edge_axis[12] = {0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2};
+
+  // load the voxels of the cube, with the same bounds and quantization as StandaloneMarchingCubes
+  boost::unordered_map<int, float> tsdf (cloud.points.size ());
+  std::vector<int> voxels;
+  voxels.reserve (cloud.points.size ());
+  for (size_t i = 0; i < cloud.points.size (); ++i)
+  {
+    const int x = static_cast<int> (cloud.points[i].x - origin[0]);
+    const int y = static_cast<int> (cloud.points[i].y - origin[1]);
+    const int z = static_cast<int> (cloud.points[i].z - origin[2]);
+
+    if (x > 0 && x < voxels_x_ && y > 0 && y < voxels_y_ && z > 0 && z < voxels_z_)
+    {
+      const float value = std::max (-1.0f, std::min (1.0f, cloud.points[i].intensity));
+      const int index = x + voxels_x_ * y + slice * z;
+      std::pair<boost::unordered_map<int, float>::iterator, bool> res = tsdf.insert (std::make_pair (index, 0.0f));
+      res.first->second = static_cast<short> (value * DIVISOR) / static_cast<float> (DIVISOR);
+      if (res.second)
+        voxels.push_back (index);
+    }
+  }
+
+  // visit the cells in memory order, to output the same mesh whatever the order of the cloud
+  std::sort (voxels.begin (), voxels.end ());
+
+  const float cell_size = getCellSize ();
+  pcl::PointCloud<pcl::PointXYZ> vertices;
+  std::vector<pcl::Vertices> polygons;
+  boost::unordered_map<uint64_t, int> edge_vertices;
+
+  for (size_t v = 0; v < voxels.size (); ++v)
+  {
+    const int index = voxels[v];
+    const int x = index % voxels_x_;
+    const int y = (index / voxels_x_) % voxels_y_;
+    const int z = index / slice;
+
+    // a cell is only meshed when its eight corners hold a value. The voxels at 0 are never loaded,
+    // so a corner wrapping over the border of the grid is never found.
+    int corner_index[8];
+    float f[8];
+    bool complete = true;
+    for (int c = 0; c < 8; ++c)
+    {
+      corner_index[c] = index + corner_offsets[c][0] + voxels_x_ * corner_offsets[c][1] + slice * corner_offsets[c][2];
+      boost::unordered_map<int, float>::const_iterator it = tsdf.find (corner_index[c]);
+      if (it == tsdf.end ())
+      {
+        complete = false;
+        break;
+      }
+      f[c] = it->second;
+    }
+    if (!complete)
+      continue;
+
+    int cubeindex = 0;
+    for (int c = 0; c < 8; ++c)
+      if (f[c] < 0)
+        cubeindex |= 1 << c;
+
+    if (pcl::edgeTable[cubeindex] == 0)
+      continue;
+
+    for (int t = 0; pcl::triTable[cubeindex][t] != -1; t += 3)
+    {
+      int ids[3];
+      for (int k = 0; k < 3; ++k)
+      {
+        const int e = pcl::triTable[cubeindex][t + k];
+        const int lower = edge_corners[e][0];
+        const int upper = edge_corners[e][1];
+        const uint64_t key = static_cast<uint64_t> (corner_index[lower]) * 3 + edge_axis[e];
+
+        std::pair<boost::unordered_map<uint64_t, int>::iterator, bool> res =
+          edge_vertices.insert (std::make_pair (key, static_cast<int> (vertices.points.size ())));
+        if (res.second)
+        {
+          // interpolate from the lower corner, so the neighbouring cells compute the same vertex
+          const float ratio = (0.f - f[lower]) / (f[upper] - f[lower] + 1e-15f);
+          pcl::PointXYZ p;
+          p.x = (x + corner_offsets[lower][0] + 0.5f) * cell_size;
+          p.y = (y + corner_offsets[lower][1] + 0.5f) * cell_size;
+          p.z = (z + corner_offsets[lower][2] + 0.5f) * cell_size;
+          (&p.x)[edge_axis[e]] += ratio * cell_size;
+          p.x += origin[0] * cell_size;
+          p.y += origin[1] * cell_size;
+          p.z += origin[2] * cell_size;
+          vertices.points.push_back (p);
+        }
+        ids[k] = res.first->second;
+      }
+
+      // same orientation as the faces of the GPU marching cubes
+      pcl::Vertices polygon;
+      polygon.vertices.resize (3);
+      polygon.vertices[0] = ids[0];
+      polygon.vertices[1] = ids[2];
+      polygon.vertices[2] = ids[1];
+      polygons.push_back (polygon);
+    }
+  }
+
+  if (polygons.empty ())
+    return (MeshPtr ());
+
+  vertices.width = static_cast<uint32_t> (vertices.points.size ());
+  vertices.height = 1;
+  vertices.is_dense = true;
+
+  MeshPtr mesh_ptr (new pcl::PolygonMesh ());
+  pcl::toROSMsg (vertices, mesh_ptr->cloud);
+  mesh_ptr->polygons.swap (polygons);
+  return (mesh_ptr);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::CpuMarchingCubes<PointT>::getMeshesFromTSDFVector (std::vector<PointCloudPtr> &tsdf_clouds, const std::vector<Eigen::Vector3f> &tsdf_offsets,
+                                                        unsigned int nr_threads, const std::string &prefix)
+{
+  //Safety check
+  const std::vector<Eigen::Vector3f> offsets (tsdf_offsets.begin (), tsdf_offsets.begin () + std::min (tsdf_clouds.size (), tsdf_offsets.size ()));
+  return (getMeshesFromTSDFCubes (boost::bind (&CpuMarchingCubes<PointT>::takeCube, &tsdf_clouds, _1), offsets, nr_threads, prefix));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::CpuMarchingCubes<PointT>::getMeshesFromTSDFCubes (const CubeGetter &get_cube, const std::vector<Eigen::Vector3f> &tsdf_offsets,
+                                                       unsigned int nr_threads, const std::string &prefix)
+{
+  if (nr_threads == 0)
+    nr_threads = std::max (1u, boost::thread::hardware_concurrency ());
+
+  const size_t nb_cubes = tsdf_offsets.size ();
+  PCL_INFO ("There are %d cubes to be processed with %d threads\n", nb_cubes, nr_threads);
+
+  // the state belongs to this call, so that several calls can run at once on the same object
+  MeshingState state;
+  boost::thread_group workers;
+  for (unsigned int i = 1; i < std::min<size_t> (nr_threads, nb_cubes); ++i)
+    workers.create_thread (boost::bind (&CpuMarchingCubes<PointT>::meshCubes, this, boost::cref (get_cube), boost::cref (tsdf_offsets), boost::cref (prefix), &state));
+  meshCubes (get_cube, tsdf_offsets, prefix, &state);
+  workers.join_all ();
+
+  PCL_INFO ("Saved %d meshes\n", state.nb_meshes);
+  return (state.nb_meshes);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::CpuMarchingCubes<PointT>::meshCubes (const CubeGetter &get_cube, const std::vector<Eigen::Vector3f> &tsdf_offsets, const std::string &prefix,
+                                          MeshingState *state) const
+{
+  const size_t nb_cubes = tsdf_offsets.size ();
+
+  while (true)
+  {
+    size_t i;
+    {
+      boost::mutex::scoped_lock lock (state->mutex);
+      if (state->next_cube >= nb_cubes)
+        return;
+      i = state->next_cube++;
+    }
+
+    // the worker owns the cube from now on, it is freed once meshed
+    PointCloudPtr cube = get_cube (i);
+    MeshPtr mesh = cube ? computeMesh (*cube, tsdf_offsets[i]) : MeshPtr ();
+    cube.reset ();
+
+    if (!mesh)
+    {
+      PCL_INFO ("Cube %d returned no faces, we skip it!\n", i + 1);
+      continue;
+    }
+
+    std::stringstream name;
+    name << prefix << i + 1 << ".ply";
+    pcl::io::savePLYFile (name.str (), *mesh);
+
+    boost::mutex::scoped_lock lock (state->mutex);
+    ++state->nb_meshes;
+    PCL_INFO ("Saved mesh %s (%d faces)\n", name.str ().c_str (), mesh->polygons.size ());
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename PointT> typename pcl::CpuMarchingCubes<PointT>::PointCloudPtr
+pcl::CpuMarchingCubes<PointT>::takeCube (std::vector<PointCloudPtr> *tsdf_clouds, size_t i)
+{
+  PointCloudPtr cube;
+  cube.swap ((*tsdf_clouds)[i]);
+  return (cube);
+}
+
+#define PCL_INSTANTIATE_CpuMarchingCubes(PointT) template class PCL_EXPORTS pcl::CpuMarchingCubes<PointT>;
+
+#endif // PCL_CPU_MARCHING_CUBES_IMPL_H_
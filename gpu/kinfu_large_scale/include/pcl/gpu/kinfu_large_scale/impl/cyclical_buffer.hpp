@@ -39,6 +39,7 @@
 #define PCL_CYCLICAL_BUFFER_IMPL_HPP_
 
 #include <pcl/gpu/kinfu_large_scale/cyclical_buffer.h>
+#include <pcl/gpu/kinfu_large_scale/frame_profiler.h>
 
 
 bool 
@@ -76,6 +77,8 @@ pcl::gpu::CyclicalBuffer::checkForShift (const pcl::gpu::TsdfVolume::Ptr volume,
 void
 pcl::gpu::CyclicalBuffer::performShift (const pcl::gpu::TsdfVolume::Ptr volume, const pcl::gpu::ColorVolume::Ptr color, const pcl::PointXYZ &target_point, const bool last_shift, const bool extract_world)
 {
+  KINFU_PROFILE_STAGE (SHIFT);
+
   // compute new origin and offsets
   int offset_x, offset_y, offset_z;
   computeAndSetNewCubeMetricOrigin (target_point, offset_x, offset_y, offset_z);
@@ -98,38 +101,28 @@ pcl::gpu::CyclicalBuffer::performShift (const pcl::gpu::TsdfVolume::Ptr volume,
 	  points = DeviceArray<PointXYZ> (cloud_buffer_device_xyz_.ptr (), size);
 	  intensities = DeviceArray<float> (cloud_buffer_device_intensities_.ptr(), size);
 
-	  PointCloud<PointXYZ>::Ptr current_slice_xyz (new PointCloud<PointXYZ>);
-	  PointCloud<PointIntensity>::Ptr current_slice_intensities (new PointCloud<PointIntensity>);
-
 	  // Retrieving XYZ 
-	  points.download (current_slice_xyz->points);
-	  current_slice_xyz->width = (int) current_slice_xyz->points.size ();
-	  current_slice_xyz->height = 1;
+	  std::vector<PointXYZ, Eigen::aligned_allocator<PointXYZ> > points_vector;
+	  points.download (points_vector);
 
 	  // Retrieving intensities
 	  // TODO change this mechanism by using PointIntensity directly (in spite of float)
 	  // when tried, this lead to wrong intenisty values being extracted by fetchSliceAsCloud () (padding pbls?)
 	  std::vector<float , Eigen::aligned_allocator<float> > intensities_vector;
 	  intensities.download (intensities_vector);
-	  current_slice_intensities->points.resize (current_slice_xyz->points.size ());
-	  for(int i = 0 ; i < current_slice_intensities->points.size () ; ++i)
-		current_slice_intensities->points[i].intensity = intensities_vector[i];
 
-	  current_slice_intensities->width = (int) current_slice_intensities->points.size ();
-	  current_slice_intensities->height = 1;
-
-	  // Concatenating XYZ and Intensities
-	  pcl::concatenateFields (*current_slice_xyz, *current_slice_intensities, *current_slice);
+	  // Concatenating XYZ and Intensities, and transforming the slice from local to global coordinates, in a single pass
+	  current_slice->points.resize (points_vector.size ());
+	  for (size_t i = 0; i < points_vector.size (); ++i)
+	  {
+		PointXYZI &point = current_slice->points[i];
+		point.x = points_vector[i].x + buffer_.origin_GRID_global.x;
+		point.y = points_vector[i].y + buffer_.origin_GRID_global.y;
+		point.z = points_vector[i].z + buffer_.origin_GRID_global.z;
+		point.intensity = intensities_vector[i];
+	  }
 	  current_slice->width = (int) current_slice->points.size ();
 	  current_slice->height = 1;
-
-	  // transform the slice from local to global coordinates
-	  Eigen::Affine3f global_cloud_transformation; 
-	  global_cloud_transformation.translation ()[0] = buffer_.origin_GRID_global.x;
-	  global_cloud_transformation.translation ()[1] = buffer_.origin_GRID_global.y;
-	  global_cloud_transformation.translation ()[2] = buffer_.origin_GRID_global.z;
-	  global_cloud_transformation.linear () = Eigen::Matrix3f::Identity ();
-	  transformPointCloud (*current_slice, *current_slice, global_cloud_transformation);
   }
 
   // retrieve existing data from the world model
@@ -140,21 +133,21 @@ pcl::gpu::CyclicalBuffer::performShift (const pcl::gpu::TsdfVolume::Ptr volume,
   double new_origin_z = buffer_.origin_GRID_global.z + offset_z;
 
   if ( extract_world ) {
-	  world_model_.getExistingData (buffer_.origin_GRID_global.x, buffer_.origin_GRID_global.y, buffer_.origin_GRID_global.z,
+	  world_model_->getExistingData (buffer_.origin_GRID_global.x, buffer_.origin_GRID_global.y, buffer_.origin_GRID_global.z,
 									offset_x, offset_y, offset_z,
 									buffer_.voxels_size.x - 1, buffer_.voxels_size.y - 1, buffer_.voxels_size.z - 1,
 									*previously_existing_slice);
   
 	  //replace world model data with values extracted from the TSDF buffer slice
-	  world_model_.setSliceAsNans (buffer_.origin_GRID_global.x, buffer_.origin_GRID_global.y, buffer_.origin_GRID_global.z,
+	  world_model_->setSliceAsNans (buffer_.origin_GRID_global.x, buffer_.origin_GRID_global.y, buffer_.origin_GRID_global.z,
 								   offset_x, offset_y, offset_z,
 								   buffer_.voxels_size.x, buffer_.voxels_size.y, buffer_.voxels_size.z);
 
   	  cout << current_slice->points.size() << endl;
 
-	  PCL_INFO ("world contains %d points after update\n", world_model_.getWorldSize ());
-	  world_model_.cleanWorldFromNans ();                               
-	  PCL_INFO ("world contains %d points after cleaning\n", world_model_.getWorldSize ());
+	  PCL_INFO ("world contains %d points after update\n", world_model_->getWorldSize ());
+	  world_model_->cleanWorldFromNans ();                               
+	  PCL_INFO ("world contains %d points after cleaning\n", world_model_->getWorldSize ());
   }
 
   // clear buffer slice and update the world model
@@ -217,8 +210,12 @@ pcl::gpu::CyclicalBuffer::performShift (const pcl::gpu::TsdfVolume::Ptr volume,
   if ( extract_world ) {
 	  // insert current slice in the world if it contains any points
 	  if (current_slice->points.size () != 0) {
-		world_model_.addSlice(current_slice);
-        PCL_INFO ("world contains %d points after add slice\n", world_model_.getWorldSize ());
+		world_model_->addSlice(current_slice);
+        PCL_INFO ("world contains %d points after add slice\n", world_model_->getWorldSize ());
+
+		// the slice is not modified anymore, persist it while tracking goes on
+		if (slice_writer_)
+		  slice_writer_->push (current_slice);
 	  }
   }
 
@@ -0,0 +1,152 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2011, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_SLICE_WRITER_IMPL_HPP_
+#define PCL_SLICE_WRITER_IMPL_HPP_
+
+#include <pcl/gpu/kinfu_large_scale/slice_writer.h>
+#include <pcl/io/pcd_io.h>
+#include <iomanip>
+#include <sstream>
+
+
+template <typename PointT>
+pcl::SliceWriter<PointT>::SliceWriter (const std::string &prefix) :
+  prefix_ (prefix),
+  queue_ (),
+  next_index_ (0),
+  nb_written_ (0),
+  busy_ (false),
+  stop_ (false)
+{
+  thread_ = boost::thread (&SliceWriter<PointT>::run, this);
+}
+
+
+template <typename PointT>
+pcl::SliceWriter<PointT>::~SliceWriter ()
+{
+  {
+    boost::mutex::scoped_lock lock (mutex_);
+    stop_ = true;
+  }
+  queue_cond_.notify_all ();
+  thread_.join ();
+}
+
+
+template <typename PointT>
+void
+pcl::SliceWriter<PointT>::push (const PointCloudConstPtr &slice)
+{
+  if (!slice || slice->points.empty ())
+    return;
+
+  {
+    boost::mutex::scoped_lock lock (mutex_);
+    queue_.push_back (std::make_pair (next_index_++, slice));
+  }
+  queue_cond_.notify_one ();
+}
+
+
+template <typename PointT>
+void
+pcl::SliceWriter<PointT>::flush ()
+{
+  boost::mutex::scoped_lock lock (mutex_);
+  while (!queue_.empty () || busy_)
+    written_cond_.wait (lock);
+}
+
+
+template <typename PointT>
+size_t
+pcl::SliceWriter<PointT>::getNumberOfWrittenSlices ()
+{
+  boost::mutex::scoped_lock lock (mutex_);
+  return (nb_written_);
+}
+
+
+template <typename PointT>
+size_t
+pcl::SliceWriter<PointT>::getNumberOfQueuedSlices ()
+{
+  boost::mutex::scoped_lock lock (mutex_);
+  return (queue_.size ());
+}
+
+
+template <typename PointT>
+void
+pcl::SliceWriter<PointT>::run ()
+{
+  while (true)
+  {
+    std::pair<int, PointCloudConstPtr> slice;
+    {
+      boost::mutex::scoped_lock lock (mutex_);
+      while (queue_.empty () && !stop_)
+        queue_cond_.wait (lock);
+      // the queued slices are written before stopping
+      if (queue_.empty ())
+        return;
+      slice = queue_.front ();
+      queue_.pop_front ();
+      busy_ = true;
+    }
+
+    std::ostringstream filename;
+    filename << prefix_ << std::setw (6) << std::setfill ('0') << slice.first << ".pcd";
+    if (pcl::io::savePCDFileBinary (filename.str (), *slice.second) < 0)
+      PCL_ERROR ("[pcl::SliceWriter::run] Couldn't write slice %d to %s\n", slice.first, filename.str ().c_str ());
+    else
+      PCL_DEBUG ("[pcl::SliceWriter::run] Slice %d (%d points) written to %s\n", slice.first, static_cast<int> (slice.second->points.size ()), filename.str ().c_str ());
+
+    {
+      boost::mutex::scoped_lock lock (mutex_);
+      busy_ = false;
+      ++nb_written_;
+    }
+    written_cond_.notify_all ();
+  }
+}
+
+#define PCL_INSTANTIATE_SliceWriter(T) template class PCL_EXPORTS pcl::SliceWriter<T>;
+
+#endif // PCL_SLICE_WRITER_IMPL_HPP_
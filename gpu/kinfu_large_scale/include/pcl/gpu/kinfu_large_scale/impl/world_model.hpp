@@ -132,20 +132,18 @@ void
 pcl::WorldModel<PointT>::getWorldAsCubes (const double size, std::vector<typename pcl::WorldModel<PointT>::PointCloudPtr> &cubes, std::vector<Eigen::Vector3f> &transforms, double overlap)
 {
   
-  if(world_->points.size () == 0)
+  if(getWorldSize () == 0)
   {
     PCL_INFO("The world is empty, returning nothing\n");
     return;
   }
 
-  PCL_INFO ("Getting world as cubes. World contains %d points.\n", world_->points.size ());
+  PCL_INFO ("Getting world as cubes. World contains %d points.\n", getWorldSize ());
 
   // remove nans from world cloud
-  world_->is_dense = false;
-  std::vector<int> indices;
-  pcl::removeNaNFromPointCloud	(	*world_, *world_, indices);
+  cleanWorldFromNans ();
 	
-  PCL_INFO ("World contains %d points after nan removal.\n", world_->points.size ());
+  PCL_INFO ("World contains %d points after nan removal.\n", getWorldSize ());
   
 
   // check cube size value
@@ -174,7 +172,7 @@ pcl::WorldModel<PointT>::getWorldAsCubes (const double size, std::vector<typenam
   
   // get world's bounding values on XYZ
   PointT min, max;
-  pcl::getMinMax3D(*world_, min, max);
+  getWorldBounds (min, max);
 
   PCL_INFO ("Bounding box for the world: \n\t [%f - %f] \n\t [%f - %f] \n\t [%f - %f] \n", min.x, max.x, min.y, max.y, min.z, max.z);
 
@@ -200,21 +198,8 @@ pcl::WorldModel<PointT>::getWorldAsCubes (const double size, std::vector<typenam
         PointCloudPtr box (new pcl::PointCloud<PointT>);
 
 
-        // set conditional filter
-        ConditionAndPtr range_cond (new pcl::ConditionAnd<PointT> ());
-        range_cond->addComparison (FieldComparisonConstPtr (new pcl::FieldComparison<PointT> ("x", pcl::ComparisonOps::GE, origin.x)));
-        range_cond->addComparison (FieldComparisonConstPtr (new pcl::FieldComparison<PointT> ("x", pcl::ComparisonOps::LT, origin.x + cubeSide)));
-        range_cond->addComparison (FieldComparisonConstPtr (new pcl::FieldComparison<PointT> ("y", pcl::ComparisonOps::GE, origin.y)));
-        range_cond->addComparison (FieldComparisonConstPtr (new pcl::FieldComparison<PointT> ("y", pcl::ComparisonOps::LT, origin.y + cubeSide)));
-        range_cond->addComparison (FieldComparisonConstPtr (new pcl::FieldComparison<PointT> ("z", pcl::ComparisonOps::GE, origin.z)));
-        range_cond->addComparison (FieldComparisonConstPtr (new pcl::FieldComparison<PointT> ("z", pcl::ComparisonOps::LT, origin.z + cubeSide)));
-
-        // build the filter
-        pcl::ConditionalRemoval<PointT> condrem (range_cond);
-        condrem.setInputCloud (world_);
-        condrem.setKeepOrganized(false);
-        // apply filter
-        condrem.filter (*box);
+        // extract the points lying in the cube
+        extractBox (origin.x, origin.y, origin.z, origin.x + cubeSide, origin.y + cubeSide, origin.z + cubeSide, *box);
 
         // also push transform along with points.
         if(box->points.size() > 0)
@@ -253,20 +238,18 @@ void
 pcl::WorldModel<PointT>::getWorldAsCubes (const double size, std::vector<typename pcl::WorldModel<PointT>::PointCloudPtr> &cubes, std::vector<Eigen::Vector3f> &transforms, double overlap, pcl::gpu::StandaloneMarchingCubes<pcl::PointXYZI> & mcubes)
 {
   
-  if(world_->points.size () == 0)
+  if(getWorldSize () == 0)
   {
     PCL_INFO("The world is empty, returning nothing\n");
     return;
   }
 
-  PCL_INFO ("Getting world as cubes. World contains %d points.\n", world_->points.size ());
+  PCL_INFO ("Getting world as cubes. World contains %d points.\n", getWorldSize ());
 
   // remove nans from world cloud
-  world_->is_dense = false;
-  std::vector<int> indices;
-  pcl::removeNaNFromPointCloud	(	*world_, *world_, indices);
+  cleanWorldFromNans ();
 	
-  PCL_INFO ("World contains %d points after nan removal.\n", world_->points.size ());
+  PCL_INFO ("World contains %d points after nan removal.\n", getWorldSize ());
   
 
   // check cube size value
@@ -295,7 +278,7 @@ pcl::WorldModel<PointT>::getWorldAsCubes (const double size, std::vector<typenam
   
   // get world's bounding values on XYZ
   PointT min, max;
-  pcl::getMinMax3D(*world_, min, max);
+  getWorldBounds (min, max);
 
   PCL_INFO ("Bounding box for the world: \n\t [%f - %f] \n\t [%f - %f] \n\t [%f - %f] \n", min.x, max.x, min.y, max.y, min.z, max.z);
 
@@ -323,21 +306,9 @@ pcl::WorldModel<PointT>::getWorldAsCubes (const double size, std::vector<typenam
         PointCloudPtr box (new pcl::PointCloud<PointT>);
 
 
-        // set conditional filter
-        ConditionAndPtr range_cond (new pcl::ConditionAnd<PointT> ());
-        range_cond->addComparison (FieldComparisonConstPtr (new pcl::FieldComparison<PointT> ("x", pcl::ComparisonOps::GE, origin.x - 0.5)));
-        range_cond->addComparison (FieldComparisonConstPtr (new pcl::FieldComparison<PointT> ("x", pcl::ComparisonOps::LT, origin.x + cubeSide - 0.5)));
-        range_cond->addComparison (FieldComparisonConstPtr (new pcl::FieldComparison<PointT> ("y", pcl::ComparisonOps::GE, origin.y - 0.5)));
-        range_cond->addComparison (FieldComparisonConstPtr (new pcl::FieldComparison<PointT> ("y", pcl::ComparisonOps::LT, origin.y + cubeSide - 0.5)));
-        range_cond->addComparison (FieldComparisonConstPtr (new pcl::FieldComparison<PointT> ("z", pcl::ComparisonOps::GE, origin.z - 0.5)));
-        range_cond->addComparison (FieldComparisonConstPtr (new pcl::FieldComparison<PointT> ("z", pcl::ComparisonOps::LT, origin.z + cubeSide - 0.5)));
-
-        // build the filter
-        pcl::ConditionalRemoval<PointT> condrem (range_cond);
-        condrem.setInputCloud (world_);
-        condrem.setKeepOrganized(false);
-        // apply filter
-        condrem.filter (*box);
+        // extract the points lying in the cube
+        extractBox (origin.x - 0.5, origin.y - 0.5, origin.z - 0.5, 
+                    origin.x + cubeSide - 0.5, origin.y + cubeSide - 0.5, origin.z + cubeSide - 0.5, *box);
 
         // also push transform along with points.
         if(box->points.size() > 0)
@@ -358,7 +329,7 @@ pcl::WorldModel<PointT>::getWorldAsCubes (const double size, std::vector<typenam
 			//Get mesh
 			pcl::PointCloud< PointT > * ppbox = &( *box );
 			pcl::PointCloud< pcl::PointXYZI > * pbox = reinterpret_cast < pcl::PointCloud< pcl::PointXYZI > * > ( ppbox );
-			pcl::gpu::StandaloneMarchingCubes<PointT>::MeshPtr tmp = mcubes.getMeshFromTSDFCloud ( * pbox );
+			typename pcl::gpu::StandaloneMarchingCubes<PointT>::MeshPtr tmp = mcubes.getMeshFromTSDFCloud ( * pbox );
 			float cell_size = mcubes.getCellSize();
         
 			if(tmp != 0)
@@ -409,6 +380,195 @@ pcl::WorldModel<PointT>::getWorldAsCubes (const double size, std::vector<typenam
 
 }
 
+template <typename PointT>
+void
+pcl::WorldModel<PointT>::getWorldAsCubeBuckets (const double size, CubeBuckets &buckets, double overlap)
+{
+  // clear returned buckets
+  buckets.transforms.clear ();
+  buckets.offsets.clear ();
+  buckets.points.clear ();
+
+  if(getWorldSize () == 0)
+  {
+    PCL_INFO("The world is empty, returning nothing\n");
+    return;
+  }
+
+  // remove nans from world cloud
+  cleanWorldFromNans ();
+
+  PCL_INFO ("Bucketing world into cubes. World contains %d points after nan removal.\n", getWorldSize ());
+
+  // check cube size value
+  double cubeSide = size;
+  if (cubeSide <= 0.0f)
+  {
+    PCL_ERROR ("Size of the cube must be positive and non null (%f given). Setting it to 3.0 meters.\n", cubeSide);
+    cubeSide = 512.0f;
+  }
+
+  // check overlap value
+  double step_increment = 1.0f - overlap;
+  if (overlap < 0.0)
+  {
+    PCL_ERROR ("Overlap ratio must be positive or null (%f given). Setting it to 0.0 procent.\n", overlap);
+    step_increment = 1.0f;
+  }
+  if (overlap > 1.0)
+  {
+    PCL_ERROR ("Overlap ratio must be less or equal to 1.0 (%f given). Setting it to 10 procent.\n", overlap);
+    step_increment = 0.1f;
+  }
+  const int step = std::max (1, static_cast<int> (cubeSide * step_increment));
+
+  // get world's bounding values on XYZ
+  PointT min, max;
+  getWorldBounds (min, max);
+
+  PCL_INFO ("Bounding box for the world: \n\t [%f - %f] \n\t [%f - %f] \n\t [%f - %f] \n", min.x, max.x, min.y, max.y, min.z, max.z);
+
+  // cube origins and bounds along each axis, computed as in getWorldAsCubes so that the cubes hold the same points
+  const float mins[3] = {min.x, min.y, min.z};
+  const float maxs[3] = {max.x, max.y, max.z};
+  std::vector<float> origins[3];
+  std::vector<double> lower[3], upper[3];
+  for (int a = 0; a < 3; ++a)
+  {
+    for (float origin = mins[a]; origin < maxs[a]; origin += step)
+    {
+      origins[a].push_back (origin);
+      lower[a].push_back (origin - 0.5);
+      upper[a].push_back (origin + cubeSide - 0.5);
+    }
+  }
+
+  const int nb_y = static_cast<int> (origins[1].size ());
+  const int nb_z = static_cast<int> (origins[2].size ());
+  const size_t nb_cubes = origins[0].size () * nb_y * nb_z;
+
+  // count the points of every cube (a point lies in up to 8 cubes with overlap), then fill the pointers in a second pass.
+  // The points are read where the world model stores them, the world is never gathered in a single cloud
+  std::vector<std::pair<const PointT*, size_t> > segments;
+  getWorldSegments (segments);
+  std::vector<size_t> counts (nb_cubes, 0);
+  for (int pass = 0; pass < 2; ++pass)
+  {
+    for (size_t s = 0; s < segments.size (); ++s)
+    {
+      for (size_t i = 0; i < segments[s].second; ++i)
+      {
+        const PointT &point = segments[s].first[i];
+        if (!pcl_isfinite (point.x))
+          continue;
+
+        int begin[3], end[3];
+        findCubes (point.x, lower[0], upper[0], mins[0], step, begin[0], end[0]);
+        findCubes (point.y, lower[1], upper[1], mins[1], step, begin[1], end[1]);
+        findCubes (point.z, lower[2], upper[2], mins[2], step, begin[2], end[2]);
+
+        for (int x = begin[0]; x < end[0]; ++x)
+          for (int y = begin[1]; y < end[1]; ++y)
+            for (int z = begin[2]; z < end[2]; ++z)
+            {
+              const size_t b = (x * nb_y + y) * nb_z + z;
+              if (pass == 0)
+                ++counts[b];
+              else
+                buckets.points[counts[b]++] = &point;
+            }
+      }
+    }
+
+    if (pass == 1)
+      break;
+
+    // keep the non empty cubes in the order of getWorldAsCubes: X, then Y, then Z. counts becomes the write position of each cube
+    size_t total = 0;
+    for (size_t b = 0; b < nb_cubes; ++b)
+    {
+      if (counts[b] == 0)
+        continue;
+
+      const int z = static_cast<int> (b % nb_z);
+      const int y = static_cast<int> ((b / nb_z) % nb_y);
+      const int x = static_cast<int> (b / (nb_z * nb_y));
+
+      buckets.offsets.push_back (total);
+      buckets.transforms.push_back (Eigen::Vector3f (origins[0][x], origins[1][y], origins[2][z]));
+      const size_t count = counts[b];
+      counts[b] = total;
+      total += count;
+    }
+    buckets.offsets.push_back (total);
+    buckets.points.resize (total);
+  }
+
+  PCL_INFO ("Returning %d non empty cubes out of %d (%d points).\n", buckets.size (), nb_cubes, buckets.points.size ());
+}
+
+template <typename PointT>
+typename pcl::WorldModel<PointT>::PointCloudPtr
+pcl::WorldModel<PointT>::CubeBuckets::getCube (const size_t c) const
+{
+  PointCloudPtr cube (new PointCloud);
+  cube->points.resize (offsets[c + 1] - offsets[c]);
+  for (size_t i = offsets[c], k = 0; i < offsets[c + 1]; ++i, ++k)
+    cube->points[k] = *points[i];
+
+  cube->width = static_cast<uint32_t> (cube->points.size ());
+  cube->height = 1;
+  cube->is_dense = true;
+  return (cube);
+}
+
+template <typename PointT>
+void
+pcl::WorldModel<PointT>::findCubes (const double value, const std::vector<double> &lower, const std::vector<double> &upper,
+                                    const double first, const int step, int &begin, int &end)
+{
+  const int nb_cubes = static_cast<int> (lower.size ());
+
+  // last cube starting before the value: estimate, then fix the rounding on the bounds
+  int last = static_cast<int> (floor ((value + 0.5 - first) / step));
+  last = std::max (0, std::min (last, nb_cubes - 1));
+  while (last + 1 < nb_cubes && lower[last + 1] <= value)
+    ++last;
+  while (last >= 0 && lower[last] > value)
+    --last;
+
+  begin = end = last + 1;
+  if (last < 0 || upper[last] <= value)
+    return;
+
+  // the upper bounds are increasing, the previous cubes contain the value as long as they end after it
+  begin = last;
+  while (begin > 0 && upper[begin - 1] > value)
+    --begin;
+}
+
+template <typename PointT>
+void
+pcl::WorldModel<PointT>::extractBox (const double min_x, const double min_y, const double min_z,
+                                     const double max_x, const double max_y, const double max_z, PointCloud &box)
+{
+  // set conditional filter
+  ConditionAndPtr range_cond (new pcl::ConditionAnd<PointT> ());
+  range_cond->addComparison (FieldComparisonConstPtr (new pcl::FieldComparison<PointT> ("x", pcl::ComparisonOps::GE, min_x)));
+  range_cond->addComparison (FieldComparisonConstPtr (new pcl::FieldComparison<PointT> ("x", pcl::ComparisonOps::LT, max_x)));
+  range_cond->addComparison (FieldComparisonConstPtr (new pcl::FieldComparison<PointT> ("y", pcl::ComparisonOps::GE, min_y)));
+  range_cond->addComparison (FieldComparisonConstPtr (new pcl::FieldComparison<PointT> ("y", pcl::ComparisonOps::LT, max_y)));
+  range_cond->addComparison (FieldComparisonConstPtr (new pcl::FieldComparison<PointT> ("z", pcl::ComparisonOps::GE, min_z)));
+  range_cond->addComparison (FieldComparisonConstPtr (new pcl::FieldComparison<PointT> ("z", pcl::ComparisonOps::LT, max_z)));
+
+  // build the filter
+  pcl::ConditionalRemoval<PointT> condrem (range_cond);
+  condrem.setInputCloud (world_);
+  condrem.setKeepOrganized(false);
+  // apply filter
+  condrem.filter (box);
+}
+
 template <typename PointT>
 inline void 
 pcl::WorldModel<PointT>::setIndicesAsNans (PointCloudPtr cloud, IndicesConstPtr indices)
@@ -561,6 +721,104 @@ pcl::WorldModel<PointT>::setSliceAsNans (const double origin_x, const double ori
   
 }
 
+
+template <typename PointT>
+void
+pcl::WorldModel<PointT>::getEnteringSlice (const double previous_origin_x, const double previous_origin_y, const double previous_origin_z, const double offset_x, const double offset_y, const double offset_z, const double volume_x, const double volume_y, const double volume_z, EnteringSlice &slice)
+{
+  const double previous_origins[3] = {previous_origin_x, previous_origin_y, previous_origin_z};
+  const double offsets[3] = {offset_x, offset_y, offset_z};
+  const double volumes[3] = {volume_x, volume_y, volume_z};
+
+  for (int d = 0; d < 3; ++d)
+  {
+    const double new_origin = previous_origins[d] + offsets[d];
+    slice.cube.min[d] = static_cast<float> (new_origin);
+    slice.cube.max[d] = static_cast<float> (new_origin + volumes[d]);
+    slice.origin[d] = static_cast<float> (new_origin);
+
+    // same bounds as the ConditionOr of getExistingData
+    slice.positive[d] = (offsets[d] >= 0);
+    if (slice.positive[d])
+      slice.bounds[d] = static_cast<float> (previous_origins[d] + volumes[d] - 1.0);
+    else
+      slice.bounds[d] = static_cast<float> (previous_origins[d]);
+  }
+}
+
+
+template <typename PointT>
+void
+pcl::WorldModel<PointT>::getEvictedSlice (const double origin_x, const double origin_y, const double origin_z, const double offset_x, const double offset_y, const double offset_z, const int size_x, const int size_y, const int size_z, EvictedSlice &slice)
+{
+  const double previous_origins[3] = {origin_x, origin_y, origin_z};
+  const double offsets[3] = {offset_x, offset_y, offset_z};
+  const int sizes[3] = {size_x, size_y, size_z};
+
+  for (int d = 0; d < 3; ++d)
+  {
+    const double previous_limit = previous_origins[d] + sizes[d] - 1;
+    const double new_origin = previous_origins[d] + offsets[d];
+    const double new_limit = previous_limit + offsets[d];
+
+    // same limits as the three ConditionOr of setSliceAsNans
+    double lower_limit, upper_limit;
+    if (offsets[d] >= 0)
+    {
+      lower_limit = previous_origins[d];
+      upper_limit = new_origin;
+    }
+    else
+    {
+      lower_limit = new_limit;
+      upper_limit = previous_limit;
+    }
+    PCL_DEBUG ("Limit %c: [%f - %f]\n", 'X' + d, lower_limit, upper_limit);
+
+    for (int s = 0; s < 3; ++s)
+    {
+      slice.slabs[s].min[d] = static_cast<float> (s == d ? lower_limit : previous_origins[d]);
+      slice.slabs[s].max[d] = static_cast<float> (s == d ? upper_limit : previous_limit);
+    }
+    slice.bounds.min[d] = static_cast<float> (std::min (lower_limit, previous_origins[d]));
+    slice.bounds.max[d] = static_cast<float> (std::max (upper_limit, previous_limit));
+  }
+}
+
+
+template <typename PointT>
+void
+pcl::WorldModel<PointT>::updateBounds (const PointVector &points, Eigen::Array4f &min, Eigen::Array4f &max)
+{
+  for (size_t i = 0; i < points.size (); ++i)
+  {
+    if (!pcl_isfinite (points[i].x))
+      continue;
+    pcl::Array4fMapConst pt = points[i].getArray4fMap ();
+    min = min.min (pt);
+    max = max.max (pt);
+  }
+}
+
+
+template <typename PointT>
+void
+pcl::WorldModel<PointT>::finishExistingSlice (const EnteringSlice &slice, PointCloud &existing_slice)
+{
+  setAsUnorganized (existing_slice);
+
+  if(existing_slice.points.size () != 0)
+  {
+    //transform the slice in new cube coordinates
+    Eigen::Affine3f transformation;
+    transformation.translation () = slice.origin;
+
+    transformation.linear ().setIdentity ();
+
+    transformPointCloud (existing_slice, existing_slice, transformation.inverse ());
+  }
+}
+
 #define PCL_INSTANTIATE_WorldModel(T) template class PCL_EXPORTS pcl::WorldModel<T>;
 
 #endif // PCL_WORLD_MODEL_IMPL_HPP_
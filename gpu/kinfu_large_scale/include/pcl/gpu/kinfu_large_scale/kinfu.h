@@ -70,6 +70,8 @@
 typedef pcl::PointXYZ PtType;
 typedef pcl::PointCloud<PtType> CloudType;
 PCL_EXPORTS CloudType::Ptr cvMat2PointCloud(const cv::Mat &dmat, const pcl::device::Intr &intr);
+//@brief same as above, but fills an existing cloud so that its storage is reused from frame to frame
+PCL_EXPORTS void cvMat2PointCloud(const cv::Mat &dmat, const pcl::device::Intr &intr, CloudType &cloud);
 
 //ƽ, ȡָ
 //¿ plane_fitter.cpp
@@ -675,6 +677,7 @@ namespace pcl
 		bool integrateWithGtPoses( const DepthMap &depth, const View *pcolor = NULL);
 
 		//ȫ... @2017-4-2 14:30:29
+		//debug output only, they do nothing unless dbgKf_ >= 1
 		void dbgAhcPeac( const DepthMap &depth_raw, const View *pcolor = NULL);
 		void dbgAhcPeac2( const CloudType::Ptr depCloud);
 		void dbgAhcPeac3( const CloudType::Ptr depCloud, PlaneFitter *pf);
@@ -780,6 +783,24 @@ namespace pcl
         {
           return (cyclical_.getBuffer ());
         }
+
+        /** \brief Replace the world model maintained by the cyclical buffer (e.g. by a pcl::BlockWorldModel).
+          * \param[in] world_model the world model backend used to store the shifted slices
+          */
+        void
+        setWorldModel (const pcl::WorldModel<pcl::PointXYZI>::Ptr &world_model)
+        {
+          cyclical_.setWorldModel (world_model);
+        }
+
+        /** \brief Persist the slices shifted out of the volume in the background (see pcl::SliceWriter), NULL to disable it.
+          * \param[in] slice_writer the writer receiving the slices
+          */
+        void
+        setSliceWriter (const pcl::SliceWriter<pcl::PointXYZI>::Ptr &slice_writer)
+        {
+          cyclical_.setSliceWriter (slice_writer);
+        }
         
         /** \brief Extract the world and mesh it.
           */
@@ -0,0 +1,177 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2011, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef PCL_KINFU_PLANE_EXTRACTION_WORKER_H_
+#define PCL_KINFU_PLANE_EXTRACTION_WORKER_H_
+
+#include <pcl/gpu/kinfu_large_scale/kinfu.h>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <vector>
+
+namespace pcl
+{
+  namespace gpu
+  {
+    /** \brief PlaneExtractionWorker runs the AHC plane fitter (PEAC) on depth maps in a background thread, so that
+      * plane extraction overlaps with the tracking of the same frame on the GPU.
+      * Frames are processed in the order of push. Each frame owns a depth map, a point cloud and an RGBDImage that
+      * are allocated once and reused, so no cloud is built per frame.
+      *
+      * Typical use, once per frame:
+      * \code
+      * worker.push (depth_device, intr, frame_index);
+      * kinfu (depth_device);                                    // tracking runs meanwhile
+      * PlaneExtractionWorker::Frame *planes = worker.wait ();
+      * \endcode
+      * \note The frame returned by wait stays valid, and may be modified (e.g. drawn on), until the next call to wait.
+      */
+    class PCL_EXPORTS PlaneExtractionWorker
+    {
+      public:
+
+        typedef boost::shared_ptr<PlaneExtractionWorker> Ptr;
+
+        /** \brief Buffers of one frame, reused from frame to frame. */
+        struct Frame
+        {
+          Frame () : index (-1), cloud (), image (cloud), done (false) {}
+
+          /** \brief index given to push */
+          int index;
+
+          /** \brief host copy of the depth map, in millimeters */
+          cv::Mat depth;
+
+          /** \brief organized cloud of the depth map, in meters */
+          CloudType cloud;
+
+          /** \brief AHC view of cloud */
+          RGBDImage image;
+
+          /** \brief indices of the pixels of each extracted plane */
+          std::vector<std::vector<int> > planes;
+
+          /** \brief color coded segmentation */
+          cv::Mat segmentation;
+
+          /** \brief plane index of each pixel, copied from PlaneFitter::membershipImg */
+          cv::Mat membership;
+
+          /** \brief true once the planes have been extracted */
+          bool done;
+        };
+
+        /** \brief Constructor, starts the worker thread.
+          * \param[in] nb_buffers number of frames that can be pending, plus the one held since the last wait (at least 2)
+          */
+        PlaneExtractionWorker (const int nb_buffers = 2);
+
+        /** \brief Destructor, finishes the pending frames and joins the worker thread. */
+        ~PlaneExtractionWorker ();
+
+        /** \brief Returns the plane fitter, to be configured before the first push. */
+        PlaneFitter&
+        getPlaneFitter () { return (plane_fitter_); }
+
+        /** \brief Download a depth map and queue it for plane extraction.
+          * \param[in] depth depth map on the device, in millimeters
+          * \param[in] intr intrinsics of the depth camera
+          * \param[in] index index of the frame, returned with the planes
+          * \return false if all the buffers are pending or held by the caller, the frame is then dropped
+          */
+        bool
+        push (const KinfuTracker::DepthMap &depth, const pcl::device::Intr &intr, const int index);
+
+        /** \brief Queue a depth map already on the host for plane extraction.
+          * \param[in] depth depth map (CV_16UC1), in millimeters
+          * \param[in] intr intrinsics of the depth camera
+          * \param[in] index index of the frame, returned with the planes
+          * \return false if all the buffers are pending or held by the caller, the frame is then dropped
+          */
+        bool
+        push (const cv::Mat &depth, const pcl::device::Intr &intr, const int index);
+
+        /** \brief Wait for the oldest pushed frame and return its planes, NULL if no frame was pushed.
+          * The frame returned by the previous call is released.
+          */
+        Frame*
+        wait ();
+
+        /** \brief Returns the number of frames pushed and not yet returned by wait. */
+        int
+        getNumberOfPendingFrames () const;
+
+      private:
+
+        /** \brief Returns a free buffer, NULL if all of them are in use. */
+        Frame*
+        acquire ();
+
+        /** \brief Queue a filled buffer. */
+        void
+        enqueue (Frame &frame, const pcl::device::Intr &intr);
+
+        /** \brief Worker thread main loop. */
+        void
+        run ();
+
+        /** \brief buffers, in a ring: pending frames are [head_, head_ + pending_[, in push order */
+        std::vector<boost::shared_ptr<Frame> > frames_;
+        std::vector<pcl::device::Intr> intrinsics_;
+        int head_;
+        int pending_;
+
+        /** \brief buffer returned by the last wait, -1 if none */
+        int held_;
+
+        /** \brief plane fitter, only used by the worker thread once started */
+        PlaneFitter plane_fitter_;
+
+        bool stop_;
+        mutable boost::mutex mutex_;
+        boost::condition_variable queued_;
+        boost::condition_variable processed_;
+        boost::thread thread_;
+    };
+  }
+}
+
+#endif // PCL_KINFU_PLANE_EXTRACTION_WORKER_H_
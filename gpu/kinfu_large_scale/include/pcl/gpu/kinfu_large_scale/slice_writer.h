@@ -0,0 +1,126 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2011, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_SLICE_WRITER_H_
+#define PCL_SLICE_WRITER_H_
+
+#include <pcl/point_cloud.h>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <deque>
+#include <string>
+
+namespace pcl
+{
+  /** \brief SliceWriter persists the slices shifted out of the TSDF volume in a background thread, so that
+    * tracking goes on while they are written to disk.
+    * Each slice is saved as a binary PCD file named prefix + index (6 digits) + ".pcd", in the order of push.
+    * The slices are shared with the caller and must not be modified once pushed.
+    */
+  template <typename PointT>
+  class SliceWriter
+  {
+    public:
+
+      typedef boost::shared_ptr<SliceWriter<PointT> > Ptr;
+      typedef boost::shared_ptr<const SliceWriter<PointT> > ConstPtr;
+
+      typedef pcl::PointCloud<PointT> PointCloud;
+      typedef typename PointCloud::ConstPtr PointCloudConstPtr;
+
+      /** \brief Constructor, starts the writing thread.
+        * \param[in] prefix path and prefix of the written files
+        */
+      SliceWriter (const std::string &prefix = "slice_");
+
+      /** \brief Destructor, writes the queued slices then stops the writing thread. */
+      ~SliceWriter ();
+
+      /** \brief Queue a slice for writing and return immediately.
+        * \param[in] slice the slice to write, it must not be modified afterwards
+        */
+      void push (const PointCloudConstPtr &slice);
+
+      /** \brief Wait until all the queued slices are written. */
+      void flush ();
+
+      /** \brief Returns the number of slices written so far. */
+      size_t getNumberOfWrittenSlices ();
+
+      /** \brief Returns the number of slices waiting to be written. */
+      size_t getNumberOfQueuedSlices ();
+
+    private:
+
+      /** \brief Loop of the writing thread. */
+      void run ();
+
+      /** \brief path and prefix of the written files */
+      std::string prefix_;
+
+      /** \brief slices waiting to be written, with their index */
+      std::deque<std::pair<int, PointCloudConstPtr> > queue_;
+
+      /** \brief index of the next pushed slice */
+      int next_index_;
+
+      /** \brief number of slices written so far */
+      size_t nb_written_;
+
+      /** \brief true while the writing thread writes a slice */
+      bool busy_;
+
+      /** \brief asks the writing thread to stop once the queue is empty */
+      bool stop_;
+
+      /** \brief protects the queue and the counters */
+      boost::mutex mutex_;
+
+      /** \brief signals a new slice or the stop request to the writing thread */
+      boost::condition_variable queue_cond_;
+
+      /** \brief signals flush that a slice was written */
+      boost::condition_variable written_cond_;
+
+      /** \brief writing thread */
+      boost::thread thread_;
+  };
+}
+
+#endif // PCL_SLICE_WRITER_H_
@@ -41,7 +41,6 @@
 //General includes and I/O
 
 #include <iostream>
-#include <unordered_map>
 #include <pcl/io/pcd_io.h>
 #include <pcl/io/ply_io.h>
 #include <pcl/io/vtk_io.h>
@@ -53,6 +52,7 @@
 //Marching cubes includes
 #include <pcl/gpu/kinfu_large_scale/marching_cubes.h>
 #include <pcl/PolygonMesh.h>
+#include <pcl/surface/vertex_welding.h>
 
 #include <pcl/gpu/containers/device_array.h>
 
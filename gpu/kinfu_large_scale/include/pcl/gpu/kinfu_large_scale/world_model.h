@@ -78,6 +78,33 @@ namespace pcl
       
       typedef typename pcl::traits::fieldList<PointT>::type FieldList;
 
+      typedef std::vector<PointT, Eigen::aligned_allocator<PointT> > PointVector;
+
+      /** \brief The world split into cubes by getWorldAsCubeBuckets. Only pointers to the points of every cube, in the storage
+        * of the world model, are kept: getCube builds the point cloud of one cube when it is needed.
+        * \note The buckets are valid until the world model is modified.
+        */
+      struct CubeBuckets
+      {
+        /** \brief position of every non empty cube in world coordinates */
+        std::vector<Eigen::Vector3f> transforms;
+        /** \brief the points of cube c are points[offsets[c]] ... points[offsets[c + 1] - 1] */
+        std::vector<size_t> offsets;
+        /** \brief the points of the world model, grouped by cube */
+        std::vector<const PointT*> points;
+
+        /** \brief Returns the number of non empty cubes. */
+        size_t
+        size () const { return (transforms.size ()); }
+
+        /** \brief Builds the point cloud of cube c. Can be called from several threads at once.
+          * \param[in] c the index of the cube, in [0, size ()[
+          * \return the points of the cube, in world coordinates
+          */
+        PointCloudPtr
+        getCube (const size_t c) const;
+      };
+
       /** \brief Default constructor for the WorldModel.
         */
       WorldModel() : 
@@ -85,10 +112,13 @@ namespace pcl
       {
         world_->is_dense = false;
       }
+
+      /** \brief Destructor. */
+      virtual ~WorldModel () {}
       
       /** \brief Clear the world.
         */
-      void reset()
+      virtual void reset()
       {
         PCL_WARN("Clearing world model");
         world_->points.clear ();
@@ -97,7 +127,7 @@ namespace pcl
       /** \brief Append a new point cloud (slice) to the world.
         * \param[in] new_cloud the point cloud to add to the world
         */
-      void addSlice (const PointCloudPtr new_cloud);
+      virtual void addSlice (const PointCloudPtr new_cloud);
 
 
       /** \brief Retreive existing data from the world model, after a shift
@@ -112,9 +142,9 @@ namespace pcl
         * \param[in] volume_z size of the cube, Z axis, in indices
         * \param[out] existing_slice the extracted point cloud representing the slice
         */
-      void getExistingData(const double previous_origin_x, const double previous_origin_y, const double previous_origin_z,
-                           const double offset_x, const double offset_y, const double offset_z,
-                           const double volume_x, const double volume_y, const double volume_z, pcl::PointCloud<PointT> &existing_slice);
+      virtual void getExistingData(const double previous_origin_x, const double previous_origin_y, const double previous_origin_z,
+                                   const double offset_x, const double offset_y, const double offset_z,
+                                   const double volume_x, const double volume_y, const double volume_z, pcl::PointCloud<PointT> &existing_slice);
       
       /** \brief Give nan values to the slice of the world 
         * \param[in] origin_x global origin of the cube on X axis, before the shift
@@ -127,13 +157,13 @@ namespace pcl
         * \param[in] volume_y size of the cube, Y axis, in indices
         * \param[in] volume_z size of the cube, Z axis, in indices
         */                    
-      void setSliceAsNans (const double origin_x, const double origin_y, const double origin_z,
-                           const double offset_x, const double offset_y, const double offset_z,
-                           const int size_x, const int size_y, const int size_z);            
+      virtual void setSliceAsNans (const double origin_x, const double origin_y, const double origin_z,
+                                   const double offset_x, const double offset_y, const double offset_z,
+                                   const int size_x, const int size_y, const int size_z);            
 
       /** \brief Remove points with nan values from the world.
         */
-      void cleanWorldFromNans () 
+      virtual void cleanWorldFromNans () 
       { 
         world_->is_dense = false;
         std::vector<int> indices; 
@@ -142,14 +172,14 @@ namespace pcl
 
       /** \brief Returns the world as a point cloud.
         */
-      PointCloudPtr getWorld () 
+      virtual PointCloudPtr getWorld () 
       { 
         return (world_); 
       }
       
       /** \brief Returns the number of points contained in the world.
         */      
-      size_t getWorldSize () 
+      virtual size_t getWorldSize () 
       { 
         return (world_->points.size () );
       }
@@ -162,12 +192,177 @@ namespace pcl
         */
       void getWorldAsCubes (double size, std::vector<PointCloudPtr> &cubes, std::vector<Eigen::Vector3f> &transforms, double overlap = 0.0);
       void getWorldAsCubes (double size, std::vector<PointCloudPtr> &cubes, std::vector<Eigen::Vector3f> &transforms, double overlap, pcl::gpu::StandaloneMarchingCubes<pcl::PointXYZI> & mcubes);
+
+      /** \brief Splits the world into cubes, like the meshing overload of getWorldAsCubes, but dispatches the points in two passes over the world
+        * instead of cropping the whole world once per cube. Cubes are laid out from the world minimum with an integer step, each cube covering [origin - 0.5, origin + size - 0.5[.
+        * The cubes are not built: the points are read in place from the storage of the world model (see getWorldSegments), only pointers
+        * to them are kept, and CubeBuckets::getCube builds one cube at a time.
+        * \param[in] size the size of a 3D cube, in indices.
+        * \param[out] buckets the non empty cubes, with their position in world coordinates.
+        * \param[in] overlap optional overlap (in percent) between each cube (usefull to create overlapped meshes).
+        */
+      void getWorldAsCubeBuckets (double size, CubeBuckets &buckets, double overlap = 0.0);
       
-    private:
+    protected:
+
+      /** \brief An axis aligned box [min, max[, tested with the same float comparisons as pcl::FieldComparison. */
+      struct Box
+      {
+        float min[3];
+        float max[3];
+
+        /** \brief Check if a point lies in the box. nan points are never in the box. */
+        inline bool
+        contains (const PointT &point) const
+        {
+          return (point.x >= min[0] && point.x < max[0] &&
+                  point.y >= min[1] && point.y < max[1] &&
+                  point.z >= min[2] && point.z < max[2]);
+        }
+      };
+
+      /** \brief The data of the world entering the cube after a shift: the points of the new cube lying beyond the previous cube on at least one axis. */
+      struct EnteringSlice
+      {
+        /** \brief the new cube */
+        Box cube;
+        /** \brief bound of the previous cube on each axis, on the side of the shift */
+        float bounds[3];
+        /** \brief whether the shift is positive on each axis */
+        bool positive[3];
+        /** \brief origin of the new cube */
+        Eigen::Vector3f origin;
+
+        /** \brief Check if a point of the world enters the cube. */
+        inline bool
+        contains (const PointT &point) const
+        {
+          if (!cube.contains (point))
+            return (false);
+          return ((positive[0] ? point.x >= bounds[0] : point.x < bounds[0]) ||
+                  (positive[1] ? point.y >= bounds[1] : point.y < bounds[1]) ||
+                  (positive[2] ? point.z >= bounds[2] : point.z < bounds[2]));
+        }
+      };
+
+      /** \brief The data of the world leaving the cube during a shift, as the union of one slab per axis. */
+      struct EvictedSlice
+      {
+        /** \brief the slab of each axis, limited to the previous cube on the other axes */
+        Box slabs[3];
+        /** \brief bounding box of the three slabs */
+        Box bounds;
+
+        /** \brief Check if a point of the world leaves the cube. */
+        inline bool
+        contains (const PointT &point) const
+        {
+          return (slabs[0].contains (point) || slabs[1].contains (point) || slabs[2].contains (point));
+        }
+      };
+
+      /** \brief Compute the slice of the world entering the cube after a shift. The parameters are the ones of getExistingData.
+        * \param[out] slice the entering slice
+        */
+      static void
+      getEnteringSlice (const double previous_origin_x, const double previous_origin_y, const double previous_origin_z,
+                        const double offset_x, const double offset_y, const double offset_z,
+                        const double volume_x, const double volume_y, const double volume_z, EnteringSlice &slice);
+
+      /** \brief Compute the slice of the world leaving the cube during a shift. The parameters are the ones of setSliceAsNans.
+        * \param[out] slice the evicted slice
+        */
+      static void
+      getEvictedSlice (const double origin_x, const double origin_y, const double origin_z,
+                       const double offset_x, const double offset_y, const double offset_z,
+                       const int size_x, const int size_y, const int size_z, EvictedSlice &slice);
+
+      /** \brief Append the points lying in a region (a Box, an EnteringSlice or an EvictedSlice) to a cloud.
+        * \param[in] region the region
+        * \param[in] points the points to test
+        * \param[out] cloud the cloud the points of the region are appended to
+        */
+      template <typename Region> static inline void
+      copyPointsIn (const Region &region, const PointVector &points, PointCloud &cloud)
+      {
+        for (size_t i = 0; i < points.size (); ++i)
+          if (region.contains (points[i]))
+            cloud.points.push_back (points[i]);
+      }
+
+      /** \brief Grow a bounding box with the finite points of a vector.
+        * \param[in] points the points
+        * \param[in,out] min the minimum coordinates
+        * \param[in,out] max the maximum coordinates
+        */
+      static void
+      updateBounds (const PointVector &points, Eigen::Array4f &min, Eigen::Array4f &max);
+
+      /** \brief Make an extracted cloud a dense unorganized cloud, holding its points in a single row. */
+      static inline void
+      setAsUnorganized (PointCloud &cloud)
+      {
+        cloud.width = static_cast<uint32_t> (cloud.points.size ());
+        cloud.height = 1;
+        cloud.is_dense = true;
+      }
+
+      /** \brief Finish a slice extracted with an EnteringSlice: set its size and express it in new cube coordinates.
+        * \param[in] slice the entering slice
+        * \param[in,out] existing_slice the points of the world entering the cube
+        */
+      static void
+      finishExistingSlice (const EnteringSlice &slice, PointCloud &existing_slice);
+
+      /** \brief Extract the points of the world lying inside an axis aligned box.
+        * \param[in] min_x lower bound of the box on X axis (inclusive)
+        * \param[in] min_y lower bound of the box on Y axis (inclusive)
+        * \param[in] min_z lower bound of the box on Z axis (inclusive)
+        * \param[in] max_x upper bound of the box on X axis (exclusive)
+        * \param[in] max_y upper bound of the box on Y axis (exclusive)
+        * \param[in] max_z upper bound of the box on Z axis (exclusive)
+        * \param[out] box the points of the world inside the box
+        */
+      virtual void extractBox (const double min_x, const double min_y, const double min_z,
+                               const double max_x, const double max_y, const double max_z, PointCloud &box);
+
+      /** \brief Compute the bounding values of the world on XYZ.
+        * \param[out] min the minimum coordinates of the world
+        * \param[out] max the maximum coordinates of the world
+        */
+      virtual void getWorldBounds (PointT &min, PointT &max)
+      {
+        pcl::getMinMax3D (*world_, min, max);
+      }
+
+      /** \brief Collect the arrays the points of the world are stored in, so that they can be read without gathering the world.
+        * \param[out] segments the first point and the number of points of each array. The arrays may contain nan points.
+        */
+      virtual void getWorldSegments (std::vector<std::pair<const PointT*, size_t> > &segments)
+      {
+        segments.clear ();
+        if (!world_->points.empty ())
+          segments.push_back (std::make_pair (&world_->points[0], world_->points.size ()));
+      }
 
       /** \brief cloud containing our world */
       PointCloudPtr world_;
 
+    private:
+
+      /** \brief Find the cubes of one axis containing a coordinate. The cubes are sorted, cube k covering [lower[k], upper[k][.
+        * \param[in] value the coordinate
+        * \param[in] lower lower bounds of the cubes (inclusive)
+        * \param[in] upper upper bounds of the cubes (exclusive)
+        * \param[in] first origin of the first cube
+        * \param[in] step distance between two cube origins
+        * \param[out] begin first cube containing the value
+        * \param[out] end one past the last cube containing the value (begin == end if there is none)
+        */
+      static void
+      findCubes (const double value, const std::vector<double> &lower, const std::vector<double> &upper,
+                 const double first, const int step, int &begin, int &end);
+
       /** \brief set the points which index is in the indices vector to nan 
         * \param[in] cloud the cloud that contains the point to be set to nan
         * \param[in] indices the vector of indices to set to nan
@@ -1,4 +1,6 @@
 #include "HashSparseMatrix.h"
+#include <algorithm>
+#include <cassert>
 
 
 HashSparseMatrix::HashSparseMatrix( int ioffset, int joffset )
@@ -63,3 +65,203 @@ void HashSparseMatrix::AddHessian( int idx1[], double val1[], int n1, int idx2[]
 		}
 	}
 }
+
+SparseHessianAssembler::SparseHessianAssembler( void )
+{
+	size_ = 0;
+}
+
+SparseHessianAssembler::~SparseHessianAssembler( void )
+{
+}
+
+void SparseHessianAssembler::Init( const std::vector< int > & block_size )
+{
+	int nblocks = ( int )block_size.size();
+	block_size_ = block_size;
+	block_start_.resize( nblocks );
+	size_ = 0;
+	for ( int i = 0; i < nblocks; i++ ) {
+		block_start_[ i ] = size_;
+		size_ += block_size[ i ];
+	}
+	var_block_.resize( size_ );
+	for ( int i = 0; i < nblocks; i++ ) {
+		for ( int k = 0; k < block_size[ i ]; k++ ) {
+			var_block_[ block_start_[ i ] + k ] = i;
+		}
+	}
+	col_blocks_.assign( nblocks, std::vector< int >() );
+	col_offsets_.clear();
+	matrix_.resize( 0, 0 );
+}
+
+void SparseHessianAssembler::MarkBlock( int b1, int b2 )
+{
+	if ( b1 > b2 ) {
+		std::swap( b1, b2 );
+	}
+	// a block column interacts with few block rows, a sorted list keeps the structure proportional to the non zero blocks
+	std::vector< int > & blocks = col_blocks_[ b2 ];
+	std::vector< int >::iterator it = std::lower_bound( blocks.begin(), blocks.end(), b1 );
+	if ( it == blocks.end() || *it != b1 ) {
+		blocks.insert( it, b1 );
+	}
+}
+
+void SparseHessianAssembler::MarkBlocks( const int blocks[], int n )
+{
+	for ( int i = 0; i < n; i++ ) {
+		for ( int j = i; j < n; j++ ) {
+			MarkBlock( blocks[ i ], blocks[ j ] );
+		}
+	}
+}
+
+void SparseHessianAssembler::BuildStructure()
+{
+	int nblocks = ( int )block_size_.size();
+	col_offsets_.resize( nblocks );
+	Eigen::VectorXi nnz( size_ );
+	for ( int b2 = 0; b2 < nblocks; b2++ ) {
+		// the diagonal block is always kept, the pose of the last fragment and the lattice anchor rely on it
+		MarkBlock( b2, b2 );
+		col_offsets_[ b2 ].clear();
+		int offset = 0;
+		for ( int t = 0; t < ( int )col_blocks_[ b2 ].size(); t++ ) {
+			col_offsets_[ b2 ].push_back( offset );
+			offset += block_size_[ col_blocks_[ b2 ][ t ] ];
+		}
+		for ( int k = 0; k < block_size_[ b2 ]; k++ ) {
+			nnz( block_start_[ b2 ] + k ) = offset - block_size_[ b2 ] + k + 1;
+		}
+	}
+
+	matrix_.resize( size_, size_ );
+	matrix_.reserve( nnz );
+	for ( int b2 = 0; b2 < nblocks; b2++ ) {
+		for ( int k = 0; k < block_size_[ b2 ]; k++ ) {
+			int col = block_start_[ b2 ] + k;
+			for ( int t = 0; t < ( int )col_blocks_[ b2 ].size(); t++ ) {
+				int b1 = col_blocks_[ b2 ][ t ];
+				int rows = ( b1 == b2 ) ? k + 1 : block_size_[ b1 ];
+				for ( int r = 0; r < rows; r++ ) {
+					matrix_.insert( block_start_[ b1 ] + r, col ) = 0.0;
+				}
+			}
+		}
+	}
+	matrix_.makeCompressed();
+}
+
+void SparseHessianAssembler::InitAccumulator( Accumulator & acc ) const
+{
+	acc.values_.resize( matrix_.nonZeros() );
+	acc.Jb_.resize( size_ );
+	ClearAccumulator( acc );
+}
+
+void SparseHessianAssembler::ClearAccumulator( Accumulator & acc ) const
+{
+	std::fill( acc.values_.begin(), acc.values_.end(), 0.0 );
+	acc.Jb_.setZero();
+	acc.score_ = 0.0;
+}
+
+void SparseHessianAssembler::AddAccumulator( const Accumulator & src, Accumulator & dst ) const
+{
+	for ( int i = 0; i < ( int )src.values_.size(); i++ ) {
+		dst.values_[ i ] += src.values_[ i ];
+	}
+	dst.Jb_ += src.Jb_;
+	dst.score_ += src.score_;
+}
+
+int SparseHessianAssembler::FindOffset( int b1, int b2 ) const
+{
+	const std::vector< int > & blocks = col_blocks_[ b2 ];
+	std::vector< int >::const_iterator it = std::lower_bound( blocks.begin(), blocks.end(), b1 );
+	assert( it != blocks.end() && *it == b1 );
+	return col_offsets_[ b2 ][ it - blocks.begin() ];
+}
+
+void SparseHessianAssembler::AddRow( const int blocks[], const double val[], int n, double b, Accumulator & acc ) const
+{
+	// a row touches few blocks : merge the duplicated ones (e.g., lattice nodes shared by both points) and sort them
+	const int max_blocks = 32;
+	const int max_vals = 32 * 6;
+	assert( n <= max_blocks );
+	int ub[ max_blocks ];
+	int uoff[ max_blocks ];
+	double uval[ max_vals ];
+	int nu = 0, nval = 0;
+	for ( int p = 0, pos = 0; p < n; pos += block_size_[ blocks[ p ] ], p++ ) {
+		int bs = block_size_[ blocks[ p ] ];
+		int q = 0;
+		while ( q < nu && ub[ q ] != blocks[ p ] ) {
+			q++;
+		}
+		if ( q == nu ) {
+			assert( nval + bs <= max_vals );
+			ub[ nu ] = blocks[ p ];
+			uoff[ nu ] = nval;
+			for ( int k = 0; k < bs; k++ ) {
+				uval[ nval + k ] = val[ pos + k ];
+			}
+			nval += bs;
+			nu++;
+		} else {
+			for ( int k = 0; k < bs; k++ ) {
+				uval[ uoff[ q ] + k ] += val[ pos + k ];
+			}
+		}
+	}
+	for ( int p = 1; p < nu; p++ ) {
+		int bb = ub[ p ], oo = uoff[ p ];
+		int q = p - 1;
+		while ( q >= 0 && ub[ q ] > bb ) {
+			ub[ q + 1 ] = ub[ q ];
+			uoff[ q + 1 ] = uoff[ q ];
+			q--;
+		}
+		ub[ q + 1 ] = bb;
+		uoff[ q + 1 ] = oo;
+	}
+
+	const int * outer = matrix_.outerIndexPtr();
+	double * values = &acc.values_[ 0 ];
+	for ( int q = 0; q < nu; q++ ) {
+		int b2 = ub[ q ];
+		const double * v2 = uval + uoff[ q ];
+		for ( int c = 0; c < block_size_[ b2 ]; c++ ) {
+			acc.Jb_( block_start_[ b2 ] + c ) += b * v2[ c ];
+		}
+		for ( int p = 0; p <= q; p++ ) {
+			int b1 = ub[ p ];
+			const double * v1 = uval + uoff[ p ];
+			int offset = FindOffset( b1, b2 );
+			for ( int c = 0; c < block_size_[ b2 ]; c++ ) {
+				double * slot = values + outer[ block_start_[ b2 ] + c ] + offset;
+				int rows = ( p == q ) ? c + 1 : block_size_[ b1 ];
+				for ( int r = 0; r < rows; r++ ) {
+					slot[ r ] += v1[ r ] * v2[ c ];
+				}
+			}
+		}
+	}
+}
+
+double & SparseHessianAssembler::Coeff( std::vector< double > & values, int i, int j ) const
+{
+	if ( i > j ) {
+		std::swap( i, j );
+	}
+	int b1 = var_block_[ i ];
+	int b2 = var_block_[ j ];
+	return values[ matrix_.outerIndexPtr()[ j ] + FindOffset( b1, b2 ) + i - block_start_[ b1 ] ];
+}
+
+void SparseHessianAssembler::SetValues( const std::vector< double > & values )
+{
+	std::copy( values.begin(), values.end(), matrix_.valuePtr() );
+}
@@ -6,13 +6,13 @@
 #include "Eigen/IterativeLinearSolvers"
 #include "Eigen/CholmodSupport"
 #include "unsupported/Eigen/SparseExtra"
-#include <hash_map>
+#include <boost/unordered_map.hpp>
 #include <vector>
 
 typedef Eigen::Triplet< double > Triplet;
 typedef std::vector< Triplet > TripletVector;
-typedef stdext::hash_map< int, int > HashMap;
-typedef stdext::hash_map< int, int >::const_iterator HashMapIterator;
+typedef boost::unordered_map< int, int > HashMap;
+typedef boost::unordered_map< int, int >::const_iterator HashMapIterator;
 typedef std::pair< int, int > IntPair;
 
 class HashSparseMatrix
@@ -36,3 +36,50 @@ public:
 	void AddJb( int i, double value, double b, Eigen::VectorXd & Jb );
 };
 
+
+// Assembles the upper triangle of J^T J and J^T b for a least square problem whose variables are grouped in blocks
+// (e.g., 6 for a fragment pose, 3 for a control lattice node).
+// The sparse structure is built once from the block pairs that interact, afterwards each iteration only adds values
+// into fixed slots of the compressed column storage, so the symbolic factorization of the matrix can be reused.
+class SparseHessianAssembler
+{
+public:
+	SparseHessianAssembler( void );
+	~SparseHessianAssembler( void );
+
+	// per-thread storage of the values of J^T J (in compressed order), J^T b and the squared residuals
+	struct Accumulator {
+		std::vector< double > values_;
+		Eigen::VectorXd Jb_;
+		double score_;
+	};
+
+public:
+	int size_;
+	std::vector< int > block_start_;
+	std::vector< int > block_size_;
+	std::vector< int > var_block_;
+	std::vector< std::vector< int > > col_blocks_;		// block rows present in each block column, sorted (filled by MarkBlock)
+	std::vector< std::vector< int > > col_offsets_;		// offset of each block row inside the columns of the block column
+	Eigen::SparseMatrix< double > matrix_;
+
+public:
+	// structure
+	void Init( const std::vector< int > & block_size );
+	void MarkBlock( int b1, int b2 );
+	void MarkBlocks( const int blocks[], int n );
+	void BuildStructure();
+
+public:
+	// values
+	void InitAccumulator( Accumulator & acc ) const;
+	void ClearAccumulator( Accumulator & acc ) const;
+	void AddAccumulator( const Accumulator & src, Accumulator & dst ) const;
+	void AddRow( const int blocks[], const double val[], int n, double b, Accumulator & acc ) const;
+	double & Coeff( std::vector< double > & values, int i, int j ) const;
+	void SetValues( const std::vector< double > & values );
+	int NonZeros() const { return ( int )matrix_.nonZeros(); }
+
+private:
+	int FindOffset( int b1, int b2 ) const;
+};
@@ -0,0 +1,358 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2011, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <pcl/gpu/kinfu_large_scale/frame_profiler.h>
+#include <pcl/common/time.h>
+#include <pcl/console/print.h>
+#include <cuda_runtime_api.h>
+#include <algorithm>
+#include <cstdio>
+
+#ifdef _WIN32
+#  define NOMINMAX
+#  include <windows.h>
+#  include <psapi.h>
+#  ifdef _MSC_VER
+#    pragma comment(lib, "psapi.lib")
+#  endif
+#else
+#  include <unistd.h>
+#endif
+
+namespace pcl
+{
+  namespace gpu
+  {
+    FrameProfiler::ScopedStage::ScopedStage (const Stage stage, const int level, const bool device) :
+      stage_ (stage), level_ (level), begin_ (0), device_ (device), active_ (FrameProfiler::instance ().isEnabled ())
+    {
+      if (active_)
+        begin_ = FrameProfiler::instance ().now ();
+    }
+
+    FrameProfiler::ScopedStage::~ScopedStage ()
+    {
+      if (!active_)
+        return;
+      FrameProfiler &profiler = FrameProfiler::instance ();
+      if (device_ && profiler.synchronize_)
+        cudaDeviceSynchronize ();
+      profiler.addEvent (stage_, level_, begin_, profiler.now ());
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    FrameProfiler::ScopedFrame::ScopedFrame (const bool has_data, const int frame) :
+      active_ (has_data && FrameProfiler::instance ().isEnabled ())
+    {
+      if (active_)
+        FrameProfiler::instance ().beginFrame (frame);
+    }
+
+    FrameProfiler::ScopedFrame::~ScopedFrame ()
+    {
+      if (active_)
+        FrameProfiler::instance ().endFrame ();
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    FrameProfiler::FrameProfiler () :
+      enabled_ (false), synchronize_ (true), origin_ (0), current_ (), in_frame_ (false),
+      frames_ (), frames_head_ (0), frames_size_ (0), events_ (), events_head_ (0), events_size_ (0)
+    {
+      setCapacity (4096, 65536);
+    }
+
+    FrameProfiler&
+    FrameProfiler::instance ()
+    {
+      static FrameProfiler profiler;
+      return (profiler);
+    }
+
+    const char*
+    FrameProfiler::getStageName (const int stage)
+    {
+      static const char* names[NB_STAGES] =
+      {
+        "frame", "preprocess", "raycast", "icp", "icp_level", "shift", "integrate", "plane_fitting", "mesh_extraction"
+      };
+      return (stage >= 0 && stage < NB_STAGES ? names[stage] : "unknown");
+    }
+
+    void
+    FrameProfiler::setEnabled (const bool enabled)
+    {
+      if (enabled && !enabled_)
+      {
+        clear ();
+        origin_ = pcl::getTime () * 1e6;
+      }
+      enabled_ = enabled;
+    }
+
+    void
+    FrameProfiler::setCapacity (const size_t max_frames, const size_t max_events)
+    {
+      boost::mutex::scoped_lock lock (mutex_);
+      frames_.resize (std::max<size_t> (max_frames, 1));
+      events_.resize (std::max<size_t> (max_events, 1));
+      frames_head_ = frames_size_ = 0;
+      events_head_ = events_size_ = 0;
+      in_frame_ = false;
+    }
+
+    void
+    FrameProfiler::clear ()
+    {
+      boost::mutex::scoped_lock lock (mutex_);
+      frames_head_ = frames_size_ = 0;
+      events_head_ = events_size_ = 0;
+      in_frame_ = false;
+      threads_.clear ();
+    }
+
+    double
+    FrameProfiler::now () const
+    {
+      return (pcl::getTime () * 1e6 - origin_);
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    void
+    FrameProfiler::beginFrame (const int frame)
+    {
+      boost::mutex::scoped_lock lock (mutex_);
+      current_.frame = frame;
+      current_.duration = 0;
+      std::fill (current_.stage_time, current_.stage_time + NB_STAGES, 0.0);
+      current_.host_memory = current_.device_memory = 0;
+      in_frame_ = true;
+      current_.begin = now ();
+    }
+
+    void
+    FrameProfiler::endFrame ()
+    {
+      if (synchronize_)
+        cudaDeviceSynchronize ();
+      const double end = now ();
+      const size_t host_memory = getHostMemory ();
+      const size_t device_memory = getDeviceMemory ();
+
+      boost::mutex::scoped_lock lock (mutex_);
+      if (!in_frame_)
+        return;
+      in_frame_ = false;
+      current_.duration = end - current_.begin;
+      current_.stage_time[FRAME] = current_.duration;
+      current_.host_memory = host_memory;
+      current_.device_memory = device_memory;
+
+      frames_[(frames_head_ + frames_size_) % frames_.size ()] = current_;
+      if (frames_size_ < frames_.size ())
+        ++frames_size_;
+      else
+        frames_head_ = (frames_head_ + 1) % frames_.size ();
+
+      Event event = { FRAME, -1, current_.frame, getThreadIndex (), current_.begin, current_.duration };
+      events_[(events_head_ + events_size_) % events_.size ()] = event;
+      if (events_size_ < events_.size ())
+        ++events_size_;
+      else
+        events_head_ = (events_head_ + 1) % events_.size ();
+    }
+
+    void
+    FrameProfiler::addEvent (const Stage stage, const int level, const double begin, const double end)
+    {
+      boost::mutex::scoped_lock lock (mutex_);
+      Event event = { stage, level, in_frame_ ? current_.frame : -1, getThreadIndex (), begin, end - begin };
+      events_[(events_head_ + events_size_) % events_.size ()] = event;
+      if (events_size_ < events_.size ())
+        ++events_size_;
+      else
+        events_head_ = (events_head_ + 1) % events_.size ();
+
+      if (in_frame_)
+        current_.stage_time[stage] += end - begin;
+    }
+
+    int
+    FrameProfiler::getThreadIndex ()
+    {
+      std::map<boost::thread::id, int>::const_iterator it = threads_.find (boost::this_thread::get_id ());
+      if (it != threads_.end ())
+        return (it->second);
+      const int index = static_cast<int> (threads_.size ());
+      threads_[boost::this_thread::get_id ()] = index;
+      return (index);
+    }
+
+    size_t
+    FrameProfiler::getNumberOfFrames () const
+    {
+      boost::mutex::scoped_lock lock (mutex_);
+      return (frames_size_);
+    }
+
+    size_t
+    FrameProfiler::getNumberOfEvents () const
+    {
+      boost::mutex::scoped_lock lock (mutex_);
+      return (events_size_);
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    template <typename T> void
+    FrameProfiler::unroll (const std::vector<T> &ring, const size_t head, const size_t size, std::vector<T> &out)
+    {
+      out.resize (size);
+      for (size_t i = 0; i < size; ++i)
+        out[i] = ring[(head + i) % ring.size ()];
+    }
+
+    bool
+    FrameProfiler::saveCSV (const std::string &filename) const
+    {
+      std::vector<FrameRecord> frames;
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        unroll (frames_, frames_head_, frames_size_, frames);
+      }
+
+      FILE *f = fopen (filename.c_str (), "w");
+      if (f == NULL)
+      {
+        PCL_ERROR ("[pcl::gpu::FrameProfiler::saveCSV] Could not open %s for writing.\n", filename.c_str ());
+        return (false);
+      }
+
+      fprintf (f, "frame,begin_ms");
+      for (int s = 0; s < NB_STAGES; ++s)
+        fprintf (f, ",%s_ms", getStageName (s));
+      fprintf (f, ",host_mb,device_mb\n");
+
+      for (size_t i = 0; i < frames.size (); ++i)
+      {
+        fprintf (f, "%d,%.3f", frames[i].frame, frames[i].begin * 1e-3);
+        for (int s = 0; s < NB_STAGES; ++s)
+          fprintf (f, ",%.3f", frames[i].stage_time[s] * 1e-3);
+        fprintf (f, ",%.1f,%.1f\n", frames[i].host_memory / 1048576.0, frames[i].device_memory / 1048576.0);
+      }
+
+      fclose (f);
+      PCL_INFO ("[pcl::gpu::FrameProfiler::saveCSV] %d frames written to %s.\n", static_cast<int> (frames.size ()), filename.c_str ());
+      return (true);
+    }
+
+    bool
+    FrameProfiler::saveChromeTrace (const std::string &filename) const
+    {
+      std::vector<FrameRecord> frames;
+      std::vector<Event> events;
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        unroll (frames_, frames_head_, frames_size_, frames);
+        unroll (events_, events_head_, events_size_, events);
+      }
+
+      FILE *f = fopen (filename.c_str (), "w");
+      if (f == NULL)
+      {
+        PCL_ERROR ("[pcl::gpu::FrameProfiler::saveChromeTrace] Could not open %s for writing.\n", filename.c_str ());
+        return (false);
+      }
+
+      fprintf (f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+      bool first = true;
+      for (size_t i = 0; i < events.size (); ++i, first = false)
+      {
+        const Event &e = events[i];
+        fprintf (f, "%s{\"name\":\"%s\",\"cat\":\"kinfu\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.1f,\"dur\":%.1f,\"args\":{\"frame\":%d",
+                 first ? "" : ",\n", getStageName (e.stage), e.thread, e.begin, e.duration, e.frame);
+        if (e.level >= 0)
+          fprintf (f, ",\"level\":%d", e.level);
+        fprintf (f, "}}");
+      }
+      for (size_t i = 0; i < frames.size (); ++i, first = false)
+        fprintf (f, "%s{\"name\":\"memory\",\"cat\":\"kinfu\",\"ph\":\"C\",\"pid\":0,\"ts\":%.1f,\"args\":{\"host_mb\":%.1f,\"device_mb\":%.1f}}",
+                 first ? "" : ",\n", frames[i].begin + frames[i].duration,
+                 frames[i].host_memory / 1048576.0, frames[i].device_memory / 1048576.0);
+      fprintf (f, "\n]}\n");
+
+      fclose (f);
+      PCL_INFO ("[pcl::gpu::FrameProfiler::saveChromeTrace] %d events written to %s.\n", static_cast<int> (events.size ()), filename.c_str ());
+      return (true);
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    size_t
+    FrameProfiler::getHostMemory ()
+    {
+#ifdef _WIN32
+      PROCESS_MEMORY_COUNTERS counters;
+      if (GetProcessMemoryInfo (GetCurrentProcess (), &counters, sizeof (counters)))
+        return (counters.WorkingSetSize);
+      return (0);
+#else
+      long pages = 0, resident = 0;
+      FILE *f = fopen ("/proc/self/statm", "r");
+      if (f == NULL)
+        return (0);
+      if (fscanf (f, "%ld %ld", &pages, &resident) != 2)
+        resident = 0;
+      fclose (f);
+      return (static_cast<size_t> (resident) * static_cast<size_t> (sysconf (_SC_PAGESIZE)));
+#endif
+    }
+
+    size_t
+    FrameProfiler::getDeviceMemory ()
+    {
+      size_t free_memory = 0, total_memory = 0;
+      if (cudaMemGetInfo (&free_memory, &total_memory) != cudaSuccess)
+        return (0);
+      return (total_memory - free_memory);
+    }
+  }
+}
@@ -42,6 +42,7 @@
 #include <pcl/kdtree/kdtree_flann.h>
 #include <pcl/common/time.h>
 #include <pcl/gpu/kinfu_large_scale/kinfu.h>
+#include <pcl/gpu/kinfu_large_scale/frame_profiler.h>
 #include "internal.h"
 
 #include <Eigen/Core>
@@ -120,43 +121,43 @@ namespace zc{
 
 
 //////////////////////////////
-CloudType::Ptr cvMat2PointCloud(const cv::Mat &dmat, const pcl::device::Intr &intr){
+void cvMat2PointCloud(const cv::Mat &dmat, const pcl::device::Intr &intr, CloudType &cloud){
 	CV_Assert(dmat.type() == CV_16UC1);
 
-	int imWidth = dmat.cols,
+	const int imWidth = dmat.cols,
 		imHeight = dmat.rows;
 
-	//صĵ:
-	CloudType::Ptr pCloud(new CloudType);
-	pCloud->points.reserve(imWidth * imHeight); //ע:  resize,  push_back,  "[]"
+	//resize keeps the storage of a cloud that is reused from frame to frame
+	cloud.points.resize(imWidth * imHeight);
+	cloud.width = imWidth;
+	cloud.height = imHeight;
 
-	float fx_inv = 1 / intr.fx,
+	const float fx_inv = 1 / intr.fx,
 		fy_inv = 1 / intr.fy;
 	const float mm2m = 0.001;
 	const float qnan = numeric_limits<float>::quiet_NaN ();
 
-	ushort *pDat = (ushort*)dmat.data;
 	for(int i = 0; i < imHeight; i++){
-		for(int j = 0; j < imWidth; j++){
-			PtType pt;
-			ushort z = *pDat;
-			if(0 == z){ //ֵ cloud Ӧ nan! !
-				pt.x = pt.y = pt.z = qnan;
+		const ushort *pDat = dmat.ptr<ushort>(i);
+		PtType *pPt = &cloud.points[i * imWidth];
+		const float y_scale = (i - intr.cy) * fy_inv;
+		for(int j = 0; j < imWidth; j++, ++pDat, ++pPt){
+			const ushort z = *pDat;
+			if(0 == z){ //a zero depth is a missing measurement, it must be nan in the cloud
+				pPt->x = pPt->y = pPt->z = qnan;
 			}
 			else{
-				pt.z = z * mm2m; //ת(m)߶
-				pt.x = pt.z * (j - intr.cx) * fx_inv;
-				pt.y = pt.z * (i - intr.cy) * fy_inv;
+				pPt->z = z * mm2m; //meters
+				pPt->x = pPt->z * (j - intr.cx) * fx_inv;
+				pPt->y = pPt->z * y_scale;
 			}
-			pCloud->push_back(pt);
-
-			++pDat;
 		}
 	}
+}//cvMat2PointCloud
 
-	pCloud->width = imWidth; //ʾ, , Ϊ push_back 趨
-	pCloud->height = imHeight;
-
+CloudType::Ptr cvMat2PointCloud(const cv::Mat &dmat, const pcl::device::Intr &intr){
+	CloudType::Ptr pCloud(new CloudType);
+	cvMat2PointCloud(dmat, intr, *pCloud);
 	return pCloud;
 }//cvMat2PointCloud
 
@@ -712,6 +713,7 @@ int
 void
 	pcl::gpu::KinfuTracker::extractAndMeshWorld ()
 {
+	KINFU_PROFILE_STAGE (MESH_EXTRACTION);
 	finished_ = true;
 	int cloud_size = 0;
 	cloud_size = cyclical_.getWorldModel ()->getWorld ()->points.size();
@@ -856,6 +858,7 @@ bool
 	else
 	{
 		//ScopeTime time(">>> Bilateral, pyr-down-all, create-maps-all");
+		KINFU_PROFILE_STAGE (PREPROCESS);
 		//depth_raw.copyTo(depths_curr_[0]);
 		device::bilateralFilter (depth_raw, depths_curr_[0]);
 
@@ -999,6 +1002,7 @@ bool
 	/*Mat33& device_Rcurr = device_cast<Mat33> (Rcurr);*/
 	{          
 		//ScopeTime time( ">>> raycast" );
+		KINFU_PROFILE_STAGE (RAYCAST);
 		//device::sync();
 		//raycast (intr, device_cam_rot_local_prev, device_cam_trans_local_prev, tsdf_volume_->getTsdfTruncDist (), device_volume_size, tsdf_volume_->data (), getCyclicalBufferStructure (), vmaps_g_prev_[0], nmaps_g_prev_[0]);    
 		//device::sync();
@@ -1064,8 +1068,10 @@ bool
 	else
 	{
 		//ScopeTime time(">>> icp-all");
+		KINFU_PROFILE_STAGE (ICP);
 		for (int level_index = LEVELS-1; level_index>=0; --level_index)
 		{
+			KINFU_PROFILE_LEVEL (ICP_LEVEL, level_index);
 			int iter_num = icp_iterations_[level_index];
 
 			// current maps
@@ -1394,6 +1400,7 @@ bool
 		if ( frame_ptr != NULL && ( frame_ptr->flag_ & frame_ptr->IgnoreIntegrationFlag ) ) {
 		} else {
 			//ScopeTime time( ">>> integrate" );
+			KINFU_PROFILE_STAGE (INTEGRATE);
 			//device::sync();
 			//integrateTsdfVolume (depth_raw, intr, device_volume_size, device_cam_rot_local_curr_inv, device_cam_trans_local_curr, tsdf_volume_->getTsdfTruncDist (), tsdf_volume_->data (), getCyclicalBufferStructure (), depthRawScaled_);
 			//device::sync();
@@ -2288,6 +2295,7 @@ pcl::gpu::KinfuTracker::cuOdometry( const DepthMap &depth_raw, const View *pcolo
 	cv::Mat dcurrFiltHost(depth_raw.rows(), depth_raw.cols(), CV_16UC1);
 	DepthMap depthPlFilt;
 	{
+	KINFU_PROFILE_STAGE (PREPROCESS);
 	ScopeTime time(">>> Bilateral, pyr-down-all, create-maps-all"); //release  ~12ms
 	device::bilateralFilter (depth_raw, depths_curr_[0]);
 	
@@ -2787,6 +2795,7 @@ pcl::gpu::KinfuTracker::cuOdometry( const DepthMap &depth_raw, const View *pcolo
 	// Ray casting //icp ֮ǰ,  bdrOdometry , ԭ kinfu ͬ @2017-4-5 17:10:59
 	{
 	//ScopeTime time("ray-cast-all"); //11ms, ô? @2018-3-26 00:58:34
+	KINFU_PROFILE_STAGE (RAYCAST);
 	tt1.tic();
 	raycast (intr, device_Rprev, device_tprev, tsdf_volume_->getTsdfTruncDist(), device_volume_size, tsdf_volume_->data(), getCyclicalBufferStructure(), vmaps_g_prev_[0], nmaps_g_prev_[0]);
 	printf("raycast-orig "); tt1.toc_print(); //0ms
@@ -2816,6 +2825,7 @@ pcl::gpu::KinfuTracker::cuOdometry( const DepthMap &depth_raw, const View *pcolo
 	{
         tt1.tic();
 	ScopeTime time(">>> icp-all");
+	KINFU_PROFILE_STAGE (ICP);
 	bool doLvlIterBreak = false;
 
 	if(dbgKf_ > 1){ //icp-loop, 
@@ -2854,6 +2864,7 @@ pcl::gpu::KinfuTracker::cuOdometry( const DepthMap &depth_raw, const View *pcolo
 		;
 
 	for (int level_index = LEVELS-1; level_index>=0; --level_index){
+		KINFU_PROFILE_LEVEL (ICP_LEVEL, level_index);
 		int iter_num = icp_iterations_[level_index];
 
 		// current maps
@@ -3482,6 +3493,7 @@ pcl::gpu::KinfuTracker::cuOdometry( const DepthMap &depth_raw, const View *pcolo
 	if (integrate)
 	{
 		ScopeTime time("if-integrate");
+		KINFU_PROFILE_STAGE (INTEGRATE);
 
 		//ScopeTime time("tsdf");
 		//integrateTsdfVolume(depth_raw, intr, device_volume_size, device_Rcurr_inv, device_tcurr, tranc_dist, volume_);
@@ -4581,6 +4593,10 @@ bool pcl::gpu::KinfuTracker::integrateWithGtPoses( const DepthMap &depth_raw, co
 }//integrateWithGtPoses
 
 void pcl::gpu::KinfuTracker::dbgAhcPeac( const DepthMap &depth_raw, const View *pcolor /*= NULL*/){
+	//the cloud and the segmentation are only built for the debug output
+	if(dbgKf_ < 1)
+		return;
+
 	//device::Intr intr (fx_, fy_, cx_, cy_, max_integrate_distance_);
 	pcl::device::Intr intr(529.22, 528.98, 313.77, 254.10, 5.0);
 
@@ -4603,6 +4619,9 @@ void pcl::gpu::KinfuTracker::dbgAhcPeac( const DepthMap &depth_raw, const View *
 }//dbgAhcPeac
 
 void pcl::gpu::KinfuTracker::dbgAhcPeac2( const CloudType::Ptr depCloud){
+	if(dbgKf_ < 1)
+		return;
+
 	RGBDImage rgbdObj(*depCloud);
 	cv::Mat dbgSegMat(depCloud->height, depCloud->width, CV_8UC3); //ָӻ
 	vector<vector<int>> idxss;
@@ -4616,6 +4635,9 @@ void pcl::gpu::KinfuTracker::dbgAhcPeac2( const CloudType::Ptr depCloud){
 }//dbgAhcPeac2
 
 void pcl::gpu::KinfuTracker::dbgAhcPeac3( const CloudType::Ptr depCloud, PlaneFitter *pf){
+	if(dbgKf_ < 1)
+		return;
+
 	RGBDImage rgbdObj(*depCloud);
 	cv::Mat dbgSegMat(depCloud->height, depCloud->width, CV_8UC3); //ָӻ
 	vector<vector<int>> idxss;
@@ -4628,6 +4650,9 @@ void pcl::gpu::KinfuTracker::dbgAhcPeac3( const CloudType::Ptr depCloud, PlaneFi
 }//dbgAhcPeac3
 
 void pcl::gpu::KinfuTracker::dbgAhcPeac4( const RGBDImage *rgbdObj, PlaneFitter *pf){
+	if(dbgKf_ < 1)
+		return;
+
 	cv::Mat dbgSegMat(rgbdObj->height(), rgbdObj->width(), CV_8UC3); //ָӻ
 	vector<vector<int>> idxss;
 
@@ -4650,6 +4675,9 @@ void dbgAhcPeac5( const RGBDImage *rgbdObj, PlaneFitter *pf){
 }//dbgAhcPeac5
 
 void pcl::gpu::KinfuTracker::dbgAhcPeac5( const RGBDImage *rgbdObj, PlaneFitter *pf){
+	if(dbgKf_ < 1)
+		return;
+
 	::dbgAhcPeac5( rgbdObj, pf);
 }//dbgAhcPeac5
 
@@ -5439,206 +5467,193 @@ void pcl::gpu::KinfuTracker::OptimizeSLAC()
 		{
 			//pcl::ScopeTime ttime( "Neat Optimization" );
 
-			Eigen::SparseMatrix< double > baseJJ( matrix_size, matrix_size );
-			TripletVector tri;
-			HashSparseMatrix mat( 6 * num, 6 * num );
+			// one block of 6 variables per fragment pose, one block of 3 variables per control lattice node
+			// the lattice nodes of the points never change, so the structure of J^T J is built once
+			std::vector< int > block_size( num, 6 );
+			block_size.resize( num + nper / 3, 3 );
+			SparseHessianAssembler assembler;
+			assembler.Init( block_size );
 			for ( int i = 0; i <= resolution; i++ ) {
 				for ( int j = 0; j <= resolution; j++ ) {
 					for ( int k = 0; k <= resolution; k++ ) {
-						int idx[ 2 ] = { grid_.GetIndex( i, j, k ) * 3, 0 };
-						double val[ 2 ] = { 1, -1 };
+						int node = num + grid_.GetIndex( i, j, k );
+						if ( i < resolution ) {
+							assembler.MarkBlock( node, num + grid_.GetIndex( i + 1, j, k ) );
+						}
+						if ( j < resolution ) {
+							assembler.MarkBlock( node, num + grid_.GetIndex( i, j + 1, k ) );
+						}
+						if ( k < resolution ) {
+							assembler.MarkBlock( node, num + grid_.GetIndex( i, j, k + 1 ) );
+						}
+					}
+				}
+			}
+			for ( int l = 0; l < ( int )corres.size(); l++ ) {
+				int i = corres[ l ]->idx0_;
+				int j = corres[ l ]->idx1_;
+				int blocks[ 18 ] = { i, j };
+				for ( int k = 0; k < ( int )corres[ l ]->corres_.size(); k++ ) {
+					SLACPoint & pi = fragments[ i ]->points_[ corres[ l ]->corres_[ k ].first ];
+					SLACPoint & pj = fragments[ j ]->points_[ corres[ l ]->corres_[ k ].second ];
+					for ( int ll = 0; ll < 8; ll++ ) {
+						blocks[ 2 + ll ] = num + pi.idx_[ ll ] / 3;
+						blocks[ 10 + ll ] = num + pj.idx_[ ll ] / 3;
+					}
+					assembler.MarkBlocks( blocks, 18 );
+				}
+			}
+			assembler.BuildStructure();
+
+			// regularizer part of J^T J, identical for all iterations
+			SparseHessianAssembler::Accumulator base;
+			assembler.InitAccumulator( base );
+			for ( int i = 0; i <= resolution; i++ ) {
+				for ( int j = 0; j <= resolution; j++ ) {
+					for ( int k = 0; k <= resolution; k++ ) {
+						int blocks[ 2 ] = { num + grid_.GetIndex( i, j, k ), 0 };
+						std::vector< int > nbrs;
 						if ( i > 0 ) {
-							idx[ 1 ] = grid_.GetIndex( i - 1, j, k ) * 3;
-							mat.AddHessian2( idx, val, tri );
+							nbrs.push_back( num + grid_.GetIndex( i - 1, j, k ) );
 						}
 						if ( i < resolution ) {
-							idx[ 1 ] = grid_.GetIndex( i + 1, j, k ) * 3;
-							mat.AddHessian2( idx, val, tri );
+							nbrs.push_back( num + grid_.GetIndex( i + 1, j, k ) );
 						}
 						if ( j > 0 ) {
-							idx[ 1 ] = grid_.GetIndex( i, j - 1, k ) * 3;
-							mat.AddHessian2( idx, val, tri );
+							nbrs.push_back( num + grid_.GetIndex( i, j - 1, k ) );
 						}
 						if ( j < resolution ) {
-							idx[ 1 ] = grid_.GetIndex( i, j + 1, k ) * 3;
-							mat.AddHessian2( idx, val, tri );
+							nbrs.push_back( num + grid_.GetIndex( i, j + 1, k ) );
 						}
 						if ( k > 0 ) {
-							idx[ 1 ] = grid_.GetIndex( i, j, k - 1 ) * 3;
-							mat.AddHessian2( idx, val, tri );
+							nbrs.push_back( num + grid_.GetIndex( i, j, k - 1 ) );
 						}
 						if ( k < resolution ) {
-							idx[ 1 ] = grid_.GetIndex( i, j, k + 1 ) * 3;
-							mat.AddHessian2( idx, val, tri );
+							nbrs.push_back( num + grid_.GetIndex( i, j, k + 1 ) );
+						}
+						for ( int t = 0; t < ( int )nbrs.size(); t++ ) {
+							blocks[ 1 ] = nbrs[ t ];
+							for ( int xyz = 0; xyz < 3; xyz++ ) {
+								double val[ 6 ] = { 0, 0, 0, 0, 0, 0 };
+								val[ xyz ] = 1;
+								val[ 3 + xyz ] = -1;
+								assembler.AddRow( blocks, val, 2, 0.0, base );
+							}
 						}
 					}
 				}
 			}
 
-			int base_anchor = grid_.GetIndex( resolution / 2, resolution / 2, 0 ) * 3;
+			int base_anchor = 6 * num + grid_.GetIndex( resolution / 2, resolution / 2, 0 ) * 3;
+
+			assembler.Coeff( base.values_, base_anchor + 0, base_anchor + 0 ) += 1;
+			assembler.Coeff( base.values_, base_anchor + 1, base_anchor + 1 ) += 1;
+			assembler.Coeff( base.values_, base_anchor + 2, base_anchor + 2 ) += 1;
 
-			mat.Add( base_anchor + 0, base_anchor + 0, 1, tri );
-			mat.Add( base_anchor + 1, base_anchor + 1, 1, tri );
-			mat.Add( base_anchor + 2, base_anchor + 2, 1, tri );
+			for ( int i = 0; i < ( int )base.values_.size(); i++ ) {
+				base.values_[ i ] *= default_weight;
+			}
 
-			baseJJ.setFromTriplets( tri.begin(), tri.end() );
+			assembler.Coeff( base.values_, 6 * num - 6, 6 * num - 6 ) += 1.0;
+			assembler.Coeff( base.values_, 6 * num - 5, 6 * num - 5 ) += 1.0;
+			assembler.Coeff( base.values_, 6 * num - 4, 6 * num - 4 ) += 1.0;
+			assembler.Coeff( base.values_, 6 * num - 3, 6 * num - 3 ) += 1.0;
+			assembler.Coeff( base.values_, 6 * num - 2, 6 * num - 2 ) += 1.0;
+			assembler.Coeff( base.values_, 6 * num - 1, 6 * num - 1 ) += 1.0;
 
-			baseJJ *= default_weight;
+			// the pattern does not change between iterations, only the numerical factorization is redone
+			Eigen::CholmodSupernodalLLT< Eigen::SparseMatrix< double >, Eigen::Upper > solver;
+			//Eigen::ConjugateGradient< SparseMatrix, Eigen::Upper > solver;
+			assembler.SetValues( base.values_ );
+			solver.analyzePattern( assembler.matrix_ );
 
 			for ( int itr = 0; itr < max_iteration; itr++ ) {
-				Eigen::VectorXd thisJb( matrix_size );
-				Eigen::MatrixXd thisJJ( baseJJ.triangularView< Eigen::Upper >() );
+				SparseHessianAssembler::Accumulator total( base );
+				Eigen::VectorXd thisJb;
 				Eigen::VectorXd result;
 
-				thisJJ( 6 * num - 6, 6 * num - 6 ) += 1.0;
-				thisJJ( 6 * num - 5, 6 * num - 5 ) += 1.0;
-				thisJJ( 6 * num - 4, 6 * num - 4 ) += 1.0;
-				thisJJ( 6 * num - 3, 6 * num - 3 ) += 1.0;
-				thisJJ( 6 * num - 2, 6 * num - 2 ) += 1.0;
-				thisJJ( 6 * num - 1, 6 * num - 1 ) += 1.0;
-
-				thisJb.setZero();
-
-				double thisscore = 0.0;
 				int nprocessed = 0;
 
-#pragma omp parallel for num_threads( 6 ) schedule( dynamic )
-				for ( int l = 0; l < ( int )corres.size(); l++ ) {
-					int i = corres[ l ]->idx0_;
-					int j = corres[ l ]->idx1_;
-					const int buck_size = 12 + 24 * 2;
-					int idx[ buck_size ];
-					double val[ buck_size ];
-					double b;
-					double score = 0.0;
-					Eigen::MatrixXd tempJJ( matrix_size, matrix_size );
-					tempJJ.setZero();
-					Eigen::VectorXd tempJb( matrix_size );
-					tempJb.setZero();
-
-					for ( int k = 0; k < ( int )corres[ l ]->corres_.size(); k++ ) {
-						int ii = corres[ l ]->corres_[ k ].first;
-						int jj = corres[ l ]->corres_[ k ].second;
-						SLACPoint & pi = fragments[ i ]->points_[ ii ];
-						SLACPoint & pj = fragments[ j ]->points_[ jj ];
-						Eigen::Vector3d ppi( pi.p_[ 0 ], pi.p_[ 1 ], pi.p_[ 2 ] );
-						Eigen::Vector3d ppj( pj.p_[ 0 ], pj.p_[ 1 ], pj.p_[ 2 ] );
-						Eigen::Vector3d npi( pi.n_[ 0 ], pi.n_[ 1 ], pi.n_[ 2 ] );
-						Eigen::Vector3d npj( pj.n_[ 0 ], pj.n_[ 1 ], pj.n_[ 2 ] );
-						Eigen::Vector3d diff = ppi - ppj;
-						b = diff.dot( npi );
-						score += b * b;
-
-						//if ( score > 1 || _isnan( score ) ) {
-						//	if ( fragments[ i ]->IsValidPoint( ii ) && fragments[ j ]->IsValidPoint( jj ) ) {
-						//		cout << npj << endl;
-						//		cout << fragments[ j ]->points_[ jj ].n_[ 0 ] << endl;
-						//		cout << fragments[ j ]->points_[ jj ].n_[ 1 ] << endl;
-						//		cout << fragments[ j ]->points_[ jj ].n_[ 2 ] << endl;
-						//		cout << _isnan( fragments[ j ]->points_[ jj ].n_[ 0 ] ) << endl;
-
-						//	}
-						//	cout << l << endl;
-						//	cout << i << "-" << ii << endl;
-						//	cout << j << "-" << jj << endl;
-						//	cout << npi << endl << npj << endl;
-						//	cout << ppi << endl << ppj << endl << b << endl << score << endl << endl;
-						//}
-
-						idx[ 0 ] = i * 6;
-						idx[ 1 ] = i * 6 + 1;
-						idx[ 2 ] = i * 6 + 2;
-						idx[ 3 ] = i * 6 + 3;
-						idx[ 4 ] = i * 6 + 4;
-						idx[ 5 ] = i * 6 + 5;
-						idx[ 6 ] = j * 6;
-						idx[ 7 ] = j * 6 + 1;
-						idx[ 8 ] = j * 6 + 2;
-						idx[ 9 ] = j * 6 + 3;
-						idx[ 10 ] = j * 6 + 4;
-						idx[ 11 ] = j * 6 + 5;
-
-						Eigen::Vector3d temp = ppj.cross( npi );
-
-						val[ 0 ] = temp( 0 );
-						val[ 1 ] = temp( 1 );
-						val[ 2 ] = temp( 2 );
-						val[ 3 ] = npi( 0 );
-						val[ 4 ] = npi( 1 );
-						val[ 5 ] = npi( 2 );
-						val[ 6 ] = -temp( 0 );
-						val[ 7 ] = -temp( 1 );
-						val[ 8 ] = -temp( 2 );
-						val[ 9 ] = -npi( 0 );
-						val[ 10 ] = -npi( 1 );
-						val[ 11 ] = -npi( 2 );
-
-						// next part of Jacobian
-						// deal with control lattices
-						Eigen::Vector3d dTi = pose_rot_t[ i ] * npi;
-						Eigen::Vector3d dTj = - pose_rot_t[ j ] * npi;
-
-						for ( int ll = 0; ll < 8; ll++ ) {
-							for ( int xyz = 0; xyz < 3; xyz++ ) {
-								idx[ 12 + ll * 3 + xyz ] = 6 * num + pi.idx_[ ll ] + xyz;
-								val[ 12 + ll * 3 + xyz ] = pi.val_[ ll ] * dTi( xyz );
+#pragma omp parallel num_threads( 6 )
+				{
+					SparseHessianAssembler::Accumulator acc;
+					assembler.InitAccumulator( acc );
+
+#pragma omp for schedule( dynamic )
+					for ( int l = 0; l < ( int )corres.size(); l++ ) {
+						int i = corres[ l ]->idx0_;
+						int j = corres[ l ]->idx1_;
+						const int buck_size = 12 + 24 * 2;
+						int blocks[ 18 ] = { i, j };
+						double val[ buck_size ];
+						double b;
+
+						for ( int k = 0; k < ( int )corres[ l ]->corres_.size(); k++ ) {
+							int ii = corres[ l ]->corres_[ k ].first;
+							int jj = corres[ l ]->corres_[ k ].second;
+							SLACPoint & pi = fragments[ i ]->points_[ ii ];
+							SLACPoint & pj = fragments[ j ]->points_[ jj ];
+							Eigen::Vector3d ppi( pi.p_[ 0 ], pi.p_[ 1 ], pi.p_[ 2 ] );
+							Eigen::Vector3d ppj( pj.p_[ 0 ], pj.p_[ 1 ], pj.p_[ 2 ] );
+							Eigen::Vector3d npi( pi.n_[ 0 ], pi.n_[ 1 ], pi.n_[ 2 ] );
+							Eigen::Vector3d diff = ppi - ppj;
+							b = diff.dot( npi );
+							acc.score_ += b * b;
+
+							Eigen::Vector3d temp = ppj.cross( npi );
+
+							val[ 0 ] = temp( 0 );
+							val[ 1 ] = temp( 1 );
+							val[ 2 ] = temp( 2 );
+							val[ 3 ] = npi( 0 );
+							val[ 4 ] = npi( 1 );
+							val[ 5 ] = npi( 2 );
+							val[ 6 ] = -temp( 0 );
+							val[ 7 ] = -temp( 1 );
+							val[ 8 ] = -temp( 2 );
+							val[ 9 ] = -npi( 0 );
+							val[ 10 ] = -npi( 1 );
+							val[ 11 ] = -npi( 2 );
+
+							// next part of Jacobian
+							// deal with control lattices
+							Eigen::Vector3d dTi = pose_rot_t[ i ] * npi;
+							Eigen::Vector3d dTj = - pose_rot_t[ j ] * npi;
+
+							for ( int ll = 0; ll < 8; ll++ ) {
+								blocks[ 2 + ll ] = num + pi.idx_[ ll ] / 3;
+								for ( int xyz = 0; xyz < 3; xyz++ ) {
+									val[ 12 + ll * 3 + xyz ] = pi.val_[ ll ] * dTi( xyz );
+								}
 							}
-						}
 
-						for ( int ll = 0; ll < 8; ll++ ) {
-							for ( int xyz = 0; xyz < 3; xyz++ ) {
-								idx[ 12 + 24 + ll * 3 + xyz ] = 6 * num + pj.idx_[ ll ] + xyz;
-								val[ 12 + 24 + ll * 3 + xyz ] = pj.val_[ ll ] * dTj( xyz );
-							}
-						}
-
-						for ( int i = 0; i < buck_size; i++ ) {
-							tempJJ( idx[ i ], idx[ i ] ) += val[ i ] * val[ i ];
-							for ( int j = i + 1; j < buck_size; j++ ) {
-								if ( idx[ i ] == idx[ j ] ) {
-									tempJJ( idx[ i ], idx[ j ] ) += 2 * val[ i ] * val[ j ];
-								} else if ( idx[ i ] < idx[ j ] ) {
-									tempJJ( idx[ i ], idx[ j ] ) += val[ i ] * val[ j ];
-								} else {
-									tempJJ( idx[ j ], idx[ i ] ) += val[ i ] * val[ j ];
+							for ( int ll = 0; ll < 8; ll++ ) {
+								blocks[ 10 + ll ] = num + pj.idx_[ ll ] / 3;
+								for ( int xyz = 0; xyz < 3; xyz++ ) {
+									val[ 12 + 24 + ll * 3 + xyz ] = pj.val_[ ll ] * dTj( xyz );
 								}
 							}
-							tempJb( idx[ i ] ) += b * val[ i ];
+
+							assembler.AddRow( blocks, val, 18, b, acc );
 						}
+
+#pragma omp atomic
+						nprocessed++;
 					}
 
 #pragma omp critical
 					{
-						nprocessed++;
-						thisscore += score;
-						thisJJ += tempJJ;
-						thisJb += tempJb;
+						assembler.AddAccumulator( acc, total );
 					}
 				}
+				double thisscore = total.score_;
+				thisJb = total.Jb_;
 				PCL_INFO( " ... Done.\n" );
 				PCL_INFO( "Data error score is : %.2f\n", thisscore );
-				//cout << thisJJ << endl;
 				//cout << thisJb << endl;
-				//cout << ipose[ 0 ] << endl;
-				//cout << ipose[ 1 ] << endl;
-				//cout << ipose[ 7 ] << endl;
-				//if ( itr == 0 ) {
-				//	Eigen::MatrixXf temp = thisJJ - Eigen::MatrixXf( baseJJ.triangularView< Eigen::Upper >() );
-				//	cout << temp.block< 10, 10 >( 0, 0 ) << endl;
-				//	cout << temp.block< 10, 10 >( 0, 2710 ) << endl;
-				//	cout << temp.block< 10, 10 >( 2710, 2710 ) << endl;
-				//	cout << temp.block< 10, 10 >( matrix_size - 11, matrix_size - 11 ) << endl;
-				//	cout << thisJJ.block< 10, 10 >( 0, 0 ) << endl;
-				//	cout << thisJJ.block< 10, 10 >( 0, 2710 ) << endl;
-				//	cout << thisJJ.block< 10, 10 >( 2710, 2710 ) << endl;
-				//	cout << thisJJ.block< 10, 10 >( matrix_size - 11, matrix_size - 11 ) << endl;
-				//}
 
-				Eigen::SparseMatrix< double > thisSparseJJ = thisJJ.sparseView();
-				Eigen::CholmodSupernodalLLT< Eigen::SparseMatrix< double >, Eigen::Upper > solver;
-				//Eigen::ConjugateGradient< SparseMatrix, Eigen::Upper > solver;
-				solver.analyzePattern( thisSparseJJ );
-				solver.factorize( thisSparseJJ );
+				assembler.SetValues( total.values_ );
+				solver.factorize( assembler.matrix_ );
 
 				Eigen::VectorXd tempCtr( thisCtr );
 
@@ -0,0 +1,190 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2010-2011, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <pcl/gpu/kinfu_large_scale/plane_extraction_worker.h>
+#include <pcl/gpu/kinfu_large_scale/frame_profiler.h>
+#include <pcl/console/print.h>
+#include <boost/bind.hpp>
+
+namespace pcl
+{
+  namespace gpu
+  {
+    PlaneExtractionWorker::PlaneExtractionWorker (const int nb_buffers) :
+      frames_ (), intrinsics_ (), head_ (0), pending_ (0), held_ (-1), plane_fitter_ (), stop_ (false)
+    {
+      const int size = nb_buffers < 2 ? 2 : nb_buffers;
+      for (int i = 0; i < size; ++i)
+        frames_.push_back (boost::shared_ptr<Frame> (new Frame));
+      intrinsics_.resize (size);
+      thread_ = boost::thread (boost::bind (&PlaneExtractionWorker::run, this));
+    }
+
+    PlaneExtractionWorker::~PlaneExtractionWorker ()
+    {
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        stop_ = true;
+      }
+      queued_.notify_all ();
+      thread_.join ();
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    bool
+    PlaneExtractionWorker::push (const KinfuTracker::DepthMap &depth, const pcl::device::Intr &intr, const int index)
+    {
+      Frame *frame = acquire ();
+      if (frame == NULL)
+        return (false);
+      frame->index = index;
+      frame->depth.create (depth.rows (), depth.cols (), CV_16UC1);
+      depth.download (frame->depth.data, frame->depth.step);
+      enqueue (*frame, intr);
+      return (true);
+    }
+
+    bool
+    PlaneExtractionWorker::push (const cv::Mat &depth, const pcl::device::Intr &intr, const int index)
+    {
+      Frame *frame = acquire ();
+      if (frame == NULL)
+        return (false);
+      frame->index = index;
+      depth.copyTo (frame->depth);
+      enqueue (*frame, intr);
+      return (true);
+    }
+
+    PlaneExtractionWorker::Frame*
+    PlaneExtractionWorker::wait ()
+    {
+      boost::mutex::scoped_lock lock (mutex_);
+      held_ = -1;
+      if (pending_ == 0)
+      {
+        PCL_ERROR ("[pcl::gpu::PlaneExtractionWorker::wait] No frame was pushed.\n");
+        return (NULL);
+      }
+
+      Frame &frame = *frames_[head_];
+      while (!frame.done)
+        processed_.wait (lock);
+
+      held_ = head_;
+      head_ = (head_ + 1) % static_cast<int> (frames_.size ());
+      --pending_;
+      return (&frame);
+    }
+
+    int
+    PlaneExtractionWorker::getNumberOfPendingFrames () const
+    {
+      boost::mutex::scoped_lock lock (mutex_);
+      return (pending_);
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    PlaneExtractionWorker::Frame*
+    PlaneExtractionWorker::acquire ()
+    {
+      // buffers are only released by wait, from the calling thread, so there is no point in blocking here
+      boost::mutex::scoped_lock lock (mutex_);
+      if (pending_ + (held_ >= 0 ? 1 : 0) >= static_cast<int> (frames_.size ()))
+      {
+        PCL_WARN ("[pcl::gpu::PlaneExtractionWorker::push] All %d buffers are in use, frame dropped.\n", static_cast<int> (frames_.size ()));
+        return (NULL);
+      }
+      // the held buffer is the one right before head_, so the next free one is after the pending ones
+      return (frames_[(head_ + pending_) % frames_.size ()].get ());
+    }
+
+    void
+    PlaneExtractionWorker::enqueue (Frame &frame, const pcl::device::Intr &intr)
+    {
+      {
+        boost::mutex::scoped_lock lock (mutex_);
+        intrinsics_[(head_ + pending_) % frames_.size ()] = intr;
+        frame.done = false;
+        ++pending_;
+      }
+      queued_.notify_one ();
+    }
+
+    void
+    PlaneExtractionWorker::run ()
+    {
+      const int size = static_cast<int> (frames_.size ());
+      while (true)
+      {
+        int slot = -1;
+        {
+          boost::mutex::scoped_lock lock (mutex_);
+          while (true)
+          {
+            for (int i = 0; i < pending_ && slot < 0; ++i)
+              if (!frames_[(head_ + i) % size]->done)
+                slot = (head_ + i) % size;
+            if (slot >= 0 || stop_)
+              break;
+            queued_.wait (lock);
+          }
+        }
+        if (slot < 0)
+          return;
+
+        Frame &frame = *frames_[slot];
+        {
+          KINFU_PROFILE_HOST_STAGE (PLANE_FITTING);
+          cvMat2PointCloud (frame.depth, intrinsics_[slot], frame.cloud);
+          frame.segmentation.create (frame.depth.rows, frame.depth.cols, CV_8UC3);
+          plane_fitter_.run (&frame.image, &frame.planes, &frame.segmentation);
+          plane_fitter_.membershipImg.copyTo (frame.membership);
+        }
+
+        {
+          boost::mutex::scoped_lock lock (mutex_);
+          frame.done = true;
+        }
+        processed_.notify_all ();
+      }
+    }
+  }
+}
@@ -0,0 +1,243 @@
+ /*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2011, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <pcl/console/parse.h>
+#include <pcl/common/time.h>
+
+#include "tsdf_volume.h"
+#include "tsdf_volume.hpp"
+
+typedef pcl::TSDFVolume<float, short> CpuTsdfVolume;
+
+int
+print_help ()
+{
+  std::cout << "\nUsage:" << std::endl;
+  std::cout << "    pcl_kinfu_largeScale_cpu_benchmark <sequence_folder> [options]" << std::endl << std::endl;
+  std::cout << "    Fuses the depth frames listed in <sequence_folder>/depth.txt (TUM RGB-D layout, as the CU3D synthetic sequences)" << std::endl;
+  std::cout << "    into a CPU TSDF volume and reports the throughput in frames per second." << std::endl;
+
+  std::cout << "\nAvailable options:" << std::endl;
+  std::cout << "    --help, -h                      : print this message" << std::endl;
+  std::cout << "    -poses <file>                   : camera trajectory in TUM format (timestamp tx ty tz qx qy qz qw), one line per depth frame" << std::endl;
+  std::cout << "                                      without it every frame is fused from the initial pose" << std::endl;
+  std::cout << "    --volume_size <in_meters>       : side of the volume (default 3)" << std::endl;
+  std::cout << "    --resolution <voxels>           : number of voxels per side (default 256)" << std::endl;
+  std::cout << "    --trunc_dist <in_meters>        : truncation distance (default 0.03)" << std::endl;
+  std::cout << "    --depth_factor <units>          : depth image units per meter (default 1000)" << std::endl;
+  std::cout << "    --threads <n>                   : number of threads, 0 for the number of cores (default 0)" << std::endl;
+  std::cout << "    --frames <n>                    : only process the first n frames" << std::endl;
+  std::cout << "    --raycast                       : raycast vertex and normal maps after each integration" << std::endl;
+  std::cout << "    --save_volume <file>            : save the fused volume at the end" << std::endl << std::endl;
+
+  return 0;
+}
+
+/** \brief Reads a TUM style list file (three header lines, then "timestamp filename" lines) */
+bool
+readDepthList (const std::string &file, std::vector<std::string> &names)
+{
+  std::ifstream iff (file.c_str ());
+  if (!iff)
+    return (false);
+
+  char buffer[4096];
+  // ignore three header lines
+  for (int i = 0; i < 3; ++i)
+    iff.getline (buffer, sizeof (buffer));
+
+  double time;
+  std::string name;
+  while (iff >> time >> name)
+    names.push_back (name);
+  return (true);
+}
+
+/** \brief Reads a TUM trajectory, one "timestamp tx ty tz qx qy qz qw" pose per line */
+bool
+readPoses (const std::string &file, std::vector<Eigen::Affine3f, Eigen::aligned_allocator<Eigen::Affine3f> > &poses)
+{
+  std::ifstream iff (file.c_str ());
+  if (!iff)
+    return (false);
+
+  std::string line;
+  while (std::getline (iff, line))
+  {
+    if (line.empty () || line[0] == '#')
+      continue;
+
+    std::istringstream ss (line);
+    double time;
+    float tx, ty, tz, qx, qy, qz, qw;
+    if (!(ss >> time >> tx >> ty >> tz >> qx >> qy >> qz >> qw))
+      continue;
+
+    Eigen::Affine3f pose = Eigen::Affine3f::Identity ();
+    pose.linear () = Eigen::Quaternionf (qw, qx, qy, qz).normalized ().toRotationMatrix ();
+    pose.translation () = Eigen::Vector3f (tx, ty, tz);
+    poses.push_back (pose);
+  }
+  return (!poses.empty ());
+}
+
+int
+main (int argc, char** argv)
+{
+  if (argc < 2 || pcl::console::find_switch (argc, argv, "--help") || pcl::console::find_switch (argc, argv, "-h"))
+    return print_help ();
+
+  std::string folder = argv[1];
+  if (folder[folder.size () - 1] != '\\' && folder[folder.size () - 1] != '/')
+    folder.push_back ('/');
+
+  float volume_size = 3.f, trunc_dist = 0.03f, depth_factor = 1000.f;
+  int resolution = 256, threads = 0, max_frames = -1;
+  std::string poses_file, volume_file;
+  pcl::console::parse_argument (argc, argv, "--volume_size", volume_size);
+  pcl::console::parse_argument (argc, argv, "--resolution", resolution);
+  pcl::console::parse_argument (argc, argv, "--trunc_dist", trunc_dist);
+  pcl::console::parse_argument (argc, argv, "--depth_factor", depth_factor);
+  pcl::console::parse_argument (argc, argv, "--threads", threads);
+  pcl::console::parse_argument (argc, argv, "--frames", max_frames);
+  pcl::console::parse_argument (argc, argv, "-poses", poses_file);
+  pcl::console::parse_argument (argc, argv, "--save_volume", volume_file);
+  bool do_raycast = pcl::console::find_switch (argc, argv, "--raycast");
+
+  std::vector<std::string> depth_names;
+  if (!readDepthList (folder + "depth.txt", depth_names) || depth_names.empty ())
+  {
+    PCL_ERROR ("Can't read %sdepth.txt\n", folder.c_str ());
+    return (-1);
+  }
+
+  std::vector<Eigen::Affine3f, Eigen::aligned_allocator<Eigen::Affine3f> > poses;
+  if (!poses_file.empty () && !readPoses (poses_file, poses))
+  {
+    PCL_ERROR ("Can't read poses from %s\n", poses_file.c_str ());
+    return (-1);
+  }
+
+  int nb_frames = static_cast<int> (depth_names.size ());
+  if (!poses.empty ())
+    nb_frames = std::min (nb_frames, static_cast<int> (poses.size ()));
+  if (max_frames > 0)
+    nb_frames = std::min (nb_frames, max_frames);
+
+  CpuTsdfVolume tsdf;
+  tsdf.resize (Eigen::Vector3i (resolution, resolution, resolution), Eigen::Vector3f::Constant (volume_size));
+
+  // same defaults as the KinfuTracker and the Evaluation class
+  CpuTsdfVolume::Intr intr (525.f, 525.f, 319.5f, 239.5f, trunc_dist);
+
+  // initial pose of the KinfuTracker, the trajectory is expressed relatively to its first pose
+  Eigen::Affine3f init_pose = Eigen::Affine3f::Identity ();
+  init_pose.translation () = Eigen::Vector3f::Constant (volume_size * 0.5f) - Eigen::Vector3f (0, 0, volume_size / 2 * 1.2f);
+  Eigen::Affine3f first_pose_inv = poses.empty () ? Eigen::Affine3f::Identity () : poses[0].inverse ();
+
+  pcl::PointCloud<pcl::PointXYZ> vmap;
+  pcl::PointCloud<pcl::Normal> nmap;
+
+  double load_time = 0, integrate_time = 0, raycast_time = 0;
+  int processed = 0;
+
+  std::cout << "Fusing " << nb_frames << " frames into a " << resolution << "^3 volume of " << volume_size << "m" << std::endl;
+
+  for (int i = 0; i < nb_frames; ++i)
+  {
+    pcl::StopWatch watch;
+
+    cv::Mat d_img = cv::imread (folder + depth_names[i], CV_LOAD_IMAGE_ANYDEPTH | CV_LOAD_IMAGE_ANYCOLOR);
+    if (d_img.empty () || d_img.elemSize () != sizeof (unsigned short))
+    {
+      PCL_WARN ("Skipping %s: not a 16-bit depth image\n", depth_names[i].c_str ());
+      continue;
+    }
+
+    Eigen::MatrixXf depth (d_img.rows, d_img.cols);
+    for (int y = 0; y < d_img.rows; ++y)
+    {
+      const unsigned short *row = d_img.ptr<unsigned short> (y);
+      for (int x = 0; x < d_img.cols; ++x)
+        depth (y, x) = row[x] / depth_factor;
+    }
+
+    Eigen::MatrixXf depth_scaled;
+    tsdf.scaleDepth (depth, depth_scaled, intr);
+    load_time += watch.getTime ();
+
+    Eigen::Affine3f pose = poses.empty () ? init_pose : init_pose * first_pose_inv * poses[i];
+    Eigen::Matrix3f R_inv = pose.linear ().inverse ();
+    Eigen::Vector3f t = pose.translation ();
+
+    watch.reset ();
+    tsdf.integrateVolume (depth_scaled, trunc_dist, R_inv, t, intr, DEFAULT_MAX_WEIGHT, threads);
+    integrate_time += watch.getTime ();
+
+    if (do_raycast)
+    {
+      watch.reset ();
+      tsdf.raycast (pose.linear (), t, intr, trunc_dist, d_img.cols, d_img.rows, vmap, nmap, threads);
+      raycast_time += watch.getTime ();
+    }
+
+    ++processed;
+  }
+
+  if (processed == 0)
+  {
+    PCL_ERROR ("No frame was processed\n");
+    return (-1);
+  }
+
+  std::cout << "Processed " << processed << " frames" << std::endl;
+  std::cout << "  load + scale : " << load_time / processed << " ms/frame" << std::endl;
+  std::cout << "  integration  : " << integrate_time / processed << " ms/frame (" << 1000.0 * processed / integrate_time << " fps)" << std::endl;
+  if (do_raycast)
+    std::cout << "  raycast      : " << raycast_time / processed << " ms/frame (" << 1000.0 * processed / raycast_time << " fps)" << std::endl;
+  std::cout << "  fusion total : " << 1000.0 * processed / (integrate_time + raycast_time) << " fps" << std::endl;
+
+  if (!volume_file.empty ())
+    tsdf.save (volume_file);
+
+  return (0);
+}
@@ -56,6 +56,11 @@ bool Evaluation::grab (double stamp, pcl::gpu::PtrStepSz<const RGB>& rgb24) { re
 bool Evaluation::grab (double stamp, pcl::gpu::PtrStepSz<const unsigned short>& depth) { return false; }
 bool Evaluation::grab (double stamp, pcl::gpu::PtrStepSz<const unsigned short>& depth, pcl::gpu::PtrStepSz<const RGB>& rgb24) { return false; }
 void Evaluation::saveAllPoses(const pcl::gpu::KinfuTracker& kinfu, int frame_number, const std::string& logfile) const {}
+void Evaluation::startPrefetch (int, int, bool, int, int) {}
+void Evaluation::stopPrefetch () {}
+bool Evaluation::isPrefetching () const { return false; }
+void Evaluation::printDecodeStats () const {}
+void Evaluation::saveDecodeTimings (const std::string&) const {}
 
 #else
 
@@ -63,6 +68,11 @@ void Evaluation::saveAllPoses(const pcl::gpu::KinfuTracker& kinfu, int frame_num
 #include <opencv2/imgproc/imgproc.hpp>
 #include<fstream>
 
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <pcl/common/time.h>
+
 using namespace cv;
 
 #include <AHCPlaneFitter.hpp> //peac: http://www.merl.com/demos/point-plane-slam
@@ -114,12 +124,194 @@ PlaneFitter planeFitter_;
 // 	return pCloud;
 // }//cvMat2PointCloud
 
+namespace
+{
+  /** \brief Reads a 16-bit depth image. On failure, error is set if the image exists but can not be used */
+  bool readDepth (const string& file, Mat& depth, string& error)
+  {
+    depth = cv::imread(file, CV_LOAD_IMAGE_ANYDEPTH | CV_LOAD_IMAGE_ANYCOLOR);
+    if(depth.empty())
+      return false;
+
+    if (depth.elemSize() != sizeof(unsigned short))
+    {
+      error = "Image " + file + " was not opend in 16-bit format. Please use OpenCV 2.3.1 or higher";
+      depth.release();
+      return false;
+    }
+    return true;
+  }
+
+  bool readRgb (const string& file, Mat& rgb)
+  {
+    cv::Mat bgr = cv::imread(file);
+    if(bgr.empty())
+      return false;
+
+    cv::cvtColor(bgr, rgb, CV_BGR2RGB);
+    return true;
+  }
+}
+
 struct Evaluation::Impl
 {
    Mat depth_buffer;
    Mat rgb_buffer;
+
+   /** \brief Slot of the prefetching ring buffer, frame 'index' lives in slot index % frames.size() */
+   struct Frame
+   {
+     enum State { EMPTY, LOADING, READY };
+
+     Frame () : index (-1), state (EMPTY), ok (false) {}
+
+     int index;
+     State state;
+     bool ok;
+     /** \brief set by the decoding thread when the frame can not be used, reported by grab() */
+     string error;
+     Mat depth, rgb;
+   };
+
+   Impl () : prefetching (false), with_rgb (false), stop (false), total (0), first (0), stride (1), base (0), next_load (0), generation (0) {}
+
+   ~Impl () { stopThreads (); }
+
+   /** \brief Decoding loop of the pool threads */
+   void worker (const Evaluation* eval);
+
+   /** \brief Waits for frame i and makes depth_buffer / rgb_buffer point to it */
+   bool fetch (int i);
+
+   /** \brief Ring buffer slot of frame i, i must be first + k * stride */
+   Frame& slot (int i) { return frames[((i - first) / stride) % frames.size()]; }
+
+   void stopThreads ();
+
+   bool prefetching, with_rgb, stop;
+
+   /** \brief number of frames of the stream */
+   int total;
+   /** \brief the pool decodes the frames first + k * stride */
+   int first, stride;
+   /** \brief last frame returned to the reader, the ring buffer holds frames.size() frames from base */
+   int base;
+   /** \brief next frame to be decoded by the pool */
+   int next_load;
+   /** \brief incremented when the reader seeks out of the ring buffer, outdated decodes are dropped */
+   int generation;
+
+   std::vector<Frame> frames;
+   std::vector<float> decode_ms, wait_ms;
+   /** \brief last decoding error, reported by grab() */
+   string error;
+
+   boost::mutex mutex;
+   boost::condition_variable loader_cond, reader_cond;
+   std::vector<boost::shared_ptr<boost::thread> > workers;
 };
 
+void Evaluation::Impl::worker (const Evaluation* eval)
+{
+  const int size = static_cast<int>(frames.size());
+  for(;;)
+  {
+    int i, gen;
+    {
+      boost::mutex::scoped_lock lock (mutex);
+      while (!stop && (next_load >= total || next_load >= base + size * stride))
+        loader_cond.wait (lock);
+      if (stop)
+        return;
+
+      i = next_load;
+      next_load += stride;
+      gen = generation;
+      Frame& frame = slot (i);
+      frame.index = i;
+      frame.state = Frame::LOADING;
+    }
+
+    string depth_file, rgb_file;
+    eval->getFileNames (i, depth_file, rgb_file);
+
+    pcl::StopWatch watch;
+    Mat depth, rgb;
+    string error;
+    bool ok = readDepth (depth_file, depth, error) && (!with_rgb || readRgb (rgb_file, rgb));
+    float ms = static_cast<float>(watch.getTime ());
+
+    {
+      boost::mutex::scoped_lock lock (mutex);
+      if (gen != generation)
+        continue;
+
+      Frame& frame = slot (i);
+      frame.depth = depth;
+      frame.rgb = rgb;
+      frame.ok = ok;
+      frame.error = error;
+      frame.state = Frame::READY;
+      decode_ms[i] = ms;
+    }
+    reader_cond.notify_all ();
+  }
+}
+
+bool Evaluation::Impl::fetch (int i)
+{
+  const int size = static_cast<int>(frames.size());
+
+  boost::mutex::scoped_lock lock (mutex);
+  if (i < 0 || i >= total)
+    return false;
+
+  // seek out of the ring buffer or off the stride: restart the pool from frame i
+  if (i < base || i >= base + size * stride || (i - first) % stride != 0)
+  {
+    ++generation;
+    first = i;
+    next_load = i;
+    for (size_t k = 0; k < frames.size(); ++k)
+      frames[k] = Frame ();
+  }
+  base = i;
+  loader_cond.notify_all ();
+
+  pcl::StopWatch watch;
+  Frame& frame = slot (i);
+  while (frame.index != i || frame.state != Frame::READY)
+    reader_cond.wait (lock);
+  wait_ms[i] = static_cast<float>(watch.getTime ());
+
+  if (!frame.ok)
+  {
+    error = frame.error;
+    return false;
+  }
+
+  // cv::Mat headers are reference counted, the data stays valid when the slot is reused
+  depth_buffer = frame.depth;
+  rgb_buffer = frame.rgb;
+  return true;
+}
+
+void Evaluation::Impl::stopThreads ()
+{
+  {
+    boost::mutex::scoped_lock lock (mutex);
+    stop = true;
+  }
+  loader_cond.notify_all ();
+
+  for (size_t k = 0; k < workers.size(); ++k)
+    workers[k]->join ();
+  workers.clear ();
+
+  stop = false;
+  prefetching = false;
+}
+
 
 
 Evaluation::Evaluation(const std::string& folder) : folder_(folder), visualization_(false)
@@ -141,6 +333,9 @@ Evaluation::Evaluation(const std::string& folder) : folder_(folder), visualizati
 
 void Evaluation::setMatchFile(const std::string& file)
 {
+  // the decoding threads read the associations
+  stopPrefetch ();
+
   string full = folder_ + file;
   ifstream iff(full.c_str());  
   if(!iff)
@@ -222,40 +417,31 @@ bool Evaluation::grab (double stamp, PtrStepSz<const unsigned short>& depth)
   if ( i>= total)
       return false;
 
-  string file = folder_ + (accociations_.empty() ? depth_stamps_and_filenames_[i].second : accociations_[i].name1);
-  cout << "file: " << file << endl;
+  bool ok;
+  impl_->error.clear();
+  if (impl_->prefetching)
+    ok = impl_->fetch (static_cast<int>(i));
+  else
+  {
+    string depth_file, rgb_file;
+    getFileNames (i, depth_file, rgb_file);
 
-  cv::Mat d_img = cv::imread(file, CV_LOAD_IMAGE_ANYDEPTH | CV_LOAD_IMAGE_ANYCOLOR);
-  cout << "after_imread: " << d_img.size() << endl;
-  if(d_img.empty())
-      return false;
-   
-  if (d_img.elemSize() != sizeof(unsigned short))
+    // Datasets are with factor 5000 (pixel to m) 
+    // http://cvpr.in.tum.de/data/datasets/rgbd-dataset/file_formats#color_images_and_depth_maps
+    // the depth is used as is (mm), no copy is needed
+    ok = readDepth (depth_file, impl_->depth_buffer, impl_->error);
+  }
+  if (!ok)
   {
-    cout << "Image was not opend in 16-bit format. Please use OpenCV 2.3.1 or higher" << endl;
-    exit(1);
+    if (!impl_->error.empty())
+      cout << impl_->error << endl;
+    return false;
   }
 
-  // Datasets are with factor 5000 (pixel to m) 
-  // http://cvpr.in.tum.de/data/datasets/rgbd-dataset/file_formats#color_images_and_depth_maps
-    
-//   cout << "BEFORE_d_img_convertTo: " << impl_->depth_buffer.size() << endl
-//       << "depth_buffer.type: " << impl_->depth_buffer.type() << endl
-//       ;
-//   cv::Rect roi(320, 240, 5, 5);
-//   cout << "d_img.ROI: " << d_img(cv::Rect(320, 240, 5, 5)) << endl
-//       ;
-//   if(impl_->depth_buffer.size().width > 0)
-//       cout << "depth_buffer.ROI: " << impl_->depth_buffer(roi) << endl;
-  //d_img.convertTo(impl_->depth_buffer, d_img.type(), 0.2);
-  d_img.convertTo(impl_->depth_buffer, d_img.type(), 1); //zc
-//   cout << "after_d_img_convertTo\n";
   depth.data = impl_->depth_buffer.ptr<ushort>();
-//   cout << "after-impl_->depth_buffer.ptr\n";
   depth.cols = impl_->depth_buffer.cols;
   depth.rows = impl_->depth_buffer.rows;
   depth.step = impl_->depth_buffer.cols*sizeof(ushort); // 1280 = 640*2
-//   cout << "after-depth.step\n";
 
 #if 0	// ahc-peac bug:	@2017-4-1 09:59:24
   pcl::device::Intr intr(529.22, 528.98, 313.77, 254.10, 5.0);
@@ -294,35 +480,31 @@ bool Evaluation::grab (double stamp, PtrStepSz<const unsigned short>& depth, Ptr
   if ( i>= accociations_.size())
       return false;
 
-  string depth_file = folder_ + accociations_[i].name1;
-  string color_file = folder_ + accociations_[i].name2;
+  bool ok;
+  impl_->error.clear();
+  if (impl_->prefetching && impl_->with_rgb)
+    ok = impl_->fetch (static_cast<int>(i));
+  else
+  {
+    string depth_file, color_file;
+    getFileNames (i, depth_file, color_file);
 
-  cv::Mat d_img = cv::imread(depth_file, CV_LOAD_IMAGE_ANYDEPTH | CV_LOAD_IMAGE_ANYCOLOR);
-  if(d_img.empty())
-      return false;
-   
-  if (d_img.elemSize() != sizeof(unsigned short))
+    // Datasets are with factor 5000 (pixel to m) 
+    // http://cvpr.in.tum.de/data/datasets/rgbd-dataset/file_formats#color_images_and_depth_maps
+    ok = readDepth (depth_file, impl_->depth_buffer, impl_->error) && readRgb (color_file, impl_->rgb_buffer);
+  }
+  if (!ok)
   {
-    cout << "Image was not opend in 16-bit format. Please use OpenCV 2.3.1 or higher" << endl;
-    exit(1);
+    if (!impl_->error.empty())
+      cout << impl_->error << endl;
+    return false;
   }
 
-  // Datasets are with factor 5000 (pixel to m) 
-  // http://cvpr.in.tum.de/data/datasets/rgbd-dataset/file_formats#color_images_and_depth_maps
-     
-  //d_img.convertTo(impl_->depth_buffer, d_img.type(), 0.2);
-  d_img.convertTo(impl_->depth_buffer, d_img.type(), 1); //zc
   depth.data = impl_->depth_buffer.ptr<ushort>();
   depth.cols = impl_->depth_buffer.cols;
   depth.rows = impl_->depth_buffer.rows;
   depth.step = impl_->depth_buffer.cols*depth.elemSize(); // 1280 = 640*2
 
-  cv::Mat bgr = cv::imread(color_file);
-  if(bgr.empty())
-      return false;     
-      
-  cv::cvtColor(bgr, impl_->rgb_buffer, CV_BGR2RGB);
-  
   rgb24.data = impl_->rgb_buffer.ptr<RGB>();
   rgb24.cols = impl_->rgb_buffer.cols;
   rgb24.rows = impl_->rgb_buffer.rows;
@@ -331,6 +513,90 @@ bool Evaluation::grab (double stamp, PtrStepSz<const unsigned short>& depth, Ptr
   return true;  
 }
 
+void Evaluation::getFileNames (size_t i, string& depth_file, string& rgb_file) const
+{
+  if (accociations_.empty())
+  {
+    depth_file = folder_ + depth_stamps_and_filenames_[i].second;
+    rgb_file = i < rgb_stamps_and_filenames_.size() ? folder_ + rgb_stamps_and_filenames_[i].second : string();
+  }
+  else
+  {
+    depth_file = folder_ + accociations_[i].name1;
+    rgb_file = folder_ + accociations_[i].name2;
+  }
+}
+
+void Evaluation::startPrefetch (int num_threads, int buffer_size, bool with_rgb, int first, int stride)
+{
+  stopPrefetch ();
+
+  num_threads = std::max (1, num_threads);
+  buffer_size = std::max (2, buffer_size);
+
+  impl_->total = getStreamSize ();
+  impl_->first = std::max (0, first);
+  impl_->stride = std::max (1, stride);
+  impl_->base = impl_->first;
+  impl_->next_load = impl_->first;
+  impl_->with_rgb = with_rgb;
+  impl_->frames.assign (buffer_size, Impl::Frame ());
+  impl_->decode_ms.assign (impl_->total, 0.f);
+  impl_->wait_ms.assign (impl_->total, 0.f);
+  impl_->prefetching = true;
+
+  for (int k = 0; k < num_threads; ++k)
+    impl_->workers.push_back (boost::shared_ptr<boost::thread> (new boost::thread (&Impl::worker, impl_.get (), this)));
+
+  cout << "Prefetching frames with " << num_threads << " threads, " << buffer_size << " frames ahead" << endl;
+}
+
+void Evaluation::stopPrefetch ()
+{
+  impl_->stopThreads ();
+}
+
+bool Evaluation::isPrefetching () const
+{
+  return impl_->prefetching;
+}
+
+void Evaluation::printDecodeStats () const
+{
+  boost::mutex::scoped_lock lock (impl_->mutex);
+
+  int count = 0;
+  double decode_sum = 0, decode_max = 0, wait_sum = 0;
+  for (size_t i = 0; i < impl_->decode_ms.size(); ++i)
+  {
+    if (impl_->decode_ms[i] <= 0)
+      continue;
+    ++count;
+    decode_sum += impl_->decode_ms[i];
+    decode_max = std::max (decode_max, (double)impl_->decode_ms[i]);
+    wait_sum += impl_->wait_ms[i];
+  }
+
+  if (count == 0)
+  {
+    cout << "No prefetched frame" << endl;
+    return;
+  }
+  cout << "Decoded " << count << " frames: " << decode_sum / count << " ms/frame on average (max " << decode_max
+       << " ms), grab waited " << wait_sum / count << " ms/frame" << endl;
+}
+
+void Evaluation::saveDecodeTimings (const std::string& file) const
+{
+  boost::mutex::scoped_lock lock (impl_->mutex);
+
+  ofstream timings (file.c_str());
+  timings << "# index decode_ms wait_ms" << endl;
+  for (size_t i = 0; i < impl_->decode_ms.size(); ++i)
+    if (impl_->decode_ms[i] > 0)
+      timings << i << " " << impl_->decode_ms[i] << " " << impl_->wait_ms[i] << endl;
+}
+
 void Evaluation::saveAllPoses(const pcl::gpu::KinfuTracker& kinfu, int frame_number, const std::string& logfile) const
 {   
   size_t total = accociations_.empty() ? depth_stamps_and_filenames_.size() : accociations_.size();
@@ -77,6 +77,29 @@ public:
     */
   bool grab (double stamp, pcl::gpu::PtrStepSz<const unsigned short>& depth, pcl::gpu::PtrStepSz<const RGB>& rgb24);
 
+  /** \brief Starts a pool of threads decoding the frames ahead of the reader into a bounded ring buffer.
+    * grab() then waits for the prefetched frame instead of decoding it. The associations file must be set before.
+    * Only the frames first, first + stride, first + 2 * stride... are decoded; grabbing another frame restarts the pool from it.
+    * \param num_threads number of decoding threads
+    * \param buffer_size number of decoded frames kept in the ring buffer, including the one returned by the last grab()
+    * \param with_rgb also decode the rgb images (needed by grab (stamp, depth, rgb24))
+    * \param first index of the first frame to decode
+    * \param stride distance between two frames read in a row
+    */
+  void startPrefetch (int num_threads = 2, int buffer_size = 8, bool with_rgb = false, int first = 0, int stride = 1);
+
+  /** \brief Stops the decoding threads, grab() decodes synchronously again */
+  void stopPrefetch ();
+
+  /** \brief Returns true if the frames are decoded by the prefetching threads */
+  bool isPrefetching () const;
+
+  /** \brief Prints decode and wait statistics of the frames read so far */
+  void printDecodeStats () const;
+
+  /** \brief Writes the per-frame timings (index, decode time, time grab() waited for the frame, in ms) */
+  void saveDecodeTimings (const std::string& file) const;
+
   const static float fx, fy, cx, cy;
 
 
@@ -99,6 +122,9 @@ private:
 
   void readFile(const std::string& file, std::vector< std::pair<double, std::string> >& output);
 
+  /** \brief Returns the depth and rgb file names of frame i, honouring the associations */
+  void getFileNames (size_t i, std::string& depth_file, std::string& rgb_file) const;
+
   struct Impl;
   boost::shared_ptr<Impl> impl_;
 };
@@ -58,6 +58,10 @@ Work in progress: patch by Marco (AUG,19th 2012)
 #include <pcl/gpu/kinfu_large_scale/kinfu.h>
 #include <pcl/gpu/kinfu_large_scale/raycaster.h>
 #include <pcl/gpu/kinfu_large_scale/marching_cubes.h>
+#include <pcl/gpu/kinfu_large_scale/block_world_model.h>
+#include <pcl/gpu/kinfu_large_scale/chunked_world_model.h>
+#include <pcl/gpu/kinfu_large_scale/frame_profiler.h>
+#include <pcl/gpu/kinfu_large_scale/plane_extraction_worker.h>
 #include <pcl/gpu/containers/initialization.h>
 
 #include <pcl/common/time.h>
@@ -68,6 +72,7 @@ Work in progress: patch by Marco (AUG,19th 2012)
 #include <pcl/io/pcd_io.h>
 #include <pcl/io/ply_io.h>
 #include <pcl/io/vtk_io.h>
+#include <pcl/surface/vertex_welding.h>
 #include <pcl/io/openni_grabber.h>
 #include <pcl/io/oni_grabber.h>
 #include <pcl/io/pcd_grabber.h>
@@ -119,6 +124,8 @@ int pngPauseId_ = -1; //-eval ʱ, 
 bool isRealPng_, isZchiPng_;
 
 int everyXframes_ = 1; //, Ĭ=1,  @2017-11-21 10:06:36
+int prefetchThreads_ = 0, //-eval: number of decoding threads, 0 = frames decoded by grab
+	prefetchSize_ = 8; //-eval: number of frames decoded ahead
 
 bool isReadOn_;   //֮ǰһֱû, , ոͣƼ 2016-3-26 15:46:37
 int png_fps_ = 1000;
@@ -305,7 +312,7 @@ template<typename CloudT> void
 
 void writeTransformation( int file_index, const Eigen::Matrix4f& trans );
 
-void writeRawTSDF( int file_index, pcl::TSDFVolume<float, short> & tsdf );
+void writeChunkedTSDF( int file_index, pcl::TSDFVolume<float, short> & tsdf );
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 void 
@@ -383,7 +390,7 @@ boost::shared_ptr<pcl::PolygonMesh> convertToMesh(const DeviceArray<PointXYZ>& t
 	return mesh_ptr;
 }
 
-boost::shared_ptr<pcl::PolygonMesh> convertToMeshCompact(const DeviceArray<PointXYZ>& triangles)
+boost::shared_ptr<pcl::PolygonMesh> convertToMeshCompact(const DeviceArray<PointXYZ>& triangles, const Eigen::Vector3f& cell_size)
 { 
   if (triangles.empty () )
   {
@@ -397,34 +404,14 @@ boost::shared_ptr<pcl::PolygonMesh> convertToMeshCompact(const DeviceArray<Point
 
   boost::shared_ptr<pcl::PolygonMesh> mesh_ptr ( new pcl::PolygonMesh () ); 
 
-  std::unordered_map< pcl::PointXYZ, int, PointXYZHasher, PointXYZEqualer > map;
-  pcl::PointCloud<pcl::PointXYZ> compactcloud;
-  for ( size_t i = 0; i < cloud.size(); i++ ) {
-	  if ( map.find( cloud.points[ i ] ) == map.end() ) {
-		  map.insert( std::pair< pcl::PointXYZ, int >( cloud.points[ i ], compactcloud.size() ) );
-		  compactcloud.push_back( cloud.points[ i ] );
-	  }
-  }
+  // Weld the copies of a vertex by the grid edge they lie on, the grid nodes being the voxel centers
+  pcl::VertexWelding<pcl::PointXYZ> welding (0);
+  welding.setGrid (0.5f * cell_size, cell_size);
+  welding.setReverseOrientation (true);
+  welding.weld (cloud, *mesh_ptr);
+
+  PCL_INFO( "[convertTrianglesToMeshCompact] Reduce mesh vertices from %d to %d\n", cloud.size(), mesh_ptr->cloud.width );
 
-  PCL_INFO( "[convertTrianglesToMeshCompact] Reduce mesh vertices from %d to %d\n", cloud.size(), compactcloud.size() );
-  
-  pcl::toROSMsg (compactcloud, mesh_ptr->cloud);
-      
-  //mesh_ptr->polygons.resize (triangles.size () / 3);
-  for (size_t i = 0; i < triangles.size () / 3; ++i)
-  {
-    pcl::Vertices v;
-    //v.vertices.push_back (i*3+0);
-    //v.vertices.push_back (i*3+2);
-    //v.vertices.push_back (i*3+1);              
-	v.vertices.push_back( map.find( cloud.points[ i*3+0 ] )->second );
-	v.vertices.push_back( map.find( cloud.points[ i*3+2 ] )->second );
-	v.vertices.push_back( map.find( cloud.points[ i*3+1 ] )->second );
-    //mesh_ptr->polygons[i] = v;
-	if ( v.vertices[ 0 ] != v.vertices[ 1 ] && v.vertices[ 1 ] != v.vertices[ 2 ] && v.vertices[ 2 ] != v.vertices[ 0 ] ) {
-		mesh_ptr->polygons.push_back( v );
-	}
-  }    
   return (mesh_ptr);
 }
 
@@ -985,7 +972,7 @@ struct SceneCloudView
 
 		//DeviceArray<PointXYZ> triangles_device = marching_cubes_->run(kinfu.volume(), triangles_buffer_device_);    
 		DeviceArray<PointXYZ> triangles_device = marching_cubes_->run(kinfu.volume(), triangles_buffer_device_, kinfu.vxlDbg_);    
-		mesh_ptr_ = convertToMeshCompact(triangles_device);
+		mesh_ptr_ = convertToMeshCompact(triangles_device, kinfu.volume().getVoxelSize());
 
 		cloud_viewer_.removeAllPointClouds ();
 		if (mesh_ptr_)
@@ -1032,7 +1019,7 @@ struct KinFuLSApp
 		: exit_ (false), scan_ (false), scan_mesh_(false), file_index_( 0 ), transformation_( Eigen::Matrix4f::Identity() ), scan_volume_ (false), independent_camera_ (false),
 		slice2d_(false), print_nbr_(false), //zc
 		registration_ (false), integrate_colors_ (false), pcd_source_ (false), focal_length_(-1.f), capture_ (source), time_ms_(0), record_script_ (false), play_script_ (false), recording_ (false), use_device_ (useDevice), traj_(cv::Mat::zeros( 480, 640, CV_8UC3 )), traj_buffer_( 480, 640, CV_8UC3, cv::Scalar( 255, 255, 255 )),
-		use_rgbdslam_ (false), record_log_ (false), fragment_rate_ (fragmentRate), fragment_start_ (fragmentStart), use_schedule_ (false), use_graph_registration_ (false), frame_id_ (0), use_bbox_ ( false ), seek_start_( -1 ), kinfu_image_ (false), traj_token_ (0), use_mask_ (false), use_omask_(false), use_tmask_(false), 
+		use_rgbdslam_ (false), record_log_ (false), record_tsdf_ (false), fragment_rate_ (fragmentRate), fragment_start_ (fragmentStart), use_schedule_ (false), use_graph_registration_ (false), frame_id_ (0), use_bbox_ ( false ), seek_start_( -1 ), kinfu_image_ (false), traj_token_ (0), use_mask_ (false), use_omask_(false), use_tmask_(false), 
 		kintinuous_( false ), rgbd_odometry_( false ), slac_( false ), bdr_odometry_( false )
 		,cu_odometry_(false), s2s_odometry_(false)
 		, kdtree_odometry_(false)
@@ -1113,6 +1100,7 @@ struct KinFuLSApp
 		float height = 480.0f;
 		float width = 640.0f;
 		screenshot_manager_.setCameraIntrinsics (pcl::device::FOCAL_LENGTH, height, width);
+		plane_worker_.getPlaneFitter ().minSupport = 0;
 		snapshot_rate_ = snapshotRate;
 	}
 
@@ -1257,6 +1245,13 @@ struct KinFuLSApp
 		cout << "Log record: " << ( record_log_ ? "On" : "Off" ) << endl;
 	}
 
+	void
+		enableTsdfRecord()
+	{
+		record_tsdf_ = true;
+		cout << "TSDF record: On" << endl;
+	}
+
 	void
 		toggleCameraParam( std::string camera_file )
 	{
@@ -1736,6 +1731,7 @@ struct KinFuLSApp
 		if ( has_data ) {
 			frame_counter_++;
 		}
+		KINFU_PROFILE_FRAME ( has_data, frame_counter_ );
 
 		if ( record_script_ ) {
 			if ( kinfu_->shiftNextTime() ) {
@@ -1971,35 +1967,35 @@ struct KinFuLSApp
 					//2017-4-22 21:36:41
 
 					kinfu_->volume().create_init_cu_volume(); //Ƶ, ʼͺ, ¿ָ @2018-12-4 12:54:53
+					//planes of this frame are extracted by plane_worker_ while cuOdometry tracks it
+					const bool extract_planes = !kinfu_->isCuInitialized_	//ȫ cu ûгʼλ
+						|| crnr_write_csv_;	// "-crnr" cu
+					float fx = camera_.fx_, fy = camera_.fy_,
+						cx = camera_.cx_, cy = camera_.cy_;
+					const bool planes_pushed = extract_planes
+						&& plane_worker_.push(depth_device_, pcl::device::Intr(fx, fy, cx, cy, camera_.integration_trunc_), frame_counter_);
+
 					tt0.tic(); //40~60ms
 					//|-> Ŀǰ汾, ~100~130ms,  f2mod+f2mkr+e2c (ֻ level_index==0 ) @2017-10-7 16:43:04
 					has_image = kinfu_->cuOdometry(depth_device_, &image_view_.colors_device_);
 					printf("kinfu_->cuOdometry: "); tt0.toc_print();
 
-					if(!kinfu_->isCuInitialized_	//ȫ cu ûгʼλ
-						|| crnr_write_csv_)	// "-crnr" cu
+					//NULL if the frame was dropped by the worker, the corner search is then skipped for this frame
+					pcl::gpu::PlaneExtractionWorker::Frame *planes_frame = planes_pushed ? plane_worker_.wait() : NULL;
+					if(extract_planes && planes_frame == NULL)
+						PCL_WARN("No planes extracted for frame %d, corner search skipped\n", frame_counter_);
+
+					if(planes_frame != NULL)
 					{
 						ScopeTimeT time("NOT kinfu_->isCuInitialized_");
 
 						//1, ƽָ,:
-						PlaneFitter planeFitter_;
-
-						cv::Mat dm_raw(depth_device_.rows(), depth_device_.cols(), CV_16UC1); //milli-m, raw
-						int c;
-						depth_device_.download(dm_raw.data, depth_device_.colsBytes());
-
-						float fx = camera_.fx_, fy = camera_.fy_,
-							cx = camera_.cx_, cy = camera_.cy_;
-						pcl::device::Intr intr(fx, fy, cx, cy, camera_.integration_trunc_);
-						CloudType::Ptr depCloud = cvMat2PointCloud(dm_raw, intr);
-						RGBDImage rgbdObj(*depCloud);
-
-						cv::Mat dbgSegMat(depCloud->height, depCloud->width, CV_8UC3); //ָӻ
-						vector<vector<int>> idxss;
-
-						planeFitter_.minSupport = 000;
-						planeFitter_.run(&rgbdObj, &idxss, &dbgSegMat);
-						annotateLabelMat(planeFitter_.membershipImg, &dbgSegMat);
+						pcl::gpu::PlaneExtractionWorker::Frame &planes = *planes_frame;
+						cv::Mat &dm_raw = planes.depth; //milli-m, raw
+						RGBDImage &rgbdObj = planes.image;
+						cv::Mat &dbgSegMat = planes.segmentation;
+						vector<vector<int>> &idxss = planes.planes;
+						annotateLabelMat(planes.membership, &dbgSegMat);
 						const char *winNameAhc = "ahc-dbg@kinfLS_app";
 						//imshow(winNameAhc, dbgSegMat);
 						cv::namedWindow(winNameAhc); //ΪҪ setMouseCallback, Աд
@@ -2011,7 +2007,7 @@ struct KinFuLSApp
 						plvec = zcRefinePlsegParam(rgbdObj, idxss); //Ƿ refine ƽ
 						vector<vector<double>> cubeCandiPoses; //vecsize=12=(t3+R9), cubeϵ̬, ҹ涨col-major; vecʾѡǵ̬
 						//2, :
-						zcFindOrtho3tup(plvec, planeFitter_.membershipImg, fx, fy, cx, cy, cubeCandiPoses, dbgSegMat);
+						zcFindOrtho3tup(plvec, planes.membership, fx, fy, cx, cy, cubeCandiPoses, dbgSegMat);
 						size_t crnrCnt = cubeCandiPoses.size();
 						bool isFoundCrnr = (crnrCnt != 0);
 
@@ -2087,7 +2083,7 @@ struct KinFuLSApp
 							vector<double> cu4pts; //meters, Ϊ cuSideLenVec_ 
 							bool isFoundCu4pts = false;
 							if(isFoundCrnr)
-								isFoundCu4pts = getCu4Pts(cubeCandiPoses[crnrIdx], cuSideLenVec_, dm_raw, planeFitter_.membershipImg, fx, fy, cx, cy, cu4pts);
+								isFoundCu4pts = getCu4Pts(cubeCandiPoses[crnrIdx], cuSideLenVec_, dm_raw, planes.membership, fx, fy, cx, cy, cu4pts);
 							//ҵ crnr δ isFoundCu4pts, Ϊʾȫ
 							printf("getCu4Pts: "); tt0.toc_print();
 
@@ -2386,23 +2382,14 @@ struct KinFuLSApp
 			}
 			*/
 
-			/*
-			//std::vector< int > raw_data;
-			//int col;
-			//kinfu_->volume().data().download( raw_data, col );
-			cout << "Downloading TSDF volume from device ... " << flush;
-			kinfu_->volume().downloadTsdfAndWeighs (tsdf_volume_.volumeWriteable (), tsdf_volume_.weightsWriteable ());
-			tsdf_volume_.setHeader (Eigen::Vector3i (pcl::device::VOLUME_X, pcl::device::VOLUME_Y, pcl::device::VOLUME_Z), kinfu_->volume().getSize ());
+			if ( record_tsdf_ ) {
+				cout << "Downloading TSDF volume from device ... " << flush;
+				kinfu_->volume().downloadTsdfAndWeighs (tsdf_volume_.volumeWriteable (), tsdf_volume_.weightsWriteable ());
+				tsdf_volume_.setHeader (Eigen::Vector3i (pcl::device::VOLUME_X, pcl::device::VOLUME_Y, pcl::device::VOLUME_Z), kinfu_->volume().getSize ());
+				cout << "done [" << tsdf_volume_.size () << " voxels]" << endl;
 
-			int cnt = 0;
-			for ( int i = 0; i < ( int )tsdf_volume_.size(); i++ ) {
-			if ( tsdf_volume_.volume().at( i ) != 0.0f )
-			cnt++;
+				writeChunkedTSDF( file_index_, tsdf_volume_ );
 			}
-			cout << "valid voxel number is " << cnt << endl;
-
-			writeRawTSDF( file_index_, tsdf_volume_ );
-			*/
 
 			file_index_++;
 		}
@@ -2914,8 +2901,10 @@ struct KinFuLSApp
 			//--Ѹ:  --camera ʱ,  eval д 525,525,319.5,239.5 ( longRange.param)	@2017-3-30 21:36:58
 
 			int key = -1; //̿
-			int currentIndex = 0; //eval 
-			while (evaluation_ptr_->grab (currentIndex, depth_)) { 
+			int currentIndex = pngSid_ > 0 ? pngSid_ : 0; //frames before -sid are not read
+			if (prefetchThreads_ > 0)
+				evaluation_ptr_->startPrefetch (prefetchThreads_, prefetchSize_, integrate_colors_, currentIndex, everyXframes_);
+			while (integrate_colors_ ? evaluation_ptr_->grab (currentIndex, depth_, rgb24_) : evaluation_ptr_->grab (currentIndex, depth_)) { 
 			//while (evaluation_ptr_->grab (currentIndex, depth_, rgb24_)) { // rgb, ͼ -r -ic
 				if(currentIndex < pngSid_){
 					currentIndex ++;
@@ -3045,6 +3034,11 @@ struct KinFuLSApp
 			}//while-eval
 
 			printf("evaluation_ptr_->grab DONE...\n");
+			if (evaluation_ptr_->isPrefetching ()){
+				evaluation_ptr_->printDecodeStats ();
+				evaluation_ptr_->saveDecodeTimings ("decode_timings.txt");
+				evaluation_ptr_->stopPrefetch ();
+			}
 
 			//cv::waitKey(0); //ֶ mesh ֮, 
 			//ٴ esc ˳:
@@ -3147,6 +3141,7 @@ struct KinFuLSApp
 	bool play_script_;
 	bool record_log_;
 	string record_log_file_;
+	bool record_tsdf_;
 
 	bool use_rgbdslam_;
 	RGBDTrajectory rgbd_traj_;
@@ -3176,6 +3171,7 @@ struct KinFuLSApp
 	int frame_id_;
 	bool enable_texture_extraction_;
 	pcl::gpu::ScreenshotManager screenshot_manager_;
+	pcl::gpu::PlaneExtractionWorker plane_worker_;
 	int snapshot_rate_;
 
 	bool kinfu_image_;
@@ -3366,14 +3362,15 @@ void writeTransformation( int file_index, const Eigen::Matrix4f & trans )
 	}
 }
 
-void writeRawTSDF( int file_index, pcl::TSDFVolume<float, short> & tsdf )
+void writeChunkedTSDF( int file_index, pcl::TSDFVolume<float, short> & tsdf )
 {
 	char filename[ 1024 ];
 	memset( filename, 0, 1024 );
 
-	sprintf( filename, "cloud_bin_tsdf_%d.tsdf", file_index );
+	// empty bricks are skipped, see pcl_kinfu_largeScale_tsdf_converter to get the former raw format back
+	sprintf( filename, "cloud_bin_tsdf_%d.ctsdf", file_index );
 
-	tsdf.save( filename );
+	tsdf.saveChunked( filename );
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -3428,11 +3425,16 @@ int
 	cout << "    --fragment <X_frames>               : fragments the stream every <X_frames>" << endl;
 	cout << "    --fragment_start <X_frames>         : fragments start from <X_frames>" << endl;
 	cout << "    --record_log <log_file>             : record transformation log file" << endl;
+	cout << "    --record_tsdf                       : with --fragment, save the TSDF volume of every fragment (cloud_bin_tsdf_<n>.ctsdf)" << endl;
 	cout << "    --graph_registration <graph file>   : register the fragments in the file" << endl;
 	cout << "    --schedule <schedule file>          : schedule Kinfu processing from the file" << endl;
 	cout << "    --seek_start <X_frames>              : start from X_frames" << endl;
 	cout << "    --kinfu_image                       : record kinfu images to image folder" << endl;
 	cout << "    --world                             : turn on world.pcd extraction" << endl;
+	cout << "    --world_blocks <X_voxels>           : store the world in blocks of <X_voxels> (faster shifts on large scans)" << endl;
+	cout << "    --world_chunks <X_points>           : store the world in append-only chunks of <X_points> (adding a slice never copies the world)" << endl;
+	cout << "    --world_slices <prefix>             : write the shifted slices to <prefix>NNNNNN.pcd in a background thread" << endl;
+	cout << "    --profile <prefix>                  : record per-frame stage timings, saved to <prefix>.csv and <prefix>.json (Chrome trace) at exit" << endl;
 	cout << "    --bbox <bbox file>                  : turn on bbox, used with --rgbdslam" << endl;
 	cout << "    --mask <x1,x2,y1,y2>                : trunc the depth image with a window" << endl;
 	cout << "    --camera <param_file>               : launch parameters from the file" << endl;
@@ -3450,7 +3452,8 @@ int
 	cout << "    -dev <device> (default), -oni <oni_file>, -pcd <pcd_file or directory>" << endl;
 	cout << endl << "";
 	cout << " For RGBD benchmark (Requires OpenCV):" << endl; 
-	cout << "    -eval <eval_folder> [-match_file <associations_file_in_the_folder>]" << endl << endl;
+	cout << "    -eval <eval_folder> [-match_file <associations_file_in_the_folder>]" << endl;
+	cout << "          [-prefetch <decoding_threads>] [-prefetch_size <frames_ahead>]  : decode the frames in background threads" << endl << endl;
 
 	return 0;
 }
@@ -3667,6 +3670,10 @@ int
 			pngEid_ = app.evaluation_ptr_->getStreamSize() - 1;
 		}
 
+		//the decoding threads are started by the eval loop, once the frame range, stride and color mode are known
+		pc::parse_argument (argc, argv, "-prefetch", prefetchThreads_);
+		pc::parse_argument (argc, argv, "-prefetch_size", prefetchSize_);
+
 		pc::parse_argument(argc, argv, "-everyX", everyXframes_);
 		pc::parse_argument(argc, argv, "-pauseId", pngPauseId_);
 
@@ -3775,9 +3782,34 @@ int
 		app.toggleLogRecord( record_log_file );
 	}
 
+	if ( pc::find_switch ( argc, argv, "--record_tsdf" ) )
+		app.enableTsdfRecord();
+
 	if ( pc::find_switch ( argc, argv, "--world" ) )
 		app.kinfu_->toggleExtractWorld();
 
+	int world_block_size = 0;
+	if ( pc::parse_argument ( argc, argv, "--world_blocks", world_block_size ) > 0 )
+		app.kinfu_->setWorldModel ( pcl::WorldModel<pcl::PointXYZI>::Ptr ( new pcl::BlockWorldModel<pcl::PointXYZI> ( world_block_size ) ) );
+
+	int world_chunk_size = 0;
+	if ( pc::parse_argument ( argc, argv, "--world_chunks", world_chunk_size ) > 0 )
+		app.kinfu_->setWorldModel ( pcl::WorldModel<pcl::PointXYZI>::Ptr ( new pcl::ChunkedWorldModel<pcl::PointXYZI> ( world_chunk_size > 0 ? world_chunk_size : 65536 ) ) );
+
+	std::string world_slices_prefix;
+	if ( pc::parse_argument ( argc, argv, "--world_slices", world_slices_prefix ) > 0 )
+		app.kinfu_->setSliceWriter ( pcl::SliceWriter<pcl::PointXYZI>::Ptr ( new pcl::SliceWriter<pcl::PointXYZI> ( world_slices_prefix ) ) );
+
+	std::string profile_prefix;
+	if ( pc::parse_argument ( argc, argv, "--profile", profile_prefix ) > 0 ) {
+#ifdef PCL_KINFU_PROFILING
+		pcl::gpu::FrameProfiler::instance ().setEnabled ( true );
+#else
+		PCL_WARN ( "--profile is ignored, kinfu_large_scale was built without KINFU_LS_PROFILING.\n" );
+		profile_prefix.clear ();
+#endif
+	}
+
 	if ( pc::find_switch ( argc, argv, "--kinfu_image" ) ) {
 		app.toggleKinfuImage();
 		if ( oni_file.find( "input.oni" ) != string::npos ) {
@@ -3945,6 +3977,11 @@ int
 	catch (const std::bad_alloc& /*e*/) { cout << "Bad alloc" << endl; }
 	catch (const std::exception& /*e*/) { cout << "Exception" << endl; }
 
+	if ( !profile_prefix.empty () ) {
+		pcl::gpu::FrameProfiler::instance ().saveCSV ( profile_prefix + ".csv" );
+		pcl::gpu::FrameProfiler::instance ().saveChromeTrace ( profile_prefix + ".json" );
+	}
+
 	//~ #ifdef HAVE_OPENCV
 	//~ for (size_t t = 0; t < app.image_view_.views_.size (); ++t)
 	//~ {
@@ -39,6 +39,8 @@
 #include <pcl/gpu/kinfu_large_scale/impl/standalone_marching_cubes.hpp>
 #include <pcl/gpu/kinfu_large_scale/world_model.h>
 #include <pcl/gpu/kinfu_large_scale/impl/world_model.hpp>
+#include <pcl/gpu/kinfu_large_scale/cpu_marching_cubes.h>
+#include <boost/bind.hpp>
 
 #include <pcl/console/parse.h>
 
@@ -50,7 +52,9 @@ print_help ()
 
   std::cout << "\nAvailable options:" << std::endl;
   std::cout << "    --help, -h                      : print this message" << std::endl;
-  std::cout << "    --volume_size <in_meters>       : define integration volume size. MUST match the size used when scanning." << std::endl << std::endl;
+  std::cout << "    --volume_size <in_meters>       : define integration volume size. MUST match the size used when scanning." << std::endl;
+  std::cout << "    --cpu                           : mesh the cubes on the CPU, several at a time, and save each mesh as soon as it is done" << std::endl;
+  std::cout << "    --threads <n>                   : number of meshing threads with --cpu (default: one per core)" << std::endl << std::endl;
 
   return 0;
 }
@@ -114,6 +118,24 @@ main (int argc, char** argv)
 
   PCL_WARN("Processing world with volume size set to %.2f meters\n", volume_size);
 
+  if (pcl::console::find_switch (argc, argv, "--cpu"))
+  {
+    int threads = 0;
+    pcl::console::parse_argument (argc, argv, "--threads", threads);
+
+    //Split the world without copying it, every cube is built when a thread meshes it. The input cloud is not needed anymore, the world model holds a copy of it
+    cloud.reset ();
+    pcl::WorldModel<pcl::PointXYZI>::CubeBuckets buckets;
+    wm.getWorldAsCubeBuckets (pcl::device::VOLUME_X, buckets, 0.025); // 2.5% overlapp (12 cells with a 512-wide cube)
+
+    pcl::CpuMarchingCubes<pcl::PointXYZI> cpu_cubes (pcl::device::VOLUME_X, pcl::device::VOLUME_Y, pcl::device::VOLUME_Z, volume_size);
+    cpu_cubes.getMeshesFromTSDFCubes (boost::bind (&pcl::WorldModel<pcl::PointXYZI>::CubeBuckets::getCube, &buckets, _1),
+                                      buckets.transforms, std::max (0, threads));
+
+    PCL_INFO( "Done!\n");
+    return (0);
+  }
+
   pcl::gpu::StandaloneMarchingCubes<pcl::PointXYZI> m_cubes(pcl::device::VOLUME_X,pcl::device::VOLUME_Y,pcl::device::VOLUME_Z,volume_size);
 
   //~ //Creating the output
@@ -0,0 +1,104 @@
+ /*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2011, Willow Garage, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <iostream>
+#include <string>
+
+#include <pcl/console/parse.h>
+#include <pcl/common/time.h>
+
+#include "tsdf_volume.h"
+#include "tsdf_volume.hpp"
+
+typedef pcl::TSDFVolume<float, short> CpuTsdfVolume;
+
+int
+print_help ()
+{
+  std::cout << "\nUsage:" << std::endl;
+  std::cout << "    pcl_kinfu_largeScale_tsdf_converter <input> <output> [options]" << std::endl << std::endl;
+  std::cout << "    Converts a raw TSDF volume (TSDFVolume::save, e.g. cloud_bin_tsdf_<n>.tsdf) into the chunked format" << std::endl;
+  std::cout << "    of TSDFVolume::saveChunked, or back with --to_raw." << std::endl;
+
+  std::cout << "\nAvailable options:" << std::endl;
+  std::cout << "    --help, -h                      : print this message" << std::endl;
+  std::cout << "    --brick_size <voxels>           : side of the bricks of the chunked file (default " << DEFAULT_BRICK_SIZE << ")" << std::endl;
+  std::cout << "    --to_raw                        : convert a chunked file into a raw one" << std::endl;
+  std::cout << "    --region <x0,y0,z0,x1,y1,z1>    : with --to_raw, only convert the voxels in [x0,x1[ x [y0,y1[ x [z0,z1[" << std::endl << std::endl;
+
+  return 0;
+}
+
+int
+main (int argc, char** argv)
+{
+  if (argc < 3 || pcl::console::find_switch (argc, argv, "--help") || pcl::console::find_switch (argc, argv, "-h"))
+    return print_help ();
+
+  std::string input = argv[1];
+  std::string output = argv[2];
+  int brick_size = DEFAULT_BRICK_SIZE;
+  pcl::console::parse_argument (argc, argv, "--brick_size", brick_size);
+  bool to_raw = pcl::console::find_switch (argc, argv, "--to_raw");
+
+  std::vector<int> region;
+  pcl::console::parse_x_arguments (argc, argv, "--region", region);
+  if (!region.empty () && (!to_raw || region.size () != 6))
+  {
+    PCL_ERROR ("--region needs six values and --to_raw\n");
+    return (-1);
+  }
+
+  pcl::StopWatch watch;
+  CpuTsdfVolume tsdf;
+  if (to_raw)
+  {
+    bool loaded = region.empty () ? tsdf.loadChunked (input)
+                                  : tsdf.loadChunkedRegion (input, Eigen::Vector3i (region[0], region[1], region[2]),
+                                                            Eigen::Vector3i (region[3], region[4], region[5]));
+    if (!loaded || !tsdf.save (output))
+      return (-1);
+  }
+  else
+  {
+    if (!tsdf.load (input) || !tsdf.saveChunked (output, brick_size))
+      return (-1);
+  }
+  std::cout << "Converted " << input << " into " << output << " in " << watch.getTime () << " ms" << std::endl;
+
+  return 0;
+}
@@ -42,6 +42,8 @@
 #include <pcl/point_types.h>
 #include <pcl/console/print.h>
 
+#include <boost/thread/thread.hpp>
+
 #include <opencv2/core/core.hpp> //zc
 #include <opencv2/imgproc/imgproc.hpp>
 #include <opencv2/opencv.hpp>
@@ -55,6 +57,11 @@
 #define DEFAULT_VOLUME_SIZE_Y 3000
 #define DEFAULT_VOLUME_SIZE_Z 3000
 
+#define DEFAULT_BRICK_SIZE 16   // side of the bricks of the chunked file format
+#define TSDF_CHUNKED_MAGIC "TSDFCHK1"
+
+#define DEFAULT_MAX_WEIGHT 256  // pcl::device::Tsdf::MAX_WEIGHT
+
 
 namespace pcl
 {
@@ -183,6 +190,28 @@ namespace pcl
     bool
     save (const std::string &filename = "tsdf_volume.dat", bool binary = true) const;
 
+    /** \brief Saves volume to a chunked file. The grid is cut into cubic bricks, the bricks holding only unobserved
+      * voxels (zero weight) are skipped and the other ones are compressed with LZF.
+      * The file starts with the header and a table giving the location of every brick, see loadChunkedRegion.
+      * \param[in] filename name of the file
+      * \param[in] brick_size side of a brick, in voxels
+      */
+    bool
+    saveChunked (const std::string &filename, int brick_size = DEFAULT_BRICK_SIZE) const;
+
+    /** \brief Loads a volume saved by saveChunked. The file is memory mapped and decompressed brick by brick. */
+    bool
+    loadChunked (const std::string &filename);
+
+    /** \brief Loads the region [min, max[ of a volume saved by saveChunked, only the bricks overlapping it are decompressed.
+      * The volume is resized to the region: its voxel (0,0,0) is the voxel min of the file, its size is scaled accordingly.
+      * \param[in] filename name of the file
+      * \param[in] min first voxel of the region
+      * \param[in] max voxel after the last one of the region, clamped to the resolution of the file
+      */
+    bool
+    loadChunkedRegion (const std::string &filename, const Eigen::Vector3i &min, const Eigen::Vector3i &max);
+
     /** \brief Returns overall number of voxels in grid */
     inline size_t
     size () const { return header_.getVolumeSize(); };
@@ -240,9 +269,47 @@ namespace pcl
   //  void
   //  convertToCloud (pcl::PointCloud<pcl::PointXYZ>::Ptr &cloud) const;
 
-    /** \brief Crate Volume from Point Cloud */
-  //   template <typename PointT> void
-  //   createFromCloud (const typename pcl::PointCloud<PointT>::ConstPtr &cloud, const Intr &intr);
+    /** \brief Crate Volume from an organized Point Cloud, seen from the initial KinfuTracker pose */
+    template <typename PointT> void
+    createFromCloud (const typename pcl::PointCloud<PointT>::ConstPtr &cloud, const Intr &intr);
+
+    /** \brief Converts a depth map (distance along Z) into distances along the camera rays, as the GPU scaleDepth kernel
+      * \param[in] depth depth map, in the units of the volume size, 0 or NaN for invalid pixels
+      * \param[out] depth_scaled distances along the rays
+      * \param[in] intr camera intrinsics
+      */
+    void
+    scaleDepth (const Eigen::MatrixXf &depth, Eigen::MatrixXf &depth_scaled, const Intr &intr) const;
+
+    /** \brief Fuses a scaled depth map into the volume on the CPU, with the projective TSDF model of tsdf_volume.cu.
+      * The volume is split into slabs along Z, one per thread, and the inner loop runs along X (contiguous in memory).
+      * \param[in] depth_scaled distances along the camera rays, see scaleDepth
+      * \param[in] tranc_dist truncation distance, in the units of the volume size
+      * \param[in] R_inv inverse of the camera rotation (world to camera)
+      * \param[in] t camera position in the volume
+      * \param[in] intr camera intrinsics
+      * \param[in] max_weight the weights are clamped to this value
+      * \param[in] nr_threads number of threads to use, 0 for the number of cores
+      */
+    void
+    integrateVolume (const Eigen::MatrixXf &depth_scaled, float tranc_dist, const Eigen::Matrix3f &R_inv, const Eigen::Vector3f &t,
+                     const Intr &intr, int max_weight = DEFAULT_MAX_WEIGHT, unsigned int nr_threads = 0);
+
+    /** \brief Raycasts the zero crossing of the volume into vertex and normal maps on the CPU, as the GPU RayCaster.
+      * The rows of the maps are shared between the threads.
+      * \param[in] R camera rotation (camera to world)
+      * \param[in] t camera position in the volume
+      * \param[in] intr camera intrinsics
+      * \param[in] tranc_dist truncation distance, the ray step is 0.8 times this distance
+      * \param[in] cols width of the maps
+      * \param[in] rows height of the maps
+      * \param[out] vmap organized vertex map, NaN where no surface was found
+      * \param[out] nmap organized normal map, NaN where no surface was found
+      * \param[in] nr_threads number of threads to use, 0 for the number of cores
+      */
+    void
+    raycast (const Eigen::Matrix3f &R, const Eigen::Vector3f &t, const Intr &intr, float tranc_dist, int cols, int rows,
+             pcl::PointCloud<pcl::PointXYZ> &vmap, pcl::PointCloud<pcl::Normal> &nmap, unsigned int nr_threads = 0) const;
 
     /** \brief Retunrs the 3D voxel coordinate */
     template <typename PointT> void
@@ -281,11 +348,26 @@ namespace pcl
     ////////////////////////////////////////////////////////////////////////////////////////
     // Private functions and members
 
-  //  void
-  //  scaleDepth (const Eigen::MatrixXf &depth, Eigen::MatrixXf &depth_scaled, const Intr &intr) const;
+    /** \brief Returns the number of threads to use for nr_threads (0 means the number of cores) */
+    static inline int
+    getNumberOfThreads (unsigned int nr_threads)
+    {
+      if (nr_threads == 0)
+        nr_threads = boost::thread::hardware_concurrency ();
+      return (nr_threads > 0 ? static_cast<int> (nr_threads) : 1);
+    }
 
-  //  void
-  //  integrateVolume (const Eigen::MatrixXf &depth_scaled, float tranc_dist, const Eigen::Matrix3f &R_inv, const Eigen::Vector3f &t, const Intr &intr);
+    /** \brief Trilinear interpolation of the TSDF at a point given in voxel units, NaN close to the borders (RayCaster::interpolateTrilineary) */
+    float
+    interpolateTrilinearly (const Eigen::Vector3f &point) const;
+
+    /** \brief Location of a brick in a chunked file. A brick is stored uncompressed when size equals raw_size, skipped when size is 0. */
+    struct BrickEntry
+    {
+      uint64_t offset;
+      uint32_t size;
+      uint32_t raw_size;
+    };
 
     typedef boost::shared_ptr<std::vector<VoxelT> > VolumePtr;
     typedef boost::shared_ptr<std::vector<WeightT> > WeightsPtr;
@@ -39,7 +39,13 @@
 
 #include "tsdf_volume.h"
 
+#include <pcl/io/lzf.h>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <cstring>
 #include <fstream>
+#include <limits>
 
 
 template <typename VoxelT, typename WeightT> bool
@@ -154,6 +160,244 @@ pcl::TSDFVolume<VoxelT, WeightT>::save (const std::string &filename, bool binary
 }
 
 
+template <typename VoxelT, typename WeightT> bool
+pcl::TSDFVolume<VoxelT, WeightT>::saveChunked (const std::string &filename, int brick_size) const
+{
+  if (brick_size <= 0)
+  {
+    pcl::console::print_error ("[TSDFVolume::saveChunked] Error: Brick size must be positive (%d given).\n", brick_size);
+    return false;
+  }
+
+  pcl::console::print_info ("Saving chunked TSDF volume to "); pcl::console::print_value ("%s ... ", filename.c_str());
+  std::cout << std::flush;
+
+  std::ofstream file (filename.c_str(), std::ios_base::binary);
+  if (!file.is_open())
+  {
+    pcl::console::print_error ("[TSDFVolume::saveChunked] Error: Couldn't open file %s.\n", filename.c_str());
+    return false;
+  }
+
+  const Eigen::Vector3i &res = header_.resolution;
+  const Eigen::Vector3i bricks = (res.array() + brick_size - 1) / brick_size;
+  std::vector<BrickEntry> table (bricks.prod());
+
+  // value of the unobserved voxels, given back to the voxels of the skipped bricks
+  VoxelT empty_value = 0;
+  for (size_t i = 0; i < weights_->size(); ++i)
+  {
+    if ((*weights_)[i] == 0)
+    {
+      empty_value = (*volume_)[i];
+      break;
+    }
+  }
+
+  // HEADER, the brick table is written again once the offsets are known
+  file.write (TSDF_CHUNKED_MAGIC, 8);
+  file.write ((const char*) &header_, sizeof (Header));
+  file.write ((const char*) &brick_size, sizeof (int));
+  file.write ((const char*) &empty_value, sizeof (VoxelT));
+  const std::streamoff table_pos = file.tellp ();
+  file.write ((const char*) &table[0], table.size() * sizeof (BrickEntry));
+  uint64_t offset = table_pos + table.size() * sizeof (BrickEntry);
+
+  // DATA, the values of a brick then its weights, x first
+  std::vector<char> raw (brick_size * brick_size * brick_size * (sizeof (VoxelT) + sizeof (WeightT)));
+  std::vector<char> compressed (raw.size ());
+  int nb_stored = 0;
+
+  for (int bz = 0; bz < bricks[2]; ++bz)
+    for (int by = 0; by < bricks[1]; ++by)
+      for (int bx = 0; bx < bricks[0]; ++bx)
+      {
+        const Eigen::Vector3i begin = Eigen::Vector3i (bx, by, bz) * brick_size;
+        const Eigen::Vector3i end = (begin.array() + brick_size).min(res.array());
+        const int row = end[0] - begin[0];
+        const int nb_voxels = row * (end[1] - begin[1]) * (end[2] - begin[2]);
+
+        VoxelT *values = reinterpret_cast<VoxelT*> (&raw[0]);
+        WeightT *weights = reinterpret_cast<WeightT*> (&raw[nb_voxels * sizeof (VoxelT)]);
+        bool empty = true;
+        for (int z = begin[2], k = 0; z < end[2]; ++z)
+          for (int y = begin[1]; y < end[1]; ++y, k += row)
+          {
+            const int idx = getLinearVoxelIndex (Eigen::Array3i (begin[0], y, z));
+            for (int x = 0; x < row; ++x)
+            {
+              values[k + x] = (*volume_)[idx + x];
+              weights[k + x] = (*weights_)[idx + x];
+              empty = empty && weights[k + x] == 0 && values[k + x] == empty_value;
+            }
+          }
+
+        BrickEntry &entry = table[bx + (by + bz * bricks[1]) * bricks[0]];
+        entry.offset = offset;
+        entry.raw_size = static_cast<uint32_t> (nb_voxels * (sizeof (VoxelT) + sizeof (WeightT)));
+        entry.size = 0;
+        if (empty)
+          continue;
+
+        // bricks which do not compress are kept as they are
+        entry.size = pcl::lzfCompress (&raw[0], entry.raw_size, &compressed[0], entry.raw_size - 1);
+        if (entry.size == 0)
+        {
+          entry.size = entry.raw_size;
+          file.write (&raw[0], entry.size);
+        }
+        else
+          file.write (&compressed[0], entry.size);
+        offset += entry.size;
+        ++nb_stored;
+      }
+
+  file.seekp (table_pos);
+  file.write ((const char*) &table[0], table.size() * sizeof (BrickEntry));
+  file.close ();
+
+  if (!file)
+  {
+    pcl::console::print_error ("[TSDFVolume::saveChunked] Error: Couldn't write file %s.\n", filename.c_str());
+    return false;
+  }
+
+  pcl::console::print_info ("done [%d voxels, %d of %d bricks, %.1f MB]\n", this->size(), nb_stored, static_cast<int> (table.size()), offset / (1024.0 * 1024.0));
+
+  return true;
+}
+
+
+template <typename VoxelT, typename WeightT> bool
+pcl::TSDFVolume<VoxelT, WeightT>::loadChunked (const std::string &filename)
+{
+  return loadChunkedRegion (filename, Eigen::Vector3i::Zero (), Eigen::Vector3i::Constant (std::numeric_limits<int>::max ()));
+}
+
+
+template <typename VoxelT, typename WeightT> bool
+pcl::TSDFVolume<VoxelT, WeightT>::loadChunkedRegion (const std::string &filename, const Eigen::Vector3i &min, const Eigen::Vector3i &max)
+{
+  pcl::console::print_info ("Loading chunked TSDF volume from "); pcl::console::print_value ("%s ... ", filename.c_str());
+  std::cout << std::flush;
+
+  boost::iostreams::mapped_file_source map;
+  try
+  {
+    map.open (filename);
+  }
+  catch (const std::exception &e)
+  {
+    pcl::console::print_error ("[TSDFVolume::loadChunkedRegion] Error: Couldn't map file %s (%s).\n", filename.c_str(), e.what ());
+    return false;
+  }
+  const char *data = map.data ();
+  const size_t file_size = map.size ();
+
+  // read HEADER
+  const size_t header_size = 8 + sizeof (Header) + sizeof (int) + sizeof (VoxelT);
+  if (file_size < header_size || memcmp (data, TSDF_CHUNKED_MAGIC, 8) != 0)
+  {
+    pcl::console::print_error ("[TSDFVolume::loadChunkedRegion] Error: %s is not a chunked TSDF file.\n", filename.c_str());
+    return false;
+  }
+  Header header;
+  int brick_size;
+  VoxelT empty_value;
+  memcpy ((char*) &header, data + 8, sizeof (Header));
+  memcpy (&brick_size, data + 8 + sizeof (Header), sizeof (int));
+  memcpy (&empty_value, data + 8 + sizeof (Header) + sizeof (int), sizeof (VoxelT));
+
+  // check if element size fits to data
+  if (header.volume_element_size != sizeof(VoxelT))
+  {
+    pcl::console::print_error ("[TSDFVolume::loadChunkedRegion] Error: Given volume element size (%d) doesn't fit data (%d)", sizeof(VoxelT), header.volume_element_size);
+    return false;
+  }
+  if (header.weights_element_size != sizeof(WeightT))
+  {
+    pcl::console::print_error ("[TSDFVolume::loadChunkedRegion] Error: Given weights element size (%d) doesn't fit data (%d)", sizeof(WeightT), header.weights_element_size);
+    return false;
+  }
+
+  const Eigen::Vector3i &res = header.resolution;
+  const Eigen::Vector3i bricks = (res.array() + brick_size - 1) / brick_size;
+  const char *table = data + header_size;
+  if (brick_size <= 0 || file_size < header_size + bricks.prod() * sizeof (BrickEntry))
+  {
+    pcl::console::print_error ("[TSDFVolume::loadChunkedRegion] Error: Brick table of %s is truncated.\n", filename.c_str());
+    return false;
+  }
+
+  const Eigen::Vector3i lo = min.cwiseMax (Eigen::Vector3i::Zero ());
+  const Eigen::Vector3i hi = max.cwiseMin (res);
+  if ((hi.array() <= lo.array()).any())
+  {
+    pcl::console::print_error ("[TSDFVolume::loadChunkedRegion] Error: Region is outside of the volume %s.\n", filename.c_str());
+    return false;
+  }
+
+  const Eigen::Vector3i region = hi - lo;
+  header_ = Header (region, header.volume_size.array() * region.cast<float>().array() / res.cast<float>().array());
+  volume_->assign (header_.getVolumeSize(), empty_value);
+  weights_->assign (header_.getVolumeSize(), 0);
+
+  // read DATA of the bricks overlapping the region
+  std::vector<char> raw (brick_size * brick_size * brick_size * (sizeof (VoxelT) + sizeof (WeightT)));
+  const Eigen::Vector3i first = lo / brick_size;
+  const Eigen::Vector3i last = (hi.array() - 1) / brick_size;
+
+  for (int bz = first[2]; bz <= last[2]; ++bz)
+    for (int by = first[1]; by <= last[1]; ++by)
+      for (int bx = first[0]; bx <= last[0]; ++bx)
+      {
+        BrickEntry entry;
+        memcpy (&entry, table + (bx + (by + bz * bricks[1]) * bricks[0]) * sizeof (BrickEntry), sizeof (BrickEntry));
+        if (entry.size == 0)
+          continue;
+
+        const Eigen::Vector3i begin = Eigen::Vector3i (bx, by, bz) * brick_size;
+        const Eigen::Vector3i end = (begin.array() + brick_size).min(res.array());
+        const int row = end[0] - begin[0];
+        const int nb_voxels = row * (end[1] - begin[1]) * (end[2] - begin[2]);
+
+        if (entry.raw_size != nb_voxels * (sizeof (VoxelT) + sizeof (WeightT)) || entry.offset + entry.size > file_size)
+        {
+          pcl::console::print_error ("[TSDFVolume::loadChunkedRegion] Error: Brick (%d, %d, %d) of %s is corrupted.\n", bx, by, bz, filename.c_str());
+          return false;
+        }
+
+        const char *brick = data + entry.offset;
+        if (entry.size != entry.raw_size)
+        {
+          if (pcl::lzfDecompress (brick, entry.size, &raw[0], entry.raw_size) != entry.raw_size)
+          {
+            pcl::console::print_error ("[TSDFVolume::loadChunkedRegion] Error: Couldn't decompress brick (%d, %d, %d) of %s.\n", bx, by, bz, filename.c_str());
+            return false;
+          }
+          brick = &raw[0];
+        }
+
+        // copy the rows of the brick lying in the region
+        const Eigen::Vector3i from = begin.cwiseMax (lo);
+        const Eigen::Vector3i to = end.cwiseMin (hi);
+        const int length = to[0] - from[0];
+        for (int z = from[2]; z < to[2]; ++z)
+          for (int y = from[1]; y < to[1]; ++y)
+          {
+            const int k = (from[0] - begin[0]) + row * ((y - begin[1]) + (z - begin[2]) * (end[1] - begin[1]));
+            const int idx = getLinearVoxelIndex (Eigen::Array3i (from[0] - lo[0], y - lo[1], z - lo[2]));
+            memcpy (&(*volume_)[idx], brick + k * sizeof (VoxelT), length * sizeof (VoxelT));
+            memcpy (&(*weights_)[idx], brick + nb_voxels * sizeof (VoxelT) + k * sizeof (WeightT), length * sizeof (WeightT));
+          }
+      }
+
+  pcl::console::print_info ("done [%d voxels, res %dx%dx%d]\n", this->size(), region[0], region[1], region[2]);
+
+  return true;
+}
+
+
 template <typename VoxelT, typename WeightT> void
 pcl::TSDFVolume<VoxelT, WeightT>::convertToTsdfCloud (pcl::PointCloud<pcl::PointXYZI>::Ptr &cloud) const
 {
@@ -497,58 +741,23 @@ pcl::TSDFVolume<VoxelT, WeightT>::averageValues ()
 }
 
 
-/*template <typename VoxelT, typename WeightT> template <typename PointT> void
+template <typename VoxelT, typename WeightT> template <typename PointT> void
 pcl::TSDFVolume<VoxelT, WeightT>::createFromCloud (const typename pcl::PointCloud<PointT>::ConstPtr &cloud, const Intr &intr)
 {
-  // get depth map from cloud
-  float bad_point = std::numeric_limits<float>::quiet_NaN ();
-  // Eigen::MatrixXf depth = Eigen::MatrixXf::Constant(cloud_->height, cloud_->width, bad_point);
-  Eigen::MatrixXf depth (cloud->height, cloud->width);
-
-  // determine max and min value
-  float min = 3000.0, max = 0.0;
-  for (int x = 0; x < cloud->width; ++x)
-    for (int y = 0; y < cloud->height; ++y)
+  // get depth map from the organized cloud, invalid points are set to 0
+  Eigen::MatrixXf depth = Eigen::MatrixXf::Zero (cloud->height, cloud->width);
+  for (int y = 0; y < static_cast<int> (cloud->height); ++y)
+    for (int x = 0; x < static_cast<int> (cloud->width); ++x)
     {
-      depth(y,x) = cloud->at(x,y).z;
-      if (!isnan(depth(y,x)))
-      {
-        if (depth(y,x) > max) max = depth(y,x);
-        if (depth(y,x) < min) min = depth(y,x);
-      }
+      const PointT &p = cloud->at (x, y);
+      if (pcl_isfinite (p.z) && p.z > 0)
+        depth (y, x) = p.z;
     }
 
-  std::cout << "  depth size = " << depth.rows() << "x" << depth.cols() << ", min/max = " << min << "/" << max << std::endl;
-
-
-  // BOOST_FOREACH (const PointT &p, cloud->points)
-  typename pcl::PointCloud<PointT>::const_iterator iter = cloud->begin();
-  for (; iter != cloud_>end(); ++iter)
-  {
-    const PointT &p = *iter;
-
-    std::cout << "orig point = " << p << std::endl;
-
-    Eigen::Array2f point (intr.fx * p.x + intr.cx * p.z,
-                          intr.fx * p.y + intr.cy * p.z);
-    Eigen::Array2i pixel (round(point(0))/p.z, round(point(1))/p.z);
-
-    std::cout << "point = " << point.transpose() << std::endl;
-    std::cout << "pixel = " << pixel.transpose() << std::endl;
-
-    depth (pixel(1), pixel(0)) = p.z;
-  }
-
-  std::cout << "  scaling depth map" << std::endl;
-  // scale depth map
   Eigen::MatrixXf depth_scaled;
-  // scaleDepth (depth, depth_scaled, intr);
-  // TODO find out what this should do! projection on unit sphere?!
-  depth_scaled = depth;
+  scaleDepth (depth, depth_scaled, intr);
 
-  // generate volume
-  // std::cout << " generating volume" << std::endl;
-  // resizeDefaultSize();
+  // same initial pose as the KinfuTracker: camera in front of the volume, looking along Z
   Eigen::Vector3f volume_size = volumeSize();
   Eigen::Vector3f voxel_size = voxelSize();
 
@@ -556,128 +765,263 @@ pcl::TSDFVolume<VoxelT, WeightT>::createFromCloud (const typename pcl::PointClou
 
   Eigen::Matrix3f R_inv_init = Eigen::Matrix3f::Identity();
   Eigen::Vector3f t_init =  volume_size * 0.5f - Eigen::Vector3f (0, 0, volume_size(2)/2.0f * 1.2f);
-  // std::cout << "initial pose: R_inv = " << R_inv_init << ", t_init = " << t_init.transpose() << std::endl;
 
-  std::cout << "  integrating values" << std::endl;
   integrateVolume (depth_scaled, tranc_dist, R_inv_init, t_init, intr);
-}*/
+}
 
 
-/*template <typename VoxelT, typename WeightT> void
+template <typename VoxelT, typename WeightT> void
 pcl::TSDFVolume<VoxelT, WeightT>::scaleDepth (const Eigen::MatrixXf &depth, Eigen::MatrixXf &depth_scaled, const Intr &intr) const
 {
   // function ported from KinFu GPU code
   depth_scaled.resizeLike (depth);
 
-  float min = 3000.0, max = 0.0;
-  // loop over depth image
   for (int x = 0; x < depth.cols(); ++x)
+  {
+    float xl = (x - intr.cx) / intr.fx;
     for (int y = 0; y < depth.rows(); ++y)
     {
-      int Dp = depth(y,x);
-
-      float xl = (x - intr.cx) / intr.fx;
       float yl = (y - intr.cy) / intr.fy;
       float lambda = sqrtf (xl * xl + yl * yl + 1);
 
-      depth_scaled(y,x) = Dp * lambda;
-
-      if (!isnan(depth_scaled(y,x)))
-      {
-        if (depth_scaled(y,x) > max) max = depth_scaled(y,x);
-        if (depth_scaled(y,x) < min) min = depth_scaled(y,x);
-      }
+      float Dp = depth(y,x);
+      depth_scaled(y,x) = pcl_isfinite (Dp) ? Dp * lambda : 0.0f;
     }
-
-  std::cout << "depth_scaled size = " << depth_scaled.rows() << "x" << depth_scaled.cols() << ", min/max = " << min << "/" << max << std::endl;
-}*/
+  }
+}
 
 
-/*template <typename VoxelT, typename WeightT> void
+template <typename VoxelT, typename WeightT> void
 pcl::TSDFVolume<VoxelT, WeightT>::integrateVolume (const Eigen::MatrixXf &depth_scaled,
-                                              float tranc_dist,
-                                              const Eigen::Matrix3f &R_inv,
-                                              const Eigen::Vector3f &t,
-                                              const Intr &intr)
+                                                   float tranc_dist,
+                                                   const Eigen::Matrix3f &R_inv,
+                                                   const Eigen::Vector3f &t,
+                                                   const Intr &intr,
+                                                   int max_weight,
+                                                   unsigned int nr_threads)
 {
-  Eigen::Array3f voxel_size = voxelSize();
-  Eigen::Array3i volume_res = gridResolution();
-  Eigen::Array3f intr_arr (intr.fx, intr.fy, 1.0f);
-  Eigen::Array3i voxel_coord (0,0,0);
+  const Eigen::Vector3f cell_size = voxelSize();
+  const Eigen::Vector3i volume_res = gridResolution();
 
-  // loop over grid in X and Y dimension
-  #pragma omp parallel for
-  // for (voxel_coord(0) = 0; voxel_coord(0) < volume_res(0); ++voxel_coord(0))
-  for (int i = 0; i < volume_res(0); ++i)
+  if (volume_->size () != size () || weights_->size () != size ())
   {
-    voxel_coord(0) = i;
+    pcl::console::print_error ("[TSDFVolume::integrateVolume] Error: Volume storage (%d) doesn't fit header size (%d)\n", volume_->size(), size());
+    return;
+  }
 
-    // std::stringstream ss;
-    // ss << voxel_coord(0) << "/" << volume_res(0) << " ";
-    // std::cout << ss.str();
-    std::cout << ". " << std::flush;
+  const int cols = static_cast<int> (depth_scaled.cols ());
+  const int rows = static_cast<int> (depth_scaled.rows ());
+  const float *depth = depth_scaled.data ();     // column major: depth_scaled(y,x) = depth[x * rows + y]
 
-    for (voxel_coord(1) = 0; voxel_coord(1) < volume_res(1); ++voxel_coord(1))
-    {
-      voxel_coord(2) = 0;
-      // points at depth 0, shifted by t
-      Eigen::Vector3f v_g = (voxel_coord.cast<float>() + 0.5f) * voxel_size - t.array();
-      float v_g_part_norm = v_g(0)*v_g(0) + v_g(1)*v_g(1);
+  VoxelT  *volume  = &(*volume_)[0];
+  WeightT *weights = &(*weights_)[0];
+
+  const float tranc_dist_inv = 1.0f / tranc_dist;
 
-      // rays in 3d
-      Eigen::Vector3f v = (R_inv * v_g).array() * intr_arr;
+  // camera space increments for a step of one voxel along X, pre-multiplied by the focal lengths
+  const float step_x = R_inv(0,0) * cell_size(0) * intr.fx;
+  const float step_y = R_inv(1,0) * cell_size(0) * intr.fy;
+  const float step_z = R_inv(2,0) * cell_size(0);
+
+  const int threads = getNumberOfThreads (nr_threads);
+
+  // one slab of Z per thread, each voxel is only touched by the thread owning its slab
+  #pragma omp parallel for schedule(static) num_threads(threads)
+  for (int z = 0; z < volume_res(2); ++z)
+  {
+    const float v_g_z = (z + 0.5f) * cell_size(2) - t(2);
+
+    for (int y = 0; y < volume_res(1); ++y)
+    {
+      const float v_g_y = (y + 0.5f) * cell_size(1) - t(1);
+      const float v_g_part_norm = v_g_y * v_g_y + v_g_z * v_g_z;
 
-      float z_scaled = 0;
+      float v_g_x = 0.5f * cell_size(0) - t(0);
 
-      Eigen::Array3f R_inv_z_scaled = R_inv.col(2).array() * voxel_size(2) * intr_arr;
+      float v_x = (R_inv(0,0) * v_g_x + R_inv(0,1) * v_g_y + R_inv(0,2) * v_g_z) * intr.fx;
+      float v_y = (R_inv(1,0) * v_g_x + R_inv(1,1) * v_g_y + R_inv(1,2) * v_g_z) * intr.fy;
+      float v_z = (R_inv(2,0) * v_g_x + R_inv(2,1) * v_g_y + R_inv(2,2) * v_g_z);
 
-      float tranc_dist_inv = 1.0f / tranc_dist;
+      const size_t row_offset = static_cast<size_t> (volume_res(0)) * (y + static_cast<size_t> (volume_res(1)) * z);
+      VoxelT  *tsdf_row   = volume + row_offset;
+      WeightT *weight_row = weights + row_offset;
 
-      // loop over depth values
-      for (voxel_coord(2) = 0; voxel_coord(2) < volume_res(2); ++voxel_coord(2),
-           v_g(2) += voxel_size(2),
-           z_scaled += voxel_size(2),
-           v(0) += R_inv_z_scaled(0),
-           v(1) += R_inv_z_scaled(1))
+      for (int x = 0; x < volume_res(0); ++x,
+           v_g_x += cell_size(0),
+           v_x += step_x,
+           v_y += step_y,
+           v_z += step_z)
       {
-        float inv_z = 1.0f / (v(2) + R_inv(2,2) * z_scaled);
+        if (v_z <= 0)
+          continue;
 
-        // std::cout << "z = " << voxel_coord(2) << ", inv_z = " << inv_z << std::endl;
+        // project to current cam
+        const float inv_z = 1.0f / v_z;
+        const int coo_x = cvRound (v_x * inv_z + intr.cx);
+        const int coo_y = cvRound (v_y * inv_z + intr.cy);
 
-        if (inv_z < 0)
+        if (coo_x < 0 || coo_y < 0 || coo_x >= cols || coo_y >= rows)
           continue;
 
-        // project to camera
-        Eigen::Array2i img_coord (round(v(0) * inv_z + intr.cx),
-                                  round(v(1) * inv_z + intr.cy));
+        const float Dp_scaled = depth[coo_x * rows + coo_y];
 
-        // std::cout << "img_coord = " << img_coord.transpose() << std::endl;
+        // signed distance function
+        const float sdf = Dp_scaled - sqrtf (v_g_x * v_g_x + v_g_part_norm);
 
-        if (img_coord(0) >= 0 && img_coord(1) >= 0 && img_coord(0) < depth_scaled.cols() && img_coord(1) < depth_scaled.rows())         //6
+        if (Dp_scaled != 0 && sdf >= -tranc_dist)
         {
-          float Dp_scaled = depth_scaled(img_coord(1), img_coord(0));
+          // get truncated distance function value
+          const float tsdf = std::min (1.0f, sdf * tranc_dist_inv);
+
+          const int weight_prev = weight_row[x];
+          tsdf_row[x] = static_cast<VoxelT> ((tsdf_row[x] * weight_prev + tsdf) / (weight_prev + 1));
+          weight_row[x] = static_cast<WeightT> (std::min (weight_prev + 1, max_weight));
+        }
+      } // loop over X
+    }
+  }
+}
+
+
+template <typename VoxelT, typename WeightT> float
+pcl::TSDFVolume<VoxelT, WeightT>::interpolateTrilinearly (const Eigen::Vector3f &point) const
+{
+  const Eigen::Vector3i &res = header_.resolution;
+
+  Eigen::Vector3i g (static_cast<int> (floorf (point(0))), static_cast<int> (floorf (point(1))), static_cast<int> (floorf (point(2))));
+
+  if (g(0) <= 0 || g(0) >= res(0) - 1 || g(1) <= 0 || g(1) >= res(1) - 1 || g(2) <= 0 || g(2) >= res(2) - 1)
+    return (std::numeric_limits<float>::quiet_NaN ());
+
+  float a = point(0) - (g(0) + 0.5f); if (a < 0) { g(0)--; a += 1.0f; }
+  float b = point(1) - (g(1) + 0.5f); if (b < 0) { g(1)--; b += 1.0f; }
+  float c = point(2) - (g(2) + 0.5f); if (c < 0) { g(2)--; c += 1.0f; }
+
+  const int step_y = res(0);
+  const int step_z = res(0) * res(1);
+  const VoxelT *v = &(*volume_)[getLinearVoxelIndex (g.array ())];
+
+  return ((1 - a) * ((1 - b) * (v[0]               * (1 - c) + v[step_z]               * c) +
+                          b  * (v[step_y]          * (1 - c) + v[step_y + step_z]      * c)) +
+               a  * ((1 - b) * (v[1]               * (1 - c) + v[1 + step_z]           * c) +
+                          b  * (v[1 + step_y]      * (1 - c) + v[1 + step_y + step_z]  * c)));
+}
+
+
+template <typename VoxelT, typename WeightT> void
+pcl::TSDFVolume<VoxelT, WeightT>::raycast (const Eigen::Matrix3f &R, const Eigen::Vector3f &t, const Intr &intr, float tranc_dist,
+                                           int cols, int rows,
+                                           pcl::PointCloud<pcl::PointXYZ> &vmap, pcl::PointCloud<pcl::Normal> &nmap,
+                                           unsigned int nr_threads) const
+{
+  const float qnan = std::numeric_limits<float>::quiet_NaN ();
+
+  vmap.width = nmap.width = cols;
+  vmap.height = nmap.height = rows;
+  vmap.is_dense = nmap.is_dense = false;
+  vmap.points.resize (static_cast<size_t> (cols) * rows);
+  nmap.points.resize (static_cast<size_t> (cols) * rows);
+
+  const Eigen::Array3f cell_size = voxelSize().array();
+  const Eigen::Array3f volume_size = volumeSize().array();
+  const Eigen::Vector3i &res = header_.resolution;
+
+  const float time_step = tranc_dist * 0.8f;
+  // infinite loop guard
+  const float max_time = 3 * (volume_size(0) + volume_size(1) + volume_size(2));
 
-          // signed distance function
-          float sdf = Dp_scaled - sqrtf (v_g(2) * v_g(2) + v_g_part_norm);
+  const int threads = getNumberOfThreads (nr_threads);
 
-          if (Dp_scaled != 0 && sdf >= -tranc_dist)
+  #pragma omp parallel for schedule(dynamic, 4) num_threads(threads)
+  for (int y = 0; y < rows; ++y)
+  {
+    for (int x = 0; x < cols; ++x)
+    {
+      pcl::PointXYZ &vertex = vmap.points[y * cols + x];
+      pcl::Normal &normal = nmap.points[y * cols + x];
+      vertex.x = vertex.y = vertex.z = qnan;
+      normal.normal_x = normal.normal_y = normal.normal_z = normal.curvature = qnan;
+
+      Eigen::Array3f ray_dir = (R * Eigen::Vector3f ((x - intr.cx) / intr.fx, (y - intr.cy) / intr.fy, 1)).normalized ().array ();
+
+      //ensure that it isn't a degenerate case
+      for (int i = 0; i < 3; ++i)
+        ray_dir(i) = (ray_dir(i) == 0.f) ? 1e-15f : ray_dir(i);
+
+      // time when the ray enters and exits the volume
+      const Eigen::Array3f ray_start = t.array ();
+      Eigen::Array3f t_min = ((ray_dir > 0).select (Eigen::Array3f::Zero (), volume_size) - ray_start) / ray_dir;
+      Eigen::Array3f t_max = ((ray_dir > 0).select (volume_size, Eigen::Array3f::Zero ()) - ray_start) / ray_dir;
+
+      float time_curr = std::max (t_min.maxCoeff (), 0.f);
+      if (time_curr >= t_max.minCoeff ())
+        continue;
+
+      // the ray in voxel units, the marching only needs floor () on it
+      const Eigen::Array3f ray_start_vox = ray_start / cell_size;
+      const Eigen::Array3f ray_dir_vox = ray_dir / cell_size;
+
+      Eigen::Array3i g = (ray_start_vox + ray_dir_vox * time_curr).floor ().template cast<int> ();
+      for (int i = 0; i < 3; ++i)
+        g(i) = std::max (0, std::min (g(i), res(i) - 1));
+
+      float tsdf = (*volume_)[getLinearVoxelIndex (g)];
+
+      for (; time_curr < max_time; time_curr += time_step)
+      {
+        float tsdf_prev = tsdf;
+
+        g = (ray_start_vox + ray_dir_vox * (time_curr + time_step)).floor ().template cast<int> ();
+        if ((g < 0).any () || (g >= res.array ()).any ())
+          break;
+
+        tsdf = (*volume_)[getLinearVoxelIndex (g)];
+
+        if (tsdf_prev < 0.f && tsdf >= 0.f)
+          break;
+
+        if (tsdf_prev >= 0.f && tsdf < 0.f)           //zero crossing
+        {
+          float Ftdt = interpolateTrilinearly ((ray_start_vox + ray_dir_vox * (time_curr + time_step)).matrix ());
+          if (pcl_isnan (Ftdt))
+            break;
+
+          float Ft = interpolateTrilinearly ((ray_start_vox + ray_dir_vox * time_curr).matrix ());
+          if (pcl_isnan (Ft))
+            break;
+
+          float Ts = time_curr - time_step * Ft / (Ftdt - Ft);
+
+          Eigen::Array3f vertex_found = ray_start + ray_dir * Ts;
+          vertex.x = vertex_found(0);
+          vertex.y = vertex_found(1);
+          vertex.z = vertex_found(2);
+
+          g = (ray_start_vox + ray_dir_vox * time_curr).floor ().template cast<int> ();
+          if ((g > 1).all () && (g < res.array () - 2).all ())
           {
-            // get truncated distance function value
-            float tsdf = fmin (1.0f, sdf * tranc_dist_inv);
-
-            // add values to volume
-            int idx = getLinearVoxelIndex (voxel_coord);
-            VoxelT &tsdf_val = volume_->at(idx);
-            short  &weight   = weights_->at(idx);
-            tsdf_val = tsdf_val * weight + tsdf;
-            weight += 1;
+            // central differences, one voxel away from the vertex
+            Eigen::Vector3f p = (vertex_found / cell_size).matrix ();
+            Eigen::Vector3f n;
+            for (int i = 0; i < 3; ++i)
+            {
+              Eigen::Vector3f p1 = p, p2 = p;
+              p1(i) += 1.0f;
+              p2(i) -= 1.0f;
+              n(i) = interpolateTrilinearly (p1) - interpolateTrilinearly (p2);
+            }
+            n.normalize ();
+
+            normal.normal_x = n(0);
+            normal.normal_y = n(1);
+            normal.normal_z = n(2);
           }
+          break;
         }
-      } // loop over depths
+      } // loop over the ray
     }
   }
-  std::cout << std::endl;
-}*/
+}
 
 #define PCL_INSTANTIATE_TSDFVolume(VT,WT) template class PCL_EXPORTS pcl::reconstruction::TSDFVolume<VT,WT>;
 
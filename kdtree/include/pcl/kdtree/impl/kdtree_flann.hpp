@@ -69,11 +69,65 @@ pcl::KdTreeFLANN<PointT, Dist>::setInputCloud (const PointCloudConstPtr &cloud,
   }
   total_nr_points_ = static_cast<int> (index_mapping_.size ());
 
-  flann_index_ = new FLANNIndex (flann::Matrix<float> (cloud_, index_mapping_.size (), dim_),
-                                 flann::KDTreeSingleIndexParams (15)); // max 15 points/leaf
+  // Without a copy of the data, the points are indexed in place, FLANN skipping the padding of each point
+  flann::Matrix<float> data (cloud_, index_mapping_.size (), dim_);
+  if (cloud_ == NULL && !index_mapping_.empty ())
+    data = flann::Matrix<float> (const_cast<float*> (reinterpret_cast<const float*> (&input_->points[0])), 
+                                 index_mapping_.size (), dim_, sizeof (PointT));
+
+  flann_index_ = new FLANNIndex (data, flann::KDTreeSingleIndexParams (15)); // max 15 points/leaf
   flann_index_->buildIndex ();
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, typename Dist> void 
+pcl::KdTreeFLANN<PointT, Dist>::addPoints (const PointCloudConstPtr &cloud)
+{
+  if (!flann_index_ || !input_)
+  {
+    setInputCloud (cloud);
+    return;
+  }
+  if (indices_)
+  {
+    PCL_ERROR ("[pcl::KdTreeFLANN::addPoints] Points can not be added to a tree built on a set of indices!\n");
+    return;
+  }
+  if (!cloud || cloud->points.size () < input_->points.size ())
+  {
+    PCL_ERROR ("[pcl::KdTreeFLANN::addPoints] The new cloud must extend the input cloud!\n");
+    return;
+  }
+
+  AddedIndex added;
+  for (int cloud_index = static_cast<int> (input_->points.size ()); cloud_index < static_cast<int> (cloud->points.size ()); ++cloud_index)
+  {
+    if (point_representation_->isValid (cloud->points[cloud_index]))
+      added.mapping.push_back (cloud_index);
+  }
+  input_ = cloud;
+  if (added.mapping.empty ())
+    return;
+
+  // Once the added points outnumber the points of the main tree, rebuilding everything is cheaper than searching
+  total_nr_points_ += static_cast<int> (added.mapping.size ());
+  if (total_nr_points_ > 2 * static_cast<int> (index_mapping_.size ()))
+  {
+    setInputCloud (cloud);
+    return;
+  }
+
+  // Merge the last trees as long as they have similar sizes, which keeps a logarithmic number of trees
+  added_.push_back (added);
+  while (added_.size () > 1 && added_[added_.size () - 2].mapping.size () <= 2 * added_.back ().mapping.size ())
+  {
+    std::vector<int> &mapping = added_[added_.size () - 2].mapping;
+    mapping.insert (mapping.end (), added_.back ().mapping.begin (), added_.back ().mapping.end ());
+    added_.pop_back ();
+  }
+  buildAddedIndex (added_.back ());
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT, typename Dist> int 
 pcl::KdTreeFLANN<PointT, Dist>::nearestKSearch (const PointT &point, int k, 
@@ -91,23 +145,84 @@ pcl::KdTreeFLANN<PointT, Dist>::nearestKSearch (const PointT &point, int k,
   std::vector<float> query (dim_);
   point_representation_->vectorize (static_cast<PointT> (point), query);
 
-  flann::Matrix<int> k_indices_mat (&k_indices[0], 1, k);
-  flann::Matrix<float> k_distances_mat (&k_distances[0], 1, k);
+  const int k_main = std::min (k, static_cast<int> (index_mapping_.size ()));
+  flann::Matrix<int> k_indices_mat (&k_indices[0], 1, k_main);
+  flann::Matrix<float> k_distances_mat (&k_distances[0], 1, k_main);
   // Wrap the k_indices and k_distances vectors (no data copy)
   flann_index_->knnSearch (flann::Matrix<float> (&query[0], 1, dim_), 
                            k_indices_mat, k_distances_mat,
-                           k, param_k_);
+                           k_main, param_k_);
 
   // Do mapping to original point cloud
   if (!identity_mapping_) 
   {
-    for (size_t i = 0; i < static_cast<size_t> (k); ++i)
+    for (size_t i = 0; i < static_cast<size_t> (k_main); ++i)
     {
       int& neighbor_index = k_indices[i];
       neighbor_index = index_mapping_[neighbor_index];
     }
   }
 
+  if (!added_.empty ())
+    addedKSearch (&query[0], k, k_main, &k_indices[0], &k_distances[0]);
+
+  return (k);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, typename Dist> int 
+pcl::KdTreeFLANN<PointT, Dist>::batchNearestKSearch (const PointCloud &cloud, const std::vector<int> &indices, int k, 
+                                                     std::vector<int> &k_indices, std::vector<float> &k_distances, 
+                                                     unsigned int nr_threads) const
+{
+  const int nr_queries = static_cast<int> (indices.empty () ? cloud.points.size () : indices.size ());
+
+  if (k > total_nr_points_)
+    k = total_nr_points_;
+
+  k_indices.resize (static_cast<size_t> (nr_queries) * k);
+  k_distances.resize (static_cast<size_t> (nr_queries) * k);
+  if (nr_queries == 0 || k <= 0)
+    return (0);
+
+  std::vector<float> queries (static_cast<size_t> (nr_queries) * dim_);
+#pragma omp parallel for num_threads (nr_threads)
+  for (int query = 0; query < nr_queries; ++query)
+  {
+    float* query_ptr = &queries[static_cast<size_t> (query) * dim_];
+    point_representation_->vectorize (cloud.points[indices.empty () ? query : indices[query]], query_ptr);
+  }
+
+  // One FLANN call per block of queries. The rows keep room for the neighbors found in the added trees.
+  const int k_main = std::min (k, static_cast<int> (index_mapping_.size ()));
+  const int block_size = 256;
+  const int nr_blocks = (nr_queries + block_size - 1) / block_size;
+#pragma omp parallel for schedule (dynamic) num_threads (nr_threads)
+  for (int block = 0; block < nr_blocks; ++block)
+  {
+    const size_t begin = static_cast<size_t> (block) * block_size;
+    const size_t size = std::min (static_cast<size_t> (nr_queries) - begin, static_cast<size_t> (block_size));
+
+    flann::Matrix<int> k_indices_mat (&k_indices[begin * k], size, k_main, k * sizeof (int));
+    flann::Matrix<float> k_distances_mat (&k_distances[begin * k], size, k_main, k * sizeof (float));
+    flann_index_->knnSearch (flann::Matrix<float> (&queries[begin * dim_], size, dim_), 
+                             k_indices_mat, k_distances_mat,
+                             k_main, param_k_);
+
+    for (size_t query = begin; query < begin + size; ++query)
+    {
+      // Do mapping to original point cloud
+      if (!identity_mapping_) 
+      {
+        for (size_t i = query * k; i < query * k + k_main; ++i)
+          k_indices[i] = index_mapping_[k_indices[i]];
+      }
+
+      if (!added_.empty ())
+        addedKSearch (&queries[query * dim_], k, k_main, &k_indices[query * k], &k_distances[query * k]);
+    }
+  }
+
   return (k);
 }
 
@@ -153,6 +268,9 @@ pcl::KdTreeFLANN<PointT, Dist>::radiusSearch (const PointT &point, double radius
     }
   }
 
+  if (!added_.empty ())
+    neighbors_in_radius = addedRadiusSearch (&query[0], radius, max_nn, k_indices, k_sqr_dists);
+
   return (neighbors_in_radius);
 }
 
@@ -170,6 +288,7 @@ pcl::KdTreeFLANN<PointT, Dist>::cleanup ()
     cloud_ = NULL;
   }
   index_mapping_.clear ();
+  added_.clear ();
 
   if (indices_)
     indices_.reset ();
@@ -188,8 +307,6 @@ pcl::KdTreeFLANN<PointT, Dist>::convertCloudToArray (const PointCloud &cloud)
 
   int original_no_of_points = static_cast<int> (cloud.points.size ());
 
-  cloud_ = static_cast<float*> (malloc (original_no_of_points * dim_ * sizeof (float)));
-  float* cloud_ptr = cloud_;
   index_mapping_.reserve (original_no_of_points);
   identity_mapping_ = true;
 
@@ -203,10 +320,17 @@ pcl::KdTreeFLANN<PointT, Dist>::convertCloudToArray (const PointCloud &cloud)
     }
 
     index_mapping_.push_back (cloud_index);
+  }
 
-    point_representation_->vectorize (cloud.points[cloud_index], cloud_ptr);
-    cloud_ptr += dim_;
+  // A dense cloud of points made of their first dim_ floats is indexed in place
+  if (identity_mapping_ && point_representation_->isTrivial ())
+  {
+    cloud_ = NULL;
+    return;
   }
+
+  cloud_ = static_cast<float*> (malloc (index_mapping_.size () * dim_ * sizeof (float)));
+  vectorizePoints (cloud, index_mapping_, cloud_);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
@@ -222,8 +346,6 @@ pcl::KdTreeFLANN<PointT, Dist>::convertCloudToArray (const PointCloud &cloud, co
 
   int original_no_of_points = static_cast<int> (indices.size ());
 
-  cloud_ = static_cast<float*> (malloc (original_no_of_points * dim_ * sizeof (float)));
-  float* cloud_ptr = cloud_;
   index_mapping_.reserve (original_no_of_points);
   // its a subcloud -> false
   // true only identity: 
@@ -242,10 +364,110 @@ pcl::KdTreeFLANN<PointT, Dist>::convertCloudToArray (const PointCloud &cloud, co
 
     // map from 0 - N -> indices [0] - indices [N]
     index_mapping_.push_back (*iIt);  // If the returned index should be for the indices vector
-    
-    point_representation_->vectorize (cloud.points[*iIt], cloud_ptr);
-    cloud_ptr += dim_;
   }
+
+  cloud_ = static_cast<float*> (malloc (index_mapping_.size () * dim_ * sizeof (float)));
+  vectorizePoints (cloud, index_mapping_, cloud_);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, typename Dist> void 
+pcl::KdTreeFLANN<PointT, Dist>::vectorizePoints (const PointCloud &cloud, const std::vector<int> &indices, float* data) const
+{
+#pragma omp parallel for
+  for (int i = 0; i < static_cast<int> (indices.size ()); ++i)
+  {
+    float* data_ptr = data + static_cast<size_t> (i) * dim_;
+    point_representation_->vectorize (cloud.points[indices[i]], data_ptr);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, typename Dist> void 
+pcl::KdTreeFLANN<PointT, Dist>::buildAddedIndex (AddedIndex &added)
+{
+  added.data.resize (added.mapping.size () * dim_);
+  vectorizePoints (*input_, added.mapping, &added.data[0]);
+
+  added.index.reset (new FLANNIndex (flann::Matrix<float> (&added.data[0], added.mapping.size (), dim_),
+                                     flann::KDTreeSingleIndexParams (15))); // max 15 points/leaf
+  added.index->buildIndex ();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, typename Dist> void 
+pcl::KdTreeFLANN<PointT, Dist>::addedKSearch (float* query, int k, int nr_found, int* k_indices, float* k_distances) const
+{
+  std::vector<int> indices (k), merged_indices (k);
+  std::vector<float> distances (k), merged_distances (k);
+
+  for (size_t a = 0; a < added_.size (); ++a)
+  {
+    const int nr_added = std::min (k, static_cast<int> (added_[a].mapping.size ()));
+    flann::Matrix<int> indices_mat (&indices[0], 1, nr_added);
+    flann::Matrix<float> distances_mat (&distances[0], 1, nr_added);
+    added_[a].index->knnSearch (flann::Matrix<float> (query, 1, dim_), indices_mat, distances_mat, nr_added, param_k_);
+
+    // Merge the two sorted lists of neighbors
+    int i = 0, j = 0, nr_merged = 0;
+    for (; nr_merged < k && (i < nr_found || j < nr_added); ++nr_merged)
+    {
+      if (j >= nr_added || (i < nr_found && k_distances[i] <= distances[j]))
+      {
+        merged_indices[nr_merged] = k_indices[i];
+        merged_distances[nr_merged] = k_distances[i++];
+      }
+      else
+      {
+        merged_indices[nr_merged] = added_[a].mapping[indices[j]];
+        merged_distances[nr_merged] = distances[j++];
+      }
+    }
+    std::copy (merged_indices.begin (), merged_indices.begin () + nr_merged, k_indices);
+    std::copy (merged_distances.begin (), merged_distances.begin () + nr_merged, k_distances);
+    nr_found = nr_merged;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, typename Dist> int 
+pcl::KdTreeFLANN<PointT, Dist>::addedRadiusSearch (float* query, double radius, unsigned int max_nn,
+                                                   std::vector<int> &k_indices, std::vector<float> &k_sqr_dists) const
+{
+  std::vector<std::vector<int> > indices (1);
+  std::vector<std::vector<float> > dists (1);
+
+  flann::SearchParams params (param_radius_);
+  params.max_neighbors = -1;
+  for (size_t a = 0; a < added_.size (); ++a)
+  {
+    const int neighbors_in_radius = added_[a].index->radiusSearch (flann::Matrix<float> (query, 1, dim_), indices, dists, 
+                                                                   static_cast<float> (radius * radius), params);
+    for (int i = 0; i < neighbors_in_radius; ++i)
+    {
+      k_indices.push_back (added_[a].mapping[indices[0][i]]);
+      k_sqr_dists.push_back (dists[0][i]);
+    }
+  }
+
+  // The neighbors of the different trees are sorted together, before keeping the max_nn closest ones
+  if (sorted_ || k_indices.size () > max_nn)
+  {
+    std::vector<std::pair<float, int> > neighbors (k_indices.size ());
+    for (size_t i = 0; i < k_indices.size (); ++i)
+      neighbors[i] = std::make_pair (k_sqr_dists[i], k_indices[i]);
+    std::sort (neighbors.begin (), neighbors.end ());
+
+    k_indices.resize (std::min (k_indices.size (), static_cast<size_t> (max_nn)));
+    k_sqr_dists.resize (k_indices.size ());
+    for (size_t i = 0; i < k_indices.size (); ++i)
+    {
+      k_sqr_dists[i] = neighbors[i].first;
+      k_indices[i] = neighbors[i].second;
+    }
+  }
+
+  return (static_cast<int> (k_indices.size ()));
 }
 
 #define PCL_INSTANTIATE_KdTreeFLANN(T) template class PCL_EXPORTS pcl::KdTreeFLANN<T>;
@@ -88,7 +88,8 @@ namespace pcl
         index_mapping_ (), identity_mapping_ (false),
         dim_ (0), total_nr_points_ (0),
         param_k_ (::flann::SearchParams (-1 , epsilon_)),
-        param_radius_ (::flann::SearchParams (-1, epsilon_, sorted))
+        param_radius_ (::flann::SearchParams (-1, epsilon_, sorted)),
+        added_ ()
       {
       }
 
@@ -101,7 +102,8 @@ namespace pcl
         index_mapping_ (), identity_mapping_ (false),
         dim_ (0), total_nr_points_ (0),
         param_k_ (::flann::SearchParams (-1 , epsilon_)),
-        param_radius_ (::flann::SearchParams (-1, epsilon_, false))
+        param_radius_ (::flann::SearchParams (-1, epsilon_, false)),
+        added_ ()
       {
         *this = k;
       }
@@ -121,6 +123,7 @@ namespace pcl
         total_nr_points_ = k.total_nr_points_;
         param_k_ = k.param_k_;
         param_radius_ = k.param_radius_;
+        added_ = k.added_;
         return (*this);
       }
 
@@ -154,12 +157,24 @@ namespace pcl
       }
 
       /** \brief Provide a pointer to the input dataset.
+        * If no indices are given, the cloud only holds finite points and the point representation is trivial, 
+        * the points are indexed in place instead of being copied.
         * \param[in] cloud the const boost shared pointer to a PointCloud message
         * \param[in] indices the point indices subset that is to be used from \a cloud - if NULL the whole cloud is used
         */
       void 
       setInputCloud (const PointCloudConstPtr &cloud, const IndicesConstPtr &indices = IndicesConstPtr ());
 
+      /** \brief Add the points appended to the input cloud since the last call to setInputCloud or addPoints.
+        * The new points are indexed by small additional trees, searched together with the main one, which are 
+        * merged as they grow. The whole tree is only rebuilt once the added points outnumber the points 
+        * of the main tree.
+        * \param[in] cloud the grown input cloud, whose first points are the ones of the current input cloud
+        * \note Points can not be added to a tree built on a set of indices.
+        */
+      void 
+      addPoints (const PointCloudConstPtr &cloud);
+
       /** \brief Search for k-nearest neighbors for the given query point.
         * 
         * \attention This method does not do any bounds checking for the input index
@@ -178,6 +193,26 @@ namespace pcl
       nearestKSearch (const PointT &point, int k, 
                       std::vector<int> &k_indices, std::vector<float> &k_sqr_distances) const;
 
+      /** \brief Search for the k-nearest neighbors of a batch of query points.
+        * The query points are converted once, and FLANN is called on blocks of query points, in parallel.
+        * 
+        * \attention This method does not do any bounds checking for the input indices, and assumes valid 
+        * (i.e., finite) data.
+        * 
+        * \param[in] cloud the point cloud holding the query points
+        * \param[in] indices the indices in \a cloud of the query points (all the points of \a cloud if empty)
+        * \param[in] k the number of neighbors to search for
+        * \param[out] k_indices the resultant indices of the neighboring points, the neighbors of the i-th query 
+        * point being stored from i * k to (i + 1) * k - 1
+        * \param[out] k_sqr_distances the resultant squared distances to the neighboring points, stored as \a k_indices
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        * \return number of neighbors found for each query point
+        */
+      int 
+      batchNearestKSearch (const PointCloud &cloud, const std::vector<int> &indices, int k, 
+                           std::vector<int> &k_indices, std::vector<float> &k_sqr_distances, 
+                           unsigned int nr_threads = 0) const;
+
       /** \brief Search for all the nearest neighbors of the query point in a given radius.
         * 
         * \attention This method does not do any bounds checking for the input index
@@ -218,6 +253,55 @@ namespace pcl
       void 
       convertCloudToArray (const PointCloud &cloud, const std::vector<int> &indices);
 
+      /** \brief Converts the given points to FLANN points, in parallel.
+        * \param[in] cloud the PointCloud data
+        * \param[in] indices the indices of the points to convert
+        * \param[out] data the FLANN points, with room for indices.size () points
+        */
+      void 
+      vectorizePoints (const PointCloud &cloud, const std::vector<int> &indices, float* data) const;
+
+      /** \brief Points indexed by an additional tree after the main one was built. */
+      struct AddedIndex
+      {
+        AddedIndex () : index (), data (), mapping () {}
+
+        /** \brief A FLANN index object. */
+        boost::shared_ptr<FLANNIndex> index;
+
+        /** \brief The FLANN points. */
+        std::vector<float> data;
+
+        /** \brief The indices of the points in the input cloud. */
+        std::vector<int> mapping;
+      };
+
+      /** \brief Builds the tree over the points of an added index. */
+      void 
+      buildAddedIndex (AddedIndex &added);
+
+      /** \brief Merges the k-nearest neighbors found in the added trees with the ones of the main tree.
+        * \param[in] query the FLANN query point
+        * \param[in] k the number of neighbors to search for
+        * \param[in] nr_found the number of neighbors found in the main tree
+        * \param[in,out] k_indices the sorted neighbors, with room for \a k neighbors
+        * \param[in,out] k_distances the squared distances to the neighbors, with room for \a k neighbors
+        */
+      void 
+      addedKSearch (float* query, int k, int nr_found, int* k_indices, float* k_distances) const;
+
+      /** \brief Appends the neighbors found in the added trees to the ones of the main tree.
+        * \param[in] query the FLANN query point
+        * \param[in] radius the radius of the sphere bounding the neighbors
+        * \param[in] max_nn the maximum number of neighbors to keep
+        * \param[in,out] k_indices the neighbors
+        * \param[in,out] k_sqr_dists the squared distances to the neighbors
+        * \return the number of neighbors found in radius
+        */
+      int 
+      addedRadiusSearch (float* query, double radius, unsigned int max_nn,
+                         std::vector<int> &k_indices, std::vector<float> &k_sqr_dists) const;
+
     private:
       /** \brief Class getName method. */
       virtual std::string 
@@ -246,6 +330,9 @@ namespace pcl
 
       /** \brief The KdTree search parameters for radius search. */
       ::flann::SearchParams param_radius_;
+
+      /** \brief Trees over the points added after the main tree was built, from the largest to the smallest. */
+      std::vector<AddedIndex> added_;
   };
 
   /** \brief KdTreeFLANN is a generic type of 3D spatial locator using kD-tree structures. The class is making use of
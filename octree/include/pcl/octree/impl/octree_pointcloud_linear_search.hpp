@@ -0,0 +1,729 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_OCTREE_POINTCLOUD_LINEAR_SEARCH_IMPL_H_
+#define PCL_OCTREE_POINTCLOUD_LINEAR_SEARCH_IMPL_H_
+
+#include <pcl/octree/octree_pointcloud_linear_search.h>
+#include <pcl/console/print.h>
+
+#include <limits>
+#include <queue>
+#include <utility>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT>
+pcl::octree::OctreePointCloudLinearSearch<PointT>::OctreePointCloudLinearSearch (const double resolution) :
+  input_ (), indices_ (), resolution_ (resolution),
+  minX_ (0.0), maxX_ (resolution), minY_ (0.0), maxY_ (resolution), minZ_ (0.0), maxZ_ (resolution),
+  octreeDepth_ (0), levelCodes_ (), levelChildren_ (), pointIndices_ (), threads_ (0)
+{
+  assert (resolution > 0.0f);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> std::size_t
+pcl::octree::OctreePointCloudLinearSearch<PointT>::getBranchCount () const
+{
+  std::size_t branch_count = 0;
+  for (unsigned int depth = 0; depth < octreeDepth_ && depth < levelCodes_.size (); ++depth)
+    branch_count += levelCodes_[depth].size ();
+  return (branch_count);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> void
+pcl::octree::OctreePointCloudLinearSearch<PointT>::getBoundingBox (
+    double& minX_arg, double& minY_arg, double& minZ_arg,
+    double& maxX_arg, double& maxY_arg, double& maxZ_arg) const
+{
+  minX_arg = minX_;
+  minY_arg = minY_;
+  minZ_arg = minZ_;
+
+  maxX_arg = maxX_;
+  maxY_arg = maxY_;
+  maxZ_arg = maxZ_;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> void
+pcl::octree::OctreePointCloudLinearSearch<PointT>::deleteTree ()
+{
+  octreeDepth_ = 0;
+  levelCodes_.clear ();
+  levelChildren_.clear ();
+  pointIndices_.clear ();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> void
+pcl::octree::OctreePointCloudLinearSearch<PointT>::addPointsFromInputCloud ()
+{
+  deleteTree ();
+
+  if (!input_)
+  {
+    PCL_ERROR ("[pcl::octree::OctreePointCloudLinearSearch::addPointsFromInputCloud] No input dataset given!\n");
+    return;
+  }
+
+  // collect the finite points
+  std::vector<MortonEntry> entries;
+  MortonEntry entry;
+  entry.code = 0;
+  if (indices_)
+  {
+    entries.reserve (indices_->size ());
+    for (std::vector<int>::const_iterator current = indices_->begin (); current != indices_->end (); ++current)
+    {
+      assert ((*current >= 0) && (*current < static_cast<int> (input_->points.size ())));
+      if (isFinite (input_->points[*current]))
+      {
+        entry.index = *current;
+        entries.push_back (entry);
+      }
+    }
+  }
+  else
+  {
+    entries.reserve (input_->points.size ());
+    for (int i = 0; i < static_cast<int> (input_->points.size ()); ++i)
+    {
+      if (input_->is_dense || isFinite (input_->points[i]))
+      {
+        entry.index = i;
+        entries.push_back (entry);
+      }
+    }
+  }
+
+  if (entries.empty ())
+    return;
+
+  const int nr_entries = static_cast<int> (entries.size ());
+  const int nr_chunks = getNumberOfChunks (nr_entries);
+
+  // bounding box of the data, one per chunk
+  std::vector<float> chunk_bounds (6 * nr_chunks);
+#pragma omp parallel for num_threads (threads_)
+  for (int c = 0; c < nr_chunks; ++c)
+  {
+    float* bounds = &chunk_bounds[6 * c];
+    bounds[0] = bounds[1] = bounds[2] = std::numeric_limits<float>::max ();
+    bounds[3] = bounds[4] = bounds[5] = -std::numeric_limits<float>::max ();
+
+    const int first = static_cast<int> (static_cast<long long> (nr_entries) * c / nr_chunks);
+    const int last = static_cast<int> (static_cast<long long> (nr_entries) * (c + 1) / nr_chunks);
+    for (int i = first; i < last; ++i)
+    {
+      const PointT& point = input_->points[entries[i].index];
+      bounds[0] = std::min (bounds[0], point.x);
+      bounds[1] = std::min (bounds[1], point.y);
+      bounds[2] = std::min (bounds[2], point.z);
+      bounds[3] = std::max (bounds[3], point.x);
+      bounds[4] = std::max (bounds[4], point.y);
+      bounds[5] = std::max (bounds[5], point.z);
+    }
+  }
+
+  float bounds[6] = {chunk_bounds[0], chunk_bounds[1], chunk_bounds[2], chunk_bounds[3], chunk_bounds[4], chunk_bounds[5]};
+  for (int c = 1; c < nr_chunks; ++c)
+  {
+    for (int j = 0; j < 3; ++j)
+    {
+      bounds[j] = std::min (bounds[j], chunk_bounds[6 * c + j]);
+      bounds[j + 3] = std::max (bounds[j + 3], chunk_bounds[6 * c + j + 3]);
+    }
+  }
+
+  // tree depth == amount of bits of the number of voxels along the largest side
+  const double max_extent = std::max (std::max (bounds[3] - bounds[0], bounds[4] - bounds[1]), bounds[5] - bounds[2]);
+  if (max_extent / resolution_ >= static_cast<double> (1 << MAX_DEPTH) - 1.0)
+  {
+    PCL_ERROR ("[pcl::octree::OctreePointCloudLinearSearch::addPointsFromInputCloud] The resolution %g is too fine for the extent %g of the data, at most %u levels are supported!\n",
+               resolution_, max_extent, MAX_DEPTH);
+    return;
+  }
+
+  const unsigned int max_voxels = static_cast<unsigned int> (max_extent / resolution_) + 1;
+  unsigned int depth = 1;
+  while ((1u << depth) < max_voxels)
+    ++depth;
+
+  // center the data in the octree bounding box
+  const double side_length = static_cast<double> (1 << depth) * resolution_;
+  minX_ = bounds[0] - (side_length - (bounds[3] - bounds[0])) / 2.0;
+  minY_ = bounds[1] - (side_length - (bounds[4] - bounds[1])) / 2.0;
+  minZ_ = bounds[2] - (side_length - (bounds[5] - bounds[2])) / 2.0;
+  maxX_ = minX_ + side_length;
+  maxY_ = minY_ + side_length;
+  maxZ_ = minZ_ + side_length;
+  octreeDepth_ = depth;
+
+  // Morton codes of the leaf voxels, sorted along with the point indices
+#pragma omp parallel for num_threads (threads_)
+  for (int i = 0; i < nr_entries; ++i)
+    entries[i].code = genMortonCodeForPoint (input_->points[entries[i].index]);
+
+  sortMortonEntries (entries);
+
+  std::vector<uint64_t> codes (nr_entries);
+  pointIndices_.resize (nr_entries);
+#pragma omp parallel for num_threads (threads_)
+  for (int i = 0; i < nr_entries; ++i)
+  {
+    codes[i] = entries[i].code;
+    pointIndices_[i] = entries[i].index;
+  }
+  std::vector<MortonEntry> ().swap (entries);
+
+  // every level is made of the distinct prefixes of the level below
+  levelCodes_.resize (octreeDepth_ + 1);
+  levelChildren_.resize (octreeDepth_ + 1);
+  compactCodes (codes, 0, levelCodes_[octreeDepth_], levelChildren_[octreeDepth_]);
+  for (int depth_idx = static_cast<int> (octreeDepth_) - 1; depth_idx >= 0; --depth_idx)
+    compactCodes (levelCodes_[depth_idx + 1], 3, levelCodes_[depth_idx], levelChildren_[depth_idx]);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> void
+pcl::octree::OctreePointCloudLinearSearch<PointT>::sortMortonEntries (std::vector<MortonEntry> &entries) const
+{
+  const int nr_entries = static_cast<int> (entries.size ());
+  const int nr_chunks = getNumberOfChunks (nr_entries);
+  const unsigned int nr_passes = (3 * octreeDepth_ + 7) / 8;
+
+  std::vector<MortonEntry> buffer (entries.size ());
+  std::vector<int> histograms (256 * nr_chunks);
+
+  for (unsigned int pass = 0; pass < nr_passes; ++pass)
+  {
+    const unsigned int shift = 8 * pass;
+
+    // count the digits of each chunk
+#pragma omp parallel for num_threads (threads_)
+    for (int c = 0; c < nr_chunks; ++c)
+    {
+      int* histogram = &histograms[256 * c];
+      std::fill (histogram, histogram + 256, 0);
+
+      const int first = static_cast<int> (static_cast<long long> (nr_entries) * c / nr_chunks);
+      const int last = static_cast<int> (static_cast<long long> (nr_entries) * (c + 1) / nr_chunks);
+      for (int i = first; i < last; ++i)
+        ++histogram[(entries[i].code >> shift) & 0xff];
+    }
+
+    // exclusive prefix sum, digit major and chunk minor so that the scatter is stable
+    int offset = 0;
+    bool single_digit = false;
+    for (int digit = 0; digit < 256; ++digit)
+    {
+      const int digit_begin = offset;
+      for (int c = 0; c < nr_chunks; ++c)
+      {
+        const int count = histograms[256 * c + digit];
+        histograms[256 * c + digit] = offset;
+        offset += count;
+      }
+      if (offset - digit_begin == nr_entries)
+        single_digit = true;
+    }
+
+    // all the codes share this digit, the pass would not move anything
+    if (single_digit)
+      continue;
+
+#pragma omp parallel for num_threads (threads_)
+    for (int c = 0; c < nr_chunks; ++c)
+    {
+      int* histogram = &histograms[256 * c];
+
+      const int first = static_cast<int> (static_cast<long long> (nr_entries) * c / nr_chunks);
+      const int last = static_cast<int> (static_cast<long long> (nr_entries) * (c + 1) / nr_chunks);
+      for (int i = first; i < last; ++i)
+        buffer[histogram[(entries[i].code >> shift) & 0xff]++] = entries[i];
+    }
+
+    entries.swap (buffer);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> void
+pcl::octree::OctreePointCloudLinearSearch<PointT>::compactCodes (
+    const std::vector<uint64_t> &codes, unsigned int shift,
+    std::vector<uint64_t> &node_codes, std::vector<int> &node_children) const
+{
+  const int nr_codes = static_cast<int> (codes.size ());
+  const int nr_chunks = getNumberOfChunks (nr_codes);
+
+  // count the runs starting in each chunk
+  std::vector<int> chunk_offsets (nr_chunks + 1, 0);
+#pragma omp parallel for num_threads (threads_)
+  for (int c = 0; c < nr_chunks; ++c)
+  {
+    const int first = static_cast<int> (static_cast<long long> (nr_codes) * c / nr_chunks);
+    const int last = static_cast<int> (static_cast<long long> (nr_codes) * (c + 1) / nr_chunks);
+    int nr_runs = 0;
+    for (int i = first; i < last; ++i)
+      if (i == 0 || (codes[i] >> shift) != (codes[i - 1] >> shift))
+        ++nr_runs;
+    chunk_offsets[c + 1] = nr_runs;
+  }
+
+  for (int c = 0; c < nr_chunks; ++c)
+    chunk_offsets[c + 1] += chunk_offsets[c];
+
+  node_codes.resize (chunk_offsets[nr_chunks]);
+  node_children.resize (chunk_offsets[nr_chunks] + 1);
+
+#pragma omp parallel for num_threads (threads_)
+  for (int c = 0; c < nr_chunks; ++c)
+  {
+    const int first = static_cast<int> (static_cast<long long> (nr_codes) * c / nr_chunks);
+    const int last = static_cast<int> (static_cast<long long> (nr_codes) * (c + 1) / nr_chunks);
+    int node = chunk_offsets[c];
+    for (int i = first; i < last; ++i)
+    {
+      if (i == 0 || (codes[i] >> shift) != (codes[i - 1] >> shift))
+      {
+        node_codes[node] = codes[i] >> shift;
+        node_children[node] = i;
+        ++node;
+      }
+    }
+  }
+
+  node_children.back () = nr_codes;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> const PointT&
+pcl::octree::OctreePointCloudLinearSearch<PointT>::getPointByIndex (const int index_arg) const
+{
+  // retrieve point from input cloud
+  assert (index_arg < static_cast<int> (input_->points.size ()));
+  return (input_->points[index_arg]);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> pcl::uint64_t
+pcl::octree::OctreePointCloudLinearSearch<PointT>::genMortonCodeForPoint (const PointT& point_arg) const
+{
+  const unsigned int max_key = (1u << octreeDepth_) - 1;
+
+  // the coordinates are clamped to the bounding box to be robust to rounding on its upper faces
+  const unsigned int key_x = std::min (static_cast<unsigned int> (std::max ((point_arg.x - minX_) / resolution_, 0.0)), max_key);
+  const unsigned int key_y = std::min (static_cast<unsigned int> (std::max ((point_arg.y - minY_) / resolution_, 0.0)), max_key);
+  const unsigned int key_z = std::min (static_cast<unsigned int> (std::max ((point_arg.z - minZ_) / resolution_, 0.0)), max_key);
+
+  return (encodeMorton (key_x, key_y, key_z));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> void
+pcl::octree::OctreePointCloudLinearSearch<PointT>::genVoxelBounds (unsigned int depth_arg, uint64_t code_arg,
+                                                                   Eigen::Vector3f &min_pt, Eigen::Vector3f &max_pt) const
+{
+  unsigned int x, y, z;
+  decodeMorton (code_arg, x, y, z);
+
+  const double voxel_size = static_cast<double> (1 << (octreeDepth_ - depth_arg)) * resolution_;
+
+  min_pt[0] = static_cast<float> (minX_ + x * voxel_size);
+  min_pt[1] = static_cast<float> (minY_ + y * voxel_size);
+  min_pt[2] = static_cast<float> (minZ_ + z * voxel_size);
+
+  max_pt[0] = static_cast<float> (minX_ + (x + 1) * voxel_size);
+  max_pt[1] = static_cast<float> (minY_ + (y + 1) * voxel_size);
+  max_pt[2] = static_cast<float> (minZ_ + (z + 1) * voxel_size);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> float
+pcl::octree::OctreePointCloudLinearSearch<PointT>::pointToVoxelSqrDistance (const PointT& point_arg,
+                                                                            unsigned int depth_arg, uint64_t code_arg) const
+{
+  Eigen::Vector3f min_pt, max_pt;
+  genVoxelBounds (depth_arg, code_arg, min_pt, max_pt);
+
+  const Eigen::Vector3f point (point_arg.x, point_arg.y, point_arg.z);
+  const Eigen::Vector3f outside = (min_pt - point).cwiseMax (point - max_pt).cwiseMax (Eigen::Vector3f::Zero ());
+
+  return (outside.squaredNorm ());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> bool
+pcl::octree::OctreePointCloudLinearSearch<PointT>::isVoxelOccupiedAtPoint (const PointT& point_arg) const
+{
+  if (levelCodes_.empty () || !isFinite (point_arg))
+    return (false);
+
+  if (point_arg.x < minX_ || point_arg.y < minY_ || point_arg.z < minZ_ ||
+      point_arg.x >= maxX_ || point_arg.y >= maxY_ || point_arg.z >= maxZ_)
+    return (false);
+
+  const std::vector<uint64_t> &leaf_codes = levelCodes_[octreeDepth_];
+  return (std::binary_search (leaf_codes.begin (), leaf_codes.end (), genMortonCodeForPoint (point_arg)));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> bool
+pcl::octree::OctreePointCloudLinearSearch<PointT>::voxelSearch (const PointT& point, std::vector<int>& pointIdx_data) const
+{
+  assert (isFinite (point) && "Invalid (NaN, Inf) point coordinates given to voxelSearch!");
+  pointIdx_data.clear ();
+
+  if (levelCodes_.empty ())
+    return (false);
+
+  if (point.x < minX_ || point.y < minY_ || point.z < minZ_ ||
+      point.x >= maxX_ || point.y >= maxY_ || point.z >= maxZ_)
+    return (false);
+
+  const std::vector<uint64_t> &leaf_codes = levelCodes_[octreeDepth_];
+  const uint64_t code = genMortonCodeForPoint (point);
+
+  std::vector<uint64_t>::const_iterator leaf = std::lower_bound (leaf_codes.begin (), leaf_codes.end (), code);
+  if (leaf == leaf_codes.end () || *leaf != code)
+    return (false);
+
+  const int leaf_idx = static_cast<int> (leaf - leaf_codes.begin ());
+  const std::vector<int> &leaf_points = levelChildren_[octreeDepth_];
+  pointIdx_data.assign (pointIndices_.begin () + leaf_points[leaf_idx], pointIndices_.begin () + leaf_points[leaf_idx + 1]);
+
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> int
+pcl::octree::OctreePointCloudLinearSearch<PointT>::nearestKSearch (const PointT &p_q, int k, std::vector<int> &k_indices,
+                                                                   std::vector<float> &k_sqr_distances) const
+{
+  assert (isFinite (p_q) && "Invalid (NaN, Inf) point coordinates given to nearestKSearch!");
+  k_indices.clear ();
+  k_sqr_distances.clear ();
+
+  if (k < 1 || levelCodes_.empty ())
+    return (0);
+
+  // candidate nodes, closest first, and best points found so far, farthest first
+  std::priority_queue<NodeQueueEntry> node_queue;
+  std::priority_queue<std::pair<float, int> > point_queue;
+
+  NodeQueueEntry entry;
+  entry.sqr_distance = pointToVoxelSqrDistance (p_q, 0, levelCodes_[0][0]);
+  entry.depth = 0;
+  entry.node = 0;
+  node_queue.push (entry);
+
+  while (!node_queue.empty ())
+  {
+    const NodeQueueEntry current = node_queue.top ();
+    node_queue.pop ();
+
+    // no remaining node can contain a closer point
+    if (static_cast<int> (point_queue.size ()) == k && current.sqr_distance > point_queue.top ().first)
+      break;
+
+    const int first = levelChildren_[current.depth][current.node];
+    const int last = levelChildren_[current.depth][current.node + 1];
+
+    if (current.depth == octreeDepth_)
+    {
+      for (int i = first; i < last; ++i)
+      {
+        const int point_idx = pointIndices_[i];
+        const float sqr_distance = pointSquaredDist (input_->points[point_idx], p_q);
+
+        if (static_cast<int> (point_queue.size ()) < k)
+          point_queue.push (std::make_pair (sqr_distance, point_idx));
+        else if (sqr_distance < point_queue.top ().first)
+        {
+          point_queue.pop ();
+          point_queue.push (std::make_pair (sqr_distance, point_idx));
+        }
+      }
+    }
+    else
+    {
+      const std::vector<uint64_t> &child_codes = levelCodes_[current.depth + 1];
+      entry.depth = current.depth + 1;
+      for (int child = first; child < last; ++child)
+      {
+        entry.sqr_distance = pointToVoxelSqrDistance (p_q, entry.depth, child_codes[child]);
+        if (static_cast<int> (point_queue.size ()) < k || entry.sqr_distance <= point_queue.top ().first)
+        {
+          entry.node = child;
+          node_queue.push (entry);
+        }
+      }
+    }
+  }
+
+  const int nr_neighbors = static_cast<int> (point_queue.size ());
+  k_indices.resize (nr_neighbors);
+  k_sqr_distances.resize (nr_neighbors);
+  for (int i = nr_neighbors - 1; i >= 0; --i)
+  {
+    k_sqr_distances[i] = point_queue.top ().first;
+    k_indices[i] = point_queue.top ().second;
+    point_queue.pop ();
+  }
+
+  return (nr_neighbors);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> void
+pcl::octree::OctreePointCloudLinearSearch<PointT>::approxNearestSearch (const PointT &p_q, int &result_index,
+                                                                        float &sqr_distance) const
+{
+  assert (isFinite (p_q) && "Invalid (NaN, Inf) point coordinates given to approxNearestSearch!");
+  result_index = -1;
+  sqr_distance = std::numeric_limits<float>::max ();
+
+  if (levelCodes_.empty ())
+    return;
+
+  // descend towards the child whose center is the closest to the query point
+  const Eigen::Vector3f point (p_q.x, p_q.y, p_q.z);
+  int node = 0;
+  for (unsigned int depth = 0; depth < octreeDepth_; ++depth)
+  {
+    const int first = levelChildren_[depth][node];
+    const int last = levelChildren_[depth][node + 1];
+
+    float min_sqr_distance = std::numeric_limits<float>::max ();
+    for (int child = first; child < last; ++child)
+    {
+      Eigen::Vector3f min_pt, max_pt;
+      genVoxelBounds (depth + 1, levelCodes_[depth + 1][child], min_pt, max_pt);
+
+      const float child_sqr_distance = ((min_pt + max_pt) * 0.5f - point).squaredNorm ();
+      if (child_sqr_distance < min_sqr_distance)
+      {
+        min_sqr_distance = child_sqr_distance;
+        node = child;
+      }
+    }
+  }
+
+  // nearest point of the reached leaf
+  const std::vector<int> &leaf_points = levelChildren_[octreeDepth_];
+  for (int i = leaf_points[node]; i < leaf_points[node + 1]; ++i)
+  {
+    const float point_sqr_distance = pointSquaredDist (input_->points[pointIndices_[i]], p_q);
+    if (point_sqr_distance < sqr_distance)
+    {
+      sqr_distance = point_sqr_distance;
+      result_index = pointIndices_[i];
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> int
+pcl::octree::OctreePointCloudLinearSearch<PointT>::radiusSearch (const PointT &p_q, const double radius,
+                                                                 std::vector<int> &k_indices,
+                                                                 std::vector<float> &k_sqr_distances,
+                                                                 unsigned int max_nn) const
+{
+  assert (isFinite (p_q) && "Invalid (NaN, Inf) point coordinates given to radiusSearch!");
+  k_indices.clear ();
+  k_sqr_distances.clear ();
+
+  if (levelCodes_.empty ())
+    return (0);
+
+  const float sqr_radius = static_cast<float> (radius * radius);
+
+  // depth first traversal of the nodes intersecting the sphere, children are visited in Morton order
+  std::vector<std::pair<unsigned int, int> > node_stack;
+  node_stack.reserve (8 * (octreeDepth_ + 1));
+  node_stack.push_back (std::make_pair (0u, 0));
+
+  while (!node_stack.empty ())
+  {
+    const unsigned int depth = node_stack.back ().first;
+    const int node = node_stack.back ().second;
+    node_stack.pop_back ();
+
+    if (pointToVoxelSqrDistance (p_q, depth, levelCodes_[depth][node]) > sqr_radius)
+      continue;
+
+    const int first = levelChildren_[depth][node];
+    const int last = levelChildren_[depth][node + 1];
+
+    if (depth == octreeDepth_)
+    {
+      for (int i = first; i < last; ++i)
+      {
+        const float sqr_distance = pointSquaredDist (input_->points[pointIndices_[i]], p_q);
+        if (sqr_distance <= sqr_radius)
+        {
+          k_indices.push_back (pointIndices_[i]);
+          k_sqr_distances.push_back (sqr_distance);
+
+          if (max_nn > 0 && k_indices.size () == max_nn)
+            return (static_cast<int> (k_indices.size ()));
+        }
+      }
+    }
+    else
+    {
+      for (int child = last - 1; child >= first; --child)
+        node_stack.push_back (std::make_pair (depth + 1, child));
+    }
+  }
+
+  return (static_cast<int> (k_indices.size ()));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> int
+pcl::octree::OctreePointCloudLinearSearch<PointT>::boxSearch (const Eigen::Vector3f &min_pt,
+                                                              const Eigen::Vector3f &max_pt,
+                                                              std::vector<int> &k_indices) const
+{
+  k_indices.clear ();
+
+  if (levelCodes_.empty ())
+    return (0);
+
+  std::vector<std::pair<unsigned int, int> > node_stack;
+  node_stack.reserve (8 * (octreeDepth_ + 1));
+  node_stack.push_back (std::make_pair (0u, 0));
+
+  while (!node_stack.empty ())
+  {
+    const unsigned int depth = node_stack.back ().first;
+    const int node = node_stack.back ().second;
+    node_stack.pop_back ();
+
+    Eigen::Vector3f voxel_min, voxel_max;
+    genVoxelBounds (depth, levelCodes_[depth][node], voxel_min, voxel_max);
+
+    if ((voxel_max.array () < min_pt.array ()).any () || (voxel_min.array () > max_pt.array ()).any ())
+      continue;
+
+    const int first = levelChildren_[depth][node];
+    const int last = levelChildren_[depth][node + 1];
+
+    if (depth == octreeDepth_)
+    {
+      for (int i = first; i < last; ++i)
+      {
+        const PointT& point = input_->points[pointIndices_[i]];
+        if (point.x >= min_pt (0) && point.y >= min_pt (1) && point.z >= min_pt (2) &&
+            point.x <= max_pt (0) && point.y <= max_pt (1) && point.z <= max_pt (2))
+          k_indices.push_back (pointIndices_[i]);
+      }
+    }
+    else
+    {
+      for (int child = last - 1; child >= first; --child)
+        node_stack.push_back (std::make_pair (depth + 1, child));
+    }
+  }
+
+  return (static_cast<int> (k_indices.size ()));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> int
+pcl::octree::OctreePointCloudLinearSearch<PointT>::getOccupiedVoxelCenters (AlignedPointTVector &voxelCenterList_arg) const
+{
+  voxelCenterList_arg.clear ();
+  if (levelCodes_.empty ())
+    return (0);
+
+  const std::vector<uint64_t> &leaf_codes = levelCodes_[octreeDepth_];
+  voxelCenterList_arg.resize (leaf_codes.size ());
+
+  const int nr_leaves = static_cast<int> (leaf_codes.size ());
+#pragma omp parallel for num_threads (threads_)
+  for (int leaf = 0; leaf < nr_leaves; ++leaf)
+  {
+    Eigen::Vector3f min_pt, max_pt;
+    genVoxelBounds (octreeDepth_, leaf_codes[leaf], min_pt, max_pt);
+
+    PointT& center = voxelCenterList_arg[leaf];
+    center.x = 0.5f * (min_pt[0] + max_pt[0]);
+    center.y = 0.5f * (min_pt[1] + max_pt[1]);
+    center.z = 0.5f * (min_pt[2] + max_pt[2]);
+  }
+
+  return (nr_leaves);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> std::size_t
+pcl::octree::OctreePointCloudLinearSearch<PointT>::getVoxelCentroids (AlignedPointTVector &voxelCentroidList_arg) const
+{
+  voxelCentroidList_arg.clear ();
+  if (levelCodes_.empty ())
+    return (0);
+
+  // the points of a leaf are contiguous in pointIndices_
+  const std::vector<int> &leaf_points = levelChildren_[octreeDepth_];
+  const int nr_leaves = static_cast<int> (levelCodes_[octreeDepth_].size ());
+  voxelCentroidList_arg.resize (nr_leaves);
+
+#pragma omp parallel for num_threads (threads_)
+  for (int leaf = 0; leaf < nr_leaves; ++leaf)
+  {
+    Eigen::Vector3d sum (Eigen::Vector3d::Zero ());
+    for (int i = leaf_points[leaf]; i < leaf_points[leaf + 1]; ++i)
+    {
+      const PointT& point = input_->points[pointIndices_[i]];
+      sum += Eigen::Vector3d (point.x, point.y, point.z);
+    }
+    sum /= static_cast<double> (leaf_points[leaf + 1] - leaf_points[leaf]);
+
+    PointT& centroid = voxelCentroidList_arg[leaf];
+    centroid.x = static_cast<float> (sum[0]);
+    centroid.y = static_cast<float> (sum[1]);
+    centroid.z = static_cast<float> (sum[2]);
+  }
+
+  return (voxelCentroidList_arg.size ());
+}
+
+#endif    // PCL_OCTREE_POINTCLOUD_LINEAR_SEARCH_IMPL_H_
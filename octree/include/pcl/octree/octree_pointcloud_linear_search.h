@@ -0,0 +1,523 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_OCTREE_POINTCLOUD_LINEAR_SEARCH_H_
+#define PCL_OCTREE_POINTCLOUD_LINEAR_SEARCH_H_
+
+#include <pcl/pcl_macros.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace pcl
+{
+  namespace octree
+  {
+    /** \brief @b Pointerless (linear) octree pointcloud search class
+      * \note The octree is stored level by level in arrays of Morton (Z-order) codes. Each level lists the codes of its
+      * occupied nodes in increasing order together with the offset of their first child in the next level, and the
+      * leaf level points into a single array of point indices sorted in Morton order.
+      * \note The tree is built at once by addPointsFromInputCloud: the Morton codes of the \ref OctreeKey of all points
+      * are computed and sorted with a parallel radix sort, so that every level is derived from the one below by a
+      * linear scan. Points cannot be added or removed afterwards.
+      * \note The search interface mirrors \ref OctreePointCloudSearch (voxelSearch, nearestKSearch, approxNearestSearch,
+      * radiusSearch and boxSearch), and every query method is const so that a tree can be shared between threads.
+      * \note typename: PointT: type of point used in pointcloud
+      * \ingroup octree
+      */
+    template<typename PointT>
+    class OctreePointCloudLinearSearch
+    {
+      public:
+        // public typedefs
+        typedef boost::shared_ptr<std::vector<int> > IndicesPtr;
+        typedef boost::shared_ptr<const std::vector<int> > IndicesConstPtr;
+
+        typedef pcl::PointCloud<PointT> PointCloud;
+        typedef boost::shared_ptr<PointCloud> PointCloudPtr;
+        typedef boost::shared_ptr<const PointCloud> PointCloudConstPtr;
+
+        // Boost shared pointers
+        typedef boost::shared_ptr<OctreePointCloudLinearSearch<PointT> > Ptr;
+        typedef boost::shared_ptr<const OctreePointCloudLinearSearch<PointT> > ConstPtr;
+
+        // Eigen aligned allocator
+        typedef std::vector<PointT, Eigen::aligned_allocator<PointT> > AlignedPointTVector;
+
+        /** \brief Constructor.
+          * \param[in] resolution octree resolution at lowest octree level
+          */
+        OctreePointCloudLinearSearch (const double resolution);
+
+        /** \brief Empty class destructor. */
+        virtual
+        ~OctreePointCloudLinearSearch ()
+        {
+        }
+
+        /** \brief Provide a pointer to the input data set. The tree is built by \ref addPointsFromInputCloud.
+          * \param[in] cloud_arg the const boost shared pointer to a PointCloud message
+          * \param[in] indices_arg the point indices subset that is to be used from \a cloud - if 0 the whole point cloud is used
+          */
+        inline void
+        setInputCloud (const PointCloudConstPtr &cloud_arg, const IndicesConstPtr &indices_arg = IndicesConstPtr ())
+        {
+          deleteTree ();
+          input_ = cloud_arg;
+          indices_ = indices_arg;
+        }
+
+        /** \brief Get a pointer to the vector of indices used. */
+        inline IndicesConstPtr const
+        getIndices () const
+        {
+          return (indices_);
+        }
+
+        /** \brief Get a pointer to the input point cloud dataset. */
+        inline PointCloudConstPtr
+        getInputCloud () const
+        {
+          return (input_);
+        }
+
+        /** \brief Set the number of threads used to build the tree and to extract the voxel centroids.
+          * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+          */
+        inline void
+        setNumberOfThreads (unsigned int nr_threads = 0)
+        {
+          threads_ = nr_threads;
+        }
+
+        /** \brief Get the octree voxel resolution. */
+        inline double
+        getResolution () const
+        {
+          return (resolution_);
+        }
+
+        /** \brief Get the maximum depth of the octree. */
+        inline unsigned int
+        getTreeDepth () const
+        {
+          return (octreeDepth_);
+        }
+
+        /** \brief Get the number of occupied leaf nodes (voxels). */
+        inline std::size_t
+        getLeafCount () const
+        {
+          return (levelCodes_.empty () ? 0 : levelCodes_.back ().size ());
+        }
+
+        /** \brief Get the number of occupied branch nodes. */
+        std::size_t
+        getBranchCount () const;
+
+        /** \brief Get the bounding box of the octree.
+          * \param[out] minX_arg X coordinate of lower bounding box corner
+          * \param[out] minY_arg Y coordinate of lower bounding box corner
+          * \param[out] minZ_arg Z coordinate of lower bounding box corner
+          * \param[out] maxX_arg X coordinate of upper bounding box corner
+          * \param[out] maxY_arg Y coordinate of upper bounding box corner
+          * \param[out] maxZ_arg Z coordinate of upper bounding box corner
+          */
+        void
+        getBoundingBox (double& minX_arg, double& minY_arg, double& minZ_arg,
+                        double& maxX_arg, double& maxY_arg, double& maxZ_arg) const;
+
+        /** \brief Build the octree from all the finite points of the input cloud (and indices, if given).
+          * \note The bounding box is fitted to the data and the depth is chosen so that the leaf voxels have the
+          * requested resolution. Morton codes use 21 bits per axis, deeper trees are rejected.
+          */
+        void
+        addPointsFromInputCloud ();
+
+        /** \brief Delete the octree structure. */
+        void
+        deleteTree ();
+
+        /** \brief Check if voxel at given point exist.
+          * \param[in] point_arg point to be checked
+          * \return "true" if voxel exist; "false" otherwise
+          */
+        bool
+        isVoxelOccupiedAtPoint (const PointT& point_arg) const;
+
+        /** \brief Search for neighbors within a voxel at given point
+          * \param[in] point point addressing a leaf node voxel
+          * \param[out] pointIdx_data the resultant indices of the neighboring voxel points
+          * \return "true" if leaf node exist; "false" otherwise
+          */
+        bool
+        voxelSearch (const PointT& point, std::vector<int>& pointIdx_data) const;
+
+        /** \brief Search for neighbors within a voxel at given point referenced by a point index
+          * \param[in] index the index in input cloud defining the query point
+          * \param[out] pointIdx_data the resultant indices of the neighboring voxel points
+          * \return "true" if leaf node exist; "false" otherwise
+          */
+        inline bool
+        voxelSearch (const int index, std::vector<int>& pointIdx_data) const
+        {
+          return (voxelSearch (getPointByIndex (index), pointIdx_data));
+        }
+
+        /** \brief Search for k-nearest neighbors at the query point.
+          * \param[in] cloud the point cloud data
+          * \param[in] index the index in \a cloud representing the query point
+          * \param[in] k the number of neighbors to search for
+          * \param[out] k_indices the resultant indices of the neighboring points
+          * \param[out] k_sqr_distances the resultant squared distances to the neighboring points
+          * \return number of neighbors found
+          */
+        inline int
+        nearestKSearch (const PointCloud &cloud, int index, int k, std::vector<int> &k_indices,
+                        std::vector<float> &k_sqr_distances) const
+        {
+          return (nearestKSearch (cloud[index], k, k_indices, k_sqr_distances));
+        }
+
+        /** \brief Search for k-nearest neighbors at given query point.
+          * \param[in] p_q the given query point
+          * \param[in] k the number of neighbors to search for
+          * \param[out] k_indices the resultant indices of the neighboring points, sorted by increasing distance
+          * \param[out] k_sqr_distances the resultant squared distances to the neighboring points
+          * \return number of neighbors found
+          */
+        int
+        nearestKSearch (const PointT &p_q, int k, std::vector<int> &k_indices,
+                        std::vector<float> &k_sqr_distances) const;
+
+        /** \brief Search for k-nearest neighbors at query point
+          * \param[in] index index of the query point in the input cloud given by \a setInputCloud, whether or not
+          *        indices were given
+          * \param[in] k the number of neighbors to search for
+          * \param[out] k_indices the resultant indices of the neighboring points
+          * \param[out] k_sqr_distances the resultant squared distances to the neighboring points
+          * \return number of neighbors found
+          */
+        inline int
+        nearestKSearch (int index, int k, std::vector<int> &k_indices, std::vector<float> &k_sqr_distances) const
+        {
+          return (nearestKSearch (getPointByIndex (index), k, k_indices, k_sqr_distances));
+        }
+
+        /** \brief Search for approx. nearest neighbor at the query point.
+          * \param[in] cloud the point cloud data
+          * \param[in] query_index the index in \a cloud representing the query point
+          * \param[out] result_index the resultant index of the neighbor point
+          * \param[out] sqr_distance the resultant squared distance to the neighboring point
+          */
+        inline void
+        approxNearestSearch (const PointCloud &cloud, int query_index, int &result_index, float &sqr_distance) const
+        {
+          return (approxNearestSearch (cloud.points[query_index], result_index, sqr_distance));
+        }
+
+        /** \brief Search for approx. nearest neighbor at the query point.
+          * \note The tree is descended towards the child closest to the query point, the nearest point of the reached leaf is returned.
+          * \param[in] p_q the given query point
+          * \param[out] result_index the resultant index of the neighbor point
+          * \param[out] sqr_distance the resultant squared distance to the neighboring point
+          */
+        void
+        approxNearestSearch (const PointT &p_q, int &result_index, float &sqr_distance) const;
+
+        /** \brief Search for approx. nearest neighbor at the query point.
+          * \param[in] query_index index of the query point in the input cloud given by \a setInputCloud, whether or not
+          *        indices were given
+          * \param[out] result_index the resultant index of the neighbor point
+          * \param[out] sqr_distance the resultant squared distance to the neighboring point
+          */
+        inline void
+        approxNearestSearch (int query_index, int &result_index, float &sqr_distance) const
+        {
+          return (approxNearestSearch (getPointByIndex (query_index), result_index, sqr_distance));
+        }
+
+        /** \brief Search for all neighbors of query point that are within a given radius.
+          * \param[in] cloud the point cloud data
+          * \param[in] index the index in \a cloud representing the query point
+          * \param[in] radius the radius of the sphere bounding all of p_q's neighbors
+          * \param[out] k_indices the resultant indices of the neighboring points
+          * \param[out] k_sqr_distances the resultant squared distances to the neighboring points
+          * \param[in] max_nn if given, bounds the maximum returned neighbors to this value
+          * \return number of neighbors found in radius
+          */
+        inline int
+        radiusSearch (const PointCloud &cloud, int index, double radius, std::vector<int> &k_indices,
+                      std::vector<float> &k_sqr_distances, unsigned int max_nn = 0) const
+        {
+          return (radiusSearch (cloud.points[index], radius, k_indices, k_sqr_distances, max_nn));
+        }
+
+        /** \brief Search for all neighbors of query point that are within a given radius.
+          * \param[in] p_q the given query point
+          * \param[in] radius the radius of the sphere bounding all of p_q's neighbors
+          * \param[out] k_indices the resultant indices of the neighboring points, in Morton order
+          * \param[out] k_sqr_distances the resultant squared distances to the neighboring points
+          * \param[in] max_nn if given, bounds the maximum returned neighbors to this value
+          * \return number of neighbors found in radius
+          */
+        int
+        radiusSearch (const PointT &p_q, const double radius, std::vector<int> &k_indices,
+                      std::vector<float> &k_sqr_distances, unsigned int max_nn = 0) const;
+
+        /** \brief Search for all neighbors of query point that are within a given radius.
+          * \param[in] index index of the query point in the input cloud given by \a setInputCloud, whether or not
+          *        indices were given
+          * \param[in] radius radius of the sphere bounding all of p_q's neighbors
+          * \param[out] k_indices the resultant indices of the neighboring points
+          * \param[out] k_sqr_distances the resultant squared distances to the neighboring points
+          * \param[in] max_nn if given, bounds the maximum returned neighbors to this value
+          * \return number of neighbors found in radius
+          */
+        inline int
+        radiusSearch (int index, const double radius, std::vector<int> &k_indices,
+                      std::vector<float> &k_sqr_distances, unsigned int max_nn = 0) const
+        {
+          return (radiusSearch (getPointByIndex (index), radius, k_indices, k_sqr_distances, max_nn));
+        }
+
+        /** \brief Search for points within rectangular search area
+          * \param[in] min_pt lower corner of search area
+          * \param[in] max_pt upper corner of search area
+          * \param[out] k_indices the resultant point indices
+          * \return number of points found within search area
+          */
+        int
+        boxSearch (const Eigen::Vector3f &min_pt, const Eigen::Vector3f &max_pt, std::vector<int> &k_indices) const;
+
+        /** \brief Get a PointT vector of centers of all occupied voxels, in Morton order.
+          * \param[out] voxelCenterList_arg results are written to this vector of PointT elements
+          * \return number of occupied voxels
+          */
+        int
+        getOccupiedVoxelCenters (AlignedPointTVector &voxelCenterList_arg) const;
+
+        /** \brief Get a PointT vector of the centroids of the points of all occupied voxels, in Morton order.
+          * \param[out] voxelCentroidList_arg results are written to this vector of PointT elements
+          * \return number of occupied voxels
+          */
+        std::size_t
+        getVoxelCentroids (AlignedPointTVector &voxelCentroidList_arg) const;
+
+      protected:
+
+        /** \brief A point index and the Morton code of its voxel, as sorted by the radix sort. */
+        struct MortonEntry
+        {
+          uint64_t code;
+          int index;
+        };
+
+        /** \brief A node of the tree and its squared distance to the query point, closest first in a priority queue. */
+        struct NodeQueueEntry
+        {
+          float sqr_distance;
+          unsigned int depth;
+          int node;
+
+          bool
+          operator< (const NodeQueueEntry& rhs) const
+          {
+            return (sqr_distance > rhs.sqr_distance);
+          }
+        };
+
+        /** \brief Get point at index from input pointcloud dataset. As in OctreePointCloud, the index refers to the
+          * input cloud directly, the indices given to \a setInputCloud are not applied.
+          * \param[in] index_arg index representing the point in the dataset given by \a setInputCloud
+          * \return PointT from input pointcloud dataset
+          */
+        const PointT&
+        getPointByIndex (const int index_arg) const;
+
+        /** \brief Generate the Morton code of the leaf voxel at a given point.
+          * \param[in] point_arg the point, must lie inside the bounding box
+          * \return the Morton code of the leaf voxel
+          */
+        uint64_t
+        genMortonCodeForPoint (const PointT& point_arg) const;
+
+        /** \brief Compute the bounding box of a node.
+          * \param[in] depth_arg depth of the node (0 is the root)
+          * \param[in] code_arg Morton code of the node at that depth
+          * \param[out] min_pt lower corner of the node
+          * \param[out] max_pt upper corner of the node
+          */
+        void
+        genVoxelBounds (unsigned int depth_arg, uint64_t code_arg, Eigen::Vector3f &min_pt, Eigen::Vector3f &max_pt) const;
+
+        /** \brief Squared distance between a point and the bounding box of a node (0 if the point is inside).
+          * \param[in] point_arg the query point
+          * \param[in] depth_arg depth of the node
+          * \param[in] code_arg Morton code of the node
+          */
+        float
+        pointToVoxelSqrDistance (const PointT& point_arg, unsigned int depth_arg, uint64_t code_arg) const;
+
+        /** \brief Calculate squared distance between two points
+          * \param[in] pointA point A
+          * \param[in] pointB point B
+          * \return squared distance between point A and point B
+          */
+        inline float
+        pointSquaredDist (const PointT& pointA, const PointT& pointB) const
+        {
+          return ((pointA.x - pointB.x) * (pointA.x - pointB.x) + (pointA.y - pointB.y) * (pointA.y - pointB.y)
+                  + (pointA.z - pointB.z) * (pointA.z - pointB.z));
+        }
+
+        /** \brief Merge runs of equal code prefixes into the nodes of the level above.
+          * \param[in] codes sorted codes of the level below (or of the points)
+          * \param[in] shift number of bits dropped from \a codes to get the prefixes
+          * \param[out] node_codes the distinct prefixes, in increasing order
+          * \param[out] node_children offset of the first element of \a codes of each prefix, followed by the size of \a codes
+          */
+        void
+        compactCodes (const std::vector<uint64_t> &codes, unsigned int shift,
+                      std::vector<uint64_t> &node_codes, std::vector<int> &node_children) const;
+
+        /** \brief Sort Morton entries by code with a parallel LSD radix sort, 8 bits per pass.
+          * \param[in,out] entries the entries to sort
+          */
+        void
+        sortMortonEntries (std::vector<MortonEntry> &entries) const;
+
+        /** \brief Number of independent chunks a linear pass over \a size elements is split into. The split does
+          * not depend on the number of threads, so that the result of a build is always the same.
+          */
+        static inline int
+        getNumberOfChunks (int size)
+        {
+          return (std::max (1, std::min (size / 65536, 64)));
+        }
+
+        /** \brief Interleave the lower 21 bits of the three voxel coordinates into a Morton code,
+          * following the child index order of \ref OctreeKey (x is the most significant bit).
+          */
+        static inline uint64_t
+        encodeMorton (unsigned int x_arg, unsigned int y_arg, unsigned int z_arg)
+        {
+          return ((spreadBits (x_arg) << 2) | (spreadBits (y_arg) << 1) | spreadBits (z_arg));
+        }
+
+        /** \brief Extract the voxel coordinates from a Morton code. */
+        static inline void
+        decodeMorton (uint64_t code_arg, unsigned int &x_arg, unsigned int &y_arg, unsigned int &z_arg)
+        {
+          x_arg = compactBits (code_arg >> 2);
+          y_arg = compactBits (code_arg >> 1);
+          z_arg = compactBits (code_arg);
+        }
+
+        /** \brief Insert two zero bits between each of the lower 21 bits of a value. */
+        static inline uint64_t
+        spreadBits (unsigned int value_arg)
+        {
+          uint64_t v = value_arg & 0x1fffff;
+          v = (v | (v << 32)) & 0x1f00000000ffffULL;
+          v = (v | (v << 16)) & 0x1f0000ff0000ffULL;
+          v = (v | (v << 8))  & 0x100f00f00f00f00fULL;
+          v = (v | (v << 4))  & 0x10c30c30c30c30c3ULL;
+          v = (v | (v << 2))  & 0x1249249249249249ULL;
+          return (v);
+        }
+
+        /** \brief Inverse of \ref spreadBits. */
+        static inline unsigned int
+        compactBits (uint64_t value_arg)
+        {
+          uint64_t v = value_arg & 0x1249249249249249ULL;
+          v = (v | (v >> 2))  & 0x10c30c30c30c30c3ULL;
+          v = (v | (v >> 4))  & 0x100f00f00f00f00fULL;
+          v = (v | (v >> 8))  & 0x1f0000ff0000ffULL;
+          v = (v | (v >> 16)) & 0x1f00000000ffffULL;
+          v = (v | (v >> 32)) & 0x1fffff;
+          return (static_cast<unsigned int> (v));
+        }
+
+        /** \brief Pointer to input point cloud dataset. */
+        PointCloudConstPtr input_;
+
+        /** \brief A pointer to the vector of point indices to use. */
+        IndicesConstPtr indices_;
+
+        /** \brief Octree resolution. */
+        double resolution_;
+
+        // Octree bounding box coordinates
+        double minX_;
+        double maxX_;
+
+        double minY_;
+        double maxY_;
+
+        double minZ_;
+        double maxZ_;
+
+        /** \brief Octree depth, the leaves are at this depth. */
+        unsigned int octreeDepth_;
+
+        /** \brief Morton codes of the occupied nodes of each depth, in increasing order. */
+        std::vector<std::vector<uint64_t> > levelCodes_;
+
+        /** \brief For each depth, offsets of the first child of each node in the next depth (one more than the nodes).
+          * At the leaf depth the offsets point into \ref pointIndices_.
+          */
+        std::vector<std::vector<int> > levelChildren_;
+
+        /** \brief Indices of the points of the tree, sorted by the Morton code of their leaf. */
+        std::vector<int> pointIndices_;
+
+        /** \brief The number of threads the scheduler should use. */
+        unsigned int threads_;
+
+        /** \brief Maximum depth supported by 64 bit Morton codes. */
+        static const unsigned int MAX_DEPTH = 21;
+    };
+  }
+}
+
+#define PCL_INSTANTIATE_OctreePointCloudLinearSearch(T) template class PCL_EXPORTS pcl::octree::OctreePointCloudLinearSearch<T>;
+
+#endif // PCL_OCTREE_POINTCLOUD_LINEAR_SEARCH_H_
@@ -61,6 +61,7 @@ PCL_INSTANTIATE(OctreePointCloudDoubleBufferWithLeafDataTVector,
     PCL_XYZ_POINT_TYPES)
 
 PCL_INSTANTIATE(OctreePointCloudSearch, PCL_XYZ_POINT_TYPES)
+PCL_INSTANTIATE(OctreePointCloudLinearSearch, PCL_XYZ_POINT_TYPES)
 
 
 // PCL_INSTANTIATE(OctreePointCloudSingleBufferWithLeafDataT, PCL_XYZ_POINT_TYPES);
@@ -0,0 +1,472 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_OUTOFCORE_OUTLIER_REMOVAL_H_
+#define PCL_OUTOFCORE_OUTLIER_REMOVAL_H_
+
+#include <pcl/pcl_macros.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <sensor_msgs/PointCloud2.h>
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace pcl
+{
+  namespace outofcore
+  {
+    /** \brief @b OutofcoreOutlierRemoval is the base class of the outlier removal filters for point clouds stored
+      * in binary PCD files that do not fit in memory.
+      * \details The input file is streamed once to partition space into cubic blocks, each block spilling its
+      * points to a temporary file. The blocks are then processed in parallel: each one is loaded together with
+      * the points of the neighboring blocks that lie within a margin around it, so that the neighborhoods of the
+      * points near the block boundaries are complete. Finally, the input file is streamed again and the points
+      * kept are copied, with all their fields and in their original order, to the output PCD file.
+      * <br>
+      * The memory used is bounded by the number of points read at once (\ref setChunkSize), one bit per input
+      * point, and the points of the blocks (and margins) processed at the same time, one per thread, each thread
+      * also keeping the last blocks it read (\ref setBlockCacheSize).
+      * \ingroup outofcore
+      */
+    class PCL_EXPORTS OutofcoreOutlierRemoval
+    {
+      public:
+        /** \brief Constructor. */
+        OutofcoreOutlierRemoval ();
+
+        /** \brief Destructor. */
+        virtual ~OutofcoreOutlierRemoval () {}
+
+        /** \brief Set the edge length of the cubic blocks space is partitioned into.
+          * \param[in] block_size the edge length of a block
+          */
+        inline void
+        setBlockSize (double block_size)
+        {
+          block_size_ = block_size;
+        }
+
+        /** \brief Get the edge length of the cubic blocks space is partitioned into. */
+        inline double
+        getBlockSize () const
+        {
+          return (block_size_);
+        }
+
+        /** \brief Set the number of points read from the input file at once.
+          * \param[in] nr_points the number of points per chunk
+          */
+        inline void
+        setChunkSize (unsigned int nr_points)
+        {
+          chunk_size_ = (std::max) (nr_points, 1u);
+        }
+
+        /** \brief Get the number of points read from the input file at once. */
+        inline unsigned int
+        getChunkSize () const
+        {
+          return (chunk_size_);
+        }
+
+        /** \brief Set the number of blocks each thread keeps in memory after reading them, so that the neighbor
+          * blocks shared by consecutive blocks are not read again from their temporary files.
+          * \param[in] nr_blocks the number of blocks cached per thread (at least 1)
+          */
+        inline void
+        setBlockCacheSize (unsigned int nr_blocks)
+        {
+          cache_size_ = (std::max) (nr_blocks, 1u);
+        }
+
+        /** \brief Get the number of blocks each thread keeps in memory after reading them. */
+        inline unsigned int
+        getBlockCacheSize () const
+        {
+          return (cache_size_);
+        }
+
+        /** \brief Set the directory the temporary block files are written to (the directory of the output file
+          * by default).
+          * \param[in] directory an existing directory
+          */
+        inline void
+        setTemporaryDirectory (const std::string &directory)
+        {
+          temporary_directory_ = directory;
+        }
+
+        /** \brief Set the number of threads processing the blocks.
+          * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+          */
+        inline void
+        setNumberOfThreads (unsigned int nr_threads = 0)
+        {
+          threads_ = nr_threads;
+        }
+
+        /** \brief Set whether the regular conditions for points filtering should apply, or the inverted conditions.
+          * \param[in] negative false = normal filter behavior (default), true = inverted behavior
+          */
+        inline void
+        setNegative (bool negative)
+        {
+          negative_ = negative;
+        }
+
+        /** \brief Get whether the regular conditions for points filtering should apply, or the inverted conditions. */
+        inline bool
+        getNegative () const
+        {
+          return (negative_);
+        }
+
+        /** \brief Filter a binary PCD file into another one.
+          * \param[in] input_file the input binary PCD file, its points must have float x, y and z fields
+          * \param[in] output_file the output binary PCD file, containing the points kept with all their fields
+          * \return the number of points written to the output file, -1 on error
+          */
+        int64_t
+        filter (const std::string &input_file, const std::string &output_file);
+
+      protected:
+        /** \brief The coordinates of a point in a block file, and its position in the input file. */
+        struct BlockPoint
+        {
+          float x, y, z;
+          uint64_t index;
+        };
+
+        /** \brief A cubic block of space, its points being stored in a temporary file. */
+        struct Block
+        {
+          Block () : cell (), file_name (), size (0) {}
+
+          /** \brief The integer coordinates of the block. */
+          int cell[3];
+          /** \brief The temporary file of the points of the block. */
+          std::string file_name;
+          /** \brief The number of points of the block. */
+          uint64_t size;
+        };
+
+        /** \brief The blocks read last by a thread, with their points, most recently used first. */
+        typedef std::list<std::pair<size_t, std::vector<BlockPoint> > > BlockCache;
+
+        /** \brief Classify the points of the blocks, calling \ref keepPoint for the points to keep.
+          * \return false on error
+          */
+        virtual bool
+        processBlocks () = 0;
+
+        /** \brief Returns true if the points with non finite coordinates are kept. Called after \ref processBlocks. */
+        virtual bool
+        keepNonFinitePoints () const = 0;
+
+        /** \brief Load a block and the points of its neighbor blocks lying within a margin around it.
+          * \param[in] block the position of the block in blocks_
+          * \param[in] margin the margin around the block
+          * \param[out] cloud the points of the block first, followed by the points in the margin
+          * \param[out] indices the positions in the input file of the points of the block
+          * \param[out] complete true if no point of any block lies outside of the block expanded by the margin
+          * \param[in,out] cache the blocks read last by the calling thread
+          * \return false on error
+          */
+        bool
+        loadBlock (size_t block, double margin, pcl::PointCloud<pcl::PointXYZ> &cloud,
+                   std::vector<uint64_t> &indices, bool &complete, BlockCache &cache) const;
+
+        /** \brief Get the points of a block from a cache, reading the block if it is not in the cache.
+          * \param[in] block the position of the block in blocks_
+          * \param[in,out] cache the blocks read last by the calling thread
+          * \return the points of the block, valid until the next call with the same cache, NULL on error
+          */
+        const std::vector<BlockPoint>*
+        getCachedBlock (size_t block, BlockCache &cache) const;
+
+        /** \brief Read the points of a block from its temporary file.
+          * \param[in] block the position of the block in blocks_
+          * \param[out] points the points of the block, in the order of the input file
+          * \return false on error
+          */
+        bool
+        readBlock (size_t block, std::vector<BlockPoint> &points) const;
+
+        /** \brief Get the distance of a point of a block to the boundary of the block expanded by a margin.
+          * \param[in] block the position of the block in blocks_
+          * \param[in] margin the margin around the block
+          * \param[in] point the point, inside the block
+          */
+        double
+        getDistanceToBoundary (size_t block, double margin, const pcl::PointXYZ &point) const;
+
+        /** \brief Mark a point of the input file as kept. Can be called concurrently.
+          * \param[in] index the position of the point in the input file
+          */
+        inline void
+        keepPoint (uint64_t index)
+        {
+          const unsigned char bit = static_cast<unsigned char> (1 << (index & 7));
+#pragma omp atomic
+          keep_[index >> 3] |= bit;
+        }
+
+        /** \brief The blocks of the input cloud. */
+        std::vector<Block> blocks_;
+
+        /** \brief The position in blocks_ of each block, by integer coordinates. */
+        std::map<std::pair<int, std::pair<int, int> >, size_t> block_ids_;
+
+        /** \brief The temporary files of the blocks are named prefix_ + block number + extension. */
+        std::string prefix_;
+
+        /** \brief The number of points of the input cloud. */
+        uint64_t nr_points_;
+
+        /** \brief The number of points of the input cloud with non finite coordinates. */
+        uint64_t nr_non_finite_;
+
+        /** \brief The edge length of the blocks. */
+        double block_size_;
+
+        /** \brief The number of points read from the input file at once. */
+        unsigned int chunk_size_;
+
+        /** \brief The directory of the temporary block files. */
+        std::string temporary_directory_;
+
+        /** \brief The number of threads processing the blocks. */
+        unsigned int threads_;
+
+        /** \brief The number of blocks each thread keeps in memory after reading them. */
+        unsigned int cache_size_;
+
+        /** \brief If true, the points that would be removed are kept, and vice versa. */
+        bool negative_;
+
+        /** \brief One bit per point of the input file, set if the point is kept. */
+        std::vector<unsigned char> keep_;
+
+      private:
+        /** \brief Stream the input file into the block files.
+          * \param[in] input_file the input binary PCD file
+          * \param[in] header the header of the input file
+          * \param[in] data_idx the offset of the point data in the input file
+          * \return false on error
+          */
+        bool
+        partition (const std::string &input_file, const sensor_msgs::PointCloud2 &header, unsigned int data_idx);
+
+        /** \brief Stream the input file into the output file, copying the points kept.
+          * \param[in] input_file the input binary PCD file
+          * \param[in] header the header of the input file
+          * \param[in] data_idx the offset of the point data in the input file
+          * \param[in] origin the sensor acquisition origin of the input file
+          * \param[in] orientation the sensor acquisition orientation of the input file
+          * \param[in] output_file the output binary PCD file
+          * \return the number of points written, -1 on error
+          */
+        int64_t
+        write (const std::string &input_file, const sensor_msgs::PointCloud2 &header, unsigned int data_idx,
+               const Eigen::Vector4f &origin, const Eigen::Quaternionf &orientation, const std::string &output_file);
+
+        /** \brief Remove the temporary files of the blocks. */
+        void
+        removeBlockFiles ();
+    };
+
+    /** \brief @b OutofcoreStatisticalOutlierRemoval is the out of core counterpart of
+      * pcl::StatisticalOutlierRemoval: it removes the points whose mean distance to their k nearest neighbors is
+      * above mean + stddev_mult * stddev of the mean distances of all the points.
+      * \details A block is first loaded with the points of its neighbors within \ref setBlockMargin. The k nearest
+      * neighbors of a point are exact if they are closer than the boundary of the loaded region; the other points
+      * of the block are searched again with a margin large enough, until all the neighborhoods are exact. The
+      * mean distances of a block are kept in a temporary file until the global mean and standard deviation are
+      * known.
+      * \note The output matches the one of pcl::StatisticalOutlierRemoval on the whole cloud, up to the rounding
+      * of the sums of the mean distances, which are accumulated in a different order.
+      * \ingroup outofcore
+      */
+    class PCL_EXPORTS OutofcoreStatisticalOutlierRemoval : public OutofcoreOutlierRemoval
+    {
+      public:
+        /** \brief Constructor. */
+        OutofcoreStatisticalOutlierRemoval ();
+
+        /** \brief Set the number of nearest neighbors to use for mean distance estimation.
+          * \param[in] nr_k the number of points to use for mean distance estimation
+          */
+        inline void
+        setMeanK (int nr_k)
+        {
+          mean_k_ = nr_k;
+        }
+
+        /** \brief Get the number of nearest neighbors to use for mean distance estimation. */
+        inline int
+        getMeanK () const
+        {
+          return (mean_k_);
+        }
+
+        /** \brief Set the standard deviation multiplier for the distance threshold calculation.
+          * \param[in] stddev_mult the standard deviation multiplier
+          */
+        inline void
+        setStddevMulThresh (double stddev_mult)
+        {
+          std_mul_ = stddev_mult;
+        }
+
+        /** \brief Get the standard deviation multiplier for the distance threshold calculation. */
+        inline double
+        getStddevMulThresh () const
+        {
+          return (std_mul_);
+        }
+
+        /** \brief Set the margin the blocks are first loaded with. A margin close to the distance to the k-th
+          * neighbor of most points avoids searching the points near the block boundaries again.
+          * \param[in] margin the initial margin around the blocks (a quarter of the block size if 0)
+          */
+        inline void
+        setBlockMargin (double margin)
+        {
+          margin_ = margin;
+        }
+
+        /** \brief Get the distance threshold computed by the last call to filter. */
+        inline double
+        getDistanceThreshold () const
+        {
+          return (distance_threshold_);
+        }
+
+      protected:
+        bool
+        processBlocks ();
+
+        bool
+        keepNonFinitePoints () const
+        {
+          // points with non finite coordinates have a mean distance of 0
+          return (negative_ ? 0 > distance_threshold_ : 0 <= distance_threshold_);
+        }
+
+      private:
+        /** \brief The number of points to use for mean distance estimation. */
+        int mean_k_;
+
+        /** \brief The standard deviation multiplier. */
+        double std_mul_;
+
+        /** \brief The margin the blocks are first loaded with. */
+        double margin_;
+
+        /** \brief The distance threshold: mean + std_mul_ * stddev. */
+        double distance_threshold_;
+    };
+
+    /** \brief @b OutofcoreRadiusOutlierRemoval is the out of core counterpart of pcl::RadiusOutlierRemoval: it
+      * removes the points that do not have a given number of neighbors within a given radius. The blocks are
+      * loaded with a margin equal to the radius, so the neighborhoods, and the output, are exact.
+      * \ingroup outofcore
+      */
+    class PCL_EXPORTS OutofcoreRadiusOutlierRemoval : public OutofcoreOutlierRemoval
+    {
+      public:
+        /** \brief Constructor. */
+        OutofcoreRadiusOutlierRemoval ();
+
+        /** \brief Set the radius of the sphere that will determine which points are neighbors.
+          * \param[in] radius the radius of the sphere for nearest neighbor searching
+          */
+        inline void
+        setRadiusSearch (double radius)
+        {
+          search_radius_ = radius;
+        }
+
+        /** \brief Get the radius of the sphere that will determine which points are neighbors. */
+        inline double
+        getRadiusSearch () const
+        {
+          return (search_radius_);
+        }
+
+        /** \brief Set the number of neighbors (including the point itself) that need to be present in order to be
+          * classified as an inlier.
+          * \param[in] min_pts the minimum number of neighbors
+          */
+        inline void
+        setMinNeighborsInRadius (int min_pts)
+        {
+          min_pts_radius_ = min_pts;
+        }
+
+        /** \brief Get the number of neighbors that need to be present in order to be classified as an inlier. */
+        inline int
+        getMinNeighborsInRadius () const
+        {
+          return (min_pts_radius_);
+        }
+
+      protected:
+        bool
+        processBlocks ();
+
+        bool
+        keepNonFinitePoints () const
+        {
+          // points with non finite coordinates have no neighbors
+          return (negative_ ? 0 <= min_pts_radius_ : 0 > min_pts_radius_);
+        }
+
+      private:
+        /** \brief The radius of the neighborhoods. */
+        double search_radius_;
+
+        /** \brief The minimum number of neighbors of an inlier. */
+        int min_pts_radius_;
+    };
+  }
+}
+
+#endif  // PCL_OUTOFCORE_OUTLIER_REMOVAL_H_
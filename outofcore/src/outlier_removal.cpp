@@ -0,0 +1,583 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <pcl/outofcore/outlier_removal.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/common/io.h>
+#include <pcl/search/kdtree.h>
+#include <pcl/console/print.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl::outofcore::OutofcoreOutlierRemoval::OutofcoreOutlierRemoval ()
+  : blocks_ ()
+  , block_ids_ ()
+  , prefix_ ()
+  , nr_points_ (0)
+  , nr_non_finite_ (0)
+  , block_size_ (1.0)
+  , chunk_size_ (1000000)
+  , temporary_directory_ ()
+  , threads_ (0)
+  , cache_size_ (8)
+  , negative_ (false)
+  , keep_ ()
+{
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl::int64_t
+pcl::outofcore::OutofcoreOutlierRemoval::filter (const std::string &input_file, const std::string &output_file)
+{
+  if (block_size_ <= 0)
+  {
+    PCL_ERROR ("[pcl::outofcore::OutofcoreOutlierRemoval::filter] Invalid block size %f!\n", block_size_);
+    return (-1);
+  }
+
+  pcl::PCDReader reader;
+  sensor_msgs::PointCloud2 header;
+  Eigen::Vector4f origin;
+  Eigen::Quaternionf orientation;
+  int pcd_version, data_type;
+  unsigned int data_idx;
+  if (reader.readHeader (input_file, header, origin, orientation, pcd_version, data_type, data_idx) < 0)
+  {
+    PCL_ERROR ("[pcl::outofcore::OutofcoreOutlierRemoval::filter] Could not read the header of %s!\n", input_file.c_str ());
+    return (-1);
+  }
+  if (data_type != 1)
+  {
+    PCL_ERROR ("[pcl::outofcore::OutofcoreOutlierRemoval::filter] %s is not a binary PCD file, it can not be streamed!\n", input_file.c_str ());
+    return (-1);
+  }
+  const int x_idx = pcl::getFieldIndex (header, "x");
+  const int y_idx = pcl::getFieldIndex (header, "y");
+  const int z_idx = pcl::getFieldIndex (header, "z");
+  if (x_idx == -1 || y_idx == -1 || z_idx == -1 ||
+      header.fields[x_idx].datatype != sensor_msgs::PointField::FLOAT32 ||
+      header.fields[y_idx].datatype != sensor_msgs::PointField::FLOAT32 ||
+      header.fields[z_idx].datatype != sensor_msgs::PointField::FLOAT32)
+  {
+    PCL_ERROR ("[pcl::outofcore::OutofcoreOutlierRemoval::filter] %s has no float x, y and z fields!\n", input_file.c_str ());
+    return (-1);
+  }
+
+  boost::filesystem::path directory (temporary_directory_);
+  if (temporary_directory_.empty ())
+    directory = boost::filesystem::path (output_file).parent_path ();
+  prefix_ = (directory / boost::filesystem::path (output_file).filename ()).string () + ".block_";
+
+  nr_points_ = static_cast<uint64_t> (header.width) * header.height;
+  keep_.assign ((nr_points_ + 7) / 8, 0);
+  bool success = partition (input_file, header, data_idx) && processBlocks ();
+  removeBlockFiles ();
+  if (!success)
+    return (-1);
+
+  return (write (input_file, header, data_idx, origin, orientation, output_file));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl::outofcore::OutofcoreOutlierRemoval::partition (const std::string &input_file,
+                                                    const sensor_msgs::PointCloud2 &header, unsigned int data_idx)
+{
+  std::ifstream fs (input_file.c_str (), std::ios::in | std::ios::binary);
+  fs.seekg (data_idx);
+
+  const unsigned int point_step = header.point_step;
+  const unsigned int x_offset = header.fields[pcl::getFieldIndex (header, "x")].offset;
+  const unsigned int y_offset = header.fields[pcl::getFieldIndex (header, "y")].offset;
+  const unsigned int z_offset = header.fields[pcl::getFieldIndex (header, "z")].offset;
+
+  blocks_.clear ();
+  block_ids_.clear ();
+  nr_non_finite_ = 0;
+  std::vector<std::vector<BlockPoint> > chunk_points;
+  std::vector<char> buffer (static_cast<size_t> (chunk_size_) * point_step);
+
+  for (uint64_t begin = 0; begin < nr_points_; begin += chunk_size_)
+  {
+    const size_t nr_chunk_points = static_cast<size_t> ((std::min) (static_cast<uint64_t> (chunk_size_), nr_points_ - begin));
+    fs.read (&buffer[0], nr_chunk_points * point_step);
+    if (!fs)
+    {
+      PCL_ERROR ("[pcl::outofcore::OutofcoreOutlierRemoval::partition] Could not read the points of %s!\n", input_file.c_str ());
+      return (false);
+    }
+
+    // bucket the points of the chunk by block
+    for (size_t i = 0; i < nr_chunk_points; ++i)
+    {
+      BlockPoint point;
+      memcpy (&point.x, &buffer[i * point_step + x_offset], sizeof (float));
+      memcpy (&point.y, &buffer[i * point_step + y_offset], sizeof (float));
+      memcpy (&point.z, &buffer[i * point_step + z_offset], sizeof (float));
+      if (!pcl_isfinite (point.x) || !pcl_isfinite (point.y) || !pcl_isfinite (point.z))
+      {
+        ++nr_non_finite_;
+        continue;
+      }
+      point.index = begin + i;
+
+      int cell[3];
+      cell[0] = static_cast<int> (floor (point.x / block_size_));
+      cell[1] = static_cast<int> (floor (point.y / block_size_));
+      cell[2] = static_cast<int> (floor (point.z / block_size_));
+      std::pair<std::map<std::pair<int, std::pair<int, int> >, size_t>::iterator, bool> inserted =
+        block_ids_.insert (std::make_pair (std::make_pair (cell[0], std::make_pair (cell[1], cell[2])), blocks_.size ()));
+      if (inserted.second)
+      {
+        blocks_.push_back (Block ());
+        std::copy (cell, cell + 3, blocks_.back ().cell);
+        blocks_.back ().file_name = prefix_ + boost::lexical_cast<std::string> (blocks_.size () - 1) + ".bin";
+        chunk_points.resize (blocks_.size ());
+      }
+      chunk_points[inserted.first->second].push_back (point);
+    }
+
+    // and append them to the block files
+    for (size_t block = 0; block < blocks_.size (); ++block)
+    {
+      if (chunk_points[block].empty ())
+        continue;
+
+      FILE *file = fopen (blocks_[block].file_name.c_str (), "ab");
+      const size_t written = file ? fwrite (&chunk_points[block][0], sizeof (BlockPoint), chunk_points[block].size (), file) : 0;
+      if (file)
+        fclose (file);
+      if (written != chunk_points[block].size ())
+      {
+        PCL_ERROR ("[pcl::outofcore::OutofcoreOutlierRemoval::partition] Could not write to %s!\n", blocks_[block].file_name.c_str ());
+        return (false);
+      }
+      blocks_[block].size += chunk_points[block].size ();
+      chunk_points[block].clear ();
+    }
+  }
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl::outofcore::OutofcoreOutlierRemoval::readBlock (size_t block, std::vector<BlockPoint> &points) const
+{
+  points.resize (static_cast<size_t> (blocks_[block].size));
+  FILE *file = fopen (blocks_[block].file_name.c_str (), "rb");
+  const size_t read = file ? fread (&points[0], sizeof (BlockPoint), points.size (), file) : 0;
+  if (file)
+    fclose (file);
+  if (read != points.size ())
+  {
+    PCL_ERROR ("[pcl::outofcore::OutofcoreOutlierRemoval::readBlock] Could not read %s!\n", blocks_[block].file_name.c_str ());
+    return (false);
+  }
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl::outofcore::OutofcoreOutlierRemoval::loadBlock (size_t block, double margin, pcl::PointCloud<pcl::PointXYZ> &cloud,
+                                                    std::vector<uint64_t> &indices, bool &complete, BlockCache &cache) const
+{
+  const Block &home = blocks_[block];
+  const int ring = static_cast<int> (ceil (margin / block_size_));
+  double min[3], max[3];
+  for (int d = 0; d < 3; ++d)
+  {
+    min[d] = home.cell[d] * block_size_ - margin;
+    max[d] = (home.cell[d] + 1) * block_size_ + margin;
+  }
+
+  const std::vector<BlockPoint> *home_points = getCachedBlock (block, cache);
+  if (!home_points)
+    return (false);
+  cloud.clear ();
+  indices.resize (home_points->size ());
+  for (size_t i = 0; i < home_points->size (); ++i)
+  {
+    cloud.push_back (pcl::PointXYZ ((*home_points)[i].x, (*home_points)[i].y, (*home_points)[i].z));
+    indices[i] = (*home_points)[i].index;
+  }
+
+  // the neighbor blocks within the ring, looked up by their coordinates unless the ring has more cells than there are blocks
+  std::vector<size_t> neighbors;
+  const double nr_cells = pow (2.0 * ring + 1.0, 3);
+  if (nr_cells <= static_cast<double> (blocks_.size ()))
+  {
+    for (int x = home.cell[0] - ring; x <= home.cell[0] + ring; ++x)
+      for (int y = home.cell[1] - ring; y <= home.cell[1] + ring; ++y)
+        for (int z = home.cell[2] - ring; z <= home.cell[2] + ring; ++z)
+        {
+          std::map<std::pair<int, std::pair<int, int> >, size_t>::const_iterator it =
+            block_ids_.find (std::make_pair (x, std::make_pair (y, z)));
+          if (it != block_ids_.end () && it->second != block)
+            neighbors.push_back (it->second);
+        }
+  }
+  else
+  {
+    for (size_t other = 0; other < blocks_.size (); ++other)
+      if (other != block &&
+          abs (blocks_[other].cell[0] - home.cell[0]) <= ring &&
+          abs (blocks_[other].cell[1] - home.cell[1]) <= ring &&
+          abs (blocks_[other].cell[2] - home.cell[2]) <= ring)
+        neighbors.push_back (other);
+  }
+
+  // the blocks out of the ring have points outside of the margin
+  complete = (neighbors.size () + 1 == blocks_.size ());
+  for (size_t n = 0; n < neighbors.size (); ++n)
+  {
+    const std::vector<BlockPoint> *other_points = getCachedBlock (neighbors[n], cache);
+    if (!other_points)
+      return (false);
+    const std::vector<BlockPoint> &points = *other_points;
+    for (size_t i = 0; i < points.size (); ++i)
+    {
+      if (points[i].x >= min[0] && points[i].x <= max[0] &&
+          points[i].y >= min[1] && points[i].y <= max[1] &&
+          points[i].z >= min[2] && points[i].z <= max[2])
+        cloud.push_back (pcl::PointXYZ (points[i].x, points[i].y, points[i].z));
+      else
+        complete = false;
+    }
+  }
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+const std::vector<pcl::outofcore::OutofcoreOutlierRemoval::BlockPoint>*
+pcl::outofcore::OutofcoreOutlierRemoval::getCachedBlock (size_t block, BlockCache &cache) const
+{
+  for (BlockCache::iterator it = cache.begin (); it != cache.end (); ++it)
+  {
+    if (it->first == block)
+    {
+      cache.splice (cache.begin (), cache, it);
+      return (&cache.front ().second);
+    }
+  }
+
+  // the least recently used block is dropped, its storage is reused for the block read
+  if (cache.size () >= cache_size_)
+    cache.splice (cache.begin (), cache, --cache.end ());
+  else
+    cache.push_front (std::make_pair (block, std::vector<BlockPoint> ()));
+  cache.front ().first = block;
+  if (!readBlock (block, cache.front ().second))
+  {
+    cache.pop_front ();
+    return (NULL);
+  }
+  return (&cache.front ().second);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+double
+pcl::outofcore::OutofcoreOutlierRemoval::getDistanceToBoundary (size_t block, double margin, const pcl::PointXYZ &point) const
+{
+  const int *cell = blocks_[block].cell;
+  double distance = point.x - (cell[0] * block_size_ - margin);
+  distance = (std::min) (distance, (cell[0] + 1) * block_size_ + margin - point.x);
+  distance = (std::min) (distance, point.y - (cell[1] * block_size_ - margin));
+  distance = (std::min) (distance, (cell[1] + 1) * block_size_ + margin - point.y);
+  distance = (std::min) (distance, point.z - (cell[2] * block_size_ - margin));
+  distance = (std::min) (distance, (cell[2] + 1) * block_size_ + margin - point.z);
+  return (distance);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl::int64_t
+pcl::outofcore::OutofcoreOutlierRemoval::write (const std::string &input_file, const sensor_msgs::PointCloud2 &header,
+                                                unsigned int data_idx, const Eigen::Vector4f &origin,
+                                                const Eigen::Quaternionf &orientation, const std::string &output_file)
+{
+  // the number of points kept is known before streaming them, so the header is written first
+  const bool keep_non_finite = keepNonFinitePoints ();
+  uint64_t nr_kept = keep_non_finite ? nr_non_finite_ : 0;
+  for (size_t i = 0; i < keep_.size (); ++i)
+    for (unsigned char bits = keep_[i]; bits; bits &= static_cast<unsigned char> (bits - 1))
+      ++nr_kept;
+
+  sensor_msgs::PointCloud2 output_header;
+  output_header.fields = header.fields;
+  output_header.point_step = header.point_step;
+  output_header.width = static_cast<uint32_t> (nr_kept);
+  output_header.height = 1;
+  output_header.row_step = output_header.point_step * output_header.width;
+  pcl::PCDWriter writer;
+  const std::string header_text = writer.generateHeaderBinary (output_header, origin, orientation) + "DATA binary\n";
+
+  std::ifstream in (input_file.c_str (), std::ios::in | std::ios::binary);
+  in.seekg (data_idx);
+  std::ofstream out (output_file.c_str (), std::ios::out | std::ios::binary);
+  out.write (header_text.c_str (), header_text.size ());
+
+  const unsigned int point_step = header.point_step;
+  const unsigned int x_offset = header.fields[pcl::getFieldIndex (header, "x")].offset;
+  const unsigned int y_offset = header.fields[pcl::getFieldIndex (header, "y")].offset;
+  const unsigned int z_offset = header.fields[pcl::getFieldIndex (header, "z")].offset;
+  std::vector<char> buffer (static_cast<size_t> (chunk_size_) * point_step);
+  for (uint64_t begin = 0; begin < nr_points_ && in && out; begin += chunk_size_)
+  {
+    const size_t nr_chunk_points = static_cast<size_t> ((std::min) (static_cast<uint64_t> (chunk_size_), nr_points_ - begin));
+    in.read (&buffer[0], nr_chunk_points * point_step);
+
+    // compact the points kept at the beginning of the buffer
+    size_t nr_chunk_kept = 0;
+    for (size_t i = 0; i < nr_chunk_points; ++i)
+    {
+      const uint64_t index = begin + i;
+      bool keep = (keep_[index >> 3] >> (index & 7)) & 1;
+      if (!keep && keep_non_finite)
+      {
+        float x, y, z;
+        memcpy (&x, &buffer[i * point_step + x_offset], sizeof (float));
+        memcpy (&y, &buffer[i * point_step + y_offset], sizeof (float));
+        memcpy (&z, &buffer[i * point_step + z_offset], sizeof (float));
+        keep = !pcl_isfinite (x) || !pcl_isfinite (y) || !pcl_isfinite (z);
+      }
+      if (!keep)
+        continue;
+      if (nr_chunk_kept != i)
+        memmove (&buffer[nr_chunk_kept * point_step], &buffer[i * point_step], point_step);
+      ++nr_chunk_kept;
+    }
+    out.write (&buffer[0], nr_chunk_kept * point_step);
+  }
+
+  if (!in || !out)
+  {
+    PCL_ERROR ("[pcl::outofcore::OutofcoreOutlierRemoval::write] Could not stream %s into %s!\n", input_file.c_str (), output_file.c_str ());
+    return (-1);
+  }
+  return (static_cast<int64_t> (nr_kept));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::outofcore::OutofcoreOutlierRemoval::removeBlockFiles ()
+{
+  boost::system::error_code error;
+  for (size_t block = 0; block < blocks_.size (); ++block)
+  {
+    boost::filesystem::remove (blocks_[block].file_name, error);
+    boost::filesystem::remove (blocks_[block].file_name + ".dist", error);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl::outofcore::OutofcoreStatisticalOutlierRemoval::OutofcoreStatisticalOutlierRemoval ()
+  : OutofcoreOutlierRemoval ()
+  , mean_k_ (1)
+  , std_mul_ (0.0)
+  , margin_ (0.0)
+  , distance_threshold_ (0.0)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl::outofcore::OutofcoreStatisticalOutlierRemoval::processBlocks ()
+{
+  const int nr_blocks = static_cast<int> (blocks_.size ());
+  const double initial_margin = margin_ > 0 ? margin_ : block_size_ / 4;
+  bool success = true;
+
+  // First pass: compute the mean distances of the points of each block to their k nearest neighbors, searched
+  // in the block and its margin. The mean distances are accumulated as in pcl::StatisticalOutlierRemoval.
+  double sum = 0, sq_sum = 0;
+  int64_t valid_distances = 0;
+  BlockCache cache;
+#pragma omp parallel for schedule (dynamic) private (cache) reduction (+ : sum, sq_sum, valid_distances) reduction (&& : success) num_threads (threads_)
+  for (int block = 0; block < nr_blocks; ++block)
+  {
+    pcl::PointCloud<pcl::PointXYZ>::Ptr cloud (new pcl::PointCloud<pcl::PointXYZ>);
+    pcl::search::KdTree<pcl::PointXYZ> tree (false);
+    std::vector<uint64_t> indices;
+    std::vector<int> nn_indices (mean_k_);
+    std::vector<float> nn_dists (mean_k_);
+
+    // the points of the block whose k nearest neighbors may lie outside of the loaded region
+    std::vector<int> unresolved (static_cast<size_t> (blocks_[block].size));
+    for (size_t i = 0; i < unresolved.size (); ++i)
+      unresolved[i] = static_cast<int> (i);
+    std::vector<float> distances (unresolved.size ());
+
+    double margin = initial_margin;
+    while (!unresolved.empty ())
+    {
+      bool complete;
+      if (!loadBlock (block, margin, *cloud, indices, complete, cache))
+      {
+        success = false;
+        break;
+      }
+      tree.setInputCloud (cloud);
+
+      std::vector<int> still_unresolved;
+      double needed_margin = 0;
+      for (size_t u = 0; u < unresolved.size (); ++u)
+      {
+        const int i = unresolved[u];
+        const int nr_found = tree.nearestKSearch (cloud->points[i], mean_k_ + 1, nn_indices, nn_dists);
+        if (nr_found == 0)
+          continue;
+
+        // the neighbors are exact if no point outside of the loaded region can be closer than the k-th one
+        if (!complete && (nr_found < mean_k_ + 1 || sqrt (nn_dists.back ()) >= getDistanceToBoundary (block, margin, cloud->points[i])))
+        {
+          still_unresolved.push_back (i);
+          needed_margin = (std::max) (needed_margin, static_cast<double> (sqrt (nn_dists.back ())));
+          continue;
+        }
+
+        double dist_sum = 0.0;
+        for (int k = 1; k < nr_found; ++k)  // k = 0 is the query point
+          dist_sum += sqrt (nn_dists[k]);
+        distances[i] = static_cast<float> (dist_sum / mean_k_);
+        sum += distances[i];
+        sq_sum += distances[i] * distances[i];
+        valid_distances++;
+      }
+
+      // the k-th distances found bound the ones in a larger region: loading this margin resolves all the points
+      unresolved.swap (still_unresolved);
+      margin = (std::max) (needed_margin * 1.001, margin * 2);
+    }
+
+    FILE *file = fopen ((blocks_[block].file_name + ".dist").c_str (), "wb");
+    const size_t written = file && !distances.empty () ? fwrite (&distances[0], sizeof (float), distances.size (), file) : 0;
+    if (file)
+      fclose (file);
+    if (written != distances.size ())
+    {
+      PCL_ERROR ("[pcl::outofcore::OutofcoreStatisticalOutlierRemoval::processBlocks] Could not write %s.dist!\n", blocks_[block].file_name.c_str ());
+      success = false;
+    }
+  }
+  if (!success)
+    return (false);
+
+  // Estimate the mean and the standard deviation of the distance vector
+  double mean = sum / static_cast<double>(valid_distances);
+  double variance = (sq_sum - sum * sum / static_cast<double>(valid_distances)) / (static_cast<double>(valid_distances) - 1);
+  double stddev = sqrt (variance);
+  distance_threshold_ = mean + std_mul_ * stddev;
+
+  // Second pass: Classify the points on the computed distance threshold
+#pragma omp parallel for schedule (dynamic) reduction (&& : success) num_threads (threads_)
+  for (int block = 0; block < nr_blocks; ++block)
+  {
+    std::vector<BlockPoint> points;
+    std::vector<float> distances (static_cast<size_t> (blocks_[block].size));
+    FILE *file = fopen ((blocks_[block].file_name + ".dist").c_str (), "rb");
+    const size_t read = file ? fread (&distances[0], sizeof (float), distances.size (), file) : 0;
+    if (file)
+      fclose (file);
+    if (read != distances.size () || !readBlock (block, points))
+    {
+      success = false;
+      continue;
+    }
+
+    for (size_t i = 0; i < points.size (); ++i)
+      if ((!negative_ && distances[i] <= distance_threshold_) || (negative_ && distances[i] > distance_threshold_))
+        keepPoint (points[i].index);
+  }
+  return (success);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl::outofcore::OutofcoreRadiusOutlierRemoval::OutofcoreRadiusOutlierRemoval ()
+  : OutofcoreOutlierRemoval ()
+  , search_radius_ (0.0)
+  , min_pts_radius_ (1)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl::outofcore::OutofcoreRadiusOutlierRemoval::processBlocks ()
+{
+  if (search_radius_ == 0.0)
+  {
+    PCL_ERROR ("[pcl::outofcore::OutofcoreRadiusOutlierRemoval::processBlocks] No radius defined!\n");
+    return (false);
+  }
+
+  // all the neighbors of the points of a block lie within the radius around it; the margin is slightly larger,
+  // so that the points the search finds in the radius due to rounding are loaded as well
+  const double margin = search_radius_ * 1.001;
+  const int nr_blocks = static_cast<int> (blocks_.size ());
+  bool success = true;
+  BlockCache cache;
+#pragma omp parallel for schedule (dynamic) private (cache) reduction (&& : success) num_threads (threads_)
+  for (int block = 0; block < nr_blocks; ++block)
+  {
+    pcl::PointCloud<pcl::PointXYZ>::Ptr cloud (new pcl::PointCloud<pcl::PointXYZ>);
+    pcl::search::KdTree<pcl::PointXYZ> tree (false);
+    std::vector<uint64_t> indices;
+    std::vector<int> nn_indices;
+    std::vector<float> nn_dists;
+    bool complete;
+    if (!loadBlock (block, margin, *cloud, indices, complete, cache))
+    {
+      success = false;
+      continue;
+    }
+    tree.setInputCloud (cloud);
+
+    for (size_t i = 0; i < indices.size (); ++i)
+    {
+      // Note: k includes the query point, so is always at least 1
+      int k = tree.radiusSearch (cloud->points[i], search_radius_, nn_indices, nn_dists);
+      if ((!negative_ && k > min_pts_radius_) || (negative_ && k <= min_pts_radius_))
+        keepPoint (indices[i]);
+    }
+  }
+  return (success);
+}
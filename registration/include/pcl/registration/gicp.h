@@ -50,6 +50,11 @@ namespace pcl
     * after closest point assignments have been made.
     * The original code uses GSL and ANN while in ours we use an eigen mapped BFGS and 
     * FLANN.
+    *
+    * The covariance matrices of the source and target points are computed in parallel (see
+    * IterativeClosestPoint::setNumberOfThreads) on the first align after the cloud is set, and kept for the next
+    * ones: a target registered against many sources has its covariances computed once. They can also be
+    * retrieved and given back, to share them between GeneralizedIterativeClosestPoint objects.
     * \author Nizar Sallem
     * \ingroup registration
     */
@@ -74,6 +79,7 @@ namespace pcl
       using IterativeClosestPoint<PointSource, PointTarget>::inlier_threshold_;
       using IterativeClosestPoint<PointSource, PointTarget>::min_number_correspondences_;
       using IterativeClosestPoint<PointSource, PointTarget>::update_visualizer_;
+      using IterativeClosestPoint<PointSource, PointTarget>::threads_;
 
       typedef pcl::PointCloud<PointSource> PointCloudSource;
       typedef typename PointCloudSource::Ptr PointCloudSourcePtr;
@@ -91,13 +97,17 @@ namespace pcl
 
       typedef Eigen::Matrix<double, 6, 1> Vector6d;
 
+      typedef std::vector<Eigen::Matrix3d> MatricesVector;
+      typedef boost::shared_ptr<MatricesVector> MatricesVectorPtr;
+      typedef boost::shared_ptr<const MatricesVector> MatricesVectorConstPtr;
+
       /** \brief Empty constructor. */
       GeneralizedIterativeClosestPoint () 
         : k_correspondences_(20)
         , gicp_epsilon_(0.001)
         , rotation_epsilon_(2e-3)
-        , input_covariances_(0)
-        , target_covariances_(0)
+        , input_covariances_()
+        , target_covariances_()
         , mahalanobis_(0)
         , max_inner_iterations_(20)
       {
@@ -130,7 +140,7 @@ namespace pcl
         
         input_ = input.makeShared ();
         input_tree_->setInputCloud (input_);
-        input_covariances_.reserve (input_->size ());
+        input_covariances_.reset ();
       }
 
       /** \brief Provide a pointer to the input target (e.g., the point cloud that we want to align the input source to)
@@ -140,9 +150,31 @@ namespace pcl
       setInputTarget (const PointCloudTargetConstPtr &target)
       {
         pcl::Registration<PointSource, PointTarget>::setInputTarget(target);
-        target_covariances_.reserve (target_->size ());
+        target_covariances_.reset ();
       }
 
+      /** \brief Provide a pointer to the covariance matrices of the source points, computed beforehand, e.g. by
+        * another GeneralizedIterativeClosestPoint object. Must be called after setInputCloud.
+        * \param[in] covariances the covariance matrices, one per point of the input cloud
+        */
+      inline void
+      setSourceCovariances (const MatricesVectorConstPtr &covariances) { input_covariances_ = covariances; }
+
+      /** \brief Get a pointer to the covariance matrices of the source points, null until they are computed by align. */
+      inline MatricesVectorConstPtr
+      getSourceCovariances () const { return (input_covariances_); }
+
+      /** \brief Provide a pointer to the covariance matrices of the target points, computed beforehand, e.g. by
+        * another GeneralizedIterativeClosestPoint object. Must be called after setInputTarget.
+        * \param[in] covariances the covariance matrices, one per point of the target cloud
+        */
+      inline void
+      setTargetCovariances (const MatricesVectorConstPtr &covariances) { target_covariances_ = covariances; }
+
+      /** \brief Get a pointer to the covariance matrices of the target points, null until they are computed by align. */
+      inline MatricesVectorConstPtr
+      getTargetCovariances () const { return (target_covariances_); }
+
       /** \brief Estimate a rigid rotation transformation between a source and a target point cloud using an iterative
         * non-linear Levenberg-Marquardt approach.
         * \param[in] cloud_src the source point cloud dataset
@@ -194,9 +226,17 @@ namespace pcl
         * A higher value will bring more accurate covariance matrix but will make 
         * covariances computation slower.
         * \param k the number of neighbors to use when computing covariances
+        * \note The covariances computed with the previous number of neighbors are discarded.
         */
       void
-      setCorrespondenceRandomness (int k) { k_correspondences_ = k; }
+      setCorrespondenceRandomness (int k)
+      {
+        if (k == k_correspondences_)
+          return;
+        k_correspondences_ = k;
+        input_covariances_.reset ();
+        target_covariances_.reset ();
+      }
 
       /** \brief Get the number of neighbors used when computing covariances as set by 
         * the user 
@@ -251,11 +291,11 @@ namespace pcl
       /** \brief KD tree pointer of the input cloud. */
       InputKdTreePtr input_tree_;
       
-      /** \brief Input cloud points covariances. */
-      std::vector<Eigen::Matrix3d> input_covariances_;
+      /** \brief Input cloud points covariances, null until computed. */
+      MatricesVectorConstPtr input_covariances_;
 
-      /** \brief Target cloud points covariances. */
-      std::vector<Eigen::Matrix3d> target_covariances_;
+      /** \brief Target cloud points covariances, null until computed. */
+      MatricesVectorConstPtr target_covariances_;
 
       /** \brief Mahalanobis matrices holder. */
       std::vector<Eigen::Matrix3d> mahalanobis_;
@@ -264,7 +304,7 @@ namespace pcl
       int max_inner_iterations_;
 
       /** \brief compute points covariances matrices according to the K nearest 
-        * neighbors. K is set via setCorrespondenceRandomness() methode.
+        * neighbors, in parallel. K is set via setCorrespondenceRandomness() methode.
         * \param cloud pointer to point cloud
         * \param tree KD tree performer for nearest neighbors search
         * \return cloud_covariance covariances matrices for each point in the cloud
@@ -323,6 +363,17 @@ namespace pcl
         void  df(const Vector6d &x, Vector6d &df);
         void fdf(const Vector6d &x, double &f, Vector6d &df);
 
+        /** \brief Sum the cost, and optionally the translation gradient and the rotation terms, of the
+          * correspondences. The sums are done in parallel on fixed blocks of correspondences, added in the order
+          * of the blocks, so the result does not depend on the number of threads.
+          * \param[in] x the state
+          * \param[out] f the sum of the costs
+          * \param[out] g_t the sum of the translation gradient terms M*res, if \a with_gradient
+          * \param[out] R the sum of the rotation terms, if \a with_gradient
+          * \param[in] with_gradient true to compute \a g_t and \a R
+          */
+        void sum (const Vector6d &x, double &f, Eigen::Vector3d &g_t, Eigen::Matrix3d &R, bool with_gradient) const;
+
         const GeneralizedIterativeClosestPoint *gicp_;
       };
       
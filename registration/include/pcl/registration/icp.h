@@ -81,6 +81,11 @@ namespace pcl
     * Eigen::Matrix4f transformation = icp.getFinalTransformation ();
     * \endcode
     *
+    * The correspondences are searched in parallel (see \ref setNumberOfThreads), and the transformed source
+    * points are kept in a buffer reused between the iterations. By default the transformation is estimated
+    * with the serial estimator, so that the results do not depend on the number of threads (see
+    * \ref setDeterministic).
+    *
     * \author Radu Bogdan Rusu, Michael Dixon
     * \ingroup registration
     */
@@ -99,12 +104,39 @@ namespace pcl
     public:
       /** \brief Empty constructor. */
       IterativeClosestPoint () 
+        : threads_ (0)
+        , deterministic_ (true)
+        , transformed_source_ (new PointCloudSource)
+        , nn_indices_ ()
+        , nn_dists_ ()
+        , source_indices_ ()
+        , target_indices_ ()
       {
         reg_name_ = "IterativeClosestPoint";
         ransac_iterations_ = 1000;
         transformation_estimation_.reset (new pcl::registration::TransformationEstimationSVD<PointSource, PointTarget>);
       };
 
+      /** \brief Set the number of threads used to search the correspondences and, if not deterministic, to
+        * estimate the transformation.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads = 0) { threads_ = nr_threads; }
+
+      /** \brief Set whether the transformation is estimated with the serial estimator (default), in which case
+        * the alignment is bit identical for any number of threads, or with
+        * TransformationEstimation::estimateRigidTransformationParallel, whose sums are done in parallel and
+        * may differ in the last bits from the serial ones.
+        * \param[in] deterministic true to use the serial estimator
+        */
+      inline void
+      setDeterministic (bool deterministic) { deterministic_ = deterministic; }
+
+      /** \brief Get whether the transformation is estimated with the serial estimator. */
+      inline bool
+      getDeterministic () const { return (deterministic_); }
+
     protected:
       /** \brief Rigid transformation computation method  with initial guess.
         * \param output the transformed input point cloud dataset using the rigid transformation found
@@ -133,6 +165,31 @@ namespace pcl
       using Registration<PointSource, PointTarget>::correspondence_distances_;
       using Registration<PointSource, PointTarget>::euclidean_fitness_epsilon_;
       using Registration<PointSource, PointTarget>::transformation_estimation_;
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
+
+      /** \brief True if the transformation is estimated with the serial estimator. */
+      bool deterministic_;
+
+      /** \brief The transformed source points, swapped with the output cloud during computeTransformation. */
+      PointCloudSourcePtr transformed_source_;
+
+      /** \brief The index and squared distance of the nearest neighbor of each source point, -1 if none was found. */
+      std::vector<int> nn_indices_;
+      std::vector<float> nn_dists_;
+
+      /** \brief The source and target indices of the correspondences closer than the distance threshold. */
+      std::vector<int> source_indices_;
+      std::vector<int> target_indices_;
+
+    private:
+      /** \brief Transform the points of transformed_source_ in place, in parallel, the same way as
+        * pcl::transformPointCloud does.
+        * \param[in] transform the rigid transformation to apply
+        */
+      void
+      transformSource (const Eigen::Matrix4f &transform);
   };
 }
 
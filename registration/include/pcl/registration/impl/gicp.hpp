@@ -51,68 +51,73 @@ pcl::GeneralizedIterativeClosestPoint<PointSource, PointTarget>::computeCovarian
     return;
   }
 
-  Eigen::Vector3d mean;
-  std::vector<int> nn_indecies; nn_indecies.reserve (k_correspondences_);
-  std::vector<float> nn_dist_sq; nn_dist_sq.reserve (k_correspondences_);
-
   // We should never get there but who knows
   if(cloud_covariances.size () < cloud->size ())
     cloud_covariances.resize (cloud->size ());
 
-  typename pcl::PointCloud<PointT>::const_iterator points_iterator = cloud->begin ();
-  std::vector<Eigen::Matrix3d>::iterator matrices_iterator = cloud_covariances.begin ();
-  for(;
-      points_iterator != cloud->end ();
-      ++points_iterator, ++matrices_iterator)
+  const int nr_points = static_cast<int> (cloud->size ());
+#ifdef _OPENMP
+#pragma omp parallel num_threads (threads_)
+#endif
   {
-    const PointT &query_point = *points_iterator;
-    Eigen::Matrix3d &cov = *matrices_iterator;
-    // Zero out the cov and mean
-    cov.setZero ();
-    mean.setZero ();
-
-    // Search for the K nearest neighbours
-    kdtree->nearestKSearch(query_point, k_correspondences_, nn_indecies, nn_dist_sq);
+    Eigen::Vector3d mean;
+    std::vector<int> nn_indecies; nn_indecies.reserve (k_correspondences_);
+    std::vector<float> nn_dist_sq; nn_dist_sq.reserve (k_correspondences_);
+
+#ifdef _OPENMP
+#pragma omp for schedule (dynamic, 256)
+#endif
+    for (int i = 0; i < nr_points; ++i)
+    {
+      const PointT &query_point = (*cloud)[i];
+      Eigen::Matrix3d &cov = cloud_covariances[i];
+      // Zero out the cov and mean
+      cov.setZero ();
+      mean.setZero ();
+
+      // Search for the K nearest neighbours
+      kdtree->nearestKSearch(query_point, k_correspondences_, nn_indecies, nn_dist_sq);
     
-    // Find the covariance matrix
-    for(int j = 0; j < k_correspondences_; j++) {
-      const PointT &pt = (*cloud)[nn_indecies[j]];
+      // Find the covariance matrix
+      for(int j = 0; j < k_correspondences_; j++) {
+        const PointT &pt = (*cloud)[nn_indecies[j]];
       
-      mean[0] += pt.x;
-      mean[1] += pt.y;
-      mean[2] += pt.z;
+        mean[0] += pt.x;
+        mean[1] += pt.y;
+        mean[2] += pt.z;
       
-      cov(0,0) += pt.x*pt.x;
+        cov(0,0) += pt.x*pt.x;
       
-      cov(1,0) += pt.y*pt.x;
-      cov(1,1) += pt.y*pt.y;
+        cov(1,0) += pt.y*pt.x;
+        cov(1,1) += pt.y*pt.y;
       
-      cov(2,0) += pt.z*pt.x;
-      cov(2,1) += pt.z*pt.y;
-      cov(2,2) += pt.z*pt.z;    
-    }
-  
-    mean /= static_cast<double> (k_correspondences_);
-    // Get the actual covariance
-    for (int k = 0; k < 3; k++)
-      for (int l = 0; l <= k; l++) 
-      {
-        cov(k,l) /= static_cast<double> (k_correspondences_);
-        cov(k,l) -= mean[k]*mean[l];
-        cov(l,k) = cov(k,l);
+        cov(2,0) += pt.z*pt.x;
+        cov(2,1) += pt.z*pt.y;
+        cov(2,2) += pt.z*pt.z;    
       }
+  
+      mean /= static_cast<double> (k_correspondences_);
+      // Get the actual covariance
+      for (int k = 0; k < 3; k++)
+        for (int l = 0; l <= k; l++) 
+        {
+          cov(k,l) /= static_cast<double> (k_correspondences_);
+          cov(k,l) -= mean[k]*mean[l];
+          cov(l,k) = cov(k,l);
+        }
     
-    // Compute the SVD (covariance matrix is symmetric so U = V')
-    Eigen::JacobiSVD<Eigen::Matrix3d> svd(cov, Eigen::ComputeFullU);
-    cov.setZero ();
-    Eigen::Matrix3d U = svd.matrixU ();
-    // Reconstitute the covariance matrix with modified singular values using the column     // vectors in V.
-    for(int k = 0; k < 3; k++) {
-      Eigen::Vector3d col = U.col(k);
-      double v = 1.; // biggest 2 singular values replaced by 1
-      if(k == 2)   // smallest singular value replaced by gicp_epsilon
-        v = gicp_epsilon_;
-      cov+= v * col * col.transpose(); 
+      // Compute the SVD (covariance matrix is symmetric so U = V')
+      Eigen::JacobiSVD<Eigen::Matrix3d> svd(cov, Eigen::ComputeFullU);
+      cov.setZero ();
+      Eigen::Matrix3d U = svd.matrixU ();
+      // Reconstitute the covariance matrix with modified singular values using the column     // vectors in V.
+      for(int k = 0; k < 3; k++) {
+        Eigen::Vector3d col = U.col(k);
+        double v = 1.; // biggest 2 singular values replaced by 1
+        if(k == 2)   // smallest singular value replaced by gicp_epsilon
+          v = gicp_epsilon_;
+        cov+= v * col * col.transpose(); 
+      }
     }
   }
 }
@@ -237,27 +242,77 @@ pcl::GeneralizedIterativeClosestPoint<PointSource, PointTarget>::estimateRigidTr
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////
-template <typename PointSource, typename PointTarget> inline double
-pcl::GeneralizedIterativeClosestPoint<PointSource, PointTarget>::OptimizationFunctorWithIndices::operator() (const Vector6d& x)
+template <typename PointSource, typename PointTarget> void
+pcl::GeneralizedIterativeClosestPoint<PointSource, PointTarget>::OptimizationFunctorWithIndices::sum (const Vector6d& x, double& f, Eigen::Vector3d& g_t, Eigen::Matrix3d& R, bool with_gradient) const
 {
   Eigen::Matrix4f transformation_matrix = gicp_->base_transformation_;
   gicp_->applyState(transformation_matrix, x);
-  double f = 0;
-  int m = static_cast<int> (gicp_->tmp_idx_src_->size ());
-  for (int i = 0; i < m; ++i)
+  const int m = static_cast<int> (gicp_->tmp_idx_src_->size ());
+
+  // The sums of each block are computed separately, then added in the order of the blocks
+  const int block_size = 256;
+  const int nr_blocks = (m + block_size - 1) / block_size;
+  std::vector<double> block_f (nr_blocks);
+  std::vector<Eigen::Vector3d> block_g_t (nr_blocks);
+  std::vector<Eigen::Matrix3d> block_R (nr_blocks);
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads (gicp_->threads_) schedule (static)
+#endif
+  for (int block = 0; block < nr_blocks; ++block)
+  {
+    double f_b = 0;
+    Eigen::Vector3d g_t_b = Eigen::Vector3d::Zero ();
+    Eigen::Matrix3d R_b = Eigen::Matrix3d::Zero ();
+    const int end = (std::min) (m, (block + 1) * block_size);
+    for (int i = block * block_size; i < end; ++i)
+    {
+      // The last coordinate, p_src[3] is guaranteed to be set to 1.0 in registration.hpp
+      Vector4fMapConst p_src = gicp_->tmp_src_->points[(*gicp_->tmp_idx_src_)[i]].getVector4fMap ();
+      // The last coordinate, p_tgt[3] is guaranteed to be set to 1.0 in registration.hpp
+      Vector4fMapConst p_tgt = gicp_->tmp_tgt_->points[(*gicp_->tmp_idx_tgt_)[i]].getVector4fMap ();
+      Eigen::Vector4f pp (transformation_matrix * p_src);
+      // The last coordiante is still guaranteed to be set to 1.0
+      Eigen::Vector3d res (pp[0] - p_tgt[0], pp[1] - p_tgt[1], pp[2] - p_tgt[2]);
+      // temp = M*res
+      Eigen::Vector3d temp (gicp_->mahalanobis((*gicp_->tmp_idx_src_)[i]) * res);
+      // Increment total error
+      f_b+= double(res.transpose() * temp);
+      if (!with_gradient)
+        continue;
+      // Increment translation gradient
+      // g.head<3> ()+= 2*M*res/num_matches (we postpone 2/num_matches after the loop closes)
+      g_t_b+= temp;
+      pp = gicp_->base_transformation_ * p_src;
+      Eigen::Vector3d p_src3 (pp[0], pp[1], pp[2]);
+      // Increment rotation gradient
+      R_b+= p_src3 * temp.transpose();
+    }
+    block_f[block] = f_b;
+    block_g_t[block] = g_t_b;
+    block_R[block] = R_b;
+  }
+
+  f = 0;
+  g_t.setZero ();
+  R.setZero ();
+  for (int block = 0; block < nr_blocks; ++block)
   {
-    // The last coordinate, p_src[3] is guaranteed to be set to 1.0 in registration.hpp
-    Vector4fMapConst p_src = gicp_->tmp_src_->points[(*gicp_->tmp_idx_src_)[i]].getVector4fMap ();
-    // The last coordinate, p_tgt[3] is guaranteed to be set to 1.0 in registration.hpp
-    Vector4fMapConst p_tgt = gicp_->tmp_tgt_->points[(*gicp_->tmp_idx_tgt_)[i]].getVector4fMap ();
-    Eigen::Vector4f pp (transformation_matrix * p_src);
-    // Estimate the distance (cost function)
-    // The last coordiante is still guaranteed to be set to 1.0
-    Eigen::Vector3d res(pp[0] - p_tgt[0], pp[1] - p_tgt[1], pp[2] - p_tgt[2]);
-    Eigen::Vector3d temp (gicp_->mahalanobis((*gicp_->tmp_idx_src_)[i]) * res);
-    //increment= res'*temp/num_matches = temp'*M*temp/num_matches (we postpone 1/num_matches after the loop closes)
-    f+= double(res.transpose() * temp);
+    f+= block_f[block];
+    g_t+= block_g_t[block];
+    R+= block_R[block];
   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointSource, typename PointTarget> inline double
+pcl::GeneralizedIterativeClosestPoint<PointSource, PointTarget>::OptimizationFunctorWithIndices::operator() (const Vector6d& x)
+{
+  double f;
+  Eigen::Vector3d g_t;
+  Eigen::Matrix3d R;
+  sum (x, f, g_t, R, false);
+  int m = static_cast<int> (gicp_->tmp_idx_src_->size ());
   return f/m;
 }
 
@@ -265,33 +320,13 @@ pcl::GeneralizedIterativeClosestPoint<PointSource, PointTarget>::OptimizationFun
 template <typename PointSource, typename PointTarget> inline void
 pcl::GeneralizedIterativeClosestPoint<PointSource, PointTarget>::OptimizationFunctorWithIndices::df (const Vector6d& x, Vector6d& g)
 {
-  Eigen::Matrix4f transformation_matrix = gicp_->base_transformation_;
-  gicp_->applyState(transformation_matrix, x);
-  //Zero out g
-  g.setZero ();
-  //Eigen::Vector3d g_t = g.head<3> ();
-  Eigen::Matrix3d R = Eigen::Matrix3d::Zero ();
+  double f;
+  Eigen::Vector3d g_t;
+  Eigen::Matrix3d R;
+  sum (x, f, g_t, R, true);
   int m = static_cast<int> (gicp_->tmp_idx_src_->size ());
-  for (int i = 0; i < m; ++i)
-  {
-    // The last coordinate, p_src[3] is guaranteed to be set to 1.0 in registration.hpp
-    Vector4fMapConst p_src = gicp_->tmp_src_->points[(*gicp_->tmp_idx_src_)[i]].getVector4fMap ();
-    // The last coordinate, p_tgt[3] is guaranteed to be set to 1.0 in registration.hpp
-    Vector4fMapConst p_tgt = gicp_->tmp_tgt_->points[(*gicp_->tmp_idx_tgt_)[i]].getVector4fMap ();
-
-    Eigen::Vector4f pp (transformation_matrix * p_src);
-    // The last coordiante is still guaranteed to be set to 1.0
-    Eigen::Vector3d res (pp[0] - p_tgt[0], pp[1] - p_tgt[1], pp[2] - p_tgt[2]);
-    // temp = M*res
-    Eigen::Vector3d temp (gicp_->mahalanobis ((*gicp_->tmp_idx_src_)[i]) * res);
-    // Increment translation gradient
-    // g.head<3> ()+= 2*M*res/num_matches (we postpone 2/num_matches after the loop closes)
-    g.head<3> ()+= temp;
-    // Increment rotation gradient
-    pp = gicp_->base_transformation_ * p_src;
-    Eigen::Vector3d p_src3 (pp[0], pp[1], pp[2]);
-    R+= p_src3 * temp.transpose();
-  }
+  g.setZero ();
+  g.head<3> () = g_t;
   g.head<3> ()*= 2.0/m;
   R*= 2.0/m;
   gicp_->computeRDerivative(x, R, g);
@@ -301,33 +336,12 @@ pcl::GeneralizedIterativeClosestPoint<PointSource, PointTarget>::OptimizationFun
 template <typename PointSource, typename PointTarget> inline void
 pcl::GeneralizedIterativeClosestPoint<PointSource, PointTarget>::OptimizationFunctorWithIndices::fdf (const Vector6d& x, double& f, Vector6d& g)
 {
-  Eigen::Matrix4f transformation_matrix = gicp_->base_transformation_;
-  gicp_->applyState(transformation_matrix, x);
-  f = 0;
-  g.setZero ();
-  Eigen::Matrix3d R = Eigen::Matrix3d::Zero ();
+  Eigen::Vector3d g_t;
+  Eigen::Matrix3d R;
+  sum (x, f, g_t, R, true);
   const int m = static_cast<const int> (gicp_->tmp_idx_src_->size ());
-  for (int i = 0; i < m; ++i)
-  {
-    // The last coordinate, p_src[3] is guaranteed to be set to 1.0 in registration.hpp
-    Vector4fMapConst p_src = gicp_->tmp_src_->points[(*gicp_->tmp_idx_src_)[i]].getVector4fMap ();
-    // The last coordinate, p_tgt[3] is guaranteed to be set to 1.0 in registration.hpp
-    Vector4fMapConst p_tgt = gicp_->tmp_tgt_->points[(*gicp_->tmp_idx_tgt_)[i]].getVector4fMap ();
-    Eigen::Vector4f pp (transformation_matrix * p_src);
-    // The last coordiante is still guaranteed to be set to 1.0
-    Eigen::Vector3d res (pp[0] - p_tgt[0], pp[1] - p_tgt[1], pp[2] - p_tgt[2]);
-    // temp = M*res
-    Eigen::Vector3d temp (gicp_->mahalanobis((*gicp_->tmp_idx_src_)[i]) * res);
-    // Increment total error
-    f+= double(res.transpose() * temp);
-    // Increment translation gradient
-    // g.head<3> ()+= 2*M*res/num_matches (we postpone 2/num_matches after the loop closes)
-    g.head<3> ()+= temp;
-    pp = gicp_->base_transformation_ * p_src;
-    Eigen::Vector3d p_src3 (pp[0], pp[1], pp[2]);
-    // Increment rotation gradient
-    R+= p_src3 * temp.transpose();    
-  }
+  g.setZero ();
+  g.head<3> () = g_t;
   f/= double(m);
   g.head<3> ()*= double(2.0/m);
   R*= 2.0/m;
@@ -345,10 +359,20 @@ pcl::GeneralizedIterativeClosestPoint<PointSource, PointTarget>::computeTransfor
   const size_t N = indices_->size ();
   // Set the mahalanobis matrices to identity
   mahalanobis_.resize (N, Eigen::Matrix3d::Identity ());
-  // Compute target cloud covariance matrices
-  computeCovariances<PointTarget> (target_, tree_, target_covariances_);
+  // Compute target cloud covariance matrices, unless they are kept from a previous alignment or given
+  if (!target_covariances_ || target_covariances_->size () != target_->size ())
+  {
+    MatricesVectorPtr target_covariances (new MatricesVector);
+    computeCovariances<PointTarget> (target_, tree_, *target_covariances);
+    target_covariances_ = target_covariances;
+  }
   // Compute input cloud covariance matrices
-  computeCovariances<PointSource> (input_, input_tree_, input_covariances_);
+  if (!input_covariances_ || input_covariances_->size () != input_->size ())
+  {
+    MatricesVectorPtr input_covariances (new MatricesVector);
+    computeCovariances<PointSource> (input_, input_tree_, *input_covariances);
+    input_covariances_ = input_covariances;
+  }
 
   base_transformation_ = guess;
   nr_iterations_ = 0;
@@ -387,8 +411,8 @@ pcl::GeneralizedIterativeClosestPoint<PointSource, PointTarget>::computeTransfor
       // Check if the distance to the nearest neighbor is smaller than the user imposed threshold
       if (nn_dists[0] < dist_threshold)
       {
-        Eigen::Matrix3d &C1 = input_covariances_[i];
-        Eigen::Matrix3d &C2 = target_covariances_[nn_indices[0]];
+        const Eigen::Matrix3d &C1 = (*input_covariances_)[i];
+        const Eigen::Matrix3d &C2 = (*target_covariances_)[nn_indices[0]];
         Eigen::Matrix3d &M = mahalanobis_[i];
         // M = R*C1
         M = R * C1;
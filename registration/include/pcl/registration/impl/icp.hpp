@@ -40,17 +40,42 @@
 
 #include <pcl/registration/boost.h>
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointSource, typename PointTarget> void
+pcl::IterativeClosestPoint<PointSource, PointTarget>::transformSource (const Eigen::Matrix4f &transform)
+{
+  const Eigen::Transform<float, 3, Eigen::Affine> t (transform);
+  const bool is_dense = transformed_source_->is_dense;
+  const int nr_points = static_cast<int> (transformed_source_->points.size ());
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads (threads_) schedule (static)
+#endif
+  for (int i = 0; i < nr_points; ++i)
+  {
+    PointSource &p = transformed_source_->points[i];
+    // Dataset might contain NaNs and Infs, so check for them first
+    if (!is_dense && (!pcl_isfinite (p.x) || !pcl_isfinite (p.y) || !pcl_isfinite (p.z)))
+      continue;
+    Eigen::Vector3f pt (p.x, p.y, p.z);
+    p.x = static_cast<float> (t (0, 0) * pt.coeffRef (0) + t (0, 1) * pt.coeffRef (1) + t (0, 2) * pt.coeffRef (2) + t (0, 3));
+    p.y = static_cast<float> (t (1, 0) * pt.coeffRef (0) + t (1, 1) * pt.coeffRef (1) + t (1, 2) * pt.coeffRef (2) + t (1, 3));
+    p.z = static_cast<float> (t (2, 0) * pt.coeffRef (0) + t (2, 1) * pt.coeffRef (1) + t (2, 2) * pt.coeffRef (2) + t (2, 3));
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointSource, typename PointTarget> void
 pcl::IterativeClosestPoint<PointSource, PointTarget>::computeTransformation (PointCloudSource &output, const Eigen::Matrix4f &guess)
 {
-  // Allocate enough space to hold the results
-  std::vector<int> nn_indices (1);
-  std::vector<float> nn_dists (1);
+  // Work on the points of output through transformed_source_, so that the registration model can share them
+  // without a copy; they are swapped back before returning
+  transformed_source_->swap (output);
+  transformed_source_->header = output.header;
 
-  // Point cloud containing the correspondences of each point in <input, indices>
-  PointCloudTarget input_corresp;
-  input_corresp.points.resize (indices_->size ());
+  const int nr_points = static_cast<int> (indices_->size ());
+  nn_indices_.resize (nr_points);
+  nn_dists_.resize (nr_points);
 
   nr_iterations_ = 0;
   converged_ = false;
@@ -62,13 +87,16 @@ pcl::IterativeClosestPoint<PointSource, PointTarget>::computeTransformation (Poi
     // Initialise final transformation to the guessed one
     final_transformation_ = guess;
     // Apply guessed transformation prior to search for neighbours
-    transformPointCloud (output, output, guess);
+    transformSource (guess);
   }
 
   // Resize the vector of distances between correspondences 
   std::vector<float> previous_correspondence_distances (indices_->size ());
   correspondence_distances_.resize (indices_->size ());
 
+  std::vector<int> source_indices_good;
+  std::vector<int> target_indices_good;
+
   while (!converged_)           // repeat until convergence
   {
     // Save the previously estimated transformation
@@ -76,50 +104,74 @@ pcl::IterativeClosestPoint<PointSource, PointTarget>::computeTransformation (Poi
     // And the previous set of distances
     previous_correspondence_distances = correspondence_distances_;
 
+    // Search the nearest neighbor of all the points in parallel
+#ifdef _OPENMP
+#pragma omp parallel num_threads (threads_)
+#endif
+    {
+      std::vector<int> nn_indices (1);
+      std::vector<float> nn_dists (1);
+#ifdef _OPENMP
+#pragma omp for schedule (dynamic, 256)
+#endif
+      for (int idx = 0; idx < nr_points; ++idx)
+      {
+        if (this->searchForNeighbors (*transformed_source_, (*indices_)[idx], nn_indices, nn_dists))
+        {
+          nn_indices_[idx] = nn_indices[0];
+          nn_dists_[idx] = nn_dists[0];
+        }
+        else
+          nn_indices_[idx] = -1;
+      }
+    }
+
     int cnt = 0;
-    std::vector<int> source_indices (indices_->size ());
-    std::vector<int> target_indices (indices_->size ());
+    source_indices_.resize (nr_points);
+    target_indices_.resize (nr_points);
 
     // Iterating over the entire index vector and  find all correspondences
-    for (size_t idx = 0; idx < indices_->size (); ++idx)
+    bool found_all = true;
+    for (int idx = 0; idx < nr_points; ++idx)
     {
-      if (!this->searchForNeighbors (output, (*indices_)[idx], nn_indices, nn_dists))
+      if (nn_indices_[idx] == -1)
       {
         PCL_ERROR ("[pcl::%s::computeTransformation] Unable to find a nearest neighbor in the target dataset for point %d in the source!\n", getClassName ().c_str (), (*indices_)[idx]);
-        return;
+        found_all = false;
+        break;
       }
 
       // Check if the distance to the nearest neighbor is smaller than the user imposed threshold
-      if (nn_dists[0] < dist_threshold)
+      if (nn_dists_[idx] < dist_threshold)
       {
-        source_indices[cnt] = (*indices_)[idx];
-        target_indices[cnt] = nn_indices[0];
+        source_indices_[cnt] = (*indices_)[idx];
+        target_indices_[cnt] = nn_indices_[idx];
         cnt++;
       }
 
       // Save the nn_dists[0] to a global vector of distances
-      correspondence_distances_[(*indices_)[idx]] = std::min (nn_dists[0], static_cast<float> (dist_threshold));
+      correspondence_distances_[(*indices_)[idx]] = std::min (nn_dists_[idx], static_cast<float> (dist_threshold));
     }
+    if (!found_all)
+      break;
     if (cnt < min_number_correspondences_)
     {
       PCL_ERROR ("[pcl::%s::computeTransformation] Not enough correspondences found. Relax your threshold parameters.\n", getClassName ().c_str ());
       converged_ = false;
-      return;
+      break;
     }
 
     // Resize to the actual number of valid correspondences
-    source_indices.resize (cnt); target_indices.resize (cnt);
+    source_indices_.resize (cnt); target_indices_.resize (cnt);
 
-    std::vector<int> source_indices_good;
-    std::vector<int> target_indices_good;
     {
       // From the set of correspondences found, attempt to remove outliers
       // Create the registration model
       typedef typename SampleConsensusModelRegistration<PointSource>::Ptr SampleConsensusModelRegistrationPtr;
       SampleConsensusModelRegistrationPtr model;
-      model.reset (new SampleConsensusModelRegistration<PointSource> (output.makeShared (), source_indices));
+      model.reset (new SampleConsensusModelRegistration<PointSource> (transformed_source_, source_indices_));
       // Pass the target_indices
-      model->setInputTarget (target_, target_indices);
+      model->setInputTarget (target_, target_indices_);
       // Create a RANSAC model
       RandomSampleConsensus<PointSource> sac (model, inlier_threshold_);
       sac.setMaxIterations (ransac_iterations_);
@@ -127,8 +179,8 @@ pcl::IterativeClosestPoint<PointSource, PointTarget>::computeTransformation (Poi
       // Compute the set of inliers
       if (!sac.computeModel ())
       {
-        source_indices_good = source_indices;
-        target_indices_good = target_indices;
+        source_indices_good = source_indices_;
+        target_indices_good = target_indices_;
       }
       else
       {
@@ -139,8 +191,8 @@ pcl::IterativeClosestPoint<PointSource, PointTarget>::computeTransformation (Poi
         target_indices_good.resize (inliers.size ());
 
         boost::unordered_map<int, int> source_to_target;
-        for (unsigned int i = 0; i < source_indices.size(); ++i)
-          source_to_target[source_indices[i]] = target_indices[i];
+        for (unsigned int i = 0; i < source_indices_.size(); ++i)
+          source_to_target[source_indices_[i]] = target_indices_[i];
 
         // Copy just the inliers
         std::copy(inliers.begin(), inliers.end(), source_indices_good.begin());
@@ -155,7 +207,7 @@ pcl::IterativeClosestPoint<PointSource, PointTarget>::computeTransformation (Poi
     {
       PCL_ERROR ("[pcl::%s::computeTransformation] Not enough correspondences found. Relax your threshold parameters.\n", getClassName ().c_str ());
       converged_ = false;
-      return;
+      break;
     }
 
     PCL_DEBUG ("[pcl::%s::computeTransformation] Number of correspondences %d [%f%%] out of %zu points [100.0%%], RANSAC rejected: %zu [%f%%].\n", 
@@ -163,15 +215,17 @@ pcl::IterativeClosestPoint<PointSource, PointTarget>::computeTransformation (Poi
         cnt, 
         (static_cast<float> (cnt) * 100.0f) / static_cast<float> (indices_->size ()), 
         indices_->size (), 
-        source_indices.size () - cnt, 
-        static_cast<float> (source_indices.size () - cnt) * 100.0f / static_cast<float> (source_indices.size ()));
+        source_indices_.size () - cnt, 
+        static_cast<float> (source_indices_.size () - cnt) * 100.0f / static_cast<float> (source_indices_.size ()));
   
     // Estimate the transform
-    //rigid_transformation_estimation_(output, source_indices_good, *target_, target_indices_good, transformation_);
-    transformation_estimation_->estimateRigidTransformation (output, source_indices_good, *target_, target_indices_good, transformation_);
+    if (deterministic_)
+      transformation_estimation_->estimateRigidTransformation (*transformed_source_, source_indices_good, *target_, target_indices_good, transformation_);
+    else
+      transformation_estimation_->estimateRigidTransformationParallel (*transformed_source_, source_indices_good, *target_, target_indices_good, threads_, transformation_);
 
     // Tranform the data
-    transformPointCloud (output, output, transformation_);
+    transformSource (transformation_);
 
     // Obtain the final transformation    
     final_transformation_ = transformation_ * final_transformation_;
@@ -180,7 +234,7 @@ pcl::IterativeClosestPoint<PointSource, PointTarget>::computeTransformation (Poi
 
     // Update the vizualization of icp convergence
     if (update_visualizer_ != 0)
-      update_visualizer_(output, source_indices_good, *target_, target_indices_good );
+      update_visualizer_(*transformed_source_, source_indices_good, *target_, target_indices_good );
 
     // Various/Different convergence termination criteria
     // 1. Number of iterations has reached the maximum user imposed number of iterations (via 
@@ -208,5 +262,8 @@ pcl::IterativeClosestPoint<PointSource, PointTarget>::computeTransformation (Poi
 
     }
   }
+
+  // Give the transformed points back to the caller
+  output.swap (*transformed_source_);
 }
 
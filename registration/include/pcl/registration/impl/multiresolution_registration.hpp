@@ -0,0 +1,144 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_REGISTRATION_IMPL_MULTIRESOLUTION_REGISTRATION_HPP_
+#define PCL_REGISTRATION_IMPL_MULTIRESOLUTION_REGISTRATION_HPP_
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointSource, typename PointTarget> void
+pcl::registration::MultiresolutionRegistration<PointSource, PointTarget>::buildTargetLevels (const std::vector<Level> &levels)
+{
+  target_levels_.resize (levels.size ());
+  target_trees_.resize (levels.size ());
+  for (size_t l = 0; l < levels.size (); ++l)
+  {
+    // The full resolution level shares the target and the kd-tree of this object, built only now
+    if (levels[l].leaf_size <= 0)
+    {
+      buildTargetTree ();
+      target_levels_[l] = target_;
+      target_trees_[l] = tree_;
+      continue;
+    }
+
+    PointCloudTargetPtr target (new PointCloudTarget);
+    pcl::VoxelGrid<PointTarget> grid;
+    grid.setLeafSize (levels[l].leaf_size, levels[l].leaf_size, levels[l].leaf_size);
+    grid.setInputCloud (target_);
+    grid.filter (*target);
+    // Set all the point.data[3] values to 1 to aid the rigid transformation, as Registration::setInputTarget does
+    for (size_t i = 0; i < target->points.size (); ++i)
+      target->points[i].data[3] = 1.0;
+
+    KdTreePtr tree (new pcl::KdTreeFLANN<PointTarget>);
+    tree->setInputCloud (target);
+    target_levels_[l] = target;
+    target_trees_[l] = tree;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointSource, typename PointTarget> void
+pcl::registration::MultiresolutionRegistration<PointSource, PointTarget>::computeTransformation (PointCloudSource &output, const Eigen::Matrix4f &guess)
+{
+  converged_ = false;
+  if (!registration_)
+  {
+    PCL_ERROR ("[pcl::%s::computeTransformation] No registration method given!\n", getClassName ().c_str ());
+    return;
+  }
+
+  std::vector<Level> levels = levels_;
+  if (levels.empty ())
+  {
+    Level level;
+    level.leaf_size = 0.0f;
+    level.max_iterations = max_iterations_;
+    level.max_correspondence_distance = corr_dist_threshold_;
+    level.transformation_epsilon = transformation_epsilon_;
+    level.euclidean_fitness_epsilon = euclidean_fitness_epsilon_;
+    levels.push_back (level);
+  }
+  if (target_levels_.size () != levels.size ())
+    buildTargetLevels (levels);
+
+  // output holds the points of interest of the source, untransformed
+  PointCloudSourceConstPtr source = output.makeShared ();
+  Eigen::Matrix4f transformation = guess;
+  levels_converged_.assign (levels.size (), false);
+  converged_ = true;
+
+  for (size_t l = 0; l < levels.size (); ++l)
+  {
+    // Downsample the source and move it with the transformation found on the coarser levels, so that every
+    // registration method starts from the identity
+    PointCloudSourcePtr level_source (new PointCloudSource);
+    if (levels[l].leaf_size > 0)
+    {
+      pcl::VoxelGrid<PointSource> grid;
+      grid.setLeafSize (levels[l].leaf_size, levels[l].leaf_size, levels[l].leaf_size);
+      grid.setInputCloud (source);
+      grid.filter (*level_source);
+    }
+    else
+      *level_source = *source;
+    transformPointCloud (*level_source, *level_source, transformation);
+
+    registration_->setInputCloud (level_source);
+    registration_->setSearchMethodTarget (target_trees_[l], true);
+    registration_->setInputTarget (target_levels_[l]);
+    registration_->setMaximumIterations (levels[l].max_iterations);
+    registration_->setMaxCorrespondenceDistance (levels[l].max_correspondence_distance);
+    registration_->setTransformationEpsilon (levels[l].transformation_epsilon);
+    registration_->setEuclideanFitnessEpsilon (levels[l].euclidean_fitness_epsilon);
+
+    PointCloudSource level_output;
+    registration_->align (level_output);
+    transformation = registration_->getFinalTransformation () * transformation;
+
+    levels_converged_[l] = registration_->hasConverged ();
+    converged_ = converged_ && levels_converged_[l];
+    PCL_DEBUG ("[pcl::%s::computeTransformation] Level %zu (leaf size %f): %zu source and %zu target points, converged: %d.\n",
+               getClassName ().c_str (), l, levels[l].leaf_size, level_source->points.size (),
+               target_levels_[l]->points.size (), static_cast<int> (levels_converged_[l]));
+  }
+
+  final_transformation_ = transformation;
+  transformPointCloud (output, output, final_transformation_);
+}
+
+#endif  // PCL_REGISTRATION_IMPL_MULTIRESOLUTION_REGISTRATION_HPP_
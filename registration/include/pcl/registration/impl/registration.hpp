@@ -53,7 +53,11 @@ pcl::Registration<PointSource, PointTarget>::setInputTarget (const PointCloudTar
 
   //target_ = cloud;
   target_ = target.makeShared ();
-  tree_->setInputCloud (target_);
+  // The search object may have been built on this target already, see setSearchMethodTarget
+  if (force_no_recompute_)
+    force_no_recompute_ = false;
+  else
+    tree_->setInputCloud (target_);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
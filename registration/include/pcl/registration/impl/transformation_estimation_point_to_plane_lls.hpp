@@ -143,91 +143,79 @@ constructTransformationMatrix (const double & alpha, const double & beta, const
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointSource, typename PointTarget, typename Scalar> inline void
 pcl::registration::TransformationEstimationPointToPlaneLLS<PointSource, PointTarget, Scalar>::
-estimateRigidTransformation (ConstCloudIterator<PointSource>& source_it, ConstCloudIterator<PointTarget>& target_it, Matrix4 &transformation_matrix) const
+accumulateNormalEquations (const PointSource &p_src, const PointTarget &p_tgt, Matrix6d &ATA, Vector6d &ATb) const
 {
-  typedef Eigen::Matrix<double, 6, 1> Vector6d;
-  typedef Eigen::Matrix<double, 6, 6> Matrix6d;
+  if (!pcl_isfinite (p_src.x) ||
+      !pcl_isfinite (p_src.y) ||
+      !pcl_isfinite (p_src.z) ||
+      !pcl_isfinite (p_src.normal_x) ||
+      !pcl_isfinite (p_src.normal_y) ||
+      !pcl_isfinite (p_src.normal_z) ||
+      !pcl_isfinite (p_tgt.x) ||
+      !pcl_isfinite (p_tgt.y) ||
+      !pcl_isfinite (p_tgt.z) ||
+      !pcl_isfinite (p_tgt.normal_x) ||
+      !pcl_isfinite (p_tgt.normal_y) ||
+      !pcl_isfinite (p_tgt.normal_z))
+    return;
 
-  Matrix6d ATA;
-  Vector6d ATb;
-  ATA.setZero ();
-  ATb.setZero ();
+  const float & sx = p_src.x;
+  const float & sy = p_src.y;
+  const float & sz = p_src.z;
+  const float & dx = p_tgt.x;
+  const float & dy = p_tgt.y;
+  const float & dz = p_tgt.z;
+  const float & nx = p_tgt.normal[0];
+  const float & ny = p_tgt.normal[1];
+  const float & nz = p_tgt.normal[2];
 
-  // Approximate as a linear least squares problem
-  while (source_it.isValid () && target_it.isValid ())
-  {
-    if (!pcl_isfinite (source_it->x) ||
-        !pcl_isfinite (source_it->y) ||
-        !pcl_isfinite (source_it->z) ||
-        !pcl_isfinite (source_it->normal_x) ||
-        !pcl_isfinite (source_it->normal_y) ||
-        !pcl_isfinite (source_it->normal_z) ||
-        !pcl_isfinite (target_it->x) ||
-        !pcl_isfinite (target_it->y) ||
-        !pcl_isfinite (target_it->z) ||
-        !pcl_isfinite (target_it->normal_x) ||
-        !pcl_isfinite (target_it->normal_y) ||
-        !pcl_isfinite (target_it->normal_z))
-    {
-      ++target_it;
-      ++source_it;    
-      continue;
-    }
-
-    const float & sx = source_it->x;
-    const float & sy = source_it->y;
-    const float & sz = source_it->z;
-    const float & dx = target_it->x;
-    const float & dy = target_it->y;
-    const float & dz = target_it->z;
-    const float & nx = target_it->normal[0];
-    const float & ny = target_it->normal[1];
-    const float & nz = target_it->normal[2];
-
-    double a = nz*sy - ny*sz;
-    double b = nx*sz - nz*sx; 
-    double c = ny*sx - nx*sy;
+  double a = nz*sy - ny*sz;
+  double b = nx*sz - nz*sx; 
+  double c = ny*sx - nx*sy;
    
-    //    0  1  2  3  4  5
-    //    6  7  8  9 10 11
-    //   12 13 14 15 16 17
-    //   18 19 20 21 22 23
-    //   24 25 26 27 28 29
-    //   30 31 32 33 34 35
+  //    0  1  2  3  4  5
+  //    6  7  8  9 10 11
+  //   12 13 14 15 16 17
+  //   18 19 20 21 22 23
+  //   24 25 26 27 28 29
+  //   30 31 32 33 34 35
    
-    ATA.coeffRef (0) += a * a;
-    ATA.coeffRef (1) += a * b;
-    ATA.coeffRef (2) += a * c;
-    ATA.coeffRef (3) += a * nx;
-    ATA.coeffRef (4) += a * ny;
-    ATA.coeffRef (5) += a * nz;
-    ATA.coeffRef (7) += b * b;
-    ATA.coeffRef (8) += b * c;
-    ATA.coeffRef (9) += b * nx;
-    ATA.coeffRef (10) += b * ny;
-    ATA.coeffRef (11) += b * nz;
-    ATA.coeffRef (14) += c * c;
-    ATA.coeffRef (15) += c * nx;
-    ATA.coeffRef (16) += c * ny;
-    ATA.coeffRef (17) += c * nz;
-    ATA.coeffRef (21) += nx * nx;
-    ATA.coeffRef (22) += nx * ny;
-    ATA.coeffRef (23) += nx * nz;
-    ATA.coeffRef (28) += ny * ny;
-    ATA.coeffRef (29) += ny * nz;
-    ATA.coeffRef (35) += nz * nz;
-
-    double d = nx*dx + ny*dy + nz*dz - nx*sx - ny*sy - nz*sz;
-    ATb.coeffRef (0) += a * d;
-    ATb.coeffRef (1) += b * d;
-    ATb.coeffRef (2) += c * d;
-    ATb.coeffRef (3) += nx * d;
-    ATb.coeffRef (4) += ny * d;
-    ATb.coeffRef (5) += nz * d;
+  ATA.coeffRef (0) += a * a;
+  ATA.coeffRef (1) += a * b;
+  ATA.coeffRef (2) += a * c;
+  ATA.coeffRef (3) += a * nx;
+  ATA.coeffRef (4) += a * ny;
+  ATA.coeffRef (5) += a * nz;
+  ATA.coeffRef (7) += b * b;
+  ATA.coeffRef (8) += b * c;
+  ATA.coeffRef (9) += b * nx;
+  ATA.coeffRef (10) += b * ny;
+  ATA.coeffRef (11) += b * nz;
+  ATA.coeffRef (14) += c * c;
+  ATA.coeffRef (15) += c * nx;
+  ATA.coeffRef (16) += c * ny;
+  ATA.coeffRef (17) += c * nz;
+  ATA.coeffRef (21) += nx * nx;
+  ATA.coeffRef (22) += nx * ny;
+  ATA.coeffRef (23) += nx * nz;
+  ATA.coeffRef (28) += ny * ny;
+  ATA.coeffRef (29) += ny * nz;
+  ATA.coeffRef (35) += nz * nz;
 
-    ++target_it;
-    ++source_it;    
-  }
+  double d = nx*dx + ny*dy + nz*dz - nx*sx - ny*sy - nz*sz;
+  ATb.coeffRef (0) += a * d;
+  ATb.coeffRef (1) += b * d;
+  ATb.coeffRef (2) += c * d;
+  ATb.coeffRef (3) += nx * d;
+  ATb.coeffRef (4) += ny * d;
+  ATb.coeffRef (5) += nz * d;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointSource, typename PointTarget, typename Scalar> inline void
+pcl::registration::TransformationEstimationPointToPlaneLLS<PointSource, PointTarget, Scalar>::
+solveNormalEquations (Matrix6d &ATA, const Vector6d &ATb, Matrix4 &transformation_matrix) const
+{
   ATA.coeffRef (6) = ATA.coeff (1);
   ATA.coeffRef (12) = ATA.coeff (2);
   ATA.coeffRef (13) = ATA.coeff (8);
@@ -250,4 +238,79 @@ estimateRigidTransformation (ConstCloudIterator<PointSource>& source_it, ConstCl
   // Construct the transformation matrix from x
   constructTransformationMatrix (x (0), x (1), x (2), x (3), x (4), x (5), transformation_matrix);
 }
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointSource, typename PointTarget, typename Scalar> inline void
+pcl::registration::TransformationEstimationPointToPlaneLLS<PointSource, PointTarget, Scalar>::
+estimateRigidTransformation (ConstCloudIterator<PointSource>& source_it, ConstCloudIterator<PointTarget>& target_it, Matrix4 &transformation_matrix) const
+{
+  Matrix6d ATA;
+  Vector6d ATb;
+  ATA.setZero ();
+  ATb.setZero ();
+
+  // Approximate as a linear least squares problem
+  while (source_it.isValid () && target_it.isValid ())
+  {
+    accumulateNormalEquations (*source_it, *target_it, ATA, ATb);
+    ++target_it;
+    ++source_it;    
+  }
+
+  solveNormalEquations (ATA, ATb, transformation_matrix);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointSource, typename PointTarget, typename Scalar> void
+pcl::registration::TransformationEstimationPointToPlaneLLS<PointSource, PointTarget, Scalar>::
+estimateRigidTransformationParallel (const pcl::PointCloud<PointSource> &cloud_src,
+                                     const std::vector<int> &indices_src,
+                                     const pcl::PointCloud<PointTarget> &cloud_tgt,
+                                     const std::vector<int> &indices_tgt,
+                                     unsigned int nr_threads,
+                                     Matrix4 &transformation_matrix) const
+{
+  if (indices_tgt.size () != indices_src.size ())
+  {
+    PCL_ERROR ("[pcl::TransformationEstimationPointToPlaneLLS::estimateRigidTransformationParallel] Number or points in source (%zu) differs than target (%zu)!\n", indices_src.size (), indices_tgt.size ());
+    return;
+  }
+
+  // The normal equations of each block are summed separately, then added in the order of the blocks, so that the
+  // result does not depend on the number of threads
+  const int nr_points = static_cast<int> (indices_src.size ());
+  const int block_size = 1024;
+  const int nr_blocks = (nr_points + block_size - 1) / block_size;
+  std::vector<Matrix6d, Eigen::aligned_allocator<Matrix6d> > block_ATA (nr_blocks);
+  std::vector<Vector6d, Eigen::aligned_allocator<Vector6d> > block_ATb (nr_blocks);
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads (nr_threads) schedule (static)
+#endif
+  for (int block = 0; block < nr_blocks; ++block)
+  {
+    Matrix6d ATA;
+    Vector6d ATb;
+    ATA.setZero ();
+    ATb.setZero ();
+    const int end = (std::min) (nr_points, (block + 1) * block_size);
+    for (int i = block * block_size; i < end; ++i)
+      accumulateNormalEquations (cloud_src.points[indices_src[i]], cloud_tgt.points[indices_tgt[i]], ATA, ATb);
+    block_ATA[block] = ATA;
+    block_ATb[block] = ATb;
+  }
+
+  Matrix6d ATA;
+  Vector6d ATb;
+  ATA.setZero ();
+  ATb.setZero ();
+  for (int block = 0; block < nr_blocks; ++block)
+  {
+    ATA += block_ATA[block];
+    ATb += block_ATb[block];
+  }
+
+  solveNormalEquations (ATA, ATb, transformation_matrix);
+}
+
 #endif /* PCL_REGISTRATION_TRANSFORMATION_ESTIMATION_POINT_TO_PLANE_LLS_HPP_ */
@@ -174,11 +174,22 @@ pcl::registration::TransformationEstimationSVD<PointSource, PointTarget, Scalar>
     const Eigen::Matrix<Scalar, 4, 1> &centroid_tgt,
     Matrix4 &transformation_matrix) const
 {
-  transformation_matrix.setIdentity ();
-
   // Assemble the correlation matrix H = source * target'
   Eigen::Matrix<Scalar, 3, 3> H = (cloud_src_demean * cloud_tgt_demean.transpose ()).topLeftCorner (3, 3);
 
+  getTransformationFromCorrelationMatrix (H, centroid_src, centroid_tgt, transformation_matrix);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointSource, typename PointTarget, typename Scalar> void
+pcl::registration::TransformationEstimationSVD<PointSource, PointTarget, Scalar>::getTransformationFromCorrelationMatrix (
+    const Eigen::Matrix<Scalar, 3, 3> &H,
+    const Eigen::Matrix<Scalar, 4, 1> &centroid_src,
+    const Eigen::Matrix<Scalar, 4, 1> &centroid_tgt,
+    Matrix4 &transformation_matrix) const
+{
+  transformation_matrix.setIdentity ();
+
   // Compute the Singular Value Decomposition
   Eigen::JacobiSVD<Eigen::Matrix<Scalar, 3, 3> > svd (H, Eigen::ComputeFullU | Eigen::ComputeFullV);
   Eigen::Matrix<Scalar, 3, 3> u = svd.matrixU ();
@@ -199,6 +210,91 @@ pcl::registration::TransformationEstimationSVD<PointSource, PointTarget, Scalar>
   transformation_matrix.block (0, 3, 3, 1) = centroid_tgt.head (3) - Rc;
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointSource, typename PointTarget, typename Scalar> void
+pcl::registration::TransformationEstimationSVD<PointSource, PointTarget, Scalar>::estimateRigidTransformationParallel (
+    const pcl::PointCloud<PointSource> &cloud_src,
+    const std::vector<int> &indices_src,
+    const pcl::PointCloud<PointTarget> &cloud_tgt,
+    const std::vector<int> &indices_tgt,
+    unsigned int nr_threads,
+    Matrix4 &transformation_matrix) const
+{
+  if (indices_src.size () != indices_tgt.size ())
+  {
+    PCL_ERROR ("[pcl::TransformationEstimationSVD::estimateRigidTransformationParallel] Number or points in source (%zu) differs than target (%zu)!\n", indices_src.size (), indices_tgt.size ());
+    return;
+  }
+  const int nr_points = static_cast<int> (indices_src.size ());
+  if (nr_points == 0)
+  {
+    PCL_ERROR ("[pcl::TransformationEstimationSVD::estimateRigidTransformationParallel] No correspondences given!\n");
+    return;
+  }
+
+  // The sums of each block are computed separately, then added in the order of the blocks, so that the result
+  // does not depend on the number of threads
+  const int block_size = 1024;
+  const int nr_blocks = (nr_points + block_size - 1) / block_size;
+  std::vector<Eigen::Vector3d, Eigen::aligned_allocator<Eigen::Vector3d> > block_sum_src (nr_blocks), block_sum_tgt (nr_blocks);
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads (nr_threads) schedule (static)
+#endif
+  for (int block = 0; block < nr_blocks; ++block)
+  {
+    Eigen::Vector3d sum_src (Eigen::Vector3d::Zero ()), sum_tgt (Eigen::Vector3d::Zero ());
+    const int end = (std::min) (nr_points, (block + 1) * block_size);
+    for (int i = block * block_size; i < end; ++i)
+    {
+      const PointSource &p_src = cloud_src.points[indices_src[i]];
+      const PointTarget &p_tgt = cloud_tgt.points[indices_tgt[i]];
+      sum_src += Eigen::Vector3d (p_src.x, p_src.y, p_src.z);
+      sum_tgt += Eigen::Vector3d (p_tgt.x, p_tgt.y, p_tgt.z);
+    }
+    block_sum_src[block] = sum_src;
+    block_sum_tgt[block] = sum_tgt;
+  }
+
+  Eigen::Vector3d mean_src (Eigen::Vector3d::Zero ()), mean_tgt (Eigen::Vector3d::Zero ());
+  for (int block = 0; block < nr_blocks; ++block)
+  {
+    mean_src += block_sum_src[block];
+    mean_tgt += block_sum_tgt[block];
+  }
+  mean_src /= nr_points;
+  mean_tgt /= nr_points;
+
+  // Assemble the correlation matrix H = source * target' of the demeaned points
+  std::vector<Eigen::Matrix3d, Eigen::aligned_allocator<Eigen::Matrix3d> > block_H (nr_blocks);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads (nr_threads) schedule (static)
+#endif
+  for (int block = 0; block < nr_blocks; ++block)
+  {
+    Eigen::Matrix3d H (Eigen::Matrix3d::Zero ());
+    const int end = (std::min) (nr_points, (block + 1) * block_size);
+    for (int i = block * block_size; i < end; ++i)
+    {
+      const PointSource &p_src = cloud_src.points[indices_src[i]];
+      const PointTarget &p_tgt = cloud_tgt.points[indices_tgt[i]];
+      const Eigen::Vector3d d_src (Eigen::Vector3d (p_src.x, p_src.y, p_src.z) - mean_src);
+      const Eigen::Vector3d d_tgt (Eigen::Vector3d (p_tgt.x, p_tgt.y, p_tgt.z) - mean_tgt);
+      H.noalias () += d_src * d_tgt.transpose ();
+    }
+    block_H[block] = H;
+  }
+
+  Eigen::Matrix3d H (Eigen::Matrix3d::Zero ());
+  for (int block = 0; block < nr_blocks; ++block)
+    H += block_H[block];
+
+  Eigen::Matrix<Scalar, 4, 1> centroid_src, centroid_tgt;
+  centroid_src << mean_src.cast<Scalar> (), 1;
+  centroid_tgt << mean_tgt.cast<Scalar> (), 1;
+  getTransformationFromCorrelationMatrix (H.cast<Scalar> (), centroid_src, centroid_tgt, transformation_matrix);
+}
+
 //#define PCL_INSTANTIATE_TransformationEstimationSVD(T,U) template class PCL_EXPORTS pcl::registration::TransformationEstimationSVD<T,U>;
 
 #endif /* PCL_REGISTRATION_TRANSFORMATION_ESTIMATION_SVD_HPP_ */
\ No newline at end of file
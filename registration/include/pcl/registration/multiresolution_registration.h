@@ -0,0 +1,258 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_REGISTRATION_MULTIRESOLUTION_REGISTRATION_H_
+#define PCL_REGISTRATION_MULTIRESOLUTION_REGISTRATION_H_
+
+#include <pcl/registration/registration.h>
+#include <pcl/filters/voxel_grid.h>
+
+namespace pcl
+{
+  namespace registration
+  {
+    /** \brief @b MultiresolutionRegistration aligns a source to a target point cloud coarse-to-fine. The source
+      * and the target are downsampled with a VoxelGrid filter into a pyramid of levels, and a registration method
+      * (e.g., IterativeClosestPoint, IterativeClosestPointNonLinear or GeneralizedIterativeClosestPoint) is run on
+      * each level, from the coarsest to the finest, starting from the transformation found on the coarser levels.
+      *
+      * Each level has its own leaf size and convergence criteria. A leaf size of 0 uses the clouds at full
+      * resolution. The downsampled targets and their kd-trees are kept until the target or the levels change, so
+      * aligning several sources to the same target builds them only once. If no level is added, the registration
+      * method runs once at full resolution with the maximum number of iterations, correspondence distance and
+      * epsilons set on this object.
+      *
+      * Usage example:
+      * \code
+      * MultiresolutionRegistration<PointXYZ, PointXYZ> reg;
+      * reg.setRegistration (Registration<PointXYZ, PointXYZ>::Ptr (new IterativeClosestPoint<PointXYZ, PointXYZ>));
+      * reg.setInputCloud (cloud_source);
+      * reg.setInputTarget (cloud_target);
+      * // 4cm, 2cm and full resolution levels
+      * reg.addLevel (0.04f, 20, 0.2);
+      * reg.addLevel (0.02f, 20, 0.1);
+      * reg.addLevel (0.0f, 50, 0.05, 1e-8);
+      * reg.align (cloud_source_registered);
+      * Eigen::Matrix4f transformation = reg.getFinalTransformation ();
+      * \endcode
+      *
+      * \ingroup registration
+      */
+    template <typename PointSource, typename PointTarget>
+    class MultiresolutionRegistration : public Registration<PointSource, PointTarget>
+    {
+      public:
+        typedef boost::shared_ptr<MultiresolutionRegistration<PointSource, PointTarget> > Ptr;
+        typedef boost::shared_ptr<const MultiresolutionRegistration<PointSource, PointTarget> > ConstPtr;
+
+        typedef typename Registration<PointSource, PointTarget>::Ptr RegistrationPtr;
+        typedef typename Registration<PointSource, PointTarget>::KdTreePtr KdTreePtr;
+
+        typedef typename Registration<PointSource, PointTarget>::PointCloudSource PointCloudSource;
+        typedef typename PointCloudSource::Ptr PointCloudSourcePtr;
+        typedef typename PointCloudSource::ConstPtr PointCloudSourceConstPtr;
+
+        typedef typename Registration<PointSource, PointTarget>::PointCloudTarget PointCloudTarget;
+        typedef typename PointCloudTarget::Ptr PointCloudTargetPtr;
+        typedef typename PointCloudTarget::ConstPtr PointCloudTargetConstPtr;
+
+        /** \brief The resolution and the convergence criteria of a level of the pyramid. */
+        struct Level
+        {
+          /** \brief The leaf size of the VoxelGrid filter, 0 for the full resolution. */
+          float leaf_size;
+          /** \brief The maximum number of iterations of the registration method. */
+          int max_iterations;
+          /** \brief The maximum distance between two correspondent points. */
+          double max_correspondence_distance;
+          /** \brief The transformation epsilon of the registration method. */
+          double transformation_epsilon;
+          /** \brief The Euclidean fitness epsilon of the registration method. */
+          double euclidean_fitness_epsilon;
+        };
+
+        /** \brief Empty constructor. */
+        MultiresolutionRegistration ()
+          : registration_ ()
+          , levels_ ()
+          , target_levels_ ()
+          , target_trees_ ()
+          , target_tree_built_ (false)
+          , levels_converged_ ()
+        {
+          reg_name_ = "MultiresolutionRegistration";
+        }
+
+        /** \brief Provide a pointer to the registration method run on each level. Its input, target, search object
+          * and convergence criteria are set by align; as it shares the cached kd-trees of the levels, it should not
+          * be given another target on its own.
+          * \param[in] registration the registration method, e.g. an IterativeClosestPoint object
+          */
+        inline void
+        setRegistration (const RegistrationPtr &registration) { registration_ = registration; }
+
+        /** \brief Get a pointer to the registration method run on each level. */
+        inline RegistrationPtr
+        getRegistration () const { return (registration_); }
+
+        /** \brief Add a level to the pyramid. The levels are processed in the order they are added, so the coarsest
+          * level has to be added first.
+          * \param[in] leaf_size the leaf size of the VoxelGrid filter, 0 for the full resolution
+          * \param[in] max_iterations the maximum number of iterations of the registration method
+          * \param[in] max_correspondence_distance the maximum distance between two correspondent points
+          * \param[in] transformation_epsilon the transformation epsilon of the registration method (default: 0)
+          * \param[in] euclidean_fitness_epsilon the Euclidean fitness epsilon of the registration method
+          * (default: -double::max)
+          */
+        inline void
+        addLevel (float leaf_size, int max_iterations, double max_correspondence_distance,
+                  double transformation_epsilon = 0.0,
+                  double euclidean_fitness_epsilon = -std::numeric_limits<double>::max ())
+        {
+          Level level;
+          level.leaf_size = leaf_size;
+          level.max_iterations = max_iterations;
+          level.max_correspondence_distance = max_correspondence_distance;
+          level.transformation_epsilon = transformation_epsilon;
+          level.euclidean_fitness_epsilon = euclidean_fitness_epsilon;
+          levels_.push_back (level);
+          target_levels_.clear ();
+          target_trees_.clear ();
+        }
+
+        /** \brief Remove all the levels of the pyramid. */
+        inline void
+        clearLevels ()
+        {
+          levels_.clear ();
+          target_levels_.clear ();
+          target_trees_.clear ();
+        }
+
+        /** \brief Get the levels of the pyramid. */
+        inline const std::vector<Level>&
+        getLevels () const { return (levels_); }
+
+        /** \brief Get, for each level, whether the registration method converged on it during the last align. */
+        inline const std::vector<bool>&
+        getLevelsConverged () const { return (levels_converged_); }
+
+        /** \brief Provide a pointer to the input target. The downsampled targets are rebuilt on the next align,
+          * and the kd-tree of the full resolution target is only built if a level or the fitness score needs it.
+          * \param[in] cloud the input point cloud target
+          */
+        inline void
+        setInputTarget (const PointCloudTargetConstPtr &cloud)
+        {
+          this->setSearchMethodTarget (tree_, true);
+          Registration<PointSource, PointTarget>::setInputTarget (cloud);
+          target_levels_.clear ();
+          target_trees_.clear ();
+          target_tree_built_ = false;
+        }
+
+        /** \brief Obtain the Euclidean fitness score (e.g., sum of squared distances from the source to the target)
+          * \param[in] max_range maximum allowable distance between a point and its correspondence in the target
+          * (default: double::max)
+          */
+        inline double
+        getFitnessScore (double max_range = std::numeric_limits<double>::max ())
+        {
+          buildTargetTree ();
+          return (Registration<PointSource, PointTarget>::getFitnessScore (max_range));
+        }
+        using Registration<PointSource, PointTarget>::getFitnessScore;
+
+      protected:
+        using Registration<PointSource, PointTarget>::reg_name_;
+        using Registration<PointSource, PointTarget>::getClassName;
+        using Registration<PointSource, PointTarget>::target_;
+        using Registration<PointSource, PointTarget>::tree_;
+        using Registration<PointSource, PointTarget>::max_iterations_;
+        using Registration<PointSource, PointTarget>::final_transformation_;
+        using Registration<PointSource, PointTarget>::transformation_epsilon_;
+        using Registration<PointSource, PointTarget>::euclidean_fitness_epsilon_;
+        using Registration<PointSource, PointTarget>::corr_dist_threshold_;
+        using Registration<PointSource, PointTarget>::converged_;
+
+        /** \brief Run the registration method on each level, coarse-to-fine.
+          * \param output the transformed input point cloud dataset using the rigid transformation found
+          * \param guess the initial guess of the transformation to compute
+          */
+        virtual void
+        computeTransformation (PointCloudSource &output, const Eigen::Matrix4f &guess);
+
+        /** \brief Downsample the target and build the kd-tree of each level.
+          * \param[in] levels the levels of the pyramid
+          */
+        void
+        buildTargetLevels (const std::vector<Level> &levels);
+
+        /** \brief Build the kd-tree of the full resolution target, unless it is already built. */
+        inline void
+        buildTargetTree ()
+        {
+          if (target_tree_built_ || !target_)
+            return;
+          tree_->setInputCloud (target_);
+          target_tree_built_ = true;
+        }
+
+        /** \brief The registration method run on each level. */
+        RegistrationPtr registration_;
+
+        /** \brief The levels of the pyramid, from the coarsest to the finest. */
+        std::vector<Level> levels_;
+
+        /** \brief The downsampled target of each level. */
+        std::vector<PointCloudTargetConstPtr> target_levels_;
+
+        /** \brief The kd-tree built on the downsampled target of each level. */
+        std::vector<KdTreePtr> target_trees_;
+
+        /** \brief True once the kd-tree of this object is built on the full resolution target. */
+        bool target_tree_built_;
+
+        /** \brief Whether the registration method converged on each level during the last align. */
+        std::vector<bool> levels_converged_;
+    };
+  }
+}
+
+#include <pcl/registration/impl/multiresolution_registration.hpp>
+
+#endif  // PCL_REGISTRATION_MULTIRESOLUTION_REGISTRATION_H_
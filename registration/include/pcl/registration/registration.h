@@ -87,6 +87,7 @@ namespace pcl
       /** \brief Empty constructor. */
       Registration () : reg_name_ (),
                         tree_ (new pcl::KdTreeFLANN<PointTarget>),
+                        force_no_recompute_ (false),
                         nr_iterations_(0),
                         max_iterations_(10),
                         ransac_iterations_ (0),
@@ -122,6 +123,25 @@ namespace pcl
       virtual inline void 
       setInputTarget (const PointCloudTargetConstPtr &cloud);
 
+      /** \brief Provide a pointer to the search object used to find the correspondences in the target.
+        * \param[in] tree a pointer to the spatial search object
+        * \param[in] force_no_recompute if true, the search object is assumed to be already built on the target
+        * given by the next call to setInputTarget, which then does not rebuild it. This lets several registrations
+        * share the search object of a target. If false (default), the search object is built on the current target.
+        */
+      inline void
+      setSearchMethodTarget (const KdTreePtr &tree, bool force_no_recompute = false)
+      {
+        tree_ = tree;
+        force_no_recompute_ = force_no_recompute;
+        if (!force_no_recompute && target_)
+          tree_->setInputCloud (target_);
+      }
+
+      /** \brief Get a pointer to the search object used to find the correspondences in the target. */
+      inline KdTreePtr
+      getSearchMethodTarget () const { return (tree_); }
+
       /** \brief Get a pointer to the input point cloud dataset target. */
       inline PointCloudTargetConstPtr const 
       getInputTarget () { return (target_ ); }
@@ -284,6 +304,9 @@ namespace pcl
       /** \brief A pointer to the spatial search object. */
       KdTreePtr tree_;
 
+      /** \brief True if the search object is already built on the next target given (see setSearchMethodTarget). */
+      bool force_no_recompute_;
+
       /** \brief The number of iterations the internal optimization ran for (used internally). */
       int nr_iterations_;
 
@@ -120,6 +120,29 @@ namespace pcl
             const pcl::Correspondences &correspondences,
             Matrix4 &transformation_matrix) const = 0;
 
+        /** \brief Estimate a rigid rotation transformation between a source and a target point cloud, summing the
+          * contributions of the correspondences in parallel. The sums are done on fixed blocks of correspondences,
+          * so the result does not depend on the number of threads, but it may differ in the last bits from the one
+          * of estimateRigidTransformation. The default implementation calls estimateRigidTransformation.
+          * \param[in] cloud_src the source point cloud dataset
+          * \param[in] indices_src the vector of indices describing the points of interest in \a cloud_src
+          * \param[in] cloud_tgt the target point cloud dataset
+          * \param[in] indices_tgt the vector of indices describing the correspondences of the interst points from \a indices_src
+          * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+          * \param[out] transformation_matrix the resultant transformation matrix
+          */
+        virtual void
+        estimateRigidTransformationParallel (
+            const pcl::PointCloud<PointSource> &cloud_src,
+            const std::vector<int> &indices_src,
+            const pcl::PointCloud<PointTarget> &cloud_tgt,
+            const std::vector<int> &indices_tgt,
+            unsigned int,
+            Matrix4 &transformation_matrix) const
+        {
+          estimateRigidTransformation (cloud_src, indices_src, cloud_tgt, indices_tgt, transformation_matrix);
+        }
+
 
         typedef boost::shared_ptr<TransformationEstimation<PointSource, PointTarget, Scalar> > Ptr;
         typedef boost::shared_ptr<const TransformationEstimation<PointSource, PointTarget, Scalar> > ConstPtr;
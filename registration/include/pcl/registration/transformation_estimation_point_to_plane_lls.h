@@ -122,7 +122,27 @@ namespace pcl
             const pcl::Correspondences &correspondences,
             Matrix4 &transformation_matrix) const;
 
+        /** \brief Estimate a rigid rotation transformation between a source and a target point cloud, assembling
+          * the normal equations of the correspondences in parallel, on fixed blocks of correspondences.
+          * \param[in] cloud_src the source point cloud dataset
+          * \param[in] indices_src the vector of indices describing the points of interest in \a cloud_src
+          * \param[in] cloud_tgt the target point cloud dataset
+          * \param[in] indices_tgt the vector of indices describing the correspondences of the interst points from \a indices_src
+          * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+          * \param[out] transformation_matrix the resultant transformation matrix
+          */
+        void
+        estimateRigidTransformationParallel (
+            const pcl::PointCloud<PointSource> &cloud_src,
+            const std::vector<int> &indices_src,
+            const pcl::PointCloud<PointTarget> &cloud_tgt,
+            const std::vector<int> &indices_tgt,
+            unsigned int nr_threads,
+            Matrix4 &transformation_matrix) const;
+
       protected:
+        typedef Eigen::Matrix<double, 6, 1> Vector6d;
+        typedef Eigen::Matrix<double, 6, 6> Matrix6d;
         
         /** \brief Estimate a rigid rotation transformation between a source and a target
           * \param[in] source_it an iterator over the source point cloud dataset
@@ -148,6 +168,25 @@ namespace pcl
                                        const double & tx,    const double & ty,   const double & tz,
                                        Matrix4 &transformation_matrix) const;
 
+        /** \brief Add the contribution of a correspondence to the upper triangle of the normal equations. The
+          * correspondences with a non finite point or normal are skipped.
+          * \param[in] p_src the source point
+          * \param[in] p_tgt the target point, with its normal
+          * \param[in,out] ATA the upper triangle of the matrix of the normal equations
+          * \param[in,out] ATb the right hand side of the normal equations
+          */
+        inline void
+        accumulateNormalEquations (const PointSource &p_src, const PointTarget &p_tgt,
+                                   Matrix6d &ATA, Vector6d &ATb) const;
+
+        /** \brief Solve the normal equations, and construct the transformation matrix from their solution.
+          * \param[in,out] ATA the matrix of the normal equations, only the upper triangle has to be set
+          * \param[in] ATb the right hand side of the normal equations
+          * \param[out] transformation_matrix the resultant transformation matrix
+          */
+        inline void
+        solveNormalEquations (Matrix6d &ATA, const Vector6d &ATb, Matrix4 &transformation_matrix) const;
+
     };
   }
 }
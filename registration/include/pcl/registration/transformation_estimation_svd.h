@@ -123,6 +123,24 @@ namespace pcl
             const pcl::Correspondences &correspondences,
             Matrix4 &transformation_matrix) const;
 
+        /** \brief Estimate a rigid rotation transformation between a source and a target point cloud using SVD,
+          * computing the centroids and the correlation matrix in parallel, on fixed blocks of correspondences.
+          * \param[in] cloud_src the source point cloud dataset
+          * \param[in] indices_src the vector of indices describing the points of interest in \a cloud_src
+          * \param[in] cloud_tgt the target point cloud dataset
+          * \param[in] indices_tgt the vector of indices describing the correspondences of the interst points from \a indices_src
+          * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+          * \param[out] transformation_matrix the resultant transformation matrix
+          */
+        void
+        estimateRigidTransformationParallel (
+            const pcl::PointCloud<PointSource> &cloud_src,
+            const std::vector<int> &indices_src,
+            const pcl::PointCloud<PointTarget> &cloud_tgt,
+            const std::vector<int> &indices_tgt,
+            unsigned int nr_threads,
+            Matrix4 &transformation_matrix) const;
+
       protected:
 
         /** \brief Estimate a rigid rotation transformation between a source and a target
@@ -150,6 +168,19 @@ namespace pcl
             const Eigen::Matrix<Scalar, 4, 1> &centroid_tgt,
             Matrix4 &transformation_matrix) const;
 
+        /** \brief Obtain a 4x4 rigid transformation matrix from an assembled correlation matrix H = src * tgt'
+          * \param[in] H the 3x3 correlation matrix of the demeaned source and target clouds
+          * \param[in] centroid_src the input source centroid, in Eigen format
+          * \param[in] centroid_tgt the input target cloud, in Eigen format
+          * \param[out] transformation_matrix the resultant 4x4 rigid transformation matrix
+          */
+        void
+        getTransformationFromCorrelationMatrix (
+            const Eigen::Matrix<Scalar, 3, 3> &H,
+            const Eigen::Matrix<Scalar, 4, 1> &centroid_src,
+            const Eigen::Matrix<Scalar, 4, 1> &centroid_tgt,
+            Matrix4 &transformation_matrix) const;
+
         bool use_umeyama_;
      };
 
@@ -68,6 +68,26 @@ namespace pcl
           TransformationEstimationSVD<PointSource, PointTarget, Scalar> (false)
       {}
 
+        /** \brief The scale is estimated from the demeaned clouds, so the correspondences are not summed in
+          * parallel: this calls estimateRigidTransformation.
+          * \param[in] cloud_src the source point cloud dataset
+          * \param[in] indices_src the vector of indices describing the points of interest in \a cloud_src
+          * \param[in] cloud_tgt the target point cloud dataset
+          * \param[in] indices_tgt the vector of indices describing the correspondences of the interst points from \a indices_src
+          * \param[out] transformation_matrix the resultant transformation matrix
+          */
+        void
+        estimateRigidTransformationParallel (
+            const pcl::PointCloud<PointSource> &cloud_src,
+            const std::vector<int> &indices_src,
+            const pcl::PointCloud<PointTarget> &cloud_tgt,
+            const std::vector<int> &indices_tgt,
+            unsigned int,
+            Matrix4 &transformation_matrix) const
+        {
+          this->estimateRigidTransformation (cloud_src, indices_src, cloud_tgt, indices_tgt, transformation_matrix);
+        }
+
       protected:
         /** \brief Obtain a 4x4 rigid transformation matrix from a correlation matrix H = src * tgt'
           * \param[in] cloud_src_demean the input source cloud, demeaned, in Eigen format
@@ -0,0 +1,185 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_SAMPLE_CONSENSUS_DISTANCE_KERNELS_H_
+#define PCL_SAMPLE_CONSENSUS_DISTANCE_KERNELS_H_
+
+#include <pcl/pcl_macros.h>
+#include <pcl/point_cloud.h>
+#include <vector>
+
+namespace pcl
+{
+  namespace sample_consensus
+  {
+    /** \brief Instruction sets the distance kernels can run with. */
+    enum SimdLevel
+    {
+      SIMD_NONE = 0,
+      SIMD_SSE2 = 1,
+      SIMD_AVX = 2
+    };
+
+    /** \brief Number of points processed by one call of a distance kernel. */
+    const int DISTANCE_BLOCK_SIZE = 256;
+
+    /** \brief @b DistanceBlock holds the coordinates (and normals) of up to DISTANCE_BLOCK_SIZE points
+      * in separate arrays (structure of arrays), so that the distance kernels can process several points
+      * per instruction.
+      * \ingroup sample_consensus
+      */
+    struct DistanceBlock
+    {
+      float x[DISTANCE_BLOCK_SIZE];
+      float y[DISTANCE_BLOCK_SIZE];
+      float z[DISTANCE_BLOCK_SIZE];
+      float nx[DISTANCE_BLOCK_SIZE];
+      float ny[DISTANCE_BLOCK_SIZE];
+      float nz[DISTANCE_BLOCK_SIZE];
+      /** \brief Number of valid points in the block. */
+      int size;
+    };
+
+    /** \brief Gather the XYZ coordinates of the next DISTANCE_BLOCK_SIZE points (or less, at the end of indices)
+      * into a block, and set the size of the block.
+      * \param[in] cloud the input point cloud
+      * \param[in] indices the indices of the points to gather
+      * \param[in] begin the position of the first point of the block in indices
+      * \param[out] block the block to fill
+      */
+    template <typename PointT> inline void
+    gatherXYZ (const pcl::PointCloud<PointT> &cloud, const std::vector<int> &indices, const size_t begin, DistanceBlock &block)
+    {
+      block.size = indices.size () - begin < static_cast<size_t> (DISTANCE_BLOCK_SIZE) ?
+                   static_cast<int> (indices.size () - begin) : DISTANCE_BLOCK_SIZE;
+      for (int j = 0; j < block.size; ++j)
+      {
+        const PointT &p = cloud.points[indices[begin + j]];
+        block.x[j] = p.x;
+        block.y[j] = p.y;
+        block.z[j] = p.z;
+      }
+    }
+
+    /** \brief Gather the normals of the points of a block, after gatherXYZ.
+      * \param[in] normals the input point cloud containing the normals
+      * \param[in] indices the indices of the points to gather
+      * \param[in] begin the position of the first point of the block in indices
+      * \param[in,out] block the block to fill, its size is set by gatherXYZ
+      */
+    template <typename PointNT> inline void
+    gatherNormals (const pcl::PointCloud<PointNT> &normals, const std::vector<int> &indices, const size_t begin, DistanceBlock &block)
+    {
+      for (int j = 0; j < block.size; ++j)
+      {
+        const PointNT &n = normals.points[indices[begin + j]];
+        block.nx[j] = n.normal[0];
+        block.ny[j] = n.normal[1];
+        block.nz[j] = n.normal[2];
+      }
+    }
+
+    /** \brief Compute the distances |a*x + b*y + c*z + d| of the points of a block to a plane.
+      * \param[in] block the points
+      * \param[in] coefficients the plane coefficients (a, b, c, d)
+      * \param[out] distances the distances, block.size values
+      */
+    PCL_EXPORTS void
+    planeDistances (const DistanceBlock &block, const float coefficients[4], float *distances);
+
+    /** \brief Compute the distances of the points of a block to a sphere.
+      * \param[in] block the points
+      * \param[in] center the center of the sphere
+      * \param[in] radius the radius of the sphere
+      * \param[out] distances the distances, block.size values
+      */
+    PCL_EXPORTS void
+    sphereDistances (const DistanceBlock &block, const float center[3], const float radius, float *distances);
+
+    /** \brief Compute the squared distances of the points of a block to a line.
+      * \param[in] block the points
+      * \param[in] line_pt a point of the line
+      * \param[in] line_dir the direction of the line, normalized
+      * \param[out] sqr_distances the squared distances, block.size values
+      */
+    PCL_EXPORTS void
+    lineSqrDistances (const DistanceBlock &block, const float line_pt[3], const float line_dir[3], float *sqr_distances);
+
+    /** \brief Compute the weighted distances of the points (with normals) of a block to a plane, as done by
+      * SampleConsensusModelNormalPlane: |w * d_normal + (1 - w) * d_euclid|, where d_normal is the angle
+      * between the point normal and the plane normal, folded to [0, pi/2].
+      * \param[in] block the points and their normals
+      * \param[in] coefficients the plane coefficients (a, b, c, d)
+      * \param[in] normal_distance_weight the weight w of the angular distance
+      * \param[out] distances the distances, block.size values
+      */
+    PCL_EXPORTS void
+    normalPlaneDistances (const DistanceBlock &block, const float coefficients[4], const float normal_distance_weight, float *distances);
+
+    /** \brief Compute the weighted distances of the points (with normals) of a block to a cylinder, as done by
+      * SampleConsensusModelCylinder: |w * d_normal + (1 - w) * d_euclid|, where d_euclid is the difference between
+      * the distance to the axis and the radius, and d_normal is the angle between the point normal and the
+      * direction from the axis to the point, folded to [0, pi/2].
+      * \param[in] block the points and their normals
+      * \param[in] line_pt a point of the cylinder axis
+      * \param[in] line_dir the direction of the cylinder axis, normalized
+      * \param[in] radius the radius of the cylinder
+      * \param[in] normal_distance_weight the weight w of the angular distance
+      * \param[out] distances the distances, block.size values
+      */
+    PCL_EXPORTS void
+    cylinderDistances (const DistanceBlock &block, const float line_pt[3], const float line_dir[3], const float radius,
+                       const float normal_distance_weight, float *distances);
+
+    /** \brief Returns the instruction set used by the distance kernels. By default, the best one supported
+      * by both the build and the CPU, detected at load time.
+      */
+    PCL_EXPORTS SimdLevel
+    getSimdLevel ();
+
+    /** \brief Select the instruction set used by the distance kernels, for benchmarking or testing. The level
+      * is lowered to the best one available if the build or the CPU do not support it.
+      * \note This is a global setting, it must not be changed while the kernels are in use.
+      * \param[in] level the requested instruction set
+      * \return the instruction set actually selected
+      */
+    PCL_EXPORTS SimdLevel
+    setSimdLevel (const SimdLevel level);
+  }
+}
+
+#endif  //#ifndef PCL_SAMPLE_CONSENSUS_DISTANCE_KERNELS_H_
@@ -0,0 +1,183 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_SAMPLE_CONSENSUS_IMPL_PARALLEL_RANSAC_H_
+#define PCL_SAMPLE_CONSENSUS_IMPL_PARALLEL_RANSAC_H_
+
+#include <pcl/sample_consensus/parallel_ransac.h>
+
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> bool
+pcl::ParallelRandomSampleConsensus<PointT>::computeModel (int debug_verbosity_level)
+{
+  // Warn and exit if no threshold was set
+  if (threshold_ == std::numeric_limits<double>::max())
+  {
+    PCL_ERROR ("[pcl::ParallelRandomSampleConsensus::computeModel] No threshold set!\n");
+    return (false);
+  }
+
+  iterations_ = 0;
+  model_.clear ();
+  int n_best_inliers_count = -INT_MAX;
+  double k = 1.0;
+
+  const boost::shared_ptr<std::vector<int> > indices = sac_model_->getIndices ();
+  const int nr_indices = static_cast<int> (indices->size ());
+  const int nr_pretest = (std::min) (nr_pretest_, nr_indices);
+
+  std::vector<std::vector<int> > selections (batch_size_);
+  std::vector<Eigen::VectorXf> coefficients (batch_size_);
+  std::vector<unsigned int> seeds (batch_size_);
+  std::vector<char> valid (batch_size_);
+  std::vector<int> inliers_count (batch_size_);
+
+  unsigned skipped_count = 0;
+  // supress infinite loops by just allowing 10 x maximum allowed iterations for invalid model parameters!
+  const unsigned max_skip = max_iterations_ * 10;
+  bool no_samples = false;
+
+  // Iterate, one batch of hypotheses at a time
+  while ((model_.empty () || iterations_ < k) && iterations_ <= max_iterations_ && skipped_count < max_skip && !no_samples)
+  {
+    // Once a model is found, don't draw more hypotheses than needed
+    int nr_hypotheses = batch_size_;
+    if (!model_.empty ())
+      nr_hypotheses = static_cast<int> ((std::min) (static_cast<double> (batch_size_), ceil (k) - iterations_));
+    nr_hypotheses = (std::max) (1, (std::min) (nr_hypotheses, max_iterations_ + 1 - iterations_));
+
+    // Draw the samples sequentially, the random generator of the model is not thread safe
+    for (int h = 0; h < nr_hypotheses; ++h)
+    {
+      int sample_iterations = iterations_;
+      sac_model_->getSamples (sample_iterations, selections[h]);
+      if (selections[h].empty ())
+      {
+        PCL_ERROR ("[pcl::ParallelRandomSampleConsensus::computeModel] No samples could be selected!\n");
+        nr_hypotheses = h;
+        no_samples = true;
+        break;
+      }
+      // Seed of the pre-test points of the hypothesis
+      seeds[h] = static_cast<unsigned int> (rng_->base () ());
+    }
+
+    // A hypothesis has to beat the previous batches, and at least tie with the best one of this batch
+    int min_inliers = n_best_inliers_count + 1;
+
+#pragma omp parallel for schedule (dynamic, 1) num_threads (threads_)
+    for (int h = 0; h < nr_hypotheses; ++h)
+    {
+      inliers_count[h] = -INT_MAX;
+      valid[h] = sac_model_->computeModelCoefficients (selections[h], coefficients[h]);
+      if (!valid[h])
+        continue;
+
+      // T(d,d) test: the hypothesis has to fit a few random points before its inliers are counted
+      if (nr_pretest > 0)
+      {
+        boost::minstd_rand pretest_rng (seeds[h]);
+        std::set<int> pretest;
+        for (int i = 0; i < nr_pretest; ++i)
+          pretest.insert ((*indices)[pretest_rng () % nr_indices]);
+        if (!sac_model_->doSamplesVerifyModel (pretest, coefficients[h], threshold_))
+          continue;
+      }
+
+      int hypothesis_min_inliers;
+#pragma omp critical (parallel_ransac_min_inliers)
+      hypothesis_min_inliers = min_inliers;
+
+      // Stop counting as soon as the hypothesis can not reach hypothesis_min_inliers
+      const int n_inliers_count = sac_model_->countWithinDistancePreemptive (coefficients[h], threshold_, hypothesis_min_inliers);
+      if (n_inliers_count < hypothesis_min_inliers)
+        continue;
+
+      inliers_count[h] = n_inliers_count;
+#pragma omp critical (parallel_ransac_min_inliers)
+      min_inliers = (std::max) (min_inliers, n_inliers_count);
+    }
+
+    // Keep the best hypothesis in the order they were drawn
+    for (int h = 0; h < nr_hypotheses; ++h)
+    {
+      if (!valid[h])
+      {
+        ++skipped_count;
+        continue;
+      }
+      ++iterations_;
+
+      // Better match ?
+      if (inliers_count[h] > n_best_inliers_count)
+      {
+        n_best_inliers_count = inliers_count[h];
+
+        // Save the current model/inlier/coefficients selection as being the best so far
+        model_              = selections[h];
+        model_coefficients_ = coefficients[h];
+
+        // Compute the k parameter (k=log(z)/log(1-w^n)), the pre-test points being part of the sample
+        double w = static_cast<double> (n_best_inliers_count) / static_cast<double> (nr_indices);
+        double p_no_outliers = 1.0 - pow (w, static_cast<double> (model_.size () + nr_pretest));
+        p_no_outliers = (std::max) (std::numeric_limits<double>::epsilon (), p_no_outliers);       // Avoid division by -Inf
+        p_no_outliers = (std::min) (1.0 - std::numeric_limits<double>::epsilon (), p_no_outliers);   // Avoid division by 0.
+        k = log (1.0 - probability_) / log (p_no_outliers);
+      }
+    }
+
+    if (debug_verbosity_level > 1)
+      PCL_DEBUG ("[pcl::ParallelRandomSampleConsensus::computeModel] Trial %d out of %f: best is %d inliers so far.\n", iterations_, k, n_best_inliers_count);
+  }
+
+  if (debug_verbosity_level > 0)
+    PCL_DEBUG ("[pcl::ParallelRandomSampleConsensus::computeModel] Model: %zu size, %d inliers.\n", model_.size (), n_best_inliers_count);
+
+  if (model_.empty ())
+  {
+    inliers_.clear ();
+    return (false);
+  }
+
+  // Get the set of inliers that correspond to the best model found so far
+  sac_model_->selectWithinDistance (model_coefficients_, threshold_, inliers_);
+  return (true);
+}
+
+#define PCL_INSTANTIATE_ParallelRandomSampleConsensus(T) template class PCL_EXPORTS pcl::ParallelRandomSampleConsensus<T>;
+
+#endif    // PCL_SAMPLE_CONSENSUS_IMPL_PARALLEL_RANSAC_H_
@@ -40,6 +40,7 @@
 
 #include <pcl/sample_consensus/eigen.h>
 #include <pcl/sample_consensus/sac_model_cylinder.h>
+#include <pcl/sample_consensus/distance_kernels.h>
 #include <pcl/common/concatenate.h>
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -130,32 +131,23 @@ pcl::SampleConsensusModelCylinder<PointT, PointNT>::getDistancesToModel (
 
   distances.resize (indices_->size ());
 
-  Eigen::Vector4f line_pt  (model_coefficients[0], model_coefficients[1], model_coefficients[2], 0);
   Eigen::Vector4f line_dir (model_coefficients[3], model_coefficients[4], model_coefficients[5], 0);
-  float ptdotdir = line_pt.dot (line_dir);
-  float dirdotdir = 1.0f / line_dir.dot (line_dir);
-  // Iterate through the 3d points and calculate the distances from them to the sphere
-  for (size_t i = 0; i < indices_->size (); ++i)
+  line_dir.normalize ();
+  const float line_pt[3] = { model_coefficients[0], model_coefficients[1], model_coefficients[2] };
+  const float line_dir3[3] = { line_dir[0], line_dir[1], line_dir[2] };
+  const float weight = static_cast<float> (normal_distance_weight_);
+  sample_consensus::DistanceBlock block;
+  float block_distances[sample_consensus::DISTANCE_BLOCK_SIZE];
+
+  // Calculate the distances from the 3d points to the cylinder by blocks of points, weighting the difference between
+  // dist(point,cylinder_axis) and the radius with the angular distance between the point normal and the (axis->point) vector
+  for (size_t begin = 0; begin < indices_->size (); begin += sample_consensus::DISTANCE_BLOCK_SIZE)
   {
-    // Aproximate the distance from the point to the cylinder as the difference between
-    // dist(point,cylinder_axis) and cylinder radius
-    // @note need to revise this.
-    Eigen::Vector4f pt (input_->points[(*indices_)[i]].x, input_->points[(*indices_)[i]].y, input_->points[(*indices_)[i]].z, 0);
-    Eigen::Vector4f n  (normals_->points[(*indices_)[i]].normal[0], normals_->points[(*indices_)[i]].normal[1], normals_->points[(*indices_)[i]].normal[2], 0);
-
-    double d_euclid = fabs (pointToLineDistance (pt, model_coefficients) - model_coefficients[6]);
-
-    // Calculate the point's projection on the cylinder axis
-    float k = (pt.dot (line_dir) - ptdotdir) * dirdotdir;
-    Eigen::Vector4f pt_proj = line_pt + k * line_dir;
-    Eigen::Vector4f dir = pt - pt_proj;
-    dir.normalize ();
-
-    // Calculate the angular distance between the point normal and the (dir=pt_proj->pt) vector
-    double d_normal = fabs (getAngle3D (n, dir));
-    d_normal = (std::min) (d_normal, M_PI - d_normal);
-
-    distances[i] = fabs (normal_distance_weight_ * d_normal + (1 - normal_distance_weight_) * d_euclid);
+    sample_consensus::gatherXYZ (*input_, *indices_, begin, block);
+    sample_consensus::gatherNormals (*normals_, *indices_, begin, block);
+    sample_consensus::cylinderDistances (block, line_pt, line_dir3, model_coefficients[6], weight, block_distances);
+    for (int j = 0; j < block.size; ++j)
+      distances[begin + j] = block_distances[j];
   }
 }
 
@@ -174,34 +166,26 @@ pcl::SampleConsensusModelCylinder<PointT, PointNT>::selectWithinDistance (
   int nr_p = 0;
   inliers.resize (indices_->size ());
 
-  Eigen::Vector4f line_pt  (model_coefficients[0], model_coefficients[1], model_coefficients[2], 0);
   Eigen::Vector4f line_dir (model_coefficients[3], model_coefficients[4], model_coefficients[5], 0);
-  float ptdotdir = line_pt.dot (line_dir);
-  float dirdotdir = 1.0f / line_dir.dot (line_dir);
-  // Iterate through the 3d points and calculate the distances from them to the sphere
-  for (size_t i = 0; i < indices_->size (); ++i)
+  line_dir.normalize ();
+  const float line_pt[3] = { model_coefficients[0], model_coefficients[1], model_coefficients[2] };
+  const float line_dir3[3] = { line_dir[0], line_dir[1], line_dir[2] };
+  const float weight = static_cast<float> (normal_distance_weight_);
+  sample_consensus::DistanceBlock block;
+  float block_distances[sample_consensus::DISTANCE_BLOCK_SIZE];
+
+  // Calculate the distances from the 3d points to the cylinder by blocks of points, weighting the difference between
+  // dist(point,cylinder_axis) and the radius with the angular distance between the point normal and the (axis->point) vector
+  for (size_t begin = 0; begin < indices_->size (); begin += sample_consensus::DISTANCE_BLOCK_SIZE)
   {
-    // Aproximate the distance from the point to the cylinder as the difference between
-    // dist(point,cylinder_axis) and cylinder radius
-    Eigen::Vector4f pt (input_->points[(*indices_)[i]].x, input_->points[(*indices_)[i]].y, input_->points[(*indices_)[i]].z, 0);
-    Eigen::Vector4f n  (normals_->points[(*indices_)[i]].normal[0], normals_->points[(*indices_)[i]].normal[1], normals_->points[(*indices_)[i]].normal[2], 0);
-    double d_euclid = fabs (pointToLineDistance (pt, model_coefficients) - model_coefficients[6]);
-
-    // Calculate the point's projection on the cylinder axis
-    float k = (pt.dot (line_dir) - ptdotdir) * dirdotdir;
-    Eigen::Vector4f pt_proj = line_pt + k * line_dir;
-    Eigen::Vector4f dir = pt - pt_proj;
-    dir.normalize ();
-
-    // Calculate the angular distance between the point normal and the (dir=pt_proj->pt) vector
-    double d_normal = fabs (getAngle3D (n, dir));
-    d_normal = (std::min) (d_normal, M_PI - d_normal);
-
-    if (fabs (normal_distance_weight_ * d_normal + (1 - normal_distance_weight_) * d_euclid) < threshold)
+    sample_consensus::gatherXYZ (*input_, *indices_, begin, block);
+    sample_consensus::gatherNormals (*normals_, *indices_, begin, block);
+    sample_consensus::cylinderDistances (block, line_pt, line_dir3, model_coefficients[6], weight, block_distances);
+    for (int j = 0; j < block.size; ++j)
     {
       // Returns the indices of the points whose distances are smaller than the threshold
-      inliers[nr_p] = (*indices_)[i];
-      nr_p++;
+      if (block_distances[j] < threshold)
+        inliers[nr_p++] = (*indices_)[begin + j];
     }
   }
   inliers.resize (nr_p);
@@ -218,31 +202,59 @@ pcl::SampleConsensusModelCylinder<PointT, PointNT>::countWithinDistance (
 
   int nr_p = 0;
 
-  Eigen::Vector4f line_pt  (model_coefficients[0], model_coefficients[1], model_coefficients[2], 0);
   Eigen::Vector4f line_dir (model_coefficients[3], model_coefficients[4], model_coefficients[5], 0);
-  float ptdotdir = line_pt.dot (line_dir);
-  float dirdotdir = 1.0f / line_dir.dot (line_dir);
-  // Iterate through the 3d points and calculate the distances from them to the sphere
-  for (size_t i = 0; i < indices_->size (); ++i)
+  line_dir.normalize ();
+  const float line_pt[3] = { model_coefficients[0], model_coefficients[1], model_coefficients[2] };
+  const float line_dir3[3] = { line_dir[0], line_dir[1], line_dir[2] };
+  const float weight = static_cast<float> (normal_distance_weight_);
+  sample_consensus::DistanceBlock block;
+  float block_distances[sample_consensus::DISTANCE_BLOCK_SIZE];
+
+  // Calculate the distances from the 3d points to the cylinder by blocks of points, weighting the difference between
+  // dist(point,cylinder_axis) and the radius with the angular distance between the point normal and the (axis->point) vector
+  for (size_t begin = 0; begin < indices_->size (); begin += sample_consensus::DISTANCE_BLOCK_SIZE)
   {
-    // Aproximate the distance from the point to the cylinder as the difference between
-    // dist(point,cylinder_axis) and cylinder radius
-    Eigen::Vector4f pt (input_->points[(*indices_)[i]].x, input_->points[(*indices_)[i]].y, input_->points[(*indices_)[i]].z, 0);
-    Eigen::Vector4f n  (normals_->points[(*indices_)[i]].normal[0], normals_->points[(*indices_)[i]].normal[1], normals_->points[(*indices_)[i]].normal[2], 0);
-    double d_euclid = fabs (pointToLineDistance (pt, model_coefficients) - model_coefficients[6]);
-
-    // Calculate the point's projection on the cylinder axis
-    float k = (pt.dot (line_dir) - ptdotdir) * dirdotdir;
-    Eigen::Vector4f pt_proj = line_pt + k * line_dir;
-    Eigen::Vector4f dir = pt - pt_proj;
-    dir.normalize ();
-
-    // Calculate the angular distance between the point normal and the (dir=pt_proj->pt) vector
-    double d_normal = fabs (getAngle3D (n, dir));
-    d_normal = (std::min) (d_normal, M_PI - d_normal);
-
-    if (fabs (normal_distance_weight_ * d_normal + (1 - normal_distance_weight_) * d_euclid) < threshold)
-      nr_p++;
+    sample_consensus::gatherXYZ (*input_, *indices_, begin, block);
+    sample_consensus::gatherNormals (*normals_, *indices_, begin, block);
+    sample_consensus::cylinderDistances (block, line_pt, line_dir3, model_coefficients[6], weight, block_distances);
+    for (int j = 0; j < block.size; ++j)
+      if (block_distances[j] < threshold)
+        nr_p++;
+  }
+  return (nr_p);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, typename PointNT> int
+pcl::SampleConsensusModelCylinder<PointT, PointNT>::countWithinDistancePreemptive (
+      const Eigen::VectorXf &model_coefficients, const double threshold, const int min_inliers)
+{
+  // Check if the model is valid given the user constraints
+  if (!isModelValid (model_coefficients))
+    return (0);
+
+  const int nr_points = static_cast<int> (indices_->size ());
+  int nr_p = 0;
+
+  Eigen::Vector4f line_dir (model_coefficients[3], model_coefficients[4], model_coefficients[5], 0);
+  line_dir.normalize ();
+  const float line_pt[3] = { model_coefficients[0], model_coefficients[1], model_coefficients[2] };
+  const float line_dir3[3] = { line_dir[0], line_dir[1], line_dir[2] };
+  const float weight = static_cast<float> (normal_distance_weight_);
+  sample_consensus::DistanceBlock block;
+  float block_distances[sample_consensus::DISTANCE_BLOCK_SIZE];
+
+  // Count the inliers by blocks of points, and stop once the remaining points can not bring the model to min_inliers
+  for (int begin = 0; begin < nr_points; begin += sample_consensus::DISTANCE_BLOCK_SIZE)
+  {
+    sample_consensus::gatherXYZ (*input_, *indices_, begin, block);
+    sample_consensus::gatherNormals (*normals_, *indices_, begin, block);
+    sample_consensus::cylinderDistances (block, line_pt, line_dir3, model_coefficients[6], weight, block_distances);
+    for (int j = 0; j < block.size; ++j)
+      if (block_distances[j] < threshold)
+        nr_p++;
+    if (nr_p + (nr_points - begin - block.size) < min_inliers)
+      break;
   }
   return (nr_p);
 }
@@ -39,6 +39,7 @@
 #define PCL_SAMPLE_CONSENSUS_IMPL_SAC_MODEL_LINE_H_
 
 #include <pcl/sample_consensus/sac_model_line.h>
+#include <pcl/sample_consensus/distance_kernels.h>
 #include <pcl/common/centroid.h>
 #include <pcl/common/concatenate.h>
 
@@ -94,17 +95,21 @@ pcl::SampleConsensusModelLine<PointT>::getDistancesToModel (
   distances.resize (indices_->size ());
 
   // Obtain the line point and direction
-  Eigen::Vector4f line_pt  (model_coefficients[0], model_coefficients[1], model_coefficients[2], 0);
   Eigen::Vector4f line_dir (model_coefficients[3], model_coefficients[4], model_coefficients[5], 0);
   line_dir.normalize ();
-
-  // Iterate through the 3d points and calculate the distances from them to the line
-  for (size_t i = 0; i < indices_->size (); ++i)
+  const float line_pt[3] = { model_coefficients[0], model_coefficients[1], model_coefficients[2] };
+  const float line_dir3[3] = { line_dir[0], line_dir[1], line_dir[2] };
+  sample_consensus::DistanceBlock block;
+  float block_distances[sample_consensus::DISTANCE_BLOCK_SIZE];
+
+  // Calculate the squared distances from the 3d points to the line by blocks of points
+  // D = ||(P2-P1) x (P1-P0)|| / ||P2-P1|| = norm (cross (p2-p1, p2-p0)) / norm(p2-p1)
+  for (size_t begin = 0; begin < indices_->size (); begin += sample_consensus::DISTANCE_BLOCK_SIZE)
   {
-    // Calculate the distance from the point to the line
-    // D = ||(P2-P1) x (P1-P0)|| / ||P2-P1|| = norm (cross (p2-p1, p2-p0)) / norm(p2-p1)
-    // Need to estimate sqrt here to keep MSAC and friends general
-    distances[i] = sqrt ((line_pt - input_->points[(*indices_)[i]].getVector4fMap ()).cross3 (line_dir).squaredNorm ());
+    sample_consensus::gatherXYZ (*input_, *indices_, begin, block);
+    sample_consensus::lineSqrDistances (block, line_pt, line_dir3, block_distances);
+    for (int j = 0; j < block.size; ++j)
+      distances[begin + j] = sqrt (block_distances[j]);
   }
 }
 
@@ -123,22 +128,24 @@ pcl::SampleConsensusModelLine<PointT>::selectWithinDistance (
   inliers.resize (indices_->size ());
 
   // Obtain the line point and direction
-  Eigen::Vector4f line_pt  (model_coefficients[0], model_coefficients[1], model_coefficients[2], 0);
   Eigen::Vector4f line_dir (model_coefficients[3], model_coefficients[4], model_coefficients[5], 0);
   line_dir.normalize ();
-
-  // Iterate through the 3d points and calculate the distances from them to the line
-  for (size_t i = 0; i < indices_->size (); ++i)
+  const float line_pt[3] = { model_coefficients[0], model_coefficients[1], model_coefficients[2] };
+  const float line_dir3[3] = { line_dir[0], line_dir[1], line_dir[2] };
+  sample_consensus::DistanceBlock block;
+  float block_distances[sample_consensus::DISTANCE_BLOCK_SIZE];
+
+  // Calculate the squared distances from the 3d points to the line by blocks of points
+  // D = ||(P2-P1) x (P1-P0)|| / ||P2-P1|| = norm (cross (p2-p1, p2-p0)) / norm(p2-p1)
+  for (size_t begin = 0; begin < indices_->size (); begin += sample_consensus::DISTANCE_BLOCK_SIZE)
   {
-    // Calculate the distance from the point to the line
-    // D = ||(P2-P1) x (P1-P0)|| / ||P2-P1|| = norm (cross (p2-p1, p2-p0)) / norm(p2-p1)
-    double sqr_distance = (line_pt - input_->points[(*indices_)[i]].getVector4fMap ()).cross3 (line_dir).squaredNorm ();
-
-    if (sqr_distance < sqr_threshold)
+    sample_consensus::gatherXYZ (*input_, *indices_, begin, block);
+    sample_consensus::lineSqrDistances (block, line_pt, line_dir3, block_distances);
+    for (int j = 0; j < block.size; ++j)
     {
-      // Returns the indices of the points whose squared distances are smaller than the threshold
-      inliers[nr_p] = (*indices_)[i];
-      nr_p++;
+      // Returns the indices of the points whose distances are smaller than the threshold
+      if (block_distances[j] < sqr_threshold)
+        inliers[nr_p++] = (*indices_)[begin + j];
     }
   }
   inliers.resize (nr_p);
@@ -158,19 +165,22 @@ pcl::SampleConsensusModelLine<PointT>::countWithinDistance (
   int nr_p = 0;
 
   // Obtain the line point and direction
-  Eigen::Vector4f line_pt  (model_coefficients[0], model_coefficients[1], model_coefficients[2], 0);
   Eigen::Vector4f line_dir (model_coefficients[3], model_coefficients[4], model_coefficients[5], 0);
   line_dir.normalize ();
-
-  // Iterate through the 3d points and calculate the distances from them to the line
-  for (size_t i = 0; i < indices_->size (); ++i)
+  const float line_pt[3] = { model_coefficients[0], model_coefficients[1], model_coefficients[2] };
+  const float line_dir3[3] = { line_dir[0], line_dir[1], line_dir[2] };
+  sample_consensus::DistanceBlock block;
+  float block_distances[sample_consensus::DISTANCE_BLOCK_SIZE];
+
+  // Calculate the squared distances from the 3d points to the line by blocks of points
+  // D = ||(P2-P1) x (P1-P0)|| / ||P2-P1|| = norm (cross (p2-p1, p2-p0)) / norm(p2-p1)
+  for (size_t begin = 0; begin < indices_->size (); begin += sample_consensus::DISTANCE_BLOCK_SIZE)
   {
-    // Calculate the distance from the point to the line
-    // D = ||(P2-P1) x (P1-P0)|| / ||P2-P1|| = norm (cross (p2-p1, p2-p0)) / norm(p2-p1)
-    double sqr_distance = (line_pt - input_->points[(*indices_)[i]].getVector4fMap ()).cross3 (line_dir).squaredNorm ();
-
-    if (sqr_distance < sqr_threshold)
-      nr_p++;
+    sample_consensus::gatherXYZ (*input_, *indices_, begin, block);
+    sample_consensus::lineSqrDistances (block, line_pt, line_dir3, block_distances);
+    for (int j = 0; j < block.size; ++j)
+      if (block_distances[j] < sqr_threshold)
+        nr_p++;
   }
   return (nr_p);
 }
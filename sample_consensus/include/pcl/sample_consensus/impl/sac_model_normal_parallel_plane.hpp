@@ -125,6 +125,51 @@ pcl::SampleConsensusModelNormalParallelPlane<PointT, PointNT>::countWithinDistan
   return (nr_p);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, typename PointNT> int
+pcl::SampleConsensusModelNormalParallelPlane<PointT, PointNT>::countWithinDistancePreemptive (
+      const Eigen::VectorXf &model_coefficients, const double threshold, const int min_inliers)
+{
+  if (!normals_)
+  {
+    PCL_ERROR ("[pcl::SampleConsensusModelNormalParallelPlane::countWithinDistancePreemptive] No input dataset containing normals was given!\n");
+    return (0);
+  }
+
+  // Check if the model is valid given the user constraints
+  if (!isModelValid (model_coefficients))
+    return (0);
+
+  // Obtain the plane normal
+  Eigen::Vector4f coeff = model_coefficients;
+
+  const int nr_points = static_cast<int> (indices_->size ());
+  const int block_size = 1024;
+  int nr_p = 0;
+
+  // Count the inliers by blocks of points, and stop once the remaining points can not bring the model to min_inliers
+  for (int begin = 0; begin < nr_points; begin += block_size)
+  {
+    const int end = (std::min) (begin + block_size, nr_points);
+    for (int i = begin; i < end; ++i)
+    {
+      Eigen::Vector4f p (input_->points[(*indices_)[i]].x, input_->points[(*indices_)[i]].y, input_->points[(*indices_)[i]].z, 1);
+      Eigen::Vector4f n (normals_->points[(*indices_)[i]].normal[0], normals_->points[(*indices_)[i]].normal[1], normals_->points[(*indices_)[i]].normal[2], 0);
+      double d_euclid = fabs (coeff.dot (p));
+
+      // Calculate the angular distance between the point normal and the plane normal
+      double d_normal = fabs (getAngle3D (n, coeff));
+      d_normal = (std::min) (d_normal, fabs(M_PI - d_normal));
+
+      if (fabs (normal_distance_weight_ * d_normal + (1 - normal_distance_weight_) * d_euclid) < threshold)
+        nr_p++;
+    }
+    if (nr_p + (nr_points - end) < min_inliers)
+      break;
+  }
+  return (nr_p);
+}
+
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT, typename PointNT> void
@@ -39,6 +39,7 @@
 #define PCL_SAMPLE_CONSENSUS_IMPL_SAC_MODEL_NORMAL_PLANE_H_
 
 #include <pcl/sample_consensus/sac_model_normal_plane.h>
+#include <pcl/sample_consensus/distance_kernels.h>
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT, typename PointNT> void
@@ -59,30 +60,26 @@ pcl::SampleConsensusModelNormalPlane<PointT, PointNT>::selectWithinDistance (
     return;
   }
 
-  // Obtain the plane normal
-  Eigen::Vector4f coeff = model_coefficients;
-  coeff[3] = 0;
-
   int nr_p = 0;
   inliers.resize (indices_->size ());
-  // Iterate through the 3d points and calculate the distances from them to the plane
-  for (size_t i = 0; i < indices_->size (); ++i)
-  {
-    // Calculate the distance from the point to the plane normal as the dot product
-    // D = (P-A).N/|N|
-    Eigen::Vector4f p (input_->points[(*indices_)[i]].x, input_->points[(*indices_)[i]].y, input_->points[(*indices_)[i]].z, 0);
-    Eigen::Vector4f n (normals_->points[(*indices_)[i]].normal[0], normals_->points[(*indices_)[i]].normal[1], normals_->points[(*indices_)[i]].normal[2], 0);
-    double d_euclid = fabs (coeff.dot (p) + model_coefficients[3]);
 
-    // Calculate the angular distance between the point normal and the plane normal
-    double d_normal = fabs (getAngle3D (n, coeff));
-    d_normal = (std::min) (d_normal, M_PI - d_normal);
+  const float coefficients[4] = { model_coefficients[0], model_coefficients[1], model_coefficients[2], model_coefficients[3] };
+  const float weight = static_cast<float> (normal_distance_weight_);
+  sample_consensus::DistanceBlock block;
+  float block_distances[sample_consensus::DISTANCE_BLOCK_SIZE];
 
-    if (fabs (normal_distance_weight_ * d_normal + (1 - normal_distance_weight_) * d_euclid) < threshold)
+  // Calculate the distances from the 3d points to the plane by blocks of points, weighting the euclidean
+  // distance with the angular distance between the point normal and the plane normal
+  for (size_t begin = 0; begin < indices_->size (); begin += sample_consensus::DISTANCE_BLOCK_SIZE)
+  {
+    sample_consensus::gatherXYZ (*input_, *indices_, begin, block);
+    sample_consensus::gatherNormals (*normals_, *indices_, begin, block);
+    sample_consensus::normalPlaneDistances (block, coefficients, weight, block_distances);
+    for (int j = 0; j < block.size; ++j)
     {
       // Returns the indices of the points whose distances are smaller than the threshold
-      inliers[nr_p] = (*indices_)[i];
-      nr_p++;
+      if (block_distances[j] < threshold)
+        inliers[nr_p++] = (*indices_)[begin + j];
     }
   }
   inliers.resize (nr_p);
@@ -103,27 +100,61 @@ pcl::SampleConsensusModelNormalPlane<PointT, PointNT>::countWithinDistance (
   if (!isModelValid (model_coefficients))
     return (0);
 
-  // Obtain the plane normal
-  Eigen::Vector4f coeff = model_coefficients;
-  coeff[3] = 0;
+  int nr_p = 0;
+
+  const float coefficients[4] = { model_coefficients[0], model_coefficients[1], model_coefficients[2], model_coefficients[3] };
+  const float weight = static_cast<float> (normal_distance_weight_);
+  sample_consensus::DistanceBlock block;
+  float block_distances[sample_consensus::DISTANCE_BLOCK_SIZE];
+
+  // Calculate the distances from the 3d points to the plane by blocks of points, weighting the euclidean
+  // distance with the angular distance between the point normal and the plane normal
+  for (size_t begin = 0; begin < indices_->size (); begin += sample_consensus::DISTANCE_BLOCK_SIZE)
+  {
+    sample_consensus::gatherXYZ (*input_, *indices_, begin, block);
+    sample_consensus::gatherNormals (*normals_, *indices_, begin, block);
+    sample_consensus::normalPlaneDistances (block, coefficients, weight, block_distances);
+    for (int j = 0; j < block.size; ++j)
+      if (block_distances[j] < threshold)
+        nr_p++;
+  }
+  return (nr_p);
+}
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT, typename PointNT> int
+pcl::SampleConsensusModelNormalPlane<PointT, PointNT>::countWithinDistancePreemptive (
+      const Eigen::VectorXf &model_coefficients, const double threshold, const int min_inliers)
+{
+  if (!normals_)
+  {
+    PCL_ERROR ("[pcl::SampleConsensusModelNormalPlane::countWithinDistancePreemptive] No input dataset containing normals was given!\n");
+    return (0);
+  }
+
+  // Check if the model is valid given the user constraints
+  if (!isModelValid (model_coefficients))
+    return (0);
+
+  const int nr_points = static_cast<int> (indices_->size ());
   int nr_p = 0;
 
-  // Iterate through the 3d points and calculate the distances from them to the plane
-  for (size_t i = 0; i < indices_->size (); ++i)
+  const float coefficients[4] = { model_coefficients[0], model_coefficients[1], model_coefficients[2], model_coefficients[3] };
+  const float weight = static_cast<float> (normal_distance_weight_);
+  sample_consensus::DistanceBlock block;
+  float block_distances[sample_consensus::DISTANCE_BLOCK_SIZE];
+
+  // Count the inliers by blocks of points, and stop once the remaining points can not bring the model to min_inliers
+  for (int begin = 0; begin < nr_points; begin += sample_consensus::DISTANCE_BLOCK_SIZE)
   {
-    // Calculate the distance from the point to the plane normal as the dot product
-    // D = (P-A).N/|N|
-    Eigen::Vector4f p (input_->points[(*indices_)[i]].x, input_->points[(*indices_)[i]].y, input_->points[(*indices_)[i]].z, 0);
-    Eigen::Vector4f n (normals_->points[(*indices_)[i]].normal[0], normals_->points[(*indices_)[i]].normal[1], normals_->points[(*indices_)[i]].normal[2], 0);
-    double d_euclid = fabs (coeff.dot (p) + model_coefficients[3]);
-
-    // Calculate the angular distance between the point normal and the plane normal
-    double d_normal = fabs (getAngle3D (n, coeff));
-    d_normal = (std::min) (d_normal, M_PI - d_normal);
-
-    if (fabs (normal_distance_weight_ * d_normal + (1 - normal_distance_weight_) * d_euclid) < threshold)
-      nr_p++;
+    sample_consensus::gatherXYZ (*input_, *indices_, begin, block);
+    sample_consensus::gatherNormals (*normals_, *indices_, begin, block);
+    sample_consensus::normalPlaneDistances (block, coefficients, weight, block_distances);
+    for (int j = 0; j < block.size; ++j)
+      if (block_distances[j] < threshold)
+        nr_p++;
+    if (nr_p + (nr_points - begin - block.size) < min_inliers)
+      break;
   }
   return (nr_p);
 }
@@ -146,26 +177,22 @@ pcl::SampleConsensusModelNormalPlane<PointT, PointNT>::getDistancesToModel (
     return;
   }
 
-  // Obtain the plane normal
-  Eigen::Vector4f coeff = model_coefficients;
-  coeff[3] = 0;
-
   distances.resize (indices_->size ());
 
-  // Iterate through the 3d points and calculate the distances from them to the plane
-  for (size_t i = 0; i < indices_->size (); ++i)
-  {
-    // Calculate the distance from the point to the plane normal as the dot product
-    // D = (P-A).N/|N|
-    Eigen::Vector4f p (input_->points[(*indices_)[i]].x, input_->points[(*indices_)[i]].y, input_->points[(*indices_)[i]].z, 0);
-    Eigen::Vector4f n (normals_->points[(*indices_)[i]].normal[0], normals_->points[(*indices_)[i]].normal[1], normals_->points[(*indices_)[i]].normal[2], 0);
-    double d_euclid = fabs (coeff.dot (p) + model_coefficients[3]);
-
-    // Calculate the angular distance between the point normal and the plane normal
-    double d_normal = fabs (getAngle3D (n, coeff));
-    d_normal = (std::min) (d_normal, M_PI - d_normal);
+  const float coefficients[4] = { model_coefficients[0], model_coefficients[1], model_coefficients[2], model_coefficients[3] };
+  const float weight = static_cast<float> (normal_distance_weight_);
+  sample_consensus::DistanceBlock block;
+  float block_distances[sample_consensus::DISTANCE_BLOCK_SIZE];
 
-    distances[i] = fabs (normal_distance_weight_ * d_normal + (1 - normal_distance_weight_) * d_euclid);
+  // Calculate the distances from the 3d points to the plane by blocks of points, weighting the euclidean
+  // distance with the angular distance between the point normal and the plane normal
+  for (size_t begin = 0; begin < indices_->size (); begin += sample_consensus::DISTANCE_BLOCK_SIZE)
+  {
+    sample_consensus::gatherXYZ (*input_, *indices_, begin, block);
+    sample_consensus::gatherNormals (*normals_, *indices_, begin, block);
+    sample_consensus::normalPlaneDistances (block, coefficients, weight, block_distances);
+    for (int j = 0; j < block.size; ++j)
+      distances[begin + j] = block_distances[j];
   }
 }
 
@@ -67,6 +67,18 @@ pcl::SampleConsensusModelParallelPlane<PointT>::countWithinDistance (
   return (SampleConsensusModelPlane<PointT>::countWithinDistance (model_coefficients, threshold));
 }
 
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::SampleConsensusModelParallelPlane<PointT>::countWithinDistancePreemptive (
+      const Eigen::VectorXf &model_coefficients, const double threshold, const int min_inliers)
+{
+  // Check if the model is valid given the user constraints
+  if (!isModelValid (model_coefficients))
+    return (0);
+
+  return (SampleConsensusModelPlane<PointT>::countWithinDistancePreemptive (model_coefficients, threshold, min_inliers));
+}
+
 //////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
 pcl::SampleConsensusModelParallelPlane<PointT>::getDistancesToModel (
@@ -67,6 +67,18 @@ pcl::SampleConsensusModelPerpendicularPlane<PointT>::countWithinDistance (
   return (SampleConsensusModelPlane<PointT>::countWithinDistance (model_coefficients, threshold));
 }
 
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::SampleConsensusModelPerpendicularPlane<PointT>::countWithinDistancePreemptive (
+      const Eigen::VectorXf &model_coefficients, const double threshold, const int min_inliers)
+{
+  // Check if the model is valid given the user constraints
+  if (!isModelValid (model_coefficients))
+    return (0);
+
+  return (SampleConsensusModelPlane<PointT>::countWithinDistancePreemptive (model_coefficients, threshold, min_inliers));
+}
+
 //////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
 pcl::SampleConsensusModelPerpendicularPlane<PointT>::getDistancesToModel (
@@ -39,6 +39,7 @@
 #define PCL_SAMPLE_CONSENSUS_IMPL_SAC_MODEL_PLANE_H_
 
 #include <pcl/sample_consensus/sac_model_plane.h>
+#include <pcl/sample_consensus/distance_kernels.h>
 #include <pcl/common/centroid.h>
 #include <pcl/common/eigen.h>
 #include <pcl/common/concatenate.h>
@@ -117,20 +118,17 @@ pcl::SampleConsensusModelPlane<PointT>::getDistancesToModel (
 
   distances.resize (indices_->size ());
 
-  // Iterate through the 3d points and calculate the distances from them to the plane
-  for (size_t i = 0; i < indices_->size (); ++i)
+  const float coefficients[4] = { model_coefficients[0], model_coefficients[1], model_coefficients[2], model_coefficients[3] };
+  sample_consensus::DistanceBlock block;
+  float block_distances[sample_consensus::DISTANCE_BLOCK_SIZE];
+
+  // Calculate the distances from the 3d points to the plane by blocks of points, D = |N.P + d|
+  for (size_t begin = 0; begin < indices_->size (); begin += sample_consensus::DISTANCE_BLOCK_SIZE)
   {
-    // Calculate the distance from the point to the plane normal as the dot product
-    // D = (P-A).N/|N|
-    /*distances[i] = fabs (model_coefficients[0] * input_->points[(*indices_)[i]].x +
-                         model_coefficients[1] * input_->points[(*indices_)[i]].y +
-                         model_coefficients[2] * input_->points[(*indices_)[i]].z +
-                         model_coefficients[3]);*/
-    Eigen::Vector4f pt (input_->points[(*indices_)[i]].x,
-                        input_->points[(*indices_)[i]].y,
-                        input_->points[(*indices_)[i]].z,
-                        1);
-    distances[i] = fabs (model_coefficients.dot (pt));
+    sample_consensus::gatherXYZ (*input_, *indices_, begin, block);
+    sample_consensus::planeDistances (block, coefficients, block_distances);
+    for (int j = 0; j < block.size; ++j)
+      distances[begin + j] = block_distances[j];
   }
 }
 
@@ -149,20 +147,20 @@ pcl::SampleConsensusModelPlane<PointT>::selectWithinDistance (
   int nr_p = 0;
   inliers.resize (indices_->size ());
 
-  // Iterate through the 3d points and calculate the distances from them to the plane
-  for (size_t i = 0; i < indices_->size (); ++i)
+  const float coefficients[4] = { model_coefficients[0], model_coefficients[1], model_coefficients[2], model_coefficients[3] };
+  sample_consensus::DistanceBlock block;
+  float block_distances[sample_consensus::DISTANCE_BLOCK_SIZE];
+
+  // Calculate the distances from the 3d points to the plane by blocks of points, D = |N.P + d|
+  for (size_t begin = 0; begin < indices_->size (); begin += sample_consensus::DISTANCE_BLOCK_SIZE)
   {
-    // Calculate the distance from the point to the plane normal as the dot product
-    // D = (P-A).N/|N|
-    Eigen::Vector4f pt (input_->points[(*indices_)[i]].x,
-                        input_->points[(*indices_)[i]].y,
-                        input_->points[(*indices_)[i]].z,
-                        1);
-    if (fabs (model_coefficients.dot (pt)) < threshold)
+    sample_consensus::gatherXYZ (*input_, *indices_, begin, block);
+    sample_consensus::planeDistances (block, coefficients, block_distances);
+    for (int j = 0; j < block.size; ++j)
     {
       // Returns the indices of the points whose distances are smaller than the threshold
-      inliers[nr_p] = (*indices_)[i];
-      nr_p++;
+      if (block_distances[j] < threshold)
+        inliers[nr_p++] = (*indices_)[begin + j];
     }
   }
   inliers.resize (nr_p);
@@ -182,17 +180,51 @@ pcl::SampleConsensusModelPlane<PointT>::countWithinDistance (
 
   int nr_p = 0;
 
-  // Iterate through the 3d points and calculate the distances from them to the plane
-  for (size_t i = 0; i < indices_->size (); ++i)
+  const float coefficients[4] = { model_coefficients[0], model_coefficients[1], model_coefficients[2], model_coefficients[3] };
+  sample_consensus::DistanceBlock block;
+  float block_distances[sample_consensus::DISTANCE_BLOCK_SIZE];
+
+  // Calculate the distances from the 3d points to the plane by blocks of points, D = |N.P + d|
+  for (size_t begin = 0; begin < indices_->size (); begin += sample_consensus::DISTANCE_BLOCK_SIZE)
   {
-    // Calculate the distance from the point to the plane normal as the dot product
-    // D = (P-A).N/|N|
-    Eigen::Vector4f pt (input_->points[(*indices_)[i]].x,
-                        input_->points[(*indices_)[i]].y,
-                        input_->points[(*indices_)[i]].z,
-                        1);
-    if (fabs (model_coefficients.dot (pt)) < threshold)
-      nr_p++;
+    sample_consensus::gatherXYZ (*input_, *indices_, begin, block);
+    sample_consensus::planeDistances (block, coefficients, block_distances);
+    for (int j = 0; j < block.size; ++j)
+      if (block_distances[j] < threshold)
+        nr_p++;
+  }
+  return (nr_p);
+}
+
+//////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::SampleConsensusModelPlane<PointT>::countWithinDistancePreemptive (
+      const Eigen::VectorXf &model_coefficients, const double threshold, const int min_inliers)
+{
+  // Needs a valid set of model coefficients
+  if (model_coefficients.size () != 4)
+  {
+    PCL_ERROR ("[pcl::SampleConsensusModelPlane::countWithinDistancePreemptive] Invalid number of model coefficients given (%zu)!\n", model_coefficients.size ());
+    return (0);
+  }
+
+  const int nr_points = static_cast<int> (indices_->size ());
+  int nr_p = 0;
+
+  const float coefficients[4] = { model_coefficients[0], model_coefficients[1], model_coefficients[2], model_coefficients[3] };
+  sample_consensus::DistanceBlock block;
+  float block_distances[sample_consensus::DISTANCE_BLOCK_SIZE];
+
+  // Count the inliers by blocks of points, and stop once the remaining points can not bring the model to min_inliers
+  for (int begin = 0; begin < nr_points; begin += sample_consensus::DISTANCE_BLOCK_SIZE)
+  {
+    sample_consensus::gatherXYZ (*input_, *indices_, begin, block);
+    sample_consensus::planeDistances (block, coefficients, block_distances);
+    for (int j = 0; j < block.size; ++j)
+      if (block_distances[j] < threshold)
+        nr_p++;
+    if (nr_p + (nr_points - begin - block.size) < min_inliers)
+      break;
   }
   return (nr_p);
 }
@@ -40,6 +40,7 @@
 
 #include <pcl/sample_consensus/eigen.h>
 #include <pcl/sample_consensus/sac_model_sphere.h>
+#include <pcl/sample_consensus/distance_kernels.h>
 
 //////////////////////////////////////////////////////////////////////////
 template <typename PointT> bool
@@ -126,22 +127,22 @@ pcl::SampleConsensusModelSphere<PointT>::getDistancesToModel (
     distances.clear ();
     return;
   }
-  distances.resize (indices_->size ());
 
-  // Iterate through the 3d points and calculate the distances from them to the sphere
-  for (size_t i = 0; i < indices_->size (); ++i)
-    // Calculate the distance from the point to the sphere as the difference between
-    //dist(point,sphere_origin) and sphere_radius
-    distances[i] = fabs (sqrtf (
-                               ( input_->points[(*indices_)[i]].x - model_coefficients[0] ) *
-                               ( input_->points[(*indices_)[i]].x - model_coefficients[0] ) +
+  distances.resize (indices_->size ());
 
-                               ( input_->points[(*indices_)[i]].y - model_coefficients[1] ) *
-                               ( input_->points[(*indices_)[i]].y - model_coefficients[1] ) +
+  const float center[3] = { model_coefficients[0], model_coefficients[1], model_coefficients[2] };
+  sample_consensus::DistanceBlock block;
+  float block_distances[sample_consensus::DISTANCE_BLOCK_SIZE];
 
-                               ( input_->points[(*indices_)[i]].z - model_coefficients[2] ) *
-                               ( input_->points[(*indices_)[i]].z - model_coefficients[2] )
-                               ) - model_coefficients[3]);
+  // Calculate the distances from the 3d points to the sphere by blocks of points, as the difference between
+  // dist(point,sphere_origin) and sphere_radius
+  for (size_t begin = 0; begin < indices_->size (); begin += sample_consensus::DISTANCE_BLOCK_SIZE)
+  {
+    sample_consensus::gatherXYZ (*input_, *indices_, begin, block);
+    sample_consensus::sphereDistances (block, center, model_coefficients[3], block_distances);
+    for (int j = 0; j < block.size; ++j)
+      distances[begin + j] = block_distances[j];
+  }
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -159,25 +160,21 @@ pcl::SampleConsensusModelSphere<PointT>::selectWithinDistance (
   int nr_p = 0;
   inliers.resize (indices_->size ());
 
-  // Iterate through the 3d points and calculate the distances from them to the sphere
-  for (size_t i = 0; i < indices_->size (); ++i)
-  {
-    // Calculate the distance from the point to the sphere as the difference between
-    // dist(point,sphere_origin) and sphere_radius
-    if (fabs (sqrtf (
-                    ( input_->points[(*indices_)[i]].x - model_coefficients[0] ) *
-                    ( input_->points[(*indices_)[i]].x - model_coefficients[0] ) +
-
-                    ( input_->points[(*indices_)[i]].y - model_coefficients[1] ) *
-                    ( input_->points[(*indices_)[i]].y - model_coefficients[1] ) +
+  const float center[3] = { model_coefficients[0], model_coefficients[1], model_coefficients[2] };
+  sample_consensus::DistanceBlock block;
+  float block_distances[sample_consensus::DISTANCE_BLOCK_SIZE];
 
-                    ( input_->points[(*indices_)[i]].z - model_coefficients[2] ) *
-                    ( input_->points[(*indices_)[i]].z - model_coefficients[2] )
-                    ) - model_coefficients[3]) < threshold)
+  // Calculate the distances from the 3d points to the sphere by blocks of points, as the difference between
+  // dist(point,sphere_origin) and sphere_radius
+  for (size_t begin = 0; begin < indices_->size (); begin += sample_consensus::DISTANCE_BLOCK_SIZE)
+  {
+    sample_consensus::gatherXYZ (*input_, *indices_, begin, block);
+    sample_consensus::sphereDistances (block, center, model_coefficients[3], block_distances);
+    for (int j = 0; j < block.size; ++j)
     {
       // Returns the indices of the points whose distances are smaller than the threshold
-      inliers[nr_p] = (*indices_)[i];
-      nr_p++;
+      if (block_distances[j] < threshold)
+        inliers[nr_p++] = (*indices_)[begin + j];
     }
   }
   inliers.resize (nr_p);
@@ -194,22 +191,19 @@ pcl::SampleConsensusModelSphere<PointT>::countWithinDistance (
 
   int nr_p = 0;
 
-  // Iterate through the 3d points and calculate the distances from them to the sphere
-  for (size_t i = 0; i < indices_->size (); ++i)
+  const float center[3] = { model_coefficients[0], model_coefficients[1], model_coefficients[2] };
+  sample_consensus::DistanceBlock block;
+  float block_distances[sample_consensus::DISTANCE_BLOCK_SIZE];
+
+  // Calculate the distances from the 3d points to the sphere by blocks of points, as the difference between
+  // dist(point,sphere_origin) and sphere_radius
+  for (size_t begin = 0; begin < indices_->size (); begin += sample_consensus::DISTANCE_BLOCK_SIZE)
   {
-    // Calculate the distance from the point to the sphere as the difference between
-    // dist(point,sphere_origin) and sphere_radius
-    if (fabs (sqrtf (
-                    ( input_->points[(*indices_)[i]].x - model_coefficients[0] ) *
-                    ( input_->points[(*indices_)[i]].x - model_coefficients[0] ) +
-
-                    ( input_->points[(*indices_)[i]].y - model_coefficients[1] ) *
-                    ( input_->points[(*indices_)[i]].y - model_coefficients[1] ) +
-
-                    ( input_->points[(*indices_)[i]].z - model_coefficients[2] ) *
-                    ( input_->points[(*indices_)[i]].z - model_coefficients[2] )
-                    ) - model_coefficients[3]) < threshold)
-      nr_p++;
+    sample_consensus::gatherXYZ (*input_, *indices_, begin, block);
+    sample_consensus::sphereDistances (block, center, model_coefficients[3], block_distances);
+    for (int j = 0; j < block.size; ++j)
+      if (block_distances[j] < threshold)
+        nr_p++;
   }
   return (nr_p);
 }
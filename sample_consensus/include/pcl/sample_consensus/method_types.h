@@ -47,6 +47,7 @@ namespace pcl
   const static int SAC_RMSAC   = 4;
   const static int SAC_MLESAC  = 5;
   const static int SAC_PROSAC  = 6;
+  const static int SAC_PARALLEL_RANSAC = 7;
 }
 
 #endif  //#ifndef PCL_SAMPLE_CONSENSUS_METHOD_TYPES_H_
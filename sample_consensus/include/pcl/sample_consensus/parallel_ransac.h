@@ -0,0 +1,149 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_SAMPLE_CONSENSUS_PARALLEL_RANSAC_H_
+#define PCL_SAMPLE_CONSENSUS_PARALLEL_RANSAC_H_
+
+#include <pcl/sample_consensus/sac.h>
+#include <pcl/sample_consensus/sac_model.h>
+
+namespace pcl
+{
+  //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  /** \brief @b ParallelRandomSampleConsensus is a multithreaded RANSAC, evaluating the hypotheses by batches.
+    *
+    * The samples of a batch are drawn sequentially from the model, then the hypotheses of the batch are
+    * computed and scored in parallel. Each hypothesis is first checked on a few random points (the
+    * T(d,d) test of "Randomized RANSAC with Td,d test", O. Chum and J. Matas, BMVC 2002), then its
+    * inliers are counted with SampleConsensusModel::countWithinDistancePreemptive, which gives up as
+    * soon as the hypothesis can not beat the best one found so far.
+    *
+    * The best hypothesis is the one with the most inliers, the first one drawn in case of ties, so the
+    * result only depends on the seed and on the batch size, not on the number of threads.
+    *
+    * \note The model is shared by the threads: its computeModelCoefficients, doSamplesVerifyModel and
+    * countWithinDistancePreemptive methods must not modify it, which is the case of the models of PCL.
+    * \ingroup sample_consensus
+    */
+  template <typename PointT>
+  class ParallelRandomSampleConsensus : public SampleConsensus<PointT>
+  {
+    using SampleConsensus<PointT>::max_iterations_;
+    using SampleConsensus<PointT>::threshold_;
+    using SampleConsensus<PointT>::iterations_;
+    using SampleConsensus<PointT>::sac_model_;
+    using SampleConsensus<PointT>::model_;
+    using SampleConsensus<PointT>::model_coefficients_;
+    using SampleConsensus<PointT>::inliers_;
+    using SampleConsensus<PointT>::probability_;
+    using SampleConsensus<PointT>::rng_;
+
+    typedef typename SampleConsensusModel<PointT>::Ptr SampleConsensusModelPtr;
+
+    public:
+      /** \brief Parallel RANSAC main constructor
+        * \param[in] model a Sample Consensus model
+        */
+      ParallelRandomSampleConsensus (const SampleConsensusModelPtr &model) : 
+        SampleConsensus<PointT> (model),
+        batch_size_ (64),
+        nr_pretest_ (1),
+        threads_ (0)
+      {
+        // Maximum number of trials before we give up.
+        max_iterations_ = 10000;
+      }
+
+      /** \brief Parallel RANSAC main constructor
+        * \param[in] model a Sample Consensus model
+        * \param[in] threshold distance to model threshold
+        */
+      ParallelRandomSampleConsensus (const SampleConsensusModelPtr &model, double threshold) : 
+        SampleConsensus<PointT> (model, threshold),
+        batch_size_ (64),
+        nr_pretest_ (1),
+        threads_ (0)
+      {
+        // Maximum number of trials before we give up.
+        max_iterations_ = 10000;
+      }
+
+      /** \brief Compute the actual model and find the inliers
+        * \param[in] debug_verbosity_level enable/disable on-screen debug information and set the verbosity level
+        */
+      bool 
+      computeModel (int debug_verbosity_level = 0);
+
+      /** \brief Set the number of hypotheses drawn and evaluated together (default: 64).
+        * \param[in] batch_size the number of hypotheses of a batch
+        */
+      inline void 
+      setBatchSize (int batch_size) { batch_size_ = (std::max) (1, batch_size); }
+
+      /** \brief Get the number of hypotheses drawn and evaluated together. */
+      inline int 
+      getBatchSize () const { return (batch_size_); }
+
+      /** \brief Set the number of random points a hypothesis must fit before its inliers are counted (default: 1).
+        * \param[in] nr_pretest the number of points of the T(d,d) test, 0 to disable it
+        */
+      inline void 
+      setNumberOfPretestPoints (int nr_pretest) { nr_pretest_ = (std::max) (0, nr_pretest); }
+
+      /** \brief Get the number of random points a hypothesis must fit before its inliers are counted. */
+      inline int 
+      getNumberOfPretestPoints () const { return (nr_pretest_); }
+
+      /** \brief Initialize the scheduler and set the number of threads to use.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      inline void 
+      setNumberOfThreads (unsigned int nr_threads = 0) { threads_ = nr_threads; }
+
+    protected:
+      /** \brief Number of hypotheses drawn and evaluated together. */
+      int batch_size_;
+
+      /** \brief Number of random points of the T(d,d) pre-test. */
+      int nr_pretest_;
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
+  };
+}
+
+#endif  //#ifndef PCL_SAMPLE_CONSENSUS_PARALLEL_RANSAC_H_
@@ -258,6 +258,27 @@ namespace pcl
       countWithinDistance (const Eigen::VectorXf &model_coefficients, 
                            const double threshold) = 0;
 
+      /** \brief Count the points which respect the given model coefficients as inliers, giving up as soon 
+        * as the model can not reach \a min_inliers inliers anymore.
+        *
+        * The default implementation counts all the inliers with countWithinDistance. Models overriding it 
+        * must stay consistent with their countWithinDistance.
+        * \param[in] model_coefficients the coefficients of a model that we need to
+        * compute distances to
+        * \param[in] threshold a maximum admissible distance threshold for
+        * determining the inliers from the outliers
+        * \param[in] min_inliers the number of inliers the model needs to be of interest
+        * \return the number of inliers if it is at least \a min_inliers, a smaller value otherwise
+        */
+      virtual int
+      countWithinDistancePreemptive (const Eigen::VectorXf &model_coefficients, 
+                                     const double threshold,
+                                     const int min_inliers)
+      {
+        (void)min_inliers;
+        return (countWithinDistance (model_coefficients, threshold));
+      }
+
       /** \brief Create a new point cloud with inliers projected onto the model. Pure virtual.
         * \param[in] inliers the data inliers that we want to project on the model
         * \param[in] model_coefficients the coefficients of a model
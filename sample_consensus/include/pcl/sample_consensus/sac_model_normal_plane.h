@@ -129,6 +129,18 @@ namespace pcl
       countWithinDistance (const Eigen::VectorXf &model_coefficients, 
                            const double threshold);
 
+      /** \brief Count the points which respect the given model coefficients as inliers, giving up as soon
+        * as the model can not reach \a min_inliers inliers anymore.
+        * \param[in] model_coefficients the coefficients of a model that we need to compute distances to
+        * \param[in] threshold maximum admissible distance threshold for determining the inliers from the outliers
+        * \param[in] min_inliers the number of inliers the model needs to be of interest
+        * \return the number of inliers if it is at least \a min_inliers, a smaller value otherwise
+        */
+      virtual int
+      countWithinDistancePreemptive (const Eigen::VectorXf &model_coefficients, 
+                                     const double threshold, 
+                                     const int min_inliers);
+
       /** \brief Compute all distances from the cloud data to a given plane model.
         * \param[in] model_coefficients the coefficients of a plane model that we need to compute distances to
         * \param[out] distances the resultant estimated distances
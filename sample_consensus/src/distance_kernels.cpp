@@ -0,0 +1,577 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <pcl/sample_consensus/distance_kernels.h>
+#include <cmath>
+
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define PCL_SAC_HAVE_SSE2
+#  include <emmintrin.h>
+#endif
+
+// The AVX kernels are compiled for AVX regardless of the compiler flags, and only called
+// when the CPU supports them. GCC needs the target attribute for that (GCC >= 4.9).
+#if defined (PCL_SAC_HAVE_SSE2) && (defined (__AVX__) || (defined (_MSC_VER) && _MSC_VER >= 1600) || \
+    (defined (__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#  define PCL_SAC_HAVE_AVX
+#  include <immintrin.h>
+#  if defined (_MSC_VER)
+#    include <intrin.h>
+#  endif
+#  if defined (__GNUC__) && !defined (__AVX__)
+#    define PCL_SAC_AVX_TARGET __attribute__ ((target ("avx")))
+#  else
+#    define PCL_SAC_AVX_TARGET
+#  endif
+#endif
+
+using pcl::sample_consensus::DistanceBlock;
+using pcl::sample_consensus::SimdLevel;
+
+// Coefficients of the asin polynomial of Cephes (asinf), used to compute the angles of all the kernels,
+// so that the scalar and vectorized kernels give the same results up to rounding.
+#define PCL_SAC_ASIN_P0 4.2163199048e-2f
+#define PCL_SAC_ASIN_P1 2.4181311049e-2f
+#define PCL_SAC_ASIN_P2 4.5470025998e-2f
+#define PCL_SAC_ASIN_P3 7.4953002686e-2f
+#define PCL_SAC_ASIN_P4 1.6666752422e-1f
+#define PCL_SAC_HALF_PI 1.5707963267948966f
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/** \brief Returns min (acos (c), pi - acos (c)) = acos (|c|), c being the cosine of an angle.
+  * A NaN cosine gives a NaN angle, as std::acos does.
+  */
+static inline float
+foldedAngle (const float c)
+{
+  float x = fabsf (c);
+  if (x > 1.0f)
+    x = 1.0f;
+  const bool big = x > 0.5f;
+  const float z = big ? 0.5f * (1.0f - x) : x * x;
+  const float s = big ? sqrtf (z) : x;
+  const float p = ((((PCL_SAC_ASIN_P0 * z + PCL_SAC_ASIN_P1) * z + PCL_SAC_ASIN_P2) * z + PCL_SAC_ASIN_P3) * z + PCL_SAC_ASIN_P4) * z * s + s;
+  return (big ? 2.0f * p : PCL_SAC_HALF_PI - p);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+static void
+planeDistancesScalar (const DistanceBlock &b, int j, const float c[4], float *d)
+{
+  for (; j < b.size; ++j)
+    d[j] = fabsf (c[0] * b.x[j] + c[1] * b.y[j] + c[2] * b.z[j] + c[3]);
+}
+
+static void
+sphereDistancesScalar (const DistanceBlock &b, int j, const float center[3], const float radius, float *d)
+{
+  for (; j < b.size; ++j)
+  {
+    const float dx = b.x[j] - center[0], dy = b.y[j] - center[1], dz = b.z[j] - center[2];
+    d[j] = fabsf (sqrtf (dx * dx + dy * dy + dz * dz) - radius);
+  }
+}
+
+static void
+lineSqrDistancesScalar (const DistanceBlock &b, int j, const float p[3], const float u[3], float *d)
+{
+  for (; j < b.size; ++j)
+  {
+    // |(line_pt - pt) x line_dir|^2
+    const float wx = p[0] - b.x[j], wy = p[1] - b.y[j], wz = p[2] - b.z[j];
+    const float cx = wy * u[2] - wz * u[1];
+    const float cy = wz * u[0] - wx * u[2];
+    const float cz = wx * u[1] - wy * u[0];
+    d[j] = cx * cx + cy * cy + cz * cz;
+  }
+}
+
+static void
+normalPlaneDistancesScalar (const DistanceBlock &b, int j, const float c[4], const float w, float *d)
+{
+  const float cc = c[0] * c[0] + c[1] * c[1] + c[2] * c[2];
+  for (; j < b.size; ++j)
+  {
+    const float d_euclid = fabsf (c[0] * b.x[j] + c[1] * b.y[j] + c[2] * b.z[j] + c[3]);
+    const float nc = c[0] * b.nx[j] + c[1] * b.ny[j] + c[2] * b.nz[j];
+    const float nn = b.nx[j] * b.nx[j] + b.ny[j] * b.ny[j] + b.nz[j] * b.nz[j];
+    const float d_normal = foldedAngle (nc / sqrtf (nn * cc));
+    d[j] = fabsf (w * d_normal + (1.0f - w) * d_euclid);
+  }
+}
+
+static void
+cylinderDistancesScalar (const DistanceBlock &b, int j, const float p[3], const float u[3], const float radius, const float w, float *d)
+{
+  for (; j < b.size; ++j)
+  {
+    // v is the vector from the projection of the point on the axis to the point
+    const float wx = b.x[j] - p[0], wy = b.y[j] - p[1], wz = b.z[j] - p[2];
+    const float k = wx * u[0] + wy * u[1] + wz * u[2];
+    const float vx = wx - k * u[0], vy = wy - k * u[1], vz = wz - k * u[2];
+    const float vv = vx * vx + vy * vy + vz * vz;
+    const float d_euclid = fabsf (sqrtf (vv) - radius);
+    const float nv = b.nx[j] * vx + b.ny[j] * vy + b.nz[j] * vz;
+    const float nn = b.nx[j] * b.nx[j] + b.ny[j] * b.ny[j] + b.nz[j] * b.nz[j];
+    const float d_normal = foldedAngle (nv / sqrtf (nn * vv));
+    d[j] = fabsf (w * d_normal + (1.0f - w) * d_euclid);
+  }
+}
+
+#ifdef PCL_SAC_HAVE_SSE2
+//////////////////////////////////////////////////////////////////////////////////////////////
+static inline __m128
+abs4 (const __m128 v)
+{
+  return (_mm_andnot_ps (_mm_set1_ps (-0.0f), v));
+}
+
+static inline __m128
+select4 (const __m128 mask, const __m128 a, const __m128 b)
+{
+  return (_mm_or_ps (_mm_and_ps (mask, a), _mm_andnot_ps (mask, b)));
+}
+
+/** \brief SSE2 version of foldedAngle. */
+static inline __m128
+foldedAngle4 (const __m128 c)
+{
+  const __m128 one = _mm_set1_ps (1.0f), half = _mm_set1_ps (0.5f);
+  // _mm_min_ps returns its second operand if one of them is NaN, which propagates NaN cosines
+  const __m128 x = _mm_min_ps (one, abs4 (c));
+  const __m128 big = _mm_cmpgt_ps (x, half);
+  const __m128 z_big = _mm_mul_ps (half, _mm_sub_ps (one, x));
+  const __m128 z = select4 (big, z_big, _mm_mul_ps (x, x));
+  const __m128 s = select4 (big, _mm_sqrt_ps (z_big), x);
+  __m128 p = _mm_add_ps (_mm_mul_ps (_mm_set1_ps (PCL_SAC_ASIN_P0), z), _mm_set1_ps (PCL_SAC_ASIN_P1));
+  p = _mm_add_ps (_mm_mul_ps (p, z), _mm_set1_ps (PCL_SAC_ASIN_P2));
+  p = _mm_add_ps (_mm_mul_ps (p, z), _mm_set1_ps (PCL_SAC_ASIN_P3));
+  p = _mm_add_ps (_mm_mul_ps (p, z), _mm_set1_ps (PCL_SAC_ASIN_P4));
+  p = _mm_add_ps (_mm_mul_ps (_mm_mul_ps (p, z), s), s);
+  return (select4 (big, _mm_add_ps (p, p), _mm_sub_ps (_mm_set1_ps (PCL_SAC_HALF_PI), p)));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+static void
+planeDistancesSSE2 (const DistanceBlock &b, const float c[4], float *d)
+{
+  const __m128 c0 = _mm_set1_ps (c[0]), c1 = _mm_set1_ps (c[1]), c2 = _mm_set1_ps (c[2]), c3 = _mm_set1_ps (c[3]);
+  int j = 0;
+  for (; j + 4 <= b.size; j += 4)
+  {
+    __m128 r = _mm_add_ps (_mm_mul_ps (c0, _mm_loadu_ps (b.x + j)), _mm_mul_ps (c1, _mm_loadu_ps (b.y + j)));
+    r = _mm_add_ps (r, _mm_add_ps (_mm_mul_ps (c2, _mm_loadu_ps (b.z + j)), c3));
+    _mm_storeu_ps (d + j, abs4 (r));
+  }
+  planeDistancesScalar (b, j, c, d);
+}
+
+static void
+sphereDistancesSSE2 (const DistanceBlock &b, const float center[3], const float radius, float *d)
+{
+  const __m128 cx = _mm_set1_ps (center[0]), cy = _mm_set1_ps (center[1]), cz = _mm_set1_ps (center[2]), r = _mm_set1_ps (radius);
+  int j = 0;
+  for (; j + 4 <= b.size; j += 4)
+  {
+    const __m128 dx = _mm_sub_ps (_mm_loadu_ps (b.x + j), cx);
+    const __m128 dy = _mm_sub_ps (_mm_loadu_ps (b.y + j), cy);
+    const __m128 dz = _mm_sub_ps (_mm_loadu_ps (b.z + j), cz);
+    const __m128 dd = _mm_add_ps (_mm_add_ps (_mm_mul_ps (dx, dx), _mm_mul_ps (dy, dy)), _mm_mul_ps (dz, dz));
+    _mm_storeu_ps (d + j, abs4 (_mm_sub_ps (_mm_sqrt_ps (dd), r)));
+  }
+  sphereDistancesScalar (b, j, center, radius, d);
+}
+
+static void
+lineSqrDistancesSSE2 (const DistanceBlock &b, const float p[3], const float u[3], float *d)
+{
+  const __m128 px = _mm_set1_ps (p[0]), py = _mm_set1_ps (p[1]), pz = _mm_set1_ps (p[2]);
+  const __m128 ux = _mm_set1_ps (u[0]), uy = _mm_set1_ps (u[1]), uz = _mm_set1_ps (u[2]);
+  int j = 0;
+  for (; j + 4 <= b.size; j += 4)
+  {
+    const __m128 wx = _mm_sub_ps (px, _mm_loadu_ps (b.x + j));
+    const __m128 wy = _mm_sub_ps (py, _mm_loadu_ps (b.y + j));
+    const __m128 wz = _mm_sub_ps (pz, _mm_loadu_ps (b.z + j));
+    const __m128 cx = _mm_sub_ps (_mm_mul_ps (wy, uz), _mm_mul_ps (wz, uy));
+    const __m128 cy = _mm_sub_ps (_mm_mul_ps (wz, ux), _mm_mul_ps (wx, uz));
+    const __m128 cz = _mm_sub_ps (_mm_mul_ps (wx, uy), _mm_mul_ps (wy, ux));
+    _mm_storeu_ps (d + j, _mm_add_ps (_mm_add_ps (_mm_mul_ps (cx, cx), _mm_mul_ps (cy, cy)), _mm_mul_ps (cz, cz)));
+  }
+  lineSqrDistancesScalar (b, j, p, u, d);
+}
+
+static void
+normalPlaneDistancesSSE2 (const DistanceBlock &b, const float c[4], const float w, float *d)
+{
+  const __m128 c0 = _mm_set1_ps (c[0]), c1 = _mm_set1_ps (c[1]), c2 = _mm_set1_ps (c[2]), c3 = _mm_set1_ps (c[3]);
+  const __m128 cc = _mm_set1_ps (c[0] * c[0] + c[1] * c[1] + c[2] * c[2]);
+  const __m128 wn = _mm_set1_ps (w), we = _mm_set1_ps (1.0f - w);
+  int j = 0;
+  for (; j + 4 <= b.size; j += 4)
+  {
+    __m128 de = _mm_add_ps (_mm_mul_ps (c0, _mm_loadu_ps (b.x + j)), _mm_mul_ps (c1, _mm_loadu_ps (b.y + j)));
+    de = abs4 (_mm_add_ps (de, _mm_add_ps (_mm_mul_ps (c2, _mm_loadu_ps (b.z + j)), c3)));
+    const __m128 nx = _mm_loadu_ps (b.nx + j), ny = _mm_loadu_ps (b.ny + j), nz = _mm_loadu_ps (b.nz + j);
+    const __m128 nc = _mm_add_ps (_mm_add_ps (_mm_mul_ps (c0, nx), _mm_mul_ps (c1, ny)), _mm_mul_ps (c2, nz));
+    const __m128 nn = _mm_add_ps (_mm_add_ps (_mm_mul_ps (nx, nx), _mm_mul_ps (ny, ny)), _mm_mul_ps (nz, nz));
+    const __m128 dn = foldedAngle4 (_mm_div_ps (nc, _mm_sqrt_ps (_mm_mul_ps (nn, cc))));
+    _mm_storeu_ps (d + j, abs4 (_mm_add_ps (_mm_mul_ps (wn, dn), _mm_mul_ps (we, de))));
+  }
+  normalPlaneDistancesScalar (b, j, c, w, d);
+}
+
+static void
+cylinderDistancesSSE2 (const DistanceBlock &b, const float p[3], const float u[3], const float radius, const float w, float *d)
+{
+  const __m128 px = _mm_set1_ps (p[0]), py = _mm_set1_ps (p[1]), pz = _mm_set1_ps (p[2]);
+  const __m128 ux = _mm_set1_ps (u[0]), uy = _mm_set1_ps (u[1]), uz = _mm_set1_ps (u[2]);
+  const __m128 r = _mm_set1_ps (radius), wn = _mm_set1_ps (w), we = _mm_set1_ps (1.0f - w);
+  int j = 0;
+  for (; j + 4 <= b.size; j += 4)
+  {
+    const __m128 wx = _mm_sub_ps (_mm_loadu_ps (b.x + j), px);
+    const __m128 wy = _mm_sub_ps (_mm_loadu_ps (b.y + j), py);
+    const __m128 wz = _mm_sub_ps (_mm_loadu_ps (b.z + j), pz);
+    const __m128 k = _mm_add_ps (_mm_add_ps (_mm_mul_ps (wx, ux), _mm_mul_ps (wy, uy)), _mm_mul_ps (wz, uz));
+    const __m128 vx = _mm_sub_ps (wx, _mm_mul_ps (k, ux));
+    const __m128 vy = _mm_sub_ps (wy, _mm_mul_ps (k, uy));
+    const __m128 vz = _mm_sub_ps (wz, _mm_mul_ps (k, uz));
+    const __m128 vv = _mm_add_ps (_mm_add_ps (_mm_mul_ps (vx, vx), _mm_mul_ps (vy, vy)), _mm_mul_ps (vz, vz));
+    const __m128 de = abs4 (_mm_sub_ps (_mm_sqrt_ps (vv), r));
+    const __m128 nx = _mm_loadu_ps (b.nx + j), ny = _mm_loadu_ps (b.ny + j), nz = _mm_loadu_ps (b.nz + j);
+    const __m128 nv = _mm_add_ps (_mm_add_ps (_mm_mul_ps (nx, vx), _mm_mul_ps (ny, vy)), _mm_mul_ps (nz, vz));
+    const __m128 nn = _mm_add_ps (_mm_add_ps (_mm_mul_ps (nx, nx), _mm_mul_ps (ny, ny)), _mm_mul_ps (nz, nz));
+    const __m128 dn = foldedAngle4 (_mm_div_ps (nv, _mm_sqrt_ps (_mm_mul_ps (nn, vv))));
+    _mm_storeu_ps (d + j, abs4 (_mm_add_ps (_mm_mul_ps (wn, dn), _mm_mul_ps (we, de))));
+  }
+  cylinderDistancesScalar (b, j, p, u, radius, w, d);
+}
+#endif  // PCL_SAC_HAVE_SSE2
+
+#ifdef PCL_SAC_HAVE_AVX
+// The AVX kernels clear the upper halves of the YMM registers before calling the scalar kernels
+// on the last points, which are compiled without AVX (AVX to SSE transition penalty).
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+PCL_SAC_AVX_TARGET static inline __m256
+abs8 (const __m256 v)
+{
+  return (_mm256_andnot_ps (_mm256_set1_ps (-0.0f), v));
+}
+
+/** \brief AVX version of select4. _mm256_blendv_ps is not used, as some compilers expand it to
+  * scalar code when AVX2 is not enabled.
+  */
+PCL_SAC_AVX_TARGET static inline __m256
+select8 (const __m256 mask, const __m256 a, const __m256 b)
+{
+  return (_mm256_or_ps (_mm256_and_ps (mask, a), _mm256_andnot_ps (mask, b)));
+}
+
+/** \brief AVX version of foldedAngle. */
+PCL_SAC_AVX_TARGET static inline __m256
+foldedAngle8 (const __m256 c)
+{
+  const __m256 one = _mm256_set1_ps (1.0f), half = _mm256_set1_ps (0.5f);
+  // _mm256_min_ps returns its second operand if one of them is NaN, which propagates NaN cosines
+  const __m256 x = _mm256_min_ps (one, abs8 (c));
+  const __m256 big = _mm256_cmp_ps (x, half, _CMP_GT_OQ);
+  const __m256 z_big = _mm256_mul_ps (half, _mm256_sub_ps (one, x));
+  const __m256 z = select8 (big, z_big, _mm256_mul_ps (x, x));
+  const __m256 s = select8 (big, _mm256_sqrt_ps (z_big), x);
+  __m256 p = _mm256_add_ps (_mm256_mul_ps (_mm256_set1_ps (PCL_SAC_ASIN_P0), z), _mm256_set1_ps (PCL_SAC_ASIN_P1));
+  p = _mm256_add_ps (_mm256_mul_ps (p, z), _mm256_set1_ps (PCL_SAC_ASIN_P2));
+  p = _mm256_add_ps (_mm256_mul_ps (p, z), _mm256_set1_ps (PCL_SAC_ASIN_P3));
+  p = _mm256_add_ps (_mm256_mul_ps (p, z), _mm256_set1_ps (PCL_SAC_ASIN_P4));
+  p = _mm256_add_ps (_mm256_mul_ps (_mm256_mul_ps (p, z), s), s);
+  return (select8 (big, _mm256_add_ps (p, p), _mm256_sub_ps (_mm256_set1_ps (PCL_SAC_HALF_PI), p)));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+PCL_SAC_AVX_TARGET static void
+planeDistancesAVX (const DistanceBlock &b, const float c[4], float *d)
+{
+  const __m256 c0 = _mm256_set1_ps (c[0]), c1 = _mm256_set1_ps (c[1]), c2 = _mm256_set1_ps (c[2]), c3 = _mm256_set1_ps (c[3]);
+  int j = 0;
+  for (; j + 8 <= b.size; j += 8)
+  {
+    __m256 r = _mm256_add_ps (_mm256_mul_ps (c0, _mm256_loadu_ps (b.x + j)), _mm256_mul_ps (c1, _mm256_loadu_ps (b.y + j)));
+    r = _mm256_add_ps (r, _mm256_add_ps (_mm256_mul_ps (c2, _mm256_loadu_ps (b.z + j)), c3));
+    _mm256_storeu_ps (d + j, abs8 (r));
+  }
+  _mm256_zeroupper ();
+  planeDistancesScalar (b, j, c, d);
+}
+
+PCL_SAC_AVX_TARGET static void
+sphereDistancesAVX (const DistanceBlock &b, const float center[3], const float radius, float *d)
+{
+  const __m256 cx = _mm256_set1_ps (center[0]), cy = _mm256_set1_ps (center[1]), cz = _mm256_set1_ps (center[2]);
+  const __m256 r = _mm256_set1_ps (radius);
+  int j = 0;
+  for (; j + 8 <= b.size; j += 8)
+  {
+    const __m256 dx = _mm256_sub_ps (_mm256_loadu_ps (b.x + j), cx);
+    const __m256 dy = _mm256_sub_ps (_mm256_loadu_ps (b.y + j), cy);
+    const __m256 dz = _mm256_sub_ps (_mm256_loadu_ps (b.z + j), cz);
+    const __m256 dd = _mm256_add_ps (_mm256_add_ps (_mm256_mul_ps (dx, dx), _mm256_mul_ps (dy, dy)), _mm256_mul_ps (dz, dz));
+    _mm256_storeu_ps (d + j, abs8 (_mm256_sub_ps (_mm256_sqrt_ps (dd), r)));
+  }
+  _mm256_zeroupper ();
+  sphereDistancesScalar (b, j, center, radius, d);
+}
+
+PCL_SAC_AVX_TARGET static void
+lineSqrDistancesAVX (const DistanceBlock &b, const float p[3], const float u[3], float *d)
+{
+  const __m256 px = _mm256_set1_ps (p[0]), py = _mm256_set1_ps (p[1]), pz = _mm256_set1_ps (p[2]);
+  const __m256 ux = _mm256_set1_ps (u[0]), uy = _mm256_set1_ps (u[1]), uz = _mm256_set1_ps (u[2]);
+  int j = 0;
+  for (; j + 8 <= b.size; j += 8)
+  {
+    const __m256 wx = _mm256_sub_ps (px, _mm256_loadu_ps (b.x + j));
+    const __m256 wy = _mm256_sub_ps (py, _mm256_loadu_ps (b.y + j));
+    const __m256 wz = _mm256_sub_ps (pz, _mm256_loadu_ps (b.z + j));
+    const __m256 cx = _mm256_sub_ps (_mm256_mul_ps (wy, uz), _mm256_mul_ps (wz, uy));
+    const __m256 cy = _mm256_sub_ps (_mm256_mul_ps (wz, ux), _mm256_mul_ps (wx, uz));
+    const __m256 cz = _mm256_sub_ps (_mm256_mul_ps (wx, uy), _mm256_mul_ps (wy, ux));
+    _mm256_storeu_ps (d + j, _mm256_add_ps (_mm256_add_ps (_mm256_mul_ps (cx, cx), _mm256_mul_ps (cy, cy)), _mm256_mul_ps (cz, cz)));
+  }
+  _mm256_zeroupper ();
+  lineSqrDistancesScalar (b, j, p, u, d);
+}
+
+PCL_SAC_AVX_TARGET static void
+normalPlaneDistancesAVX (const DistanceBlock &b, const float c[4], const float w, float *d)
+{
+  const __m256 c0 = _mm256_set1_ps (c[0]), c1 = _mm256_set1_ps (c[1]), c2 = _mm256_set1_ps (c[2]), c3 = _mm256_set1_ps (c[3]);
+  const __m256 cc = _mm256_set1_ps (c[0] * c[0] + c[1] * c[1] + c[2] * c[2]);
+  const __m256 wn = _mm256_set1_ps (w), we = _mm256_set1_ps (1.0f - w);
+  int j = 0;
+  for (; j + 8 <= b.size; j += 8)
+  {
+    __m256 de = _mm256_add_ps (_mm256_mul_ps (c0, _mm256_loadu_ps (b.x + j)), _mm256_mul_ps (c1, _mm256_loadu_ps (b.y + j)));
+    de = abs8 (_mm256_add_ps (de, _mm256_add_ps (_mm256_mul_ps (c2, _mm256_loadu_ps (b.z + j)), c3)));
+    const __m256 nx = _mm256_loadu_ps (b.nx + j), ny = _mm256_loadu_ps (b.ny + j), nz = _mm256_loadu_ps (b.nz + j);
+    const __m256 nc = _mm256_add_ps (_mm256_add_ps (_mm256_mul_ps (c0, nx), _mm256_mul_ps (c1, ny)), _mm256_mul_ps (c2, nz));
+    const __m256 nn = _mm256_add_ps (_mm256_add_ps (_mm256_mul_ps (nx, nx), _mm256_mul_ps (ny, ny)), _mm256_mul_ps (nz, nz));
+    const __m256 dn = foldedAngle8 (_mm256_div_ps (nc, _mm256_sqrt_ps (_mm256_mul_ps (nn, cc))));
+    _mm256_storeu_ps (d + j, abs8 (_mm256_add_ps (_mm256_mul_ps (wn, dn), _mm256_mul_ps (we, de))));
+  }
+  _mm256_zeroupper ();
+  normalPlaneDistancesScalar (b, j, c, w, d);
+}
+
+PCL_SAC_AVX_TARGET static void
+cylinderDistancesAVX (const DistanceBlock &b, const float p[3], const float u[3], const float radius, const float w, float *d)
+{
+  const __m256 px = _mm256_set1_ps (p[0]), py = _mm256_set1_ps (p[1]), pz = _mm256_set1_ps (p[2]);
+  const __m256 ux = _mm256_set1_ps (u[0]), uy = _mm256_set1_ps (u[1]), uz = _mm256_set1_ps (u[2]);
+  const __m256 r = _mm256_set1_ps (radius), wn = _mm256_set1_ps (w), we = _mm256_set1_ps (1.0f - w);
+  int j = 0;
+  for (; j + 8 <= b.size; j += 8)
+  {
+    const __m256 wx = _mm256_sub_ps (_mm256_loadu_ps (b.x + j), px);
+    const __m256 wy = _mm256_sub_ps (_mm256_loadu_ps (b.y + j), py);
+    const __m256 wz = _mm256_sub_ps (_mm256_loadu_ps (b.z + j), pz);
+    const __m256 k = _mm256_add_ps (_mm256_add_ps (_mm256_mul_ps (wx, ux), _mm256_mul_ps (wy, uy)), _mm256_mul_ps (wz, uz));
+    const __m256 vx = _mm256_sub_ps (wx, _mm256_mul_ps (k, ux));
+    const __m256 vy = _mm256_sub_ps (wy, _mm256_mul_ps (k, uy));
+    const __m256 vz = _mm256_sub_ps (wz, _mm256_mul_ps (k, uz));
+    const __m256 vv = _mm256_add_ps (_mm256_add_ps (_mm256_mul_ps (vx, vx), _mm256_mul_ps (vy, vy)), _mm256_mul_ps (vz, vz));
+    const __m256 de = abs8 (_mm256_sub_ps (_mm256_sqrt_ps (vv), r));
+    const __m256 nx = _mm256_loadu_ps (b.nx + j), ny = _mm256_loadu_ps (b.ny + j), nz = _mm256_loadu_ps (b.nz + j);
+    const __m256 nv = _mm256_add_ps (_mm256_add_ps (_mm256_mul_ps (nx, vx), _mm256_mul_ps (ny, vy)), _mm256_mul_ps (nz, vz));
+    const __m256 nn = _mm256_add_ps (_mm256_add_ps (_mm256_mul_ps (nx, nx), _mm256_mul_ps (ny, ny)), _mm256_mul_ps (nz, nz));
+    const __m256 dn = foldedAngle8 (_mm256_div_ps (nv, _mm256_sqrt_ps (_mm256_mul_ps (nn, vv))));
+    _mm256_storeu_ps (d + j, abs8 (_mm256_add_ps (_mm256_mul_ps (wn, dn), _mm256_mul_ps (we, de))));
+  }
+  _mm256_zeroupper ();
+  cylinderDistancesScalar (b, j, p, u, radius, w, d);
+}
+#endif  // PCL_SAC_HAVE_AVX
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/** \brief Returns the best instruction set supported by both the build and the CPU. */
+static SimdLevel
+getSupportedSimdLevel ()
+{
+#ifdef PCL_SAC_HAVE_AVX
+#  if defined (_MSC_VER)
+  // AVX needs the CPU support (CPUID.1:ECX.AVX) and the OS support of the YMM registers (XGETBV)
+  int info[4];
+  __cpuid (info, 1);
+  if ((info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv (0) & 6) == 6)
+    return (pcl::sample_consensus::SIMD_AVX);
+#  else
+  __builtin_cpu_init ();
+  if (__builtin_cpu_supports ("avx"))
+    return (pcl::sample_consensus::SIMD_AVX);
+#  endif
+#endif
+#ifdef PCL_SAC_HAVE_SSE2
+  return (pcl::sample_consensus::SIMD_SSE2);
+#else
+  return (pcl::sample_consensus::SIMD_NONE);
+#endif
+}
+
+static SimdLevel simd_level = getSupportedSimdLevel ();
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+SimdLevel
+pcl::sample_consensus::getSimdLevel ()
+{
+  return (simd_level);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+SimdLevel
+pcl::sample_consensus::setSimdLevel (const SimdLevel level)
+{
+  const SimdLevel supported = getSupportedSimdLevel ();
+  simd_level = level < supported ? level : supported;
+  return (simd_level);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::sample_consensus::planeDistances (const DistanceBlock &block, const float coefficients[4], float *distances)
+{
+  switch (simd_level)
+  {
+#ifdef PCL_SAC_HAVE_AVX
+    case SIMD_AVX:
+      planeDistancesAVX (block, coefficients, distances);
+      break;
+#endif
+#ifdef PCL_SAC_HAVE_SSE2
+    case SIMD_SSE2:
+      planeDistancesSSE2 (block, coefficients, distances);
+      break;
+#endif
+    default:
+      planeDistancesScalar (block, 0, coefficients, distances);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::sample_consensus::sphereDistances (const DistanceBlock &block, const float center[3], const float radius, float *distances)
+{
+  switch (simd_level)
+  {
+#ifdef PCL_SAC_HAVE_AVX
+    case SIMD_AVX:
+      sphereDistancesAVX (block, center, radius, distances);
+      break;
+#endif
+#ifdef PCL_SAC_HAVE_SSE2
+    case SIMD_SSE2:
+      sphereDistancesSSE2 (block, center, radius, distances);
+      break;
+#endif
+    default:
+      sphereDistancesScalar (block, 0, center, radius, distances);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::sample_consensus::lineSqrDistances (const DistanceBlock &block, const float line_pt[3], const float line_dir[3], float *sqr_distances)
+{
+  switch (simd_level)
+  {
+#ifdef PCL_SAC_HAVE_AVX
+    case SIMD_AVX:
+      lineSqrDistancesAVX (block, line_pt, line_dir, sqr_distances);
+      break;
+#endif
+#ifdef PCL_SAC_HAVE_SSE2
+    case SIMD_SSE2:
+      lineSqrDistancesSSE2 (block, line_pt, line_dir, sqr_distances);
+      break;
+#endif
+    default:
+      lineSqrDistancesScalar (block, 0, line_pt, line_dir, sqr_distances);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::sample_consensus::normalPlaneDistances (const DistanceBlock &block, const float coefficients[4],
+                                             const float normal_distance_weight, float *distances)
+{
+  switch (simd_level)
+  {
+#ifdef PCL_SAC_HAVE_AVX
+    case SIMD_AVX:
+      normalPlaneDistancesAVX (block, coefficients, normal_distance_weight, distances);
+      break;
+#endif
+#ifdef PCL_SAC_HAVE_SSE2
+    case SIMD_SSE2:
+      normalPlaneDistancesSSE2 (block, coefficients, normal_distance_weight, distances);
+      break;
+#endif
+    default:
+      normalPlaneDistancesScalar (block, 0, coefficients, normal_distance_weight, distances);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl::sample_consensus::cylinderDistances (const DistanceBlock &block, const float line_pt[3], const float line_dir[3],
+                                          const float radius, const float normal_distance_weight, float *distances)
+{
+  switch (simd_level)
+  {
+#ifdef PCL_SAC_HAVE_AVX
+    case SIMD_AVX:
+      cylinderDistancesAVX (block, line_pt, line_dir, radius, normal_distance_weight, distances);
+      break;
+#endif
+#ifdef PCL_SAC_HAVE_SSE2
+    case SIMD_SSE2:
+      cylinderDistancesSSE2 (block, line_pt, line_dir, radius, normal_distance_weight, distances);
+      break;
+#endif
+    default:
+      cylinderDistancesScalar (block, 0, line_pt, line_dir, radius, normal_distance_weight, distances);
+  }
+}
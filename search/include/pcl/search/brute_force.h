@@ -122,7 +122,48 @@ namespace pcl
                       std::vector<int> &k_indices, std::vector<float> &k_sqr_distances,
                       unsigned int max_nn = 0) const;
 
+        /** \brief Search for the k-nearest neighbors of a batch of query points, in parallel. The neighbors are
+          * kept in the reused output buffers of each thread instead of a priority queue, so no memory is allocated
+          * per query point.
+          * \param[in] cloud the point cloud data
+          * \param[in] indices the indices in \a cloud of the query points. If indices is empty, neighbors will be searched for all points.
+          * \param[in] k the number of neighbors to search for
+          * \param[out] neighbors the neighbors of the query points, in the order of \a indices
+          * \note Query points with non finite coordinates get no neighbors.
+          */
+        void
+        batchNearestKSearch (const PointCloud &cloud, const std::vector<int> &indices, int k,
+                             BatchNeighbors &neighbors) const
+        {
+          this->batchSearch (BatchKSearch (*this, k), cloud, indices, neighbors);
+        }
+
       private:
+        /** \brief Calls the sorted k-nearest neighbor search of the brute force searcher. */
+        struct BatchKSearch
+        {
+          BatchKSearch (const BruteForce &searcher, int k) : searcher_ (searcher), k_ (k) {}
+
+          inline int
+          operator () (const PointT &point, std::vector<int> &k_indices, std::vector<float> &k_distances) const
+          {
+            return (searcher_.sortedKSearch (point, k_, k_indices, k_distances));
+          }
+
+          const BruteForce &searcher_;
+          int k_;
+        };
+
+        /** \brief Search for the k-nearest neighbors, inserting them directly in the sorted output buffers.
+          * \param[in] point the given query point
+          * \param[in] k the number of neighbors to search for
+          * \param[out] k_indices the resultant indices of the neighboring points
+          * \param[out] k_distances the resultant squared distances to the neighboring points
+          * \return number of neighbors found
+          */
+        int
+        sortedKSearch (const PointT &point, int k, std::vector<int> &k_indices, std::vector<float> &k_distances) const;
+
         int
         denseKSearch (const PointT &point, int k, std::vector<int> &k_indices, std::vector<float> &k_distances) const;
 
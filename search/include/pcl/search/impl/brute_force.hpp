@@ -214,6 +214,48 @@ pcl::search::BruteForce<PointT>::sparseKSearch (
   return (static_cast<int> (k_indices.size ()));
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::search::BruteForce<PointT>::sortedKSearch (
+    const PointT &point, int k, std::vector<int> &k_indices, std::vector<float> &k_distances) const
+{
+  if (k < 1)
+  {
+    k_indices.clear ();
+    k_distances.clear ();
+    return (0);
+  }
+
+  k_indices.resize (k);
+  k_distances.resize (k);
+  const int nr_points = static_cast<int> (indices_ != NULL ? indices_->size () : input_->size ());
+  int nr_neighbors = 0;
+  for (int i = 0; i < nr_points; ++i)
+  {
+    const int index = indices_ != NULL ? (*indices_)[i] : i;
+    if (!input_->is_dense && !pcl_isfinite (input_->points[index].x))
+      continue;
+
+    const float distance = getDistSqr (input_->points[index], point);
+    if (nr_neighbors == k && distance >= k_distances[k - 1])
+      continue;
+
+    // shift the farther neighbors to make room for the new one
+    int position = (nr_neighbors < k) ? nr_neighbors++ : k - 1;
+    for (; position > 0 && k_distances[position - 1] > distance; --position)
+    {
+      k_indices[position] = k_indices[position - 1];
+      k_distances[position] = k_distances[position - 1];
+    }
+    k_indices[position] = index;
+    k_distances[position] = distance;
+  }
+
+  k_indices.resize (nr_neighbors);
+  k_distances.resize (nr_neighbors);
+  return (nr_neighbors);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> int
 pcl::search::BruteForce<PointT>::denseRadiusSearch (
@@ -85,9 +85,10 @@ pcl::search::OrganizedNeighbor<PointT>::radiusSearch (const               PointT
   {
     for (; idx < xEnd; ++idx)
     {
-      if (!mask_[idx] || !isFinite (input_->points[idx]))
+      if (!mask_[idx])
         continue;
 
+      // non finite points give a NaN distance, which fails the comparison
       squared_distance = (input_->points[idx].getVector3fMap () - query.getVector3fMap ()).squaredNorm ();
       if (squared_distance <= squared_radius)
       {
@@ -114,6 +115,18 @@ pcl::search::OrganizedNeighbor<PointT>::nearestKSearch (const PointT &query,
                                                         int k,
                                                         std::vector<int> &k_indices,
                                                         std::vector<float> &k_sqr_distances) const
+{
+  std::vector<Entry> heap;
+  return (searchKNearest (query, k, heap, k_indices, k_sqr_distances));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> int
+pcl::search::OrganizedNeighbor<PointT>::searchKNearest (const PointT &query,
+                                                        int k,
+                                                        std::vector<Entry> &results,
+                                                        std::vector<int> &k_indices,
+                                                        std::vector<float> &k_sqr_distances) const
 {
   assert (isFinite (query) && "Invalid (NaN, Inf) point coordinates given to nearestKSearch!");
   if (k < 1)
@@ -136,9 +149,9 @@ pcl::search::OrganizedNeighbor<PointT>::nearestKSearch (const PointT &query,
   unsigned top = 0;
   unsigned bottom = input_->height - 1;
 
-  std::priority_queue <Entry> results;
-  //std::vector<Entry> k_results;
-  //k_results.reserve (k);
+  // max-heap on the distance, the farthest of the current k nearest neighbors on top
+  results.clear ();
+  results.reserve (k);
   // add point laying on the projection of the query point.
   if (xBegin >= 0 && 
       xBegin < static_cast<int> (input_->width) && 
@@ -236,7 +249,7 @@ pcl::search::OrganizedNeighbor<PointT>::nearestKSearch (const PointT &query,
       }
       // stop here means that the k-nearest neighbor changed -> recalculate bounding box of ellipse.
       if (stop)
-        getProjectedRadiusSearchBox (query, results.top ().distance, left, right, top, bottom);
+        getProjectedRadiusSearchBox (query, results.front ().distance, left, right, top, bottom);
       
     }
     // now we use it as stop flag -> if bounding box is completely within the already examined search box were done!
@@ -248,15 +261,14 @@ pcl::search::OrganizedNeighbor<PointT>::nearestKSearch (const PointT &query,
   } while (!stop);
 
   
+  // sorting the heap pops the neighbors in the same order as a priority queue would
+  std::sort_heap (results.begin (), results.end ());
   k_indices.resize (results.size ());
   k_sqr_distances.resize (results.size ());
-  size_t idx = results.size () - 1;
-  while (!results.empty ())
+  for (size_t idx = 0; idx < results.size (); ++idx)
   {
-    k_indices [idx] = results.top ().index;
-    k_sqr_distances [idx] = results.top ().distance;
-    results.pop ();
-    --idx;
+    k_indices [idx] = results [idx].index;
+    k_sqr_distances [idx] = results [idx].distance;
   }
   
   return (static_cast<int> (k_indices.size ()));
@@ -324,6 +336,108 @@ pcl::search::OrganizedNeighbor<PointT>::computeCameraMatrix (Eigen::Matrix3f& ca
   pcl::getCameraMatrixFromProjectionMatrix (projection_matrix_, camera_matrix);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> void
+pcl::search::OrganizedNeighbor<PointT>::setProjectionMatrix (const Eigen::Matrix<float, 3, 4, Eigen::RowMajor> &projection_matrix)
+{
+  projection_matrix_ = projection_matrix;
+  KR_ = projection_matrix_.topLeftCorner <3, 3> ();
+  KR_KRT_ = KR_ * KR_.transpose ();
+  fixed_projection_ = true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> void
+pcl::search::OrganizedNeighbor<PointT>::setCameraIntrinsics (float focal_length_x, float focal_length_y,
+                                                             float principal_point_x, float principal_point_y)
+{
+  Eigen::Matrix<float, 3, 4, Eigen::RowMajor> projection_matrix (Eigen::Matrix<float, 3, 4, Eigen::RowMajor>::Zero ());
+  projection_matrix.coeffRef (0, 0) = focal_length_x;
+  projection_matrix.coeffRef (0, 2) = principal_point_x;
+  projection_matrix.coeffRef (1, 1) = focal_length_y;
+  projection_matrix.coeffRef (1, 2) = principal_point_y;
+  projection_matrix.coeffRef (2, 2) = 1.0f;
+  setProjectionMatrix (projection_matrix);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template<typename PointT> template <typename SearchFunctorT> void
+pcl::search::OrganizedNeighbor<PointT>::tiledBatchSearch (const SearchFunctorT &search, const std::vector<int> &indices,
+                                                          BatchNeighbors &neighbors) const
+{
+  const int nr_queries = static_cast<int> (indices.empty () ? input_->points.size () : indices.size ());
+  const unsigned width = input_->width;
+  const unsigned tiles_x = (width + tile_size_ - 1) / tile_size_;
+  const unsigned tiles_y = (input_->height + tile_size_ - 1) / tile_size_;
+  const int nr_tiles = static_cast<int> (tiles_x * tiles_y);
+
+  // group the queries by tile (counting sort), keeping their order within a tile
+  std::vector<int> query_tile (nr_queries);
+  std::vector<int> tile_begin (nr_tiles + 1, 0);
+  for (int query = 0; query < nr_queries; ++query)
+  {
+    const unsigned idx = indices.empty () ? query : indices[query];
+    query_tile[query] = (idx / width / tile_size_) * tiles_x + (idx % width) / tile_size_;
+    ++tile_begin[query_tile[query] + 1];
+  }
+  for (int tile = 0; tile < nr_tiles; ++tile)
+    tile_begin[tile + 1] += tile_begin[tile];
+  std::vector<int> tile_queries (nr_queries);
+  std::vector<int> tile_fill (tile_begin.begin (), tile_begin.end () - 1);
+  for (int query = 0; query < nr_queries; ++query)
+    tile_queries[tile_fill[query_tile[query]]++] = query;
+
+  // offsets[query + 1] holds the number of neighbors of the query until the prefix sum below, and
+  // query_tile[query] is reused to hold the position of its neighbors in the buffers of its tile
+  neighbors.offsets.resize (nr_queries + 1);
+  neighbors.offsets[0] = 0;
+  std::vector<std::vector<int> > tile_indices (nr_tiles);
+  std::vector<std::vector<float> > tile_sqr_distances (nr_tiles);
+
+  std::vector<Entry> heap;
+  std::vector<int> k_indices;
+  std::vector<float> k_sqr_distances;
+#pragma omp parallel for schedule (dynamic) private (heap, k_indices, k_sqr_distances) num_threads (threads_)
+  for (int tile = 0; tile < nr_tiles; ++tile)
+  {
+    for (int i = tile_begin[tile]; i < tile_begin[tile + 1]; ++i)
+    {
+      const int query = tile_queries[i];
+      const PointT &point = input_->points[indices.empty () ? query : indices[query]];
+      int nr_neighbors = 0;
+      if (isFinite (point))
+      {
+        nr_neighbors = search (point, heap, k_indices, k_sqr_distances);
+        nr_neighbors = std::min (nr_neighbors, static_cast<int> (k_indices.size ()));
+      }
+
+      query_tile[query] = static_cast<int> (tile_indices[tile].size ());
+      tile_indices[tile].insert (tile_indices[tile].end (), k_indices.begin (), k_indices.begin () + nr_neighbors);
+      tile_sqr_distances[tile].insert (tile_sqr_distances[tile].end (), k_sqr_distances.begin (), k_sqr_distances.begin () + nr_neighbors);
+      neighbors.offsets[query + 1] = nr_neighbors;
+    }
+  }
+
+  for (int query = 0; query < nr_queries; ++query)
+    neighbors.offsets[query + 1] += neighbors.offsets[query];
+  neighbors.indices.resize (neighbors.offsets.back ());
+  neighbors.sqr_distances.resize (neighbors.offsets.back ());
+
+#pragma omp parallel for num_threads (threads_)
+  for (int tile = 0; tile < nr_tiles; ++tile)
+  {
+    for (int i = tile_begin[tile]; i < tile_begin[tile + 1]; ++i)
+    {
+      const int query = tile_queries[i];
+      const size_t nr_neighbors = neighbors.offsets[query + 1] - neighbors.offsets[query];
+      std::copy (tile_indices[tile].begin () + query_tile[query], tile_indices[tile].begin () + query_tile[query] + nr_neighbors,
+                 neighbors.indices.begin () + neighbors.offsets[query]);
+      std::copy (tile_sqr_distances[tile].begin () + query_tile[query], tile_sqr_distances[tile].begin () + query_tile[query] + nr_neighbors,
+                 neighbors.sqr_distances.begin () + neighbors.offsets[query]);
+    }
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 template<typename PointT> void
 pcl::search::OrganizedNeighbor<PointT>::estimateProjectionMatrix ()
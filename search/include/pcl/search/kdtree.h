@@ -72,6 +72,7 @@ namespace pcl
         using pcl::search::Search<PointT>::nearestKSearch;
         using pcl::search::Search<PointT>::radiusSearch;
         using pcl::search::Search<PointT>::sorted_results_;
+        using pcl::search::Search<PointT>::threads_;
 
         typedef boost::shared_ptr<KdTree<PointT> > Ptr;
         typedef boost::shared_ptr<const KdTree<PointT> > ConstPtr;
@@ -168,6 +169,74 @@ namespace pcl
           return (tree_->radiusSearch (point, radius, k_indices, k_sqr_distances, max_nn));
         }
 
+        /** \brief Search for the k-nearest neighbors of a batch of query points, with blocks of query points 
+          * given to FLANN at once.
+          * \param[in] cloud the point cloud data
+          * \param[in] indices the indices in \a cloud of the query points. If indices is empty, neighbors will be searched for all points.
+          * \param[in] k the number of neighbors to search for
+          * \param[out] neighbors the neighbors of the query points, in the order of \a indices
+          * \note Query points with non finite coordinates get no neighbors.
+          */
+        void
+        batchNearestKSearch (const PointCloud &cloud, const std::vector<int> &indices, int k,
+                             BatchNeighbors &neighbors) const
+        {
+          // FLANN expects finite query points, the non finite ones are left out of the FLANN batch
+          const int nr_queries = static_cast<int> (indices.empty () ? cloud.points.size () : indices.size ());
+          int nr_finite = 0;
+          for (int query = 0; query < nr_queries; ++query)
+            if (isFinite (cloud.points[indices.empty () ? query : indices[query]]))
+              ++nr_finite;
+
+          // the query indices are only copied when some of them have to be left out
+          std::vector<int> finite_queries;
+          if (nr_finite != nr_queries)
+          {
+            finite_queries.reserve (nr_finite);
+            for (int query = 0; query < nr_queries; ++query)
+            {
+              const int index = indices.empty () ? query : indices[query];
+              if (isFinite (cloud.points[index]))
+                finite_queries.push_back (index);
+            }
+          }
+          const std::vector<int> &queries = (nr_finite != nr_queries) ? finite_queries : indices;
+
+          // the neighbors are written in place, the buffers keep their capacity from one call to the next
+          const int nr_k = nr_finite == 0 ? 0 :
+                           tree_->batchNearestKSearch (cloud, queries, k, neighbors.indices, neighbors.sqr_distances, threads_);
+          if (nr_finite == 0)
+          {
+            neighbors.indices.clear ();
+            neighbors.sqr_distances.clear ();
+          }
+
+          neighbors.offsets.resize (nr_queries + 1);
+          neighbors.offsets[0] = 0;
+          for (int query = 0; query < nr_queries; ++query)
+          {
+            const bool valid = nr_finite == nr_queries || 
+                               isFinite (cloud.points[indices.empty () ? query : indices[query]]);
+            neighbors.offsets[query + 1] = neighbors.offsets[query] + (valid ? nr_k : 0);
+          }
+        }
+
+        /** \brief Search for all the nearest neighbors of a batch of query points in a given radius, in parallel.
+          * \param[in] cloud the point cloud data
+          * \param[in] indices the indices in \a cloud of the query points. If indices is empty, neighbors will be searched for all points.
+          * \param[in] radius the radius of the sphere bounding all of the neighbors
+          * \param[out] neighbors the neighbors of the query points, in the order of \a indices
+          * \param[in] max_nn if given, bounds the maximum returned neighbors of each query point to this value
+          * \note Query points with non finite coordinates get no neighbors.
+          */
+        void
+        batchRadiusSearch (const PointCloud &cloud, const std::vector<int> &indices, double radius,
+                           BatchNeighbors &neighbors, unsigned int max_nn = 0) const
+        {
+          this->batchSearch (typename Search<PointT>::template RadiusSearchFunctor<const pcl::KdTreeFLANN<PointT> > (*tree_, radius, max_nn),
+                             cloud, indices, neighbors);
+        }
+
       protected:
         /** \brief A pointer to the internal KdTreeFLANN object. */
         KdTreeFLANNPtr tree_;
@@ -173,6 +173,23 @@ namespace pcl
           return (tree_->nearestKSearch (index, k, k_indices, k_sqr_distances));
         }
 
+        /** \brief Search for the k-nearest neighbors of a batch of query points, in parallel. The octree is
+          * searched directly, without going through the virtual single point search.
+          * \param[in] cloud the point cloud data
+          * \param[in] indices the indices in \a cloud of the query points. If indices is empty, neighbors will be searched for all points.
+          * \param[in] k the number of neighbors to search for
+          * \param[out] neighbors the neighbors of the query points, in the order of \a indices
+          * \note Query points with non finite coordinates get no neighbors.
+          */
+        void
+        batchNearestKSearch (const PointCloud &cloud, const std::vector<int> &indices, int k,
+                             BatchNeighbors &neighbors) const
+        {
+          typedef pcl::octree::OctreePointCloudSearch<PointT, LeafTWrap, BranchTWrap> OctreeSearch;
+          this->batchSearch (typename Search<PointT>::template NearestKSearchFunctor<OctreeSearch> (*tree_, k),
+                             cloud, indices, neighbors);
+        }
+
         /** \brief search for all neighbors of query point that are within a given radius.
          * \param cloud the point cloud data
          * \param index the index in \a cloud representing the query point
@@ -76,6 +76,7 @@ namespace pcl
         using pcl::search::Search<PointT>::indices_;
         using pcl::search::Search<PointT>::sorted_results_;
         using pcl::search::Search<PointT>::input_;
+        using pcl::search::Search<PointT>::threads_;
 
         /** \brief Constructor
           * \param[in] sorted_results whether the results should be return sorted in ascending order on the distances or not.
@@ -93,6 +94,8 @@ namespace pcl
           , eps_ (eps)
           , pyramid_level_ (pyramid_level)
           , mask_ ()
+          , fixed_projection_ (false)
+          , tile_size_ (32)
         {
         }
 
@@ -120,6 +123,38 @@ namespace pcl
           */
         void 
         computeCameraMatrix (Eigen::Matrix3f& camera_matrix) const;
+
+        /** \brief Set the projection matrix of the device the input clouds come from. The matrix is then used for all
+          * the following input clouds, instead of being estimated from each of them in \ref setInputCloud.
+          * \param[in] projection_matrix the 3x4 projection matrix K * [R | t], mapping points to pixel coordinates
+          */
+        void
+        setProjectionMatrix (const Eigen::Matrix<float, 3, 4, Eigen::RowMajor> &projection_matrix);
+
+        /** \brief Set the intrinsic parameters of the camera the input clouds come from, given in the pixel coordinates
+          * of the clouds (i.e. scaled to the cloud resolution). The projection matrix is then K * [I | 0] for all the
+          * following input clouds, instead of being estimated from each of them in \ref setInputCloud.
+          * \param[in] focal_length_x the focal length in x direction, in pixels
+          * \param[in] focal_length_y the focal length in y direction, in pixels
+          * \param[in] principal_point_x the x coordinate of the principal point, in pixels
+          * \param[in] principal_point_y the y coordinate of the principal point, in pixels
+          */
+        void
+        setCameraIntrinsics (float focal_length_x, float focal_length_y, float principal_point_x, float principal_point_y);
+
+        /** \brief Go back to estimating the projection matrix from each input cloud. */
+        inline void
+        resetProjectionMatrix ()
+        {
+          fixed_projection_ = false;
+        }
+
+        /** \brief Returns true if the projection matrix was set by the user, false if it is estimated from the input clouds. */
+        inline bool
+        hasFixedProjectionMatrix () const
+        {
+          return (fixed_projection_);
+        }
         
         /** \brief Provide a pointer to the input data set, if user has focal length he must set it before calling this
           * \param[in] cloud the const boost shared pointer to a PointCloud message
@@ -143,7 +178,8 @@ namespace pcl
           else
             mask_.assign (input_->size (), 1);
 
-          estimateProjectionMatrix ();
+          if (!fixed_projection_)
+            estimateProjectionMatrix ();
         }
 
         /** \brief Search for all neighbors of query point that are within a given radius.
@@ -182,6 +218,61 @@ namespace pcl
                         std::vector<int> &k_indices,
                         std::vector<float> &k_sqr_distances) const;
 
+        /** \brief Search for the k-nearest neighbors of a batch of query points, in parallel.
+          * \param[in] cloud the point cloud data
+          * \param[in] indices the indices in \a cloud of the query points. If indices is empty, neighbors will be searched for all points.
+          * \param[in] k the number of neighbors to search for
+          * \param[out] neighbors the neighbors of the query points, in the order of \a indices
+          * \note Query points with non finite coordinates get no neighbors.
+          * \note If \a cloud is the input cloud, the queries are answered in one sweep over tiles of the image
+          * (see \ref setTileSize), so that neighboring queries share their search windows in the cache.
+          */
+        void
+        batchNearestKSearch (const PointCloud &cloud, const std::vector<int> &indices, int k,
+                             BatchNeighbors &neighbors) const
+        {
+          if (&cloud == input_.get ())
+            tiledBatchSearch (BatchKSearch (*this, k), indices, neighbors);
+          else
+            this->batchSearch (BatchKSearch (*this, k), cloud, indices, neighbors);
+        }
+
+        /** \brief Search for all the nearest neighbors of a batch of query points in a given radius, in parallel.
+          * \param[in] cloud the point cloud data
+          * \param[in] indices the indices in \a cloud of the query points. If indices is empty, neighbors will be searched for all points.
+          * \param[in] radius the radius of the sphere bounding all of the neighbors
+          * \param[out] neighbors the neighbors of the query points, in the order of \a indices
+          * \param[in] max_nn if given, bounds the maximum returned neighbors of each query point to this value
+          * \note Query points with non finite coordinates get no neighbors.
+          * \note If \a cloud is the input cloud, the queries are answered in one sweep over tiles of the image
+          * (see \ref setTileSize), so that neighboring queries share their search windows in the cache.
+          */
+        void
+        batchRadiusSearch (const PointCloud &cloud, const std::vector<int> &indices, double radius,
+                           BatchNeighbors &neighbors, unsigned int max_nn = 0) const
+        {
+          if (&cloud == input_.get ())
+            tiledBatchSearch (BatchRadiusSearch (*this, radius, max_nn), indices, neighbors);
+          else
+            this->batchSearch (BatchRadiusSearch (*this, radius, max_nn), cloud, indices, neighbors);
+        }
+
+        /** \brief Set the size of the square image tiles the batch searches over the input cloud are split into.
+          * \param[in] tile_size the width and height of a tile, in pixels
+          */
+        inline void
+        setTileSize (unsigned tile_size)
+        {
+          tile_size_ = std::max (tile_size, 1u);
+        }
+
+        /** \brief Get the size of the square image tiles the batch searches over the input cloud are split into. */
+        inline unsigned
+        getTileSize () const
+        {
+          return (tile_size_);
+        }
+
         /** \brief projects a point into the image
           * \param[in] p point in 3D World Coordinate Frame to be projected onto the image plane
           * \param[out] q the 2D projected point in pixel coordinates (u,v)
@@ -190,7 +281,6 @@ namespace pcl
         bool projectPoint (const PointT& p, pcl::PointXY& q) const;
         
       protected:
-
         struct Entry
         {
           Entry (int idx, float dist) : index (idx), distance (dist) {}
@@ -205,32 +295,109 @@ namespace pcl
           }
         };
 
+        /** \brief Calls the k-nearest neighbor search of the organized searcher without virtual dispatch. */
+        struct BatchKSearch
+        {
+          BatchKSearch (const OrganizedNeighbor &searcher, int k) : searcher_ (searcher), k_ (k) {}
+
+          inline int
+          operator () (const PointT &point, std::vector<int> &k_indices, std::vector<float> &k_sqr_distances) const
+          {
+            return (searcher_.OrganizedNeighbor<PointT>::nearestKSearch (point, k_, k_indices, k_sqr_distances));
+          }
+
+          inline int
+          operator () (const PointT &point, std::vector<Entry> &heap, std::vector<int> &k_indices,
+                       std::vector<float> &k_sqr_distances) const
+          {
+            return (searcher_.searchKNearest (point, k_, heap, k_indices, k_sqr_distances));
+          }
+
+          const OrganizedNeighbor &searcher_;
+          int k_;
+        };
+
+        /** \brief Calls the radius search of the organized searcher without virtual dispatch. */
+        struct BatchRadiusSearch
+        {
+          BatchRadiusSearch (const OrganizedNeighbor &searcher, double radius, unsigned int max_nn)
+            : searcher_ (searcher), radius_ (radius), max_nn_ (max_nn) {}
+
+          inline int
+          operator () (const PointT &point, std::vector<int> &k_indices, std::vector<float> &k_sqr_distances) const
+          {
+            return (searcher_.OrganizedNeighbor<PointT>::radiusSearch (point, radius_, k_indices, k_sqr_distances, max_nn_));
+          }
+
+          inline int
+          operator () (const PointT &point, std::vector<Entry> &, std::vector<int> &k_indices,
+                       std::vector<float> &k_sqr_distances) const
+          {
+            return (searcher_.OrganizedNeighbor<PointT>::radiusSearch (point, radius_, k_indices, k_sqr_distances, max_nn_));
+          }
+
+          const OrganizedNeighbor &searcher_;
+          double radius_;
+          unsigned int max_nn_;
+        };
+
         /** \brief test if point given by index is among the k NN in results to the query point.
           * \param[in] query query point
           * \param[in] k number of maximum nn interested in
-          * \param[in] queue priority queue with k NN
+          * \param[in,out] heap max-heap (on the distance) with the k NN found so far
           * \param[in] index index on point to be tested
-          * \return wheter the top element changed or not.
+          * \return wheter the top element changed or not (which includes the heap becoming full).
           */
         inline bool 
-        testPoint (const PointT& query, unsigned k, std::priority_queue<Entry>& queue, unsigned index) const
+        testPoint (const PointT& query, unsigned k, std::vector<Entry>& heap, unsigned index) const
         {
           const PointT& point = input_->points [index];
           if (mask_ [index] && pcl_isfinite (point.x))
           {
             float squared_distance = (point.getVector3fMap () - query.getVector3fMap ()).squaredNorm ();
-            if (queue.size () < k)
-              queue.push (Entry (index, squared_distance));
-            else if (queue.top ().distance > squared_distance)
+            if (heap.size () < k)
+            {
+              heap.push_back (Entry (index, squared_distance));
+              std::push_heap (heap.begin (), heap.end ());
+              // the k-th neighbor bounds the search box from now on
+              return (heap.size () == k);
+            }
+            else if (heap.front ().distance > squared_distance)
             {
-              queue.pop ();
-              queue.push (Entry (index, squared_distance));
+              std::pop_heap (heap.begin (), heap.end ());
+              heap.back () = Entry (index, squared_distance);
+              std::push_heap (heap.begin (), heap.end ());
               return true; // top element has changed!
             }
           }
           return false;
         }
 
+        /** \brief Search for the k-nearest neighbors for a given query point, using a caller provided heap, so that
+          * a sequence of searches does not allocate memory.
+          * \param[in] query the given query point
+          * \param[in] k the number of neighbors to search for
+          * \param[in,out] heap buffer for the k nearest neighbors found during the search
+          * \param[out] k_indices the resultant point indices
+          * \param[out] k_sqr_distances the resultant squared distances
+          * \return number of neighbors found
+          */
+        int
+        searchKNearest (const PointT &query, int k, std::vector<Entry> &heap,
+                        std::vector<int> &k_indices, std::vector<float> &k_sqr_distances) const;
+
+        /** \brief Answer a batch of queries on points of the input cloud in one parallel sweep over the tiles of
+          * the image. The queries are grouped by tile, each thread reuses its search buffers from one query
+          * to the next, and the results are gathered in compressed sparse row layout in the order of \a indices.
+          * The buffers grouping the queries by tile and the per tile result buffers belong to the call, so that
+          * several threads can run batch searches on the same object.
+          * \param[in] search the single point search, called as search (point, heap, k_indices, k_sqr_distances)
+          * \param[in] indices the indices in the input cloud of the query points (all the points if empty)
+          * \param[out] neighbors the neighbors of the query points
+          */
+        template <typename SearchFunctorT> void
+        tiledBatchSearch (const SearchFunctorT &search, const std::vector<int> &indices, BatchNeighbors &neighbors) const;
+
         inline void
         clipRange (int& begin, int &end, int min, int max) const
         {
@@ -268,6 +435,12 @@ namespace pcl
         
         /** \brief mask, indicating whether the point was in the indices list or not.*/
         std::vector<unsigned char> mask_;
+
+        /** \brief true if the projection matrix was set by the user and must not be estimated from the input clouds. */
+        bool fixed_projection_;
+
+        /** \brief width and height of the image tiles of the batch searches over the input cloud. */
+        unsigned tile_size_;
       public:
         EIGEN_MAKE_ALIGNED_OPERATOR_NEW
     };
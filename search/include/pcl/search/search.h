@@ -47,6 +47,39 @@ namespace pcl
 {
   namespace search
   {
+    /** \brief Neighbors of a batch of query points, stored in compressed sparse row layout: the neighbors of the
+      * i-th query point are indices[offsets[i]] to indices[offsets[i + 1] - 1], and their squared distances are
+      * stored at the same positions in sqr_distances.
+      * \ingroup search
+      */
+    struct BatchNeighbors
+    {
+      BatchNeighbors () : offsets (1, 0), indices (), sqr_distances () {}
+
+      /** \brief Returns the number of query points. */
+      inline size_t
+      size () const
+      {
+        return (offsets.empty () ? 0 : offsets.size () - 1);
+      }
+
+      /** \brief Returns the number of neighbors found for a query point.
+        * \param[in] query the position of the query point in the batch
+        */
+      inline int
+      getNumberOfNeighbors (size_t query) const
+      {
+        return (static_cast<int> (offsets[query + 1] - offsets[query]));
+      }
+
+      /** \brief Position of the first neighbor of each query point, followed by the total number of neighbors. */
+      std::vector<size_t> offsets;
+      /** \brief Indices of the neighbors, query after query. */
+      std::vector<int> indices;
+      /** \brief Squared distances to the neighbors, query after query. */
+      std::vector<float> sqr_distances;
+    };
+
     /** \brief Generic search class. All search wrappers must inherit from this.
       *
       * Each search method must implement 2 different types of search:
@@ -89,6 +122,7 @@ namespace pcl
           , indices_ ()
           , sorted_results_ (sorted)
           , name_ (name)
+          , threads_ (0)
         {
         }
 
@@ -115,6 +149,15 @@ namespace pcl
         {
           sorted_results_ = sorted;
         }
+
+        /** \brief Set the number of threads used by the batch searches.
+          * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+          */
+        inline void
+        setNumberOfThreads (unsigned int nr_threads = 0)
+        {
+          threads_ = nr_threads;
+        }
         
         /** \brief Pass the input dataset that the search will be performed on.
           * \param[in] cloud a const pointer to the PointCloud data
@@ -475,12 +518,96 @@ namespace pcl
           }
         }
 
+        /** \brief Search for the k-nearest neighbors of a batch of query points, in parallel.
+          * The results of all the query points are stored in a single set of flat buffers, which can be reused
+          * from one call to the next without reallocating.
+          * \param[in] cloud the point cloud data
+          * \param[in] indices the indices in \a cloud of the query points. If indices is empty, neighbors will be searched for all points.
+          * \param[in] k the number of neighbors to search for
+          * \param[out] neighbors the neighbors of the query points, in the order of \a indices
+          * \note Query points with non finite coordinates get no neighbors.
+          */
+        virtual void
+        batchNearestKSearch (const PointCloud &cloud, const std::vector<int> &indices, int k,
+                             BatchNeighbors &neighbors) const
+        {
+          batchSearch (NearestKSearchFunctor<const Search<PointT> > (*this, k), cloud, indices, neighbors);
+        }
+
+        /** \brief Search for all the nearest neighbors of a batch of query points in a given radius, in parallel.
+          * The results of all the query points are stored in a single set of flat buffers, which can be reused
+          * from one call to the next without reallocating.
+          * \param[in] cloud the point cloud data
+          * \param[in] indices the indices in \a cloud of the query points. If indices is empty, neighbors will be searched for all points.
+          * \param[in] radius the radius of the sphere bounding all of the neighbors
+          * \param[out] neighbors the neighbors of the query points, in the order of \a indices
+          * \param[in] max_nn if given, bounds the maximum returned neighbors of each query point to this value. If \a max_nn
+          * is set to 0 or to a number higher than the number of points in the input cloud, all neighbors in \a radius will
+          * be returned.
+          * \note Query points with non finite coordinates get no neighbors.
+          */
+        virtual void
+        batchRadiusSearch (const PointCloud &cloud, const std::vector<int> &indices, double radius,
+                           BatchNeighbors &neighbors, unsigned int max_nn = 0) const
+        {
+          batchSearch (RadiusSearchFunctor<const Search<PointT> > (*this, radius, max_nn), cloud, indices, neighbors);
+        }
+
       protected:
+        /** \brief Calls the k-nearest neighbor search of a searcher, for a fixed k. */
+        template <typename SearcherT>
+        struct NearestKSearchFunctor
+        {
+          NearestKSearchFunctor (SearcherT &searcher, int k) : searcher_ (searcher), k_ (k) {}
+
+          inline int
+          operator () (const PointT &point, std::vector<int> &k_indices, std::vector<float> &k_sqr_distances) const
+          {
+            return (searcher_.nearestKSearch (point, k_, k_indices, k_sqr_distances));
+          }
+
+          SearcherT &searcher_;
+          int k_;
+        };
+
+        /** \brief Calls the radius search of a searcher, for a fixed radius. */
+        template <typename SearcherT>
+        struct RadiusSearchFunctor
+        {
+          RadiusSearchFunctor (SearcherT &searcher, double radius, unsigned int max_nn) 
+            : searcher_ (searcher), radius_ (radius), max_nn_ (max_nn) {}
+
+          inline int
+          operator () (const PointT &point, std::vector<int> &k_indices, std::vector<float> &k_sqr_distances) const
+          {
+            return (searcher_.radiusSearch (point, radius_, k_indices, k_sqr_distances, max_nn_));
+          }
+
+          SearcherT &searcher_;
+          double radius_;
+          unsigned int max_nn_;
+        };
+
+        /** \brief Run a single point search over a batch of query points, in parallel, and gather the results
+          * in compressed sparse row layout. The queries are processed in blocks, each block appending its
+          * results to its own buffers, which are then copied at their final position.
+          * \param[in] search the single point search, called as search (point, k_indices, k_sqr_distances)
+          * \param[in] cloud the point cloud data
+          * \param[in] indices the indices in \a cloud of the query points (all the points of \a cloud if empty)
+          * \param[out] neighbors the neighbors of the query points
+          */
+        template <typename SearchFunctorT> void
+        batchSearch (const SearchFunctorT &search, const PointCloud &cloud, const std::vector<int> &indices,
+                     BatchNeighbors &neighbors) const;
+
         void sortResults (std::vector<int>& indices, std::vector<float>& distances) const;
         PointCloudConstPtr input_;
         IndicesConstPtr indices_;
         bool sorted_results_;
         std::string name_;
+
+        /** \brief The number of threads used by the batch searches. */
+        unsigned int threads_;
         
       private:
         struct Compare
@@ -519,6 +646,56 @@ namespace pcl
       // sort  the according distances.
       sort (distances.begin (), distances.end ());
     }
+
+    template<typename PointT> template <typename SearchFunctorT> void
+    Search<PointT>::batchSearch (const SearchFunctorT &search, const PointCloud &cloud,
+                                 const std::vector<int> &indices, BatchNeighbors &neighbors) const
+    {
+      const int nr_queries = static_cast<int> (indices.empty () ? cloud.points.size () : indices.size ());
+      const int block_size = 256;
+      const int nr_blocks = (nr_queries + block_size - 1) / block_size;
+
+      // offsets[query + 1] holds the number of neighbors of the query until the prefix sum below
+      neighbors.offsets.resize (nr_queries + 1);
+      neighbors.offsets[0] = 0;
+      std::vector<std::vector<int> > block_indices (nr_blocks);
+      std::vector<std::vector<float> > block_sqr_distances (nr_blocks);
+
+      std::vector<int> k_indices;
+      std::vector<float> k_sqr_distances;
+#pragma omp parallel for schedule (dynamic) private (k_indices, k_sqr_distances) num_threads (threads_)
+      for (int block = 0; block < nr_blocks; ++block)
+      {
+        const int end = std::min ((block + 1) * block_size, nr_queries);
+        for (int query = block * block_size; query < end; ++query)
+        {
+          const PointT &point = cloud.points[indices.empty () ? query : indices[query]];
+          int nr_neighbors = 0;
+          if (isFinite (point))
+          {
+            nr_neighbors = search (point, k_indices, k_sqr_distances);
+            nr_neighbors = std::min (nr_neighbors, static_cast<int> (k_indices.size ()));
+          }
+
+          block_indices[block].insert (block_indices[block].end (), k_indices.begin (), k_indices.begin () + nr_neighbors);
+          block_sqr_distances[block].insert (block_sqr_distances[block].end (), k_sqr_distances.begin (), k_sqr_distances.begin () + nr_neighbors);
+          neighbors.offsets[query + 1] = nr_neighbors;
+        }
+      }
+
+      for (int query = 0; query < nr_queries; ++query)
+        neighbors.offsets[query + 1] += neighbors.offsets[query];
+      neighbors.indices.resize (neighbors.offsets.back ());
+      neighbors.sqr_distances.resize (neighbors.offsets.back ());
+
+#pragma omp parallel for num_threads (threads_)
+      for (int block = 0; block < nr_blocks; ++block)
+      {
+        const size_t offset = neighbors.offsets[block * block_size];
+        std::copy (block_indices[block].begin (), block_indices[block].end (), neighbors.indices.begin () + offset);
+        std::copy (block_sqr_distances[block].begin (), block_sqr_distances[block].end (), neighbors.sqr_distances.begin () + offset);
+      }
+    }
   } // namespace search
 } // namespace pcl
 
@@ -81,6 +81,27 @@ namespace pcl
       const boost::shared_ptr<search::Search<PointT> > &tree, float tolerance, std::vector<PointIndices> &clusters, 
       unsigned int min_pts_per_cluster = 1, unsigned int max_pts_per_cluster = (std::numeric_limits<int>::max) ());
 
+  //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  /** \brief Decompose a region of space into clusters based on the Euclidean distance between points, without a
+    * spatial locator. The points are bucketed in a voxel hash, and the neighboring voxels are merged in parallel
+    * with a lock-free union-find. The clusters are the same as the ones of the functions above, in the same order.
+    * \param cloud the point cloud message
+    * \param indices a list of point indices to use from \a cloud
+    * \param tolerance the spatial cluster tolerance as a measure in L2 Euclidean space
+    * \param clusters the resultant clusters containing point indices (as a vector of PointIndices)
+    * \param min_pts_per_cluster minimum number of points that a cluster may contain (default: 1)
+    * \param max_pts_per_cluster maximum number of points that a cluster may contain (default: max int)
+    * \param nr_threads the number of threads to use (default: 0, automatic)
+    * \note the points with non finite coordinates are not part of any cluster
+    * \ingroup segmentation
+    */
+  template <typename PointT> void 
+  extractEuclideanClustersVoxelHash (
+      const PointCloud<PointT> &cloud, const std::vector<int> &indices, 
+      float tolerance, std::vector<PointIndices> &clusters, 
+      unsigned int min_pts_per_cluster = 1, unsigned int max_pts_per_cluster = (std::numeric_limits<int>::max) (),
+      unsigned int nr_threads = 0);
+
   //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
   /** \brief Decompose a region of space into clusters based on the euclidean distance between points, and the normal
     * angular deviation
@@ -312,7 +333,9 @@ namespace pcl
       EuclideanClusterExtraction () : tree_ (), 
                                       cluster_tolerance_ (0),
                                       min_pts_per_cluster_ (1), 
-                                      max_pts_per_cluster_ (std::numeric_limits<int>::max ())
+                                      max_pts_per_cluster_ (std::numeric_limits<int>::max ()),
+                                      use_voxel_hash_ (false),
+                                      threads_ (0)
       {};
 
       /** \brief Provide a pointer to the search object.
@@ -381,6 +404,32 @@ namespace pcl
         return (max_pts_per_cluster_); 
       }
 
+      /** \brief Set whether the clusters are extracted with extractEuclideanClustersVoxelHash (a voxel hash and a
+        * parallel union-find) instead of growing them with radius searches. The search method is not used then.
+        * \param[in] use_voxel_hash true to use the voxel hash clustering (default: false)
+        */
+      inline void 
+      setUseVoxelHash (bool use_voxel_hash) 
+      { 
+        use_voxel_hash_ = use_voxel_hash; 
+      }
+
+      /** \brief Get whether the clusters are extracted with the voxel hash clustering. */
+      inline bool 
+      getUseVoxelHash () const 
+      { 
+        return (use_voxel_hash_); 
+      }
+
+      /** \brief Set the number of threads used by the voxel hash clustering.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      inline void 
+      setNumberOfThreads (unsigned int nr_threads = 0) 
+      { 
+        threads_ = nr_threads; 
+      }
+
       /** \brief Cluster extraction in a PointCloud given by <setInputCloud (), setIndices ()>
         * \param[out] clusters the resultant point clusters
         */
@@ -406,6 +455,12 @@ namespace pcl
       /** \brief The maximum number of points that a cluster needs to contain in order to be considered valid (default = MAXINT). */
       int max_pts_per_cluster_;
 
+      /** \brief Whether the clusters are extracted with the voxel hash clustering (default = false). */
+      bool use_voxel_hash_;
+
+      /** \brief The number of threads used by the voxel hash clustering (default = 0, automatic). */
+      unsigned int threads_;
+
       /** \brief Class getName method. */
       virtual std::string getClassName () const { return ("EuclideanClusterExtraction"); }
 
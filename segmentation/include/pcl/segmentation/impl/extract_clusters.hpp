@@ -39,6 +39,9 @@
 #define PCL_SEGMENTATION_IMPL_EXTRACT_CLUSTERS_H_
 
 #include <pcl/segmentation/extract_clusters.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT> void
@@ -198,6 +201,273 @@ pcl::extractEuclideanClusters (const PointCloud<PointT> &cloud,
   }
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+namespace pcl
+{
+  namespace detail
+  {
+    /** \brief Replace *value by new_value if it is equal to old_value, atomically.
+      * \return true if the value was replaced
+      */
+    inline bool
+    compareAndSwap (volatile int *value, int old_value, int new_value)
+    {
+#ifdef _MSC_VER
+      return (_InterlockedCompareExchange (reinterpret_cast<volatile long*> (value), new_value, old_value) == old_value);
+#else
+      return (__sync_bool_compare_and_swap (value, old_value, new_value));
+#endif
+    }
+
+    /** \brief Find the root of the set of an element in a union-find forest shared by several threads, halving
+      * the path on the way. Each element points to a smaller one, so the root is the smallest element of its set.
+      */
+    inline int
+    findRoot (volatile int *parents, int i)
+    {
+      int parent = parents[i];
+      while (parent != i)
+      {
+        const int grand_parent = parents[parent];
+        if (grand_parent != parent)
+          compareAndSwap (parents + i, parent, grand_parent);
+        i = parent;
+        parent = parents[i];
+      }
+      return (i);
+    }
+
+    /** \brief Merge the sets of two elements in a union-find forest shared by several threads. The root with the
+      * largest index is linked to the other one, and the link is retried if another thread changed the roots.
+      */
+    inline void
+    unionSets (volatile int *parents, int a, int b)
+    {
+      for (;;)
+      {
+        a = findRoot (parents, a);
+        b = findRoot (parents, b);
+        if (a == b)
+          return;
+        if (a > b)
+          std::swap (a, b);
+        if (compareAndSwap (parents + b, b, a))
+          return;
+      }
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::extractEuclideanClustersVoxelHash (const PointCloud<PointT> &cloud, 
+                                        const std::vector<int> &indices,
+                                        float tolerance, std::vector<PointIndices> &clusters,
+                                        unsigned int min_pts_per_cluster, 
+                                        unsigned int max_pts_per_cluster,
+                                        unsigned int nr_threads)
+{
+  if (tolerance <= 0)
+  {
+    PCL_ERROR ("[pcl::extractEuclideanClustersVoxelHash] Invalid cluster tolerance (%f)!\n", tolerance);
+    return;
+  }
+  const int nr_points = static_cast<int> (indices.size ());
+  if (nr_points == 0)
+    return;
+
+  // The voxels are half the tolerance wide, so that all the points of a voxel belong to the same cluster
+  const float voxel_size = 0.5f * tolerance;
+  const float inverse_voxel_size = 1.0f / voxel_size;
+  const float sqr_tolerance = tolerance * tolerance;
+
+  std::vector<int> voxel_coordinates (3 * nr_points);
+  std::vector<char> valid (nr_points);
+#pragma omp parallel for schedule (static) num_threads (nr_threads)
+  for (int i = 0; i < nr_points; ++i)
+  {
+    const PointT &p = cloud.points[indices[i]];
+    valid[i] = pcl_isfinite (p.x) && pcl_isfinite (p.y) && pcl_isfinite (p.z);
+    if (!valid[i])
+      continue;
+    voxel_coordinates[3 * i + 0] = static_cast<int> (floor (p.x * inverse_voxel_size));
+    voxel_coordinates[3 * i + 1] = static_cast<int> (floor (p.y * inverse_voxel_size));
+    voxel_coordinates[3 * i + 2] = static_cast<int> (floor (p.z * inverse_voxel_size));
+  }
+
+  Eigen::Vector3i min_voxel ((std::numeric_limits<int>::max) (), (std::numeric_limits<int>::max) (), (std::numeric_limits<int>::max) ());
+  Eigen::Vector3i max_voxel = -min_voxel;
+  int nr_valid = 0;
+  for (int i = 0; i < nr_points; ++i)
+  {
+    if (!valid[i])
+      continue;
+    const Eigen::Map<const Eigen::Vector3i> v (&voxel_coordinates[3 * i]);
+    min_voxel = min_voxel.cwiseMin (v);
+    max_voxel = max_voxel.cwiseMax (v);
+    ++nr_valid;
+  }
+  if (nr_valid == 0)
+    return;
+
+  // Voxel keys, with a margin of two voxels on each side so that the keys of the neighbors are always valid
+  min_voxel -= Eigen::Vector3i::Constant (2);
+  const uint64_t size_y = static_cast<uint64_t> (static_cast<int64_t> (max_voxel[1]) - min_voxel[1] + 3);
+  const uint64_t size_z = static_cast<uint64_t> (static_cast<int64_t> (max_voxel[2]) - min_voxel[2] + 3);
+  const double size_x = static_cast<double> (static_cast<int64_t> (max_voxel[0]) - min_voxel[0] + 3);
+  if (size_x * static_cast<double> (size_y) * static_cast<double> (size_z) > static_cast<double> ((std::numeric_limits<int64_t>::max) ()))
+  {
+    PCL_ERROR ("[pcl::extractEuclideanClustersVoxelHash] Cluster tolerance (%f) too small for the extent of the input cloud!\n", tolerance);
+    return;
+  }
+
+  std::vector<std::pair<uint64_t, int> > keys;
+  keys.reserve (nr_valid);
+  for (int i = 0; i < nr_points; ++i)
+  {
+    if (!valid[i])
+      continue;
+    const uint64_t x = voxel_coordinates[3 * i + 0] - min_voxel[0];
+    const uint64_t y = voxel_coordinates[3 * i + 1] - min_voxel[1];
+    const uint64_t z = voxel_coordinates[3 * i + 2] - min_voxel[2];
+    keys.push_back (std::make_pair ((x * size_y + y) * size_z + z, i));
+  }
+  std::sort (keys.begin (), keys.end ());
+
+  // Group the points by voxel, and copy their coordinates in that order
+  std::vector<uint64_t> voxel_keys;
+  std::vector<int> voxel_begin;
+  std::vector<float> xyz (3 * nr_valid);
+  for (int k = 0; k < nr_valid; ++k)
+  {
+    if (k == 0 || keys[k].first != keys[k - 1].first)
+    {
+      voxel_keys.push_back (keys[k].first);
+      voxel_begin.push_back (k);
+    }
+    const PointT &p = cloud.points[indices[keys[k].second]];
+    xyz[3 * k + 0] = p.x;
+    xyz[3 * k + 1] = p.y;
+    xyz[3 * k + 2] = p.z;
+  }
+  const int nr_voxels = static_cast<int> (voxel_keys.size ());
+  voxel_begin.push_back (nr_valid);
+
+  // The union-find forest is over the positions in indices. The points of a voxel are linked to the first of
+  // them, which represents the voxel. The bounding boxes of the voxels are used to skip the points too far away.
+  std::vector<int> parents (nr_points);
+  std::vector<float> voxel_boxes (6 * nr_voxels);
+#pragma omp parallel for schedule (static) num_threads (nr_threads)
+  for (int i = 0; i < nr_points; ++i)
+    parents[i] = i;
+#pragma omp parallel for schedule (static) num_threads (nr_threads)
+  for (int v = 0; v < nr_voxels; ++v)
+  {
+    float *box = &voxel_boxes[6 * v];
+    box[0] = box[3] = xyz[3 * voxel_begin[v] + 0];
+    box[1] = box[4] = xyz[3 * voxel_begin[v] + 1];
+    box[2] = box[5] = xyz[3 * voxel_begin[v] + 2];
+    for (int k = voxel_begin[v] + 1; k < voxel_begin[v + 1]; ++k)
+    {
+      // keys are sorted by position for the same voxel, so the first point has the smallest position
+      parents[keys[k].second] = keys[voxel_begin[v]].second;
+      for (int d = 0; d < 3; ++d)
+      {
+        box[d] = (std::min) (box[d], xyz[3 * k + d]);
+        box[d + 3] = (std::max) (box[d + 3], xyz[3 * k + d]);
+      }
+    }
+  }
+
+  // Merge each voxel with its neighbors within two voxels that come after it in the key order
+  volatile int *forest = &parents[0];
+#pragma omp parallel for schedule (dynamic, 64) num_threads (nr_threads)
+  for (int v = 0; v < nr_voxels; ++v)
+  {
+    const int representative = keys[voxel_begin[v]].second;
+    for (int dx = 0; dx <= 2; ++dx)
+    {
+      for (int dy = (dx == 0 ? 0 : -2); dy <= 2; ++dy)
+      {
+        // the voxels with the same x and y are contiguous in the key order
+        const uint64_t column_key = voxel_keys[v] + (static_cast<uint64_t> (dx) * size_y + dy) * size_z;
+        int w;
+        if (dx == 0 && dy == 0)
+          w = v + 1;
+        else
+          w = static_cast<int> (std::lower_bound (voxel_keys.begin () + v + 1, voxel_keys.end (), column_key - 2) - voxel_keys.begin ());
+        for (; w < nr_voxels && voxel_keys[w] <= column_key + 2; ++w)
+        {
+          const int other = keys[voxel_begin[w]].second;
+          if (pcl::detail::findRoot (forest, representative) == pcl::detail::findRoot (forest, other))
+            continue;
+
+          // Both voxels are connected sets, so the first pair of points within the tolerance merges them
+          const float *box = &voxel_boxes[6 * w];
+          bool linked = false;
+          for (int a = voxel_begin[v]; a < voxel_begin[v + 1] && !linked; ++a)
+          {
+            const float *pa = &xyz[3 * a];
+            const float bx = (std::max) ((std::max) (box[0] - pa[0], pa[0] - box[3]), 0.0f);
+            const float by = (std::max) ((std::max) (box[1] - pa[1], pa[1] - box[4]), 0.0f);
+            const float bz = (std::max) ((std::max) (box[2] - pa[2], pa[2] - box[5]), 0.0f);
+            if (bx * bx + by * by + bz * bz > sqr_tolerance)
+              continue;
+            for (int b = voxel_begin[w]; b < voxel_begin[w + 1]; ++b)
+            {
+              const float *pb = &xyz[3 * b];
+              const float ex = pa[0] - pb[0], ey = pa[1] - pb[1], ez = pa[2] - pb[2];
+              if (ex * ex + ey * ey + ez * ez <= sqr_tolerance)
+              {
+                pcl::detail::unionSets (forest, representative, other);
+                linked = true;
+                break;
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // Each point is linked to a smaller position, so the labels can be propagated in one pass. The clusters are
+  // numbered by their smallest position, which is the order in which extractEuclideanClusters finds them.
+  std::vector<int> labels (nr_points, -1);
+  std::vector<int> cluster_sizes;
+  for (int i = 0; i < nr_points; ++i)
+  {
+    if (!valid[i])
+      continue;
+    if (parents[i] == i)
+    {
+      labels[i] = static_cast<int> (cluster_sizes.size ());
+      cluster_sizes.push_back (0);
+    }
+    else
+      labels[i] = labels[parents[i]];
+    ++cluster_sizes[labels[i]];
+  }
+
+  std::vector<PointIndices> all_clusters (cluster_sizes.size ());
+  for (size_t c = 0; c < all_clusters.size (); ++c)
+    all_clusters[c].indices.reserve (cluster_sizes[c]);
+  for (int i = 0; i < nr_points; ++i)
+    if (labels[i] >= 0)
+      all_clusters[labels[i]].indices.push_back (indices[i]);
+
+  for (size_t c = 0; c < all_clusters.size (); ++c)
+  {
+    std::vector<int> &r = all_clusters[c].indices;
+    std::sort (r.begin (), r.end ());
+    r.erase (std::unique (r.begin (), r.end ()), r.end ());
+    if (r.size () < min_pts_per_cluster || r.size () > max_pts_per_cluster)
+      continue;
+    clusters.push_back (PointIndices ());
+    clusters.back ().header = cloud.header;
+    clusters.back ().indices.swap (r);
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -213,6 +483,14 @@ pcl::EuclideanClusterExtraction<PointT>::extract (std::vector<PointIndices> &clu
     return;
   }
 
+  if (use_voxel_hash_)
+  {
+    extractEuclideanClustersVoxelHash (*input_, *indices_, static_cast<float> (cluster_tolerance_), clusters, min_pts_per_cluster_, max_pts_per_cluster_, threads_);
+    std::sort (clusters.rbegin (), clusters.rend (), comparePointClusters);
+    deinitCompute ();
+    return;
+  }
+
   // Initialize the spatial locator
   if (!tree_)
   {
@@ -238,5 +516,6 @@ pcl::EuclideanClusterExtraction<PointT>::extract (std::vector<PointIndices> &clu
 #define PCL_INSTANTIATE_EuclideanClusterExtraction(T) template class PCL_EXPORTS pcl::EuclideanClusterExtraction<T>;
 #define PCL_INSTANTIATE_extractEuclideanClusters(T) template void PCL_EXPORTS pcl::extractEuclideanClusters<T>(const pcl::PointCloud<T> &, const boost::shared_ptr<pcl::search::Search<T> > &, float , std::vector<pcl::PointIndices> &, unsigned int, unsigned int);
 #define PCL_INSTANTIATE_extractEuclideanClusters_indices(T) template void PCL_EXPORTS pcl::extractEuclideanClusters<T>(const pcl::PointCloud<T> &, const std::vector<int> &, const boost::shared_ptr<pcl::search::Search<T> > &, float , std::vector<pcl::PointIndices> &, unsigned int, unsigned int);
+#define PCL_INSTANTIATE_extractEuclideanClustersVoxelHash(T) template void PCL_EXPORTS pcl::extractEuclideanClustersVoxelHash<T>(const pcl::PointCloud<T> &, const std::vector<int> &, float , std::vector<pcl::PointIndices> &, unsigned int, unsigned int, unsigned int);
 
 #endif        // PCL_EXTRACT_CLUSTERS_IMPL_H_
@@ -41,11 +41,12 @@
 #include <pcl/common/vector_average.h>
 #include <pcl/Vertices.h>
 #include <pcl/kdtree/kdtree_flann.h>
+#include <pcl/surface/impl/vertex_welding.hpp>
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointNT>
 pcl::MarchingCubes<PointNT>::MarchingCubes () 
-: min_p_ (), max_p_ (), percentage_extend_grid_ (), iso_level_ ()
+: min_p_ (), max_p_ (), percentage_extend_grid_ (), iso_level_ (), weld_vertices_ (false)
 {
 }
 
@@ -260,6 +261,13 @@ pcl::MarchingCubes<PointNT>::performReconstruction (pcl::PolygonMesh &output)
         getNeighborList1D (leaf_node, index_3d);
         createSurface (leaf_node, index_3d, cloud);
       }
+
+  if (weld_vertices_)
+  {
+    getWelding ().weld (cloud, output);
+    return;
+  }
+
   pcl::toROSMsg (cloud, output.cloud);
 
   output.polygons.resize (cloud.size () / 3);
@@ -313,6 +321,14 @@ pcl::MarchingCubes<PointNT>::performReconstruction (pcl::PointCloud<PointNT> &po
         createSurface (leaf_node, index_3d, points);
       }
 
+  if (weld_vertices_)
+  {
+    pcl::PointCloud<PointNT> triangles;
+    triangles.swap (points);
+    getWelding ().weld (triangles, points, polygons);
+    return;
+  }
+
   polygons.resize (points.size () / 3);
   for (size_t i = 0; i < polygons.size (); ++i)
   {
@@ -325,6 +341,18 @@ pcl::MarchingCubes<PointNT>::performReconstruction (pcl::PointCloud<PointNT> &po
 }
 
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointNT> pcl::VertexWelding<PointNT>
+pcl::MarchingCubes<PointNT>::getWelding () const
+{
+  // Grid node (x, y, z) lies at min_p_ + (x / res_x_, y / res_y_, z / res_z_) * (max_p_ - min_p_), see createSurface
+  Eigen::Vector3f cell_size ((max_p_[0] - min_p_[0]) / float (res_x_),
+                             (max_p_[1] - min_p_[1]) / float (res_y_),
+                             (max_p_[2] - min_p_[2]) / float (res_z_));
+  pcl::VertexWelding<PointNT> welding;
+  welding.setGrid (min_p_.head<3> (), cell_size);
+  return (welding);
+}
 
 #define PCL_INSTANTIATE_MarchingCubes(T) template class PCL_EXPORTS pcl::MarchingCubes<T>;
 
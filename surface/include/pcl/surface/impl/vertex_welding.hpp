@@ -0,0 +1,222 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_SURFACE_IMPL_VERTEX_WELDING_H_
+#define PCL_SURFACE_IMPL_VERTEX_WELDING_H_
+
+#include <pcl/surface/vertex_welding.h>
+#include <pcl/ros/conversions.h>
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_map.hpp>
+#include <cstring>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> size_t
+pcl::VertexWelding<PointT>::VertexKeyHash::operator () (const VertexKey &key) const
+{
+  size_t seed = 0;
+  for (int i = 0; i < 4; ++i)
+    boost::hash_combine (seed, key.k[i]);
+  return (seed);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::VertexWelding<PointT>::computeKey (const PointT &point, VertexKey &key) const
+{
+  if (!use_grid_)
+  {
+    // adding 0 turns -0 into 0, so both are merged as with operator ==
+    const float xyz[3] = {point.x + 0.0f, point.y + 0.0f, point.z + 0.0f};
+    memcpy (key.k, xyz, sizeof (xyz));
+    key.k[3] = 0;
+    return;
+  }
+
+  // Vertices closer than this to a grid node (in cells) are identified by the node
+  const float node_tolerance = 1e-3f;
+
+  // The edge axis is the one along which the vertex is the farthest from a node
+  const float xyz[3] = {point.x, point.y, point.z};
+  float g[3];
+  int nearest[3];
+  int axis = 3;
+  float max_distance = node_tolerance;
+  for (int a = 0; a < 3; ++a)
+  {
+    g[a] = (xyz[a] - grid_origin_[a]) / grid_cell_size_[a];
+    nearest[a] = static_cast<int> (floor (g[a] + 0.5f));
+    const float distance = fabsf (g[a] - static_cast<float> (nearest[a]));
+    if (distance > max_distance)
+    {
+      max_distance = distance;
+      axis = a;
+    }
+  }
+
+  for (int a = 0; a < 3; ++a)
+    key.k[a] = (a == axis) ? static_cast<int> (floor (g[a])) : nearest[a];
+  key.k[3] = axis;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> int
+pcl::VertexWelding<PointT>::getNumberOfThreads () const
+{
+#ifdef _OPENMP
+  return (threads_ == 0 ? omp_get_num_procs () : static_cast<int> (threads_));
+#else
+  return (1);
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::VertexWelding<PointT>::weld (const PointCloud &triangles, PointCloud &vertices, std::vector<pcl::Vertices> &polygons) const
+{
+  typedef boost::unordered_map<VertexKey, int, VertexKeyHash> VertexMap;
+
+  const int nr_points = static_cast<int> (triangles.points.size () - triangles.points.size () % 3);
+  const int nr_shards = getNumberOfThreads ();
+
+  // Identify every point of the soup, and the shard it belongs to
+  std::vector<VertexKey> keys (nr_points);
+  std::vector<int> shards (nr_points, 0);
+  VertexKeyHash hasher;
+#pragma omp parallel for num_threads(nr_shards)
+  for (int i = 0; i < nr_points; ++i)
+  {
+    computeKey (triangles.points[i], keys[i]);
+    if (nr_shards > 1)
+      shards[i] = static_cast<int> (hasher (keys[i]) % nr_shards);
+  }
+
+  // Bucket the points by shard, in increasing order within each shard
+  std::vector<int> shard_begin (nr_shards + 1, 0);
+  std::vector<int> order;
+  if (nr_shards > 1)
+  {
+    for (int i = 0; i < nr_points; ++i)
+      ++shard_begin[shards[i] + 1];
+    for (int s = 0; s < nr_shards; ++s)
+      shard_begin[s + 1] += shard_begin[s];
+
+    std::vector<int> position (shard_begin.begin (), shard_begin.end () - 1);
+    order.resize (nr_points);
+    for (int i = 0; i < nr_points; ++i)
+      order[position[shards[i]]++] = i;
+  }
+  else
+    shard_begin[1] = nr_points;
+
+  // Every shard numbers its vertices in order of first occurrence
+  std::vector<int> ids (nr_points);
+  std::vector<std::vector<int> > first_points (nr_shards);
+#pragma omp parallel for schedule(static, 1) num_threads(nr_shards)
+  for (int s = 0; s < nr_shards; ++s)
+  {
+    VertexMap map;
+    // a closed marching cubes surface has about 6 soup points per vertex
+    map.rehash ((shard_begin[s + 1] - shard_begin[s]) / 6 + 1);
+    for (int j = shard_begin[s]; j < shard_begin[s + 1]; ++j)
+    {
+      const int i = order.empty () ? j : order[j];
+      std::pair<typename VertexMap::iterator, bool> res = map.insert (std::make_pair (keys[i], static_cast<int> (first_points[s].size ())));
+      if (res.second)
+        first_points[s].push_back (i);
+      ids[i] = res.first->second;
+    }
+  }
+  std::vector<VertexKey> ().swap (keys);
+
+  std::vector<int> offsets (nr_shards + 1, 0);
+  for (int s = 0; s < nr_shards; ++s)
+    offsets[s + 1] = offsets[s] + static_cast<int> (first_points[s].size ());
+
+  vertices.header = triangles.header;
+  vertices.points.resize (offsets[nr_shards]);
+  vertices.width = static_cast<uint32_t> (vertices.points.size ());
+  vertices.height = 1;
+  vertices.is_dense = triangles.is_dense;
+#pragma omp parallel for schedule(static, 1) num_threads(nr_shards)
+  for (int s = 0; s < nr_shards; ++s)
+    for (size_t j = 0; j < first_points[s].size (); ++j)
+      vertices.points[offsets[s] + j] = triangles.points[first_points[s][j]];
+
+  const int nr_triangles = nr_points / 3;
+  const int second = reverse_orientation_ ? 2 : 1;
+  const int third = reverse_orientation_ ? 1 : 2;
+  polygons.resize (nr_triangles);
+#pragma omp parallel for num_threads(nr_shards)
+  for (int t = 0; t < nr_triangles; ++t)
+  {
+    polygons[t].vertices.resize (3);
+    polygons[t].vertices[0] = offsets[shards[t * 3]] + ids[t * 3];
+    polygons[t].vertices[1] = offsets[shards[t * 3 + second]] + ids[t * 3 + second];
+    polygons[t].vertices[2] = offsets[shards[t * 3 + third]] + ids[t * 3 + third];
+  }
+
+  // Drop the triangles collapsed on an edge by the welding
+  size_t nr_polygons = 0;
+  for (size_t t = 0; t < polygons.size (); ++t)
+  {
+    const std::vector<uint32_t> &v = polygons[t].vertices;
+    if (v[0] == v[1] || v[1] == v[2] || v[2] == v[0])
+      continue;
+    if (t != nr_polygons)
+      polygons[nr_polygons].vertices.swap (polygons[t].vertices);
+    ++nr_polygons;
+  }
+  polygons.resize (nr_polygons);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT> void
+pcl::VertexWelding<PointT>::weld (const PointCloud &triangles, pcl::PolygonMesh &mesh) const
+{
+  PointCloud vertices;
+  weld (triangles, vertices, mesh.polygons);
+  pcl::toROSMsg (vertices, mesh.cloud);
+  mesh.header = triangles.header;
+}
+
+#define PCL_INSTANTIATE_VertexWelding(T) template class PCL_EXPORTS pcl::VertexWelding<T>;
+
+#endif  // PCL_SURFACE_IMPL_VERTEX_WELDING_H_
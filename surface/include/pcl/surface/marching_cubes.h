@@ -38,6 +38,7 @@
 
 #include <pcl/surface/boost.h>
 #include <pcl/surface/reconstruction.h>
+#include <pcl/surface/vertex_welding.h>
 
 namespace pcl
 {
@@ -427,6 +428,19 @@ namespace pcl
       getPercentageExtendGrid ()
       { return percentage_extend_grid_; }
 
+      /** \brief Method that sets whether the triangles should share their vertices. By default every triangle has its
+        * own three vertices. When set, the vertices are welded by the grid edge they lie on (see pcl::VertexWelding).
+        * \param[in] weld_vertices true to output an indexed mesh with shared vertices
+        */
+      inline void
+      setWeldVertices (bool weld_vertices)
+      { weld_vertices_ = weld_vertices; }
+
+      /** \brief Method that returns whether the triangles share their vertices. */
+      inline bool
+      getWeldVertices ()
+      { return weld_vertices_; }
+
     protected:
       /** \brief The data structure storing the 3D grid */
       std::vector<float> grid_;
@@ -444,6 +458,9 @@ namespace pcl
       /** \brief The iso level to be extracted. */
       float iso_level_;
 
+      /** \brief Whether the vertices of the triangles are welded. */
+      bool weld_vertices_;
+
       /** \brief Convert the point cloud into voxel data. */
       virtual void
       voxelizeData () = 0;
@@ -488,6 +505,10 @@ namespace pcl
       getNeighborList1D (std::vector<float> &leaf,
                          Eigen::Vector3i &index3d);
 
+      /** \brief Returns a VertexWelding set up with the grid of the marching cubes. */
+      pcl::VertexWelding<PointNT>
+      getWelding () const;
+
       /** \brief Class get name method. */
       std::string getClassName () const { return ("MarchingCubes"); }
 
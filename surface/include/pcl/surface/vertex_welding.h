@@ -0,0 +1,173 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Point Cloud Library (PCL) - www.pointclouds.org
+ *  Copyright (c) 2012-, Open Perception, Inc.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder(s) nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_SURFACE_VERTEX_WELDING_H_
+#define PCL_SURFACE_VERTEX_WELDING_H_
+
+#include <pcl/point_cloud.h>
+#include <pcl/PolygonMesh.h>
+#include <pcl/Vertices.h>
+#include <boost/shared_ptr.hpp>
+#include <Eigen/Core>
+
+namespace pcl
+{
+  /** \brief VertexWelding merges the duplicated vertices of a triangle soup (three consecutive points per triangle,
+    * as produced by marching cubes) into an indexed mesh, in a single pass over the soup.
+    *
+    * By default, vertices are merged when their coordinates are equal. When the grid of the marching cubes is given
+    * with \ref setGrid, every vertex is identified by the grid edge it lies on instead (or by the grid node, when it lies
+    * on a node). This merges the copies of a vertex computed by neighbouring cells even when they differ in the last bits.
+    *
+    * The soup can be split in several shards processed in parallel. With a single thread, the vertices are output in
+    * the order of their first occurrence in the soup. Triangles that collapse on an edge are dropped.
+    *
+    * \ingroup surface
+    */
+  template <typename PointT>
+  class VertexWelding
+  {
+    public:
+      typedef boost::shared_ptr<VertexWelding<PointT> > Ptr;
+      typedef boost::shared_ptr<const VertexWelding<PointT> > ConstPtr;
+
+      typedef pcl::PointCloud<PointT> PointCloud;
+
+      /** \brief Constructor.
+        * \param[in] nr_threads the number of threads to use (0 sets the value back to automatic)
+        */
+      VertexWelding (unsigned int nr_threads = 1)
+        : use_grid_ (false)
+        , grid_origin_ (Eigen::Vector3f::Zero ())
+        , grid_cell_size_ (Eigen::Vector3f::Ones ())
+        , reverse_orientation_ (false)
+        , threads_ (nr_threads)
+      {}
+
+      /** \brief Identify the vertices by the edge of the marching cubes grid they lie on.
+        * \param[in] origin position of the grid node (0, 0, 0)
+        * \param[in] cell_size distance between two grid nodes, on each axis
+        */
+      inline void
+      setGrid (const Eigen::Vector3f &origin, const Eigen::Vector3f &cell_size)
+      {
+        use_grid_ = true;
+        grid_origin_ = origin;
+        grid_cell_size_ = cell_size;
+      }
+
+      /** \brief Merge the vertices having the same coordinates (default). */
+      inline void
+      resetGrid ()
+      { use_grid_ = false; }
+
+      /** \brief Output the triangles with the vertices 0, 2, 1 of the soup, as the meshes of the GPU marching cubes.
+        * \param[in] reverse true to reverse the orientation of the triangles
+        */
+      inline void
+      setReverseOrientation (bool reverse)
+      { reverse_orientation_ = reverse; }
+
+      /** \brief Initialize the scheduler and set the number of threads to use.
+        * \param[in] nr_threads the number of hardware threads to use (0 sets the value back to automatic)
+        */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads = 0)
+      { threads_ = nr_threads; }
+
+      /** \brief Weld a triangle soup.
+        * \param[in] triangles the triangle soup, three consecutive points per triangle
+        * \param[out] vertices the welded vertices
+        * \param[out] polygons the triangles, indexing the welded vertices
+        */
+      void
+      weld (const PointCloud &triangles, PointCloud &vertices, std::vector<pcl::Vertices> &polygons) const;
+
+      /** \brief Weld a triangle soup into a PolygonMesh.
+        * \param[in] triangles the triangle soup, three consecutive points per triangle
+        * \param[out] mesh the welded mesh
+        */
+      void
+      weld (const PointCloud &triangles, pcl::PolygonMesh &mesh) const;
+
+    protected:
+      /** \brief Identifier of a welded vertex: the bits of its coordinates, or its grid edge (three node coordinates and an axis, 3 for a node). */
+      struct VertexKey
+      {
+        int k[4];
+
+        inline bool
+        operator == (const VertexKey &other) const
+        { return (k[0] == other.k[0] && k[1] == other.k[1] && k[2] == other.k[2] && k[3] == other.k[3]); }
+      };
+
+      /** \brief Hash functor of a VertexKey. */
+      struct VertexKeyHash
+      {
+        size_t
+        operator () (const VertexKey &key) const;
+      };
+
+      /** \brief Compute the identifier of a vertex.
+        * \param[in] point the vertex
+        * \param[out] key its identifier
+        */
+      void
+      computeKey (const PointT &point, VertexKey &key) const;
+
+      /** \brief Returns the number of threads to use. */
+      int
+      getNumberOfThreads () const;
+
+      /** \brief Whether the vertices are identified by their grid edge. */
+      bool use_grid_;
+
+      /** \brief Position of the grid node (0, 0, 0). */
+      Eigen::Vector3f grid_origin_;
+
+      /** \brief Distance between two grid nodes, on each axis. */
+      Eigen::Vector3f grid_cell_size_;
+
+      /** \brief Whether the triangles are output as 0, 2, 1. */
+      bool reverse_orientation_;
+
+      /** \brief The number of threads the scheduler should use. */
+      unsigned int threads_;
+  };
+}
+
+#endif  // PCL_SURFACE_VERTEX_WELDING_H_
@@ -490,6 +490,186 @@ TEST (PCL, IINormalEstimationSimple3DGradient)
   }
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// A wavy surface with a depth step and a few invalid points
+void
+createWaveCloud (PointCloud<PointXYZ> &wave, unsigned width, unsigned height, float phase)
+{
+  wave.width = width;
+  wave.height = height;
+  wave.points.resize (width * height);
+  wave.is_dense = false;
+  for (unsigned v = 0; v < height; ++v)
+  {
+    for (unsigned u = 0; u < width; ++u)
+    {
+      wave (u, v).x = static_cast<float> (u) * 0.01f;
+      wave (u, v).y = static_cast<float> (v) * 0.01f;
+      wave (u, v).z = 2.0f + 0.1f * sinf (static_cast<float> (u) * 0.1f + phase) * cosf (static_cast<float> (v) * 0.07f);
+      if (u > width / 2)
+        wave (u, v).z += 0.5f;
+      if ((u * 7 + v * 13) % 97 == 0)
+        wave (u, v).z = numeric_limits<float>::quiet_NaN ();
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+expectSameNormals (const PointCloud<Normal> &a, const PointCloud<Normal> &b)
+{
+  ASSERT_EQ (a.points.size (), b.points.size ());
+  int nr_differences = 0;
+  for (size_t i = 0; i < a.points.size (); ++i)
+  {
+    for (int d = 0; d < 4; ++d)
+    {
+      const float va = (d < 3) ? a.points[i].normal[d] : a.points[i].curvature;
+      const float vb = (d < 3) ? b.points[i].normal[d] : b.points[i].curvature;
+      if (pcl_isfinite (va) != pcl_isfinite (vb) || (pcl_isfinite (va) && va != vb))
+        ++nr_differences;
+    }
+  }
+  EXPECT_EQ (nr_differences, 0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, IINormalEstimationStreaming)
+{
+  typedef IntegralImageNormalEstimation<PointXYZ, Normal> IINormalEstimation;
+  const IINormalEstimation::NormalEstimationMethod methods[] =
+    { IINormalEstimation::COVARIANCE_MATRIX, IINormalEstimation::AVERAGE_3D_GRADIENT,
+      IINormalEstimation::AVERAGE_DEPTH_CHANGE, IINormalEstimation::SIMPLE_3D_GRADIENT };
+
+  PointCloud<PointXYZ>::Ptr large (new PointCloud<PointXYZ>);
+  PointCloud<PointXYZ>::Ptr small (new PointCloud<PointXYZ>);
+  PointCloud<PointXYZ>::Ptr large2 (new PointCloud<PointXYZ>);
+  createWaveCloud (*large, 160, 120, 0.0f);
+  createWaveCloud (*small, 64, 48, 0.5f);
+  createWaveCloud (*large2, 160, 120, 1.0f);
+
+  for (int m = 0; m < 4; ++m)
+  {
+    for (int policy = 0; policy < 2; ++policy)
+    {
+      if (methods[m] == IINormalEstimation::SIMPLE_3D_GRADIENT && policy == 1)
+        continue;
+
+      // the same estimator is used for a stream of frames, with a change of resolution
+      IINormalEstimation streaming;
+      streaming.setNormalEstimationMethod (methods[m]);
+      streaming.setBorderPolicy (policy == 0 ? IINormalEstimation::BORDER_POLICY_IGNORE : IINormalEstimation::BORDER_POLICY_MIRROR);
+      streaming.setMaxDepthChangeFactor (0.02f);
+      streaming.setNormalSmoothingSize (10.0f);
+      streaming.setNumberOfThreads (4);
+
+      PointCloud<PointXYZ>::Ptr frames[] = { large, small, large2 };
+      for (int f = 0; f < 3; ++f)
+      {
+        PointCloud<Normal> output, reference;
+        streaming.setInputCloud (frames[f]);
+        streaming.compute (output);
+
+        // a fresh, single threaded estimator
+        IINormalEstimation single;
+        single.setNormalEstimationMethod (methods[m]);
+        single.setBorderPolicy (policy == 0 ? IINormalEstimation::BORDER_POLICY_IGNORE : IINormalEstimation::BORDER_POLICY_MIRROR);
+        single.setMaxDepthChangeFactor (0.02f);
+        single.setNormalSmoothingSize (10.0f);
+        single.setNumberOfThreads (1);
+        single.setInputCloud (frames[f]);
+        single.compute (reference);
+
+        EXPECT_EQ (output.width, frames[f]->width);
+        EXPECT_EQ (output.height, frames[f]->height);
+        expectSameNormals (output, reference);
+
+        double integral_images_time, distance_map_time, normals_time;
+        streaming.getTimings (integral_images_time, distance_map_time, normals_time);
+        EXPECT_GE (integral_images_time, 0.0);
+        EXPECT_GE (distance_map_time, 0.0);
+        EXPECT_GE (normals_time, 0.0);
+      }
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// The normals of the integral images against sums computed pixel by pixel over each rectangle
+TEST (PCL, IINormalEstimationBoxSum)
+{
+  typedef IntegralImageNormalEstimation<PointXYZ, Normal> IINormalEstimation;
+  const int width = 80, height = 60, rect_size = 10;
+
+  // a smooth wave, so that no depth change shrinks the rectangles
+  PointCloud<PointXYZ>::Ptr wave (new PointCloud<PointXYZ>);
+  wave->width = width;
+  wave->height = height;
+  wave->points.resize (width * height);
+  for (int v = 0; v < height; ++v)
+  {
+    for (int u = 0; u < width; ++u)
+    {
+      (*wave) (u, v).x = static_cast<float> (u) * 0.01f;
+      (*wave) (u, v).y = static_cast<float> (v) * 0.01f;
+      (*wave) (u, v).z = 2.0f + 0.1f * sinf (static_cast<float> (u) * 0.1f) * cosf (static_cast<float> (v) * 0.07f);
+    }
+  }
+
+  for (int m = 0; m < 2; ++m)
+  {
+    for (int threads = 1; threads <= 4; threads += 3)
+    {
+      IINormalEstimation estimation;
+      estimation.setNormalEstimationMethod (m == 0 ? IINormalEstimation::COVARIANCE_MATRIX : IINormalEstimation::AVERAGE_3D_GRADIENT);
+      estimation.setBorderPolicy (IINormalEstimation::BORDER_POLICY_IGNORE);
+      estimation.setMaxDepthChangeFactor (0.02f);
+      estimation.setNormalSmoothingSize (static_cast<float> (rect_size));
+      estimation.setNumberOfThreads (threads);
+      estimation.setInputCloud (wave);
+      PointCloud<Normal> output;
+      estimation.compute (output);
+
+      for (int v = rect_size; v < height - rect_size; ++v)
+      {
+        for (int u = rect_size; u < width - rect_size; ++u)
+        {
+          Eigen::Vector3d sum (Eigen::Vector3d::Zero ()), gradient_x (Eigen::Vector3d::Zero ()), gradient_y (Eigen::Vector3d::Zero ());
+          Eigen::Matrix3d second_order (Eigen::Matrix3d::Zero ());
+          for (int y = v - rect_size / 2; y < v - rect_size / 2 + rect_size; ++y)
+          {
+            for (int x = u - rect_size / 2; x < u - rect_size / 2 + rect_size; ++x)
+            {
+              const Eigen::Vector3d point = (*wave) (x, y).getVector3fMap ().cast<double> ();
+              sum += point;
+              second_order += point * point.transpose ();
+              gradient_x += ((*wave) (x + 1, y).getVector3fMap () - (*wave) (x - 1, y).getVector3fMap ()).cast<double> ();
+              gradient_y += ((*wave) (x, y + 1).getVector3fMap () - (*wave) (x, y - 1).getVector3fMap ()).cast<double> ();
+            }
+          }
+
+          Eigen::Vector3f normal;
+          if (m == 0)
+          {
+            const Eigen::Vector3f center = sum.cast<float> ();
+            Eigen::Matrix3f covariance_matrix = second_order.cast<float> ();
+            covariance_matrix -= (center * center.transpose ()) / static_cast<float> (rect_size * rect_size);
+            float eigen_value;
+            eigen33 (covariance_matrix, eigen_value, normal);
+          }
+          else
+            normal = gradient_y.cross (gradient_x).normalized ().cast<float> ();
+          flipNormalTowardsViewpoint ((*wave) (u, v), 0.0f, 0.0f, 0.0f, normal[0], normal[1], normal[2]);
+
+          EXPECT_NEAR (output (u, v).normal_x, normal[0], 1e-3);
+          EXPECT_NEAR (output (u, v).normal_y, normal[1], 1e-3);
+          EXPECT_NEAR (output (u, v).normal_z, normal[2], 1e-3);
+        }
+      }
+    }
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (PCL, IINormalEstimationSimple3DGradientUnorganized)
 {
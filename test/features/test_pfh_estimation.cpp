@@ -41,6 +41,7 @@
 #include <pcl/point_cloud.h>
 #include <pcl/features/normal_3d.h>
 #include <pcl/features/pfh.h>
+#include <pcl/features/pfh_omp.h>
 #include <pcl/features/fpfh.h>
 #include <pcl/features/fpfh_omp.h>
 #include <pcl/features/vfh.h>
@@ -499,6 +500,134 @@ TEST (PCL, FPFHEstimationOpenMP)
   (cloud.makeShared (), normals, test_indices, 33);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, FPFHEstimationOpenMPCache)
+{
+  PointCloud<PointXYZ>::Ptr points (new PointCloud<PointXYZ> (cloud));
+  NormalEstimation<PointXYZ, Normal> n;
+  PointCloud<Normal>::Ptr normals (new PointCloud<Normal> ());
+  n.setInputCloud (points);
+  n.setSearchMethod (search::KdTree<PointXYZ>::Ptr (new search::KdTree<PointXYZ>));
+  n.setKSearch (10);
+  n.compute (*normals);
+
+  // The descriptors are the same with and without the cache, and the same as the serial ones
+  PointCloud<FPFHSignature33> output_serial, output_cache, output_no_cache;
+  FPFHEstimation<PointXYZ, Normal, FPFHSignature33> fpfh;
+  fpfh.setInputCloud (points);
+  fpfh.setInputNormals (normals);
+  fpfh.setSearchMethod (search::KdTree<PointXYZ>::Ptr (new search::KdTree<PointXYZ>));
+  fpfh.setKSearch (10);
+  fpfh.compute (output_serial);
+
+  FPFHEstimationOMP<PointXYZ, Normal, FPFHSignature33> fpfh_omp (4);
+  fpfh_omp.setInputCloud (points);
+  fpfh_omp.setInputNormals (normals);
+  fpfh_omp.setSearchMethod (search::KdTree<PointXYZ>::Ptr (new search::KdTree<PointXYZ>));
+  fpfh_omp.setKSearch (10);
+  fpfh_omp.compute (output_cache);
+  fpfh_omp.setUseInternalCache (false);
+  fpfh_omp.compute (output_no_cache);
+
+  ASSERT_EQ (output_serial.size (), output_cache.size ());
+  ASSERT_EQ (output_serial.size (), output_no_cache.size ());
+  for (size_t i = 0; i < output_serial.size (); ++i)
+  {
+    for (int j = 0; j < 33; ++j)
+    {
+      ASSERT_EQ (output_serial.points[i].histogram[j], output_cache.points[i].histogram[j]);
+      ASSERT_EQ (output_serial.points[i].histogram[j], output_no_cache.points[i].histogram[j]);
+    }
+  }
+
+  // Move a few points, and update the descriptors incrementally
+  fpfh_omp.setUseInternalCache (true);
+  fpfh_omp.compute (output_cache);
+  vector<int> changed;
+  for (size_t i = 0; i < points->size (); i += 37)
+  {
+    points->points[i].x += 0.002f;
+    points->points[i].z -= 0.001f;
+    changed.push_back (static_cast<int> (i));
+  }
+  fpfh_omp.computeChanged (changed, output_cache);
+
+  PointCloud<FPFHSignature33> output_full;
+  FPFHEstimationOMP<PointXYZ, Normal, FPFHSignature33> fpfh_full (4);
+  fpfh_full.setInputCloud (points);
+  fpfh_full.setInputNormals (normals);
+  fpfh_full.setSearchMethod (search::KdTree<PointXYZ>::Ptr (new search::KdTree<PointXYZ>));
+  fpfh_full.setKSearch (10);
+  fpfh_full.compute (output_full);
+
+  ASSERT_EQ (output_full.size (), output_cache.size ());
+  for (size_t i = 0; i < output_full.size (); ++i)
+    for (int j = 0; j < 33; ++j)
+      ASSERT_EQ (output_full.points[i].histogram[j], output_cache.points[i].histogram[j]);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, PFHEstimationOpenMP)
+{
+  PointCloud<PointXYZ>::Ptr points (new PointCloud<PointXYZ> (cloud));
+  NormalEstimation<PointXYZ, Normal> n;
+  PointCloud<Normal>::Ptr normals (new PointCloud<Normal> ());
+  n.setInputCloud (points);
+  n.setSearchMethod (search::KdTree<PointXYZ>::Ptr (new search::KdTree<PointXYZ>));
+  n.setKSearch (10);
+  n.compute (*normals);
+
+  PointCloud<PFHSignature125> output_serial, output_omp;
+  PFHEstimation<PointXYZ, Normal, PFHSignature125> pfh;
+  pfh.setInputCloud (points);
+  pfh.setInputNormals (normals);
+  pfh.setSearchMethod (search::KdTree<PointXYZ>::Ptr (new search::KdTree<PointXYZ>));
+  pfh.setRadiusSearch (0.02);
+  pfh.compute (output_serial);
+
+  PFHEstimationOMP<PointXYZ, Normal, PFHSignature125> pfh_omp (4);
+  pfh_omp.setInputCloud (points);
+  pfh_omp.setInputNormals (normals);
+  pfh_omp.setSearchMethod (search::KdTree<PointXYZ>::Ptr (new search::KdTree<PointXYZ>));
+  pfh_omp.setRadiusSearch (0.02);
+  pfh_omp.compute (output_omp);
+
+  ASSERT_EQ (output_serial.size (), output_omp.size ());
+  for (size_t i = 0; i < output_serial.size (); ++i)
+    for (int j = 0; j < 125; ++j)
+      ASSERT_EQ (output_serial.points[i].histogram[j], output_omp.points[i].histogram[j]);
+
+  // Move a few points, and update the descriptors incrementally
+  vector<int> changed;
+  for (size_t i = 0; i < points->size (); i += 37)
+  {
+    points->points[i].y += 0.002f;
+    changed.push_back (static_cast<int> (i));
+  }
+  pfh_omp.computeChanged (changed, output_omp);
+
+  // The search method of pfh was built on the previous coordinates
+  PFHEstimation<PointXYZ, Normal, PFHSignature125> pfh_moved;
+  pfh_moved.setInputCloud (points);
+  pfh_moved.setInputNormals (normals);
+  pfh_moved.setSearchMethod (search::KdTree<PointXYZ>::Ptr (new search::KdTree<PointXYZ>));
+  pfh_moved.setRadiusSearch (0.02);
+  pfh_moved.compute (output_serial);
+
+  ASSERT_EQ (output_serial.size (), output_omp.size ());
+  for (size_t i = 0; i < output_serial.size (); ++i)
+    for (int j = 0; j < 125; ++j)
+      ASSERT_EQ (output_serial.points[i].histogram[j], output_omp.points[i].histogram[j]);
+
+  // Test results when setIndices and/or setSearchSurface are used
+  boost::shared_ptr<vector<int> > test_indices (new vector<int> (0));
+  for (size_t i = 0; i < cloud.size (); i+=3)
+    test_indices->push_back (static_cast<int> (i));
+
+  testIndicesAndSearchSurface<PFHEstimationOMP<PointXYZ, Normal, PFHSignature125>, PointXYZ, Normal, PFHSignature125>
+  (cloud.makeShared (), normals, test_indices, 125);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (PCL, VFHEstimation)
 {
@@ -773,6 +773,43 @@ TEST (VoxelGrid_RGB, Filters)
   }
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (VoxelGrid_LargeGrid, Filters)
+{
+  // 65536 x 65536 x 2 voxels: the index of the last slice does not fit in 32 bits
+  PointCloud<PointXYZ>::Ptr cloud (new PointCloud<PointXYZ>);
+  cloud->points.push_back (PointXYZ (0.5f, 0.5f, 0.5f));
+  cloud->points.push_back (PointXYZ (65535.5f, 65535.5f, 0.5f));
+  cloud->points.push_back (PointXYZ (0.5f, 0.5f, 1.5f));
+  cloud->points.push_back (PointXYZ (0.75f, 0.25f, 1.75f));
+  cloud->width = static_cast<uint32_t> (cloud->points.size ());
+  cloud->height = 1;
+
+  PointCloud<PointXYZ> output;
+  VoxelGrid<PointXYZ> grid;
+
+  grid.setLeafSize (1.0f, 1.0f, 1.0f);
+  grid.setInputCloud (cloud);
+  grid.setNumberOfThreads (2);
+  grid.filter (output);
+
+  // voxels are sorted by index, z major
+  ASSERT_EQ (int (output.points.size ()), 3);
+  EXPECT_NEAR (output.points[0].x, 0.5f, 1e-4);
+  EXPECT_NEAR (output.points[0].y, 0.5f, 1e-4);
+  EXPECT_NEAR (output.points[0].z, 0.5f, 1e-4);
+  EXPECT_NEAR (output.points[1].x, 65535.5f, 1e-4);
+  EXPECT_NEAR (output.points[1].y, 65535.5f, 1e-4);
+  EXPECT_NEAR (output.points[1].z, 0.5f, 1e-4);
+  EXPECT_NEAR (output.points[2].x, 0.625f, 1e-4);
+  EXPECT_NEAR (output.points[2].y, 0.375f, 1e-4);
+  EXPECT_NEAR (output.points[2].z, 1.625f, 1e-4);
+
+  // the leaf layout needs int indices
+  grid.setSaveLeafLayout (true);
+  EXPECT_THROW (grid.filter (output), PCLException);
+}
+
 #if 0
 ////////////////////////////////////////////////////////////////////////////////
 float getRandomNumber (float max = 1.0, float min = 0.0)
@@ -1859,6 +1896,50 @@ TEST (ConditionalRemovalSetIndices, Filters)
   EXPECT_EQ (num_not_nan, int (indices->size ()) - int (condrem2_.getRemovedIndices ()->size ()));
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (CompiledCondition, Filters)
+{
+  // a copy of the cloud with some invalid points
+  PointCloud<PointXYZ> cloud_nan = *cloud;
+  for (size_t i = 0; i < cloud_nan.points.size (); i += 7)
+    cloud_nan.points[i].y = std::numeric_limits<float>::quiet_NaN ();
+
+  // z in ]0.02, 0.04[ and (y >= 0.10 or y <= 0.05 or (x == 0 and a quadric that is always true))
+  ConditionAnd<PointXYZ>::Ptr and_cond (new ConditionAnd<PointXYZ> ());
+  and_cond->addComparison (FieldComparison<PointXYZ>::ConstPtr (new FieldComparison<PointXYZ> ("z", ComparisonOps::GT, 0.02)));
+  and_cond->addComparison (FieldComparison<PointXYZ>::ConstPtr (new FieldComparison<PointXYZ> ("z", ComparisonOps::LT, 0.04)));
+  ConditionOr<PointXYZ>::Ptr or_cond (new ConditionOr<PointXYZ> ());
+  or_cond->addComparison (FieldComparison<PointXYZ>::ConstPtr (new FieldComparison<PointXYZ> ("y", ComparisonOps::GE, 0.10)));
+  or_cond->addComparison (FieldComparison<PointXYZ>::ConstPtr (new FieldComparison<PointXYZ> ("y", ComparisonOps::LE, 0.05)));
+  ConditionAnd<PointXYZ>::Ptr nested_cond (new ConditionAnd<PointXYZ> ());
+  nested_cond->addComparison (FieldComparison<PointXYZ>::ConstPtr (new FieldComparison<PointXYZ> ("x", ComparisonOps::EQ, 0)));
+  nested_cond->addComparison (TfQuadraticXYZComparison<PointXYZ>::ConstPtr (new TfQuadraticXYZComparison<PointXYZ> (ComparisonOps::EQ, Eigen::Matrix3f::Zero (),
+                                                                                                                    Eigen::Vector3f::Zero (), 0)));
+  or_cond->addCondition (nested_cond);
+  and_cond->addCondition (or_cond);
+
+  // every point, then every other point through indices
+  vector<int> indices;
+  for (int i = 0; i < static_cast<int> (cloud_nan.points.size ()); i += 2)
+    indices.push_back (i);
+
+  CompiledCondition<PointXYZ> compiled (and_cond);
+  vector<uint8_t> result (cloud_nan.points.size ());
+  compiled.evaluate (cloud_nan, NULL, 0, static_cast<int> (cloud_nan.points.size ()), &result[0]);
+  for (size_t i = 0; i < cloud_nan.points.size (); ++i)
+    EXPECT_EQ (bool (result[i]), and_cond->evaluate (cloud_nan.points[i]));
+
+  compiled.evaluate (cloud_nan, &indices[0], 1, static_cast<int> (indices.size ()) - 1, &result[0]);
+  for (size_t i = 1; i < indices.size (); ++i)
+    EXPECT_EQ (bool (result[i - 1]), and_cond->evaluate (cloud_nan.points[indices[i]]));
+
+  // an empty condition lets every point through
+  CompiledCondition<PointXYZ> compiled_empty (ConditionAnd<PointXYZ>::Ptr (new ConditionAnd<PointXYZ> ()));
+  compiled_empty.evaluate (cloud_nan, NULL, 0, static_cast<int> (cloud_nan.points.size ()), &result[0]);
+  for (size_t i = 0; i < cloud_nan.points.size (); ++i)
+    EXPECT_EQ (int (result[i]), 1);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 TEST (SamplingSurfaceNormal, Filters)
 {
@@ -267,6 +267,43 @@ TEST (PCL, KdTreeFLANN_nearestKSearch)
   }
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, KdTreeFLANN_addPoints)
+{
+  KdTreeFLANN<MyPoint> kdtree;
+  PointCloud<MyPoint>::Ptr grown (new PointCloud<MyPoint>);
+  grown->points.assign (cloud_big.points.begin (), cloud_big.points.begin () + 10000);
+  kdtree.setInputCloud (grown);
+
+  const int k = 10;
+  vector<int> k_indices, gt_indices;
+  vector<float> k_distances, gt_distances;
+  for (size_t size = 10500; size <= 30000; size += 500)
+  {
+    // Each grown cloud is added to the incremental tree, and indexed from scratch for the ground truth
+    grown.reset (new PointCloud<MyPoint>);
+    grown->points.assign (cloud_big.points.begin (), cloud_big.points.begin () + size);
+    kdtree.addPoints (grown);
+    KdTreeFLANN<MyPoint> gt_kdtree;
+    gt_kdtree.setInputCloud (grown);
+
+    for (size_t i = 0; i < size; i += 997)
+    {
+      kdtree.nearestKSearch (cloud_big.points[i], k, k_indices, k_distances);
+      gt_kdtree.nearestKSearch (cloud_big.points[i], k, gt_indices, gt_distances);
+      ASSERT_EQ (k_indices.size (), gt_indices.size ());
+      for (size_t j = 0; j < k_indices.size (); ++j)
+        EXPECT_NEAR (k_distances[j], gt_distances[j], 1e-3);
+
+      kdtree.radiusSearch (cloud_big.points[i], 30.0, k_indices, k_distances);
+      gt_kdtree.radiusSearch (cloud_big.points[i], 30.0, gt_indices, gt_distances);
+      ASSERT_EQ (k_indices.size (), gt_indices.size ());
+      for (size_t j = 0; j < k_indices.size (); ++j)
+        EXPECT_NEAR (k_distances[j], gt_distances[j], 1e-3);
+    }
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (PCL, KdTreeFLANN_nearestKSearchEigen)
 {
@@ -1625,6 +1625,118 @@ TEST (PCL, Octree_Pointcloud_Ray_Traversal)
 
 }
 
+TEST (PCL, Octree_Pointcloud_Linear_Search)
+{
+  const unsigned int test_runs = 20;
+  unsigned int test_id;
+
+  // instantiate point cloud
+  PointCloud<PointXYZ>::Ptr cloudIn (new PointCloud<PointXYZ> ());
+
+  size_t i;
+
+  srand (static_cast<unsigned int> (time (NULL)));
+
+  cloudIn->width = 5000;
+  cloudIn->height = 1;
+  cloudIn->points.resize (cloudIn->width * cloudIn->height);
+  for (i = 0; i < cloudIn->points.size (); i++)
+  {
+    cloudIn->points[i] = PointXYZ (static_cast<float> (5.0  * rand () / RAND_MAX),
+                                   static_cast<float> (10.0 * rand () / RAND_MAX),
+                                   static_cast<float> (10.0 * rand () / RAND_MAX));
+  }
+
+  OctreePointCloudLinearSearch<PointXYZ> octree (0.1);
+  octree.setInputCloud (cloudIn);
+  octree.addPointsFromInputCloud ();
+
+  // every point is found in its own voxel, and every voxel holds distinct points
+  std::vector<int> voxelIndices;
+  std::vector<int> pointCount (cloudIn->points.size (), 0);
+  OctreePointCloudLinearSearch<PointXYZ>::AlignedPointTVector voxelCenters;
+  ASSERT_EQ (octree.getOccupiedVoxelCenters (voxelCenters), static_cast<int> (octree.getLeafCount ()));
+  for (i = 0; i < voxelCenters.size (); i++)
+  {
+    ASSERT_EQ (octree.voxelSearch (voxelCenters[i], voxelIndices), true);
+    for (size_t j = 0; j < voxelIndices.size (); j++)
+      pointCount[voxelIndices[j]]++;
+  }
+  for (i = 0; i < cloudIn->points.size (); i++)
+  {
+    ASSERT_EQ (pointCount[i], 1);
+    ASSERT_EQ (octree.voxelSearch (cloudIn->points[i], voxelIndices), true);
+    ASSERT_EQ (std::find (voxelIndices.begin (), voxelIndices.end (), static_cast<int> (i)) != voxelIndices.end (), true);
+  }
+
+  OctreePointCloudLinearSearch<PointXYZ>::AlignedPointTVector voxelCentroids;
+  ASSERT_EQ (octree.getVoxelCentroids (voxelCentroids), octree.getLeafCount ());
+
+  std::vector<int> k_indices;
+  std::vector<float> k_sqr_distances;
+
+  for (test_id = 0; test_id < test_runs; test_id++)
+  {
+    // define a random search point
+    PointXYZ searchPoint (static_cast<float> (10.0 * rand () / RAND_MAX),
+                          static_cast<float> (10.0 * rand () / RAND_MAX),
+                          static_cast<float> (10.0 * rand () / RAND_MAX));
+
+    std::vector<float> sqrDistBruteforce (cloudIn->points.size ());
+    for (i = 0; i < cloudIn->points.size (); i++)
+    {
+      sqrDistBruteforce[i] = (cloudIn->points[i].x - searchPoint.x) * (cloudIn->points[i].x - searchPoint.x)
+          + (cloudIn->points[i].y - searchPoint.y) * (cloudIn->points[i].y - searchPoint.y)
+          + (cloudIn->points[i].z - searchPoint.z) * (cloudIn->points[i].z - searchPoint.z);
+    }
+
+    // nearest neighbor search, compared by distance
+    const int K = 1 + rand () % 20;
+    std::vector<float> sortedSqrDist (sqrDistBruteforce);
+    std::sort (sortedSqrDist.begin (), sortedSqrDist.end ());
+
+    ASSERT_EQ (octree.nearestKSearch (searchPoint, K, k_indices, k_sqr_distances), K);
+    for (int k = 0; k < K; k++)
+    {
+      EXPECT_NEAR (k_sqr_distances[k], sortedSqrDist[k], 1e-4);
+      EXPECT_NEAR (k_sqr_distances[k], sqrDistBruteforce[k_indices[k]], 1e-4);
+    }
+
+    // radius search
+    const float searchRadius = 3.0f * static_cast<float> (rand ()) / static_cast<float> (RAND_MAX);
+    size_t radiusCount = 0;
+    for (i = 0; i < cloudIn->points.size (); i++)
+      if (sqrDistBruteforce[i] <= searchRadius * searchRadius)
+        radiusCount++;
+
+    ASSERT_EQ (octree.radiusSearch (searchPoint, searchRadius, k_indices, k_sqr_distances), static_cast<int> (radiusCount));
+    for (i = 0; i < k_indices.size (); i++)
+      ASSERT_EQ (sqrDistBruteforce[k_indices[i]] <= searchRadius * searchRadius, true);
+
+    octree.radiusSearch (searchPoint, searchRadius, k_indices, k_sqr_distances, 5);
+    ASSERT_EQ (k_indices.size () <= 5, true);
+
+    // box search
+    const Eigen::Vector3f minPt (searchPoint.x - searchRadius, searchPoint.y - searchRadius, searchPoint.z - searchRadius);
+    const Eigen::Vector3f maxPt (searchPoint.x + searchRadius, searchPoint.y + searchRadius, searchPoint.z + searchRadius);
+    size_t boxCount = 0;
+    for (i = 0; i < cloudIn->points.size (); i++)
+    {
+      const PointXYZ& pt = cloudIn->points[i];
+      if (pt.x >= minPt (0) && pt.y >= minPt (1) && pt.z >= minPt (2) && pt.x <= maxPt (0) && pt.y <= maxPt (1) && pt.z <= maxPt (2))
+        boxCount++;
+    }
+    ASSERT_EQ (octree.boxSearch (minPt, maxPt, k_indices), static_cast<int> (boxCount));
+
+    // approximate nearest neighbor lies in the voxel closest to the search point
+    int resultIndex;
+    float sqrDistance;
+    octree.approxNearestSearch (searchPoint, resultIndex, sqrDistance);
+    ASSERT_EQ (resultIndex >= 0, true);
+    EXPECT_NEAR (sqrDistance, sqrDistBruteforce[resultIndex], 1e-4);
+  }
+}
+
 /* ---[ */
 int
 main (int argc, char** argv)
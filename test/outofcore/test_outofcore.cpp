@@ -57,6 +57,10 @@ using namespace pcl;
 
 #include <pcl/outofcore/outofcore.h>
 #include <pcl/outofcore/outofcore_impl.h>
+#include <pcl/outofcore/outlier_removal.h>
+#include <pcl/filters/statistical_outlier_removal.h>
+#include <pcl/filters/radius_outlier_removal.h>
+#include <pcl/io/pcd_io.h>
 
 #include <sensor_msgs/PointCloud2.h>
 
@@ -891,6 +895,105 @@ TEST_F (OutofcoreTest, PointCloud2_Query)
   cleanUpFilesystem ();
 }
 
+/** \brief Compares the output file of an out of core filter to the output of the in-memory filter. */
+void
+compareFilteredClouds (const std::string &file_name, const pcl::PointCloud<pcl::PointXYZI> &expected)
+{
+  pcl::PointCloud<pcl::PointXYZI> filtered;
+  ASSERT_EQ (pcl::io::loadPCDFile (file_name, filtered), 0);
+  ASSERT_EQ (filtered.size (), expected.size ());
+  for (size_t i = 0; i < expected.size (); ++i)
+  {
+    if (!pcl_isfinite (expected[i].x))
+    {
+      EXPECT_FALSE (pcl_isfinite (filtered[i].x));
+      continue;
+    }
+    EXPECT_EQ (filtered[i].x, expected[i].x);
+    EXPECT_EQ (filtered[i].y, expected[i].y);
+    EXPECT_EQ (filtered[i].z, expected[i].z);
+    EXPECT_EQ (filtered[i].intensity, expected[i].intensity);
+  }
+}
+
+TEST (PCL, Outofcore_Outlier_Removal)
+{
+  // a few dense clusters in sparse noise, the intensity holding the position of the point
+  boost::mt19937 rng (rngseed);
+  boost::normal_distribution<float> normal (0.0f, 0.1f);
+  boost::uniform_real<float> uniform (-2.0f, 2.0f);
+  boost::variate_generator<boost::mt19937&, boost::normal_distribution<float> > cluster_noise (rng, normal);
+  boost::variate_generator<boost::mt19937&, boost::uniform_real<float> > sparse_noise (rng, uniform);
+
+  pcl::PointCloud<pcl::PointXYZI>::Ptr cloud (new pcl::PointCloud<pcl::PointXYZI>);
+  for (int i = 0; i < 20000; ++i)
+  {
+    pcl::PointXYZI point;
+    if (i % 10 == 0)
+    {
+      point.x = sparse_noise ();
+      point.y = sparse_noise ();
+      point.z = sparse_noise ();
+    }
+    else
+    {
+      const float center = static_cast<float> (i % 3) - 1.0f;
+      point.x = center + cluster_noise ();
+      point.y = center * 0.5f + cluster_noise ();
+      point.z = cluster_noise ();
+    }
+    point.intensity = static_cast<float> (i);
+    cloud->push_back (point);
+  }
+  ASSERT_EQ (pcl::io::savePCDFileBinary ("outlier_removal_finite.pcd", *cloud), 0);
+  for (size_t i = 5; i < cloud->size (); i += 1000)
+    (*cloud)[i].x = (*cloud)[i].y = (*cloud)[i].z = std::numeric_limits<float>::quiet_NaN ();
+  cloud->is_dense = false;
+  ASSERT_EQ (pcl::io::savePCDFileBinary ("outlier_removal_input.pcd", *cloud), 0);
+
+  // small blocks and chunks, so that most neighborhoods cross block boundaries
+  pcl::PointCloud<pcl::PointXYZI> expected;
+  pcl::StatisticalOutlierRemoval<pcl::PointXYZI> sor;
+  sor.setInputCloud (cloud);
+  sor.setMeanK (8);
+  sor.setStddevMulThresh (1.0);
+  sor.filter (expected);
+
+  OutofcoreStatisticalOutlierRemoval outofcore_sor;
+  outofcore_sor.setBlockSize (0.25);
+  outofcore_sor.setBlockMargin (0.01);
+  outofcore_sor.setChunkSize (3000);
+  outofcore_sor.setMeanK (8);
+  outofcore_sor.setStddevMulThresh (1.0);
+  EXPECT_EQ (outofcore_sor.filter ("outlier_removal_input.pcd", "outlier_removal_output.pcd"), static_cast<int64_t> (expected.size ()));
+  compareFilteredClouds ("outlier_removal_output.pcd", expected);
+
+  // radius searches on non finite points are not supported by the in-memory filter
+  pcl::PointCloud<pcl::PointXYZI>::Ptr finite_cloud (new pcl::PointCloud<pcl::PointXYZI>);
+  pcl::io::loadPCDFile ("outlier_removal_finite.pcd", *finite_cloud);
+  pcl::RadiusOutlierRemoval<pcl::PointXYZI> ror;
+  ror.setInputCloud (finite_cloud);
+  ror.setRadiusSearch (0.05);
+  ror.setMinNeighborsInRadius (4);
+  OutofcoreRadiusOutlierRemoval outofcore_ror;
+  outofcore_ror.setBlockSize (0.25);
+  outofcore_ror.setChunkSize (3000);
+  outofcore_ror.setRadiusSearch (0.05);
+  outofcore_ror.setMinNeighborsInRadius (4);
+  for (int negative = 0; negative < 2; ++negative)
+  {
+    ror.setNegative (negative != 0);
+    ror.filter (expected);
+    outofcore_ror.setNegative (negative != 0);
+    EXPECT_EQ (outofcore_ror.filter ("outlier_removal_finite.pcd", "outlier_removal_output.pcd"), static_cast<int64_t> (expected.size ()));
+    compareFilteredClouds ("outlier_removal_output.pcd", expected);
+  }
+
+  boost::filesystem::remove ("outlier_removal_input.pcd");
+  boost::filesystem::remove ("outlier_removal_finite.pcd");
+  boost::filesystem::remove ("outlier_removal_output.pcd");
+}
+
 /* [--- */
 int
 main (int argc, char** argv)
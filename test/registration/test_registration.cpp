@@ -46,6 +46,8 @@
 #include <pcl/registration/registration.h>
 #include <pcl/registration/icp.h>
 #include <pcl/registration/icp_nl.h>
+#include <pcl/registration/gicp.h>
+#include <pcl/registration/multiresolution_registration.h>
 #include <pcl/registration/transformation_estimation_point_to_plane.h>
 #include <pcl/registration/transformation_validation_euclidean.h>
 #include <pcl/registration/transformation_estimation_point_to_plane_lls.h>
@@ -187,6 +189,52 @@ TEST (PCL, IterativeClosestPoint)
   EXPECT_EQ (transformation (3, 3), 1);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, IterativeClosestPointThreads)
+{
+  Eigen::Matrix4f guess = Eigen::Matrix4f::Identity ();
+  guess (0, 3) = 0.01f;
+
+  IterativeClosestPoint<PointXYZ, PointXYZ> reg;
+  reg.setInputCloud (cloud_source.makeShared ());
+  reg.setInputTarget (cloud_target.makeShared ());
+  reg.setMaximumIterations (50);
+  reg.setTransformationEpsilon (1e-8);
+  reg.setMaxCorrespondenceDistance (0.05);
+
+  // In deterministic mode, the alignment must not depend on the number of threads
+  reg.setNumberOfThreads (1);
+  PointCloud<PointXYZ> output_single;
+  reg.align (output_single, guess);
+  Eigen::Matrix4f transformation_single = reg.getFinalTransformation ();
+  EXPECT_LT (reg.getFitnessScore (), 0.001);
+
+  reg.setNumberOfThreads (4);
+  PointCloud<PointXYZ> output_multi;
+  reg.align (output_multi, guess);
+  Eigen::Matrix4f transformation_multi = reg.getFinalTransformation ();
+
+  for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 4; ++j)
+      EXPECT_EQ (transformation_single (i, j), transformation_multi (i, j));
+  ASSERT_EQ (output_single.points.size (), output_multi.points.size ());
+  for (size_t i = 0; i < output_single.points.size (); ++i)
+  {
+    EXPECT_EQ (output_single.points[i].x, output_multi.points[i].x);
+    EXPECT_EQ (output_single.points[i].y, output_multi.points[i].y);
+    EXPECT_EQ (output_single.points[i].z, output_multi.points[i].z);
+  }
+
+  // The parallel estimator only changes the last bits of the sums
+  reg.setDeterministic (false);
+  PointCloud<PointXYZ> output_parallel;
+  reg.align (output_parallel, guess);
+  Eigen::Matrix4f transformation_parallel = reg.getFinalTransformation ();
+  for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 4; ++j)
+      EXPECT_NEAR (transformation_single (i, j), transformation_parallel (i, j), 1e-3);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (PCL, IterativeClosestPointNonLinear)
 {
@@ -236,6 +284,146 @@ TEST (PCL, IterativeClosestPointNonLinear)
   EXPECT_LT (reg.getFitnessScore (), 0.001);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, GeneralizedIterativeClosestPoint)
+{
+  typedef GeneralizedIterativeClosestPoint<PointXYZ, PointXYZ> GICP;
+  PointCloud<PointXYZ>::Ptr src (new PointCloud<PointXYZ> (cloud_source));
+  PointCloud<PointXYZ>::Ptr tgt (new PointCloud<PointXYZ> (cloud_target));
+  PointCloud<PointXYZ> output;
+
+  GICP reg;
+  reg.setInputCloud (src);
+  reg.setInputTarget (tgt);
+  reg.setMaximumIterations (50);
+  reg.setTransformationEpsilon (1e-8);
+  EXPECT_TRUE (reg.getTargetCovariances ().get () == NULL);
+
+  reg.setNumberOfThreads (1);
+  reg.align (output);
+  EXPECT_LT (reg.getFitnessScore (), 0.001);
+  Eigen::Matrix4f transformation = reg.getFinalTransformation ();
+
+  // The covariances are kept for the next alignments
+  GICP::MatricesVectorConstPtr target_covariances = reg.getTargetCovariances ();
+  ASSERT_TRUE (target_covariances.get () != NULL);
+  EXPECT_EQ (int (target_covariances->size ()), int (tgt->points.size ()));
+  ASSERT_TRUE (reg.getSourceCovariances ().get () != NULL);
+  EXPECT_EQ (int (reg.getSourceCovariances ()->size ()), int (src->points.size ()));
+
+  // The result does not depend on the number of threads
+  reg.setNumberOfThreads (4);
+  reg.setInputCloud (src);
+  reg.align (output);
+  EXPECT_EQ (reg.getTargetCovariances (), target_covariances);
+  Eigen::Matrix4f transformation_multi = reg.getFinalTransformation ();
+  for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 4; ++j)
+      EXPECT_EQ (transformation (i, j), transformation_multi (i, j));
+
+  // The covariances can be shared with another object
+  GICP reg_shared;
+  reg_shared.setInputCloud (src);
+  reg_shared.setInputTarget (tgt);
+  reg_shared.setTargetCovariances (target_covariances);
+  reg_shared.setSourceCovariances (reg.getSourceCovariances ());
+  reg_shared.setMaximumIterations (50);
+  reg_shared.setTransformationEpsilon (1e-8);
+  reg_shared.align (output);
+  EXPECT_EQ (reg_shared.getTargetCovariances (), target_covariances);
+  Eigen::Matrix4f transformation_shared = reg_shared.getFinalTransformation ();
+  for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 4; ++j)
+      EXPECT_EQ (transformation (i, j), transformation_shared (i, j));
+
+  // A new number of neighbors resets both covariances
+  reg.setCorrespondenceRandomness (reg.getCorrespondenceRandomness ());
+  EXPECT_EQ (reg.getTargetCovariances (), target_covariances);
+  reg.setCorrespondenceRandomness (reg.getCorrespondenceRandomness () + 5);
+  EXPECT_TRUE (reg.getSourceCovariances ().get () == NULL);
+  EXPECT_TRUE (reg.getTargetCovariances ().get () == NULL);
+  reg.align (output);
+  EXPECT_LT (reg.getFitnessScore (), 0.001);
+
+  // A new target resets its covariances
+  reg.setInputTarget (tgt);
+  EXPECT_TRUE (reg.getTargetCovariances ().get () == NULL);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, MultiresolutionRegistration)
+{
+  registration::MultiresolutionRegistration<PointXYZ, PointXYZ> reg;
+  reg.setInputCloud (cloud_source.makeShared ());
+  reg.setInputTarget (cloud_target.makeShared ());
+  reg.addLevel (0.01f, 20, 0.1);
+  reg.addLevel (0.005f, 20, 0.05);
+  reg.addLevel (0.0f, 50, 0.05, 1e-8);
+  EXPECT_EQ (int (reg.getLevels ().size ()), 3);
+
+  // Without registration method, nothing is done
+  PointCloud<PointXYZ> output;
+  reg.align (output);
+  EXPECT_FALSE (reg.hasConverged ());
+
+  reg.setRegistration (Registration<PointXYZ, PointXYZ>::Ptr (new IterativeClosestPoint<PointXYZ, PointXYZ>));
+  reg.align (output);
+  EXPECT_EQ (int (output.points.size ()), int (cloud_source.points.size ()));
+  EXPECT_TRUE (reg.hasConverged ());
+  ASSERT_EQ (int (reg.getLevelsConverged ().size ()), 3);
+  EXPECT_LT (reg.getFitnessScore (), 0.001);
+
+  // The same transformation as the full resolution IterativeClosestPoint test
+  Eigen::Matrix4f transformation = reg.getFinalTransformation ();
+  EXPECT_NEAR (transformation (0, 0),  0.8806,  1e-2);
+  EXPECT_NEAR (transformation (0, 2), -0.4724,  1e-2);
+  EXPECT_NEAR (transformation (0, 3),  0.03453, 1e-2);
+  EXPECT_NEAR (transformation (1, 1),  0.9992,  1e-2);
+  EXPECT_NEAR (transformation (2, 0),  0.4732,  1e-2);
+  EXPECT_NEAR (transformation (2, 2),  0.8808,  1e-2);
+  EXPECT_NEAR (transformation (2, 3),  0.04116, 1e-2);
+
+  // The output is the source transformed by the final transformation
+  PointCloud<PointXYZ> transformed;
+  transformPointCloud (cloud_source, transformed, transformation);
+  for (size_t i = 0; i < output.points.size (); ++i)
+  {
+    EXPECT_NEAR (output.points[i].x, transformed.points[i].x, 1e-5);
+    EXPECT_NEAR (output.points[i].y, transformed.points[i].y, 1e-5);
+    EXPECT_NEAR (output.points[i].z, transformed.points[i].z, 1e-5);
+  }
+
+  // The cached target levels give the same result on the next alignment
+  reg.align (output);
+  Eigen::Matrix4f transformation_cached = reg.getFinalTransformation ();
+  for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 4; ++j)
+      EXPECT_EQ (transformation (i, j), transformation_cached (i, j));
+
+  // Any registration method can be run on the levels
+  reg.setRegistration (Registration<PointXYZ, PointXYZ>::Ptr (new IterativeClosestPointNonLinear<PointXYZ, PointXYZ>));
+  reg.align (output);
+  EXPECT_LT (reg.getFitnessScore (), 0.001);
+
+  reg.clearLevels ();
+  reg.addLevel (0.01f, 20, 0.1);
+  reg.addLevel (0.0f, 20, 0.05, 5e-4);
+  reg.setRegistration (Registration<PointXYZ, PointXYZ>::Ptr (new GeneralizedIterativeClosestPoint<PointXYZ, PointXYZ>));
+  reg.align (output);
+  EXPECT_LT (reg.getFitnessScore (), 0.001);
+
+  // Without full resolution level, the kd-tree of the target is only built for the fitness score
+  registration::MultiresolutionRegistration<PointXYZ, PointXYZ> reg_coarse;
+  reg_coarse.setInputCloud (cloud_source.makeShared ());
+  reg_coarse.setInputTarget (cloud_target.makeShared ());
+  reg_coarse.addLevel (0.01f, 20, 0.1);
+  reg_coarse.setRegistration (Registration<PointXYZ, PointXYZ>::Ptr (new IterativeClosestPoint<PointXYZ, PointXYZ>));
+  reg_coarse.align (output);
+  EXPECT_TRUE (reg_coarse.getSearchMethodTarget ()->getInputCloud ().get () == NULL);
+  EXPECT_LT (reg_coarse.getFitnessScore (), 0.001);
+  EXPECT_TRUE (reg_coarse.getSearchMethodTarget ()->getInputCloud ().get () != NULL);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (PCL, IterativeClosestPoint_PointToPlane)
 {
@@ -373,6 +561,66 @@ TEST (PCL, TransformationEstimationPointToPlaneLLS)
       EXPECT_NEAR (estimated_tform (i, j), ground_truth_tform (i, j), 1e-2);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, TransformationEstimationParallel)
+{
+  // Create a test cloud, large enough to be split in several blocks
+  PointCloud<PointNormal>::Ptr src (new PointCloud<PointNormal>);
+  for (float x = -5.0f; x <= 5.0f; x += 0.05f)
+  {
+    for (float y = -5.0f; y <= 5.0f; y += 0.1f)
+    {
+      PointNormal p;
+      p.x = x;
+      p.y = y;
+      p.z = 0.1f * powf (x, 2.0f) + 0.2f * p.x * p.y - 0.3f * y + 1.0f;
+      Eigen::Vector3f n (-0.2f * p.x - 0.2f, 0.6f * p.y - 0.2f, 1.0f);
+      p.getNormalVector3fMap () = n.normalized ();
+      src->points.push_back (p);
+    }
+  }
+  src->width = static_cast<uint32_t> (src->points.size ());
+  src->height = 1;
+  src->is_dense = true;
+
+  Eigen::Matrix4f ground_truth_tform = Eigen::Matrix4f::Identity ();
+  ground_truth_tform.row (0) <<  0.9938f,  0.0988f,  0.0517f,  0.1000f;
+  ground_truth_tform.row (1) << -0.0997f,  0.9949f,  0.0149f, -0.2000f;
+  ground_truth_tform.row (2) << -0.0500f, -0.0200f,  0.9986f,  0.3000f;
+  ground_truth_tform.row (3) <<  0.0000f,  0.0000f,  0.0000f,  1.0000f;
+
+  PointCloud<PointNormal>::Ptr tgt (new PointCloud<PointNormal>);
+  transformPointCloudWithNormals (*src, *tgt, ground_truth_tform);
+
+  std::vector<int> indices (src->points.size ());
+  for (size_t i = 0; i < indices.size (); ++i)
+    indices[i] = static_cast<int> (i);
+
+  registration::TransformationEstimationSVD<PointNormal, PointNormal> svd;
+  registration::TransformationEstimationPointToPlaneLLS<PointNormal, PointNormal> lls;
+  Eigen::Matrix4f serial_tform, single_tform, multi_tform;
+
+  svd.estimateRigidTransformation (*src, indices, *tgt, indices, serial_tform);
+  svd.estimateRigidTransformationParallel (*src, indices, *tgt, indices, 1, single_tform);
+  svd.estimateRigidTransformationParallel (*src, indices, *tgt, indices, 4, multi_tform);
+  for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 4; ++j)
+    {
+      EXPECT_NEAR (single_tform (i, j), serial_tform (i, j), 1e-4);
+      EXPECT_EQ (single_tform (i, j), multi_tform (i, j));
+    }
+
+  lls.estimateRigidTransformation (*src, indices, *tgt, indices, serial_tform);
+  lls.estimateRigidTransformationParallel (*src, indices, *tgt, indices, 1, single_tform);
+  lls.estimateRigidTransformationParallel (*src, indices, *tgt, indices, 4, multi_tform);
+  for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 4; ++j)
+    {
+      EXPECT_NEAR (single_tform (i, j), serial_tform (i, j), 1e-4);
+      EXPECT_EQ (single_tform (i, j), multi_tform (i, j));
+    }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (PCL, SampleConsensusInitialAlignment)
 {
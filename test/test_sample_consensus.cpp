@@ -46,6 +46,8 @@
 #include <pcl/sample_consensus/msac.h>
 #include <pcl/sample_consensus/rmsac.h>
 #include <pcl/sample_consensus/mlesac.h>
+#include <pcl/sample_consensus/parallel_ransac.h>
+#include <pcl/sample_consensus/distance_kernels.h>
 #include <pcl/sample_consensus/sac_model.h>
 #include <pcl/sample_consensus/sac_model_plane.h>
 #include <pcl/sample_consensus/sac_model_sphere.h>
@@ -231,6 +233,38 @@ TEST (RRANSAC, SampleConsensusModelPlane)
   verifyPlaneSac(model, sac, 600, 1.0f, 1.0f, 0.01f);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (ParallelRANSAC, SampleConsensusModelPlane)
+{
+  srand (0);
+  // Create a shared plane model pointer directly
+  SampleConsensusModelPlanePtr model (new SampleConsensusModelPlane<PointXYZ> (cloud_));
+
+  // Create the parallel RANSAC object
+  ParallelRandomSampleConsensus<PointXYZ> sac (model, 0.03);
+
+  verifyPlaneSac(model, sac);
+
+  // The preemptive count is exact as long as the model can reach the minimum number of inliers
+  Eigen::VectorXf coeff;
+  sac.getModelCoefficients (coeff);
+  int nr_inliers = model->countWithinDistance (coeff, 0.03);
+  EXPECT_EQ (model->countWithinDistancePreemptive (coeff, 0.03, nr_inliers), nr_inliers);
+  EXPECT_LT (model->countWithinDistancePreemptive (coeff, 0.03, nr_inliers + 1), nr_inliers + 1);
+
+  // The result does not depend on the number of threads
+  std::vector<int> inliers, inliers_single_thread;
+  sac.getInliers (inliers);
+
+  SampleConsensusModelPlanePtr model_single_thread (new SampleConsensusModelPlane<PointXYZ> (cloud_));
+  ParallelRandomSampleConsensus<PointXYZ> sac_single_thread (model_single_thread, 0.03);
+  sac_single_thread.setNumberOfThreads (1);
+  ASSERT_EQ (sac_single_thread.computeModel (), true);
+  sac_single_thread.getInliers (inliers_single_thread);
+  EXPECT_EQ (inliers.size (), inliers_single_thread.size ());
+  EXPECT_TRUE (inliers == inliers_single_thread);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TEST (RMSAC, SampleConsensusModelPlane)
 {
@@ -809,6 +843,97 @@ TEST (RANSAC, SampleConsensusModelNormalPlane)
   verifyPlaneSac (model, sac);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void
+verifyDistances (const std::vector<double> &distances, const std::vector<double> &reference, double tol = 1e-4)
+{
+  ASSERT_EQ (distances.size (), reference.size ());
+  for (size_t i = 0; i < reference.size (); ++i)
+  {
+    if (pcl_isnan (reference[i]))
+      EXPECT_TRUE (pcl_isnan (distances[i]));
+    else
+      EXPECT_NEAR (distances[i], reference[i], tol);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (SampleConsensusDistanceKernels, SimdLevels)
+{
+  SampleConsensusModelPlanePtr plane (new SampleConsensusModelPlane<PointXYZ> (cloud_));
+  SampleConsensusModelSpherePtr sphere (new SampleConsensusModelSphere<PointXYZ> (cloud_));
+  SampleConsensusModelLinePtr line (new SampleConsensusModelLine<PointXYZ> (cloud_));
+  SampleConsensusModelNormalPlanePtr normal_plane (new SampleConsensusModelNormalPlane<PointXYZ, Normal> (cloud_));
+  normal_plane->setInputNormals (normals_);
+  normal_plane->setNormalDistanceWeight (0.1);
+  SampleConsensusModelCylinderPtr cylinder (new SampleConsensusModelCylinder<PointXYZ, Normal> (cloud_));
+  cylinder->setInputNormals (normals_);
+  cylinder->setNormalDistanceWeight (0.1);
+
+  Eigen::VectorXf plane_coeff (4), sphere_coeff (4), line_coeff (6), cylinder_coeff (7);
+  plane_coeff << -0.8964f, -0.5868f, -1.208f, 1.0f;
+  plane_coeff.head<3> ().normalize ();
+  sphere_coeff << 1.0f, 0.1f, -0.2f, 0.3f;
+  line_coeff << 1.0f, 0.1f, -0.2f, 0.3f, -0.5f, 0.8f;
+  cylinder_coeff << 1.0f, 0.1f, -0.2f, 0.3f, -0.5f, 0.8f, 0.25f;
+
+  // Reference distances, computed point by point
+  size_t nr_points = cloud_->points.size ();
+  std::vector<double> plane_ref (nr_points), sphere_ref (nr_points), line_ref (nr_points),
+                      normal_plane_ref (nr_points), cylinder_ref (nr_points);
+  Eigen::Vector4f plane_normal (plane_coeff[0], plane_coeff[1], plane_coeff[2], 0);
+  Eigen::Vector4f line_pt (line_coeff[0], line_coeff[1], line_coeff[2], 0);
+  Eigen::Vector4f line_dir (line_coeff[3], line_coeff[4], line_coeff[5], 0);
+  line_dir.normalize ();
+  for (size_t i = 0; i < nr_points; ++i)
+  {
+    Eigen::Vector4f p (cloud_->points[i].x, cloud_->points[i].y, cloud_->points[i].z, 0);
+    Eigen::Vector4f n (normals_->points[i].normal[0], normals_->points[i].normal[1], normals_->points[i].normal[2], 0);
+
+    double d_euclid = fabs (plane_normal.dot (p) + plane_coeff[3]);
+    double d_normal = fabs (getAngle3D (n, plane_normal));
+    d_normal = (std::min) (d_normal, M_PI - d_normal);
+    plane_ref[i] = d_euclid;
+    normal_plane_ref[i] = fabs (0.1 * d_normal + 0.9 * d_euclid);
+
+    sphere_ref[i] = fabs ((p - Eigen::Vector4f (sphere_coeff[0], sphere_coeff[1], sphere_coeff[2], 0)).norm () - sphere_coeff[3]);
+
+    Eigen::Vector4f dir = (p - line_pt) - (p - line_pt).dot (line_dir) * line_dir;
+    line_ref[i] = dir.norm ();
+    d_euclid = fabs (dir.norm () - cylinder_coeff[6]);
+    d_normal = fabs (getAngle3D (n, dir));
+    d_normal = (std::min) (d_normal, M_PI - d_normal);
+    cylinder_ref[i] = fabs (0.1 * d_normal + 0.9 * d_euclid);
+  }
+
+  // All the instruction sets available give the same distances, up to rounding
+  sample_consensus::SimdLevel default_level = sample_consensus::getSimdLevel ();
+  for (int level = sample_consensus::SIMD_NONE; level <= sample_consensus::SIMD_AVX; ++level)
+  {
+    if (sample_consensus::setSimdLevel (static_cast<sample_consensus::SimdLevel> (level)) != level)
+      continue;
+
+    std::vector<double> distances;
+    plane->getDistancesToModel (plane_coeff, distances);
+    verifyDistances (distances, plane_ref);
+    sphere->getDistancesToModel (sphere_coeff, distances);
+    verifyDistances (distances, sphere_ref);
+    line->getDistancesToModel (line_coeff, distances);
+    verifyDistances (distances, line_ref);
+    normal_plane->getDistancesToModel (plane_coeff, distances);
+    verifyDistances (distances, normal_plane_ref);
+    cylinder->getDistancesToModel (cylinder_coeff, distances);
+    verifyDistances (distances, cylinder_ref);
+
+    // Counting and selecting the inliers use the same distances
+    std::vector<int> inliers;
+    cylinder->selectWithinDistance (cylinder_coeff, 0.2, inliers);
+    EXPECT_EQ (cylinder->countWithinDistance (cylinder_coeff, 0.2), int (inliers.size ()));
+    EXPECT_EQ (cylinder->countWithinDistancePreemptive (cylinder_coeff, 0.2, 0), int (inliers.size ()));
+  }
+  sample_consensus::setSimdLevel (default_level);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Test if RANSAC finishes within a second.
 TEST (SAC, InfiniteLoop)
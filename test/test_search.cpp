@@ -65,6 +65,9 @@ using namespace std;
 #define TEST_ORGANIZED_SPARSE_VIEW_KNN                1
 #define TEST_ORGANIZED_SPARSE_COMPLETE_RADIUS         1
 #define TEST_ORGANIZED_SPARSE_VIEW_RADIUS             1
+#define TEST_unorganized_sparse_cloud_BATCH           1
+#define TEST_ORGANIZED_SPARSE_BATCH                   1
+#define TEST_ORGANIZED_CAMERA_INTRINSICS              1
 
 #if EXCESSIVE_TESTING
 /** \brief number of points used for creating unordered point clouds */
@@ -411,6 +414,78 @@ testRadiusSearch (typename PointCloud<PointT>::ConstPtr point_cloud, vector<sear
   }
 }
 
+/** \brief does batch knn and radius searches and compares the results to the ones of the single point searches
+  * \param cloud the input point cloud
+  * \param search_methods vector of all search methods to be tested
+  * \param query_indices indices of query points in the point cloud (not necessarily in input_indices)
+  * \param input_indices indices defining a subset of the point cloud.
+  */
+template<typename PointT> void
+testBatchSearch (typename PointCloud<PointT>::ConstPtr point_cloud, vector<search::Search<PointT>*> search_methods, 
+                 const vector<int>& query_indices, const vector<int>& input_indices = vector<int> ())
+{
+  boost::shared_ptr<vector<int> > input_indices_;
+  if (input_indices.size ())
+    input_indices_.reset (new vector<int> (input_indices));
+
+  // a non finite query point gets no neighbors
+  vector<int> queries (query_indices);
+  for (unsigned pIdx = 0; pIdx < point_cloud->size (); ++pIdx)
+  {
+    if (!isFinite (point_cloud->points [pIdx]))
+    {
+      queries.push_back (pIdx);
+      break;
+    }
+  }
+
+  vector<int> indices;
+  vector<float> distances;
+  for (size_t sIdx = 0; sIdx < search_methods.size (); ++sIdx)
+  {
+    search::Search<PointT>& search = *search_methods [sIdx];
+    search.setInputCloud (point_cloud, input_indices_);
+    search::BatchNeighbors neighbors;
+    bool passed = true;
+
+    for (int knn = 1; knn <= 64; knn <<= 3)
+    {
+      search.batchNearestKSearch (*point_cloud, queries, knn, neighbors);
+      passed = passed && neighbors.size () == queries.size ();
+      for (size_t qIdx = 0; qIdx < queries.size () && passed; ++qIdx)
+      {
+        indices.clear ();
+        distances.clear ();
+        if (isFinite (point_cloud->points [queries [qIdx]]))
+          search.nearestKSearch (point_cloud->points [queries [qIdx]], knn, indices, distances);
+        passed = compareResults (indices, distances, search.getName (),
+                                 vector<int> (neighbors.indices.begin () + neighbors.offsets [qIdx], neighbors.indices.begin () + neighbors.offsets [qIdx + 1]),
+                                 vector<float> (neighbors.sqr_distances.begin () + neighbors.offsets [qIdx], neighbors.sqr_distances.begin () + neighbors.offsets [qIdx + 1]),
+                                 search.getName (), 1e-6f);
+      }
+    }
+
+    for (float radius = 0.01f; radius < 0.2f; radius *= 3.0f)
+    {
+      search.batchRadiusSearch (*point_cloud, queries, radius, neighbors);
+      passed = passed && neighbors.size () == queries.size ();
+      for (size_t qIdx = 0; qIdx < queries.size () && passed; ++qIdx)
+      {
+        indices.clear ();
+        distances.clear ();
+        if (isFinite (point_cloud->points [queries [qIdx]]))
+          search.radiusSearch (point_cloud->points [queries [qIdx]], radius, indices, distances);
+        passed = compareResults (indices, distances, search.getName (),
+                                 vector<int> (neighbors.indices.begin () + neighbors.offsets [qIdx], neighbors.indices.begin () + neighbors.offsets [qIdx + 1]),
+                                 vector<float> (neighbors.sqr_distances.begin () + neighbors.offsets [qIdx], neighbors.sqr_distances.begin () + neighbors.offsets [qIdx + 1]),
+                                 search.getName (), 1e-6f);
+      }
+    }
+    cout << search.getName () << " batch: " << (passed?"passed":"failed") << endl;
+    EXPECT_TRUE (passed);
+  }
+}
+
 #if TEST_unorganized_dense_cloud_COMPLETE_KNN
 // Test search on unorganized point clouds
 TEST (PCL, unorganized_dense_cloud_Complete_KNN)
@@ -489,6 +564,14 @@ TEST (PCL, unorganized_sparse_cloud_View_Radius)
 }
 #endif
 
+#if TEST_unorganized_sparse_cloud_BATCH
+TEST (PCL, unorganized_sparse_cloud_Batch)
+{
+  testBatchSearch (unorganized_sparse_cloud, unorganized_search_methods, unorganized_sparse_cloud_query_indices);
+  testBatchSearch (unorganized_sparse_cloud, unorganized_search_methods, unorganized_sparse_cloud_query_indices, unorganized_input_indices);
+}
+#endif
+
 #if TEST_ORGANIZED_SPARSE_COMPLETE_KNN
 TEST (PCL, Organized_Sparse_Complete_KNN)
 {
@@ -517,6 +600,92 @@ TEST (PCL, Organized_Sparse_View_Radius)
 }
 #endif
 
+#if TEST_ORGANIZED_SPARSE_BATCH
+TEST (PCL, Organized_Sparse_Batch)
+{
+  // the queries are points of the input cloud -> the organized search answers them in one sweep over the image tiles
+  testBatchSearch (organized_sparse_cloud, organized_search_methods, organized_sparse_query_indices);
+  testBatchSearch (organized_sparse_cloud, organized_search_methods, organized_sparse_query_indices, organized_input_indices);
+}
+#endif
+
+#if TEST_ORGANIZED_CAMERA_INTRINSICS
+TEST (PCL, Organized_Camera_Intrinsics)
+{
+  // back project a slanted, wavy depth image with holes through known intrinsics
+  const unsigned width = 160, height = 120;
+  const float fx = 140.0f, fy = 145.0f, cx = 79.5f, cy = 61.0f;
+  PointCloud<PointXYZ>::Ptr cloud (new PointCloud<PointXYZ> (width, height));
+  cloud->is_dense = false;
+  for (unsigned yIdx = 0; yIdx < height; ++yIdx)
+  {
+    for (unsigned xIdx = 0; xIdx < width; ++xIdx)
+    {
+      PointXYZ &point = cloud->at (xIdx, yIdx);
+      if (rand_uint () == 0)
+      {
+        point.x = point.y = point.z = std::numeric_limits<float>::quiet_NaN ();
+        continue;
+      }
+      point.z = 1.0f + 0.3f * static_cast<float> (xIdx) / width + 0.02f * sinf (0.2f * static_cast<float> (yIdx));
+      point.x = (static_cast<float> (xIdx) - cx) * point.z / fx;
+      point.y = (static_cast<float> (yIdx) - cy) * point.z / fy;
+    }
+  }
+
+  pcl::search::OrganizedNeighbor<PointXYZ> intrinsics_search (true);
+  intrinsics_search.setCameraIntrinsics (fx, fy, cx, cy);
+  intrinsics_search.setTileSize (16);
+  intrinsics_search.setInputCloud (cloud);
+  EXPECT_TRUE (intrinsics_search.hasFixedProjectionMatrix ());
+  EXPECT_TRUE (intrinsics_search.isValid ());
+
+  Eigen::Matrix3f camera_matrix;
+  intrinsics_search.computeCameraMatrix (camera_matrix);
+  EXPECT_NEAR (camera_matrix (0, 0), fx, 1e-4);
+  EXPECT_NEAR (camera_matrix (1, 1), fy, 1e-4);
+  EXPECT_NEAR (camera_matrix (0, 2), cx, 1e-4);
+  EXPECT_NEAR (camera_matrix (1, 2), cy, 1e-4);
+
+  vector<int> query_indices;
+  for (unsigned pIdx = 0; pIdx < cloud->size (); pIdx += 97)
+  {
+    if (!isFinite (cloud->points [pIdx]))
+      continue;
+    query_indices.push_back (pIdx);
+
+    pcl::PointXY pixel;
+    EXPECT_TRUE (intrinsics_search.projectPoint (cloud->points [pIdx], pixel));
+    EXPECT_NEAR (pixel.x, static_cast<float> (pIdx % width), 1e-3);
+    EXPECT_NEAR (pixel.y, static_cast<float> (pIdx / width), 1e-3);
+  }
+
+  vector<search::Search<PointXYZ>*> search_methods;
+  search_methods.push_back (&brute_force);
+  search_methods.push_back (&intrinsics_search);
+  testKNNSearch (PointCloud<PointXYZ>::ConstPtr (cloud), search_methods, query_indices);
+  testRadiusSearch (PointCloud<PointXYZ>::ConstPtr (cloud), search_methods, query_indices);
+  testBatchSearch (PointCloud<PointXYZ>::ConstPtr (cloud), search_methods, query_indices);
+
+  // all the pixels of the frame at once, compared to the single point searches
+  search::BatchNeighbors neighbors;
+  intrinsics_search.batchRadiusSearch (*cloud, vector<int> (), 0.02, neighbors);
+  ASSERT_EQ (neighbors.size (), cloud->size ());
+  vector<int> indices;
+  vector<float> distances;
+  bool passed = true;
+  for (unsigned pIdx = 0; pIdx < cloud->size () && passed; ++pIdx)
+  {
+    indices.clear ();
+    if (isFinite (cloud->points [pIdx]))
+      intrinsics_search.radiusSearch (cloud->points [pIdx], 0.02, indices, distances);
+    passed = static_cast<int> (indices.size ()) == neighbors.getNumberOfNeighbors (pIdx) &&
+             std::equal (indices.begin (), indices.end (), neighbors.indices.begin () + neighbors.offsets [pIdx]);
+  }
+  EXPECT_TRUE (passed);
+}
+#endif
+
 /** \brief create subset of point in cloud to use as query points
   * \param[out] query_indices resulting query indices - not guaranteed to have size of query_count but guaranteed not to exceed that value
   * \param cloud input cloud required to check for nans and to get number of points
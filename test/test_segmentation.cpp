@@ -50,6 +50,7 @@
 #include <pcl/segmentation/region_growing.h>
 #include <pcl/segmentation/region_growing_rgb.h>
 #include <pcl/segmentation/min_cut_segmentation.h>
+#include <pcl/segmentation/extract_clusters.h>
 
 using namespace pcl;
 using namespace pcl::io;
@@ -386,6 +387,51 @@ TEST (ExtractPolygonalPrism, Segmentation)
   EXPECT_EQ (static_cast<int> (output.indices.size ()), 0);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+TEST (EuclideanClusterExtraction, VoxelHash)
+{
+  const float tolerances[] = { 0.003f, 0.006f, 0.02f };
+  for (int t = 0; t < 3; ++t)
+  {
+    // Same clusters, in the same order, as the clusters grown with radius searches
+    std::vector<int> indices;
+    for (int i = 0; i < static_cast<int> (cloud_->points.size ()); i += 2)
+      indices.push_back (i);
+    search::Search<PointXYZ>::Ptr tree (new search::KdTree<PointXYZ>);
+    tree->setInputCloud (cloud_, boost::make_shared<std::vector<int> > (indices));
+    std::vector<PointIndices> clusters, voxel_hash_clusters;
+    extractEuclideanClusters (*cloud_, indices, tree, tolerances[t], clusters, 2, 100);
+    extractEuclideanClustersVoxelHash (*cloud_, indices, tolerances[t], voxel_hash_clusters, 2, 100);
+    EXPECT_GT (clusters.size (), 0);
+    ASSERT_EQ (clusters.size (), voxel_hash_clusters.size ());
+    for (size_t c = 0; c < clusters.size (); ++c)
+      EXPECT_TRUE (clusters[c].indices == voxel_hash_clusters[c].indices);
+
+    EuclideanClusterExtraction<PointXYZ> ec;
+    ec.setInputCloud (cloud_);
+    ec.setSearchMethod (search::Search<PointXYZ>::Ptr (new search::KdTree<PointXYZ>));
+    ec.setClusterTolerance (tolerances[t]);
+    ec.setMinClusterSize (3);
+    clusters.clear ();
+    voxel_hash_clusters.clear ();
+    ec.extract (clusters);
+    ec.setUseVoxelHash (true);
+    ec.setNumberOfThreads (4);
+    ec.extract (voxel_hash_clusters);
+    ASSERT_EQ (clusters.size (), voxel_hash_clusters.size ());
+    std::vector<std::vector<int> > sorted_clusters, sorted_voxel_hash_clusters;
+    for (size_t c = 0; c < clusters.size (); ++c)
+    {
+      EXPECT_EQ (clusters[c].indices.size (), voxel_hash_clusters[c].indices.size ());
+      sorted_clusters.push_back (clusters[c].indices);
+      sorted_voxel_hash_clusters.push_back (voxel_hash_clusters[c].indices);
+    }
+    std::sort (sorted_clusters.begin (), sorted_clusters.end ());
+    std::sort (sorted_voxel_hash_clusters.begin (), sorted_voxel_hash_clusters.end ());
+    EXPECT_TRUE (sorted_clusters == sorted_voxel_hash_clusters);
+  }
+}
+
 /* ---[ */
 int
 main (int argc, char** argv)
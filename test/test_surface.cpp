@@ -53,6 +53,7 @@
 #include <pcl/surface/poisson.h>
 #include <pcl/surface/marching_cubes_hoppe.h>
 #include <pcl/surface/marching_cubes_rbf.h>
+#include <pcl/surface/vertex_welding.h>
 #include <pcl/common/common.h>
 #include "boost.h"
 
@@ -108,6 +109,79 @@ TEST (PCL, MarchingCubesTest)
   EXPECT_EQ (vertices[vertices.size ()/2].vertices[0], 4284);
   EXPECT_EQ (vertices[vertices.size ()/2].vertices[1], 4285);
   EXPECT_EQ (vertices[vertices.size ()/2].vertices[2], 4286);
+
+  // Welded vertices: same triangles, indexing shared vertices
+  hoppe.setWeldVertices (true);
+  PointCloud<PointNormal> welded_points;
+  std::vector<Vertices> welded_vertices;
+  hoppe.reconstruct (welded_points, welded_vertices);
+
+  EXPECT_GT (welded_vertices.size (), 0u);
+  EXPECT_LT (welded_points.size (), 3 * welded_vertices.size ());
+  for (size_t i = 0; i < welded_vertices.size (); ++i)
+    for (size_t j = 0; j < 3; ++j)
+      EXPECT_LT (welded_vertices[i].vertices[j], welded_points.size ());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TEST (PCL, VertexWelding)
+{
+  // Two triangles sharing the edge (1, 0, 0) - (0, 1, 0), and a triangle collapsed on an edge
+  PointCloud<PointXYZ> triangles;
+  triangles.push_back (PointXYZ (0.0f, 0.0f, 0.0f));
+  triangles.push_back (PointXYZ (1.0f, 0.0f, 0.0f));
+  triangles.push_back (PointXYZ (0.0f, 1.0f, 0.0f));
+  triangles.push_back (PointXYZ (1.0f, 0.0f, 0.0f));
+  triangles.push_back (PointXYZ (1.0f, 1.0f, 0.0f));
+  triangles.push_back (PointXYZ (0.0f, 1.0f, 0.0f));
+  triangles.push_back (PointXYZ (1.0f, 1.0f, 0.0f));
+  triangles.push_back (PointXYZ (1.0f, 1.0f, 0.0f));
+  triangles.push_back (PointXYZ (0.0f, 0.0f, 0.0f));
+
+  VertexWelding<PointXYZ> welding;
+  PointCloud<PointXYZ> vertices;
+  std::vector<Vertices> polygons;
+  welding.weld (triangles, vertices, polygons);
+
+  ASSERT_EQ (vertices.size (), 4);
+  ASSERT_EQ (polygons.size (), 2);
+  EXPECT_EQ (polygons[0].vertices[0], 0);
+  EXPECT_EQ (polygons[0].vertices[1], 1);
+  EXPECT_EQ (polygons[0].vertices[2], 2);
+  EXPECT_EQ (polygons[1].vertices[0], 1);
+  EXPECT_EQ (polygons[1].vertices[1], 3);
+  EXPECT_EQ (polygons[1].vertices[2], 2);
+
+  welding.setReverseOrientation (true);
+  welding.weld (triangles, vertices, polygons);
+  ASSERT_EQ (polygons.size (), 2);
+  EXPECT_EQ (polygons[1].vertices[0], 1);
+  EXPECT_EQ (polygons[1].vertices[1], 2);
+  EXPECT_EQ (polygons[1].vertices[2], 3);
+
+  // Copies of a vertex lying on the same grid edge are merged even if they differ slightly
+  PointCloud<PointXYZ> soup;
+  soup.push_back (PointXYZ (0.3f, 0.0f, 0.0f));
+  soup.push_back (PointXYZ (1.0f, 0.6f, 0.0f));
+  soup.push_back (PointXYZ (0.0f, 0.0f, 0.25f));
+  soup.push_back (PointXYZ (1.0f, 0.6000001f, 0.0f));
+  soup.push_back (PointXYZ (0.3000001f, 0.0f, 0.0f));
+  soup.push_back (PointXYZ (1.0f, 0.0f, 0.7f));
+
+  welding.setReverseOrientation (false);
+  welding.weld (soup, vertices, polygons);
+  EXPECT_EQ (vertices.size (), 6);
+
+  welding.setGrid (Eigen::Vector3f::Zero (), Eigen::Vector3f::Ones ());
+  for (unsigned int nr_threads = 1; nr_threads <= 4; ++nr_threads)
+  {
+    welding.setNumberOfThreads (nr_threads);
+    welding.weld (soup, vertices, polygons);
+    ASSERT_EQ (vertices.size (), 4);
+    ASSERT_EQ (polygons.size (), 2);
+    EXPECT_EQ (polygons[0].vertices[0], polygons[1].vertices[1]);
+    EXPECT_EQ (polygons[0].vertices[1], polygons[1].vertices[0]);
+  }
 }
 
 